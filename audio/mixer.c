@@ -1,4 +1,5 @@
 #include "mixer.h"
+#include "mem_sections.h"
 
 void mixer_init(Mixer *mix) {
     mix->count = 0;
@@ -10,7 +11,7 @@ void mixer_add(Mixer *mix, float freq) {
     }
 }
 
-int16_t mixer_next(Mixer *mix) {
+RAMFUNC int16_t mixer_next(Mixer *mix) {
     int32_t sum = 0;
     for (int i = 0; i < mix->count; i++) {
         sum += osc_next(&mix->oscs[i]);
@@ -1,10 +1,12 @@
 #include "oscillator.h"
+#include "mem_sections.h"
 #include <math.h>
 
 #define WAVE_LENGTH 1024
 #define M_PI 3.14159265358979323846
 
-int16_t sine[WAVE_LENGTH];
+// read twice per oscillator per sample, so kept in DTCM
+int16_t sine[WAVE_LENGTH] DTCM_BSS;
 
 // Generate the sine table at startup
 void osc_generate_sine_table() {
@@ -18,7 +20,7 @@ void osc_init(Oscillator *osc, float freq) {
     osc->phase_inc = (float)WAVE_LENGTH * freq / SAMPLE_RATE;
 }
 
-int16_t osc_next(Oscillator *osc) {
+RAMFUNC int16_t osc_next(Oscillator *osc) {
     int idx = (int)osc->phase;
     int next_idx = (idx + 1) % WAVE_LENGTH;
     float frac = osc->phase - idx;
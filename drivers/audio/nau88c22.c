@@ -10,6 +10,7 @@
 
 #include "nau88c22.h"
 #include "errornum.h"
+#include "i2c_bus.h"
 
 static uint8_t nau88c22_write_reg(uint8_t reg_addr, uint16_t reg_data);
 static uint8_t nau88c22_read_reg(uint8_t reg_addr, uint16_t *reg_data);
@@ -61,7 +62,10 @@ static uint8_t nau88c22_write_reg(uint8_t reg_addr, uint16_t reg_data)
     data[0] = (reg_addr << 1) | ((reg_data >> 8) & 0x01); // pack reg addr and msb
     data[1] = reg_data & 0xFF;                            // lsb
 
-    if (HAL_I2C_Master_Transmit(&AUDIO_I2C_HANDLE, NAU88C22_I2C_ADDR << 1, data, 2, 100) != HAL_OK)
+    i2c_bus_acquire();
+    HAL_StatusTypeDef status = HAL_I2C_Master_Transmit(&AUDIO_I2C_HANDLE, NAU88C22_I2C_ADDR << 1, data, 2, 100);
+    i2c_bus_release();
+    if (status != HAL_OK)
     {
         return EIO;
     }
@@ -85,7 +89,9 @@ static uint8_t nau88c22_read_reg(uint8_t reg_addr, uint16_t *reg_data)
         return EINVAL;
     }
 
+    i2c_bus_acquire();
     status = HAL_I2C_Mem_Read(&AUDIO_I2C_HANDLE, NAU88C22_I2C_ADDR << 1, reg_addr << 1, I2C_MEMADD_SIZE_8BIT, data, 2, 100);
+    i2c_bus_release();
     if (status != HAL_OK)
     {
         return EIO;
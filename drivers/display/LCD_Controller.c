@@ -7,46 +7,220 @@
  */
 
 #include "LCD_Controller.h"
+#include "dcache.h"
+#include "mem_sections.h"
+#include <stdbool.h>
+
+#if defined(__arm__) && defined(DISPLAY_BUS_FMC)
+#include "fmc.h"
+#ifdef USE_FREERTOS
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#include "tickless_idle.h"
+#include "trace.h"
+#endif
+#endif
+
+// pixels per HAL_SPI_Transmit when streaming a fill
+#define LCD_SPI_REPEAT_CHUNK 256
+
+// HAL_SPI_Transmit takes a 16-bit byte count
+#define LCD_SPI_MAX_PIXELS 32767U
+
+static volatile uint32_t lcd_tx_bytes = 0;
+
+uint32_t lcd_get_tx_bytes(void)
+{
+    return lcd_tx_bytes;
+}
+
+#if defined(__arm__)
+#define FMC_WRITE(addr, value) (*(addr) = (value))
+#define FMC_READ(addr) (*(addr))
+#else
+#define FMC_WRITE(addr, value) lcd_fmc_bus_write((uintptr_t)(addr), (value))
+#define FMC_READ(addr) lcd_fmc_bus_read((uintptr_t)(addr))
+#endif
+
+#ifndef LCD_FMC_RESET_PORT
+#define LCD_FMC_RESET_PORT GPIOD
+#define LCD_FMC_RESET_PIN GPIO_PIN_3
+#endif
+
+#ifndef LCD_FMC_MDMA_CHANNEL
+#define LCD_FMC_MDMA_CHANNEL MDMA_Channel0
+#endif
+
+// MDMA block length is limited to 65536 bytes
+#define FMC_DMA_CHUNK 32768U
+
+#if defined(__arm__) && defined(DISPLAY_BUS_FMC)
+static MDMA_HandleTypeDef fmc_mdma;
+static uint16_t fmc_fill_value;
+
+#ifdef USE_FREERTOS
+static StaticSemaphore_t fmc_done_buffer;
+static SemaphoreHandle_t fmc_done;
+
+static void fmc_mdma_complete(MDMA_HandleTypeDef *hmdma)
+{
+    (void)hmdma;
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(fmc_done, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void MDMA_IRQHandler(void)
+{
+    TRACE_ISR_ENTER();
+    HAL_MDMA_IRQHandler(&fmc_mdma);
+    TRACE_ISR_EXIT();
+}
+#endif
+
+static void fmc_mdma_init(void)
+{
+    __HAL_RCC_MDMA_CLK_ENABLE();
+    fmc_mdma.Instance = LCD_FMC_MDMA_CHANNEL;
+    fmc_mdma.Init.Request = MDMA_REQUEST_SW;
+    fmc_mdma.Init.TransferTriggerMode = MDMA_BLOCK_TRANSFER;
+    fmc_mdma.Init.Priority = MDMA_PRIORITY_HIGH;
+    fmc_mdma.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+    fmc_mdma.Init.SourceInc = MDMA_SRC_INC_HALFWORD;
+    fmc_mdma.Init.DestinationInc = MDMA_DEST_INC_DISABLE;
+    fmc_mdma.Init.SourceDataSize = MDMA_SRC_DATASIZE_HALFWORD;
+    fmc_mdma.Init.DestDataSize = MDMA_DEST_DATASIZE_HALFWORD;
+    fmc_mdma.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+    fmc_mdma.Init.BufferTransferLength = 128;
+    fmc_mdma.Init.SourceBurst = MDMA_SOURCE_BURST_SINGLE;
+    fmc_mdma.Init.DestBurst = MDMA_DEST_BURST_SINGLE;
+    fmc_mdma.Init.SourceBlockAddressOffset = 0;
+    fmc_mdma.Init.DestBlockAddressOffset = 0;
+    HAL_MDMA_Init(&fmc_mdma);
+
+#ifdef USE_FREERTOS
+    fmc_done = xSemaphoreCreateBinaryStatic(&fmc_done_buffer);
+    vQueueAddToRegistry(fmc_done, "lcd-dma");
+    HAL_MDMA_RegisterCallback(&fmc_mdma, HAL_MDMA_XFER_CPLT_CB_ID, fmc_mdma_complete);
+    HAL_NVIC_SetPriority(MDMA_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(MDMA_IRQn);
+#endif
+}
+
+// moves count halfwords to the data address, source fixed for fills
+static void fmc_mdma_write(const uint16_t *src, uint32_t count, bool increment)
+{
+    MODIFY_REG(fmc_mdma.Instance->CTCR, MDMA_CTCR_SINC, increment ? MDMA_SRC_INC_HALFWORD : MDMA_SRC_INC_DISABLE);
+    // the MDMA reads RAM, so pixels still in the D-cache go out first
+    dcache_clean(src, increment ? count * 2 : 2);
+
+    while (count > 0)
+    {
+        uint32_t chunk = count < FMC_DMA_CHUNK ? count : FMC_DMA_CHUNK;
+#ifdef USE_FREERTOS
+        // sleep on the completion interrupt once tasks are running
+        if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+        {
+            // the MDMA and FMC stop with the clocks, so the idle sleep must not enter Stop mode
+            tickless_stop_hold();
+            HAL_MDMA_Start_IT(&fmc_mdma, (uint32_t)src, (uint32_t)FMC_BANK1_DATA, chunk * 2, 1);
+            xSemaphoreTake(fmc_done, portMAX_DELAY);
+            tickless_stop_release();
+        }
+        else
+#endif
+        {
+            HAL_MDMA_Start(&fmc_mdma, (uint32_t)src, (uint32_t)FMC_BANK1_DATA, chunk * 2, 1);
+            HAL_MDMA_PollForTransfer(&fmc_mdma, HAL_MDMA_FULL_TRANSFER, HAL_MAX_DELAY);
+        }
+        if (increment)
+            src += chunk;
+        count -= chunk;
+    }
+}
+#endif
 
 static void fmc_init(void)
 {
-    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_3, GPIO_PIN_RESET);
-    HAL_Delay(10);
-    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_3, GPIO_PIN_SET);
+#if defined(__arm__)
+#if defined(DISPLAY_BUS_FMC)
+    MX_FMC_Init();
+    // NOR/SRAM bank 1 at 0xC0000000, see FMC_BANK1_REG
+    HAL_SetFMCMemorySwappingConfig(FMC_SWAPBMAP_SDRAM_SRAM);
+    fmc_mdma_init();
+#endif
+    // the panel needs a 10us low pulse, then 120ms before it takes Sleep Out
+    HAL_GPIO_WritePin(LCD_FMC_RESET_PORT, LCD_FMC_RESET_PIN, GPIO_PIN_RESET);
+    HAL_Delay(1);
+    HAL_GPIO_WritePin(LCD_FMC_RESET_PORT, LCD_FMC_RESET_PIN, GPIO_PIN_SET);
     HAL_Delay(120);
+#endif
 }
 
-static void fmc_write_reg(uint8_t Reg)
+static RAMFUNC void fmc_write_reg(uint8_t Reg)
 {
-    *FMC_BANK1_REG = (uint16_t)Reg;
+    FMC_WRITE(FMC_BANK1_REG, (uint16_t)Reg);
+    lcd_tx_bytes += 1;
 }
 
-static void fmc_write_data8(uint8_t data)
+static RAMFUNC void fmc_write_data8(uint8_t data)
 {
-    *FMC_BANK1_DATA = data && 0x00FF;
+    FMC_WRITE(FMC_BANK1_DATA, (uint16_t)data);
+    lcd_tx_bytes += 1;
 }
 
-static void fmc_write_data16(uint16_t data)
+static RAMFUNC void fmc_write_data16(uint16_t data)
 {
-    *FMC_BANK1_DATA = data;
+    FMC_WRITE(FMC_BANK1_DATA, data);
+    lcd_tx_bytes += 2;
 }
 
 static uint16_t fmc_read_data(void)
 {
-    return *FMC_BANK1_DATA;
+    return FMC_READ(FMC_BANK1_DATA);
 }
 
-static void fmc_write_data(uint16_t *pData, uint32_t Size)
+static RAMFUNC void fmc_write_data(uint16_t *pData, uint32_t Size)
 {
+    lcd_tx_bytes += Size * 2;
+#if defined(__arm__) && defined(DISPLAY_BUS_FMC)
+    if (Size >= LCD_FMC_DMA_MIN)
+    {
+        fmc_mdma_write(pData, Size, true);
+        return;
+    }
+#endif
     for (uint32_t i = 0; i < Size; i++)
     {
-        *FMC_BANK1_DATA = pData[i];
+        FMC_WRITE(FMC_BANK1_DATA, pData[i]);
+    }
+}
+
+static RAMFUNC void fmc_write_repeat(uint16_t data, uint32_t count)
+{
+    lcd_tx_bytes += count * 2;
+#if defined(__arm__) && defined(DISPLAY_BUS_FMC)
+    if (count >= LCD_FMC_DMA_MIN)
+    {
+        fmc_fill_value = data;
+        fmc_mdma_write(&fmc_fill_value, count, false);
+        return;
+    }
+#endif
+    for (uint32_t i = 0; i < count; i++)
+    {
+        FMC_WRITE(FMC_BANK1_DATA, data);
     }
 }
 
 static void fmc_delay(uint32_t delay)
 {
+#if defined(__arm__)
     HAL_Delay(delay);
+#else
+    (void)delay;
+#endif
 }
 
 const ILCD_t *lcd_create_fmc(void)
@@ -58,19 +232,31 @@ const ILCD_t *lcd_create_fmc(void)
         .write_data16 = fmc_write_data16,
         .read_data = fmc_read_data,
         .write_data = fmc_write_data,
+        .write_repeat = fmc_write_repeat,
         .delay = fmc_delay};
     return &fmc_lcd_io;
 }
 
+const ILCD_t *lcd_create_default(void)
+{
+#if defined(DISPLAY_BUS_FMC)
+    return lcd_create_fmc();
+#else
+    return lcd_create_spi();
+#endif
+}
+
+#if defined(__arm__)
 /**
  * @brief Initialize SPI interface for LCD communication
  */
 static void spi_init(void)
 {
+    // the panel needs a 10us low pulse, then 120ms before it takes Sleep Out
     HAL_GPIO_WritePin(DISP_RES_GPIO_Port, DISP_RES_Pin, GPIO_PIN_RESET);
-    HAL_Delay(10);
+    HAL_Delay(1);
     HAL_GPIO_WritePin(DISP_RES_GPIO_Port, DISP_RES_Pin, GPIO_PIN_SET);
-    HAL_Delay(20);
+    HAL_Delay(120);
 }
 
 /**
@@ -83,6 +269,7 @@ static void spi_write_reg(uint8_t Reg)
     HAL_GPIO_WritePin(DISP_DC_GPIO_Port, DISP_DC_Pin, GPIO_PIN_RESET);
     HAL_SPI_Transmit(&ST7789_SPI_PORT, (uint8_t *)&Reg, 1, HAL_MAX_DELAY);
     ST7789_UnSelect();
+    lcd_tx_bytes += 1;
 }
 
 /**
@@ -95,6 +282,7 @@ static void spi_write_data8(uint8_t data)
     HAL_GPIO_WritePin(DISP_DC_GPIO_Port, DISP_DC_Pin, GPIO_PIN_SET);
     HAL_SPI_Transmit(&ST7789_SPI_PORT, (uint8_t *)&data, 1, HAL_MAX_DELAY);
     ST7789_UnSelect();
+    lcd_tx_bytes += 1;
 }
 
 /**
@@ -107,6 +295,7 @@ static void spi_write_data16(uint16_t data)
     HAL_GPIO_WritePin(DISP_DC_GPIO_Port, DISP_DC_Pin, GPIO_PIN_SET);
     HAL_SPI_Transmit(&ST7789_SPI_PORT, (uint8_t *)&data, 2, HAL_MAX_DELAY);
     ST7789_UnSelect();
+    lcd_tx_bytes += 2;
 }
 
 /**
@@ -129,10 +318,45 @@ static uint16_t spi_read_data(void)
  */
 static void spi_write_data(uint16_t *pData, uint32_t Size)
 {
-    for (uint32_t i = 0; i < Size; i++)
+    // same byte stream as one spi_write_data16() per pixel, in one chip select
+    ST7789_Select();
+    HAL_GPIO_WritePin(DISP_DC_GPIO_Port, DISP_DC_Pin, GPIO_PIN_SET);
+    while (Size > 0)
+    {
+        uint32_t chunk = Size < LCD_SPI_MAX_PIXELS ? Size : LCD_SPI_MAX_PIXELS;
+        HAL_SPI_Transmit(&ST7789_SPI_PORT, (uint8_t *)pData, chunk * 2, HAL_MAX_DELAY);
+        lcd_tx_bytes += chunk * 2;
+        pData += chunk;
+        Size -= chunk;
+    }
+    ST7789_UnSelect();
+}
+
+/**
+ * @brief Write one 16-bit value repeatedly via SPI interface
+ * @param data Value to write, sent in the same byte order as spi_write_data16()
+ * @param count Number of times to write it
+ *
+ * Streams from a small pattern buffer under one chip select instead of one
+ * transaction per pixel.
+ */
+static void spi_write_repeat(uint16_t data, uint32_t count)
+{
+    static uint16_t pattern[LCD_SPI_REPEAT_CHUNK];
+    uint32_t fill = count < LCD_SPI_REPEAT_CHUNK ? count : LCD_SPI_REPEAT_CHUNK;
+    for (uint32_t i = 0; i < fill; i++)
+        pattern[i] = data;
+
+    ST7789_Select();
+    HAL_GPIO_WritePin(DISP_DC_GPIO_Port, DISP_DC_Pin, GPIO_PIN_SET);
+    while (count > 0)
     {
-        spi_write_data16(pData[i]);
+        uint32_t chunk = count < LCD_SPI_REPEAT_CHUNK ? count : LCD_SPI_REPEAT_CHUNK;
+        HAL_SPI_Transmit(&ST7789_SPI_PORT, (uint8_t *)pattern, chunk * 2, HAL_MAX_DELAY);
+        lcd_tx_bytes += chunk * 2;
+        count -= chunk;
     }
+    ST7789_UnSelect();
 }
 
 /**
@@ -157,6 +381,8 @@ const ILCD_t *lcd_create_spi(void)
         .write_data16 = spi_write_data16,
         .read_data = spi_read_data,
         .write_data = spi_write_data,
+        .write_repeat = spi_write_repeat,
         .delay = spi_delay};
     return &spi_lcd_io;
 }
+#endif
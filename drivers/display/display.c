@@ -7,11 +7,12 @@
  */
 
 #include "display.h"
+#include "mem_sections.h"
 
 // display driver vtable
 static const IDisplayDriver_t *driver = NULL;
 
-static const uint8_t font5x7[96][5] = {
+static const uint8_t font5x7[96][5] FASTDATA = {
     {0x00, 0x00, 0x00, 0x00, 0x00}, // space
     {0x00, 0x00, 0x5F, 0x00, 0x00}, // !
     {0x00, 0x07, 0x00, 0x07, 0x00}, // "
@@ -487,7 +488,7 @@ void display_fill_triangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, u
  * @param size Character size multiplier (1 = normal size)
  * @ingroup display_text
  */
-void display_draw_char(uint16_t x, uint16_t y, char c, uint16_t colour, uint16_t bg_colour, uint8_t size)
+RAMFUNC void display_draw_char(uint16_t x, uint16_t y, char c, uint16_t colour, uint16_t bg_colour, uint8_t size)
 {
     if (c < 32 || c > 127)
         c = 32; // replace invalid chars with space
@@ -547,7 +548,7 @@ void display_draw_string(uint16_t x, uint16_t y, const char *str, uint16_t colou
     }
 }
 
-void display_draw_bits(uint16_t x, uint16_t y, uint8_t *buff, uint16_t colour, uint16_t bg_colour, uint16_t w, uint16_t h)
+RAMFUNC void display_draw_bits(uint16_t x, uint16_t y, uint8_t *buff, uint16_t colour, uint16_t bg_colour, uint16_t w, uint16_t h)
 {
     uint8_t i, j;
 
@@ -675,6 +676,13 @@ void display_draw_mono_bitmap(uint16_t x, uint16_t y, const uint8_t *bitmap, uin
     driver->draw_bitmap(x, y, bitmap, width, height, fg_colour, bg_colour);
 }
 
+void display_draw_rgb565(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t *pixels)
+{
+    if (width == 0 || height == 0)
+        return;
+    driver->draw_rgb565(x, y, width, height, pixels);
+}
+
 /** @} */ // end of display_utility group
 /** @} */ // end of display_text group
 /** @} */ // end of display_drawing group
@@ -7,6 +7,7 @@
  */
 
 #include "st7789v.h"
+#include "mem_sections.h"
 
 static void st7789v_init(void);
 static void st7789v_set_orientation(uint32_t orientation);
@@ -42,21 +43,18 @@ static void st7789v_init(void)
 {
   uint8_t parameter[16];
   if (!lcd)
-    lcd = lcd_create_spi();
+    lcd = lcd_create_default();
+  /* Hardware reset, held for the 120ms the panel needs before Sleep Out,
+     so no software reset is needed on top */
   lcd->init();
 
-  /* Software Reset */
-  st7789_write_reg(ST7789V_SWRESET, (uint8_t *)NULL, 0);
-  lcd->delay(150);
-
-  /* Sleep Out */
+  /* Sleep Out, commands may follow after 5ms */
   st7789_write_reg(ST7789V_SLPOUT, (uint8_t *)NULL, 0);
-  lcd->delay(120);
+  lcd->delay(5);
 
   /* Color Mode - 16bit */
   parameter[0] = 0x05;
   st7789_write_reg(ST7789V_COLMOD, parameter, 1);
-  lcd->delay(10);
 
   /* Memory Access Control */
   parameter[0] = 0x00; // Normal orientation
@@ -143,11 +141,9 @@ static void st7789v_init(void)
 
   /* Normal Display Mode On */
   st7789_write_reg(ST7789V_NORON, (uint8_t *)NULL, 0);
-  lcd->delay(10);
 
-  /* Display On */
+  /* Display On, the backlight stays off until the first frame is drawn */
   st7789_write_reg(ST7789V_DISPON, (uint8_t *)NULL, 0);
-  lcd->delay(120);
 }
 
 /**
@@ -233,7 +229,7 @@ static uint16_t st7789v_read_id(void)
  * @param x1 Right edge X coordinate
  * @param y1 Bottom edge Y coordinate
  */
-static void st7789v_set_address_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+static RAMFUNC void st7789v_set_address_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
 {
   uint8_t parameter[4];
 
@@ -265,7 +261,7 @@ static void st7789v_set_cursor(uint16_t Xpos, uint16_t Ypos)
   st7789v_set_address_window(Xpos, Ypos, ST7789V_LCD_PIXEL_WIDTH - 1, ST7789V_LCD_PIXEL_HEIGHT - 1);
 }
 
-static void st7789v_write_pixel(uint16_t Xpos, uint16_t Ypos, uint16_t RGBCode)
+static RAMFUNC void st7789v_write_pixel(uint16_t Xpos, uint16_t Ypos, uint16_t RGBCode)
 {
   st7789v_set_address_window(Xpos, Ypos, Xpos, Ypos);
   st7789_write_reg(ST7789V_RAMWR, (uint8_t *)NULL, 0);
@@ -280,7 +276,7 @@ static uint16_t st7789v_read_pixel(uint16_t Xpos, uint16_t Ypos)
   return lcd->read_data();
 }
 
-static void st7789_write_reg(uint8_t Command, uint8_t *Parameters, uint8_t NbParameters)
+static RAMFUNC void st7789_write_reg(uint8_t Command, uint8_t *Parameters, uint8_t NbParameters)
 {
   uint8_t i;
   lcd->write_reg(Command);
@@ -336,26 +332,18 @@ static void st7789v_set_display_window(uint16_t Xpos, uint16_t Ypos, uint16_t Wi
   }
 }
 
-static void st7789v_draw_hline(uint16_t RGBCode, uint16_t Xpos, uint16_t Ypos, uint16_t Length)
+static RAMFUNC void st7789v_draw_hline(uint16_t RGBCode, uint16_t Xpos, uint16_t Ypos, uint16_t Length)
 {
-  uint16_t counter;
   st7789v_set_address_window(Xpos, Ypos, Xpos + Length - 1, Ypos);
   st7789_write_reg(ST7789V_RAMWR, (uint8_t *)NULL, 0);
-  for (counter = 0; counter < Length; counter++)
-  {
-    lcd->write_data16(RGBCode);
-  }
+  lcd->write_repeat(RGBCode, Length);
 }
 
-static void st7789v_draw_vline(uint16_t RGBCode, uint16_t Xpos, uint16_t Ypos, uint16_t Length)
+static RAMFUNC void st7789v_draw_vline(uint16_t RGBCode, uint16_t Xpos, uint16_t Ypos, uint16_t Length)
 {
-  uint16_t counter;
   st7789v_set_address_window(Xpos, Ypos, Xpos, Ypos + Length - 1);
   st7789_write_reg(ST7789V_RAMWR, (uint8_t *)NULL, 0);
-  for (counter = 0; counter < Length; counter++)
-  {
-    lcd->write_data16(RGBCode);
-  }
+  lcd->write_repeat(RGBCode, Length);
 }
 
 void st7789v_draw_bitmap(uint16_t Xpos, uint16_t Ypos, uint8_t *pbmp)
@@ -395,29 +383,21 @@ void st7789v_draw_rgb_image(uint16_t Xpos, uint16_t Ypos, uint16_t Xsize, uint16
   lcd->write_data((uint16_t *)pdata, Xsize * Ysize);
 }
 
-static void st7789v_fill(uint16_t RGBCode)
+static RAMFUNC void st7789v_fill(uint16_t RGBCode)
 {
-  uint32_t counter;
   st7789v_set_address_window(0, 0, ST7789V_LCD_PIXEL_WIDTH - 1, ST7789V_LCD_PIXEL_HEIGHT - 1);
   st7789_write_reg(ST7789V_RAMWR, (uint8_t *)NULL, 0);
-  for (counter = 0; counter < (uint32_t)ST7789V_LCD_PIXEL_WIDTH * ST7789V_LCD_PIXEL_HEIGHT; counter++)
-  {
-    lcd->write_data16(RGBCode);
-  }
+  lcd->write_repeat(RGBCode, (uint32_t)ST7789V_LCD_PIXEL_WIDTH * ST7789V_LCD_PIXEL_HEIGHT);
 }
 
-static void st7789v_fill_rect(uint16_t Xpos, uint16_t Ypos, uint16_t Width, uint16_t Height, uint16_t RGBCode)
+static RAMFUNC void st7789v_fill_rect(uint16_t Xpos, uint16_t Ypos, uint16_t Width, uint16_t Height, uint16_t RGBCode)
 {
   st7789v_set_address_window(Xpos, Ypos, Xpos + Width - 1, Ypos + Height - 1);
   st7789_write_reg(ST7789V_RAMWR, (uint8_t *)NULL, 0);
-  uint32_t total_pixels = (uint32_t)Width * Height;
-  for (uint32_t i = 0; i < total_pixels; i++)
-  {
-    lcd->write_data16(RGBCode);
-  }
+  lcd->write_repeat(RGBCode, (uint32_t)Width * Height);
 }
 
-static void st7789v_draw_mono_bitmap(uint16_t Xpos, uint16_t Ypos, const uint8_t *bitmap, uint16_t width, uint16_t height, uint16_t fg_colour, uint16_t bg_colour)
+static RAMFUNC void st7789v_draw_mono_bitmap(uint16_t Xpos, uint16_t Ypos, const uint8_t *bitmap, uint16_t width, uint16_t height, uint16_t fg_colour, uint16_t bg_colour)
 {
   st7789v_set_address_window(Xpos, Ypos, Xpos + width - 1, Ypos + height - 1);
   st7789_write_reg(ST7789V_RAMWR, (uint8_t *)NULL, 0);
@@ -429,6 +409,13 @@ static void st7789v_draw_mono_bitmap(uint16_t Xpos, uint16_t Ypos, const uint8_t
   }
 }
 
+static RAMFUNC void st7789v_draw_rgb565(uint16_t Xpos, uint16_t Ypos, uint16_t width, uint16_t height, const uint16_t *pixels)
+{
+  st7789v_set_address_window(Xpos, Ypos, Xpos + width - 1, Ypos + height - 1);
+  st7789_write_reg(ST7789V_RAMWR, (uint8_t *)NULL, 0);
+  lcd->write_data((uint16_t *)pixels, (uint32_t)width * height);
+}
+
 /**
  * @brief Get the ST7789V display driver interface
  * @return Pointer to IDisplayDriver_t structure with all driver functions
@@ -445,6 +432,7 @@ const IDisplayDriver_t *st7789v_get_driver(void)
       .set_orientation = st7789v_set_orientation_u8,
       .get_width = st7789v_get_pixel_width,
       .get_height = st7789v_get_pixel_height,
-      .draw_bitmap = st7789v_draw_mono_bitmap};
+      .draw_bitmap = st7789v_draw_mono_bitmap,
+      .draw_rgb565 = st7789v_draw_rgb565};
   return &driver;
 }
\ No newline at end of file
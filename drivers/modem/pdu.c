@@ -1,3 +1,5 @@
+#include "mem_sections.h"
+#include "profile.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
@@ -53,7 +55,7 @@ static void decodeSemiOctetNumber(const char *hex, int length, char *out, int ou
     out[pos] = '\0';
 }
 
-static int pack7bit(const char *input, uint8_t *output, int maxlen)
+static RAMFUNC int pack7bit(const char *input, uint8_t *output, int maxlen)
 {
     int len = strlen(input), outIndex = 0, carryBits = 0, carry = 0;
     for (int i = 0; i < len; i++)
@@ -77,7 +79,7 @@ static int pack7bit(const char *input, uint8_t *output, int maxlen)
     return outIndex;
 }
 
-static void decode7bit(const uint8_t *data, int septetCount, char *out, int outSize)
+static RAMFUNC void decode7bit(const uint8_t *data, int septetCount, char *out, int outSize)
 {
     int outPos = 0;
     for (int i = 0; i < septetCount && outPos < outSize - 1; i++)
@@ -91,23 +93,111 @@ static void decode7bit(const uint8_t *data, int septetCount, char *out, int outS
     }
     out[outPos] = '\0';
 }
-static int encodeUCS2(const char *ascii, uint8_t *out, int maxlen)
+// next code point of a UTF-8 string, U+FFFD for a malformed byte
+static uint32_t utf8Next(const char **s)
 {
-    int len = strlen(ascii), outIndex = 0;
-    for (int i = 0; i < len && outIndex + 1 < maxlen; i++)
+    const uint8_t *p = (const uint8_t *)*s;
+    int extra = p[0] >= 0xF0 ? 3 : p[0] >= 0xE0 ? 2 : p[0] >= 0xC0 ? 1 : 0;
+    uint32_t cp = extra ? p[0] & (0x3F >> extra) : p[0];
+    if (p[0] >= 0x80 && (extra == 0 || p[0] >= 0xF8))
     {
-        out[outIndex++] = 0x00;
-        out[outIndex++] = (uint8_t)ascii[i];
+        *s += 1;
+        return 0xFFFD;
+    }
+    for (int i = 1; i <= extra; i++)
+    {
+        if ((p[i] & 0xC0) != 0x80)
+        {
+            *s += 1;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    *s += extra + 1;
+    return cp;
+}
+
+static int utf8Put(uint32_t cp, char *out)
+{
+    if (cp < 0x80)
+    {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// UTF-8 to UCS-2 (UTF-16BE), characters outside the BMP become surrogate pairs
+static RAMFUNC int encodeUCS2(const char *utf8, uint8_t *out, int maxlen)
+{
+    int outIndex = 0;
+    while (*utf8)
+    {
+        uint32_t ch = utf8Next(&utf8);
+        if (ch >= 0x10000 && ch <= 0x10FFFF)
+        {
+            if (outIndex + 4 > maxlen)
+                break;
+            uint16_t high = 0xD800 + ((ch - 0x10000) >> 10);
+            uint16_t low = 0xDC00 + ((ch - 0x10000) & 0x3FF);
+            out[outIndex++] = high >> 8;
+            out[outIndex++] = high & 0xFF;
+            out[outIndex++] = low >> 8;
+            out[outIndex++] = low & 0xFF;
+            continue;
+        }
+        if (ch > 0xFFFF || (ch >= 0xD800 && ch <= 0xDFFF))
+            ch = 0xFFFD;
+        if (outIndex + 2 > maxlen)
+            break;
+        out[outIndex++] = ch >> 8;
+        out[outIndex++] = ch & 0xFF;
     }
     return outIndex;
 }
-static void decodeUCS2(const uint8_t *data, int byteCount, char *out, int outSize)
+
+// UCS-2 (UTF-16BE) to UTF-8, stopping before a character that would not fit
+static RAMFUNC void decodeUCS2(const uint8_t *data, int byteCount, char *out, int outSize)
 {
     int outPos = 0;
-    for (int i = 0; i + 1 < byteCount && outPos < outSize - 1; i += 2)
+    for (int i = 0; i + 1 < byteCount; i += 2)
     {
-        uint16_t ch = (data[i] << 8) | data[i + 1];
-        out[outPos++] = (ch < 128) ? (char)ch : '?';
+        uint32_t ch = (data[i] << 8) | data[i + 1];
+        if (ch >= 0xD800 && ch <= 0xDBFF && i + 3 < byteCount)
+        {
+            uint16_t low = (data[i + 2] << 8) | data[i + 3];
+            if (low >= 0xDC00 && low <= 0xDFFF)
+            {
+                ch = 0x10000 + ((ch - 0xD800) << 10) + (low - 0xDC00);
+                i += 2;
+            }
+        }
+        if (ch >= 0xD800 && ch <= 0xDFFF)
+            ch = 0xFFFD; // unpaired surrogate
+
+        char utf8[4];
+        int len = utf8Put(ch, utf8);
+        if (outPos + len > outSize - 1)
+            break;
+        memcpy(&out[outPos], utf8, len);
+        outPos += len;
     }
     out[outPos] = '\0';
 }
@@ -174,11 +264,12 @@ int encodePDU(const char *smscNumber,
     return totalLen;
 }
 
-void decodePDU(const char *pdu,
-               char *sender, int senderSize,
-               char *timestamp, int tsSize,
-               char *message, int msgSize)
+RAMFUNC void decodePDU(const char *pdu,
+                       char *sender, int senderSize,
+                       char *timestamp, int tsSize,
+                       char *message, int msgSize)
 {
+    PROFILE_ZONE_BEGIN(PROFILE_PDU_DECODE);
     const char *p = pdu;
     int smscLen = hexToByte(p);
     p += (1 + smscLen) * 2;
@@ -215,4 +306,5 @@ void decodePDU(const char *pdu,
         decodeUCS2(buf, udBytes, message, msgSize);
     else
         snprintf(message, msgSize, "[DCS %02X]", dcs);
+    PROFILE_ZONE_END(PROFILE_PDU_DECODE);
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "rc7620_api.h"
 #include "stm32h7xx_hal.h"
+#include "trace.h"
+#include "profile.h"
 
 uint8_t modem_write_command(const char *command)
 {
@@ -57,7 +59,22 @@ uint8_t depr_modem_read_response(uint8_t *buffer, uint16_t max_len, uint32_t tim
     return 0;
 }
 
-uint8_t modem_send_command_norepeat(const char *command, char *response, uint16_t response_size, uint32_t timeout)
+#if defined(TRACE_ENABLED)
+// the four characters after "AT" name the command in a trace, e.g. "+CSQ"
+static uint32_t command_tag(const char *command)
+{
+    const char *name = strncmp(command, "AT", 2) == 0 ? command + 2 : command;
+    uint32_t tag = 0;
+    for (int i = 0; i < 4 && name[i]; i++)
+    {
+        tag |= (uint32_t)(uint8_t)name[i] << (8 * i);
+    }
+    return tag;
+}
+#endif
+
+static uint8_t send_command(const char *command, char *response, uint16_t response_size, uint32_t timeout,
+                            uint32_t retry_delay)
 {
     char cmd_buffer[128]; // may need to dynamically allocate
     int cmd_len = snprintf(cmd_buffer, sizeof(cmd_buffer), "%s\r\n", command);
@@ -88,44 +105,32 @@ uint8_t modem_send_command_norepeat(const char *command, char *response, uint16_
             DEBUG_PRINTF("Got AT command response: %s\r\n", response);
         }
 
-        HAL_Delay(500);
+        if (retry_delay)
+        {
+            HAL_Delay(retry_delay);
+        }
     }
 
     return ret;
 }
 
-uint8_t modem_send_command(const char *command, char *response, uint16_t response_size, uint32_t timeout)
+uint8_t modem_send_command_norepeat(const char *command, char *response, uint16_t response_size, uint32_t timeout)
 {
-    char cmd_buffer[128]; // may need to dynamically allocate
-    int cmd_len = snprintf(cmd_buffer, sizeof(cmd_buffer), "%s\r\n", command);
-    uint8_t ret = 0;
-    uint32_t start_tick = HAL_GetTick();
-
-    if (cmd_len < 0 || cmd_len >= sizeof(cmd_buffer))
-    {
-        DEBUG_PRINTF("ERROR: Bad Command Size\r\n");
-        return E2BIG;
-    }
-
-    HAL_UART_Receive(&MODEM_UART_HANDLE, response, 100, 10);
-
-    while (HAL_GetTick() - start_tick < timeout)
-    {
-        DEBUG_PRINTF("Writing AT command: %s\r\n", cmd_buffer);
-        ret = modem_write_command(cmd_buffer);
-        if (ret)
-        {
-            return ret;
-        }
-
-        ret = modem_read_response((uint8_t *)response, response_size, 100);
-        if (ret == 0)
-        {
-            return ret;
-            DEBUG_PRINTF("Got AT command response: %s\r\n", response);
-        }
-    }
+    TRACE_BEGIN(TRACE_AT_COMMAND, command_tag(command), 0);
+    PROFILE_ZONE_BEGIN(PROFILE_AT_COMMAND);
+    uint8_t ret = send_command(command, response, response_size, timeout, 500);
+    PROFILE_ZONE_END(PROFILE_AT_COMMAND);
+    TRACE_END(TRACE_AT_COMMAND, ret, strlen(response));
+    return ret;
+}
 
+uint8_t modem_send_command(const char *command, char *response, uint16_t response_size, uint32_t timeout)
+{
+    TRACE_BEGIN(TRACE_AT_COMMAND, command_tag(command), 0);
+    PROFILE_ZONE_BEGIN(PROFILE_AT_COMMAND);
+    uint8_t ret = send_command(command, response, response_size, timeout, 0);
+    PROFILE_ZONE_END(PROFILE_AT_COMMAND);
+    TRACE_END(TRACE_AT_COMMAND, ret, strlen(response));
     return ret;
 }
 
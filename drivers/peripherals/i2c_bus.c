@@ -0,0 +1,53 @@
+/**
+ * @file i2c_bus.c
+ * @brief Lock for the shared I2C bus
+ *
+ * A FreeRTOS mutex, so a low priority task holding the bus is lifted to the
+ * priority of the one waiting for it.
+ */
+
+#include "i2c_bus.h"
+#include <stdbool.h>
+
+#ifdef USE_FREERTOS
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+static StaticSemaphore_t bus_buffer;
+static SemaphoreHandle_t bus;
+
+// the lock is only needed, and only usable, once tasks are running
+static bool bus_lockable(void)
+{
+    return bus != NULL && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+#endif
+
+void i2c_bus_init(void)
+{
+#ifdef USE_FREERTOS
+    bus = xSemaphoreCreateMutexStatic(&bus_buffer);
+    vQueueAddToRegistry(bus, "i2c-bus");
+#endif
+}
+
+void i2c_bus_acquire(void)
+{
+#ifdef USE_FREERTOS
+    if (bus_lockable())
+    {
+        xSemaphoreTake(bus, portMAX_DELAY);
+    }
+#endif
+}
+
+void i2c_bus_release(void)
+{
+#ifdef USE_FREERTOS
+    if (bus_lockable())
+    {
+        xSemaphoreGive(bus);
+    }
+#endif
+}
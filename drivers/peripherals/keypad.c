@@ -8,22 +8,18 @@
  */
 
 #include <stdbool.h>
+#include <string.h>
 #include "keypad.h"
+#include "keypad_debounce.h"
 #include "stm32_config.h"
 #include "main.h"
 
 // Button state bitmap - each bit represents a button state
 static uint32_t button_states;
-static uint32_t button_states_last;
 static uint32_t button_states_edge;
 
-// Debouncing structure
-typedef struct
-{
-    uint32_t last_press_time;
-    bool is_pressed;
-    bool is_debounced;
-} button_debounce_t;
+// Debounced state of all buttons, indexed by bitmap bit
+static KeypadDebounce debounce;
 
 // Button mapping structure
 typedef struct
@@ -72,10 +68,112 @@ static const button_map_t button_map[] = {
 };
 
 #define BUTTON_COUNT (sizeof(button_map) / sizeof(button_map[0]))
-#define DEBOUNCE_TIME_MS 30
+#define SCAN_MAX_PORTS 8
+
+// Buttons grouped by port, built from button_map so each scan reads every IDR once
+typedef struct
+{
+    GPIO_TypeDef *port;
+    uint32_t mask; // pins of this port that are buttons
+} scan_port_t;
+
+static scan_port_t scan_ports[SCAN_MAX_PORTS];
+static uint8_t scan_port_count;
+static uint8_t button_port[BUTTON_COUNT];  // index into scan_ports
+static uint8_t button_shift[BUTTON_COUNT]; // pin number within the port
+
+// Keys that wake the system from idle. EXTI lines are shared by pin number
+// across ports, so one key per line is taken; line 6 belongs to the modem RI.
+// The other keys are seen by the idle poll.
+static const uint8_t wake_buttons[] = {
+    16, // SELECT    PC0  line 0
+    12, // DPAD_UP   PC1  line 1
+    21, // VOL_UP    PA2  line 2
+    13, // DPAD_DOWN PE3  line 3
+    18, // MENU_R    PD4  line 4
+    5,  // 5         PB5  line 5
+    20, // END_CALL  PD7  line 7
+    23, // PWR       PB12 line 12
+    19, // CALL      PC15 line 15
+};
+
+#define WAKE_BUTTON_COUNT (sizeof(wake_buttons) / sizeof(wake_buttons[0]))
+#define WAKE_IRQ_PRIORITY 6 // at or below configMAX_SYSCALL_INTERRUPT_PRIORITY
+
+static uint32_t wake_mask; // EXTI lines of the wake keys
+static void (*wake_callback)(void);
+static volatile bool wake_tracking; // a wake is waiting for its first debounced press
+static volatile uint32_t wake_tick;
+static KeypadWakeStats wake_stats;
+
+static void wake_pins_init(void)
+{
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Mode = GPIO_MODE_IT_FALLING;
+    gpio.Pull = GPIO_PULLUP;
+
+    wake_mask = 0;
+    for (int i = 0; i < WAKE_BUTTON_COUNT; i++)
+    {
+        const button_map_t *button = &button_map[wake_buttons[i]];
+        gpio.Pin = button->pin;
+        HAL_GPIO_Init(button->port, &gpio);
+        wake_mask |= button->pin;
+    }
+
+    // HAL_GPIO_Init unmasks the lines, they stay masked until keypad_wake_arm()
+    EXTI_D1->IMR1 &= ~wake_mask;
+    EXTI_D1->PR1 = wake_mask;
+
+    const IRQn_Type irqs[] = {EXTI0_IRQn, EXTI1_IRQn, EXTI2_IRQn, EXTI3_IRQn,
+                              EXTI4_IRQn, EXTI9_5_IRQn, EXTI15_10_IRQn};
+    for (int i = 0; i < sizeof(irqs) / sizeof(irqs[0]); i++)
+    {
+        HAL_NVIC_SetPriority(irqs[i], WAKE_IRQ_PRIORITY, 0);
+        HAL_NVIC_EnableIRQ(irqs[i]);
+    }
+}
+
+static void scan_table_init(void)
+{
+    scan_port_count = 0;
+    for (int i = 0; i < BUTTON_COUNT; i++)
+    {
+        const button_map_t *button = &button_map[i];
+        int p = 0;
+        while (p < scan_port_count && scan_ports[p].port != button->port)
+        {
+            p++;
+        }
+        if (p == scan_port_count)
+        {
+            scan_ports[p].port = button->port;
+            scan_ports[p].mask = 0;
+            scan_port_count++;
+        }
+        scan_ports[p].mask |= button->pin;
+        button_port[i] = (uint8_t)p;
+        button_shift[i] = (uint8_t)POSITION_VAL(button->pin);
+    }
+}
 
-// Debounce states for each button
-static button_debounce_t button_debounce[BUTTON_COUNT] = {0};
+// raw levels of all buttons as a bitmap, bit set while down
+static uint32_t scan_read(void)
+{
+    uint32_t down[SCAN_MAX_PORTS];
+    for (int p = 0; p < scan_port_count; p++)
+    {
+        // buttons pull the pin low
+        down[p] = ~scan_ports[p].port->IDR & scan_ports[p].mask;
+    }
+
+    uint32_t raw = 0;
+    for (int i = 0; i < BUTTON_COUNT; i++)
+    {
+        raw |= ((down[button_port[i]] >> button_shift[i]) & 1U) << button_map[i].bitmap_bit;
+    }
+    return raw;
+}
 
 /**
  * @brief Initialize the keypad driver
@@ -84,15 +182,12 @@ void keypad_init(void)
 {
     // clear button states
     button_states = 0;
-    button_states_last = 0;
     button_states_edge = 0;
-    // initialize debounce states
-    for (int i = 0; i < BUTTON_COUNT; i++)
-    {
-        button_debounce[i].last_press_time = 0;
-        button_debounce[i].is_pressed = false;
-        button_debounce[i].is_debounced = false;
-    }
+    keypad_debounce_init(&debounce);
+    scan_table_init();
+    wake_tracking = false;
+    memset(&wake_stats, 0, sizeof(wake_stats));
+    wake_pins_init();
 }
 
 /**
@@ -104,45 +199,36 @@ void keypad_init(void)
 void keypad_update_states(void)
 {
     uint32_t current_time = HAL_GetTick();
-    uint32_t current_states = 0;
+    uint32_t previous = button_states;
+    uint32_t raw = scan_read();
 
-    // read all button states and update bitmap with debouncing
-    for (int i = 0; i < BUTTON_COUNT; i++)
-    {
-        const button_map_t *button = &button_map[i];
-        button_debounce_t *debounce = &button_debounce[i];
-
-        // read current gpio state
-        bool current_gpio_state = (HAL_GPIO_ReadPin(button->port, button->pin) == GPIO_PIN_RESET);
-
-        // debouncing logic
-        if (current_gpio_state != debounce->is_pressed)
-        {
-            // state changed, start debounce timer
-            debounce->last_press_time = current_time;
-            debounce->is_pressed = current_gpio_state;
-            debounce->is_debounced = false;
-        }
-        else if (current_gpio_state == debounce->is_pressed)
-        {
-            // state hasn't changed, check if debounce time has elapsed
-            if (!debounce->is_debounced &&
-                (current_time - debounce->last_press_time) >= DEBOUNCE_TIME_MS)
-            {
-                debounce->is_debounced = true;
-            }
-        }
+    // all buttons debounce together, the ones that flipped come back as a bitmap
+    uint32_t changed = keypad_debounce_update(&debounce, raw);
+    uint32_t edge = changed & debounce.state;
+    button_states_edge |= edge;
+    button_states = debounce.state;
 
-        // update bitmap only if debounced
-        if (debounce->is_debounced && debounce->is_pressed)
+    // a press from idle that no EXTI reported was found by the idle poll
+    if (raw && !wake_tracking && previous == 0)
+    {
+        wake_tracking = true;
+        wake_tick = current_time;
+        wake_stats.polled_wakes++;
+    }
+    if (wake_tracking && edge)
+    {
+        wake_tracking = false;
+        wake_stats.last_latency_ms = current_time - wake_tick;
+        if (wake_stats.last_latency_ms > wake_stats.max_latency_ms)
         {
-            current_states |= (1U << button->bitmap_bit);
+            wake_stats.max_latency_ms = wake_stats.last_latency_ms;
         }
     }
-    uint32_t edge = current_states & ~button_states_last;
-    button_states_edge |= edge;
-    button_states_last = current_states;
-    button_states = current_states;
+    else if (wake_tracking && keypad_debounce_idle(&debounce))
+    {
+        // a bounce that never became a press
+        wake_tracking = false;
+    }
 }
 
 /**
@@ -185,6 +271,15 @@ uint8_t keypad_get_button_count(void)
     return BUTTON_COUNT;
 }
 
+/**
+ * @brief Get the debounced held state of all buttons
+ * @return Bitmap with bit n set while button n is held
+ */
+uint32_t keypad_get_state_bitmap(void)
+{
+    return button_states;
+}
+
 /**
  * @brief Legacy function for manually scanning buttons
  * @param out_event Pointer to store the input event of pressed button
@@ -204,3 +299,79 @@ bool keypad_read_button(input_event_t *out_event)
     }
     return false;
 }
+
+/**
+ * @brief Check that no key is held or still debouncing
+ * @return true when the keypad can be left to the wake interrupt
+ */
+bool keypad_is_settled(void)
+{
+    return keypad_debounce_idle(&debounce);
+}
+
+/**
+ * @brief Register the function called from the wake interrupt
+ * @param callback Called in interrupt context, NULL to remove
+ */
+void keypad_set_wake_callback(void (*callback)(void))
+{
+    wake_callback = callback;
+}
+
+/**
+ * @brief Unmask the wake key interrupts
+ */
+void keypad_wake_arm(void)
+{
+    EXTI_D1->PR1 = wake_mask;
+    EXTI_D1->IMR1 |= wake_mask;
+}
+
+/**
+ * @brief Mask the wake key interrupts
+ */
+void keypad_wake_disarm(void)
+{
+    EXTI_D1->IMR1 &= ~wake_mask;
+}
+
+/**
+ * @brief Handle a wake key EXTI
+ *
+ * Called from the EXTI interrupt handlers. The wake lines are masked again
+ * until the next keypad_wake_arm(), the bouncing that follows is left to the
+ * poll.
+ */
+void keypad_exti_irq(void)
+{
+    uint32_t pending = EXTI_D1->PR1 & wake_mask;
+    if (!pending)
+    {
+        return;
+    }
+    EXTI_D1->PR1 = pending;
+    EXTI_D1->IMR1 &= ~wake_mask;
+
+    if (!wake_tracking)
+    {
+        wake_tracking = true;
+        wake_tick = HAL_GetTick();
+        wake_stats.exti_wakes++;
+    }
+    if (wake_callback)
+    {
+        wake_callback();
+    }
+}
+
+/**
+ * @brief Read the wake counters
+ * @param stats Receives a snapshot
+ */
+void keypad_get_wake_stats(KeypadWakeStats *stats)
+{
+    if (stats)
+    {
+        *stats = wake_stats;
+    }
+}
@@ -0,0 +1,47 @@
+/**
+ * @file keypad_debounce.c
+ * @brief Parallel keypad debounce with vertical counters
+ */
+
+#include "keypad_debounce.h"
+
+#if KEYPAD_DEBOUNCE_SAMPLES < 1 || KEYPAD_DEBOUNCE_SAMPLES > 7
+#error "KEYPAD_DEBOUNCE_SAMPLES must fit the 3-bit counter"
+#endif
+
+void keypad_debounce_init(KeypadDebounce *db)
+{
+    db->state = 0;
+    db->count[0] = 0;
+    db->count[1] = 0;
+    db->count[2] = 0;
+}
+
+uint32_t keypad_debounce_update(KeypadDebounce *db, uint32_t raw)
+{
+    uint32_t delta = raw ^ db->state;
+
+    // ripple-carry increment where the level differs, clear where it agrees
+    uint32_t carry0 = db->count[0] & delta;
+    uint32_t carry1 = db->count[1] & carry0;
+    db->count[0] = (db->count[0] ^ delta) & delta;
+    db->count[1] = (db->count[1] ^ carry0) & delta;
+    db->count[2] = (db->count[2] ^ carry1) & delta;
+
+    // counters that reached the sample count
+    uint32_t expired = delta;
+    expired &= (KEYPAD_DEBOUNCE_SAMPLES & 1) ? db->count[0] : ~db->count[0];
+    expired &= (KEYPAD_DEBOUNCE_SAMPLES & 2) ? db->count[1] : ~db->count[1];
+    expired &= (KEYPAD_DEBOUNCE_SAMPLES & 4) ? db->count[2] : ~db->count[2];
+
+    db->state ^= expired;
+    db->count[0] &= ~expired;
+    db->count[1] &= ~expired;
+    db->count[2] &= ~expired;
+    return expired;
+}
+
+bool keypad_debounce_idle(const KeypadDebounce *db)
+{
+    return (db->state | db->count[0] | db->count[1] | db->count[2]) == 0;
+}
@@ -11,6 +11,7 @@
 #include "errornum.h"
 #include "stm32_config.h"
 #include "i2c.h"
+#include "i2c_bus.h"
 
 
 /**
@@ -59,7 +60,9 @@ uint8_t lsm6dsv_write_reg(uint8_t reg_addr, uint8_t *reg_data, uint16_t len)
         return EINVAL;
     }
 
+    i2c_bus_acquire();
     status = HAL_I2C_Mem_Write(&IMU_I2C_HANDLE, LSM6DSV_I2C_ADDR << 1, reg_addr, I2C_MEMADD_SIZE_8BIT, reg_data, len, 1000);
+    i2c_bus_release();
 
     if (status != HAL_OK)
     {
@@ -85,7 +88,9 @@ uint8_t lsm6dsv_read_reg(uint8_t reg_addr, uint8_t *reg_data, uint16_t len)
         return EINVAL;
     }
 
+    i2c_bus_acquire();
     status = HAL_I2C_Mem_Read(&IMU_I2C_HANDLE, LSM6DSV_I2C_ADDR << 1, reg_addr, I2C_MEMADD_SIZE_8BIT, reg_data, len, 1000);
+    i2c_bus_release();
     if (status != HAL_OK)
     {
         return EIO;
@@ -12,14 +12,15 @@
 #include "sdmmc.h"
 #include "fatfs.h"
 #include "stm32_config.h"
+#include "mem_sections.h"
 #include "main.h"
 #include "errornum.h"
 #include "sdcard.h"
 
 
-// Main FatFS instance
-FATFS FatFs;
-FIL File;
+// Main FatFS instance, its sector windows are read and written by SDMMC IDMA
+FATFS FatFs DMA_BUFFER;
+FIL File DMA_BUFFER;
 DWORD clusters;
 
 const char config_file[] = "config.ini";
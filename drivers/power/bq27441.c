@@ -12,6 +12,7 @@
 #include "errornum.h"
 #include "stm32_config.h"
 #include "i2c.h"
+#include "i2c_bus.h"
 
 /**
  * @brief Initialize the BQ27441 battery fuel gauge
@@ -39,7 +40,9 @@ uint8_t bq27441_write_reg(uint8_t reg_addr, uint16_t *reg_data)
         return EINVAL;
     }
 
+    i2c_bus_acquire();
     status = HAL_I2C_Mem_Write(&BATT_I2C_HANDLE, BQ27441_I2C_ADDR << 1, reg_addr, I2C_MEMADD_SIZE_8BIT, (uint8_t *)reg_data, 2, 1000);
+    i2c_bus_release();
 
     if (status != HAL_OK)
     {
@@ -64,8 +67,10 @@ uint8_t bq27441_read_reg(uint8_t reg_addr, uint16_t *reg_data)
         return EINVAL;
     }
 
+    i2c_bus_acquire();
     status = HAL_I2C_Mem_Read(&BATT_I2C_HANDLE, BQ27441_I2C_ADDR << 1,
                               reg_addr, I2C_MEMADD_SIZE_8BIT, (uint8_t *)reg_data, 2, 1000);
+    i2c_bus_release();
     if (status != HAL_OK)
     {
         return EIO;
@@ -88,8 +93,10 @@ uint8_t bq27441_read_ctrl_reg(uint16_t subcmd, uint16_t *response)
         (uint8_t)(subcmd & 0xFF),
         (uint8_t)((subcmd >> 8) & 0xFF)};
 
+    i2c_bus_acquire();
     status = HAL_I2C_Mem_Write(&BATT_I2C_HANDLE, BQ27441_I2C_ADDR << 1,
                                BQ27441_CMD_CNTL, I2C_MEMADD_SIZE_8BIT, cmd_buf, 2, 1000);
+    i2c_bus_release();
 
     if (status != HAL_OK)
         return EIO;
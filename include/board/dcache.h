@@ -0,0 +1,170 @@
+/**
+ * @file dcache.h
+ * @brief D-cache maintenance around DMA transfers
+ * @ingroup memory
+ *
+ * main() turns on the I- and D-caches. A bus master other than the CPU
+ * reads and writes RAM, not the cache, so a buffer it touches in cached
+ * memory needs cleaning before the master reads it and invalidating
+ * around a transfer that writes it. Every DMA path calls these helpers
+ * with the buffer it is about to hand over; they do nothing where the
+ * CPU and the master already agree: DTCM and ITCM, which the cache never
+ * holds, the non-cacheable DMA region (DMA_BUFFER), and builds or moments
+ * with the D-cache off. On the host they do nothing at all.
+ *
+ * Maintenance works on whole 32-byte lines. A buffer sharing its first or
+ * last line with other data is cleaned and invalidated on those lines, so
+ * the neighbours are written back rather than lost, but the neighbours
+ * must then not be written while the transfer runs. DMA that writes into
+ * memory is safest on buffers for which dcache_dma_aligned() holds.
+ */
+
+#ifndef DCACHE_H
+#define DCACHE_H
+
+#include "mem_sections.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__arm__)
+#include "main.h"
+#endif
+
+/** @ingroup memory
+ *  @brief Cortex-M7 D-cache line size in bytes */
+#define DCACHE_LINE_SIZE 32u
+
+/**
+ * @ingroup memory
+ * @brief Whether an address is held in the D-cache right now
+ * @param addr Address
+ * @return false in TCM, in the DMA region, for peripherals and with the cache off
+ */
+static inline bool dcache_covers(const void *addr)
+{
+#if defined(__arm__)
+    return (SCB->CCR & SCB_CCR_DC_Msk) && !MEM_IN_DTCM(addr) && !MEM_IN_ITCM(addr) &&
+           !MEM_IN_DMA_REGION(addr) && (uintptr_t)addr < 0x40000000u;
+#else
+    (void)addr;
+    return false;
+#endif
+}
+
+/**
+ * @ingroup memory
+ * @brief Whether a buffer can take DMA without sharing a cache line
+ * @param addr Start of the buffer
+ * @param len Length in bytes
+ * @return true if the range is whole cache lines or is not cached
+ */
+static inline bool dcache_dma_aligned(const void *addr, size_t len)
+{
+    return !dcache_covers(addr) || ((((uintptr_t)addr | len) & (DCACHE_LINE_SIZE - 1)) == 0);
+}
+
+/**
+ * @ingroup memory
+ * @brief Write a buffer back to RAM before a bus master reads it
+ * @param addr Start of the buffer
+ * @param len Length in bytes
+ */
+static inline void dcache_clean(const void *addr, size_t len)
+{
+#if defined(__arm__)
+    if (len == 0 || !dcache_covers(addr))
+    {
+        return;
+    }
+    uintptr_t start = (uintptr_t)addr & ~(uintptr_t)(DCACHE_LINE_SIZE - 1);
+    uintptr_t end = (uintptr_t)addr + len;
+    SCB_CleanDCache_by_Addr((uint32_t *)start, (int32_t)(end - start));
+#else
+    (void)addr;
+    (void)len;
+#endif
+}
+
+/**
+ * @ingroup memory
+ * @brief Drop cached copies of a buffer a bus master writes
+ * @param addr Start of the buffer
+ * @param len Length in bytes
+ *
+ * Call before the transfer starts, so no dirty line is evicted over the
+ * incoming data, and again once it has finished, so the CPU reads what the
+ * master wrote. Lines only partly inside the buffer are cleaned as well.
+ */
+static inline void dcache_invalidate(void *addr, size_t len)
+{
+#if defined(__arm__)
+    if (len == 0 || !dcache_covers(addr))
+    {
+        return;
+    }
+    const uintptr_t mask = DCACHE_LINE_SIZE - 1;
+    uintptr_t start = (uintptr_t)addr;
+    uintptr_t end = start + len;
+    if (start & mask)
+    {
+        start &= ~mask;
+        SCB_CleanInvalidateDCache_by_Addr((uint32_t *)start, (int32_t)DCACHE_LINE_SIZE);
+        start += DCACHE_LINE_SIZE;
+    }
+    if ((end & mask) && end > start)
+    {
+        SCB_CleanInvalidateDCache_by_Addr((uint32_t *)(end & ~mask), (int32_t)DCACHE_LINE_SIZE);
+        end &= ~mask;
+    }
+    if (end > start)
+    {
+        SCB_InvalidateDCache_by_Addr((uint32_t *)start, (int32_t)(end - start));
+    }
+#else
+    (void)addr;
+    (void)len;
+#endif
+}
+
+/**
+ * @ingroup memory
+ * @brief Turn both caches on or off
+ * @param on true to enable
+ *
+ * Turning the D-cache off writes every dirty line back first, and turning
+ * it on starts from an empty cache, so no maintenance is lost either way.
+ * For measurements, the caches are on from reset onwards otherwise.
+ */
+static inline void cache_set_enabled(bool on)
+{
+#if defined(__arm__)
+    if (on)
+    {
+        SCB_EnableICache();
+        SCB_EnableDCache();
+    }
+    else
+    {
+        SCB_DisableDCache();
+        SCB_DisableICache();
+    }
+#else
+    (void)on;
+#endif
+}
+
+/**
+ * @ingroup memory
+ * @brief Whether the D-cache is on
+ */
+static inline bool cache_enabled(void)
+{
+#if defined(__arm__)
+    return (SCB->CCR & SCB_CCR_DC_Msk) != 0;
+#else
+    return false;
+#endif
+}
+
+#endif // DCACHE_H
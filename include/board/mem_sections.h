@@ -0,0 +1,105 @@
+/**
+ * @file mem_sections.h
+ * @brief Placement of statically allocated objects in the H7 RAM banks
+ * @ingroup memory
+ *
+ * DTCM is the core's zero-wait-state RAM and holds .data, .bss, task
+ * stacks and the RTOS control blocks. Objects marked DTCM_BSS stay there
+ * even if general .bss moves, and are zeroed at startup like .bss.
+ *
+ * DTCM is reachable by the CPU and MDMA only. Buffers that the SDMMC IDMA or
+ * another bus master reads or writes are marked DMA_BUFFER instead. They go
+ * in a section at the start of AXI SRAM, which MPU_Config() makes
+ * non-cacheable, so no cache maintenance is needed around their transfers.
+ * That section is not loaded, so main() zeroes it before any driver runs.
+ *
+ * Code on the hot paths, the panel's pixel and span writers, the audio
+ * mixer and the SMS PDU codec, is marked RAMFUNC and runs from ITCM, the
+ * zero-wait-state instruction RAM, instead of flash behind the I-cache.
+ * main() copies it there before anything calls it. Calls between flash
+ * and ITCM are out of branch range and go through linker veneers, so
+ * RAMFUNC functions are kept out of line and are best called once per
+ * span or buffer rather than once per pixel. Lookup tables read in those
+ * loops are marked FASTDATA and copied to DTCM with .data, where flash
+ * would cost wait states on every D-cache miss. Both only apply to builds
+ * with TCM_ENABLED (TCM=0 leaves everything in flash, for comparison).
+ *
+ * The build prints where every region, section and placed object ended up
+ * (tools/memmap.py). On the host the markers expand to nothing.
+ */
+
+#ifndef MEM_SECTIONS_H
+#define MEM_SECTIONS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @ingroup memory
+ *  @brief DTCM base address, the same on every supported board */
+#define MEM_DTCM_BASE 0x20000000u
+/** @ingroup memory
+ *  @brief DTCM size */
+#define MEM_DTCM_SIZE 0x20000u
+/** @ingroup memory
+ *  @brief Size of the non-cacheable DMA region, matches the linker ASSERT */
+#define MEM_DMA_REGION_SIZE 0x8000u
+
+/** @ingroup memory
+ *  @brief True if an address lies in DTCM, where only the CPU and MDMA reach */
+#define MEM_IN_DTCM(p) ((uint32_t)((uintptr_t)(p) - MEM_DTCM_BASE) < MEM_DTCM_SIZE)
+
+/** @ingroup memory
+ *  @brief ITCM base address */
+#define MEM_ITCM_BASE 0x00000000u
+/** @ingroup memory
+ *  @brief ITCM size */
+#define MEM_ITCM_SIZE 0x10000u
+/** @ingroup memory
+ *  @brief Base of the non-cacheable DMA region, the start of AXI SRAM */
+#define MEM_DMA_REGION_BASE 0x24000000u
+
+/** @ingroup memory
+ *  @brief True if an address lies in the non-cacheable DMA region */
+#define MEM_IN_DMA_REGION(p) ((uint32_t)((uintptr_t)(p) - MEM_DMA_REGION_BASE) < MEM_DMA_REGION_SIZE)
+
+#if defined(__arm__)
+/** @ingroup memory
+ *  @brief Zero-initialised object pinned to DTCM */
+#define DTCM_BSS __attribute__((section(".dtcm_bss")))
+/** @ingroup memory
+ *  @brief Buffer in the non-cacheable DMA region, 32-byte aligned */
+#define DMA_BUFFER __attribute__((section(".dma_buffers"), aligned(32)))
+
+/** @ingroup memory
+ *  @brief True if an address lies in ITCM */
+#define MEM_IN_ITCM(p) ((uint32_t)((uintptr_t)(p) - MEM_ITCM_BASE) < MEM_ITCM_SIZE)
+
+/** @ingroup memory
+ *  @brief Bounds of the DMA region, from the linker script */
+extern uint8_t _sdma_buffers[];
+extern uint8_t _edma_buffers[];
+
+/** @ingroup memory
+ *  @brief ITCM code bounds and its load address in flash, from the linker script */
+extern uint8_t _sitcm[];
+extern uint8_t _eitcm[];
+extern uint8_t _siitcm[];
+#else
+#define DTCM_BSS
+#define DMA_BUFFER
+#define MEM_IN_ITCM(p) false
+#endif
+
+#if defined(__arm__) && defined(TCM_ENABLED)
+/** @ingroup memory
+ *  @brief Function run from ITCM, kept out of line so it lands there */
+#define RAMFUNC __attribute__((section(".itcm_text"), noinline))
+/** @ingroup memory
+ *  @brief Initialised or constant table copied to DTCM at startup */
+#define FASTDATA __attribute__((section(".dtcm_data")))
+#else
+#define RAMFUNC
+#define FASTDATA
+#endif
+
+#endif
@@ -6,13 +6,27 @@
  * Provides an abstraction layer for LCD controller communication,
  * supporting both FMC (Flexible Memory Controller) and SPI interfaces.
  * This allows the display driver to work with different hardware configurations.
+ *
+ * The transport is chosen per board at build time: `make DISPLAY_BUS=fmc`
+ * defines DISPLAY_BUS_FMC and lcd_create_default() returns the FMC
+ * interface, otherwise SPI4 is used.
+ *
+ * The FMC interface drives an 8080-style 16-bit parallel bus. Address line
+ * A16 is wired to the panel's D/C pin, so commands are written to
+ * FMC_BANK1_REG and data to FMC_BANK1_DATA. Bulk writes and fills of at
+ * least LCD_FMC_DMA_MIN pixels are moved by MDMA. Host builds route every
+ * bus cycle through lcd_fmc_bus_write(), which a test provides.
  */
 
 #ifndef INC_LCD_CONTROLLER_H_
 #define INC_LCD_CONTROLLER_H_
 
+#include <stdint.h>
+
+#if defined(__arm__)
 #include "spi.h"
 #include "gpio.h"
+#endif
 
 /**
  * @brief LCD I/O interface structure
@@ -23,13 +37,14 @@
  */
 typedef struct
 {
-    void (*init)(void);                                 /**< Initialize the LCD interface */
-    void (*write_reg)(uint8_t reg);                     /**< Write a register command */
-    void (*write_data8)(uint8_t data);                  /**< Write 8-bit data */
-    void (*write_data16)(uint16_t data);                /**< Write 16-bit data */
-    uint16_t (*read_data)(void);                        /**< Read data from LCD */
-    void (*write_data)(uint16_t *pData, uint32_t Size); /**< Write data buffer */
-    void (*delay)(uint32_t delay);                      /**< Delay function */
+    void (*init)(void);                                  /**< Initialize the LCD interface */
+    void (*write_reg)(uint8_t reg);                      /**< Write a register command */
+    void (*write_data8)(uint8_t data);                   /**< Write 8-bit data */
+    void (*write_data16)(uint16_t data);                 /**< Write 16-bit data */
+    uint16_t (*read_data)(void);                         /**< Read data from LCD */
+    void (*write_data)(uint16_t *pData, uint32_t Size);  /**< Write data buffer */
+    void (*write_repeat)(uint16_t data, uint32_t count); /**< Write one 16-bit value count times */
+    void (*delay)(uint32_t delay);                       /**< Delay function */
 } ILCD_t;
 
 /**
@@ -52,18 +67,67 @@ const ILCD_t *lcd_create_fmc(void);
  */
 const ILCD_t *lcd_create_spi(void);
 
+/**
+ * @ingroup display_controller
+ * @brief Create the board's LCD interface
+ * @return FMC interface when built with DISPLAY_BUS_FMC, SPI otherwise
+ */
+const ILCD_t *lcd_create_default(void);
+
+/**
+ * @ingroup display_controller
+ * @brief Total bytes written to the panel since boot
+ * @return Free-running byte counter (wraps), shared by all transports
+ *
+ * Used by the frame statistics to attribute panel traffic to each frame.
+ */
+uint32_t lcd_get_tx_bytes(void);
+
 /* ==== FMC Interface specific definitions ==== */
 
 /** @ingroup display_controller
- *  @brief FMC register bank address (A0 = 0) */
+ *  @brief Address bit driving D/C: A16 on a 16-bit bus is HADDR bit 17 */
+#define LCD_FMC_DATA_BIT 0x00020000UL
+
+/** @ingroup display_controller
+ *  @brief FMC register bank address (A16 = 0)
+ *
+ *  NOR/SRAM bank 1 swapped to 0xC0000000, where the default memory map is
+ *  device memory, so the core never issues speculative reads to the panel. */
 #define FMC_BANK1_REG ((volatile uint16_t *)0xC0000000)
 
 /** @ingroup display_controller
- *  @brief FMC data bank address (A0 = 1) */
-#define FMC_BANK1_DATA ((volatile uint16_t *)0xC0020000)
+ *  @brief FMC data bank address (A16 = 1) */
+#define FMC_BANK1_DATA ((volatile uint16_t *)(0xC0000000 | LCD_FMC_DATA_BIT))
+
+#ifndef LCD_FMC_DMA_MIN
+/** @ingroup display_controller
+ *  @brief Shortest write worth an MDMA transfer, in pixels */
+#define LCD_FMC_DMA_MIN 64
+#endif
+
+#if !defined(__arm__)
+/**
+ * @ingroup display_controller
+ * @brief Host test double for an FMC write cycle
+ * @param address Bus address written, bit LCD_FMC_DATA_BIT selects data
+ * @param value 16-bit value on the data lines
+ */
+void lcd_fmc_bus_write(uintptr_t address, uint16_t value);
+
+/**
+ * @ingroup display_controller
+ * @brief Host test double for an FMC read cycle
+ * @param address Bus address read
+ * @return Value on the data lines
+ */
+uint16_t lcd_fmc_bus_read(uintptr_t address);
+#endif
 
 /* ==== SPI Interface specific definitions ==== */
 
+#if defined(__arm__)
+
 /** @ingroup display_controller
  *  @brief SPI handle for ST7789 display */
 #define ST7789_SPI_PORT hspi4
@@ -84,5 +148,6 @@ extern SPI_HandleTypeDef ST7789_SPI_PORT;
 /** @ingroup display_controller
  *  @brief Deselect ST7789 chip (CS high) */
 #define ST7789_UnSelect() HAL_GPIO_WritePin(ST7789_CS_PORT, ST7789_CS_PIN, GPIO_PIN_SET)
+#endif
 
 #endif
@@ -297,4 +297,18 @@ void display_draw_signal_bars(uint16_t x, uint16_t y, uint8_t strength, uint16_t
  */
 void display_draw_mono_bitmap(uint16_t x, uint16_t y, const uint8_t *bitmap, uint16_t width, uint16_t height, uint16_t fg_colour, uint16_t bg_colour);
 
+/**
+ * @ingroup display_driver
+ * @brief Draw a block of RGB565 pixels
+ * @param x Top-left X coordinate
+ * @param y Top-left Y coordinate
+ * @param width Block width in pixels
+ * @param height Block height in pixels
+ * @param pixels Row-major RGB565 pixels, width * height entries
+ *
+ * Sends the whole block through a single address window, so the cost is
+ * one window setup plus two bytes per pixel.
+ */
+void display_draw_rgb565(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t *pixels);
+
 #endif /* DISPLAY_H */
\ No newline at end of file
@@ -37,4 +37,6 @@ typedef struct
     uint16_t (*get_height)(void); /**< Get display height in pixels */
 
     void (*draw_bitmap)(uint16_t x, uint16_t y, const uint8_t *bitmap, uint16_t width, uint16_t height, uint16_t fg_colour, uint16_t bg_colour); /**< Draw bitmap image */
+
+    void (*draw_rgb565)(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t *pixels); /**< Write a block of RGB565 pixels in one window */
 } IDisplayDriver_t;
\ No newline at end of file
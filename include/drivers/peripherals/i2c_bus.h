@@ -0,0 +1,34 @@
+/**
+ * @file i2c_bus.h
+ * @brief Lock for the shared I2C bus
+ * @ingroup peripheral_drivers
+ *
+ * The codec, the IMU and the fuel gauge hang off the same I2C peripheral
+ * and are brought up and polled from different tasks. The drivers hold this
+ * lock around each HAL transfer so two transfers never overlap on the bus.
+ * Before the scheduler starts, and in builds without FreeRTOS, locking does
+ * nothing.
+ */
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+/**
+ * @ingroup peripheral_drivers
+ * @brief Create the bus lock, before the tasks using the bus are started
+ */
+void i2c_bus_init(void);
+
+/**
+ * @ingroup peripheral_drivers
+ * @brief Wait for the bus and take it
+ */
+void i2c_bus_acquire(void);
+
+/**
+ * @ingroup peripheral_drivers
+ * @brief Give the bus back
+ */
+void i2c_bus_release(void);
+
+#endif // I2C_BUS_H
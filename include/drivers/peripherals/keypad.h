@@ -14,6 +14,21 @@
 #include <stdint.h>
 #include "input.h"
 
+/**
+ * @ingroup keypad_driver
+ * @brief Wake counters
+ *
+ * Latency runs from the wake, or from the poll that first saw the key, to
+ * the first debounced press, so it includes the debounce time.
+ */
+typedef struct
+{
+    uint32_t exti_wakes;      /**< Presses from idle reported by the wake interrupt */
+    uint32_t polled_wakes;    /**< Presses from idle found by polling */
+    uint32_t last_latency_ms; /**< Latency of the most recent wake */
+    uint32_t max_latency_ms;  /**< Longest latency seen */
+} KeypadWakeStats;
+
 /**
  * @ingroup keypad_driver
  * @brief Initialize the keypad driver
@@ -26,8 +41,9 @@ void keypad_init(void);
  * @ingroup keypad_driver
  * @brief Update button states
  *
- * Scans the keypad matrix and updates button states.
- * Should be called periodically to detect button changes.
+ * Reads each button port's IDR once and debounces all buttons together,
+ * see keypad_debounce.h. Should be called every 5 ms while a key is held
+ * or keypad_is_settled() is false.
  */
 void keypad_update_states(void);
 
@@ -54,6 +70,15 @@ input_event_t keypad_get_button_event(uint8_t button_index);
  */
 uint8_t keypad_get_button_count(void);
 
+/**
+ * @ingroup keypad_driver
+ * @brief Get the debounced held state of all buttons
+ * @return Bitmap with bit n set while button n is held
+ *
+ * Bit n corresponds to keypad_get_button_event(n).
+ */
+uint32_t keypad_get_state_bitmap(void);
+
 /**
  * @ingroup keypad_driver
  * @brief Read button event (legacy function)
@@ -63,4 +88,46 @@ uint8_t keypad_get_button_count(void);
  */
 bool keypad_read_button(input_event_t *out_event);
 
+/**
+ * @ingroup keypad_driver
+ * @brief Check that no key is held or still debouncing
+ * @return true when polling can stop until the next wake
+ */
+bool keypad_is_settled(void);
+
+/**
+ * @ingroup keypad_driver
+ * @brief Register the function called from the wake interrupt
+ * @param callback Called in interrupt context, NULL to remove
+ */
+void keypad_set_wake_callback(void (*callback)(void));
+
+/**
+ * @ingroup keypad_driver
+ * @brief Unmask the wake key interrupts
+ *
+ * One key per EXTI line can wake the system, including from Stop mode.
+ * The lines mask themselves again on the first wake.
+ */
+void keypad_wake_arm(void);
+
+/**
+ * @ingroup keypad_driver
+ * @brief Mask the wake key interrupts
+ */
+void keypad_wake_disarm(void);
+
+/**
+ * @ingroup keypad_driver
+ * @brief Handle a wake key EXTI, called from the EXTI interrupt handlers
+ */
+void keypad_exti_irq(void);
+
+/**
+ * @ingroup keypad_driver
+ * @brief Read the wake counters
+ * @param stats Receives a snapshot
+ */
+void keypad_get_wake_stats(KeypadWakeStats *stats);
+
 #endif // KEYPAD_H
\ No newline at end of file
@@ -0,0 +1,166 @@
+/**
+ * @file boot_timeline.h
+ * @brief Start and end times of each boot phase, and the boot report
+ * @ingroup kernel_core
+ *
+ * main() times the clock and peripheral set-up and the task creation, and
+ * each task times the bring-up of the hardware it owns: the panel, the
+ * codec, the modem and so on. The phases overlap, as the tasks initialise
+ * side by side, and the display task draws the first frame as soon as the
+ * panel is ready while the slower phases finish in the background.
+ *
+ * Times are milliseconds of the HAL tick, which starts in HAL_Init() a few
+ * milliseconds after reset. Each phase is written by the one task that owns
+ * it and read by anyone; a reader may see a phase a moment out of date,
+ * never half of one.
+ *
+ * boot_timeline_report() lays the phases out as text, one line each with a
+ * bar placing it on the boot's time axis, for the UART log and the debug
+ * page.
+ */
+
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @ingroup kernel_core
+ *  @brief Time to first frame the boot is held to, in milliseconds */
+#define BOOT_FIRST_FRAME_TARGET_MS 300
+
+/** @ingroup kernel_core
+ *  @brief Width of the bar in a report line, in characters */
+#define BOOT_REPORT_BAR_WIDTH 14
+
+/** @ingroup kernel_core
+ *  @brief Longest report line, with its terminator */
+#define BOOT_REPORT_LINE_MAX 48
+
+/**
+ * @brief Boot phases, in the order the report lists them
+ * @ingroup kernel_core
+ */
+typedef enum
+{
+    BOOT_PHASE_CLOCKS,      /**< HAL, MPU and clock tree */
+    BOOT_PHASE_PERIPHERALS, /**< GPIO and bus peripheral set-up */
+    BOOT_PHASE_KERNEL,      /**< Pools, queues and task creation */
+    BOOT_PHASE_DISPLAY,     /**< Panel reset and configuration */
+    BOOT_PHASE_FIRST_FRAME, /**< First screen drawn and backlight on */
+    BOOT_PHASE_KEYPAD,      /**< Keypad pins and wake lines */
+    BOOT_PHASE_HAPTICS,     /**< Vibration motor driver */
+    BOOT_PHASE_CODEC,       /**< Audio codec power-up and levels */
+    BOOT_PHASE_FUEL_GAUGE,  /**< Battery fuel gauge */
+    BOOT_PHASE_LEDS,        /**< LED strip */
+    BOOT_PHASE_SD_CARD,     /**< SD card mount */
+    BOOT_PHASE_MODEM,       /**< Modem power-up and configuration */
+    BOOT_PHASE_COUNT
+} BootPhase;
+
+/**
+ * @brief State of a boot phase
+ * @ingroup kernel_core
+ */
+typedef enum
+{
+    BOOT_PENDING, /**< Not started yet */
+    BOOT_RUNNING, /**< Started, not finished */
+    BOOT_DONE,    /**< Finished */
+    BOOT_FAILED,  /**< Finished with an error */
+    BOOT_SKIPPED, /**< Not part of this build */
+} BootState;
+
+/**
+ * @brief One phase of the timeline
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t start_ms; /**< Tick when the phase started */
+    uint32_t end_ms;   /**< Tick when it finished, valid once finished */
+    BootState state;   /**< Where the phase is */
+} BootPhaseInfo;
+
+/**
+ * @ingroup kernel_core
+ * @brief Receives one line of the boot report
+ * @param line Text without a line ending
+ * @param arg Argument given to boot_timeline_report()
+ */
+typedef void (*BootReportLine)(const char *line, void *arg);
+
+/**
+ * @ingroup kernel_core
+ * @brief Forget every phase
+ *
+ * The timeline starts out cleared, this is for tests.
+ */
+void boot_timeline_reset(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Mark a phase as started
+ * @param phase Phase
+ * @param now_ms Current time in milliseconds
+ */
+void boot_phase_begin(BootPhase phase, uint32_t now_ms);
+
+/**
+ * @ingroup kernel_core
+ * @brief Mark a phase as finished
+ * @param phase Phase, begun or not
+ * @param ok false if the hardware did not come up
+ * @param now_ms Current time in milliseconds
+ *
+ * A phase that was never begun is taken to have started and ended now.
+ */
+void boot_phase_end(BootPhase phase, bool ok, uint32_t now_ms);
+
+/**
+ * @ingroup kernel_core
+ * @brief Mark a phase as not part of this build
+ * @param phase Phase
+ */
+void boot_phase_skip(BootPhase phase);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read a phase
+ * @param phase Phase
+ * @param info Receives the phase
+ * @return false if phase is out of range
+ */
+bool boot_phase_get(BootPhase phase, BootPhaseInfo *info);
+
+/**
+ * @ingroup kernel_core
+ * @brief Whether every phase has finished or been skipped
+ */
+bool boot_finished(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Short name of a phase
+ * @param phase Phase
+ * @return Name such as "display"
+ */
+const char *boot_phase_name(BootPhase phase);
+
+/**
+ * @ingroup kernel_core
+ * @brief Lay the timeline out as text
+ * @param out Called once per line
+ * @param arg Passed to out
+ * @param now_ms Current time, the end of the phases still running
+ * @return Number of lines written
+ *
+ * A header, one line per phase with its start, its length and a bar
+ * scaled to the latest end, then the time to first frame against
+ * BOOT_FIRST_FRAME_TARGET_MS and the time the whole boot took. Lines are
+ * at most 40 characters, the width of the debug page.
+ */
+int boot_timeline_report(BootReportLine out, void *arg, uint32_t now_ms);
+
+#endif // BOOT_TIMELINE_H
@@ -6,6 +6,10 @@
  * Efficient disk-based B+ tree for storing and searching contacts.
  * Provides fast prefix search and sorted iteration through contacts.
  * The tree is persisted to disk files for non-volatile storage.
+ *
+ * On the board and in the host simulation the files are on the SD card
+ * and are accessed through FatFs, with one tree open at a time. Host
+ * tests and tools use stdio files.
  */
 
 #ifndef CONTACTS_BPTREE_C
@@ -17,6 +21,18 @@
 #include <string.h>
 #include "sms_types.h"
 
+#if defined(__arm__) || defined(HOST_SIM)
+#include "ff.h"
+#endif
+
+/** @ingroup contacts_bptree
+ *  @brief File holding a tree or its contact data, a FatFs file on the card */
+#if defined(__arm__) || defined(HOST_SIM)
+typedef FIL BPTreeFile;
+#else
+typedef FILE BPTreeFile;
+#endif
+
 /** @ingroup contacts_bptree
  *  @brief Maximum keys per B+ tree node */
 #define MAX_KEYS 4
@@ -77,9 +93,9 @@ typedef struct
  */
 typedef struct
 {
-    FILE *tree_file;      /**< File handle for tree structure */
-    FILE *data_file;      /**< File handle for contact data */
-    uint32_t root_offset; /**< File offset of root node */
+    BPTreeFile *tree_file; /**< File handle for tree structure */
+    BPTreeFile *data_file; /**< File handle for contact data */
+    uint32_t root_offset;  /**< File offset of root node */
 } BPTree;
 
 /**
@@ -132,10 +148,11 @@ bool bptree_insert(BPTree *tree, ContactRecord contact);
 ContactRecord bptree_search(BPTree *tree, uint32_t offset);
 int bptree_search_prefix_page(BPTree *tree, PrefixSearchState *state, char out_names[][MAX_NAME_LEN], uint32_t out_offsets[]);
 uint32_t bptree_load_page(BPTree *tree, uint32_t offset, ContactsView *state);
+bool bptree_read_node(BPTree *tree, uint32_t offset, BPTreeNode *out_node);
 
 // Contact data functions
-uint32_t contacts_append(FILE *data_file, ContactRecord contact);
-bool contacts_read(FILE *data_file, uint32_t offset, ContactRecord *out_contact);
+uint32_t contacts_append(BPTreeFile *data_file, ContactRecord contact);
+bool contacts_read(BPTreeFile *data_file, uint32_t offset, ContactRecord *out_contact);
 
 // Internal functions
 uint32_t bptree_find_leaf(BPTree *tree, const char *name);
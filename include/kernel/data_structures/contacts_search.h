@@ -0,0 +1,132 @@
+/**
+ * @file contacts_search.h
+ * @brief Incremental prefix search over the contacts B+ tree
+ * @ingroup contacts_bptree
+ *
+ * Keeps a cursor at the first key matching the current prefix. Because keys
+ * are sorted, the first match for a longer prefix can only be at or after
+ * the current cursor, so adding a character scans forward from there rather
+ * than searching from the root (falling back to a root descent if the scan
+ * would be long). The cursor for every shorter prefix is kept on a stack, so
+ * backspace restores the previous result set without touching the file.
+ *
+ * Matching rows are paged from the cursor as they are requested, with no
+ * limit on how many match. The leaf positions of a page of rows around the
+ * last one read are kept, so scrolling within it reads nothing and moving
+ * past either end extends or slides it. Leaves are only linked forward, so
+ * a checkpoint is also kept every few rows to restart a walk from when the
+ * list scrolls back above the page. The checkpoints live in a fixed array
+ * whose spacing doubles whenever it fills, so memory stays fixed however
+ * many contacts match.
+ */
+
+#ifndef CONTACTS_SEARCH_H
+#define CONTACTS_SEARCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "contacts_bptree.h"
+
+/** @ingroup contacts_bptree
+ *  @brief Result positions kept around the last row read */
+#define CONTACT_SEARCH_PAGE 32
+
+/** @ingroup contacts_bptree
+ *  @brief Checkpoints kept to restart a walk from */
+#define CONTACT_SEARCH_MARKS 64
+
+/** @ingroup contacts_bptree
+ *  @brief Results between checkpoints until the checkpoints fill up */
+#define CONTACT_SEARCH_MARK_STRIDE 8
+
+/** @ingroup contacts_bptree
+ *  @brief Leaves scanned forward before falling back to a root descent */
+#define CONTACT_SEARCH_SCAN_LEAVES 2
+
+/**
+ * @brief Position of a key in the leaf chain
+ * @ingroup contacts_bptree
+ */
+typedef struct
+{
+    uint32_t leaf;     /**< Leaf node offset, 0 past the last leaf */
+    uint8_t key_index; /**< Key index within the leaf */
+} BPTreePos;
+
+/**
+ * @brief Incremental contact search state
+ * @ingroup contacts_bptree
+ */
+typedef struct
+{
+    BPTree *tree;                                   /**< Tree being searched */
+    char prefix[MAX_KEY_LEN];                       /**< Current prefix */
+    uint8_t len;                                    /**< Prefix length */
+    BPTreePos stack[MAX_KEY_LEN];                   /**< First-match cursor per prefix length */
+    BPTreePos page[CONTACT_SEARCH_PAGE];            /**< Positions of results page_first onwards */
+    uint32_t page_first;                            /**< Result index of page[0] */
+    uint8_t page_count;                             /**< Valid page entries */
+    BPTreePos marks[CONTACT_SEARCH_MARKS];          /**< Position of every mark_stride'th result */
+    uint8_t mark_count;                             /**< Valid checkpoints */
+    uint32_t mark_stride;                           /**< Results between checkpoints */
+    uint32_t found;                                 /**< Number of discovered matches */
+    bool complete;                                  /**< All matches discovered */
+    uint32_t leaf_offset;                           /**< Offset of the cached leaf */
+    BPTreeNode leaf;                                /**< Cached leaf node */
+    uint8_t depth;                                  /**< Tree height in nodes */
+    uint32_t reads;                                 /**< Tree node reads issued */
+} ContactSearch;
+
+/**
+ * @ingroup contacts_bptree
+ * @brief Start a search with an empty prefix (all contacts)
+ * @param search Search state
+ * @param tree Open contacts tree
+ */
+void contact_search_init(ContactSearch *search, BPTree *tree);
+
+/**
+ * @ingroup contacts_bptree
+ * @brief Append a character to the prefix
+ * @param search Search state
+ * @param c Character to append
+ * @return true if at least one contact matches the new prefix
+ */
+bool contact_search_push(ContactSearch *search, char c);
+
+/**
+ * @ingroup contacts_bptree
+ * @brief Remove the last prefix character
+ * @param search Search state
+ * @return false if the prefix was already empty
+ */
+bool contact_search_pop(ContactSearch *search);
+
+/**
+ * @ingroup contacts_bptree
+ * @brief Make sure at least n results are discovered
+ * @param search Search state
+ * @param n Wanted number of results
+ * @return Number of results discovered so far
+ */
+int contact_search_discover(ContactSearch *search, int n);
+
+/**
+ * @ingroup contacts_bptree
+ * @brief Row count for a result list
+ * @param search Search state
+ * @return Discovered results, plus one if more may follow
+ */
+int contact_search_count(const ContactSearch *search);
+
+/**
+ * @ingroup contacts_bptree
+ * @brief Read a result
+ * @param search Search state
+ * @param index Result index
+ * @param out Receives the contact
+ * @return false if there is no such result
+ */
+bool contact_search_get(ContactSearch *search, int index, ContactRecord *out);
+
+#endif /* CONTACTS_SEARCH_H */
@@ -0,0 +1,237 @@
+/**
+ * @file event_bus.h
+ * @brief Topic-based publish/subscribe event bus
+ * @ingroup kernel_core
+ *
+ * Producers publish system events (battery, signal, SMS received, call
+ * state, keys) to a topic without knowing who consumes them. Each task
+ * subscribes once at start-up with a topic mask and an optional filter.
+ *
+ * Filters run in the publisher's context, so a subscriber that is not
+ * interested in an event never sees it queued and is never woken for it.
+ * Accepted events go into the subscriber's own ring, and the subscriber's
+ * wake hook is called only when that ring goes from empty to non-empty,
+ * since the subscriber drains the ring each time it runs. A subscriber that
+ * already owns a queue, such as the coalescing input queue, can give a sink
+ * instead of using the ring; its wake hook then runs on every accepted
+ * event.
+ *
+ * An event carries a 32-bit value and an optional msg_pool payload. The
+ * publisher hands its payload reference to the bus, each ring delivery
+ * holds its own reference, and event_bus_release() drops it after
+ * handling. Sinks only borrow the payload for the duration of the call.
+ *
+ * The subscriber table is static and filled before the scheduler starts;
+ * publishing is safe from tasks and interrupts.
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef EVENT_BUS_MAX_SUBSCRIBERS
+/** @ingroup kernel_core
+ *  @brief Number of subscriber slots */
+#define EVENT_BUS_MAX_SUBSCRIBERS 8
+#endif
+
+#ifndef EVENT_BUS_QUEUE_DEPTH
+/** @ingroup kernel_core
+ *  @brief Events held in each subscriber ring */
+#define EVENT_BUS_QUEUE_DEPTH 8
+#endif
+
+/**
+ * @brief Event topics
+ * @ingroup kernel_core
+ */
+typedef enum
+{
+    EVENT_TOPIC_BATTERY,      /**< value: state of charge in percent */
+    EVENT_TOPIC_SIGNAL,       /**< value: signal bars (0-5) */
+    EVENT_TOPIC_SMS_RECEIVED, /**< data: ReceivedSms (MSG_TYPE_SMS) */
+    EVENT_TOPIC_CALL_STATE,   /**< value: CallState, data: CallData with the caller ID or NULL */
+    EVENT_TOPIC_KEY,          /**< value: KeyEvent packed with event_key_pack() */
+    EVENT_TOPIC_COUNT
+} EventTopic;
+
+/** @ingroup kernel_core
+ *  @brief Topic mask bit for event_bus_subscribe() */
+#define EVENT_TOPIC_BIT(topic) (1UL << (topic))
+
+/**
+ * @brief Event as published and received
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    EventTopic topic; /**< Topic the event was published to */
+    uint32_t value;   /**< Topic-specific scalar */
+    void *data;       /**< Optional msg_pool payload, NULL if none */
+} Event;
+
+/**
+ * @brief Publish-time filter
+ * @ingroup kernel_core
+ * @param event Event being published
+ * @param arg Subscriber argument
+ * @return true to deliver the event to this subscriber
+ */
+typedef bool (*EventFilter)(const Event *event, void *arg);
+
+/**
+ * @brief Delivery into a subscriber-owned queue
+ * @ingroup kernel_core
+ * @param event Event being published, data is only borrowed
+ * @param arg Subscriber argument
+ * @return false if the event had to be dropped
+ */
+typedef bool (*EventSink)(const Event *event, void *arg);
+
+/**
+ * @brief Wake hook, typically a task notification
+ * @ingroup kernel_core
+ * @param arg Subscriber argument
+ */
+typedef void (*EventWake)(void *arg);
+
+/**
+ * @brief Subscription request
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    const char *name;   /**< Name for statistics */
+    uint32_t topics;    /**< EVENT_TOPIC_BIT() mask */
+    EventFilter filter; /**< NULL to accept every event on the topics */
+    EventSink sink;     /**< NULL to queue events in the bus ring */
+    EventWake wake;     /**< NULL if the subscriber polls */
+    void *arg;          /**< Passed to filter, sink and wake */
+} EventSubscription;
+
+/**
+ * @brief Per-topic counters
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t published; /**< Events published to the topic */
+    uint32_t delivered; /**< Deliveries to subscribers */
+    uint32_t filtered;  /**< Deliveries skipped by subscriber filters */
+    uint32_t dropped;   /**< Deliveries lost to a full subscriber queue */
+    uint32_t wakeups;   /**< Wake hooks called for the topic */
+} EventTopicStats;
+
+/**
+ * @brief Per-subscriber counters
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    const char *name;    /**< Subscriber name */
+    uint32_t delivered;  /**< Events accepted */
+    uint32_t dropped;    /**< Events lost to a full queue */
+    uint32_t wakeups;    /**< Wake hooks called */
+    uint16_t high_water; /**< Most events waiting in the ring */
+} EventSubscriberStats;
+
+/**
+ * @brief Opaque subscriber handle
+ * @ingroup kernel_core
+ */
+typedef struct EventSubscriber EventSubscriber;
+
+/**
+ * @ingroup kernel_core
+ * @brief Remove all subscribers and clear the counters
+ */
+void event_bus_init(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Add a subscriber
+ * @param subscription Subscription request (copied)
+ * @return Subscriber handle, NULL if every slot is taken
+ *
+ * Call before the scheduler starts; the table is read without a lock.
+ */
+EventSubscriber *event_bus_subscribe(const EventSubscription *subscription);
+
+/**
+ * @ingroup kernel_core
+ * @brief Publish an event
+ * @param topic Topic to publish to
+ * @param value Topic-specific scalar
+ * @param data msg_pool payload or NULL; the caller's reference is consumed
+ * @return Number of subscribers the event was delivered to
+ */
+int event_bus_publish(EventTopic topic, uint32_t value, void *data);
+
+/**
+ * @ingroup kernel_core
+ * @brief Take the oldest event from a subscriber ring
+ * @param subscriber Subscriber handle
+ * @param event Receives the event; release it with event_bus_release()
+ * @return true if an event was waiting
+ */
+bool event_bus_receive(EventSubscriber *subscriber, Event *event);
+
+/**
+ * @ingroup kernel_core
+ * @brief Check whether a subscriber ring holds events
+ * @param subscriber Subscriber handle
+ * @return true if event_bus_receive() would return an event
+ */
+bool event_bus_pending(EventSubscriber *subscriber);
+
+/**
+ * @ingroup kernel_core
+ * @brief Drop the reference a received event holds on its payload
+ * @param event Event filled by event_bus_receive()
+ */
+void event_bus_release(Event *event);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the counters for a topic
+ * @param topic Topic
+ * @param stats Receives a snapshot
+ */
+void event_bus_get_topic_stats(EventTopic topic, EventTopicStats *stats);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the counters for a subscriber
+ * @param subscriber Subscriber handle
+ * @param stats Receives a snapshot
+ */
+void event_bus_get_subscriber_stats(const EventSubscriber *subscriber, EventSubscriberStats *stats);
+
+/**
+ * @ingroup kernel_core
+ * @brief Pack a key event into an event value
+ * @param key input_event_t of the key
+ * @param action KeyAction
+ * @param count Merged press count
+ * @return Value for EVENT_TOPIC_KEY
+ */
+static inline uint32_t event_key_pack(uint8_t key, uint8_t action, uint16_t count)
+{
+    return (uint32_t)key | ((uint32_t)action << 8) | ((uint32_t)count << 16);
+}
+
+/** @ingroup kernel_core
+ *  @brief Key (input_event_t) of an EVENT_TOPIC_KEY value */
+#define EVENT_KEY(value) ((uint8_t)((value) & 0xFF))
+
+/** @ingroup kernel_core
+ *  @brief KeyAction of an EVENT_TOPIC_KEY value */
+#define EVENT_KEY_ACTION(value) ((uint8_t)(((value) >> 8) & 0xFF))
+
+/** @ingroup kernel_core
+ *  @brief Merged press count of an EVENT_TOPIC_KEY value */
+#define EVENT_KEY_COUNT(value) ((uint16_t)((value) >> 16))
+
+#endif // EVENT_BUS_H
@@ -0,0 +1,279 @@
+/**
+ * @file health_monitor.h
+ * @brief Task heartbeats, stack and CPU usage, and a reset-surviving history
+ * @ingroup kernel_core
+ *
+ * Tasks register a heartbeat with a timeout and beat it from their main
+ * loop. The watchdog task calls health_check() periodically and refreshes
+ * the hardware watchdog only while every critical heartbeat is fresh, so a
+ * hung task resets the system instead of leaving it half alive. The first
+ * missed deadline of each heartbeat is written to the history before the
+ * reset happens.
+ *
+ * Once a second the watchdog task feeds a snapshot of every task's run-time
+ * counter and free stack to health_update_tasks(). CPU usage is the share
+ * of the run-time counter each task used since the previous snapshot;
+ * unsigned deltas keep this correct across counter wrap as long as the
+ * counter does not wrap twice between snapshots.
+ *
+ * The history lives in a HealthBackup block that the caller places in
+ * memory that survives reset (backup SRAM on the target). It holds a boot
+ * counter, the last reset cause, a ring of HealthRecord entries and the
+ * lowest free stack ever seen per task, guarded by a magic number and a
+ * checksum. A block that fails either check is cleared.
+ *
+ * Heartbeats may be beaten from any task; registration and the other calls
+ * belong to the watchdog task and start-up code.
+ */
+
+#ifndef HEALTH_MONITOR_H
+#define HEALTH_MONITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef HEALTH_MAX_HEARTBEATS
+/** @ingroup kernel_core
+ *  @brief Number of heartbeat slots */
+#define HEALTH_MAX_HEARTBEATS 8
+#endif
+
+#ifndef HEALTH_MAX_TASKS
+/** @ingroup kernel_core
+ *  @brief Number of tasks tracked for stack and CPU usage */
+#define HEALTH_MAX_TASKS 12
+#endif
+
+#ifndef HEALTH_HISTORY_LEN
+/** @ingroup kernel_core
+ *  @brief Records kept in the reset-surviving history */
+#define HEALTH_HISTORY_LEN 16
+#endif
+
+#ifndef HEALTH_STACK_LOW_BYTES
+/** @ingroup kernel_core
+ *  @brief Free stack below which a task is recorded as running low */
+#define HEALTH_STACK_LOW_BYTES 128
+#endif
+
+/** @ingroup kernel_core
+ *  @brief Characters of a task or heartbeat name kept in the history */
+#define HEALTH_NAME_LEN 12
+
+/** @ingroup kernel_core
+ *  @brief Marks a valid HealthBackup block */
+#define HEALTH_BACKUP_MAGIC 0x48454C54UL
+
+/** @ingroup kernel_core
+ *  @brief HealthBackup layout version, bump when the struct changes */
+#define HEALTH_BACKUP_VERSION 1
+
+/**
+ * @brief Cause of the last reset
+ * @ingroup kernel_core
+ */
+typedef enum
+{
+    HEALTH_RESET_UNKNOWN,
+    HEALTH_RESET_POWER_ON,  /**< Power-on or brown-out */
+    HEALTH_RESET_PIN,       /**< NRST pin */
+    HEALTH_RESET_SOFTWARE,  /**< NVIC_SystemReset() */
+    HEALTH_RESET_WATCHDOG,  /**< Independent or window watchdog */
+    HEALTH_RESET_LOW_POWER, /**< Illegal low-power entry */
+} HealthResetCause;
+
+/**
+ * @brief History record kinds
+ * @ingroup kernel_core
+ */
+typedef enum
+{
+    HEALTH_EVENT_BOOT,      /**< value: seconds the previous boot ran for */
+    HEALTH_EVENT_HANG,      /**< value: milliseconds since the last heartbeat */
+    HEALTH_EVENT_STACK_LOW, /**< value: free stack in bytes */
+} HealthEvent;
+
+/**
+ * @brief History record
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t uptime_s;           /**< Seconds since boot when recorded */
+    uint32_t value;              /**< Event-specific value */
+    uint16_t boot;               /**< Boot count when recorded */
+    uint8_t event;               /**< HealthEvent */
+    uint8_t reset_cause;         /**< HealthResetCause of that boot */
+    char name[HEALTH_NAME_LEN];  /**< Task or heartbeat, empty for boots */
+} HealthRecord;
+
+/**
+ * @brief Lowest free stack seen for a task across boots
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    char name[HEALTH_NAME_LEN]; /**< Task name, empty if unused */
+    uint32_t min_free;          /**< Bytes */
+} HealthStackMark;
+
+/**
+ * @brief Reset-surviving state, placed in backup SRAM on the target
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t magic;                               /**< HEALTH_BACKUP_MAGIC */
+    uint16_t version;                             /**< HEALTH_BACKUP_VERSION */
+    uint16_t boot_count;                          /**< Boots since the block was cleared */
+    uint32_t uptime_s;                            /**< Uptime at the last health_check() */
+    uint8_t reset_cause;                          /**< HealthResetCause of this boot */
+    uint8_t head;                                 /**< Next history slot */
+    uint8_t count;                                /**< Valid history records */
+    uint8_t reserved;
+    HealthRecord history[HEALTH_HISTORY_LEN];     /**< Ring of records */
+    HealthStackMark stacks[HEALTH_MAX_TASKS];     /**< Per-task stack minimum */
+    uint32_t checksum;                            /**< Over everything above */
+} HealthBackup;
+
+/**
+ * @brief One task in a snapshot passed to health_update_tasks()
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    const char *name;    /**< Task name */
+    uint32_t runtime;    /**< Run-time counter of the task */
+    uint32_t stack_free; /**< Lowest free stack so far in bytes */
+    uint8_t priority;    /**< Current priority */
+} HealthTaskSample;
+
+/**
+ * @brief Per-task usage as shown on the debug page
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    char name[HEALTH_NAME_LEN]; /**< Task name */
+    uint16_t cpu_permille;      /**< CPU share over the last interval */
+    uint8_t priority;           /**< Current priority */
+    uint32_t stack_free;        /**< Lowest free stack this boot, bytes */
+    uint32_t stack_min;         /**< Lowest free stack across boots, bytes */
+} HealthTaskInfo;
+
+/**
+ * @brief Heartbeat state as shown on the debug page
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    const char *name;    /**< Heartbeat name */
+    uint32_t timeout_ms; /**< Allowed silence */
+    uint32_t age_ms;     /**< Time since the last beat */
+    uint32_t max_age_ms; /**< Longest silence seen at a check */
+    uint32_t beats;      /**< Beats since boot */
+    bool critical;       /**< Blocks the hardware watchdog refresh */
+    bool hung;           /**< Past its timeout at the last check */
+} HealthHeartbeatInfo;
+
+/**
+ * @ingroup kernel_core
+ * @brief Attach the backup block and record this boot
+ * @param backup Reset-surviving block, validated and cleared if corrupt
+ * @param cause Reset cause of this boot
+ * @param now_ms Current time in milliseconds
+ *
+ * Clears the heartbeat and task tables, so call it before any task
+ * registers a heartbeat.
+ */
+void health_init(HealthBackup *backup, HealthResetCause cause, uint32_t now_ms);
+
+/**
+ * @ingroup kernel_core
+ * @brief Register a heartbeat
+ * @param name Name shown on the debug page (not copied)
+ * @param timeout_ms Longest silence before the heartbeat counts as hung
+ * @param critical true if a hang should stop the hardware watchdog refresh
+ * @return Heartbeat id, -1 if every slot is taken
+ *
+ * The heartbeat counts as fresh from the moment it is registered.
+ */
+int health_register(const char *name, uint32_t timeout_ms, bool critical);
+
+/**
+ * @ingroup kernel_core
+ * @brief Report that a task is alive
+ * @param id Heartbeat id from health_register(), negative ids are ignored
+ * @param now_ms Current time in milliseconds
+ */
+void health_heartbeat(int id, uint32_t now_ms);
+
+/**
+ * @ingroup kernel_core
+ * @brief Check every heartbeat against its timeout
+ * @param now_ms Current time in milliseconds
+ * @return true if every critical heartbeat is fresh and the watchdog may be refreshed
+ */
+bool health_check(uint32_t now_ms);
+
+/**
+ * @ingroup kernel_core
+ * @brief Update stack and CPU usage from a task snapshot
+ * @param samples One entry per task
+ * @param count Number of entries
+ * @param total_runtime Run-time counter total at the snapshot
+ * @param now_ms Current time in milliseconds
+ */
+void health_update_tasks(const HealthTaskSample *samples, int count, uint32_t total_runtime, uint32_t now_ms);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read per-task usage
+ * @param info Receives up to max entries
+ * @param max Size of info
+ * @return Number of entries written
+ */
+int health_get_tasks(HealthTaskInfo *info, int max);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read heartbeat state
+ * @param info Receives up to max entries
+ * @param max Size of info
+ * @param now_ms Current time in milliseconds
+ * @return Number of entries written
+ */
+int health_get_heartbeats(HealthHeartbeatInfo *info, int max, uint32_t now_ms);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the history, newest record first
+ * @param records Receives up to max records
+ * @param max Size of records
+ * @return Number of records written
+ */
+int health_get_history(HealthRecord *records, int max);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the boot count and reset cause
+ * @param boot_count Receives the boot count, may be NULL
+ * @param cause Receives the reset cause of this boot, may be NULL
+ */
+void health_get_boot(uint16_t *boot_count, HealthResetCause *cause);
+
+/**
+ * @ingroup kernel_core
+ * @brief Forget the history and the stack minimums, keeping the boot count
+ */
+void health_clear_history(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Short name of a reset cause
+ * @param cause Reset cause
+ * @return Name such as "iwdg"
+ */
+const char *health_reset_name(HealthResetCause cause);
+
+#endif // HEALTH_MONITOR_H
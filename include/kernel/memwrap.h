@@ -1,27 +1,136 @@
+/**
+ * @file memwrap.h
+ * @brief Heap wrappers with optional allocation tracking
+ * @ingroup kernel_core
+ *
+ * mem_malloc(), mem_calloc(), mem_realloc() and mem_free() map onto the
+ * FreeRTOS heap on the target and onto libc on the host.
+ *
+ * Built with MEM_TRACKING they become macros that pass the call site along.
+ * Every live block is then kept in a table with its size, file, line and an
+ * allocation sequence number, and live and peak bytes are summed per source
+ * file. The screen takes a mark when a page is pushed and checks for blocks
+ * allocated since that are still live after the page is popped. The last
+ * such leak report is kept for the debug page and for host soak tests.
+ * Blocks that do not fit the table are counted as untracked and freed
+ * normally.
+ *
+ * mem_get_heap_stats() reports free space, the largest free block and
+ * fragmentation with or without tracking. On the host it reports zeros.
+ */
+
 #ifndef MEMWRAP_H
 #define MEMWRAP_H
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#ifndef MEM_TRACK_MAX_ALLOCS
+/** @ingroup kernel_core
+ *  @brief Live blocks the tracking table holds, a power of two */
+#define MEM_TRACK_MAX_ALLOCS 256
+#endif
+
+#ifndef MEM_TRACK_MAX_TAGS
+/** @ingroup kernel_core
+ *  @brief Source files with their own byte counts */
+#define MEM_TRACK_MAX_TAGS 48
+#endif
+
+#ifndef MEM_LEAK_REPORT_LEN
+/** @ingroup kernel_core
+ *  @brief Leaked blocks listed in a leak report */
+#define MEM_LEAK_REPORT_LEN 8
+#endif
+
+/**
+ * @brief Heap figures
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    size_t free_blocks;              /**< Number of free blocks */
+    size_t free_bytes;               /**< Free heap space */
+    size_t largest_free;             /**< Largest single free block */
+    size_t min_ever_free;            /**< Lowest free space since boot */
+    uint16_t fragmentation_permille; /**< Free space outside the largest block */
+} MemHeapStats;
+
+/**
+ * @brief Bytes allocated from one source file
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    const char *tag;      /**< File name without the path */
+    uint32_t live_bytes;  /**< Bytes currently allocated */
+    uint32_t peak_bytes;  /**< Most bytes allocated at once */
+    uint32_t live_count;  /**< Blocks currently allocated */
+    uint32_t total_count; /**< Blocks allocated since boot */
+} MemTagStats;
+
+/**
+ * @brief One live block
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    const char *tag; /**< File name without the path */
+    uint32_t size;   /**< Requested size */
+    uint32_t seq;    /**< Allocation sequence number */
+    uint16_t line;   /**< Line of the allocating call */
+} MemBlockInfo;
+
+/**
+ * @brief Totals over all tracked blocks
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t live_bytes;  /**< Bytes currently allocated */
+    uint32_t peak_bytes;  /**< Most bytes allocated at once */
+    uint32_t live_count;  /**< Blocks currently allocated */
+    uint32_t untracked;   /**< Allocations the full table could not record */
+    uint32_t failed;      /**< Allocations the heap refused */
+    uint32_t leak_checks; /**< Page pops checked */
+    uint32_t leaks;       /**< Leaked blocks found by those checks */
+} MemTrackStats;
+
+/**
+ * @brief Blocks left behind by the last page that leaked
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    const char *page;                         /**< Name of the popped page */
+    uint32_t count;                           /**< Leaked blocks */
+    uint32_t bytes;                           /**< Leaked bytes */
+    MemBlockInfo blocks[MEM_LEAK_REPORT_LEN]; /**< The oldest leaked blocks */
+} MemLeakReport;
+
+/* ===== HEAP ===== */
 
 #if defined(USE_FREERTOS)
-/* Correct FreeRTOS headers for pvPortMalloc / vPortFree */
 #include "FreeRTOS.h"
 #include "portable.h"
 #include <string.h>
 
-static inline void *mem_malloc(size_t n) { return pvPortMalloc(n); }
-static inline void mem_free(void *p) { vPortFree(p); }
+static inline void *mem_heap_malloc(size_t n) { return pvPortMalloc(n); }
+static inline void mem_heap_free(void *p) { vPortFree(p); }
 
 /* calloc */
 #if defined(pvPortCalloc)
-static inline void *mem_calloc(size_t nmemb, size_t size)
+static inline void *mem_heap_calloc(size_t nmemb, size_t size)
 {
   return pvPortCalloc(nmemb, size);
 }
 #else
 /* Fallback: allocate then zero */
-static inline void *mem_calloc(size_t nmemb, size_t size)
+static inline void *mem_heap_calloc(size_t nmemb, size_t size)
 {
+  if (size && nmemb > (size_t)-1 / size)
+    return NULL;
   size_t total = nmemb * size;
   void *p = pvPortMalloc(total);
   if (p)
@@ -31,29 +140,21 @@ static inline void *mem_calloc(size_t nmemb, size_t size)
 #endif
 
 /* realloc */
-#if defined(pvPortReAlloc)
-static inline void *mem_realloc(void *ptr, size_t newsize)
+#if defined(HEAP_TLSF)
+#include "tlsf_heap.h"
+
+static inline void *mem_heap_realloc(void *ptr, size_t newsize)
 {
   return pvPortReAlloc(ptr, newsize);
 }
 #else
-/* Fallback: allocate new block, copy, free old */
-static inline void *mem_realloc(void *ptr, size_t newsize)
-{
-  if (!ptr)
-    return pvPortMalloc(newsize);
-  void *newp = pvPortMalloc(newsize);
-  if (newp && newsize)
-  {
-    /* NOTE: caller must ensure they know old size if shrinking */
-    /* Without old size info we conservatively copy newsize bytes
-       only if we know it's safe.  Caller beware. */
-    /* For most FreeRTOS ports you'll need to track old size yourself. */
-  }
-  if (newp)
-    vPortFree(ptr);
-  return newp;
-}
+/**
+ * @ingroup kernel_core
+ * @brief Resize a heap block, copying what fits
+ *
+ * The old size is read from the heap_4 block header.
+ */
+void *mem_heap_realloc(void *ptr, size_t newsize);
 #endif
 
 #else /* ----- Standard C library ----- */
@@ -61,11 +162,133 @@ static inline void *mem_realloc(void *ptr, size_t newsize)
 #include <stdlib.h>
 #include <string.h>
 
-static inline void *mem_malloc(size_t n) { return malloc(n); }
-static inline void mem_free(void *p) { free(p); }
-static inline void *mem_calloc(size_t n, size_t s) { return calloc(n, s); }
-static inline void *mem_realloc(void *p, size_t n) { return realloc(p, n); }
+static inline void *mem_heap_malloc(size_t n) { return malloc(n); }
+static inline void mem_heap_free(void *p) { free(p); }
+static inline void *mem_heap_calloc(size_t n, size_t s) { return calloc(n, s); }
+static inline void *mem_heap_realloc(void *p, size_t n) { return realloc(p, n); }
+
+#endif
+
+/* ===== TRACKING ===== */
+
+/**
+ * @ingroup kernel_core
+ * @brief Tracked allocation, called through mem_malloc() with MEM_TRACKING
+ * @param n Bytes
+ * @param file Allocating source file
+ * @param line Allocating line
+ * @return Block, or NULL if the heap is exhausted
+ */
+void *mem_track_malloc(size_t n, const char *file, int line);
 
+/**
+ * @ingroup kernel_core
+ * @brief Tracked zeroed allocation, called through mem_calloc()
+ */
+void *mem_track_calloc(size_t nmemb, size_t size, const char *file, int line);
+
+/**
+ * @ingroup kernel_core
+ * @brief Tracked resize, called through mem_realloc()
+ *
+ * The block is recorded against the resizing call site.
+ */
+void *mem_track_realloc(void *ptr, size_t n, const char *file, int line);
+
+/**
+ * @ingroup kernel_core
+ * @brief Tracked free, called through mem_free()
+ */
+void mem_track_free(void *ptr);
+
+#if defined(MEM_TRACKING)
+#define mem_malloc(n) mem_track_malloc((n), __FILE__, __LINE__)
+#define mem_calloc(n, s) mem_track_calloc((n), (s), __FILE__, __LINE__)
+#define mem_realloc(p, n) mem_track_realloc((p), (n), __FILE__, __LINE__)
+#define mem_free(p) mem_track_free(p)
+#else
+static inline void *mem_malloc(size_t n) { return mem_heap_malloc(n); }
+static inline void mem_free(void *p) { mem_heap_free(p); }
+static inline void *mem_calloc(size_t n, size_t s) { return mem_heap_calloc(n, s); }
+static inline void *mem_realloc(void *p, size_t n) { return mem_heap_realloc(p, n); }
 #endif
 
+/**
+ * @ingroup kernel_core
+ * @brief Read the heap figures
+ * @param stats Receives a snapshot
+ */
+void mem_get_heap_stats(MemHeapStats *stats);
+
+/**
+ * @ingroup kernel_core
+ * @brief Check that allocations are being tracked
+ * @return true when built with MEM_TRACKING
+ */
+bool mem_track_enabled(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Current allocation sequence number
+ * @return Mark to pass to mem_track_leaks()
+ */
+uint32_t mem_track_mark(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Sequence number of a live block
+ * @param ptr Block from mem_malloc()
+ * @return The block's sequence number, or the current mark if it is not tracked
+ */
+uint32_t mem_track_seq_of(const void *ptr);
+
+/**
+ * @ingroup kernel_core
+ * @brief List live blocks allocated since a mark, oldest first
+ * @param mark From mem_track_mark() or mem_track_seq_of()
+ * @param blocks Receives up to max blocks, may be NULL to only count
+ * @param max Capacity of blocks
+ * @param bytes Receives the total size of all of them, may be NULL
+ * @return Number of live blocks allocated since the mark
+ */
+int mem_track_leaks(uint32_t mark, MemBlockInfo *blocks, int max, uint32_t *bytes);
+
+/**
+ * @ingroup kernel_core
+ * @brief Check a page for leaks after it is destroyed
+ * @param mark Mark taken when the page was pushed
+ * @param page Page name for the report
+ * @return Number of leaked blocks, also kept as the last leak report if non-zero
+ */
+int mem_track_check_page(uint32_t mark, const char *page);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the last leak report
+ * @param report Receives the report, count is 0 if no page has leaked
+ */
+void mem_track_get_leak_report(MemLeakReport *report);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read per-file byte counts, highest peak first
+ * @param tags Receives up to max entries
+ * @param max Capacity of tags
+ * @return Number of entries written
+ */
+int mem_track_get_tags(MemTagStats *tags, int max);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the tracking totals
+ * @param stats Receives a snapshot
+ */
+void mem_track_get_stats(MemTrackStats *stats);
+
+/**
+ * @ingroup kernel_core
+ * @brief Restart the peaks at the current live bytes
+ */
+void mem_track_reset_peaks(void);
+
 #endif
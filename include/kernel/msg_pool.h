@@ -0,0 +1,139 @@
+/**
+ * @file msg_pool.h
+ * @brief Fixed-block message pool for inter-task payloads
+ * @ingroup kernel_core
+ *
+ * Task queues carry a command and a pointer. Payloads that outlive the
+ * sender's stack frame are allocated from this pool instead of pointing at
+ * a stack variable or at a field the sender keeps rewriting.
+ *
+ * Every block starts with a typed header and a reference count. The
+ * producer allocates a message (one reference), fills it and posts it; the
+ * reference travels through the queue and the consumer releases it after
+ * handling. A consumer that keeps the payload, such as an overlay showing
+ * an SMS, takes its own reference with msg_retain() and releases it later.
+ * Payloads are never copied.
+ *
+ * Allocation and release are O(1) and safe from tasks and interrupts. On the
+ * host the pool is guarded by a pthread mutex so tests can run producers and
+ * consumers on threads.
+ */
+
+#ifndef MSG_POOL_H
+#define MSG_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MSG_POOL_BLOCKS
+/** @ingroup kernel_core
+ *  @brief Number of blocks in the pool */
+#define MSG_POOL_BLOCKS 16
+#endif
+
+#ifndef MSG_POOL_PAYLOAD_SIZE
+/** @ingroup kernel_core
+ *  @brief Largest payload a block holds, in bytes (fits a ReceivedSms) */
+#define MSG_POOL_PAYLOAD_SIZE 192
+#endif
+
+/**
+ * @brief Payload type stored in the message header
+ * @ingroup kernel_core
+ *
+ * Consumers check the type before casting the payload.
+ */
+typedef enum
+{
+    MSG_TYPE_NONE = 0,      /**< Free block */
+    MSG_TYPE_U8,            /**< Single uint8_t (battery %, signal bars, volume) */
+    MSG_TYPE_BATTERY_STATS, /**< PowerTaskStats snapshot */
+    MSG_TYPE_RTC_SYNC,      /**< RtcSyncData */
+    MSG_TYPE_SMS,           /**< ReceivedSms */
+    MSG_TYPE_CALL_DATA,     /**< CallData */
+    MSG_TYPE_USER,          /**< First type free for tests and new producers */
+} MsgType;
+
+/**
+ * @brief Pool usage counters
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t allocs;       /**< Successful allocations */
+    uint32_t releases;     /**< Blocks returned to the pool */
+    uint32_t exhausted;    /**< Allocations refused because every block was in use */
+    uint32_t oversize;     /**< Allocations refused because the payload was too large */
+    uint32_t bad_releases; /**< Retain or release of a pointer that is not a live message */
+    uint16_t in_use;       /**< Blocks currently allocated */
+    uint16_t high_water;   /**< Most blocks ever allocated at once */
+} MsgPoolStats;
+
+/**
+ * @ingroup kernel_core
+ * @brief Build the free list and clear the statistics
+ *
+ * Call once before any task allocates. Messages still held are forgotten.
+ */
+void msg_pool_init(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Allocate a message
+ * @param type Payload type recorded in the header
+ * @param size Payload size in bytes, at most MSG_POOL_PAYLOAD_SIZE
+ * @return Payload pointer holding one reference, or NULL if the pool is
+ *         exhausted or size is too large. The payload is not cleared.
+ */
+void *msg_alloc(MsgType type, size_t size);
+
+/**
+ * @ingroup kernel_core
+ * @brief Take another reference to a message
+ * @param msg Payload pointer returned by msg_alloc()
+ */
+void msg_retain(void *msg);
+
+/**
+ * @ingroup kernel_core
+ * @brief Drop a reference, freeing the block when it was the last
+ * @param msg Payload pointer returned by msg_alloc(), NULL is ignored
+ */
+void msg_release(void *msg);
+
+/**
+ * @ingroup kernel_core
+ * @brief Check whether a pointer is a message payload from this pool
+ * @param ptr Any pointer, including NULL
+ * @return true if ptr is the start of a block's payload
+ *
+ * Lets a queue consumer tell pool messages from plain pointers, such as
+ * pages or long-lived strings, that share the same data field.
+ */
+bool msg_pool_owns(const void *ptr);
+
+/**
+ * @ingroup kernel_core
+ * @brief Type of a live message
+ * @param msg Payload pointer
+ * @return The type given to msg_alloc(), MSG_TYPE_NONE for anything else
+ */
+MsgType msg_type(const void *msg);
+
+/**
+ * @ingroup kernel_core
+ * @brief Payload size of a live message
+ * @param msg Payload pointer
+ * @return The size given to msg_alloc(), 0 for anything else
+ */
+size_t msg_size(const void *msg);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the pool counters
+ * @param stats Filled with a consistent snapshot
+ */
+void msg_pool_get_stats(MsgPoolStats *stats);
+
+#endif // MSG_POOL_H
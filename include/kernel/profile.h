@@ -0,0 +1,176 @@
+/**
+ * @file profile.h
+ * @brief Always-on timing of named code regions, with aggregated statistics
+ * @ingroup kernel_core
+ *
+ * A zone is a region of code wrapped in PROFILE_ZONE_BEGIN() and
+ * PROFILE_ZONE_END(). Each pass through it adds one sample to the zone's
+ * entry in a static table: the count, the shortest, longest and total time,
+ * and a histogram with one bucket per power of two. Times are ticks of the
+ * DWT cycle counter on the target and nanoseconds from clock_gettime() on
+ * the host, so a zone longer than 2^32 ticks (7.8 s at 550 MHz, 4.3 s on the
+ * host) wraps.
+ *
+ * Recording takes no lock and never allocates: every field is updated with
+ * its own atomic add or compare-and-swap, so zones can be recorded from any
+ * task or interrupt, and one zone from several at once. A reader may see a
+ * sample that is counted but not yet in the histogram; the table is for
+ * statistics, not accounting.
+ *
+ * The zones are fixed, listed in ProfileZone. profile_report() lays the
+ * table out as text for the UART log and the Debug > Profile page. Built
+ * without PROFILE_ENABLED the macros compile to nothing.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(__arm__)
+#include <time.h>
+#endif
+
+/** @ingroup kernel_core
+ *  @brief Histogram buckets, bucket n counts samples of [2^n, 2^(n+1)) ticks */
+#define PROFILE_BUCKETS 32
+
+/** @ingroup kernel_core
+ *  @brief Longest report line, with its terminator */
+#define PROFILE_REPORT_LINE_MAX 48
+
+/**
+ * @brief Profiled zones, in the order the report lists them
+ * @ingroup kernel_core
+ */
+typedef enum
+{
+    PROFILE_DISPLAY_FLUSH, /**< Dirty tiles drawn and sent to the panel */
+    PROFILE_GLYPH,         /**< One font glyph rendered and blitted */
+    PROFILE_BPTREE_FIND,   /**< Descent of the contacts B+ tree to a leaf */
+    PROFILE_AT_COMMAND,    /**< AT command sent and its response read */
+    PROFILE_PDU_DECODE,    /**< SMS PDU decoded */
+    PROFILE_AUDIO_BUFFER,  /**< Sample buffer played out to the codec */
+    PROFILE_ZONE_COUNT
+} ProfileZone;
+
+/**
+ * @brief Statistics of one zone
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t count;                    /**< Samples recorded */
+    uint32_t min;                      /**< Shortest sample in ticks, 0 without samples */
+    uint32_t max;                      /**< Longest sample in ticks */
+    uint64_t total;                    /**< Sum of every sample in ticks */
+    uint32_t buckets[PROFILE_BUCKETS]; /**< Samples per power of two, 0 and 1 tick in bucket 0 */
+} ProfileStats;
+
+/**
+ * @ingroup kernel_core
+ * @brief Receives one line of the profile report
+ * @param line Text without a line ending
+ * @param arg Argument given to profile_report()
+ */
+typedef void (*ProfileReportLine)(const char *line, void *arg);
+
+/**
+ * @ingroup kernel_core
+ * @brief Start the clock and clear the table
+ * @param clock_hz Ticks per second, SystemCoreClock on the target
+ */
+void profile_init(uint32_t clock_hz);
+
+/**
+ * @ingroup kernel_core
+ * @brief Clear the table
+ *
+ * Samples recorded while the table is being cleared may be partly kept.
+ */
+void profile_reset(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Add one sample to a zone, from any task or interrupt
+ * @param zone Zone, out of range zones are ignored
+ * @param ticks Time the zone took
+ */
+void profile_record(ProfileZone zone, uint32_t ticks);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read a zone
+ * @param zone Zone
+ * @param stats Receives a snapshot
+ * @return false if zone is out of range
+ */
+bool profile_get(ProfileZone zone, ProfileStats *stats);
+
+/**
+ * @ingroup kernel_core
+ * @brief Short name of a zone
+ * @param zone Zone
+ * @return Name such as "flush"
+ */
+const char *profile_zone_name(ProfileZone zone);
+
+/**
+ * @ingroup kernel_core
+ * @brief Ticks per second given to profile_init()
+ */
+uint32_t profile_clock_hz(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Estimate a percentile from the histogram
+ * @param stats Zone statistics
+ * @param percent Percentile, 1 to 100
+ * @return Upper bound in ticks of the bucket holding the percentile, at most
+ *         stats->max, 0 without samples
+ */
+uint32_t profile_percentile(const ProfileStats *stats, uint32_t percent);
+
+/**
+ * @ingroup kernel_core
+ * @brief Lay the table out as text
+ * @param out Called once per line
+ * @param arg Passed to out
+ * @return Number of lines written
+ *
+ * A header, then one line per zone with its count and its minimum, mean,
+ * 99th percentile and maximum in microseconds. Lines are at most 40
+ * characters, the width of the debug page.
+ */
+int profile_report(ProfileReportLine out, void *arg);
+
+/**
+ * @ingroup kernel_core
+ * @brief Current time in ticks
+ */
+static inline uint32_t profile_now(void)
+{
+#if defined(__arm__)
+    return *(volatile uint32_t *)0xE0001004UL; // DWT->CYCCNT
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+#if defined(PROFILE_ENABLED)
+/** @ingroup kernel_core
+ *  @brief Start of a zone, closed by PROFILE_ZONE_END() in the same block */
+#define PROFILE_ZONE_BEGIN(zone) const uint32_t profile_start_##zone = profile_now()
+/** @ingroup kernel_core
+ *  @brief End of a zone, records the time since its PROFILE_ZONE_BEGIN() */
+#define PROFILE_ZONE_END(zone) profile_record((zone), profile_now() - profile_start_##zone)
+#else
+#define PROFILE_ZONE_BEGIN(zone) ((void)0)
+#define PROFILE_ZONE_END(zone) ((void)0)
+#endif
+
+#endif // PROFILE_H
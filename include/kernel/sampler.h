@@ -0,0 +1,213 @@
+/**
+ * @file sampler.h
+ * @brief Statistical PC sampling on a hardware timer, for profiles on the host
+ * @ingroup kernel_core
+ *
+ * While the sampler runs, TIM7 interrupts at a set rate and records where
+ * the CPU was: the PC and LR the interrupt stacked, the task that was
+ * running and, when an interrupt handler was interrupted, its exception
+ * number. The timer's priority is above configMAX_SYSCALL_INTERRUPT_PRIORITY,
+ * so code inside critical sections and lower priority handlers is sampled
+ * too. Nothing has to be instrumented: a HAL busy-wait shows up as readily
+ * as a known hot loop. A sample is a few dozen instructions.
+ *
+ * The ring keeps the newest SAMPLER_RING_SIZE samples. The default rate is
+ * a prime, so periodic work at the tick rate or its multiples is not
+ * sampled at the same phase every time. Stop mode, which halts TIM7, is
+ * held off while sampling; idle time shows up as samples in the idle task.
+ *
+ * sampler_dump() writes a header, the names of the tasks and the samples,
+ * oldest first, to any byte sink, pausing the timer meanwhile. On the
+ * target that is a file on the SD card or the debug UART.
+ * tools/sample_profile.py symbolises a dump against the firmware ELF with
+ * addr2line and prints a flat and a per-task profile.
+ *
+ * The timer only exists on the target built with SAMPLER_ENABLED;
+ * elsewhere the ring and the dump work, fed by sampler_record(), and
+ * sampler_start() returns false.
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SAMPLER_RING_LOG2
+/** @ingroup kernel_core
+ *  @brief log2 of the ring size in samples, 16 bytes each */
+#define SAMPLER_RING_LOG2 10
+#endif
+
+/** @ingroup kernel_core
+ *  @brief Samples kept in the ring */
+#define SAMPLER_RING_SIZE (1u << SAMPLER_RING_LOG2)
+
+/** @ingroup kernel_core
+ *  @brief Default sampling rate in Hz, a prime just under 1 kHz */
+#define SAMPLER_DEFAULT_HZ 997
+
+/** @ingroup kernel_core
+ *  @brief Lowest rate, where the timer's 16-bit period runs out */
+#define SAMPLER_MIN_HZ 16
+
+/** @ingroup kernel_core
+ *  @brief Highest rate */
+#define SAMPLER_MAX_HZ 20000
+
+/** @ingroup kernel_core
+ *  @brief Task names kept for the dump */
+#define SAMPLER_MAX_TASKS 24
+
+/** @ingroup kernel_core
+ *  @brief Characters of a task name kept, including the terminator */
+#define SAMPLER_NAME_LEN 12
+
+/** @ingroup kernel_core
+ *  @brief First four bytes of a dump */
+#define SAMPLER_DUMP_MAGIC "UQPS"
+/** @ingroup kernel_core
+ *  @brief First four bytes of the dump trailer */
+#define SAMPLER_DUMP_END "UQPE"
+/** @ingroup kernel_core
+ *  @brief Dump layout version, bump when a struct below changes */
+#define SAMPLER_DUMP_VERSION 1
+
+/**
+ * @brief One sample, as stored and dumped
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t pc;        /**< Stacked PC, the next instruction of the interrupted code */
+    uint32_t lr;        /**< Stacked LR, usually the caller of the interrupted function */
+    uint32_t task;      /**< Handle of the running task, 0 before the scheduler starts */
+    uint16_t exception; /**< Exception number interrupted, 0 in a task */
+    uint16_t reserved;
+} SamplerRecord;
+
+/**
+ * @brief Task name entry, as dumped
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t task;               /**< Task handle, as in SamplerRecord */
+    char name[SAMPLER_NAME_LEN]; /**< Always terminated */
+} SamplerName;
+
+/**
+ * @brief Dump header, little-endian like the records
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    char magic[4];        /**< SAMPLER_DUMP_MAGIC */
+    uint16_t version;     /**< SAMPLER_DUMP_VERSION */
+    uint16_t record_size; /**< sizeof(SamplerRecord) */
+    uint32_t rate_hz;     /**< Samples per second while running */
+    uint32_t capacity;    /**< SAMPLER_RING_SIZE */
+    uint32_t taken;       /**< Samples taken since sampler_init(), the last one dumped is taken - 1 */
+    uint32_t count;       /**< Samples that follow the names */
+    uint16_t name_count;  /**< Names that follow the header */
+    uint16_t name_size;   /**< sizeof(SamplerName) */
+    uint32_t reserved;
+} SamplerDumpHeader;
+
+/**
+ * @brief Sampler statistics
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t taken;       /**< Samples taken since sampler_init() */
+    uint32_t overwritten; /**< Samples lost to the ring wrapping */
+    uint32_t capacity;    /**< SAMPLER_RING_SIZE */
+    uint32_t rate_hz;     /**< Rate of the last start, 0 if never started */
+    bool running;         /**< Timer running now */
+} SamplerStats;
+
+/**
+ * @brief Byte sink for sampler_dump()
+ * @return false to stop the dump
+ */
+typedef bool (*SamplerWriteFn)(const void *data, size_t len, void *arg);
+
+/**
+ * @ingroup kernel_core
+ * @brief Stop the timer and clear the ring
+ */
+void sampler_init(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Start sampling
+ * @param rate_hz Samples per second, clamped to SAMPLER_MIN_HZ..SAMPLER_MAX_HZ
+ * @return false where there is no timer
+ *
+ * Starting while running changes the rate. The rate actually used is the
+ * nearest the timer can divide to, and is reported in the statistics.
+ */
+bool sampler_start(uint32_t rate_hz);
+
+/**
+ * @ingroup kernel_core
+ * @brief Stop sampling, the ring is kept
+ */
+void sampler_stop(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Append a sample
+ *
+ * Called by the timer interrupt, which is the only writer.
+ *
+ * @param pc Interrupted PC
+ * @param lr Interrupted LR
+ * @param task Running task handle
+ * @param exception Interrupted exception number, 0 in a task
+ */
+void sampler_record(uint32_t pc, uint32_t lr, uint32_t task, uint16_t exception);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the sampler statistics
+ * @param stats Receives a snapshot
+ */
+void sampler_get_stats(SamplerStats *stats);
+
+/**
+ * @ingroup kernel_core
+ * @brief Write the ring to a sink
+ *
+ * The timer pauses during the dump and resumes afterwards. The dump is a
+ * SamplerDumpHeader, the task names, the samples oldest first and a
+ * trailer of SAMPLER_DUMP_END and the 32-bit sum of every byte before it.
+ * Task names are read from the kernel when the dump is taken; a task
+ * deleted since it was sampled shows up by its handle.
+ *
+ * @param write Sink, called several times
+ * @param arg Passed to the sink
+ * @return Bytes written, 0 if the sink failed
+ */
+size_t sampler_dump(SamplerWriteFn write, void *arg);
+
+#if defined(__arm__) && defined(USE_FREERTOS)
+/**
+ * @ingroup kernel_core
+ * @brief Dump to a file on the SD card
+ * @param path File to create or replace
+ * @return true if the whole dump was written
+ */
+bool sampler_save(const char *path);
+
+/**
+ * @ingroup kernel_core
+ * @brief Dump over the debug UART, when the board has one
+ * @return true if the whole dump was sent
+ */
+bool sampler_send_uart(void);
+#endif
+
+#endif // SAMPLER_H
@@ -0,0 +1,47 @@
+/**
+ * @file boot_task.h
+ * @brief Background bring-up and the boot report
+ * @ingroup boot_task
+ *
+ * FreeRTOS task for the start-up work no other task owns: the LED strip,
+ * which main() used to light before the scheduler started, and the SD card
+ * mount. It runs below the UI, so the display task draws its first frame
+ * while the card and the modem are still coming up, then waits for every
+ * phase of the boot timeline, logs the report and deletes itself.
+ */
+
+#ifndef BOOT_TASK_H_
+#define BOOT_TASK_H_
+
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "cmsis_os2.h"
+
+/** @ingroup boot_task
+ *  @brief Stack size for boot task in bytes */
+#define BOOT_TASK_STACK_SIZE 2048
+
+/** @ingroup boot_task
+ *  @brief Boot task priority, below the tasks drawing and reading keys */
+#define BOOT_TASK_PRIORITY osPriorityBelowNormal
+
+/** @ingroup boot_task
+ *  @brief Settle time of the LED rail after main() switches it on, in milliseconds */
+#define BOOT_LED_SETTLE_MS 100
+
+/** @ingroup boot_task
+ *  @brief Interval between checks for the end of the boot in milliseconds */
+#define BOOT_POLL_PERIOD_MS 100
+
+/** @ingroup boot_task
+ *  @brief Longest wait for the boot to finish before the report is logged anyway */
+#define BOOT_REPORT_TIMEOUT_MS 30000
+
+/**
+ * @ingroup boot_task
+ * @brief Start the boot task
+ * @return true if the task was created
+ */
+bool BootTask_Init(void);
+
+#endif // BOOT_TASK_H_
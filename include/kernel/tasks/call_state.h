@@ -28,6 +28,10 @@
  *  @brief Call state task priority */
 #define CALL_STATE_TASK_PRIORITY osPriorityAboveNormal
 
+/** @ingroup call_state_task
+ *  @brief Longest call state loop silence before the task counts as hung, in milliseconds */
+#define CALL_STATE_TASK_HEARTBEAT_MS 1000
+
 /**
  * @brief Call state enumeration
  * @ingroup call_state_task
@@ -58,7 +62,7 @@ typedef enum
 #define CALL_EVENT_INCOMING (1 << 0) /**< Incoming call detected (controls vibration) */
 #define CALL_EVENT_ANSWER (1 << 1)   /**< Call answered (controls GPIO switching) */
 #define CALL_EVENT_HANGUP (1 << 2)   /**< Call ended (controls GPIO switching) */
-#define CALL_EVENT_DISPLAY (1 << 3)  /**< Display notification */
+#define CALL_EVENT_DISPLAY (1 << 3)  /**< Publish the state on the event bus */
 
 // Call data structure - for passing call information
 typedef struct
@@ -70,15 +74,14 @@ typedef struct
 typedef struct
 {
     CallCommand cmd;
-    void *data; // Points to CallData for commands that need it
+    void *data; // CallData pool message (MSG_TYPE_CALL_DATA) for commands that need it
 } CallMessage;
 
 // Opaque context
 typedef struct CallStateContext CallStateContext;
 
 // Public API
-CallStateContext *CallState_Init(DisplayTaskContext *display_ctx);
-void CallState_SetDisplayContext(CallStateContext *ctx, DisplayTaskContext *display_ctx);
+CallStateContext *CallState_Init(void);
 bool CallState_PostCommand(CallStateContext *ctx, CallCommand cmd, void *data);
 CallState CallState_GetCurrentState(CallStateContext *ctx);
 
@@ -28,6 +28,10 @@
  *  @brief Cellular task priority */
 #define CELLULAR_TASK_PRIORITY osPriorityNormal
 
+/** @ingroup cellular_task
+ *  @brief Longest cellular loop silence before the task is reported, in milliseconds */
+#define CELLULAR_TASK_HEARTBEAT_MS 30000
+
 /**
  * @brief Cellular command enumeration
  * @ingroup cellular_task
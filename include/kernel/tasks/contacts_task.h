@@ -0,0 +1,151 @@
+/**
+ * @file contacts_task.h
+ * @brief Contacts task, reads the contacts B+ tree for the contacts pages
+ * @ingroup contacts_task
+ *
+ * The contacts tree lives on the SD card, where every node read can wait on
+ * the card. This task owns the tree and reads it for the contacts list and
+ * contact search pages, so the display task never blocks on the card.
+ *
+ * A page asks for one row of its list: the search prefix (empty for every
+ * contact) and the row index. The task keeps one incremental search
+ * (contacts_search.h) per page, moves it to the prefix, and answers with
+ * the contact at that index and the number of matches found so far. The
+ * answers are queued for the display task, which drains them in its loop
+ * and hands them to the current page as PAGE_RESPONSE_CONTACTS, and the
+ * page passes the row on with vlist_deliver(). Each request carries the
+ * whole prefix, so a request or answer that is dropped only delays its row
+ * until the list asks for it again.
+ *
+ * The tree is opened on the first request after the card is mounted. A
+ * failed open is tried again on the next request.
+ */
+
+#ifndef CONTACTS_TASK_H_
+#define CONTACTS_TASK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cmsis_os2.h"
+#include "contacts_bptree.h"
+
+/** @ingroup contacts_task
+ *  @brief Contacts tree file on the SD card */
+#define CONTACTS_TREE_FILE "contacts.dat"
+
+/** @ingroup contacts_task
+ *  @brief Contacts data file on the SD card */
+#define CONTACTS_DATA_FILE "contact_data.dat"
+
+/** @ingroup contacts_task
+ *  @brief Stack size for contacts task in bytes */
+#define CONTACTS_TASK_STACK_SIZE 2048
+
+/** @ingroup contacts_task
+ *  @brief Contacts task priority, level with the cellular task, which spins in
+ *  HAL UART polling while it waits on the modem and starves anything below */
+#define CONTACTS_TASK_PRIORITY osPriorityNormal
+
+/** @ingroup contacts_task
+ *  @brief Longest contacts loop silence before the task is reported, in milliseconds */
+#define CONTACTS_TASK_HEARTBEAT_MS 10000
+
+/** @ingroup contacts_task
+ *  @brief Requests queued for the task, a full list window */
+#define CONTACTS_REQUEST_QUEUE_LENGTH 16
+
+/** @ingroup contacts_task
+ *  @brief Answers queued for the display task */
+#define CONTACTS_REPLY_QUEUE_LENGTH 8
+
+/** @ingroup contacts_task
+ *  @brief Longest the task waits for room in the answer queue, in milliseconds */
+#define CONTACTS_REPLY_WAIT_MS 100
+
+/** @ingroup contacts_task
+ *  @brief Matches found past a requested row, so one answer's count covers the list window */
+#define CONTACTS_DISCOVER_AHEAD 16
+
+/**
+ * @brief Page a request comes from, each has its own search
+ * @ingroup contacts_task
+ */
+typedef enum
+{
+    CONTACTS_CLIENT_LIST,   /**< Contacts list page */
+    CONTACTS_CLIENT_SEARCH, /**< Contact search page */
+    CONTACTS_CLIENT_COUNT
+} ContactsClient;
+
+/**
+ * @brief Contacts task commands
+ * @ingroup contacts_task
+ */
+typedef enum
+{
+    CONTACTS_CMD_ROW,  /**< Read a row for the list */
+    CONTACTS_CMD_OPEN, /**< Read the selected contact to open its details */
+} ContactsCommand;
+
+/**
+ * @brief Request posted to the contacts task
+ * @ingroup contacts_task
+ */
+typedef struct
+{
+    ContactsCommand cmd;      /**< Command type */
+    uint8_t client;           /**< ContactsClient */
+    char prefix[MAX_KEY_LEN]; /**< Search prefix, "" for every contact */
+    int32_t index;            /**< Result index */
+} ContactsRequest;
+
+/**
+ * @brief Answer to a request, passed to the page as PAGE_RESPONSE_CONTACTS
+ * @ingroup contacts_task
+ */
+typedef struct
+{
+    ContactsCommand cmd;      /**< Command answered */
+    uint8_t client;           /**< ContactsClient that asked */
+    char prefix[MAX_KEY_LEN]; /**< Prefix the answer is for */
+    int32_t index;            /**< Result index */
+    bool available;           /**< The tree is open */
+    bool has_contact;         /**< index is a match and contact holds it */
+    bool complete;            /**< found counts every match */
+    uint32_t found;           /**< Matches found so far */
+    ContactRecord contact;    /**< Contact at index */
+} ContactsReply;
+
+// Forward declaration
+typedef struct DisplayTaskContext DisplayTaskContext;
+
+/**
+ * @ingroup contacts_task
+ * @brief Initialize the contacts task
+ * @param display_ctx Display task context, woken when an answer is queued
+ * @return true if the task was started
+ */
+bool ContactsTask_Init(DisplayTaskContext *display_ctx);
+
+/**
+ * @ingroup contacts_task
+ * @brief Ask the contacts task for a result
+ * @param cmd Command to post
+ * @param client Page asking
+ * @param prefix Search prefix, "" for every contact
+ * @param index Result index
+ * @return true if the request was queued
+ *
+ * Does not block. The answer arrives later through the display task.
+ */
+bool ContactsTask_PostRequest(ContactsCommand cmd, ContactsClient client, const char *prefix, int index);
+
+/**
+ * @ingroup contacts_task
+ * @brief Take the next answer, called by the display task
+ * @param reply Receives the answer
+ * @return false if no answer is waiting
+ */
+bool ContactsTask_GetReply(ContactsReply *reply);
+
+#endif // CONTACTS_TASK_H_
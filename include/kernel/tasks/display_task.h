@@ -6,6 +6,10 @@
  * FreeRTOS task that handles all display rendering, UI updates, and user input events.
  * This task manages the screen buffer and coordinates with other tasks to display
  * system status, incoming calls, messages, and application pages.
+ *
+ * Battery, signal, SMS-received, call state and key events arrive through
+ * the event bus (event_bus.h); commands posted here are the requests
+ * addressed to the display task alone.
  */
 
 #ifndef DISPLAY_TASK_H_
@@ -23,6 +27,7 @@
 #include "display.h"
 #include "tile.h"
 #include "input.h"
+#include "input_pipeline.h"
 #include "pages/menu.h"
 #include "status_bar.h"
 #include "task.h"
@@ -36,6 +41,14 @@
  *  @brief Display task priority */
 #define DISPLAY_TASK_PRIORITY osPriorityNormal
 
+/** @ingroup display_task
+ *  @brief Longest display loop silence before the task counts as hung, in milliseconds */
+#define DISPLAY_TASK_HEARTBEAT_MS 3000
+
+/** @ingroup display_task
+ *  @brief Longest the display loop sleeps when no timer is due, in milliseconds */
+#define DISPLAY_MAX_SLEEP_MS 1000
+
 /**
  * @brief Display task commands
  * @ingroup display_task
@@ -45,16 +58,10 @@ typedef enum
     DISPLAY_HANDLE_INPUT,
     DISPLAY_SET_PAGE,
     DISPLAY_CLEAR_SCREEN,
-    DISPLAY_SET_BATTERY_STATUS,
-    DISPLAY_SET_SIGNAL_STATUS,
     DISPLAY_SET_VOLUME,
-    DISPLAY_INCOMING_CALL,
-    DISPLAY_ACTIVE_CALL,
-    DISPLAY_CALL_ENDED,
-    DISPLAY_DIALLING,
-    DISPLAY_SHOW_SMS,
     DISPLAY_SET_BATTERY_PAGE,
     DISPLAY_SYNC_RTC,
+    DISPLAY_SET_HEADPHONE_STATUS,
     DISPLAY_CMD_COUNT
 } DisplayCommand;
 
@@ -133,7 +140,23 @@ void DisplayTask_SetPowerContext(DisplayTaskContext *ctx, PowerTaskContext *powe
  * @param cmd Command to post
  * @param data Optional command data
  * @return true if command was posted successfully
+ *
+ * When data is a msg_pool message the caller's reference moves to the
+ * display task, which releases it after handling. If the post fails the
+ * reference is released here, so the caller never touches data again.
  */
 bool DisplayTask_PostCommand(DisplayTaskContext *ctx, DisplayCommand cmd, void *data);
 
+/**
+ * @ingroup display_task
+ * @brief Wake the display task from its sleep
+ * @param ctx Display task context
+ *
+ * The display loop sleeps until the next UI timer expiry. Producers that
+ * do not go through DisplayTask_PostCommand(), such as the event bus
+ * subscriptions, call this after handing over work. Safe to call from
+ * interrupts.
+ */
+void DisplayTask_Wake(DisplayTaskContext *ctx);
+
 #endif // DISPLAY_TASK_H_
\ No newline at end of file
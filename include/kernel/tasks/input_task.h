@@ -18,6 +18,7 @@
 #include "task_types.h"
 #include "input.h"
 #include "keypad.h"
+#include "input_pipeline.h"
 #include "display_task.h"
 #include "audio_task.h"
 
@@ -38,6 +39,18 @@ typedef struct CallStateContext CallStateContext;
  *  @brief Priority level for input task */
 #define INPUT_TASK_PRIORITY osPriorityNormal
 
+/** @ingroup input_task
+ *  @brief Keypad scan period while a key is held or debouncing, in milliseconds */
+#define INPUT_SCAN_PERIOD_MS 5
+
+/** @ingroup input_task
+ *  @brief Keypad poll period while idle, for the keys without a wake interrupt, in milliseconds */
+#define INPUT_IDLE_POLL_MS 50
+
+/** @ingroup input_task
+ *  @brief Longest keypad scan silence before the task counts as hung, in milliseconds */
+#define INPUT_TASK_HEARTBEAT_MS 500
+
 /**
  * @ingroup input_task
  * @brief Initialize the input handling task
@@ -26,6 +26,14 @@
  *  @brief Power task priority */
 #define POWER_TASK_PRIORITY osPriorityLow
 
+/** @ingroup power_task
+ *  @brief Battery state of charge check period, in milliseconds */
+#define POWER_BATTERY_CHECK_MS 5000
+
+/** @ingroup power_task
+ *  @brief Longest power loop silence before the task is reported, in milliseconds */
+#define POWER_TASK_HEARTBEAT_MS (2 * POWER_BATTERY_CHECK_MS)
+
 /**
  * @brief Power command enumeration
  * @ingroup power_task
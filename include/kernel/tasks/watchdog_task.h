@@ -0,0 +1,52 @@
+/**
+ * @file watchdog_task.h
+ * @brief Task health monitor and hardware watchdog
+ * @ingroup watchdog_task
+ *
+ * FreeRTOS task that samples stack high-water marks and run-time stats for
+ * every task, checks the heartbeats registered with the health monitor and
+ * refreshes the independent watchdog only while every critical task is
+ * alive. The history kept by the health monitor is placed in backup SRAM so
+ * hangs and low stacks can be read back on the debug page after the reset.
+ */
+
+#ifndef WATCHDOG_TASK_H_
+#define WATCHDOG_TASK_H_
+
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "cmsis_os2.h"
+#include "health_monitor.h"
+
+/** @ingroup watchdog_task
+ *  @brief Stack size for watchdog task in bytes */
+#define WATCHDOG_TASK_STACK_SIZE 1024
+
+/** @ingroup watchdog_task
+ *  @brief Watchdog task priority, above the tasks it checks */
+#define WATCHDOG_TASK_PRIORITY osPriorityAboveNormal1
+
+/** @ingroup watchdog_task
+ *  @brief Interval between heartbeat checks in milliseconds */
+#define WATCHDOG_CHECK_PERIOD_MS 500
+
+/** @ingroup watchdog_task
+ *  @brief Interval between stack and CPU samples in milliseconds */
+#define WATCHDOG_SAMPLE_PERIOD_MS 1000
+
+/** @ingroup watchdog_task
+ *  @brief Independent watchdog timeout in milliseconds */
+#define WATCHDOG_TIMEOUT_MS 4000
+
+/**
+ * @ingroup watchdog_task
+ * @brief Attach the backup SRAM history and start the watchdog task
+ * @return true if the task was created
+ *
+ * Call before the other tasks are created so their heartbeats can
+ * register. The hardware watchdog is started by the task itself, so a
+ * scheduler that never starts does not reset the system.
+ */
+bool WatchdogTask_Init(void);
+
+#endif // WATCHDOG_TASK_H_
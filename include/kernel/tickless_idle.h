@@ -0,0 +1,135 @@
+/**
+ * @file tickless_idle.h
+ * @brief Tickless idle on LPTIM1 with Stop mode
+ * @ingroup kernel_core
+ *
+ * When every task is blocked, FreeRTOS calls vPortSuppressTicksAndSleep()
+ * with the number of ticks until the next task wakes. The SysTick and the
+ * 1 kHz HAL time base are stopped and LPTIM1, clocked from the LSI, is
+ * programmed to fire when that time is up. Any other interrupt, such as a
+ * keypad or modem ring EXTI, ends the sleep early. On wake the RTOS tick
+ * and the HAL tick are advanced by the time that passed, measured on LPTIM1.
+ *
+ * Sleeps of at least TICKLESS_STOP_MIN_TICKS enter Stop mode, shorter ones
+ * and sleeps while a driver holds a Stop veto use WFI with the clocks
+ * running. Drivers with a transfer in flight that needs the bus clocks,
+ * such as the display MDMA, take a veto with tickless_stop_hold() for its
+ * duration.
+ *
+ * LPTIM1 counts in whole counts while the RTOS counts in ticks, so the
+ * leftover fraction of each sleep, and the part of a tick the SysTick had
+ * already counted, is carried into the next conversion. Repeated sleeps
+ * therefore do not drift against the LSI. The conversion helpers are
+ * portable and are tested on the host.
+ */
+
+#ifndef TICKLESS_IDLE_H
+#define TICKLESS_IDLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef TICKLESS_STOP_MIN_TICKS
+/** @ingroup kernel_core
+ *  @brief Shortest sleep worth the Stop mode clock restart */
+#define TICKLESS_STOP_MIN_TICKS 10
+#endif
+
+/**
+ * @brief Low-power timer against RTOS tick conversion
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t counter_hz; /**< Low-power timer count rate */
+    uint32_t tick_hz;    /**< RTOS tick rate */
+    uint32_t max_counts; /**< Largest compare value the timer takes */
+    uint32_t carry;      /**< Leftover in counts * tick_hz units */
+} TicklessClock;
+
+/**
+ * @brief Sleep counters
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t sleeps;      /**< Sleeps with the tick suppressed */
+    uint32_t stops;       /**< Of those, sleeps in Stop mode */
+    uint32_t vetoed;      /**< Long enough for Stop but held by a driver */
+    uint32_t aborted;     /**< Abandoned because a task became ready */
+    uint32_t early_wakes; /**< Ended by an interrupt before the timer */
+    uint32_t sleep_ticks; /**< Ticks spent asleep */
+    uint32_t stop_ticks;  /**< Ticks spent in Stop mode */
+} TicklessStats;
+
+/**
+ * @ingroup kernel_core
+ * @brief Set up a conversion
+ * @param clock Conversion state
+ * @param counter_hz Low-power timer count rate
+ * @param tick_hz RTOS tick rate
+ * @param max_counts Largest compare value the timer takes
+ */
+void tickless_clock_init(TicklessClock *clock, uint32_t counter_hz, uint32_t tick_hz, uint32_t max_counts);
+
+/**
+ * @ingroup kernel_core
+ * @brief Longest sleep the timer can measure
+ * @param clock Conversion state
+ * @return Ticks
+ */
+uint32_t tickless_max_ticks(const TicklessClock *clock);
+
+/**
+ * @ingroup kernel_core
+ * @brief Timer counts for a sleep, taking the carried fraction into account
+ * @param clock Conversion state
+ * @param ticks Ticks to sleep, capped at tickless_max_ticks()
+ * @param partial Fraction of a tick already counted before the sleep, in
+ *                1/65536 of a tick
+ * @return Counts that end the sleep on the tick boundary, at least 1
+ */
+uint32_t tickless_counts_for(const TicklessClock *clock, uint32_t ticks, uint32_t partial);
+
+/**
+ * @ingroup kernel_core
+ * @brief Whole ticks elapsed in a sleep, carrying the remainder
+ * @param clock Conversion state
+ * @param counts Timer counts measured during the sleep
+ * @param partial Fraction of a tick already counted before the sleep, in
+ *                1/65536 of a tick
+ * @param limit Most ticks the RTOS may be stepped by
+ * @return Whole ticks elapsed, at most limit
+ */
+uint32_t tickless_ticks_elapsed(TicklessClock *clock, uint32_t counts, uint32_t partial, uint32_t limit);
+
+/**
+ * @ingroup kernel_core
+ * @brief Start LPTIM1 on the LSI for tickless idle
+ *
+ * Call before the scheduler starts.
+ */
+void tickless_idle_init(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Keep the system out of Stop mode until the matching release
+ *
+ * Nests, and is safe from tasks and interrupts.
+ */
+void tickless_stop_hold(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Drop a veto taken with tickless_stop_hold()
+ */
+void tickless_stop_release(void);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the sleep counters
+ * @param stats Receives a snapshot
+ */
+void tickless_get_stats(TicklessStats *stats);
+
+#endif // TICKLESS_IDLE_H
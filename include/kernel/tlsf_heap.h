@@ -0,0 +1,168 @@
+/**
+ * @file tlsf_heap.h
+ * @brief Constant-time two-level segregated fit heap
+ * @ingroup kernel_core
+ *
+ * Free blocks are kept in lists indexed by a first level (power of two) and
+ * a second level (TLSF_SL_COUNT linear steps inside it). Two bitmaps record
+ * which lists are non-empty, so finding a block that fits is two
+ * find-first-set operations and never walks the heap. Below 128 bytes the
+ * lists are exact 8-byte size classes. Freed blocks merge with their
+ * physical neighbours straight away through boundary tags.
+ *
+ * Malloc, free and an in-place realloc therefore run in bounded time
+ * regardless of how long the heap has been in use. Each block carries a
+ * two-word header, the same as heap_4.
+ *
+ * The heap itself is not locked. Built with HEAP_TLSF and USE_FREERTOS,
+ * tlsf_heap.c also provides pvPortMalloc() and the rest of the FreeRTOS heap
+ * interface over configTOTAL_HEAP_SIZE in place of heap_4.c, with the
+ * scheduler suspended around each call as heap_4 does. The control
+ * structure is carved from the start of that array, so the heap's RAM
+ * budget does not change.
+ */
+
+#ifndef TLSF_HEAP_H
+#define TLSF_HEAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TLSF_FL_MAX_LOG2
+/** @ingroup kernel_core
+ *  @brief Blocks stay below 2^TLSF_FL_MAX_LOG2 bytes, raise it with the heap */
+#define TLSF_FL_MAX_LOG2 14
+#endif
+
+/** @ingroup kernel_core
+ *  @brief log2 of the second-level lists per power of two */
+#define TLSF_SL_LOG2 4
+/** @ingroup kernel_core
+ *  @brief Second-level lists per power of two */
+#define TLSF_SL_COUNT (1 << TLSF_SL_LOG2)
+/** @ingroup kernel_core
+ *  @brief Alignment of every returned block, in bytes */
+#define TLSF_ALIGN 8
+/** @ingroup kernel_core
+ *  @brief log2 of the size where first-level lists start */
+#define TLSF_FL_SHIFT (TLSF_SL_LOG2 + 3)
+/** @ingroup kernel_core
+ *  @brief Blocks smaller than this share the first list, in 8-byte classes */
+#define TLSF_SMALL_SIZE (1 << TLSF_FL_SHIFT)
+/** @ingroup kernel_core
+ *  @brief Number of first-level lists */
+#define TLSF_FL_COUNT (TLSF_FL_MAX_LOG2 - TLSF_FL_SHIFT + 1)
+
+typedef struct TlsfBlock TlsfBlock;
+
+/**
+ * @brief Heap statistics
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    size_t total_bytes;    /**< Usable bytes when the heap is empty */
+    size_t free_bytes;     /**< Sum of all free blocks */
+    size_t min_ever_free;  /**< Lowest free_bytes since init */
+    size_t largest_free;   /**< Largest single free block */
+    size_t smallest_free;  /**< Smallest single free block */
+    size_t free_blocks;    /**< Number of free blocks */
+    size_t used_blocks;    /**< Number of allocated blocks */
+    uint32_t allocs;       /**< Successful allocations */
+    uint32_t frees;        /**< Blocks freed */
+    uint32_t failed;       /**< Allocations that did not fit */
+    uint32_t realloc_kept; /**< Reallocs done without moving the block */
+} TlsfStats;
+
+/**
+ * @brief Heap control structure
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t fl_bitmap;                              /**< First levels with a free block */
+    uint32_t sl_bitmap[TLSF_FL_COUNT];               /**< Second levels with a free block */
+    TlsfBlock *blocks[TLSF_FL_COUNT][TLSF_SL_COUNT]; /**< Free list heads */
+    TlsfBlock *first;                                /**< Lowest block in the arena */
+    TlsfStats stats;                                 /**< Running counters */
+} TlsfHeap;
+
+/**
+ * @ingroup kernel_core
+ * @brief Set up a heap over an arena
+ * @param heap Control structure to initialise
+ * @param mem Arena, aligned to TLSF_ALIGN
+ * @param bytes Arena size
+ * @return false if the arena is too small, too large or misaligned
+ */
+bool tlsf_heap_init(TlsfHeap *heap, void *mem, size_t bytes);
+
+/**
+ * @ingroup kernel_core
+ * @brief Allocate a block
+ * @param heap Heap to allocate from
+ * @param size Bytes requested
+ * @return Block aligned to TLSF_ALIGN, or NULL if size is 0 or nothing fits
+ */
+void *tlsf_heap_malloc(TlsfHeap *heap, size_t size);
+
+/**
+ * @ingroup kernel_core
+ * @brief Return a block to the heap
+ * @param heap Heap the block came from
+ * @param ptr Block, or NULL
+ */
+void tlsf_heap_free(TlsfHeap *heap, void *ptr);
+
+/**
+ * @ingroup kernel_core
+ * @brief Resize a block, in place when it or its free neighbour has room
+ * @param heap Heap the block came from
+ * @param ptr Block, or NULL to allocate
+ * @param size New size, or 0 to free
+ * @return The block, possibly moved, or NULL with ptr untouched if nothing fits
+ */
+void *tlsf_heap_realloc(TlsfHeap *heap, void *ptr, size_t size);
+
+/**
+ * @ingroup kernel_core
+ * @brief Usable size of an allocated block
+ * @param ptr Block from tlsf_heap_malloc()
+ * @return Bytes that can be written, at least the size requested
+ */
+size_t tlsf_heap_usable_size(const void *ptr);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the heap statistics
+ *
+ * The largest and smallest free block are found from the bitmaps and the
+ * two lists at either end, not by walking the heap.
+ *
+ * @param heap Heap to read
+ * @param stats Receives a snapshot
+ */
+void tlsf_heap_get_stats(const TlsfHeap *heap, TlsfStats *stats);
+
+/**
+ * @ingroup kernel_core
+ * @brief Walk the whole heap and check its invariants
+ *
+ * Physical links, free flags, merged neighbours, list membership and the
+ * bitmaps. Linear in the number of blocks, meant for tests and debugging.
+ *
+ * @param heap Heap to check
+ * @return true if the heap is consistent
+ */
+bool tlsf_heap_check(const TlsfHeap *heap);
+
+#if defined(HEAP_TLSF) && defined(USE_FREERTOS)
+/**
+ * @ingroup kernel_core
+ * @brief FreeRTOS heap resize, provided alongside pvPortMalloc()
+ */
+void *pvPortReAlloc(void *ptr, size_t size);
+#endif
+
+#endif
@@ -0,0 +1,299 @@
+/**
+ * @file trace.h
+ * @brief Binary event trace in a RAM ring, for timelines on the host
+ * @ingroup kernel_core
+ *
+ * Every record is 16 bytes: a cycle-counter timestamp (DWT CYCCNT on the
+ * target, nanoseconds on the host), an event id and two arguments. Writers
+ * reserve a slot with one atomic increment and never lock, so records can
+ * be written from tasks and interrupts alike. The ring keeps the newest
+ * TRACE_RING_SIZE records.
+ *
+ * Each record's sequence tag is stored last. A record still being written,
+ * or overwritten while a dump was read, has a tag that does not match its
+ * position, and the decoder drops it rather than showing a torn event.
+ *
+ * Built with TRACE_ENABLED, FreeRTOSConfig.h routes the kernel's trace
+ * macros here: task creation and switches, queue and semaphore traffic,
+ * and registered queue names. Interrupt handlers mark their entry and exit
+ * with TRACE_ISR_ENTER() and TRACE_ISR_EXIT(). Drivers and tasks add their
+ * own spans with TRACE_BEGIN() and TRACE_END(). Without TRACE_ENABLED the
+ * macros compile to nothing.
+ *
+ * trace_trigger() keeps recording for a number of records more and then
+ * freezes the ring, so the moments around an event of interest survive
+ * until they are dumped. trace_dump() writes a header, the task and queue
+ * names and the records, oldest first, to any byte sink. On the target that
+ * is a file on the SD card or the debug UART. tools/trace_decode.py turns a
+ * dump into Chrome trace JSON for chrome://tracing or Perfetto.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TRACE_RING_LOG2
+/** @ingroup kernel_core
+ *  @brief log2 of the ring size in records, 16 bytes each */
+#define TRACE_RING_LOG2 10
+#endif
+
+/** @ingroup kernel_core
+ *  @brief Records kept in the ring */
+#define TRACE_RING_SIZE (1u << TRACE_RING_LOG2)
+
+#ifndef TRACE_MAX_NAMES
+/** @ingroup kernel_core
+ *  @brief Task and queue names kept for the dump */
+#define TRACE_MAX_NAMES 24
+#endif
+
+/** @ingroup kernel_core
+ *  @brief Characters of a name kept, including the terminator */
+#define TRACE_NAME_LEN 12
+
+/** @ingroup kernel_core
+ *  @brief First four bytes of a dump */
+#define TRACE_DUMP_MAGIC "UQTR"
+/** @ingroup kernel_core
+ *  @brief First four bytes of the dump trailer */
+#define TRACE_DUMP_END "UQTE"
+/** @ingroup kernel_core
+ *  @brief Dump layout version, bump when a struct below changes */
+#define TRACE_DUMP_VERSION 1
+
+/** @ingroup kernel_core
+ *  @brief Set in an event id for the start of a span */
+#define TRACE_FLAG_BEGIN 0x8000u
+/** @ingroup kernel_core
+ *  @brief Set in an event id for the end of a span */
+#define TRACE_FLAG_END 0x4000u
+/** @ingroup kernel_core
+ *  @brief Event id without the span flags */
+#define TRACE_ID_MASK 0x3FFFu
+
+/**
+ * @brief Event ids, shared with tools/trace_decode.py
+ * @ingroup kernel_core
+ */
+typedef enum
+{
+    TRACE_TASK_SWITCH = 1,      /**< arg0 task number, arg1 priority */
+    TRACE_QUEUE_SEND,           /**< arg0 queue, arg1 items waiting before the send */
+    TRACE_QUEUE_SEND_FAILED,    /**< arg0 queue, arg1 items waiting */
+    TRACE_QUEUE_RECEIVE,        /**< arg0 queue, arg1 items waiting before the receive */
+    TRACE_QUEUE_RECEIVE_FAILED, /**< arg0 queue, arg1 items waiting */
+    TRACE_ISR,                  /**< Span, arg0 exception number */
+    TRACE_IDLE_SLEEP,           /**< Span, begin arg0 ticks expected and arg1 1 for Stop mode,
+                                     end arg0 ticks slept and arg1 1 if the wake timer fired */
+
+    TRACE_USER = 0x100,               /**< First id for drivers and tasks */
+    TRACE_DISPLAY_FLUSH = TRACE_USER, /**< Span, end arg0 tiles drawn and arg1 bytes sent */
+    TRACE_AT_COMMAND,                 /**< Span, begin arg0 first four command bytes,
+                                           end arg0 result and arg1 response bytes */
+    TRACE_AUDIO_BUFFER,               /**< Span, arg0 samples, end arg1 HAL status */
+    TRACE_INCOMING_CALL,              /**< Instant, RING seen by the call state task */
+} TraceEventId;
+
+/**
+ * @brief Kind of object a name belongs to
+ * @ingroup kernel_core
+ */
+typedef enum
+{
+    TRACE_NAME_TASK = 1, /**< Key is the task number */
+    TRACE_NAME_QUEUE,    /**< Key is the queue address */
+} TraceNameKind;
+
+/**
+ * @brief One trace record, as stored and dumped
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t timestamp; /**< Cycle counter */
+    uint16_t id;        /**< TraceEventId with span flags */
+    uint16_t tag;       /**< Ring lap plus one, stored last */
+    uint32_t arg0;
+    uint32_t arg1;
+} TraceRecord;
+
+/**
+ * @brief Name table entry, as dumped
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t key;                  /**< Task number or queue address */
+    uint8_t kind;                  /**< TraceNameKind */
+    char name[TRACE_NAME_LEN - 1]; /**< Not terminated when full */
+} TraceName;
+
+/**
+ * @brief Dump header, little-endian like the records
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    char magic[4];        /**< TRACE_DUMP_MAGIC */
+    uint16_t version;     /**< TRACE_DUMP_VERSION */
+    uint16_t record_size; /**< sizeof(TraceRecord) */
+    uint32_t clock_hz;    /**< Timestamp counts per second */
+    uint32_t capacity;    /**< TRACE_RING_SIZE */
+    uint32_t head;        /**< Records reserved since trace_init(), the last one dumped is head - 1 */
+    uint32_t count;       /**< Records that follow the names */
+    uint16_t name_count;  /**< Names that follow the header */
+    uint16_t name_size;   /**< sizeof(TraceName) */
+    uint32_t reserved;
+} TraceDumpHeader;
+
+/**
+ * @brief Trace statistics
+ * @ingroup kernel_core
+ */
+typedef struct
+{
+    uint32_t written;     /**< Records reserved since trace_init() */
+    uint32_t overwritten; /**< Records lost to the ring wrapping */
+    uint32_t capacity;    /**< TRACE_RING_SIZE */
+    uint16_t names;       /**< Names registered */
+    bool enabled;         /**< Recording now */
+    bool triggered;       /**< Frozen, or about to freeze, by trace_trigger() */
+} TraceStats;
+
+/**
+ * @brief Byte sink for trace_dump()
+ * @return false to stop the dump
+ */
+typedef bool (*TraceWriteFn)(const void *data, size_t len, void *arg);
+
+/**
+ * @ingroup kernel_core
+ * @brief Clear the ring and names and start recording
+ * @param clock_hz Timestamp counts per second, SystemCoreClock on the target
+ */
+void trace_init(uint32_t clock_hz);
+
+/**
+ * @ingroup kernel_core
+ * @brief Append a record, from any task or interrupt
+ * @param id TraceEventId, optionally with TRACE_FLAG_BEGIN or TRACE_FLAG_END
+ * @param arg0 First argument
+ * @param arg1 Second argument
+ */
+void trace_record(uint16_t id, uint32_t arg0, uint32_t arg1);
+
+/**
+ * @ingroup kernel_core
+ * @brief Record a context switch, skipped when the same task carries on
+ * @param task Task number
+ * @param priority Task priority
+ */
+void trace_task_switch(uint32_t task, uint32_t priority);
+
+/**
+ * @ingroup kernel_core
+ * @brief Give a task or queue a name in the dump
+ *
+ * A key already in the table is renamed. Names past TRACE_MAX_NAMES are
+ * dropped and their records show the key instead.
+ *
+ * @param kind TraceNameKind
+ * @param key Task number or queue address
+ * @param name Name, truncated to TRACE_NAME_LEN - 1 characters
+ */
+void trace_name(TraceNameKind kind, uint32_t key, const char *name);
+
+/**
+ * @ingroup kernel_core
+ * @brief Start or stop recording
+ *
+ * Enabling also cancels a pending or fired trigger.
+ *
+ * @param enabled true to record
+ */
+void trace_set_enabled(bool enabled);
+
+/**
+ * @ingroup kernel_core
+ * @brief Freeze the ring after a number of further records
+ *
+ * Called when something worth looking at happens. The ring then holds
+ * TRACE_RING_SIZE - post records from before the trigger and post from
+ * after. Ignored while a trigger is already pending or has fired.
+ *
+ * @param post Records to keep recording, at most TRACE_RING_SIZE
+ */
+void trace_trigger(uint32_t post);
+
+/**
+ * @ingroup kernel_core
+ * @brief Read the trace statistics
+ * @param stats Receives a snapshot
+ */
+void trace_get_stats(TraceStats *stats);
+
+/**
+ * @ingroup kernel_core
+ * @brief Write the ring to a sink
+ *
+ * Recording pauses during the dump so the records being read are not
+ * overwritten, and resumes afterwards unless a trigger froze the ring.
+ * The dump is a TraceDumpHeader, the names, the records oldest first and
+ * a trailer of TRACE_DUMP_END and the 32-bit sum of every byte before it.
+ *
+ * @param write Sink, called several times
+ * @param arg Passed to the sink
+ * @return Bytes written, 0 if the sink failed
+ */
+size_t trace_dump(TraceWriteFn write, void *arg);
+
+#if defined(__arm__) && defined(USE_FREERTOS)
+/**
+ * @ingroup kernel_core
+ * @brief Dump to a file on the SD card
+ * @param path File to create or replace
+ * @return true if the whole dump was written
+ */
+bool trace_save(const char *path);
+
+/**
+ * @ingroup kernel_core
+ * @brief Dump over the debug UART, when the board has one
+ * @return true if the whole dump was sent
+ */
+bool trace_send_uart(void);
+#endif
+
+#if defined(TRACE_ENABLED)
+/** @ingroup kernel_core
+ *  @brief Instant event */
+#define TRACE_EVENT(id, arg0, arg1) trace_record((uint16_t)(id), (uint32_t)(arg0), (uint32_t)(arg1))
+/** @ingroup kernel_core
+ *  @brief Start of a span, closed by TRACE_END() with the same id */
+#define TRACE_BEGIN(id, arg0, arg1) trace_record((uint16_t)((id) | TRACE_FLAG_BEGIN), (uint32_t)(arg0), (uint32_t)(arg1))
+/** @ingroup kernel_core
+ *  @brief End of a span */
+#define TRACE_END(id, arg0, arg1) trace_record((uint16_t)((id) | TRACE_FLAG_END), (uint32_t)(arg0), (uint32_t)(arg1))
+#else
+#define TRACE_EVENT(id, arg0, arg1) ((void)0)
+#define TRACE_BEGIN(id, arg0, arg1) ((void)0)
+#define TRACE_END(id, arg0, arg1) ((void)0)
+#endif
+
+#if defined(TRACE_ENABLED) && defined(__arm__)
+/** @ingroup kernel_core
+ *  @brief Interrupt handler entry, records the active exception number */
+#define TRACE_ISR_ENTER() TRACE_BEGIN(TRACE_ISR, __get_IPSR(), 0)
+/** @ingroup kernel_core
+ *  @brief Interrupt handler exit */
+#define TRACE_ISR_EXIT() TRACE_END(TRACE_ISR, __get_IPSR(), 0)
+#else
+#define TRACE_ISR_ENTER() ((void)0)
+#define TRACE_ISR_EXIT() ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+/**
+ * @file trace_freertos.h
+ * @brief FreeRTOS trace hooks that feed the trace ring
+ * @ingroup kernel_core
+ *
+ * Included from FreeRTOSConfig.h when TRACE_ENABLED is defined, by the
+ * firmware and by the host simulation alike. The hooks expand inside
+ * tasks.c and queue.c, where the TCB and queue fields are visible.
+ * Semaphores are queues, so their gives and takes show up as sends and
+ * receives. Queue addresses are truncated to 32 bits on a 64-bit host,
+ * which still tells the queues of one run apart.
+ */
+
+#ifndef TRACE_FREERTOS_H
+#define TRACE_FREERTOS_H
+
+#include <stdint.h>
+#include "trace.h"
+
+#define traceTASK_CREATE(pxNewTCB) \
+    trace_name(TRACE_NAME_TASK, (pxNewTCB)->uxTCBNumber, (pxNewTCB)->pcTaskName)
+#define traceTASK_SWITCHED_IN() \
+    trace_task_switch(pxCurrentTCB->uxTCBNumber, pxCurrentTCB->uxPriority)
+#define traceQUEUE_REGISTRY_ADD(xQueue, pcQueueName) \
+    trace_name(TRACE_NAME_QUEUE, (uint32_t)(uintptr_t)(xQueue), (pcQueueName))
+#define TRACE_QUEUE_EVENT(id, pxQueue) \
+    trace_record((id), (uint32_t)(uintptr_t)(pxQueue), (pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_SEND(pxQueue) TRACE_QUEUE_EVENT(TRACE_QUEUE_SEND, pxQueue)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue) TRACE_QUEUE_EVENT(TRACE_QUEUE_SEND, pxQueue)
+#define traceQUEUE_SEND_FAILED(pxQueue) TRACE_QUEUE_EVENT(TRACE_QUEUE_SEND_FAILED, pxQueue)
+#define traceQUEUE_SEND_FROM_ISR_FAILED(pxQueue) TRACE_QUEUE_EVENT(TRACE_QUEUE_SEND_FAILED, pxQueue)
+#define traceQUEUE_RECEIVE(pxQueue) TRACE_QUEUE_EVENT(TRACE_QUEUE_RECEIVE, pxQueue)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) TRACE_QUEUE_EVENT(TRACE_QUEUE_RECEIVE, pxQueue)
+#define traceQUEUE_RECEIVE_FAILED(pxQueue) TRACE_QUEUE_EVENT(TRACE_QUEUE_RECEIVE_FAILED, pxQueue)
+#define traceQUEUE_RECEIVE_FROM_ISR_FAILED(pxQueue) TRACE_QUEUE_EVENT(TRACE_QUEUE_RECEIVE_FAILED, pxQueue)
+
+#endif
@@ -0,0 +1,223 @@
+/**
+ * @file virtual_list.h
+ * @brief Virtualised scrolling list component
+ * @ingroup ui_components
+ *
+ * Scrollable list backed by a data-source callback instead of an in-memory
+ * array. Only the visible rows plus a small prefetch window above and below
+ * are cached, in a fixed ring of slots indexed by row number, so moving the
+ * selection by one row costs at most one fetch regardless of list length.
+ *
+ * Sources that cannot answer immediately (e.g. a B+ tree on SD serviced by
+ * another task) return false from fetch and later hand the row over with
+ * vlist_deliver(); the row is drawn as a placeholder until then. A row still
+ * pending VLIST_RETRY_MS after its fetch (timed on the UI timer wheel) is
+ * fetched again when it is next scrolled into the window or drawn, or by
+ * vlist_retry_pending(), so a delivery the source lost does not leave the
+ * placeholder up for good.
+ */
+
+#ifndef VIRTUAL_LIST_H
+#define VIRTUAL_LIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tile.h"
+
+/** @ingroup ui_components
+ *  @brief Number of cached row slots (visible + 2 * prefetch must fit) */
+#define VLIST_MAX_SLOTS 16
+
+/** @ingroup ui_components
+ *  @brief Maximum cached text length per row, including terminator */
+#define VLIST_ROW_LEN 32
+
+/** @ingroup ui_components
+ *  @brief Time a pending row waits for vlist_deliver() before it is fetched again (ms) */
+#define VLIST_RETRY_MS 2000
+
+/**
+ * @brief Data source for a virtual list
+ * @ingroup ui_components
+ */
+typedef struct
+{
+    int (*count)(void *ctx); /**< Total number of rows */
+    /**
+     * Fetch row text. Return true if @p out was filled, false if the row will
+     * be delivered later through vlist_deliver().
+     */
+    bool (*fetch)(void *ctx, int index, char *out, int out_len);
+    void *ctx; /**< Source-specific context */
+} VListSource;
+
+/**
+ * @brief Row drawing callback
+ * @ingroup ui_components
+ * @param tile_y First tile row of the list row
+ * @param selected Non-zero if this row is selected
+ * @param text Row text, "" for rows past the end of the list
+ */
+typedef void (*VListDrawRow)(int tile_y, int selected, const char *text);
+
+/**
+ * @brief Row slot states
+ * @ingroup ui_components
+ */
+typedef enum
+{
+    VLIST_SLOT_EMPTY,   /**< Slot holds no row */
+    VLIST_SLOT_PENDING, /**< Fetch issued, waiting for vlist_deliver() */
+    VLIST_SLOT_READY    /**< Text is valid */
+} VListSlotState;
+
+/**
+ * @brief Cached row slot
+ * @ingroup ui_components
+ */
+typedef struct
+{
+    int index;                 /**< Row index held in this slot */
+    uint8_t state;             /**< VListSlotState */
+    uint32_t requested;        /**< ui_timer_now() when the fetch was issued */
+    char text[VLIST_ROW_LEN];  /**< Row text */
+} VListSlot;
+
+/**
+ * @brief Virtual list state
+ * @ingroup ui_components
+ */
+typedef struct
+{
+    VListSource source;                /**< Data source */
+    VListDrawRow draw_row;             /**< Row renderer */
+    int first_tile_row;                /**< Tile row where the list starts */
+    int row_tiles;                     /**< Tile rows per list row */
+    int visible;                       /**< Number of visible rows */
+    int prefetch;                      /**< Rows cached beyond each edge */
+    int count;                         /**< Cached row count */
+    int offset;                        /**< Index of the top visible row */
+    int selected;                      /**< Index of the selected row */
+    uint32_t fetches;                  /**< Total fetch calls issued */
+    VListSlot slots[VLIST_MAX_SLOTS];  /**< Row cache, slot = index % VLIST_MAX_SLOTS */
+} VirtualList;
+
+/**
+ * @brief Static array data source context
+ * @ingroup ui_components
+ */
+typedef struct
+{
+    const char *const *items; /**< Row strings */
+    int count;                /**< Number of rows */
+} VListArray;
+
+/**
+ * @ingroup ui_components
+ * @brief Initialise a virtual list and prefetch its first window
+ * @param list List to initialise
+ * @param source Data source (copied)
+ * @param draw_row Row renderer
+ * @param first_tile_row Tile row where the first list row is drawn
+ * @param row_tiles Tile rows per list row
+ * @param visible Number of visible rows
+ * @param prefetch Rows to cache above and below the visible window
+ * @return false if the window does not fit in VLIST_MAX_SLOTS
+ */
+bool vlist_init(VirtualList *list, const VListSource *source, VListDrawRow draw_row,
+                int first_tile_row, int row_tiles, int visible, int prefetch);
+
+/**
+ * @ingroup ui_components
+ * @brief Move the selection by a number of rows
+ * @param list List to scroll
+ * @param delta Rows to move (negative is up)
+ * @return true if the selection changed
+ *
+ * Scrolls the window by the minimum needed to keep the selection visible
+ * and marks only the affected rows dirty.
+ */
+bool vlist_move(VirtualList *list, int delta);
+
+/**
+ * @ingroup ui_components
+ * @brief Select a row by index
+ * @param list List to scroll
+ * @param index Row to select (clamped)
+ * @return true if the selection changed
+ */
+bool vlist_select(VirtualList *list, int index);
+
+/**
+ * @ingroup ui_components
+ * @brief Draw the list row covering a tile row
+ * @param list List to draw
+ * @param ty Tile row
+ * @return true if the tile belongs to the list and was handled
+ *
+ * Intended to be called from a page's draw_tile. Draws the whole row once
+ * and marks all of its tiles clean.
+ */
+bool vlist_draw_tile(VirtualList *list, int ty);
+
+/**
+ * @ingroup ui_components
+ * @brief Provide a row that was fetched asynchronously
+ * @param list List that issued the fetch
+ * @param index Row index
+ * @param text Row text
+ *
+ * Ignored if the row has left the cached window in the meantime.
+ */
+void vlist_deliver(VirtualList *list, int index, const char *text);
+
+/**
+ * @ingroup ui_components
+ * @brief Fetch again every row in the window whose delivery is overdue
+ * @param list List to check
+ * @return Number of rows fetched again
+ *
+ * For pages with an asynchronous source, called from a periodic UI timer so
+ * a lost delivery is requested again without waiting for the next scroll.
+ */
+int vlist_retry_pending(VirtualList *list);
+
+/**
+ * @ingroup ui_components
+ * @brief Re-read the row count and drop all cached rows
+ * @param list List to refresh
+ */
+void vlist_refresh(VirtualList *list);
+
+/**
+ * @ingroup ui_components
+ * @brief Re-read the row count, keeping cached rows that still exist
+ * @param list List to update
+ * @return true if the count changed
+ *
+ * For sources whose count grows as rows are fetched. Only rows that
+ * appeared or disappeared are marked dirty.
+ */
+bool vlist_update_count(VirtualList *list);
+
+/**
+ * @ingroup ui_components
+ * @brief Get the cached text of the selected row
+ * @param list List to query
+ * @return Row text, or NULL if the row is not loaded yet
+ */
+const char *vlist_selected_text(const VirtualList *list);
+
+/**
+ * @ingroup ui_components
+ * @brief VListSource count callback for a VListArray context
+ */
+int vlist_array_count(void *ctx);
+
+/**
+ * @ingroup ui_components
+ * @brief VListSource fetch callback for a VListArray context
+ */
+bool vlist_array_fetch(void *ctx, int index, char *out, int out_len);
+
+#endif
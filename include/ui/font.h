@@ -0,0 +1,199 @@
+/**
+ * @file font.h
+ * @brief Unicode bitmap font loaded from the SD card
+ * @ingroup ui_screen
+ *
+ * Renders UTF-8 text with a bitmap font produced on the host by
+ * tools/font_build.py from a BDF (or TTF) font. Glyphs are grouped in pages
+ * of 16 consecutive code points. Only a small directory is held in RAM;
+ * pages are read from the card when first needed and kept in a fixed-size
+ * LRU cache, so a message in any script costs a handful of reads the first
+ * time it is drawn and none when it is redrawn.
+ *
+ * A page lookup reads at most one block of the page table (cached) and the
+ * page itself. Pages the font does not have are cached as empty so missing
+ * glyphs do not go back to the card either.
+ *
+ * Each glyph is drawn as one RGB565 window through the context's blit
+ * function, which defaults to display_draw_rgb565() on the target.
+ *
+ * File layout (little endian):
+ * - Header: "UFN1", u8 height, u8 ascent, u8 max_advance, u8 reserved,
+ *   u32 page_count, u32 table_offset, u32 glyph_count
+ * - Block keys: u32 first page number of each FONT_TABLE_BLOCK table entries
+ * - Page table, sorted by page: u32 page, u32 offset, u16 size, u16 mask
+ *   (bit i set if code point page * 16 + i has a glyph)
+ * - Page data, per present glyph in code point order: u8 advance, then
+ *   height rows of 1 byte (advance <= 8) or 2 bytes, leftmost pixel in the
+ *   top bit of the first byte
+ */
+
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @ingroup ui_screen
+ *  @brief Widest glyph supported */
+#define FONT_MAX_WIDTH 16
+
+/** @ingroup ui_screen
+ *  @brief Tallest font supported */
+#define FONT_MAX_HEIGHT 16
+
+/** @ingroup ui_screen
+ *  @brief Code points per page */
+#define FONT_PAGE_GLYPHS 16
+
+#ifndef FONT_CACHE_PAGES
+/** @ingroup ui_screen
+ *  @brief Decoded pages kept in RAM */
+#define FONT_CACHE_PAGES 16
+#endif
+
+/** @ingroup ui_screen
+ *  @brief Page table entries per directory block */
+#define FONT_TABLE_BLOCK 32
+
+/** @ingroup ui_screen
+ *  @brief Directory blocks held in RAM, limits a font to 8192 pages */
+#define FONT_TABLE_BLOCKS 256
+
+/** @ingroup ui_screen
+ *  @brief Largest page in the file: an advance byte and two bytes per row for each glyph */
+#define FONT_PAGE_DATA_MAX (FONT_PAGE_GLYPHS * (1 + 2 * FONT_MAX_HEIGHT))
+
+/** @ingroup ui_screen
+ *  @brief Drawn for invalid UTF-8 */
+#define FONT_REPLACEMENT 0xFFFD
+
+/** @ingroup ui_screen
+ *  @brief Page number meaning "unused cache line" */
+#define FONT_NO_PAGE 0xFFFFFFFFUL
+
+/**
+ * @brief Glyph bitmap
+ * @ingroup ui_screen
+ */
+typedef struct
+{
+    uint8_t advance;                /**< Width in pixels, 0 if the font has no glyph */
+    uint16_t rows[FONT_MAX_HEIGHT]; /**< One row per line, leftmost pixel in bit 15 */
+} FontGlyph;
+
+/**
+ * @brief Decoded page in the cache
+ * @ingroup ui_screen
+ */
+typedef struct
+{
+    uint32_t page;                      /**< Page number, FONT_NO_PAGE if unused */
+    uint32_t last_used;                 /**< Use stamp for LRU replacement */
+    FontGlyph glyphs[FONT_PAGE_GLYPHS]; /**< Glyphs, advance 0 where missing */
+} FontPage;
+
+/**
+ * @brief Font context
+ * @ingroup ui_screen
+ */
+typedef struct
+{
+    void *file;                                        /**< Open font file */
+    uint8_t height;                                    /**< Line height in pixels */
+    uint8_t ascent;                                    /**< Pixels above the baseline */
+    uint8_t max_advance;                               /**< Widest glyph */
+    uint32_t page_count;                               /**< Page table entries */
+    uint32_t table_offset;                             /**< File offset of the page table */
+    uint32_t block_keys[FONT_TABLE_BLOCKS];            /**< First page of each table block */
+    uint16_t block_count;                              /**< Valid block keys */
+    int32_t table_block;                               /**< Table block held in table[], -1 if none */
+    uint8_t table[FONT_TABLE_BLOCK * 12];              /**< Last table block read */
+    FontPage cache[FONT_CACHE_PAGES];                  /**< Page cache */
+    uint8_t page_data[FONT_PAGE_DATA_MAX];             /**< Page being decoded, kept off the caller's stack */
+    uint32_t clock;                                    /**< Use counter for the cache */
+    uint16_t pixels[FONT_MAX_WIDTH * FONT_MAX_HEIGHT]; /**< Glyph being drawn */
+    void (*blit)(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                 const uint16_t *pixels); /**< Sends a glyph to the panel */
+    uint32_t cache_hits;                  /**< Glyph lookups served from the cache */
+    uint32_t cache_misses;                /**< Glyph lookups that loaded a page */
+    uint32_t evictions;                   /**< Cached pages replaced */
+    uint32_t reads;                       /**< File reads issued */
+} FontContext;
+
+/**
+ * @ingroup ui_screen
+ * @brief Open a font file
+ * @param ctx Context to initialise
+ * @param path Font path on the SD card (or host filesystem)
+ * @return true on success
+ */
+bool font_open(FontContext *ctx, const char *path);
+
+/**
+ * @ingroup ui_screen
+ * @brief Close the font file
+ * @param ctx Context to close
+ */
+void font_close(FontContext *ctx);
+
+/**
+ * @ingroup ui_screen
+ * @brief Decode the next code point of a UTF-8 string
+ * @param s String pointer, advanced past the sequence
+ * @return Code point, 0 at the end of the string, FONT_REPLACEMENT for a
+ *         malformed sequence (one byte is consumed)
+ */
+uint32_t font_utf8_next(const char **s);
+
+/**
+ * @ingroup ui_screen
+ * @brief Look up a glyph, loading its page if needed
+ * @param ctx Font context
+ * @param cp Code point
+ * @return Glyph, or NULL if the font has none. Valid until the next lookup.
+ */
+const FontGlyph *font_glyph(FontContext *ctx, uint32_t cp);
+
+/**
+ * @ingroup ui_screen
+ * @brief Width of a UTF-8 string in pixels
+ * @param ctx Font context
+ * @param text UTF-8 string
+ * @return Sum of the glyph advances
+ */
+uint16_t font_text_width(FontContext *ctx, const char *text);
+
+/**
+ * @ingroup ui_screen
+ * @brief Draw a UTF-8 string on one line
+ * @param ctx Font context
+ * @param x Left edge
+ * @param y Top edge
+ * @param text UTF-8 string
+ * @param colour Text colour in RGB565
+ * @param bg_colour Background colour in RGB565
+ * @return X coordinate after the last glyph
+ */
+int font_draw_utf8(FontContext *ctx, int x, int y, const char *text, uint16_t colour, uint16_t bg_colour);
+
+/**
+ * @ingroup ui_screen
+ * @brief Draw a UTF-8 string wrapped at glyph boundaries
+ * @param ctx Font context
+ * @param x Left edge
+ * @param y Top edge of the first line
+ * @param width Line width in pixels
+ * @param max_lines Lines available, drawing stops after the last
+ * @param text UTF-8 string
+ * @param colour Text colour in RGB565
+ * @param bg_colour Background colour in RGB565
+ * @return Number of lines used
+ *
+ * Wraps per glyph rather than per word so unspaced scripts such as CJK
+ * break correctly. Spaces at the start of a line are skipped.
+ */
+int font_draw_wrapped(FontContext *ctx, int x, int y, int width, int max_lines, const char *text,
+                      uint16_t colour, uint16_t bg_colour);
+
+#endif /* FONT_H */
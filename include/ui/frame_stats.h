@@ -0,0 +1,142 @@
+/**
+ * @file frame_stats.h
+ * @brief Per-page frame time and redraw cost statistics
+ * @ingroup ui_screen
+ *
+ * Records, for every page type, how long each frame took to flush, how many
+ * tiles were drawn and how many bytes were pushed to the panel. Values are
+ * kept in fixed log2 histograms so recording is a handful of integer ops and
+ * no memory is allocated. The table can be shown on the debug page or dumped
+ * as text from the host simulator for CI budget checks.
+ */
+
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "screen.h"
+
+/** @ingroup ui_screen
+ *  @brief Number of log2 buckets per histogram (bucket n holds [2^n, 2^(n+1))) */
+#define FRAME_STATS_BUCKETS 20
+
+/** @ingroup ui_screen
+ *  @brief Maximum number of distinct page types tracked */
+#define FRAME_STATS_MAX_PAGES 16
+
+/** @ingroup ui_screen
+ *  @brief Default per-frame budget in microseconds (one 60 Hz frame) */
+#define FRAME_STATS_BUDGET_US 16000
+
+/**
+ * @brief Fixed log2 histogram
+ * @ingroup ui_screen
+ */
+typedef struct
+{
+    uint32_t buckets[FRAME_STATS_BUCKETS]; /**< Sample counts per log2 bucket */
+    uint32_t max;                          /**< Largest sample seen */
+    uint64_t sum;                          /**< Sum of all samples (for mean) */
+} FrameHistogram;
+
+/**
+ * @brief Statistics for one page type
+ * @ingroup ui_screen
+ */
+typedef struct
+{
+    const void *key;          /**< Page identity (its draw_tile function) */
+    const char *name;         /**< Page name for reports */
+    uint32_t frames;          /**< Frames that drew at least one tile or byte */
+    uint32_t over_budget;     /**< Frames slower than FRAME_STATS_BUDGET_US */
+    FrameHistogram time_us;   /**< Frame flush time in microseconds */
+    FrameHistogram tiles;     /**< Tiles drawn per frame */
+    FrameHistogram bytes;     /**< Bytes sent to the panel per frame */
+} FramePageStats;
+
+/**
+ * @ingroup ui_screen
+ * @brief Clear all recorded statistics
+ */
+void frame_stats_reset(void);
+
+/**
+ * @ingroup ui_screen
+ * @brief Current timestamp for frame_stats_elapsed_us()
+ * @return Free-running counter that wraps at 2^32
+ *
+ * Counts DWT cycles on target and microseconds of a monotonic clock on the
+ * host. Only differences are meaningful.
+ */
+uint32_t frame_stats_now(void);
+
+/**
+ * @ingroup ui_screen
+ * @brief Microseconds since a timestamp
+ * @param start Value returned by frame_stats_now()
+ * @return Elapsed time, correct across one counter wrap
+ */
+uint32_t frame_stats_elapsed_us(uint32_t start);
+
+/**
+ * @ingroup ui_screen
+ * @brief Record one flushed frame for a page
+ * @param page Page that was drawn
+ * @param time_us Time spent flushing in microseconds
+ * @param tiles Number of tiles drawn
+ * @param bytes Number of bytes sent to the panel
+ *
+ * Frames with no tiles and no bytes are idle ticks and are not recorded.
+ */
+void frame_stats_record(const Page *page, uint32_t time_us, uint32_t tiles, uint32_t bytes);
+
+/**
+ * @ingroup ui_screen
+ * @brief Number of page types with recorded statistics
+ * @return Count of valid entries
+ */
+int frame_stats_count(void);
+
+/**
+ * @ingroup ui_screen
+ * @brief Get statistics for a page type by index
+ * @param index Entry index (0 to frame_stats_count() - 1)
+ * @return Pointer to the entry, or NULL if out of range
+ */
+const FramePageStats *frame_stats_get(int index);
+
+/**
+ * @ingroup ui_screen
+ * @brief Find statistics by page name
+ * @param name Page name as set in Page::name
+ * @return Pointer to the entry, or NULL if the page has not been drawn
+ */
+const FramePageStats *frame_stats_find(const char *name);
+
+/**
+ * @ingroup ui_screen
+ * @brief Estimate a percentile from a histogram
+ * @param hist Histogram to query
+ * @param percent Percentile (0-100)
+ * @return Upper bound of the bucket containing the percentile
+ */
+uint32_t frame_stats_percentile(const FrameHistogram *hist, uint8_t percent);
+
+/**
+ * @ingroup ui_screen
+ * @brief Mean value of a histogram
+ * @param hist Histogram to query
+ * @param samples Number of samples recorded into it
+ * @return Integer mean, 0 if empty
+ */
+uint32_t frame_stats_mean(const FrameHistogram *hist, uint32_t samples);
+
+/**
+ * @ingroup ui_screen
+ * @brief Print the statistics table
+ * @param print printf-compatible output function (printf on host, UART on target)
+ */
+void frame_stats_dump(int (*print)(const char *fmt, ...));
+
+#endif /* FRAME_STATS_H */
@@ -0,0 +1,29 @@
+/**
+ * @file game_sprites.h
+ * @brief Packed sprite sheet
+ * @ingroup ui_screen
+ *
+ * Generated by tools/sprite_pack.py, do not edit. Regenerate from the PNGs
+ * after changing them.
+ */
+
+#ifndef GAME_SPRITES_H
+#define GAME_SPRITES_H
+
+#include "sprite.h"
+
+typedef enum
+{
+    GAME_SPRITES_CURSOR,
+    GAME_SPRITES_FLAG,
+    GAME_SPRITES_MINE,
+    GAME_SPRITES_SNAKE_HEAD_DOWN,
+    GAME_SPRITES_SNAKE_HEAD_LEFT,
+    GAME_SPRITES_SNAKE_HEAD_RIGHT,
+    GAME_SPRITES_SNAKE_HEAD_UP,
+    GAME_SPRITES_COUNT,
+} GameSpritesId;
+
+extern const Sprite game_sprites[GAME_SPRITES_COUNT];
+
+#endif
@@ -45,4 +45,16 @@ typedef enum
     INPUT_NONE         /**< No input event */
 } input_event_t;
 
+/** @ingroup ui_input
+ *  @brief Flag or-ed into an event delivered to a page for a long press */
+#define INPUT_FLAG_LONG_PRESS 0x100
+
+/** @ingroup ui_input
+ *  @brief Flag or-ed into an event delivered to a page for a key release */
+#define INPUT_FLAG_RELEASE 0x200
+
+/** @ingroup ui_input
+ *  @brief Strip event flags, leaving the input_event_t */
+#define INPUT_KEY(ev) ((ev) & 0xFF)
+
 #endif
@@ -0,0 +1,187 @@
+/**
+ * @file input_pipeline.h
+ * @brief Key event generation and coalescing input queue
+ * @ingroup ui_input
+ *
+ * Turns the debounced keypad state into press, release, repeat and
+ * long-press events, and buffers them for the display task in a small queue
+ * that merges repeated navigation events when the consumer falls behind
+ * (five queued DOWN presses become one "DOWN x5" entry). The queue keeps
+ * counters for coalesced and dropped events so backlog can be diagnosed.
+ *
+ * The generator is owned by the input task. The queue is a single instance
+ * shared by the input task (producer) and the display task (consumer).
+ */
+
+#ifndef INPUT_PIPELINE_H
+#define INPUT_PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "input.h"
+
+/** @ingroup ui_input
+ *  @brief Hold time before the first repeat in milliseconds */
+#define INPUT_REPEAT_DELAY_MS 400
+
+/** @ingroup ui_input
+ *  @brief Interval between repeats in milliseconds */
+#define INPUT_REPEAT_RATE_MS 80
+
+/** @ingroup ui_input
+ *  @brief Hold time for a long press in milliseconds */
+#define INPUT_LONG_PRESS_MS 800
+
+/** @ingroup ui_input
+ *  @brief Maximum number of keys tracked by the generator */
+#define INPUT_MAX_KEYS 32
+
+/** @ingroup ui_input
+ *  @brief Input queue capacity in events */
+#define INPUT_QUEUE_SIZE 16
+
+/** @ingroup ui_input
+ *  @brief Build a key mask bit for an input event */
+#define INPUT_KEY_BIT(ev) (1UL << (ev))
+
+/** @ingroup ui_input
+ *  @brief Keys that auto-repeat while held by default */
+#define INPUT_DEFAULT_REPEAT_MASK                                             \
+    (INPUT_KEY_BIT(INPUT_DPAD_UP) | INPUT_KEY_BIT(INPUT_DPAD_DOWN) |          \
+     INPUT_KEY_BIT(INPUT_DPAD_LEFT) | INPUT_KEY_BIT(INPUT_DPAD_RIGHT) |       \
+     INPUT_KEY_BIT(INPUT_VOLUME_UP) | INPUT_KEY_BIT(INPUT_VOLUME_DOWN))
+
+/** @ingroup ui_input
+ *  @brief Keys whose queued presses may be merged */
+#define INPUT_DEFAULT_COALESCE_MASK                                     \
+    (INPUT_KEY_BIT(INPUT_DPAD_UP) | INPUT_KEY_BIT(INPUT_DPAD_DOWN) |    \
+     INPUT_KEY_BIT(INPUT_DPAD_LEFT) | INPUT_KEY_BIT(INPUT_DPAD_RIGHT))
+
+/**
+ * @brief Key event actions
+ * @ingroup ui_input
+ */
+typedef enum
+{
+    KEY_ACTION_PRESS,      /**< Key went down */
+    KEY_ACTION_RELEASE,    /**< Key went up */
+    KEY_ACTION_REPEAT,     /**< Key held past the repeat delay */
+    KEY_ACTION_LONG_PRESS  /**< Key held past the long-press time (sent once) */
+} KeyAction;
+
+/**
+ * @brief Key event
+ * @ingroup ui_input
+ */
+typedef struct
+{
+    uint8_t key;    /**< input_event_t of the key */
+    uint8_t action; /**< KeyAction */
+    uint16_t count; /**< Number of merged press/repeat events (1 if not merged) */
+} KeyEvent;
+
+/**
+ * @brief Key event generator configuration
+ * @ingroup ui_input
+ */
+typedef struct
+{
+    uint16_t repeat_delay_ms; /**< Hold time before the first repeat */
+    uint16_t repeat_rate_ms;  /**< Interval between repeats */
+    uint16_t long_press_ms;   /**< Hold time for a long press, 0 to disable */
+    uint32_t repeat_mask;     /**< INPUT_KEY_BIT() set of repeating keys */
+} KeyEventConfig;
+
+/**
+ * @brief Key event generator state
+ * @ingroup ui_input
+ */
+typedef struct
+{
+    KeyEventConfig config;                  /**< Timing configuration */
+    input_event_t keymap[INPUT_MAX_KEYS];   /**< Keypad bit index to input event */
+    uint8_t key_count;                      /**< Number of valid keymap entries */
+    uint32_t held;                          /**< Held state from the previous update */
+    uint32_t long_sent;                     /**< Keys whose long press was reported */
+    uint32_t down_since[INPUT_MAX_KEYS];    /**< Press timestamp per key */
+    uint32_t next_repeat[INPUT_MAX_KEYS];   /**< Next repeat timestamp per key */
+} KeyEventGen;
+
+/**
+ * @brief Input queue statistics
+ * @ingroup ui_input
+ */
+typedef struct
+{
+    uint32_t pushed;     /**< Events offered to the queue */
+    uint32_t coalesced;  /**< Events merged into an existing entry */
+    uint32_t dropped;    /**< Events lost because the queue was full */
+    uint16_t high_water; /**< Maximum queued entries seen */
+} InputQueueStats;
+
+/**
+ * @ingroup ui_input
+ * @brief Fill a configuration with the default timings and masks
+ * @param config Configuration to fill
+ */
+void key_events_default_config(KeyEventConfig *config);
+
+/**
+ * @ingroup ui_input
+ * @brief Initialise a key event generator
+ * @param gen Generator to initialise
+ * @param config Timing configuration (copied), NULL for defaults
+ * @param keymap Input event for each keypad state bit
+ * @param key_count Number of entries in keymap (at most INPUT_MAX_KEYS)
+ */
+void key_events_init(KeyEventGen *gen, const KeyEventConfig *config,
+                     const input_event_t *keymap, uint8_t key_count);
+
+/**
+ * @ingroup ui_input
+ * @brief Generate events from the current held state
+ * @param gen Generator
+ * @param held Debounced state bitmap, bit n set while key n is down
+ * @param now_ms Current time in milliseconds
+ * @param out Output event array
+ * @param max_out Capacity of out
+ * @return Number of events written
+ */
+int key_events_update(KeyEventGen *gen, uint32_t held, uint32_t now_ms,
+                      KeyEvent *out, int max_out);
+
+/**
+ * @ingroup ui_input
+ * @brief Empty the input queue and clear its statistics
+ * @param coalesce_mask INPUT_KEY_BIT() set of keys that may be merged
+ */
+void input_queue_init(uint32_t coalesce_mask);
+
+/**
+ * @ingroup ui_input
+ * @brief Queue an event for the display task
+ * @param event Event to queue
+ * @return false if the event was dropped
+ *
+ * A press or repeat of a coalescing key is merged into the newest queued
+ * entry when that entry is the same key. Releases of coalescing keys are
+ * not queued, so tapping a key repeatedly still merges.
+ */
+bool input_queue_push(const KeyEvent *event);
+
+/**
+ * @ingroup ui_input
+ * @brief Take the oldest queued event
+ * @param event Receives the event
+ * @return true if an event was available
+ */
+bool input_queue_pop(KeyEvent *event);
+
+/**
+ * @ingroup ui_input
+ * @brief Get input queue statistics
+ * @param stats Receives a snapshot of the counters
+ */
+void input_queue_get_stats(InputQueueStats *stats);
+
+#endif /* INPUT_PIPELINE_H */
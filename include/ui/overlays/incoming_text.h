@@ -22,7 +22,8 @@
 /**
  * @brief Callback function type for incoming text actions
  * @ingroup ui_overlays
- * @param action Action taken by the user (INCOMING_TEXT_ACTION_OPEN or INCOMING_TEXT_ACTION_CLOSE)
+ * @param action Action taken by the user (INCOMING_TEXT_ACTION_OPEN or INCOMING_TEXT_ACTION_CLOSE),
+ *               or INCOMING_TEXT_ACTION_DESTROY when the overlay goes away
  * @param user_data User-provided data pointer
  */
 typedef void (*IncomingTextCallback)(int action, void *user_data);
@@ -35,6 +36,10 @@ typedef void (*IncomingTextCallback)(int action, void *user_data);
  *  @brief Action constant for dismissing the notification */
 #define INCOMING_TEXT_ACTION_CLOSE 1
 
+/** @ingroup ui_overlays
+ *  @brief Action sent when the overlay is destroyed, so the owner can free user_data */
+#define INCOMING_TEXT_ACTION_DESTROY 2
+
 /**
  * @ingroup ui_overlays
  * @brief Create an incoming text overlay
@@ -0,0 +1,8 @@
+#ifndef BENCHP_H
+#define BENCHP_H
+
+#include "screen.h"
+
+Page* bench_page_create();
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef BOOTP_H
+#define BOOTP_H
+
+#include "screen.h"
+
+Page* boot_page_create();
+
+#endif
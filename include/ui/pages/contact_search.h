@@ -0,0 +1,37 @@
+/**
+ * @file contact_search.h
+ * @brief As-you-type contact search page
+ * @ingroup ui_pages
+ *
+ * Narrows the contact list with every multitap keypress. The query row sits
+ * above an eight-row result list fed lazily by the contacts task, which
+ * keeps a ContactSearch cursor for the page, so each keystroke costs the
+ * task a short forward scan and backspace costs it no search I/O. Rows
+ * arrive asynchronously and are drawn as placeholders until then.
+ */
+
+#ifndef CONTACT_SEARCH_PAGE_H
+#define CONTACT_SEARCH_PAGE_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "screen.h"
+#include "tile.h"
+#include "input.h"
+#include "theme.h"
+#include "multitap.h"
+#include "contacts_task.h"
+#include "contact_row.h"
+#include "bottom_bar.h"
+#include "virtual_list.h"
+#include "contact_details.h"
+
+/**
+ * @ingroup ui_pages
+ * @brief Create the contact search page
+ * @return Pointer to the contact search page structure
+ */
+Page *contact_search_page_create(void);
+
+#endif
@@ -5,7 +5,7 @@
  *
  * Provides the contacts list interface for browsing and managing contact
  * records. Displays a scrollable list of contacts with search and selection
- * capabilities.
+ * capabilities. The left soft key opens the as-you-type search page.
  */
 
 #ifndef CONTACTS_H
@@ -18,9 +18,12 @@
 #include "tile.h"
 #include "cursor.h"
 #include "input.h"
-#include "contacts_bptree.h"
+#include "contacts_task.h"
 #include "contact_row.h"
+#include "virtual_list.h"
 #include "contact_details.h"
+#include "contact_search.h"
+#include "bottom_bar.h"
 
 /**
  * @ingroup ui_pages
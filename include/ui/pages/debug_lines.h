@@ -0,0 +1,77 @@
+/**
+ * @file debug_lines.h
+ * @brief Line-at-a-time text output for the debug pages
+ * @ingroup ui_pages
+ *
+ * Debug pages that list figures print them as rows of size 1 text from the
+ * top of the panel down. A DebugLines writer keeps the
+ * position of the next row; each call formats one row, clears it and draws
+ * it. Rows past the bottom of the panel are dropped.
+ */
+
+#ifndef DEBUG_LINES_H
+#define DEBUG_LINES_H
+
+#include <stdint.h>
+#include "tile.h"
+
+/** @ingroup ui_pages
+ *  @brief Height of one row in pixels */
+#define DEBUG_LINE_HEIGHT 10
+
+/** @ingroup ui_pages
+ *  @brief Rows that fit on the panel */
+#define DEBUG_MAX_LINES ((TILE_HEIGHT * TILE_ROWS) / DEBUG_LINE_HEIGHT)
+
+/** @ingroup ui_pages
+ *  @brief Formatted row buffer, including the terminator
+ *
+ * Holds the widest row any debug page prints with every number at its
+ * largest. The panel shows the first 40 characters.
+ */
+#define DEBUG_LINE_CHARS 80
+
+/**
+ * @brief Position of the next row
+ * @ingroup ui_pages
+ */
+typedef struct
+{
+    int px, py; /**< Top left of the panel */
+    int line;   /**< Next row */
+} DebugLines;
+
+/**
+ * @ingroup ui_pages
+ * @brief Start writing at the top of the panel
+ * @param w Writer to reset
+ */
+void debug_lines_begin(DebugLines *w);
+
+/**
+ * @ingroup ui_pages
+ * @brief Format and draw the next row
+ * @param w Writer
+ * @param colour Text colour
+ * @param fmt printf format, truncated to DEBUG_LINE_CHARS - 1 characters
+ */
+void debug_lines_put(DebugLines *w, uint16_t colour, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @ingroup ui_pages
+ * @brief Clear the next row and move past it
+ * @param w Writer
+ */
+void debug_lines_blank(DebugLines *w);
+
+/**
+ * @ingroup ui_pages
+ * @brief Clear every row below the last one written
+ * @param w Writer
+ *
+ * Removes what a longer previous refresh drew further down.
+ */
+void debug_lines_clear_rest(DebugLines *w);
+
+#endif
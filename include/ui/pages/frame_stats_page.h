@@ -0,0 +1,8 @@
+#ifndef FRAMESTATSP_H
+#define FRAMESTATSP_H
+
+#include "screen.h"
+
+Page* frame_stats_page_create();
+
+#endif
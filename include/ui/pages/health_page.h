@@ -0,0 +1,8 @@
+#ifndef HEALTHP_H
+#define HEALTHP_H
+
+#include "screen.h"
+
+Page* health_page_create();
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef MEMORYP_H
+#define MEMORYP_H
+
+#include "screen.h"
+
+Page* memory_page_create();
+
+#endif
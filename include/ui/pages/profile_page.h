@@ -0,0 +1,8 @@
+#ifndef PROFILEP_H
+#define PROFILEP_H
+
+#include "screen.h"
+
+Page* profile_page_create();
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef SAMPLERP_H
+#define SAMPLERP_H
+
+#include "screen.h"
+
+Page* sampler_page_create();
+
+#endif
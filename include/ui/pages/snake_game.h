@@ -0,0 +1,151 @@
+/**
+ * @file snake_game.h
+ * @brief Snake game runtime
+ * @ingroup ui_pages
+ *
+ * Display-free game logic for the Snake page. The body is a ring buffer
+ * indexed from the head, so a move writes one new head cell and drops one
+ * tail cell instead of shifting the whole body. An occupancy grid makes
+ * self collision O(1) and apple placement bounded by the board size.
+ *
+ * Every step reports the cells it changed so the page only redraws the
+ * head, the vacated tail and a respawned apple.
+ */
+
+#ifndef SNAKE_GAME_H
+#define SNAKE_GAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tile.h"
+
+#ifndef SNAKE_COLS
+#define SNAKE_COLS TILE_COLS ///< Board width in cells
+#endif
+
+#ifndef SNAKE_ROWS
+#define SNAKE_ROWS TILE_ROWS ///< Board height in cells
+#endif
+
+#define SNAKE_CELLS (SNAKE_COLS * SNAKE_ROWS) ///< Length at which the game is won
+
+#if SNAKE_COLS > 127 || SNAKE_ROWS > 127
+#error "snake cell coordinates are int8_t"
+#endif
+
+/**
+ * @ingroup ui_pages
+ * @brief Direction of travel
+ */
+typedef enum
+{
+    SNAKE_UP,
+    SNAKE_DOWN,
+    SNAKE_LEFT,
+    SNAKE_RIGHT,
+} SnakeDirection;
+
+/**
+ * @ingroup ui_pages
+ * @brief Game outcome
+ */
+typedef enum
+{
+    SNAKE_RUN,
+    SNAKE_OVER,
+    SNAKE_WIN,
+} SnakeStatus;
+
+/**
+ * @ingroup ui_pages
+ * @brief Board cell coordinate
+ */
+typedef struct
+{
+    int8_t x;
+    int8_t y;
+} SnakeCell;
+
+/**
+ * @ingroup ui_pages
+ * @brief Cells changed by a single step
+ */
+typedef struct
+{
+    SnakeCell head;      ///< New head cell
+    SnakeCell tail;      ///< Vacated tail cell, valid when tail_cleared
+    SnakeCell apple;     ///< Respawned apple, valid when apple_moved
+    bool moved;          ///< False when the step ended the game
+    bool tail_cleared;   ///< False when the snake grew
+    bool apple_moved;
+} SnakeStep;
+
+/**
+ * @ingroup ui_pages
+ * @brief Snake game state
+ */
+typedef struct
+{
+    SnakeCell body[SNAKE_CELLS]; ///< Ring buffer, body[head] is the head
+    uint16_t head;
+    uint16_t len;
+    uint8_t occupied[SNAKE_ROWS][SNAKE_COLS];
+    SnakeCell apple;
+    SnakeDirection dir;
+    SnakeStatus status;
+    uint32_t rng;
+} SnakeGame;
+
+/**
+ * @ingroup ui_pages
+ * @brief Start a new game
+ * @param game Game state to reset
+ * @param seed Seed for apple placement, zero is replaced with a fixed seed
+ *
+ * Places a single cell snake in the middle of the board and spawns the
+ * first apple.
+ */
+void snake_game_init(SnakeGame *game, uint32_t seed);
+
+/**
+ * @ingroup ui_pages
+ * @brief Change the direction used by the next step
+ * @param game Game state
+ * @param dir New direction
+ */
+void snake_game_turn(SnakeGame *game, SnakeDirection dir);
+
+/**
+ * @ingroup ui_pages
+ * @brief Advance the snake by one cell
+ * @param game Game state
+ * @param step Optional, receives the cells to redraw
+ * @return Game status after the step
+ *
+ * Wraps at the board edges, grows on the apple and ends the game when the
+ * head runs into the body. Moving into the cell the tail is leaving is
+ * allowed unless the snake is two long, where that is a reversal.
+ * Constant time except when an apple is respawned.
+ */
+SnakeStatus snake_game_step(SnakeGame *game, SnakeStep *step);
+
+/**
+ * @ingroup ui_pages
+ * @brief Check whether a cell holds part of the snake
+ * @param game Game state
+ * @param x Cell column
+ * @param y Cell row
+ * @return true if the snake occupies the cell
+ */
+bool snake_game_occupied(const SnakeGame *game, int x, int y);
+
+/**
+ * @ingroup ui_pages
+ * @brief Get a body cell counted from the head
+ * @param game Game state
+ * @param index 0 for the head up to len - 1 for the tail
+ * @return The cell at that position
+ */
+SnakeCell snake_game_body(const SnakeGame *game, uint16_t index);
+
+#endif
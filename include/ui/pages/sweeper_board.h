@@ -0,0 +1,129 @@
+/**
+ * @file sweeper_board.h
+ * @brief Minesweeper board runtime
+ * @ingroup ui_pages
+ *
+ * Display-free board logic for the Minesweeper page. Opening an empty
+ * region is an iterative flood fill over a FIFO work list stored in the
+ * board, so stack use is constant however large the region is. Each cell
+ * is queued at most once per reveal, which bounds the list at one entry
+ * per cell.
+ *
+ * Cells changed by a reveal or flag toggle have their redraw flag set for
+ * the page to collect.
+ */
+
+#ifndef SWEEPER_BOARD_H
+#define SWEEPER_BOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tile.h"
+
+#ifndef SWEEPER_MAX_COLS
+#define SWEEPER_MAX_COLS TILE_COLS ///< Widest supported board
+#endif
+
+#ifndef SWEEPER_MAX_ROWS
+#define SWEEPER_MAX_ROWS TILE_ROWS ///< Tallest supported board
+#endif
+
+#define SWEEPER_MAX_CELLS (SWEEPER_MAX_COLS * SWEEPER_MAX_ROWS)
+
+#if SWEEPER_MAX_CELLS > 0xFFFF
+#error "sweeper work list indices are 16-bit"
+#endif
+
+#define SWEEPER_MINE 0x0A ///< Cell value of a mine, 0-8 are neighbour counts
+
+/**
+ * @ingroup ui_pages
+ * @brief Game outcome
+ */
+typedef enum
+{
+    SWEEPER_START, ///< No mines placed until the first reveal
+    SWEEPER_ALIVE,
+    SWEEPER_OVER,
+    SWEEPER_WIN,
+} SweeperStatus;
+
+/**
+ * @ingroup ui_pages
+ * @brief Single board cell
+ */
+typedef struct
+{
+    uint8_t value; ///< Neighbouring mine count or SWEEPER_MINE
+    bool hidden;
+    bool flag;
+    bool redraw; ///< Set when the cell changed, cleared by the page
+} SweeperCell;
+
+/**
+ * @ingroup ui_pages
+ * @brief Board state
+ */
+typedef struct
+{
+    SweeperCell cells[SWEEPER_MAX_ROWS][SWEEPER_MAX_COLS];
+    uint16_t work[SWEEPER_MAX_CELLS]; ///< Flood fill FIFO, also scratch for mine placement
+    uint8_t cols;
+    uint8_t rows;
+    uint16_t mines;
+    uint16_t hidden_safe;   ///< Non-mine cells still hidden
+    uint16_t flagged_mines; ///< Mines carrying a flag
+    uint16_t work_peak;     ///< Longest work list seen since init
+    SweeperStatus status;
+} SweeperBoard;
+
+/**
+ * @ingroup ui_pages
+ * @brief Reset to a hidden board
+ * @param board Board to reset
+ * @param cols Columns, clamped to SWEEPER_MAX_COLS
+ * @param rows Rows, clamped to SWEEPER_MAX_ROWS
+ * @param mines Mines placed by the first reveal
+ *
+ * Every cell is hidden and marked for redraw.
+ */
+void sweeper_board_init(SweeperBoard *board, uint8_t cols, uint8_t rows, uint16_t mines);
+
+/**
+ * @ingroup ui_pages
+ * @brief Place mines away from the first reveal
+ * @param board Board in SWEEPER_START
+ * @param safe_x Column of the first reveal
+ * @param safe_y Row of the first reveal
+ *
+ * Mines are drawn with rand() from the cells outside the 3x3 block around
+ * the first reveal, so placement always terminates. Fewer mines are placed
+ * if the board has no room for all of them.
+ */
+void sweeper_board_place_mines(SweeperBoard *board, uint8_t safe_x, uint8_t safe_y);
+
+/**
+ * @ingroup ui_pages
+ * @brief Reveal a cell
+ * @param board Board state
+ * @param x Cell column
+ * @param y Cell row
+ * @return Number of cells revealed
+ *
+ * The first reveal places the mines. Hidden zero cells open their whole
+ * region. Revealing a number whose neighbouring flag count matches its
+ * value reveals its unflagged neighbours. Flagged cells are ignored.
+ */
+int sweeper_board_reveal(SweeperBoard *board, uint8_t x, uint8_t y);
+
+/**
+ * @ingroup ui_pages
+ * @brief Toggle the flag on a hidden cell
+ * @param board Board state
+ * @param x Cell column
+ * @param y Cell row
+ * @return true if the cell changed
+ */
+bool sweeper_board_toggle_flag(SweeperBoard *board, uint8_t x, uint8_t y);
+
+#endif
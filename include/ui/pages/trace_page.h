@@ -0,0 +1,8 @@
+#ifndef TRACEP_H
+#define TRACEP_H
+
+#include "screen.h"
+
+Page* trace_page_create();
+
+#endif
@@ -21,7 +21,8 @@ typedef enum
     PAGE_RESPONSE_DIALLING,    /**< Call dialing response */
     PAGE_RESPONSE_ACTIVE_CALL, /**< Active call response */
     PAGE_RESPONSE_CALL_ENDED,  /**< Call ended response */
-    PAGE_RESPONSE_BATTERY_HC   /**< Battery health check response */
+    PAGE_RESPONSE_BATTERY_HC,  /**< Battery health check response */
+    PAGE_RESPONSE_CONTACTS     /**< ContactsReply from the contacts task */
 } PageDataResponse;
 
 /**
@@ -54,6 +55,7 @@ typedef struct Page
     void (*destroy)(Page *self);                             /**< Clean up page resources */
     void (*data_response)(Page *self, int type, void *resp); /**< Handle data response */
     void *state;                                             /**< Page-specific state data */
+    const char *name;                                        /**< Short page name for diagnostics */
 } Page;
 
 /**
@@ -85,6 +87,7 @@ void screen_push_page(Page *new_page);
  * @brief Pop the current page from the stack
  *
  * Returns to the previous page. Does nothing if only one page remains.
+ * Timers owned by the popped page are cancelled before it is destroyed.
  */
 void screen_pop_page(void);
 
@@ -93,7 +96,8 @@ void screen_pop_page(void);
  * @brief Replace the current page
  * @param new_page Page to set as current
  *
- * Destroys the current page and replaces it with the new page.
+ * Cancels the current page's timers, destroys it and replaces it with
+ * the new page.
  */
 void screen_set_page(Page *new_page);
 
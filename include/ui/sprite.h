@@ -0,0 +1,152 @@
+/**
+ * @file sprite.h
+ * @brief Colour-keyed sprites composited into an off-screen tile
+ * @ingroup ui_screen
+ *
+ * Sprites are RGB565 images in packed sheets generated by
+ * tools/sprite_pack.py. Pixels equal to SPRITE_KEY are transparent.
+ *
+ * A page's draw_tile paints the tile background into a SpriteCanvas, blits
+ * every sprite that overlaps the tile on top, then sends the canvas to the
+ * panel with display_draw_rgb565() as one window. Moving a SpriteInstance
+ * marks the tiles under its old and new rectangles dirty, so nothing has to
+ * be erased by hand.
+ *
+ * All coordinates are screen pixels.
+ */
+
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tile.h"
+
+#define SPRITE_KEY 0xF81F ///< Transparent colour, magenta
+
+#define SPRITE_CANVAS_PIXELS (TILE_WIDTH * TILE_HEIGHT) ///< Canvas holds one tile
+
+/**
+ * @ingroup ui_screen
+ * @brief Sprite image inside a sheet
+ */
+typedef struct
+{
+    uint8_t width;
+    uint8_t height;
+    const uint16_t *pixels; ///< Row-major RGB565, SPRITE_KEY is transparent
+} Sprite;
+
+/**
+ * @ingroup ui_screen
+ * @brief Off-screen buffer for one tile
+ */
+typedef struct
+{
+    int16_t x; ///< Screen position of the first pixel
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
+    uint16_t pixels[SPRITE_CANVAS_PIXELS];
+} SpriteCanvas;
+
+/**
+ * @ingroup ui_screen
+ * @brief Sprite placed on screen
+ */
+typedef struct
+{
+    const Sprite *sprite; ///< NULL hides the instance
+    int16_t x;
+    int16_t y;
+} SpriteInstance;
+
+/**
+ * @ingroup ui_screen
+ * @brief Start composing a region
+ * @param canvas Canvas to reset
+ * @param x Screen X of the region
+ * @param y Screen Y of the region
+ * @param width Region width, the region is clipped to SPRITE_CANVAS_PIXELS
+ * @param height Region height
+ * @param bg_colour Background the region is cleared to
+ */
+void sprite_canvas_begin(SpriteCanvas *canvas, int x, int y, int width, int height, uint16_t bg_colour);
+
+/**
+ * @ingroup ui_screen
+ * @brief Start composing a tile
+ * @param canvas Canvas to reset
+ * @param tx Tile column
+ * @param ty Tile row
+ * @param bg_colour Background the tile is cleared to
+ */
+void sprite_canvas_begin_tile(SpriteCanvas *canvas, int tx, int ty, uint16_t bg_colour);
+
+/**
+ * @ingroup ui_screen
+ * @brief Fill a rectangle in the canvas, clipped to the canvas
+ */
+void sprite_canvas_fill_rect(SpriteCanvas *canvas, int x, int y, int width, int height, uint16_t colour);
+
+/**
+ * @ingroup ui_screen
+ * @brief Draw a rectangle outline in the canvas, clipped to the canvas
+ */
+void sprite_canvas_draw_rect(SpriteCanvas *canvas, int x, int y, int width, int height, uint16_t colour);
+
+/**
+ * @ingroup ui_screen
+ * @brief Composite a sprite over the canvas
+ * @param canvas Target canvas
+ * @param sprite Sprite to draw
+ * @param x Screen X of the sprite's top-left pixel
+ * @param y Screen Y of the sprite's top-left pixel
+ *
+ * Key pixels are skipped and the sprite is clipped to the canvas, so a
+ * sprite spanning several tiles is drawn a piece at a time.
+ */
+void sprite_blit(SpriteCanvas *canvas, const Sprite *sprite, int x, int y);
+
+/**
+ * @ingroup ui_screen
+ * @brief Composite a sprite as a silhouette in one colour
+ * @param canvas Target canvas
+ * @param sprite Sprite to draw, only its key mask is used
+ * @param x Screen X of the sprite's top-left pixel
+ * @param y Screen Y of the sprite's top-left pixel
+ * @param colour Colour for every non-key pixel
+ *
+ * Lets single-ink sprites follow the current theme.
+ */
+void sprite_blit_tinted(SpriteCanvas *canvas, const Sprite *sprite, int x, int y, uint16_t colour);
+
+/**
+ * @ingroup ui_screen
+ * @brief Check whether an instance overlaps the canvas
+ * @param canvas Canvas being composed
+ * @param instance Instance to test
+ * @return true if any pixel of the instance falls inside the canvas
+ */
+bool sprite_overlaps(const SpriteCanvas *canvas, const SpriteInstance *instance);
+
+/**
+ * @ingroup ui_screen
+ * @brief Mark every tile under a screen rectangle dirty
+ */
+void sprite_mark_rect(int x, int y, int width, int height);
+
+/**
+ * @ingroup ui_screen
+ * @brief Move or change an instance
+ * @param instance Instance to update
+ * @param sprite New image, NULL hides the instance
+ * @param x New screen X
+ * @param y New screen Y
+ *
+ * Marks the tiles under the old and new rectangles dirty. Nothing is
+ * marked when the instance is unchanged.
+ */
+void sprite_place(SpriteInstance *instance, const Sprite *sprite, int x, int y);
+
+#endif
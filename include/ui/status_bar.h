@@ -8,20 +8,53 @@
 #include "theme.h"
 #include "display.h"
 
+// Status bar fields, used as bits for status_bar_invalidate()
+#define STATUS_FIELD_TIME (1U << 0)
+#define STATUS_FIELD_VOLUME (1U << 1)
+#define STATUS_FIELD_HEADPHONES (1U << 2)
+#define STATUS_FIELD_SIGNAL (1U << 3)
+#define STATUS_FIELD_BATTERY (1U << 4)
+#define STATUS_FIELD_ALL 0x1FU
+
+// Counters for the debug page
+typedef struct
+{
+    uint32_t rtc_reads;    // RTC time/date register reads
+    uint32_t redraws;      // field regions redrawn
+    uint32_t redraw_bytes; // LCD bytes sent for status bar redraws
+    uint32_t minute_ticks; // RTC alarm interrupts received
+} StatusBarStats;
+
 // Main status bar drawing function (fills background only on first call)
 void draw_status_bar(void);
 
-// Status bar tick function - call this from screen_tick() for automatic time updates
+// Start the once-per-minute RTC alarm that drives the clock field
+void status_bar_start_clock(void);
+
+// Status bar tick function - call this from screen_tick(). Only fields that
+// were invalidated are redrawn, and the RTC is only read after the minute alarm.
 void status_bar_tick(void);
 
-// Manual update functions - only redraw changed elements
+// Mark fields for redraw on the next tick. Safe to call from interrupts.
+void status_bar_invalidate(uint32_t fields);
+
+// Hook run from the RTC alarm interrupt after the clock field is invalidated,
+// so a sleeping display task can be woken. The hook must be interrupt safe.
+void status_bar_set_wake_hook(void (*hook)(void *arg), void *arg);
+
+// Manual update functions - only changed fields are redrawn on the next tick
 void status_bar_update_signal(uint8_t strength);
 void status_bar_update_battery(uint8_t level);
+void status_bar_update_headphones(bool connected);
 
-// Volume indicator function - shows volume percentage for 5 seconds
+// Volume indicator function - shows volume percentage for 2 seconds, the
+// timeout runs on the UI timer wheel
 void status_bar_show_volume(uint8_t volume);
 
+// Statistics
+void status_bar_get_stats(StatusBarStats *stats);
+
 // Control functions
 void status_bar_reset(void);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file t9.h
+ * @brief T9 predictive text lookup
+ * @ingroup ui_input
+ *
+ * Walks a digit-keyed trie dictionary stored on the SD card, one node per
+ * keypress. The dictionary is produced on the host by tools/t9_dict.py from
+ * a word list with frequencies. Each node lists the words whose digit
+ * sequence ends there, most frequent first, and the most frequent word in
+ * its subtree as a completion hint for partially typed words.
+ *
+ * The file is packed to keep a large word list small on the card: nodes are
+ * written depth first so a node's first child follows it directly, chains
+ * of single-child nodes without words are folded into a digit label on the
+ * node they lead to, and words are stored as the 2-bit position of each
+ * letter on its key, since the typed digits already name the key.
+ *
+ * Only the path from the root to the current node is kept, plus a small
+ * direct-mapped cache of recently read nodes. A node record and its first
+ * T9_MAX_CANDIDATES words come in one read, so each keypress costs at most
+ * one read, and candidates are held in RAM so cycling does no I/O.
+ *
+ * File layout (little endian):
+ * - Header: "T9D2", u32 node_count, u32 word_count, u32 root_offset, u32 reserved
+ * - Node: u8 child_mask (bit i = digit i + 2), u8 word_count (bit 7: hint follows),
+ *   u8 label_len, label digits two per byte (low nibble first),
+ *   u24 child offset for every child after the first,
+ *   hint letters if flagged, then word_count words of letters
+ * - Letters: one 2-bit key position per digit from the root to the node,
+ *   four per byte (lowest bits first)
+ */
+
+#ifndef T9_H
+#define T9_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @ingroup ui_input
+ *  @brief Longest digit sequence (and word) supported */
+#define T9_MAX_DEPTH 24
+
+/** @ingroup ui_input
+ *  @brief Candidates kept in RAM for the current sequence */
+#define T9_MAX_CANDIDATES 8
+
+/** @ingroup ui_input
+ *  @brief Number of node cache entries */
+#define T9_CACHE_NODES 32
+
+/** @ingroup ui_input
+ *  @brief Offset value meaning "no node/word" */
+#define T9_NONE 0xFFFFFFFFUL
+
+/** @ingroup ui_input
+ *  @brief Bytes holding the 2-bit letters of the longest word */
+#define T9_LETTER_BYTES ((T9_MAX_DEPTH + 3) / 4)
+
+/**
+ * @brief Cached trie node
+ * @ingroup ui_input
+ */
+typedef struct
+{
+    uint32_t offset;                                      /**< File offset of the node, T9_NONE if unused */
+    uint32_t children[8];                                 /**< Child offsets in digit order */
+    uint8_t child_mask;                                   /**< Bit i set if digit i + 2 has a child */
+    uint8_t word_count;                                   /**< Words ending at this node */
+    uint8_t depth;                                        /**< Digits from the root to this node */
+    uint8_t label_len;                                    /**< Digits folded into the edge above this node */
+    uint8_t label[(T9_MAX_DEPTH + 1) / 2];                /**< Folded digits, two per byte */
+    bool has_hint;                                        /**< Hint differs from the first word */
+    uint8_t hint[T9_LETTER_BYTES];                        /**< Most frequent word in the subtree */
+    uint8_t words[T9_MAX_CANDIDATES][T9_LETTER_BYTES];    /**< First words ending here */
+} T9Node;
+
+/**
+ * @brief T9 lookup context
+ * @ingroup ui_input
+ */
+typedef struct
+{
+    void *file;                                           /**< Open dictionary file */
+    uint32_t root;                                        /**< Root node offset */
+    uint32_t path[T9_MAX_DEPTH + 1];                      /**< Node offset per depth */
+    uint8_t entry[T9_MAX_DEPTH + 1];                      /**< Depth at which each path node was entered */
+    char digits[T9_MAX_DEPTH + 1];                        /**< Typed digit sequence */
+    uint8_t depth;                                        /**< Number of typed digits */
+    char candidates[T9_MAX_CANDIDATES][T9_MAX_DEPTH + 1]; /**< Candidate words */
+    uint8_t candidate_count;                              /**< Valid candidates */
+    uint8_t candidate_index;                              /**< Selected candidate */
+    bool completion;                                      /**< Candidate is a prefix of a longer word */
+    T9Node cache[T9_CACHE_NODES];                         /**< Node cache */
+    uint32_t cache_hits;                                  /**< Node cache hits */
+    uint32_t cache_misses;                                /**< Node cache misses */
+    uint32_t reads;                                       /**< File reads issued */
+} T9Context;
+
+/**
+ * @ingroup ui_input
+ * @brief Open a dictionary file
+ * @param ctx Context to initialise
+ * @param path Dictionary path on the SD card (or host filesystem)
+ * @return true on success
+ */
+bool t9_open(T9Context *ctx, const char *path);
+
+/**
+ * @ingroup ui_input
+ * @brief Close the dictionary file
+ * @param ctx Context to close
+ */
+void t9_close(T9Context *ctx);
+
+/**
+ * @ingroup ui_input
+ * @brief Start a new word
+ * @param ctx T9 context
+ */
+void t9_reset(T9Context *ctx);
+
+/**
+ * @ingroup ui_input
+ * @brief Extend the sequence with a digit
+ * @param ctx T9 context
+ * @param digit Character '2' to '9'
+ * @return false if no dictionary word starts with the new sequence (state unchanged)
+ */
+bool t9_push_digit(T9Context *ctx, char digit);
+
+/**
+ * @ingroup ui_input
+ * @brief Remove the last digit
+ * @param ctx T9 context
+ * @return false if the sequence was already empty
+ */
+bool t9_pop_digit(T9Context *ctx);
+
+/**
+ * @ingroup ui_input
+ * @brief Get the selected candidate
+ * @param ctx T9 context
+ * @return Candidate word (as long as the digit sequence), or NULL if empty
+ */
+const char *t9_current(const T9Context *ctx);
+
+/**
+ * @ingroup ui_input
+ * @brief Select the next candidate, wrapping to the first
+ * @param ctx T9 context
+ * @return The newly selected candidate, or NULL if empty
+ */
+const char *t9_next_candidate(T9Context *ctx);
+
+#endif /* T9_H */
@@ -1,6 +1,7 @@
 #ifndef TILE_H
 #define TILE_H
 
+#include <stdbool.h>
 #include "screen.h"
 
 #define TILE_WIDTH 30
@@ -17,6 +18,7 @@ static inline void tile_to_pixels(int tx, int ty, int* out_x, int* out_y) {
 void mark_tile_dirty(int tile_x, int tile_y);
 void mark_tile_clean(int tile_x, int tile_y);
 void mark_all_tiles_dirty(void);
-void flush_dirty_tiles(Page* page);
+bool any_tiles_dirty(void);
+int flush_dirty_tiles(Page* page);
 
 #endif
@@ -0,0 +1,178 @@
+/**
+ * @file ui_timer.h
+ * @brief Hierarchical timer wheel for UI timeouts and periodic ticks
+ * @ingroup ui_screen
+ *
+ * One timer service for everything in the UI that waits: game ticks,
+ * blinking cursors, multitap timeouts, debug page refreshes and status bar
+ * indicators. Timers live in a fixed pool and are kept on a four-level wheel
+ * of 64 slots per level at 1 ms resolution, so starting and cancelling a
+ * timer is O(1) regardless of how many are pending. Timers further out sit
+ * on the coarser levels and cascade down as their slot comes due.
+ *
+ * Callbacks run from ui_timer_run(), which the display task calls every
+ * loop, so they may draw and mark tiles dirty like any input handler. Each
+ * timer records an owner (normally its Page); screen_pop_page() and
+ * screen_set_page() cancel every timer owned by the page they destroy.
+ * ui_timer_next_expiry() gives the display task its sleep deadline.
+ *
+ * The wheel is not thread safe: use it from the display task only.
+ */
+
+#ifndef UI_TIMER_H
+#define UI_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @ingroup ui_screen
+ *  @brief Number of timers that can be pending at once */
+#ifndef UI_TIMER_POOL_SIZE
+#define UI_TIMER_POOL_SIZE 32
+#endif
+
+/** @ingroup ui_screen
+ *  @brief Wheel levels */
+#define UI_TIMER_LEVELS 4
+
+/** @ingroup ui_screen
+ *  @brief Slot index bits per level */
+#define UI_TIMER_SLOT_BITS 6
+
+/** @ingroup ui_screen
+ *  @brief Slots per level */
+#define UI_TIMER_SLOTS (1U << UI_TIMER_SLOT_BITS)
+
+/** @ingroup ui_screen
+ *  @brief Longest delay or period in milliseconds (about 4.6 hours), longer ones are clamped */
+#define UI_TIMER_MAX_DELAY_MS ((1UL << (UI_TIMER_LEVELS * UI_TIMER_SLOT_BITS)) - 2)
+
+/** @ingroup ui_screen
+ *  @brief Handle returned when no timer was started */
+#define UI_TIMER_NONE 0
+
+/** @ingroup ui_screen
+ *  @brief ui_timer_next_expiry() result when nothing is pending */
+#define UI_TIMER_NEVER UINT32_MAX
+
+/**
+ * @brief Timer handle
+ * @ingroup ui_screen
+ *
+ * Handles carry a generation count, so a stale handle to a timer that has
+ * already fired or been cancelled is rejected rather than hitting the timer
+ * that reused its pool slot.
+ */
+typedef uint32_t UiTimerId;
+
+/**
+ * @brief Timer callback, run in the display task
+ * @ingroup ui_screen
+ */
+typedef void (*UiTimerCallback)(void *arg);
+
+/**
+ * @brief Timer wheel statistics
+ * @ingroup ui_screen
+ */
+typedef struct
+{
+    uint16_t active;     /**< Timers currently pending */
+    uint16_t high_water; /**< Maximum pending timers seen */
+    uint32_t started;    /**< Timers started */
+    uint32_t fired;      /**< Callbacks run */
+    uint32_t cascaded;   /**< Timers moved down from a coarser level */
+    uint32_t exhausted;  /**< Starts refused because the pool was full */
+} UiTimerStats;
+
+/**
+ * @ingroup ui_screen
+ * @brief Empty the wheel and set its clock
+ * @param now_ms Current time in milliseconds
+ */
+void ui_timer_init(uint32_t now_ms);
+
+/**
+ * @ingroup ui_screen
+ * @brief Start a timer
+ * @param owner Page (or other object) the timer belongs to, NULL for none
+ * @param delay_ms Time until the first expiry, measured from the last ui_timer_run()
+ * @param period_ms Interval between later expiries, 0 for a one-shot timer
+ * @param callback Function to run on expiry
+ * @param arg Argument passed to the callback
+ * @return Timer handle, or UI_TIMER_NONE if the pool is full
+ *
+ * A delay of 0 is treated as 1 ms, so a timer started from a callback
+ * never runs in the same pass.
+ */
+UiTimerId ui_timer_start(const void *owner, uint32_t delay_ms, uint32_t period_ms,
+                         UiTimerCallback callback, void *arg);
+
+/**
+ * @ingroup ui_screen
+ * @brief Cancel a pending timer
+ * @param id Timer handle, UI_TIMER_NONE is ignored
+ * @return true if the timer was pending
+ *
+ * Safe to call from any timer callback, including the timer's own.
+ */
+bool ui_timer_cancel(UiTimerId id);
+
+/**
+ * @ingroup ui_screen
+ * @brief Check whether a timer is still pending
+ * @param id Timer handle
+ * @return true if the timer will fire again
+ */
+bool ui_timer_pending(UiTimerId id);
+
+/**
+ * @ingroup ui_screen
+ * @brief Cancel every timer belonging to an owner
+ * @param owner Owner passed to ui_timer_start(), NULL is ignored
+ * @return Number of timers cancelled
+ *
+ * Walks the whole pool, so it costs O(UI_TIMER_POOL_SIZE). It runs once
+ * per page teardown rather than per timer.
+ */
+int ui_timer_cancel_owner(const void *owner);
+
+/**
+ * @ingroup ui_screen
+ * @brief Advance the wheel to the current time and run expired callbacks
+ * @param now_ms Current time in milliseconds
+ * @return Number of callbacks run
+ *
+ * Runs of empty slots are skipped using per-level occupancy bitmaps, so
+ * catching up after a long sleep does not step through every millisecond.
+ */
+int ui_timer_run(uint32_t now_ms);
+
+/**
+ * @ingroup ui_screen
+ * @brief Time until the wheel next needs ui_timer_run()
+ * @param now_ms Current time in milliseconds
+ * @return Milliseconds until the next expiry or cascade, 0 if one is due,
+ *         UI_TIMER_NEVER if no timers are pending
+ *
+ * Exact for timers within 64 ms. Further out it returns the time of the
+ * next cascade, which is never later than the timer itself.
+ */
+uint32_t ui_timer_next_expiry(uint32_t now_ms);
+
+/**
+ * @ingroup ui_screen
+ * @brief Wheel time of the tick being processed
+ * @return Expiry time of the running callback inside a callback, otherwise
+ *         the time passed to the last ui_timer_run()
+ */
+uint32_t ui_timer_now(void);
+
+/**
+ * @ingroup ui_screen
+ * @brief Get timer wheel statistics
+ * @param stats Receives a snapshot of the counters
+ */
+void ui_timer_get_stats(UiTimerStats *stats);
+
+#endif /* UI_TIMER_H */
@@ -0,0 +1,212 @@
+#include "boot_timeline.h"
+#include <stdio.h>
+#include <string.h>
+
+// written by the owning task, state last, so a reader never sees a finished
+// phase without its end time
+static volatile BootPhaseInfo phases[BOOT_PHASE_COUNT];
+
+static const char *const phase_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_CLOCKS] = "clocks",
+    [BOOT_PHASE_PERIPHERALS] = "peripherals",
+    [BOOT_PHASE_KERNEL] = "kernel",
+    [BOOT_PHASE_DISPLAY] = "display",
+    [BOOT_PHASE_FIRST_FRAME] = "first frame",
+    [BOOT_PHASE_KEYPAD] = "keypad",
+    [BOOT_PHASE_HAPTICS] = "haptics",
+    [BOOT_PHASE_CODEC] = "codec",
+    [BOOT_PHASE_FUEL_GAUGE] = "fuel gauge",
+    [BOOT_PHASE_LEDS] = "leds",
+    [BOOT_PHASE_SD_CARD] = "sd card",
+    [BOOT_PHASE_MODEM] = "modem",
+};
+
+static bool finished(BootState state)
+{
+    return state == BOOT_DONE || state == BOOT_FAILED;
+}
+
+void boot_timeline_reset(void)
+{
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        phases[i].state = BOOT_PENDING;
+        phases[i].start_ms = 0;
+        phases[i].end_ms = 0;
+    }
+}
+
+void boot_phase_begin(BootPhase phase, uint32_t now_ms)
+{
+    if ((unsigned)phase >= BOOT_PHASE_COUNT)
+    {
+        return;
+    }
+    phases[phase].start_ms = now_ms;
+    phases[phase].state = BOOT_RUNNING;
+}
+
+void boot_phase_end(BootPhase phase, bool ok, uint32_t now_ms)
+{
+    if ((unsigned)phase >= BOOT_PHASE_COUNT)
+    {
+        return;
+    }
+    if (phases[phase].state == BOOT_PENDING)
+    {
+        phases[phase].start_ms = now_ms;
+    }
+    phases[phase].end_ms = now_ms;
+    phases[phase].state = ok ? BOOT_DONE : BOOT_FAILED;
+}
+
+void boot_phase_skip(BootPhase phase)
+{
+    if ((unsigned)phase < BOOT_PHASE_COUNT)
+    {
+        phases[phase].state = BOOT_SKIPPED;
+    }
+}
+
+bool boot_phase_get(BootPhase phase, BootPhaseInfo *info)
+{
+    if ((unsigned)phase >= BOOT_PHASE_COUNT || !info)
+    {
+        return false;
+    }
+    info->state = phases[phase].state;
+    info->start_ms = phases[phase].start_ms;
+    info->end_ms = phases[phase].end_ms;
+    return true;
+}
+
+bool boot_finished(void)
+{
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        BootState state = phases[i].state;
+        if (!finished(state) && state != BOOT_SKIPPED)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char *boot_phase_name(BootPhase phase)
+{
+    return (unsigned)phase < BOOT_PHASE_COUNT ? phase_names[phase] : "?";
+}
+
+/* ===== REPORT ===== */
+
+// end of a phase on the report's time axis, running phases end now
+static uint32_t phase_end(const BootPhaseInfo *info, uint32_t now_ms)
+{
+    return finished(info->state) ? info->end_ms : now_ms;
+}
+
+static void draw_bar(char *bar, const BootPhaseInfo *info, uint32_t span, uint32_t now_ms)
+{
+    memset(bar, ' ', BOOT_REPORT_BAR_WIDTH);
+    bar[BOOT_REPORT_BAR_WIDTH] = '\0';
+    if (info->state == BOOT_PENDING || info->state == BOOT_SKIPPED)
+    {
+        return;
+    }
+
+    char fill = info->state == BOOT_DONE ? '#' : (info->state == BOOT_FAILED ? '!' : '=');
+    uint32_t end = phase_end(info, now_ms);
+    // every phase gets at least the cell it starts in
+    uint32_t first = (uint32_t)((uint64_t)info->start_ms * BOOT_REPORT_BAR_WIDTH / span);
+    uint32_t last = (uint32_t)(((uint64_t)end * BOOT_REPORT_BAR_WIDTH + span - 1) / span);
+    if (first >= BOOT_REPORT_BAR_WIDTH)
+    {
+        first = BOOT_REPORT_BAR_WIDTH - 1;
+    }
+    if (last <= first)
+    {
+        last = first + 1;
+    }
+    if (last > BOOT_REPORT_BAR_WIDTH)
+    {
+        last = BOOT_REPORT_BAR_WIDTH;
+    }
+    memset(bar + first, fill, last - first);
+}
+
+int boot_timeline_report(BootReportLine out, void *arg, uint32_t now_ms)
+{
+    BootPhaseInfo info[BOOT_PHASE_COUNT];
+    uint32_t span = 1;
+    bool done = true;
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        boot_phase_get((BootPhase)i, &info[i]);
+        if (info[i].state == BOOT_PENDING || info[i].state == BOOT_RUNNING)
+        {
+            done = false;
+        }
+        if (info[i].state != BOOT_PENDING && info[i].state != BOOT_SKIPPED && phase_end(&info[i], now_ms) > span)
+        {
+            span = phase_end(&info[i], now_ms);
+        }
+    }
+
+    char line[BOOT_REPORT_LINE_MAX];
+    int lines = 0;
+    snprintf(line, sizeof(line), "%-11s%5s %6s  0-%lums", "phase", "at", "took", (unsigned long)span);
+    out(line, arg);
+    lines++;
+
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        char at[12] = "-";
+        char took[12];
+        switch (info[i].state)
+        {
+        case BOOT_DONE:
+            snprintf(took, sizeof(took), "%lu", (unsigned long)(info[i].end_ms - info[i].start_ms));
+            break;
+        case BOOT_FAILED:
+            strcpy(took, "fail");
+            break;
+        case BOOT_RUNNING:
+            strcpy(took, "run");
+            break;
+        case BOOT_SKIPPED:
+            strcpy(took, "skip");
+            break;
+        default:
+            strcpy(took, "-");
+            break;
+        }
+        if (info[i].state != BOOT_PENDING && info[i].state != BOOT_SKIPPED)
+        {
+            snprintf(at, sizeof(at), "%lu", (unsigned long)info[i].start_ms);
+        }
+        char bar[BOOT_REPORT_BAR_WIDTH + 1];
+        draw_bar(bar, &info[i], span, now_ms);
+        snprintf(line, sizeof(line), "%-11.11s%5s %6s |%s|", phase_names[i], at, took, bar);
+        out(line, arg);
+        lines++;
+    }
+
+    const BootPhaseInfo *frame = &info[BOOT_PHASE_FIRST_FRAME];
+    if (finished(frame->state))
+    {
+        snprintf(line, sizeof(line), "first frame %lu ms, target %u %s", (unsigned long)frame->end_ms,
+                 BOOT_FIRST_FRAME_TARGET_MS, frame->end_ms <= BOOT_FIRST_FRAME_TARGET_MS ? "met" : "missed");
+    }
+    else
+    {
+        snprintf(line, sizeof(line), "first frame pending");
+    }
+    out(line, arg);
+    lines++;
+
+    snprintf(line, sizeof(line), done ? "boot took %lu ms" : "boot running, %lu ms", (unsigned long)span);
+    out(line, arg);
+    lines++;
+    return lines;
+}
@@ -0,0 +1,255 @@
+#include "event_bus.h"
+#include "msg_pool.h"
+#include <string.h>
+
+#if defined(USE_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#else
+#include <pthread.h>
+#endif
+
+struct EventSubscriber
+{
+    EventSubscription sub;
+    Event ring[EVENT_BUS_QUEUE_DEPTH];
+    uint8_t head;
+    uint8_t count;
+    EventSubscriberStats stats;
+};
+
+static EventSubscriber subscribers[EVENT_BUS_MAX_SUBSCRIBERS];
+static uint8_t subscriber_count;
+static EventTopicStats topic_stats[EVENT_TOPIC_COUNT];
+
+/* ===== LOCKING ===== */
+#if defined(USE_FREERTOS)
+typedef UBaseType_t bus_lock_t;
+
+static bus_lock_t bus_lock(void)
+{
+    if (xPortIsInsideInterrupt())
+    {
+        return taskENTER_CRITICAL_FROM_ISR();
+    }
+    taskENTER_CRITICAL();
+    return 0;
+}
+
+static void bus_unlock(bus_lock_t saved)
+{
+    if (xPortIsInsideInterrupt())
+    {
+        taskEXIT_CRITICAL_FROM_ISR(saved);
+    }
+    else
+    {
+        taskEXIT_CRITICAL();
+    }
+}
+#else
+typedef int bus_lock_t;
+
+static pthread_mutex_t bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static bus_lock_t bus_lock(void)
+{
+    pthread_mutex_lock(&bus_mutex);
+    return 0;
+}
+
+static void bus_unlock(bus_lock_t saved)
+{
+    (void)saved;
+    pthread_mutex_unlock(&bus_mutex);
+}
+#endif
+
+/* ===== DELIVERY ===== */
+
+// Queue an event in the subscriber ring, returns true if it should be woken
+static bool ring_push(EventSubscriber *s, const Event *event, bool *accepted)
+{
+    if (event->data)
+    {
+        msg_retain(event->data);
+    }
+
+    bus_lock_t saved = bus_lock();
+    bool wake = false;
+    *accepted = s->count < EVENT_BUS_QUEUE_DEPTH;
+    if (*accepted)
+    {
+        s->ring[(s->head + s->count) % EVENT_BUS_QUEUE_DEPTH] = *event;
+        // the subscriber drains the whole ring, so only the first event wakes it
+        wake = s->count++ == 0;
+        if (s->count > s->stats.high_water)
+        {
+            s->stats.high_water = s->count;
+        }
+    }
+    bus_unlock(saved);
+
+    if (!*accepted && event->data)
+    {
+        msg_release(event->data);
+    }
+    return wake;
+}
+
+/* ===== PUBLIC API ===== */
+
+void event_bus_init(void)
+{
+    bus_lock_t saved = bus_lock();
+    memset(subscribers, 0, sizeof(subscribers));
+    memset(topic_stats, 0, sizeof(topic_stats));
+    subscriber_count = 0;
+    bus_unlock(saved);
+}
+
+EventSubscriber *event_bus_subscribe(const EventSubscription *subscription)
+{
+    if (!subscription || subscriber_count >= EVENT_BUS_MAX_SUBSCRIBERS)
+    {
+        return NULL;
+    }
+
+    EventSubscriber *s = &subscribers[subscriber_count];
+    memset(s, 0, sizeof(*s));
+    s->sub = *subscription;
+    s->stats.name = subscription->name;
+    subscriber_count++;
+    return s;
+}
+
+int event_bus_publish(EventTopic topic, uint32_t value, void *data)
+{
+    if ((unsigned)topic >= EVENT_TOPIC_COUNT)
+    {
+        msg_release(data);
+        return 0;
+    }
+
+    Event event = {.topic = topic, .value = value, .data = data};
+    uint32_t bit = EVENT_TOPIC_BIT(topic);
+    uint32_t filtered = 0, dropped = 0, wakeups = 0;
+    int delivered = 0;
+
+    for (uint8_t i = 0; i < subscriber_count; i++)
+    {
+        EventSubscriber *s = &subscribers[i];
+        if (!(s->sub.topics & bit))
+        {
+            continue;
+        }
+        if (s->sub.filter && !s->sub.filter(&event, s->sub.arg))
+        {
+            filtered++;
+            continue;
+        }
+
+        bool accepted;
+        bool wake;
+        if (s->sub.sink)
+        {
+            accepted = s->sub.sink(&event, s->sub.arg);
+            wake = accepted;
+        }
+        else
+        {
+            wake = ring_push(s, &event, &accepted);
+        }
+        wake = wake && s->sub.wake;
+
+        bus_lock_t saved = bus_lock();
+        if (accepted)
+        {
+            s->stats.delivered++;
+            delivered++;
+        }
+        else
+        {
+            s->stats.dropped++;
+            dropped++;
+        }
+        if (wake)
+        {
+            s->stats.wakeups++;
+            wakeups++;
+        }
+        bus_unlock(saved);
+
+        if (wake)
+        {
+            s->sub.wake(s->sub.arg);
+        }
+    }
+
+    bus_lock_t saved = bus_lock();
+    topic_stats[topic].published++;
+    topic_stats[topic].delivered += delivered;
+    topic_stats[topic].filtered += filtered;
+    topic_stats[topic].dropped += dropped;
+    topic_stats[topic].wakeups += wakeups;
+    bus_unlock(saved);
+
+    // every ring delivery took its own reference, the publisher's ends here
+    msg_release(data);
+    return delivered;
+}
+
+bool event_bus_receive(EventSubscriber *subscriber, Event *event)
+{
+    if (!subscriber || !event)
+    {
+        return false;
+    }
+
+    bus_lock_t saved = bus_lock();
+    bool available = subscriber->count > 0;
+    if (available)
+    {
+        *event = subscriber->ring[subscriber->head];
+        subscriber->head = (subscriber->head + 1) % EVENT_BUS_QUEUE_DEPTH;
+        subscriber->count--;
+    }
+    bus_unlock(saved);
+    return available;
+}
+
+bool event_bus_pending(EventSubscriber *subscriber)
+{
+    return subscriber && subscriber->count > 0;
+}
+
+void event_bus_release(Event *event)
+{
+    if (event && event->data)
+    {
+        msg_release(event->data);
+        event->data = NULL;
+    }
+}
+
+void event_bus_get_topic_stats(EventTopic topic, EventTopicStats *stats)
+{
+    if (!stats || (unsigned)topic >= EVENT_TOPIC_COUNT)
+    {
+        return;
+    }
+    bus_lock_t saved = bus_lock();
+    *stats = topic_stats[topic];
+    bus_unlock(saved);
+}
+
+void event_bus_get_subscriber_stats(const EventSubscriber *subscriber, EventSubscriberStats *stats)
+{
+    if (!subscriber || !stats)
+    {
+        return;
+    }
+    bus_lock_t saved = bus_lock();
+    *stats = subscriber->stats;
+    bus_unlock(saved);
+}
@@ -0,0 +1,457 @@
+#include "health_monitor.h"
+#include <stddef.h>
+#include <string.h>
+
+#if defined(USE_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#elif !defined(__arm__)
+#include <pthread.h>
+#endif
+
+typedef struct
+{
+    const char *name;
+    uint32_t timeout_ms;
+    volatile uint32_t last_ms;
+    volatile uint32_t beats;
+    uint32_t max_age_ms;
+    bool critical;
+    bool hung;
+} Heartbeat;
+
+typedef struct
+{
+    HealthTaskInfo info;
+    uint32_t last_runtime;
+    bool seen;      // present in the latest snapshot
+    bool stack_low; // already recorded this boot
+} TaskEntry;
+
+static Heartbeat heartbeats[HEALTH_MAX_HEARTBEATS];
+static uint8_t heartbeat_count;
+static TaskEntry tasks[HEALTH_MAX_TASKS];
+static uint8_t task_count;
+static uint32_t last_total_runtime;
+static bool have_snapshot;
+static uint32_t boot_ms;
+static HealthBackup *backup;
+
+/* ===== LOCKING ===== */
+#if defined(USE_FREERTOS)
+typedef UBaseType_t health_lock_t;
+
+static health_lock_t health_lock(void)
+{
+    taskENTER_CRITICAL();
+    return 0;
+}
+
+static void health_unlock(health_lock_t saved)
+{
+    (void)saved;
+    taskEXIT_CRITICAL();
+}
+#elif defined(__arm__)
+// bare-metal driver builds run a single thread
+typedef int health_lock_t;
+
+static health_lock_t health_lock(void)
+{
+    return 0;
+}
+
+static void health_unlock(health_lock_t saved)
+{
+    (void)saved;
+}
+#else
+typedef int health_lock_t;
+
+static pthread_mutex_t health_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static health_lock_t health_lock(void)
+{
+    pthread_mutex_lock(&health_mutex);
+    return 0;
+}
+
+static void health_unlock(health_lock_t saved)
+{
+    (void)saved;
+    pthread_mutex_unlock(&health_mutex);
+}
+#endif
+
+/* ===== BACKUP BLOCK ===== */
+
+// FNV-1a over the block up to the checksum
+static uint32_t backup_checksum(const HealthBackup *b)
+{
+    const uint8_t *p = (const uint8_t *)b;
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < offsetof(HealthBackup, checksum); i++)
+    {
+        hash = (hash ^ p[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+static void backup_seal(void)
+{
+    backup->checksum = backup_checksum(backup);
+}
+
+static void copy_name(char dst[HEALTH_NAME_LEN], const char *src)
+{
+    memset(dst, 0, HEALTH_NAME_LEN);
+    if (src)
+    {
+        memcpy(dst, src, strnlen(src, HEALTH_NAME_LEN - 1));
+    }
+}
+
+static void record(HealthEvent event, const char *name, uint32_t value, uint32_t now_ms)
+{
+    if (!backup)
+    {
+        return;
+    }
+    HealthRecord *r = &backup->history[backup->head];
+    r->uptime_s = (now_ms - boot_ms) / 1000;
+    r->value = value;
+    r->boot = backup->boot_count;
+    r->event = (uint8_t)event;
+    r->reset_cause = backup->reset_cause;
+    copy_name(r->name, name);
+
+    backup->head = (backup->head + 1) % HEALTH_HISTORY_LEN;
+    if (backup->count < HEALTH_HISTORY_LEN)
+    {
+        backup->count++;
+    }
+    backup_seal();
+}
+
+static HealthStackMark *stack_mark(const char *name)
+{
+    HealthStackMark *free_slot = NULL;
+    for (int i = 0; i < HEALTH_MAX_TASKS; i++)
+    {
+        HealthStackMark *m = &backup->stacks[i];
+        if (m->name[0] == '\0')
+        {
+            if (!free_slot)
+            {
+                free_slot = m;
+            }
+        }
+        else if (strncmp(m->name, name, HEALTH_NAME_LEN - 1) == 0)
+        {
+            return m;
+        }
+    }
+    if (free_slot)
+    {
+        copy_name(free_slot->name, name);
+        free_slot->min_free = UINT32_MAX;
+    }
+    return free_slot;
+}
+
+/* ===== PUBLIC API ===== */
+
+void health_init(HealthBackup *backup_block, HealthResetCause cause, uint32_t now_ms)
+{
+    memset(heartbeats, 0, sizeof(heartbeats));
+    memset(tasks, 0, sizeof(tasks));
+    heartbeat_count = 0;
+    task_count = 0;
+    have_snapshot = false;
+    boot_ms = now_ms;
+    backup = backup_block;
+    if (!backup)
+    {
+        return;
+    }
+
+    if (backup->magic != HEALTH_BACKUP_MAGIC || backup->version != HEALTH_BACKUP_VERSION ||
+        backup->head >= HEALTH_HISTORY_LEN || backup->count > HEALTH_HISTORY_LEN ||
+        backup->checksum != backup_checksum(backup))
+    {
+        memset(backup, 0, sizeof(*backup));
+        backup->magic = HEALTH_BACKUP_MAGIC;
+        backup->version = HEALTH_BACKUP_VERSION;
+    }
+
+    uint32_t previous_uptime = backup->uptime_s;
+    backup->boot_count++;
+    backup->reset_cause = (uint8_t)cause;
+    backup->uptime_s = 0;
+    record(HEALTH_EVENT_BOOT, NULL, previous_uptime, now_ms);
+}
+
+int health_register(const char *name, uint32_t timeout_ms, bool critical)
+{
+    health_lock_t saved = health_lock();
+    int id = -1;
+    if (heartbeat_count < HEALTH_MAX_HEARTBEATS)
+    {
+        id = heartbeat_count++;
+        Heartbeat *hb = &heartbeats[id];
+        memset(hb, 0, sizeof(*hb));
+        hb->name = name;
+        hb->timeout_ms = timeout_ms;
+        hb->critical = critical;
+        hb->last_ms = boot_ms;
+    }
+    health_unlock(saved);
+    return id;
+}
+
+void health_heartbeat(int id, uint32_t now_ms)
+{
+    if (id < 0 || id >= heartbeat_count)
+    {
+        return;
+    }
+    // single word stores, the checker tolerates a torn beat count
+    heartbeats[id].last_ms = now_ms;
+    heartbeats[id].beats++;
+}
+
+bool health_check(uint32_t now_ms)
+{
+    bool alive = true;
+
+    health_lock_t saved = health_lock();
+    for (int i = 0; i < heartbeat_count; i++)
+    {
+        Heartbeat *hb = &heartbeats[i];
+        uint32_t age = now_ms - hb->last_ms;
+        if (age > hb->max_age_ms)
+        {
+            hb->max_age_ms = age;
+        }
+
+        bool hung = age > hb->timeout_ms;
+        if (hung && !hb->hung)
+        {
+            // written before the refresh stops, so it survives the watchdog reset
+            record(HEALTH_EVENT_HANG, hb->name, age, now_ms);
+        }
+        hb->hung = hung;
+        if (hung && hb->critical)
+        {
+            alive = false;
+        }
+    }
+
+    if (backup)
+    {
+        backup->uptime_s = (now_ms - boot_ms) / 1000;
+        backup_seal();
+    }
+    health_unlock(saved);
+    return alive;
+}
+
+void health_update_tasks(const HealthTaskSample *samples, int count, uint32_t total_runtime, uint32_t now_ms)
+{
+    if (!samples)
+    {
+        return;
+    }
+
+    uint32_t total_delta = total_runtime - last_total_runtime;
+    bool have_delta = have_snapshot && total_delta > 0;
+
+    health_lock_t saved = health_lock();
+    for (int t = 0; t < task_count; t++)
+    {
+        tasks[t].seen = false;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        const HealthTaskSample *s = &samples[i];
+        TaskEntry *e = NULL;
+        for (int t = 0; t < task_count; t++)
+        {
+            if (strncmp(tasks[t].info.name, s->name, HEALTH_NAME_LEN - 1) == 0)
+            {
+                e = &tasks[t];
+                break;
+            }
+        }
+        if (!e)
+        {
+            if (task_count >= HEALTH_MAX_TASKS)
+            {
+                continue;
+            }
+            e = &tasks[task_count++];
+            memset(e, 0, sizeof(*e));
+            copy_name(e->info.name, s->name);
+            e->info.stack_min = UINT32_MAX;
+            e->last_runtime = s->runtime;
+        }
+        else if (have_delta)
+        {
+            uint64_t used = (uint64_t)(uint32_t)(s->runtime - e->last_runtime) * 1000;
+            uint32_t permille = (uint32_t)(used / total_delta);
+            e->info.cpu_permille = permille > 1000 ? 1000 : permille;
+        }
+
+        e->seen = true;
+        e->last_runtime = s->runtime;
+        e->info.priority = s->priority;
+        e->info.stack_free = s->stack_free;
+        if (s->stack_free < e->info.stack_min)
+        {
+            e->info.stack_min = s->stack_free;
+        }
+    }
+
+    // tasks that were deleted stop using the CPU
+    for (int t = 0; t < task_count; t++)
+    {
+        if (!tasks[t].seen)
+        {
+            tasks[t].info.cpu_permille = 0;
+        }
+    }
+    last_total_runtime = total_runtime;
+    have_snapshot = true;
+
+    bool changed = false;
+    for (int t = 0; backup && t < task_count; t++)
+    {
+        TaskEntry *e = &tasks[t];
+        HealthStackMark *m = stack_mark(e->info.name);
+        if (m && e->info.stack_free < m->min_free)
+        {
+            m->min_free = e->info.stack_free;
+            changed = true;
+        }
+        if (m)
+        {
+            e->info.stack_min = m->min_free;
+        }
+        if (!e->stack_low && e->info.stack_free < HEALTH_STACK_LOW_BYTES)
+        {
+            e->stack_low = true;
+            record(HEALTH_EVENT_STACK_LOW, e->info.name, e->info.stack_free, now_ms);
+        }
+    }
+    if (changed)
+    {
+        backup_seal();
+    }
+    health_unlock(saved);
+}
+
+int health_get_tasks(HealthTaskInfo *info, int max)
+{
+    if (!info)
+    {
+        return 0;
+    }
+    health_lock_t saved = health_lock();
+    int n = task_count < max ? task_count : max;
+    for (int i = 0; i < n; i++)
+    {
+        info[i] = tasks[i].info;
+    }
+    health_unlock(saved);
+    return n;
+}
+
+int health_get_heartbeats(HealthHeartbeatInfo *info, int max, uint32_t now_ms)
+{
+    if (!info)
+    {
+        return 0;
+    }
+    int n = heartbeat_count < max ? heartbeat_count : max;
+    for (int i = 0; i < n; i++)
+    {
+        const Heartbeat *hb = &heartbeats[i];
+        info[i].name = hb->name;
+        info[i].timeout_ms = hb->timeout_ms;
+        info[i].age_ms = now_ms - hb->last_ms;
+        info[i].max_age_ms = hb->max_age_ms;
+        info[i].beats = hb->beats;
+        info[i].critical = hb->critical;
+        info[i].hung = hb->hung;
+    }
+    return n;
+}
+
+int health_get_history(HealthRecord *records, int max)
+{
+    if (!records || !backup)
+    {
+        return 0;
+    }
+    health_lock_t saved = health_lock();
+    int n = backup->count < max ? backup->count : max;
+    for (int i = 0; i < n; i++)
+    {
+        int slot = (backup->head + HEALTH_HISTORY_LEN - 1 - i) % HEALTH_HISTORY_LEN;
+        records[i] = backup->history[slot];
+    }
+    health_unlock(saved);
+    return n;
+}
+
+void health_get_boot(uint16_t *boot_count, HealthResetCause *cause)
+{
+    if (boot_count)
+    {
+        *boot_count = backup ? backup->boot_count : 0;
+    }
+    if (cause)
+    {
+        *cause = backup ? (HealthResetCause)backup->reset_cause : HEALTH_RESET_UNKNOWN;
+    }
+}
+
+void health_clear_history(void)
+{
+    if (!backup)
+    {
+        return;
+    }
+    health_lock_t saved = health_lock();
+    backup->head = 0;
+    backup->count = 0;
+    memset(backup->history, 0, sizeof(backup->history));
+    memset(backup->stacks, 0, sizeof(backup->stacks));
+    backup_seal();
+    for (int t = 0; t < task_count; t++)
+    {
+        tasks[t].info.stack_min = tasks[t].info.stack_free;
+        tasks[t].stack_low = false;
+    }
+    health_unlock(saved);
+}
+
+const char *health_reset_name(HealthResetCause cause)
+{
+    switch (cause)
+    {
+    case HEALTH_RESET_POWER_ON:
+        return "power";
+    case HEALTH_RESET_PIN:
+        return "pin";
+    case HEALTH_RESET_SOFTWARE:
+        return "soft";
+    case HEALTH_RESET_WATCHDOG:
+        return "wdog";
+    case HEALTH_RESET_LOW_POWER:
+        return "lpwr";
+    default:
+        return "?";
+    }
+}
@@ -5,6 +5,13 @@
 #include "cellular_task.h"
 #include "power_task.h"
 #include "test_task.h"
+#include "watchdog_task.h"
+#include "boot_task.h"
+#include "contacts_task.h"
+#include "i2c_bus.h"
+#include "msg_pool.h"
+#include "event_bus.h"
+#include "tickless_idle.h"
 
 void kernel_init(void)
 {
@@ -15,8 +22,22 @@ void kernel_init(void)
     PowerTaskContext *power_ctx = NULL;
     TestTaskContext *test_ctx = NULL;
 
-    // Initialize call state (needs display, but we'll set it later)
-    call_ctx = CallState_Init(NULL);
+    // Message payloads exchanged by the tasks below come from this pool,
+    // and the tasks subscribe to the event bus as they are created
+    msg_pool_init();
+    event_bus_init();
+
+    // LPTIM1 times the idle sleeps once every task below is blocked
+    tickless_idle_init();
+
+    // The codec, IMU and fuel gauge share I2C1 and come up from different tasks
+    i2c_bus_init();
+
+    // Health monitor first, the tasks below register their heartbeats with it
+    WatchdogTask_Init();
+
+    // Initialize call state, it publishes state changes on the event bus
+    call_ctx = CallState_Init();
 
     // Initialize display task with call context (cellular will be set later)
     display_ctx = DisplayTask_Init(call_ctx, NULL);
@@ -27,15 +48,19 @@ void kernel_init(void)
     // Initialize power task (needs display context)
     power_ctx = PowerTask_Init(display_ctx);
 
+    // The contacts pages read the contacts tree through this task
+    ContactsTask_Init(display_ctx);
+
     // Initialize audio task first (needs cellular init first)
     audio_ctx = AudioTask_Init();
 
     // Now set the cross-references
-    CallState_SetDisplayContext(call_ctx, display_ctx);
     DisplayTask_SetCellularContext(display_ctx, cellular_ctx);
     DisplayTask_SetPowerContext(display_ctx, power_ctx);
 
     // input task should not have call ctx, this is just for testing
     InputTask_Init(display_ctx, audio_ctx, call_ctx);
 
+    // Last and lowest, the LEDs and SD card come up behind the first frame
+    BootTask_Init();
 }
\ No newline at end of file
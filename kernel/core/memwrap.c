@@ -0,0 +1,613 @@
+#include "memwrap.h"
+#include <string.h>
+
+#if defined(USE_FREERTOS)
+#include "task.h"
+#elif defined(MEM_TRACKING) && !defined(__arm__)
+#include <pthread.h>
+#endif
+
+/* ===== HEAP ===== */
+
+#if defined(USE_FREERTOS) && !defined(HEAP_TLSF)
+// heap_4 puts a BlockLink_t in front of every block: the next free block and
+// the block size including the header, with the top bit set while allocated
+typedef struct
+{
+    void *next;
+    size_t size;
+} HeapBlockHeader;
+
+#define HEAP_HEADER_SIZE ((sizeof(HeapBlockHeader) + portBYTE_ALIGNMENT - 1) & ~((size_t)portBYTE_ALIGNMENT_MASK))
+#define HEAP_ALLOCATED_BIT ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
+static size_t heap_usable_size(const void *ptr)
+{
+    const HeapBlockHeader *header = (const HeapBlockHeader *)((const uint8_t *)ptr - HEAP_HEADER_SIZE);
+    return (header->size & ~HEAP_ALLOCATED_BIT) - HEAP_HEADER_SIZE;
+}
+
+void *mem_heap_realloc(void *ptr, size_t newsize)
+{
+    if (!ptr)
+    {
+        return pvPortMalloc(newsize);
+    }
+    if (newsize == 0)
+    {
+        vPortFree(ptr);
+        return NULL;
+    }
+
+    // the block already has room, heap_4 would not split off a useful remainder
+    size_t old_size = heap_usable_size(ptr);
+    if (newsize <= old_size)
+    {
+        return ptr;
+    }
+
+    void *newp = pvPortMalloc(newsize);
+    if (newp)
+    {
+        memcpy(newp, ptr, old_size);
+        vPortFree(ptr);
+    }
+    return newp;
+}
+#endif
+
+void mem_get_heap_stats(MemHeapStats *stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+
+#if defined(USE_FREERTOS)
+    HeapStats_t heap;
+    vPortGetHeapStats(&heap);
+    stats->free_bytes = heap.xAvailableHeapSpaceInBytes;
+    stats->largest_free = heap.xSizeOfLargestFreeBlockInBytes;
+    stats->min_ever_free = heap.xMinimumEverFreeBytesRemaining;
+    stats->free_blocks = heap.xNumberOfFreeBlocks;
+    if (stats->free_bytes > 0)
+    {
+        stats->fragmentation_permille =
+            (uint16_t)(1000 - (uint64_t)stats->largest_free * 1000 / stats->free_bytes);
+    }
+#endif
+}
+
+#if defined(MEM_TRACKING)
+
+/* ===== TRACKING ===== */
+
+#define SLOT_MASK (MEM_TRACK_MAX_ALLOCS - 1)
+// probing slows down as the table fills, keep an eighth of it empty
+#define SLOT_LIMIT (MEM_TRACK_MAX_ALLOCS - MEM_TRACK_MAX_ALLOCS / 8)
+#define TAG_OTHER (MEM_TRACK_MAX_TAGS - 1) // shared by files past the table
+
+#if (MEM_TRACK_MAX_ALLOCS & SLOT_MASK) != 0
+#error "MEM_TRACK_MAX_ALLOCS must be a power of two"
+#endif
+
+typedef struct
+{
+    void *ptr; // NULL when empty
+    uint32_t size;
+    uint32_t seq;
+    uint16_t tag;
+    uint16_t line;
+} Slot;
+
+// open addressing on the block address, linear probing
+static Slot slots[MEM_TRACK_MAX_ALLOCS];
+static MemTagStats tags[MEM_TRACK_MAX_TAGS];
+static uint8_t tag_count;
+static MemTrackStats totals;
+static MemLeakReport last_report;
+static uint32_t next_seq = 1;
+
+/* ===== LOCKING ===== */
+#if defined(USE_FREERTOS)
+static void mem_lock(void)
+{
+    taskENTER_CRITICAL();
+}
+
+static void mem_unlock(void)
+{
+    taskEXIT_CRITICAL();
+}
+#elif defined(__arm__)
+// bare-metal driver builds run a single thread
+static void mem_lock(void)
+{
+}
+
+static void mem_unlock(void)
+{
+}
+#else
+static pthread_mutex_t mem_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void mem_lock(void)
+{
+    pthread_mutex_lock(&mem_mutex);
+}
+
+static void mem_unlock(void)
+{
+    pthread_mutex_unlock(&mem_mutex);
+}
+#endif
+
+static uint32_t slot_hash(const void *ptr)
+{
+    // blocks are at least 8-byte aligned
+    uint32_t addr = (uint32_t)((uintptr_t)ptr >> 3);
+    return (addr * 2654435761u) & SLOT_MASK;
+}
+
+static int slot_find(const void *ptr)
+{
+    uint32_t i = slot_hash(ptr);
+    while (slots[i].ptr)
+    {
+        if (slots[i].ptr == ptr)
+        {
+            return (int)i;
+        }
+        i = (i + 1) & SLOT_MASK;
+    }
+    return -1;
+}
+
+static void slot_insert(const Slot *slot)
+{
+    uint32_t i = slot_hash(slot->ptr);
+    while (slots[i].ptr)
+    {
+        i = (i + 1) & SLOT_MASK;
+    }
+    slots[i] = *slot;
+}
+
+// backward-shift deletion keeps every probe chain unbroken without tombstones
+static void slot_remove(uint32_t hole)
+{
+    uint32_t j = hole;
+    for (;;)
+    {
+        slots[hole].ptr = NULL;
+        for (;;)
+        {
+            j = (j + 1) & SLOT_MASK;
+            if (!slots[j].ptr)
+            {
+                return;
+            }
+            // an entry stays put if its home lies cyclically in (hole, j]
+            uint32_t home = slot_hash(slots[j].ptr);
+            bool stays = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+            if (!stays)
+            {
+                break;
+            }
+        }
+        slots[hole] = slots[j];
+        hole = j;
+    }
+}
+
+static const char *file_name(const char *path)
+{
+    const char *name = path;
+    for (const char *c = path; *c; c++)
+    {
+        if (*c == '/' || *c == '\\')
+        {
+            name = c + 1;
+        }
+    }
+    return name;
+}
+
+static uint16_t tag_find(const char *file)
+{
+    const char *name = file_name(file);
+    for (uint16_t i = 0; i < tag_count; i++)
+    {
+        if (tags[i].tag == name || strcmp(tags[i].tag, name) == 0)
+        {
+            return i;
+        }
+    }
+    if (tag_count < TAG_OTHER)
+    {
+        memset(&tags[tag_count], 0, sizeof(tags[tag_count]));
+        tags[tag_count].tag = name;
+        return tag_count++;
+    }
+    tags[TAG_OTHER].tag = "other";
+    if (tag_count == TAG_OTHER)
+    {
+        tag_count++;
+    }
+    return TAG_OTHER;
+}
+
+static void track_add(void *ptr, size_t size, const char *file, int line)
+{
+    mem_lock();
+    if (!ptr)
+    {
+        totals.failed += size > 0;
+        mem_unlock();
+        return;
+    }
+    if (totals.live_count >= SLOT_LIMIT)
+    {
+        totals.untracked++;
+        mem_unlock();
+        return;
+    }
+
+    Slot slot = {ptr, (uint32_t)size, next_seq++, tag_find(file), (uint16_t)line};
+    slot_insert(&slot);
+
+    MemTagStats *tag = &tags[slot.tag];
+    tag->live_bytes += slot.size;
+    tag->live_count++;
+    tag->total_count++;
+    if (tag->live_bytes > tag->peak_bytes)
+    {
+        tag->peak_bytes = tag->live_bytes;
+    }
+
+    totals.live_bytes += slot.size;
+    totals.live_count++;
+    if (totals.live_bytes > totals.peak_bytes)
+    {
+        totals.peak_bytes = totals.live_bytes;
+    }
+    mem_unlock();
+}
+
+static void tag_subtract(const Slot *slot)
+{
+    MemTagStats *tag = &tags[slot->tag];
+    tag->live_bytes -= slot->size;
+    tag->live_count--;
+    totals.live_bytes -= slot->size;
+    totals.live_count--;
+}
+
+// forgets a block and returns its entry, untracked blocks are ignored
+static bool track_take(const void *ptr, Slot *taken)
+{
+    mem_lock();
+    int i = slot_find(ptr);
+    if (i >= 0)
+    {
+        *taken = slots[i];
+        tag_subtract(taken);
+        slot_remove((uint32_t)i);
+    }
+    mem_unlock();
+    return i >= 0;
+}
+
+// puts back an entry taken for a realloc that failed
+static void track_restore(const Slot *slot)
+{
+    mem_lock();
+    slot_insert(slot);
+    MemTagStats *tag = &tags[slot->tag];
+    tag->live_bytes += slot->size;
+    tag->live_count++;
+    totals.live_bytes += slot->size;
+    totals.live_count++;
+    totals.failed++;
+    mem_unlock();
+}
+
+void *mem_track_malloc(size_t n, const char *file, int line)
+{
+    void *ptr = mem_heap_malloc(n);
+    track_add(ptr, n, file, line);
+    return ptr;
+}
+
+void *mem_track_calloc(size_t nmemb, size_t size, const char *file, int line)
+{
+    void *ptr = mem_heap_calloc(nmemb, size);
+    track_add(ptr, nmemb * size, file, line);
+    return ptr;
+}
+
+void *mem_track_realloc(void *ptr, size_t n, const char *file, int line)
+{
+    if (!ptr)
+    {
+        return mem_track_malloc(n, file, line);
+    }
+    if (n == 0)
+    {
+        mem_track_free(ptr);
+        return NULL;
+    }
+
+    // untrack first, another task may be handed the old address once it is freed
+    Slot old;
+    bool tracked = track_take(ptr, &old);
+    void *newp = mem_heap_realloc(ptr, n);
+    if (!newp)
+    {
+        // the old block is untouched
+        if (tracked)
+        {
+            track_restore(&old);
+        }
+        else
+        {
+            track_add(NULL, n, file, line);
+        }
+        return NULL;
+    }
+    track_add(newp, n, file, line);
+    return newp;
+}
+
+void mem_track_free(void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+    Slot taken;
+    track_take(ptr, &taken);
+    mem_heap_free(ptr);
+}
+
+bool mem_track_enabled(void)
+{
+    return true;
+}
+
+uint32_t mem_track_mark(void)
+{
+    mem_lock();
+    uint32_t mark = next_seq;
+    mem_unlock();
+    return mark;
+}
+
+uint32_t mem_track_seq_of(const void *ptr)
+{
+    mem_lock();
+    int i = ptr ? slot_find(ptr) : -1;
+    uint32_t seq = i >= 0 ? slots[i].seq : next_seq;
+    mem_unlock();
+    return seq;
+}
+
+int mem_track_leaks(uint32_t mark, MemBlockInfo *blocks, int max, uint32_t *bytes)
+{
+    int count = 0;
+    int kept = 0;
+    uint32_t total = 0;
+
+    mem_lock();
+    for (int i = 0; i < MEM_TRACK_MAX_ALLOCS; i++)
+    {
+        const Slot *slot = &slots[i];
+        if (!slot->ptr || slot->seq < mark)
+        {
+            continue;
+        }
+        count++;
+        total += slot->size;
+        if (!blocks || max <= 0)
+        {
+            continue;
+        }
+
+        // keep the oldest, sorted by sequence
+        int pos = kept;
+        while (pos > 0 && blocks[pos - 1].seq > slot->seq)
+        {
+            pos--;
+        }
+        if (pos >= max)
+        {
+            continue;
+        }
+        int last = kept < max ? kept : max - 1;
+        memmove(&blocks[pos + 1], &blocks[pos], (size_t)(last - pos) * sizeof(blocks[0]));
+        blocks[pos] = (MemBlockInfo){tags[slot->tag].tag, slot->size, slot->seq, slot->line};
+        if (kept < max)
+        {
+            kept++;
+        }
+    }
+    mem_unlock();
+
+    if (bytes)
+    {
+        *bytes = total;
+    }
+    return count;
+}
+
+int mem_track_check_page(uint32_t mark, const char *page)
+{
+    MemLeakReport report;
+    report.page = page ? page : "?";
+    report.count = (uint32_t)mem_track_leaks(mark, report.blocks, MEM_LEAK_REPORT_LEN, &report.bytes);
+
+    mem_lock();
+    totals.leak_checks++;
+    totals.leaks += report.count;
+    if (report.count > 0)
+    {
+        last_report = report;
+    }
+    mem_unlock();
+    return (int)report.count;
+}
+
+void mem_track_get_leak_report(MemLeakReport *report)
+{
+    if (!report)
+    {
+        return;
+    }
+    mem_lock();
+    *report = last_report;
+    mem_unlock();
+}
+
+int mem_track_get_tags(MemTagStats *out, int max)
+{
+    int count = 0;
+    mem_lock();
+    for (int i = 0; i < tag_count; i++)
+    {
+        // insertion by peak, highest first
+        int pos = count;
+        while (pos > 0 && out[pos - 1].peak_bytes < tags[i].peak_bytes)
+        {
+            pos--;
+        }
+        if (pos >= max)
+        {
+            continue;
+        }
+        int last = count < max ? count : max - 1;
+        memmove(&out[pos + 1], &out[pos], (size_t)(last - pos) * sizeof(out[0]));
+        out[pos] = tags[i];
+        if (count < max)
+        {
+            count++;
+        }
+    }
+    mem_unlock();
+    return count;
+}
+
+void mem_track_get_stats(MemTrackStats *stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+    mem_lock();
+    *stats = totals;
+    mem_unlock();
+}
+
+void mem_track_reset_peaks(void)
+{
+    mem_lock();
+    totals.peak_bytes = totals.live_bytes;
+    for (int i = 0; i < tag_count; i++)
+    {
+        tags[i].peak_bytes = tags[i].live_bytes;
+    }
+    mem_unlock();
+}
+
+#else
+
+// without MEM_TRACKING the wrappers only forward, and nothing is reported
+void *mem_track_malloc(size_t n, const char *file, int line)
+{
+    (void)file;
+    (void)line;
+    return mem_heap_malloc(n);
+}
+
+void *mem_track_calloc(size_t nmemb, size_t size, const char *file, int line)
+{
+    (void)file;
+    (void)line;
+    return mem_heap_calloc(nmemb, size);
+}
+
+void *mem_track_realloc(void *ptr, size_t n, const char *file, int line)
+{
+    (void)file;
+    (void)line;
+    return mem_heap_realloc(ptr, n);
+}
+
+void mem_track_free(void *ptr)
+{
+    mem_heap_free(ptr);
+}
+
+bool mem_track_enabled(void)
+{
+    return false;
+}
+
+uint32_t mem_track_mark(void)
+{
+    return 0;
+}
+
+uint32_t mem_track_seq_of(const void *ptr)
+{
+    (void)ptr;
+    return 0;
+}
+
+int mem_track_leaks(uint32_t mark, MemBlockInfo *blocks, int max, uint32_t *bytes)
+{
+    (void)mark;
+    (void)blocks;
+    (void)max;
+    if (bytes)
+    {
+        *bytes = 0;
+    }
+    return 0;
+}
+
+int mem_track_check_page(uint32_t mark, const char *page)
+{
+    (void)mark;
+    (void)page;
+    return 0;
+}
+
+void mem_track_get_leak_report(MemLeakReport *report)
+{
+    if (report)
+    {
+        memset(report, 0, sizeof(*report));
+    }
+}
+
+int mem_track_get_tags(MemTagStats *tags, int max)
+{
+    (void)tags;
+    (void)max;
+    return 0;
+}
+
+void mem_track_get_stats(MemTrackStats *stats)
+{
+    if (stats)
+    {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+void mem_track_reset_peaks(void)
+{
+}
+
+#endif
@@ -0,0 +1,214 @@
+#include "msg_pool.h"
+#include <string.h>
+
+#if defined(USE_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#else
+#include <pthread.h>
+#endif
+
+typedef struct
+{
+    uint16_t type; // MsgType, MSG_TYPE_NONE while free
+    uint16_t refs;
+    uint16_t size;
+    uint16_t next; // free list link, only meaningful while free
+} MsgHeader;
+
+typedef struct
+{
+    MsgHeader header;
+    union
+    {
+        uint8_t bytes[MSG_POOL_PAYLOAD_SIZE];
+        uint64_t align;
+    } payload;
+} MsgBlock;
+
+#define FREE_END 0xFFFF
+
+static MsgBlock pool[MSG_POOL_BLOCKS];
+static uint16_t free_head = FREE_END;
+static MsgPoolStats stats;
+
+/* ===== LOCKING ===== */
+#if defined(USE_FREERTOS)
+typedef UBaseType_t pool_lock_t;
+
+static pool_lock_t pool_lock(void)
+{
+    if (xPortIsInsideInterrupt())
+    {
+        return taskENTER_CRITICAL_FROM_ISR();
+    }
+    taskENTER_CRITICAL();
+    return 0;
+}
+
+static void pool_unlock(pool_lock_t saved)
+{
+    if (xPortIsInsideInterrupt())
+    {
+        taskEXIT_CRITICAL_FROM_ISR(saved);
+    }
+    else
+    {
+        taskEXIT_CRITICAL();
+    }
+}
+#else
+typedef int pool_lock_t;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pool_lock_t pool_lock(void)
+{
+    pthread_mutex_lock(&pool_mutex);
+    return 0;
+}
+
+static void pool_unlock(pool_lock_t saved)
+{
+    (void)saved;
+    pthread_mutex_unlock(&pool_mutex);
+}
+#endif
+
+/* ===== HELPERS ===== */
+
+// Block owning a payload pointer, NULL if the pointer is not a payload start
+static MsgBlock *block_of(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    const uint8_t *first = pool[0].payload.bytes;
+    if (!ptr || p < first || p > pool[MSG_POOL_BLOCKS - 1].payload.bytes)
+    {
+        return NULL;
+    }
+    size_t offset = (size_t)(p - first);
+    if (offset % sizeof(MsgBlock) != 0)
+    {
+        return NULL;
+    }
+    return &pool[offset / sizeof(MsgBlock)];
+}
+
+/* ===== PUBLIC API ===== */
+
+void msg_pool_init(void)
+{
+    pool_lock_t saved = pool_lock();
+    for (uint16_t i = 0; i < MSG_POOL_BLOCKS; i++)
+    {
+        pool[i].header.type = MSG_TYPE_NONE;
+        pool[i].header.refs = 0;
+        pool[i].header.size = 0;
+        pool[i].header.next = (i + 1 < MSG_POOL_BLOCKS) ? i + 1 : FREE_END;
+    }
+    free_head = 0;
+    memset(&stats, 0, sizeof(stats));
+    pool_unlock(saved);
+}
+
+void *msg_alloc(MsgType type, size_t size)
+{
+    void *msg = NULL;
+    pool_lock_t saved = pool_lock();
+
+    if (size > MSG_POOL_PAYLOAD_SIZE || type == MSG_TYPE_NONE)
+    {
+        stats.oversize++;
+    }
+    else if (free_head == FREE_END)
+    {
+        stats.exhausted++;
+    }
+    else
+    {
+        MsgBlock *block = &pool[free_head];
+        free_head = block->header.next;
+        block->header.type = (uint16_t)type;
+        block->header.refs = 1;
+        block->header.size = (uint16_t)size;
+        msg = block->payload.bytes;
+
+        stats.allocs++;
+        if (++stats.in_use > stats.high_water)
+        {
+            stats.high_water = stats.in_use;
+        }
+    }
+
+    pool_unlock(saved);
+    return msg;
+}
+
+void msg_retain(void *msg)
+{
+    MsgBlock *block = block_of(msg);
+    pool_lock_t saved = pool_lock();
+    if (block && block->header.refs > 0 && block->header.refs < UINT16_MAX)
+    {
+        block->header.refs++;
+    }
+    else
+    {
+        stats.bad_releases++;
+    }
+    pool_unlock(saved);
+}
+
+void msg_release(void *msg)
+{
+    if (!msg)
+    {
+        return;
+    }
+
+    MsgBlock *block = block_of(msg);
+    pool_lock_t saved = pool_lock();
+    if (!block || block->header.refs == 0)
+    {
+        // not ours, or already free: a double release
+        stats.bad_releases++;
+    }
+    else if (--block->header.refs == 0)
+    {
+        block->header.type = MSG_TYPE_NONE;
+        block->header.size = 0;
+        block->header.next = free_head;
+        free_head = (uint16_t)(block - pool);
+        stats.releases++;
+        stats.in_use--;
+    }
+    pool_unlock(saved);
+}
+
+bool msg_pool_owns(const void *ptr)
+{
+    return block_of(ptr) != NULL;
+}
+
+MsgType msg_type(const void *msg)
+{
+    MsgBlock *block = block_of(msg);
+    return block ? (MsgType)block->header.type : MSG_TYPE_NONE;
+}
+
+size_t msg_size(const void *msg)
+{
+    MsgBlock *block = block_of(msg);
+    return block ? block->header.size : 0;
+}
+
+void msg_pool_get_stats(MsgPoolStats *out)
+{
+    if (!out)
+    {
+        return;
+    }
+    pool_lock_t saved = pool_lock();
+    *out = stats;
+    pool_unlock(saved);
+}
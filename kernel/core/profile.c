@@ -0,0 +1,226 @@
+#include "profile.h"
+#include <stdio.h>
+#include <string.h>
+
+// CoreDebug->DEMCR and DWT->CTRL, as in trace.c
+#define DEMCR (*(volatile uint32_t *)0xE000EDFCUL)
+#define DWT_CTRL (*(volatile uint32_t *)0xE0001000UL)
+
+// every field on its own, so a sample needs no lock; the minimum is kept
+// inverted so the zeroed table starts at the largest possible minimum, and
+// the total is split in halves with the carry added on overflow
+typedef struct
+{
+    uint32_t count;
+    uint32_t min_inverted;
+    uint32_t max;
+    uint32_t total_lo;
+    uint32_t total_hi;
+    uint32_t buckets[PROFILE_BUCKETS];
+} ProfileZoneSlot;
+
+static ProfileZoneSlot zones[PROFILE_ZONE_COUNT];
+static uint32_t clock_hz = 1000000000u;
+
+static const char *const zone_names[PROFILE_ZONE_COUNT] = {
+    [PROFILE_DISPLAY_FLUSH] = "flush",
+    [PROFILE_GLYPH] = "glyph",
+    [PROFILE_BPTREE_FIND] = "bpt find",
+    [PROFILE_AT_COMMAND] = "at cmd",
+    [PROFILE_PDU_DECODE] = "pdu",
+    [PROFILE_AUDIO_BUFFER] = "audio",
+};
+
+void profile_init(uint32_t hz)
+{
+    clock_hz = hz ? hz : 1;
+#if defined(__arm__)
+    DEMCR |= 1UL << 24; // TRCENA
+    DWT_CTRL |= 1UL;    // CYCCNTENA
+#endif
+    profile_reset();
+}
+
+void profile_reset(void)
+{
+    for (int i = 0; i < PROFILE_ZONE_COUNT; i++)
+    {
+        // the count first, so a reader sees an empty zone rather than a stale mean
+        __atomic_store_n(&zones[i].count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&zones[i].min_inverted, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&zones[i].max, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&zones[i].total_lo, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&zones[i].total_hi, 0, __ATOMIC_RELAXED);
+        for (int b = 0; b < PROFILE_BUCKETS; b++)
+        {
+            __atomic_store_n(&zones[i].buckets[b], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static inline uint32_t bucket_of(uint32_t ticks)
+{
+    return ticks > 1 ? 31u - (uint32_t)__builtin_clz(ticks) : 0;
+}
+
+// raise *field to value unless another writer got there first
+static inline void raise_to(uint32_t *field, uint32_t value)
+{
+    uint32_t seen = __atomic_load_n(field, __ATOMIC_RELAXED);
+    while (value > seen &&
+           !__atomic_compare_exchange_n(field, &seen, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+void profile_record(ProfileZone zone, uint32_t ticks)
+{
+    if ((unsigned)zone >= PROFILE_ZONE_COUNT)
+    {
+        return;
+    }
+    ProfileZoneSlot *slot = &zones[zone];
+    uint32_t lo = __atomic_fetch_add(&slot->total_lo, ticks, __ATOMIC_RELAXED);
+    if (lo + ticks < lo)
+    {
+        __atomic_fetch_add(&slot->total_hi, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&slot->buckets[bucket_of(ticks)], 1, __ATOMIC_RELAXED);
+    raise_to(&slot->min_inverted, ~ticks);
+    raise_to(&slot->max, ticks);
+    __atomic_fetch_add(&slot->count, 1, __ATOMIC_RELAXED);
+}
+
+bool profile_get(ProfileZone zone, ProfileStats *stats)
+{
+    if ((unsigned)zone >= PROFILE_ZONE_COUNT || !stats)
+    {
+        return false;
+    }
+    const ProfileZoneSlot *slot = &zones[zone];
+    stats->count = __atomic_load_n(&slot->count, __ATOMIC_RELAXED);
+    stats->min = stats->count ? ~__atomic_load_n(&slot->min_inverted, __ATOMIC_RELAXED) : 0;
+    stats->max = __atomic_load_n(&slot->max, __ATOMIC_RELAXED);
+    stats->total = ((uint64_t)__atomic_load_n(&slot->total_hi, __ATOMIC_RELAXED) << 32) |
+                   __atomic_load_n(&slot->total_lo, __ATOMIC_RELAXED);
+    for (int b = 0; b < PROFILE_BUCKETS; b++)
+    {
+        stats->buckets[b] = __atomic_load_n(&slot->buckets[b], __ATOMIC_RELAXED);
+    }
+    return true;
+}
+
+const char *profile_zone_name(ProfileZone zone)
+{
+    return (unsigned)zone < PROFILE_ZONE_COUNT ? zone_names[zone] : "?";
+}
+
+uint32_t profile_clock_hz(void)
+{
+    return clock_hz;
+}
+
+uint32_t profile_percentile(const ProfileStats *stats, uint32_t percent)
+{
+    uint32_t samples = 0;
+    for (int b = 0; b < PROFILE_BUCKETS; b++)
+    {
+        samples += stats->buckets[b];
+    }
+    if (samples == 0)
+    {
+        return 0;
+    }
+    if (percent > 100)
+    {
+        percent = 100;
+    }
+    // the sample the percentile falls on, counting from 1
+    uint32_t rank = (uint32_t)(((uint64_t)samples * percent + 99) / 100);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    uint32_t seen = 0;
+    for (int b = 0; b < PROFILE_BUCKETS; b++)
+    {
+        seen += stats->buckets[b];
+        if (seen >= rank)
+        {
+            uint32_t upper = b == PROFILE_BUCKETS - 1 ? UINT32_MAX : (2u << b) - 1;
+            return upper < stats->max ? upper : stats->max;
+        }
+    }
+    return stats->max;
+}
+
+/* ===== REPORT ===== */
+
+// microseconds in at most 5 characters: one decimal below 100, milliseconds from 100000
+static void format_us(char *out, size_t size, uint64_t ticks)
+{
+    uint64_t tenths = ticks * 10000000u / clock_hz;
+    if (tenths < 1000)
+    {
+        snprintf(out, size, "%lu.%lu", (unsigned long)(tenths / 10), (unsigned long)(tenths % 10));
+    }
+    else if (tenths < 1000000)
+    {
+        snprintf(out, size, "%lu", (unsigned long)(tenths / 10));
+    }
+    else
+    {
+        snprintf(out, size, "%lum", (unsigned long)(tenths / 10000));
+    }
+}
+
+// counts in at most 5 characters
+static void format_count(char *out, size_t size, uint32_t count)
+{
+    if (count < 100000)
+    {
+        snprintf(out, size, "%lu", (unsigned long)count);
+    }
+    else if (count < 10000000)
+    {
+        snprintf(out, size, "%luk", (unsigned long)(count / 1000));
+    }
+    else
+    {
+        snprintf(out, size, "%luM", (unsigned long)(count / 1000000));
+    }
+}
+
+int profile_report(ProfileReportLine out, void *arg)
+{
+    char line[PROFILE_REPORT_LINE_MAX];
+    snprintf(line, sizeof(line), "%-8s%6s%6s%6s%6s%6s", "zone us", "count", "min", "mean", "p99", "max");
+    out(line, arg);
+    int lines = 1;
+
+    for (int i = 0; i < PROFILE_ZONE_COUNT; i++)
+    {
+        ProfileStats stats;
+        profile_get((ProfileZone)i, &stats);
+        char count[24], min[24], mean[24], p99[24], max[24];
+        format_count(count, sizeof(count), stats.count);
+        if (stats.count)
+        {
+            format_us(min, sizeof(min), stats.min);
+            format_us(mean, sizeof(mean), stats.total / stats.count);
+            format_us(p99, sizeof(p99), profile_percentile(&stats, 99));
+            format_us(max, sizeof(max), stats.max);
+        }
+        else
+        {
+            strcpy(min, "-");
+            strcpy(mean, "-");
+            strcpy(p99, "-");
+            strcpy(max, "-");
+        }
+        snprintf(line, sizeof(line), "%-8.8s%6.6s%6.6s%6.6s%6.6s%6.6s", zone_names[i], count, min, mean, p99, max);
+        out(line, arg);
+        lines++;
+    }
+    return lines;
+}
@@ -0,0 +1,348 @@
+#include "sampler.h"
+#include <string.h>
+
+#if defined(USE_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+#if defined(__arm__) && defined(USE_FREERTOS)
+#include "stm32h7xx_hal.h"
+#include "stm32_config.h"
+#include "mem_sections.h"
+#include "tickless_idle.h"
+#include "fatfs.h"
+#endif
+
+#define RING_MASK (SAMPLER_RING_SIZE - 1)
+
+typedef struct
+{
+    SamplerRecord records[SAMPLER_RING_SIZE];
+    uint32_t head; // samples taken, written by the timer interrupt only
+    uint32_t rate_hz;
+    volatile bool running;
+} SamplerRing;
+
+static SamplerRing ring;
+
+void sampler_record(uint32_t pc, uint32_t lr, uint32_t task, uint16_t exception)
+{
+    uint32_t index = ring.head;
+    SamplerRecord *rec = &ring.records[index & RING_MASK];
+    rec->pc = pc;
+    rec->lr = lr;
+    rec->task = task;
+    rec->exception = exception;
+    rec->reserved = 0;
+    // the record before the count, so a reader never counts a half-written sample
+    __atomic_store_n(&ring.head, index + 1, __ATOMIC_RELEASE);
+}
+
+void sampler_get_stats(SamplerStats *stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+    uint32_t head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+    stats->taken = head;
+    stats->overwritten = head > SAMPLER_RING_SIZE ? head - SAMPLER_RING_SIZE : 0;
+    stats->capacity = SAMPLER_RING_SIZE;
+    stats->rate_hz = ring.rate_hz;
+    stats->running = ring.running;
+}
+
+/* ===== TIM7 ===== */
+
+#if defined(__arm__) && defined(USE_FREERTOS) && defined(SAMPLER_ENABLED)
+
+// TIM7 counts at 1 MHz, the period sets the rate
+#define SAMPLER_TIMER_HZ 1000000u
+// above configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, so critical sections are sampled
+#define SAMPLER_IRQ_PRIORITY 2
+
+// the stacked exception frame: r0-r3, r12, lr, pc, xpsr
+#define FRAME_LR 5
+#define FRAME_PC 6
+#define FRAME_XPSR 7
+
+void sampler_tick(const uint32_t *frame);
+
+// naked, so the stack pointer and EXC_RETURN are as the hardware left them;
+// bit 2 of EXC_RETURN tells which stack the interrupted code was on
+__attribute__((naked)) void TIM7_IRQHandler(void)
+{
+    __asm volatile("tst lr, #4      \n"
+                   "ite eq          \n"
+                   "mrseq r0, msp   \n"
+                   "mrsne r0, psp   \n"
+                   "b sampler_tick  \n");
+}
+
+void sampler_tick(const uint32_t *frame)
+{
+    TIM7->SR = ~TIM_SR_UIF;
+    // IPSR in the stacked xPSR is the handler that was interrupted, 0 for a task
+    uint16_t exception = (uint16_t)(frame[FRAME_XPSR] & 0x1FFu);
+    uint32_t task = (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle();
+    sampler_record(frame[FRAME_PC], frame[FRAME_LR], task, exception);
+}
+
+// APB1 timers run at twice PCLK1 whenever APB1 is divided
+static uint32_t timer_clock_hz(void)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    return (RCC->D2CFGR & RCC_D2CFGR_D2PPRE1) == RCC_D2CFGR_D2PPRE1_DIV1 ? pclk : pclk * 2;
+}
+
+static void timer_stop(void)
+{
+    TIM7->CR1 = 0;
+    TIM7->DIER = 0;
+    HAL_NVIC_DisableIRQ(TIM7_IRQn);
+    HAL_NVIC_ClearPendingIRQ(TIM7_IRQn);
+}
+
+static void timer_run(void)
+{
+    TIM7->CNT = 0;
+    TIM7->SR = 0;
+    TIM7->DIER = TIM_DIER_UIE;
+    HAL_NVIC_EnableIRQ(TIM7_IRQn);
+    TIM7->CR1 = TIM_CR1_CEN;
+}
+
+bool sampler_start(uint32_t rate_hz)
+{
+    if (rate_hz < SAMPLER_MIN_HZ)
+    {
+        rate_hz = SAMPLER_MIN_HZ;
+    }
+    if (rate_hz > SAMPLER_MAX_HZ)
+    {
+        rate_hz = SAMPLER_MAX_HZ;
+    }
+    uint32_t period = (SAMPLER_TIMER_HZ + rate_hz / 2) / rate_hz;
+
+    __HAL_RCC_TIM7_CLK_ENABLE();
+    timer_stop();
+    TIM7->PSC = timer_clock_hz() / SAMPLER_TIMER_HZ - 1;
+    TIM7->ARR = period - 1;
+    // load the prescaler now rather than at the first update
+    TIM7->EGR = TIM_EGR_UG;
+    HAL_NVIC_SetPriority(TIM7_IRQn, SAMPLER_IRQ_PRIORITY, 0);
+
+    ring.rate_hz = SAMPLER_TIMER_HZ / period;
+    if (!ring.running)
+    {
+        // Stop mode halts TIM7, sleeps stay in WFI while sampling
+        tickless_stop_hold();
+        ring.running = true;
+    }
+    timer_run();
+    return true;
+}
+
+void sampler_stop(void)
+{
+    if (!ring.running)
+    {
+        return;
+    }
+    timer_stop();
+    ring.running = false;
+    tickless_stop_release();
+}
+
+static void pause(bool *was_running)
+{
+    *was_running = ring.running;
+    if (*was_running)
+    {
+        timer_stop();
+    }
+}
+
+static void resume(bool was_running)
+{
+    if (was_running)
+    {
+        timer_run();
+    }
+}
+
+#else
+
+bool sampler_start(uint32_t rate_hz)
+{
+    // no timer to sample from, or TIM7 left to others
+    (void)rate_hz;
+    return false;
+}
+
+void sampler_stop(void)
+{
+}
+
+static void pause(bool *was_running)
+{
+    *was_running = false;
+}
+
+static void resume(bool was_running)
+{
+    (void)was_running;
+}
+
+#endif
+
+void sampler_init(void)
+{
+    sampler_stop();
+    memset(&ring, 0, sizeof(ring));
+}
+
+/* ===== DUMP ===== */
+
+typedef struct
+{
+    SamplerWriteFn write;
+    void *arg;
+    uint32_t sum;
+    size_t bytes;
+    bool ok;
+} DumpWriter;
+
+static void dump_put(DumpWriter *w, const void *data, size_t len)
+{
+    if (!w->ok)
+    {
+        return;
+    }
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++)
+    {
+        w->sum += bytes[i];
+    }
+    w->ok = w->write(data, len, w->arg);
+    w->bytes += len;
+}
+
+// the kernel's task list, read when the dump is taken
+static uint16_t collect_names(SamplerName *names)
+{
+#if defined(USE_FREERTOS)
+    static TaskStatus_t status[SAMPLER_MAX_TASKS];
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    {
+        return 0;
+    }
+    // the list is only returned whole, a full table leaves the names out
+    UBaseType_t count = uxTaskGetSystemState(status, SAMPLER_MAX_TASKS, NULL);
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        memset(&names[i], 0, sizeof(names[i]));
+        names[i].task = (uint32_t)(uintptr_t)status[i].xHandle;
+        strncpy(names[i].name, status[i].pcTaskName, SAMPLER_NAME_LEN - 1);
+    }
+    return (uint16_t)count;
+#else
+    (void)names;
+    return 0;
+#endif
+}
+
+size_t sampler_dump(SamplerWriteFn write, void *arg)
+{
+    bool was_running;
+    pause(&was_running);
+
+    static SamplerName names[SAMPLER_MAX_TASKS];
+    uint16_t name_count = collect_names(names);
+
+    uint32_t head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+    uint32_t count = head < SAMPLER_RING_SIZE ? head : SAMPLER_RING_SIZE;
+
+    SamplerDumpHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SAMPLER_DUMP_MAGIC, sizeof(header.magic));
+    header.version = SAMPLER_DUMP_VERSION;
+    header.record_size = sizeof(SamplerRecord);
+    header.rate_hz = ring.rate_hz;
+    header.capacity = SAMPLER_RING_SIZE;
+    header.taken = head;
+    header.count = count;
+    header.name_count = name_count;
+    header.name_size = sizeof(SamplerName);
+
+    DumpWriter w = {write, arg, 0, 0, true};
+    dump_put(&w, &header, sizeof(header));
+    dump_put(&w, names, name_count * sizeof(SamplerName));
+
+    // oldest first, the split at the ring's end is written in two pieces
+    uint32_t first = (head - count) & RING_MASK;
+    uint32_t run = SAMPLER_RING_SIZE - first < count ? SAMPLER_RING_SIZE - first : count;
+    dump_put(&w, &ring.records[first], run * sizeof(SamplerRecord));
+    dump_put(&w, &ring.records[0], (count - run) * sizeof(SamplerRecord));
+
+    uint32_t sum = w.sum;
+    dump_put(&w, SAMPLER_DUMP_END, 4);
+    dump_put(&w, &sum, sizeof(sum));
+
+    resume(was_running);
+    return w.ok ? w.bytes : 0;
+}
+
+#if defined(__arm__) && defined(USE_FREERTOS)
+
+static bool file_write(const void *data, size_t len, void *arg)
+{
+    UINT written;
+    return f_write((FIL *)arg, data, len, &written) == FR_OK && written == len;
+}
+
+bool sampler_save(const char *path)
+{
+    // FIL holds a sector buffer that SDMMC IDMA fills, so it lives in the DMA region
+    static FIL file DMA_BUFFER;
+    if (f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    {
+        return false;
+    }
+    size_t bytes = sampler_dump(file_write, &file);
+    return f_close(&file) == FR_OK && bytes > 0;
+}
+
+#if defined(DEBUG_UART_HANDLE)
+extern UART_HandleTypeDef DEBUG_UART_HANDLE;
+
+static bool uart_write(const void *data, size_t len, void *arg)
+{
+    (void)arg;
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (len > 0)
+    {
+        uint16_t chunk = len > 0xFFFF ? 0xFFFF : (uint16_t)len;
+        if (HAL_UART_Transmit(&DEBUG_UART_HANDLE, (uint8_t *)bytes, chunk, 1000) != HAL_OK)
+        {
+            return false;
+        }
+        bytes += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+bool sampler_send_uart(void)
+{
+    return sampler_dump(uart_write, NULL) > 0;
+}
+#else
+bool sampler_send_uart(void)
+{
+    // the board config names no debug UART
+    return false;
+}
+#endif
+
+#endif
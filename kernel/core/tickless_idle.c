@@ -0,0 +1,317 @@
+#include "tickless_idle.h"
+#include <string.h>
+
+#if defined(__arm__) && defined(USE_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32h7xx_hal.h"
+#include "trace.h"
+#endif
+
+/* ===== TICK CONVERSION ===== */
+
+// partial ticks arrive in 1/65536 of a tick, carry is kept in counts * tick_hz units
+static uint32_t partial_units(const TicklessClock *clock, uint32_t partial)
+{
+    return (uint32_t)(((uint64_t)partial * clock->counter_hz) >> 16);
+}
+
+void tickless_clock_init(TicklessClock *clock, uint32_t counter_hz, uint32_t tick_hz, uint32_t max_counts)
+{
+    clock->counter_hz = counter_hz;
+    clock->tick_hz = tick_hz;
+    clock->max_counts = max_counts;
+    clock->carry = 0;
+}
+
+uint32_t tickless_max_ticks(const TicklessClock *clock)
+{
+    // keep one tick of headroom for the carried fraction
+    uint32_t ticks = (uint32_t)(((uint64_t)clock->max_counts * clock->tick_hz) / clock->counter_hz);
+    return ticks > 1 ? ticks - 1 : 1;
+}
+
+uint32_t tickless_counts_for(const TicklessClock *clock, uint32_t ticks, uint32_t partial)
+{
+    uint32_t max_ticks = tickless_max_ticks(clock);
+    if (ticks > max_ticks)
+    {
+        ticks = max_ticks;
+    }
+
+    uint64_t needed = (uint64_t)ticks * clock->counter_hz;
+    uint64_t credit = (uint64_t)clock->carry + partial_units(clock, partial);
+    if (needed <= credit)
+    {
+        return 1;
+    }
+    uint64_t counts = (needed - credit + clock->tick_hz - 1) / clock->tick_hz;
+    if (counts < 1)
+    {
+        counts = 1;
+    }
+    return counts > clock->max_counts ? clock->max_counts : (uint32_t)counts;
+}
+
+uint32_t tickless_ticks_elapsed(TicklessClock *clock, uint32_t counts, uint32_t partial, uint32_t limit)
+{
+    uint64_t total = (uint64_t)counts * clock->tick_hz + clock->carry + partial_units(clock, partial);
+    uint64_t ticks = total / clock->counter_hz;
+    uint64_t rest = total % clock->counter_hz;
+
+    if (ticks > limit)
+    {
+        // the RTOS cannot be stepped past its next wake, keep less than a tick of the excess
+        rest = total - (uint64_t)limit * clock->counter_hz;
+        if (rest >= clock->counter_hz)
+        {
+            rest = clock->counter_hz - 1;
+        }
+        ticks = limit;
+    }
+    clock->carry = (uint32_t)rest;
+    return (uint32_t)ticks;
+}
+
+#if defined(__arm__) && defined(USE_FREERTOS)
+
+/* ===== LPTIM1 ===== */
+
+// LSI divided by 8, 4 kHz: four counts per tick and up to 16 s per sleep
+#define LPTIM_PRESCALER (LPTIM_CFGR_PRESC_0 | LPTIM_CFGR_PRESC_1)
+#define LPTIM_HZ (LSI_VALUE / 8)
+#define LPTIM_MAX_COUNTS 0xFFFEU
+
+static TicklessClock lptim_clock;
+static TicklessStats stats;
+static volatile uint32_t stop_holds;
+
+void LPTIM1_IRQHandler(void)
+{
+    TRACE_ISR_ENTER();
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+    TRACE_ISR_EXIT();
+}
+
+void tickless_idle_init(void)
+{
+    tickless_clock_init(&lptim_clock, LPTIM_HZ, configTICK_RATE_HZ, LPTIM_MAX_COUNTS);
+    memset(&stats, 0, sizeof(stats));
+
+    __HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSI);
+    __HAL_RCC_LPTIM1_CLK_ENABLE();
+
+    // CFGR and IER are only writable while disabled, ARR only while enabled; ARR survives disabling
+    LPTIM1->CR = 0;
+    LPTIM1->CFGR = LPTIM_PRESCALER;
+    LPTIM1->IER = LPTIM_IER_CMPMIE;
+    LPTIM1->CR = LPTIM_CR_ENABLE;
+    LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+    LPTIM1->ARR = 0xFFFF;
+    while (!(LPTIM1->ISR & LPTIM_ISR_ARROK))
+    {
+    }
+    LPTIM1->CR = 0;
+
+    // LPTIM1 reaches the core through EXTI line 47, which has to be unmasked to end Stop mode
+    EXTI_D1->IMR2 |= EXTI_IMR2_IM47;
+    HAL_NVIC_SetPriority(LPTIM1_IRQn, configLIBRARY_LOWEST_INTERRUPT_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(LPTIM1_IRQn);
+}
+
+static void lptim_start(uint32_t counts)
+{
+    LPTIM1->CR = LPTIM_CR_ENABLE;
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF | LPTIM_ICR_CMPOKCF;
+    LPTIM1->CMP = counts;
+    while (!(LPTIM1->ISR & LPTIM_ISR_CMPOK))
+    {
+    }
+    LPTIM1->CR |= LPTIM_CR_CNTSTRT;
+}
+
+// returns the counts since lptim_start(), the counter runs asynchronously so read until stable
+static uint32_t lptim_stop(bool *fired)
+{
+    uint32_t counts, again;
+    do
+    {
+        counts = LPTIM1->CNT;
+        again = LPTIM1->CNT;
+    } while (counts != again);
+
+    *fired = (LPTIM1->ISR & LPTIM_ISR_CMPM) != 0;
+    if (*fired)
+    {
+        counts = LPTIM1->CMP > counts ? LPTIM1->CMP : counts;
+    }
+    LPTIM1->CR = 0;
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+    NVIC_ClearPendingIRQ(LPTIM1_IRQn);
+    return counts;
+}
+
+/* ===== STOP MODE ===== */
+
+// Stop mode switches the system to the HSI and turns the PLLs off
+static void restore_clocks(uint32_t pll_on)
+{
+    while (!__HAL_PWR_GET_FLAG(PWR_FLAG_VOSRDY))
+    {
+    }
+
+    uint32_t ready = 0;
+    ready |= (pll_on & RCC_CR_PLL1ON) ? RCC_CR_PLL1RDY : 0;
+    ready |= (pll_on & RCC_CR_PLL2ON) ? RCC_CR_PLL2RDY : 0;
+    ready |= (pll_on & RCC_CR_PLL3ON) ? RCC_CR_PLL3RDY : 0;
+    RCC->CR |= pll_on;
+    while ((RCC->CR & ready) != ready)
+    {
+    }
+
+    if (pll_on & RCC_CR_PLL1ON)
+    {
+        __HAL_RCC_SYSCLK_CONFIG(RCC_SYSCLKSOURCE_PLLCLK);
+        while (__HAL_RCC_GET_SYSCLK_SOURCE() != RCC_SYSCLKSOURCE_STATUS_PLLCLK)
+        {
+        }
+    }
+}
+
+/* ===== FREERTOS HOOK ===== */
+
+void vPortSuppressTicksAndSleep(TickType_t expected)
+{
+    uint32_t max_ticks = tickless_max_ticks(&lptim_clock);
+    if (expected > max_ticks)
+    {
+        expected = max_ticks;
+    }
+
+    __disable_irq();
+    __DSB();
+    __ISB();
+
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+    {
+        stats.aborted++;
+        __enable_irq();
+        return;
+    }
+
+    // stop both 1 kHz time bases, keeping the part of a tick the SysTick already counted
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    uint32_t load = SysTick->LOAD;
+    uint32_t partial = (uint32_t)(((uint64_t)(load - SysTick->VAL) << 16) / (load + 1));
+    HAL_SuspendTick();
+
+    lptim_start(tickless_counts_for(&lptim_clock, expected, partial));
+
+    bool stop = expected >= TICKLESS_STOP_MIN_TICKS && stop_holds == 0;
+    TRACE_BEGIN(TRACE_IDLE_SLEEP, expected, stop);
+    if (stop)
+    {
+        uint32_t pll_on = RCC->CR & (RCC_CR_PLL1ON | RCC_CR_PLL2ON | RCC_CR_PLL3ON);
+        HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+        restore_clocks(pll_on);
+    }
+    else
+    {
+        __DSB();
+        __WFI();
+        __ISB();
+    }
+
+    bool fired;
+    uint32_t counts = lptim_stop(&fired);
+    uint32_t ticks = tickless_ticks_elapsed(&lptim_clock, counts, partial, expected);
+    // CYCCNT stops with the core clock in Stop mode, the decoder adds the ticks back
+    TRACE_END(TRACE_IDLE_SLEEP, ticks, fired);
+
+    stats.sleeps++;
+    stats.sleep_ticks += ticks;
+    if (stop)
+    {
+        stats.stops++;
+        stats.stop_ticks += ticks;
+    }
+    else if (expected >= TICKLESS_STOP_MIN_TICKS)
+    {
+        stats.vetoed++;
+    }
+    if (!fired)
+    {
+        stats.early_wakes++;
+    }
+
+    // HAL_GetTick() keeps counting milliseconds across the sleep
+    uwTick += ticks * (1000U / configTICK_RATE_HZ);
+
+    // step all but the last tick and let the SysTick handler count that one
+    // now, so tasks due at the wake time are unblocked straight away
+    if (ticks > 0)
+    {
+        vTaskStepTick(ticks - 1);
+        SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+    }
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    HAL_ResumeTick();
+
+    __enable_irq();
+}
+
+void tickless_stop_hold(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stop_holds++;
+    __set_PRIMASK(primask);
+}
+
+void tickless_stop_release(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (stop_holds > 0)
+    {
+        stop_holds--;
+    }
+    __set_PRIMASK(primask);
+}
+
+void tickless_get_stats(TicklessStats *stats_out)
+{
+    if (!stats_out)
+    {
+        return;
+    }
+    taskENTER_CRITICAL();
+    *stats_out = stats;
+    taskEXIT_CRITICAL();
+}
+
+#else
+
+// host builds have no tick to suppress
+void tickless_idle_init(void)
+{
+}
+
+void tickless_stop_hold(void)
+{
+}
+
+void tickless_stop_release(void)
+{
+}
+
+void tickless_get_stats(TicklessStats *stats)
+{
+    if (stats)
+    {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+#endif
@@ -0,0 +1,582 @@
+#include "tlsf_heap.h"
+#include <string.h>
+
+#if TLSF_FL_COUNT < 1 || TLSF_FL_COUNT > 31
+#error "TLSF_FL_MAX_LOG2 must give 1 to 31 first-level lists"
+#endif
+
+// prev_phys and size form the header of every block, the free list links
+// overlay the first bytes of the payload while the block is free
+struct TlsfBlock
+{
+    TlsfBlock *prev_phys; // block just below in memory, NULL for the first
+    size_t size;          // payload bytes, a multiple of TLSF_ALIGN, bit 0 set while free
+    TlsfBlock *next_free;
+    TlsfBlock *prev_free;
+};
+
+#define BLOCK_FREE ((size_t)1)
+#define HEADER_SIZE offsetof(TlsfBlock, next_free)
+#define BLOCK_MIN (sizeof(TlsfBlock) - HEADER_SIZE)
+#define BLOCK_MAX (((size_t)1 << TLSF_FL_MAX_LOG2) - TLSF_ALIGN)
+
+/* ===== HELPERS ===== */
+
+static inline int fls32(uint32_t x) { return 31 - __builtin_clz(x); }
+static inline int ffs32(uint32_t x) { return __builtin_ctz(x); }
+
+static inline size_t block_size(const TlsfBlock *b) { return b->size & ~BLOCK_FREE; }
+static inline bool block_is_free(const TlsfBlock *b) { return (b->size & BLOCK_FREE) != 0; }
+static inline void *block_payload(const TlsfBlock *b) { return (uint8_t *)b + HEADER_SIZE; }
+static inline TlsfBlock *block_of(const void *ptr) { return (TlsfBlock *)((uint8_t *)ptr - HEADER_SIZE); }
+
+static inline TlsfBlock *block_next(const TlsfBlock *b)
+{
+    return (TlsfBlock *)((uint8_t *)block_payload(b) + block_size(b));
+}
+
+// request rounded up to a block size, 0 if it cannot be served
+static size_t adjust_size(size_t size)
+{
+    if (size == 0 || size > BLOCK_MAX)
+    {
+        return 0;
+    }
+    size = (size + TLSF_ALIGN - 1) & ~((size_t)TLSF_ALIGN - 1);
+    return size < BLOCK_MIN ? BLOCK_MIN : size;
+}
+
+// list a block of this size lives in
+static void mapping_insert(size_t size, int *fl, int *sl)
+{
+    if (size < TLSF_SMALL_SIZE)
+    {
+        *fl = 0;
+        *sl = (int)(size / TLSF_ALIGN);
+    }
+    else
+    {
+        int f = fls32((uint32_t)size);
+        *sl = (int)((size >> (f - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT);
+        *fl = f - TLSF_FL_SHIFT + 1;
+    }
+}
+
+// first list whose every block is at least this size
+static void mapping_search(size_t size, int *fl, int *sl)
+{
+    if (size >= TLSF_SMALL_SIZE)
+    {
+        size += ((size_t)1 << (fls32((uint32_t)size) - TLSF_SL_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+/* ===== FREE LISTS ===== */
+
+static void list_remove(TlsfHeap *heap, TlsfBlock *b, int fl, int sl)
+{
+    TlsfBlock *prev = b->prev_free;
+    TlsfBlock *next = b->next_free;
+    if (next)
+    {
+        next->prev_free = prev;
+    }
+    if (prev)
+    {
+        prev->next_free = next;
+    }
+    else
+    {
+        heap->blocks[fl][sl] = next;
+        if (!next)
+        {
+            heap->sl_bitmap[fl] &= ~(1u << sl);
+            if (!heap->sl_bitmap[fl])
+            {
+                heap->fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+    heap->stats.free_bytes -= block_size(b);
+    heap->stats.free_blocks--;
+}
+
+static void free_remove(TlsfHeap *heap, TlsfBlock *b)
+{
+    int fl, sl;
+    mapping_insert(block_size(b), &fl, &sl);
+    list_remove(heap, b, fl, sl);
+}
+
+static void free_insert(TlsfHeap *heap, TlsfBlock *b)
+{
+    int fl, sl;
+    mapping_insert(block_size(b), &fl, &sl);
+    TlsfBlock *head = heap->blocks[fl][sl];
+    b->next_free = head;
+    b->prev_free = NULL;
+    if (head)
+    {
+        head->prev_free = b;
+    }
+    heap->blocks[fl][sl] = b;
+    heap->sl_bitmap[fl] |= 1u << sl;
+    heap->fl_bitmap |= 1u << fl;
+    heap->stats.free_bytes += block_size(b);
+    heap->stats.free_blocks++;
+}
+
+// head of the first non-empty list at or above (fl, sl), which it updates
+static TlsfBlock *free_find(const TlsfHeap *heap, int *fl, int *sl)
+{
+    if (*fl >= TLSF_FL_COUNT)
+    {
+        return NULL;
+    }
+    uint32_t sl_map = heap->sl_bitmap[*fl] & (~0u << *sl);
+    if (!sl_map)
+    {
+        uint32_t fl_map = heap->fl_bitmap & (~0u << (*fl + 1));
+        if (!fl_map)
+        {
+            return NULL;
+        }
+        *fl = ffs32(fl_map);
+        sl_map = heap->sl_bitmap[*fl];
+    }
+    *sl = ffs32(sl_map);
+    return heap->blocks[*fl][*sl];
+}
+
+/* ===== BLOCKS ===== */
+
+// fold a free upper neighbour into b
+static void absorb_next(TlsfHeap *heap, TlsfBlock *b)
+{
+    TlsfBlock *next = block_next(b);
+    free_remove(heap, next);
+    b->size += HEADER_SIZE + block_size(next);
+    block_next(b)->prev_phys = b;
+}
+
+// cut a used block down to size and give the rest back to the free lists
+static void trim_used(TlsfHeap *heap, TlsfBlock *b, size_t size)
+{
+    size_t have = block_size(b);
+    if (have < size + HEADER_SIZE + BLOCK_MIN)
+    {
+        return;
+    }
+
+    TlsfBlock *rest = (TlsfBlock *)((uint8_t *)block_payload(b) + size);
+    rest->prev_phys = b;
+    rest->size = (have - size - HEADER_SIZE) | BLOCK_FREE;
+    b->size = size;
+    block_next(rest)->prev_phys = rest;
+    if (block_is_free(block_next(rest)))
+    {
+        absorb_next(heap, rest);
+    }
+    free_insert(heap, rest);
+}
+
+static void note_low_water(TlsfHeap *heap)
+{
+    if (heap->stats.free_bytes < heap->stats.min_ever_free)
+    {
+        heap->stats.min_ever_free = heap->stats.free_bytes;
+    }
+}
+
+/* ===== API ===== */
+
+bool tlsf_heap_init(TlsfHeap *heap, void *mem, size_t bytes)
+{
+    if (!heap || !mem || ((uintptr_t)mem & (TLSF_ALIGN - 1)))
+    {
+        return false;
+    }
+    memset(heap, 0, sizeof(*heap));
+    bytes &= ~((size_t)TLSF_ALIGN - 1);
+
+    // one free block, then a zero-size used block that stops merges at the end
+    if (bytes < 2 * HEADER_SIZE + BLOCK_MIN)
+    {
+        return false;
+    }
+    size_t size = bytes - 2 * HEADER_SIZE;
+    if (size > BLOCK_MAX)
+    {
+        return false;
+    }
+
+    TlsfBlock *b = (TlsfBlock *)mem;
+    b->prev_phys = NULL;
+    b->size = size | BLOCK_FREE;
+    TlsfBlock *end = block_next(b);
+    end->prev_phys = b;
+    end->size = 0;
+
+    heap->first = b;
+    heap->stats.total_bytes = size;
+    heap->stats.min_ever_free = size;
+    free_insert(heap, b);
+    return true;
+}
+
+void *tlsf_heap_malloc(TlsfHeap *heap, size_t size)
+{
+    size_t adjusted = adjust_size(size);
+    if (adjusted == 0)
+    {
+        if (size)
+        {
+            heap->stats.failed++;
+        }
+        return NULL;
+    }
+
+    int fl, sl;
+    mapping_search(adjusted, &fl, &sl);
+    TlsfBlock *b = free_find(heap, &fl, &sl);
+    if (!b)
+    {
+        // the rounded search skips the request's own list, whose head may
+        // still fit: this is what lets a near-full-heap request succeed
+        mapping_insert(adjusted, &fl, &sl);
+        b = heap->blocks[fl][sl];
+        if (!b || block_size(b) < adjusted)
+        {
+            heap->stats.failed++;
+            return NULL;
+        }
+    }
+
+    list_remove(heap, b, fl, sl);
+    b->size &= ~BLOCK_FREE;
+    trim_used(heap, b, adjusted);
+
+    heap->stats.used_blocks++;
+    heap->stats.allocs++;
+    note_low_water(heap);
+    return block_payload(b);
+}
+
+void tlsf_heap_free(TlsfHeap *heap, void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+    TlsfBlock *b = block_of(ptr);
+    heap->stats.used_blocks--;
+    heap->stats.frees++;
+
+    if (b->prev_phys && block_is_free(b->prev_phys))
+    {
+        TlsfBlock *prev = b->prev_phys;
+        free_remove(heap, prev);
+        prev->size += HEADER_SIZE + block_size(b);
+        block_next(prev)->prev_phys = prev;
+        b = prev;
+    }
+    if (block_is_free(block_next(b)))
+    {
+        absorb_next(heap, b);
+    }
+    b->size |= BLOCK_FREE;
+    free_insert(heap, b);
+}
+
+void *tlsf_heap_realloc(TlsfHeap *heap, void *ptr, size_t size)
+{
+    if (!ptr)
+    {
+        return tlsf_heap_malloc(heap, size);
+    }
+    if (size == 0)
+    {
+        tlsf_heap_free(heap, ptr);
+        return NULL;
+    }
+
+    size_t adjusted = adjust_size(size);
+    if (adjusted == 0)
+    {
+        heap->stats.failed++;
+        return NULL;
+    }
+
+    TlsfBlock *b = block_of(ptr);
+    size_t have = block_size(b);
+    TlsfBlock *next = block_next(b);
+    bool next_free = block_is_free(next);
+
+    if (adjusted <= have || (next_free && have + HEADER_SIZE + block_size(next) >= adjusted))
+    {
+        if (adjusted > have)
+        {
+            absorb_next(heap, b);
+        }
+        trim_used(heap, b, adjusted);
+        heap->stats.realloc_kept++;
+        note_low_water(heap);
+        return ptr;
+    }
+
+    void *moved = tlsf_heap_malloc(heap, size);
+    if (moved)
+    {
+        memcpy(moved, ptr, have);
+        tlsf_heap_free(heap, ptr);
+    }
+    return moved;
+}
+
+size_t tlsf_heap_usable_size(const void *ptr)
+{
+    return ptr ? block_size(block_of(ptr)) : 0;
+}
+
+void tlsf_heap_get_stats(const TlsfHeap *heap, TlsfStats *stats)
+{
+    *stats = heap->stats;
+    stats->largest_free = 0;
+    stats->smallest_free = 0;
+    if (!heap->fl_bitmap)
+    {
+        return;
+    }
+
+    // only the highest and lowest lists need scanning, each spans one size step
+    int fl = fls32(heap->fl_bitmap);
+    for (const TlsfBlock *b = heap->blocks[fl][fls32(heap->sl_bitmap[fl])]; b; b = b->next_free)
+    {
+        if (block_size(b) > stats->largest_free)
+        {
+            stats->largest_free = block_size(b);
+        }
+    }
+    fl = ffs32(heap->fl_bitmap);
+    stats->smallest_free = stats->largest_free;
+    for (const TlsfBlock *b = heap->blocks[fl][ffs32(heap->sl_bitmap[fl])]; b; b = b->next_free)
+    {
+        if (block_size(b) < stats->smallest_free)
+        {
+            stats->smallest_free = block_size(b);
+        }
+    }
+}
+
+bool tlsf_heap_check(const TlsfHeap *heap)
+{
+    // physical walk: links, flags, no two free neighbours, sizes add up
+    size_t free_bytes = 0, free_blocks = 0, used_blocks = 0;
+    const TlsfBlock *prev = NULL;
+    const TlsfBlock *b = heap->first;
+    const uint8_t *end = (const uint8_t *)heap->first + HEADER_SIZE + heap->stats.total_bytes;
+    while ((const uint8_t *)b < end)
+    {
+        if (b->prev_phys != prev || block_size(b) < BLOCK_MIN || (block_size(b) & (TLSF_ALIGN - 1)))
+        {
+            return false;
+        }
+        if (block_is_free(b))
+        {
+            if (prev && block_is_free(prev))
+            {
+                return false;
+            }
+            int fl, sl;
+            mapping_insert(block_size(b), &fl, &sl);
+            const TlsfBlock *it = heap->blocks[fl][sl];
+            while (it && it != b)
+            {
+                it = it->next_free;
+            }
+            if (!it)
+            {
+                return false;
+            }
+            free_bytes += block_size(b);
+            free_blocks++;
+        }
+        else
+        {
+            used_blocks++;
+        }
+        prev = b;
+        b = block_next(b);
+    }
+    if ((const uint8_t *)b != end || b->prev_phys != prev || b->size != 0)
+    {
+        return false;
+    }
+    if (prev && block_is_free(prev) && block_is_free(b))
+    {
+        return false;
+    }
+
+    // every list entry is a free block of the right size class, bitmaps agree
+    size_t listed = 0;
+    for (int fl = 0; fl < TLSF_FL_COUNT; fl++)
+    {
+        for (int sl = 0; sl < TLSF_SL_COUNT; sl++)
+        {
+            const TlsfBlock *head = heap->blocks[fl][sl];
+            bool bit = (heap->sl_bitmap[fl] >> sl) & 1u;
+            if (bit != (head != NULL))
+            {
+                return false;
+            }
+            const TlsfBlock *back = NULL;
+            for (const TlsfBlock *it = head; it; it = it->next_free)
+            {
+                int f, s;
+                mapping_insert(block_size(it), &f, &s);
+                if (!block_is_free(it) || it->prev_free != back || f != fl || s != sl)
+                {
+                    return false;
+                }
+                back = it;
+                listed++;
+            }
+        }
+        if (((heap->fl_bitmap >> fl) & 1u) != (heap->sl_bitmap[fl] != 0))
+        {
+            return false;
+        }
+    }
+
+    return listed == free_blocks && free_blocks == heap->stats.free_blocks &&
+           free_bytes == heap->stats.free_bytes && used_blocks == heap->stats.used_blocks;
+}
+
+/* ===== FREERTOS HEAP ===== */
+
+#if defined(HEAP_TLSF) && defined(USE_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if (configAPPLICATION_ALLOCATED_HEAP == 1)
+extern uint8_t ucHeap[configTOTAL_HEAP_SIZE];
+#else
+static uint8_t ucHeap[configTOTAL_HEAP_SIZE] __attribute__((aligned(TLSF_ALIGN)));
+#endif
+
+#define CONTROL_SIZE ((sizeof(TlsfHeap) + TLSF_ALIGN - 1) & ~((size_t)TLSF_ALIGN - 1))
+
+static TlsfHeap *rtos_heap;
+
+// called with the scheduler suspended, on the first allocation as heap_4 does
+static void rtos_heap_init(void)
+{
+    uint8_t *start = (uint8_t *)(((uintptr_t)ucHeap + TLSF_ALIGN - 1) & ~((uintptr_t)TLSF_ALIGN - 1));
+    size_t bytes = configTOTAL_HEAP_SIZE - (size_t)(start - ucHeap);
+    rtos_heap = (TlsfHeap *)start;
+    bool ok = tlsf_heap_init(rtos_heap, start + CONTROL_SIZE, bytes - CONTROL_SIZE);
+    configASSERT(ok);
+    (void)ok;
+}
+
+static void malloc_failed(void)
+{
+#if (configUSE_MALLOC_FAILED_HOOK == 1)
+    extern void vApplicationMallocFailedHook(void);
+    vApplicationMallocFailedHook();
+#endif
+}
+
+void *pvPortMalloc(size_t xWantedSize)
+{
+    void *p;
+    vTaskSuspendAll();
+    {
+        if (!rtos_heap)
+        {
+            rtos_heap_init();
+        }
+        p = tlsf_heap_malloc(rtos_heap, xWantedSize);
+        traceMALLOC(p, xWantedSize);
+    }
+    (void)xTaskResumeAll();
+
+    if (!p && xWantedSize)
+    {
+        malloc_failed();
+    }
+    return p;
+}
+
+void vPortFree(void *pv)
+{
+    if (!pv)
+    {
+        return;
+    }
+    vTaskSuspendAll();
+    {
+        traceFREE(pv, tlsf_heap_usable_size(pv));
+        tlsf_heap_free(rtos_heap, pv);
+    }
+    (void)xTaskResumeAll();
+}
+
+void *pvPortReAlloc(void *pv, size_t xWantedSize)
+{
+    void *p;
+    vTaskSuspendAll();
+    {
+        if (!rtos_heap)
+        {
+            rtos_heap_init();
+        }
+        p = tlsf_heap_realloc(rtos_heap, pv, xWantedSize);
+    }
+    (void)xTaskResumeAll();
+
+    if (!p && xWantedSize)
+    {
+        malloc_failed();
+    }
+    return p;
+}
+
+size_t xPortGetFreeHeapSize(void)
+{
+    return rtos_heap ? rtos_heap->stats.free_bytes : configTOTAL_HEAP_SIZE - CONTROL_SIZE;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void)
+{
+    return rtos_heap ? rtos_heap->stats.min_ever_free : configTOTAL_HEAP_SIZE - CONTROL_SIZE;
+}
+
+void vPortInitialiseBlocks(void)
+{
+    // the heap sets itself up on the first allocation
+}
+
+void vPortGetHeapStats(HeapStats_t *pxHeapStats)
+{
+    TlsfStats stats;
+    memset(&stats, 0, sizeof(stats));
+    vTaskSuspendAll();
+    {
+        if (rtos_heap)
+        {
+            tlsf_heap_get_stats(rtos_heap, &stats);
+        }
+    }
+    (void)xTaskResumeAll();
+
+    pxHeapStats->xAvailableHeapSpaceInBytes = stats.free_bytes;
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = stats.largest_free;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = stats.smallest_free;
+    pxHeapStats->xNumberOfFreeBlocks = stats.free_blocks;
+    pxHeapStats->xMinimumEverFreeBytesRemaining = stats.min_ever_free;
+    pxHeapStats->xNumberOfSuccessfulAllocations = stats.allocs;
+    pxHeapStats->xNumberOfSuccessfulFrees = stats.frees;
+}
+#endif
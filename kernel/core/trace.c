@@ -0,0 +1,302 @@
+#include "trace.h"
+#include <string.h>
+
+#if defined(USE_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+#if defined(__arm__) && defined(USE_FREERTOS)
+#include "stm32_config.h"
+#include "mem_sections.h"
+#include "fatfs.h"
+#elif !defined(__arm__)
+#include <time.h>
+#endif
+
+#define RING_MASK (TRACE_RING_SIZE - 1)
+
+// CoreDebug->DEMCR and the DWT registers, as in FreeRTOSConfig.h
+#define DEMCR (*(volatile uint32_t *)0xE000EDFCUL)
+#define DWT_CTRL (*(volatile uint32_t *)0xE0001000UL)
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004UL)
+
+typedef struct
+{
+    TraceRecord records[TRACE_RING_SIZE];
+    uint32_t head;             // next index to reserve, only ever incremented
+    volatile uint32_t stop_at; // index the ring freezes at once triggered
+    uint32_t last_task;        // task of the last recorded switch
+    uint32_t clock_hz;
+    volatile bool enabled;
+    volatile bool triggered;
+    TraceName names[TRACE_MAX_NAMES];
+    uint16_t name_count;
+} TraceRing;
+
+static TraceRing ring;
+
+static inline uint32_t trace_now(void)
+{
+#if defined(__arm__)
+    return DWT_CYCCNT;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+// lap 0 gets tag 1, so a slot never written never matches
+static inline uint16_t tag_of(uint32_t index)
+{
+    return (uint16_t)((index >> TRACE_RING_LOG2) + 1);
+}
+
+void trace_init(uint32_t clock_hz)
+{
+    ring.enabled = false;
+    memset(&ring, 0, sizeof(ring));
+    ring.clock_hz = clock_hz;
+    ring.last_task = UINT32_MAX;
+#if defined(__arm__)
+    DEMCR |= 1UL << 24; // TRCENA
+    DWT_CTRL |= 1UL;    // CYCCNTENA
+#endif
+    ring.enabled = true;
+}
+
+void trace_record(uint16_t id, uint32_t arg0, uint32_t arg1)
+{
+    if (!ring.enabled)
+    {
+        return;
+    }
+    // LDREX/STREX on the M7, so an interrupt between the two just retries
+    uint32_t index = __atomic_fetch_add(&ring.head, 1, __ATOMIC_RELAXED);
+    if (ring.triggered && (int32_t)(index - ring.stop_at) >= 0)
+    {
+        ring.enabled = false;
+        return;
+    }
+
+    TraceRecord *rec = &ring.records[index & RING_MASK];
+    rec->timestamp = trace_now();
+    rec->id = id;
+    rec->arg0 = arg0;
+    rec->arg1 = arg1;
+    __atomic_store_n(&rec->tag, tag_of(index), __ATOMIC_RELEASE);
+}
+
+void trace_task_switch(uint32_t task, uint32_t priority)
+{
+    // the scheduler runs this with interrupts masked, so the compare is safe
+    if (task == ring.last_task)
+    {
+        return;
+    }
+    ring.last_task = task;
+    trace_record(TRACE_TASK_SWITCH, task, priority);
+}
+
+/* ===== NAMES ===== */
+
+#if defined(USE_FREERTOS)
+#define NAMES_LOCK() taskENTER_CRITICAL()
+#define NAMES_UNLOCK() taskEXIT_CRITICAL()
+#else
+// names are set up from one thread before anything is traced
+#define NAMES_LOCK() ((void)0)
+#define NAMES_UNLOCK() ((void)0)
+#endif
+
+void trace_name(TraceNameKind kind, uint32_t key, const char *name)
+{
+    NAMES_LOCK();
+    TraceName *entry = NULL;
+    for (uint16_t i = 0; i < ring.name_count; i++)
+    {
+        if (ring.names[i].kind == kind && ring.names[i].key == key)
+        {
+            entry = &ring.names[i];
+            break;
+        }
+    }
+    if (!entry && ring.name_count < TRACE_MAX_NAMES)
+    {
+        entry = &ring.names[ring.name_count++];
+    }
+    if (entry)
+    {
+        entry->key = key;
+        entry->kind = (uint8_t)kind;
+        strncpy(entry->name, name ? name : "", sizeof(entry->name));
+    }
+    NAMES_UNLOCK();
+}
+
+/* ===== CONTROL ===== */
+
+void trace_set_enabled(bool enabled)
+{
+    ring.triggered = false;
+    ring.enabled = enabled;
+}
+
+void trace_trigger(uint32_t post)
+{
+    if (ring.triggered || !ring.enabled)
+    {
+        return;
+    }
+    if (post > TRACE_RING_SIZE)
+    {
+        post = TRACE_RING_SIZE;
+    }
+    ring.stop_at = __atomic_load_n(&ring.head, __ATOMIC_RELAXED) + post;
+    ring.triggered = true;
+}
+
+void trace_get_stats(TraceStats *stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+    uint32_t head = __atomic_load_n(&ring.head, __ATOMIC_RELAXED);
+    if (ring.triggered && (int32_t)(head - ring.stop_at) > 0)
+    {
+        head = ring.stop_at;
+    }
+    stats->written = head;
+    stats->overwritten = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    stats->capacity = TRACE_RING_SIZE;
+    stats->names = ring.name_count;
+    stats->enabled = ring.enabled;
+    stats->triggered = ring.triggered;
+}
+
+/* ===== DUMP ===== */
+
+typedef struct
+{
+    TraceWriteFn write;
+    void *arg;
+    uint32_t sum;
+    size_t bytes;
+    bool ok;
+} DumpWriter;
+
+static void dump_put(DumpWriter *w, const void *data, size_t len)
+{
+    if (!w->ok)
+    {
+        return;
+    }
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++)
+    {
+        w->sum += bytes[i];
+    }
+    w->ok = w->write(data, len, w->arg);
+    w->bytes += len;
+}
+
+size_t trace_dump(TraceWriteFn write, void *arg)
+{
+    bool was_enabled = ring.enabled;
+    ring.enabled = false;
+
+    // records reserved past a trigger were never written
+    uint32_t head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+    if (ring.triggered && (int32_t)(head - ring.stop_at) > 0)
+    {
+        head = ring.stop_at;
+    }
+    uint32_t count = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+
+    TraceDumpHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_DUMP_MAGIC, sizeof(header.magic));
+    header.version = TRACE_DUMP_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.clock_hz = ring.clock_hz;
+    header.capacity = TRACE_RING_SIZE;
+    header.head = head;
+    header.count = count;
+    header.name_count = ring.name_count;
+    header.name_size = sizeof(TraceName);
+
+    DumpWriter w = {write, arg, 0, 0, true};
+    dump_put(&w, &header, sizeof(header));
+    dump_put(&w, ring.names, ring.name_count * sizeof(TraceName));
+
+    // oldest first, the split at the ring's end is written in two pieces
+    uint32_t first = (head - count) & RING_MASK;
+    uint32_t run = TRACE_RING_SIZE - first < count ? TRACE_RING_SIZE - first : count;
+    dump_put(&w, &ring.records[first], run * sizeof(TraceRecord));
+    dump_put(&w, &ring.records[0], (count - run) * sizeof(TraceRecord));
+
+    uint32_t sum = w.sum;
+    dump_put(&w, TRACE_DUMP_END, 4);
+    dump_put(&w, &sum, sizeof(sum));
+
+    if (!ring.triggered)
+    {
+        ring.enabled = was_enabled;
+    }
+    return w.ok ? w.bytes : 0;
+}
+
+#if defined(__arm__) && defined(USE_FREERTOS)
+
+static bool file_write(const void *data, size_t len, void *arg)
+{
+    UINT written;
+    return f_write((FIL *)arg, data, len, &written) == FR_OK && written == len;
+}
+
+bool trace_save(const char *path)
+{
+    // FIL holds a sector buffer that SDMMC IDMA fills, so it lives in the DMA region
+    static FIL file DMA_BUFFER;
+    if (f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    {
+        return false;
+    }
+    size_t bytes = trace_dump(file_write, &file);
+    return f_close(&file) == FR_OK && bytes > 0;
+}
+
+#if defined(DEBUG_UART_HANDLE)
+extern UART_HandleTypeDef DEBUG_UART_HANDLE;
+
+static bool uart_write(const void *data, size_t len, void *arg)
+{
+    (void)arg;
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (len > 0)
+    {
+        uint16_t chunk = len > 0xFFFF ? 0xFFFF : (uint16_t)len;
+        if (HAL_UART_Transmit(&DEBUG_UART_HANDLE, (uint8_t *)bytes, chunk, 1000) != HAL_OK)
+        {
+            return false;
+        }
+        bytes += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+bool trace_send_uart(void)
+{
+    return trace_dump(uart_write, NULL) > 0;
+}
+#else
+bool trace_send_uart(void)
+{
+    // the board config names no debug UART
+    return false;
+}
+#endif
+
+#endif
@@ -1,39 +1,159 @@
 #include "contacts_bptree.h"
+#include "profile.h"
+
+#if defined(__arm__) || defined(HOST_SIM)
+#include "mem_sections.h"
+
+// the card is only reachable through FatFs, so one tree is open at a time
+static FIL tree_fil DMA_BUFFER;
+static FIL data_fil DMA_BUFFER;
+#define TREE_FILE_STORAGE (&tree_fil)
+#define DATA_FILE_STORAGE (&data_fil)
+
+static BPTreeFile *file_open(FIL *fil, const char *path, bool create)
+{
+    // a file object still in use belongs to the tree that is already open
+    if (fil->obj.fs)
+        return NULL;
+    BYTE mode = FA_READ | FA_WRITE | (create ? FA_CREATE_ALWAYS : FA_OPEN_EXISTING);
+    return f_open(fil, path, mode) == FR_OK ? fil : NULL;
+}
+
+static void file_close(BPTreeFile *file)
+{
+    f_close(file);
+}
+
+static bool file_seek(BPTreeFile *file, uint32_t offset)
+{
+    return f_lseek(file, offset) == FR_OK;
+}
+
+static uint32_t file_tell(BPTreeFile *file)
+{
+    return (uint32_t)f_tell(file);
+}
+
+// moves to the end of the file and returns its size
+static uint32_t file_end(BPTreeFile *file)
+{
+    f_lseek(file, f_size(file));
+    return (uint32_t)f_tell(file);
+}
+
+static bool file_read(BPTreeFile *file, void *buf, uint32_t len)
+{
+    UINT got;
+    return f_read(file, buf, len, &got) == FR_OK && got == len;
+}
+
+static bool file_write(BPTreeFile *file, const void *buf, uint32_t len)
+{
+    UINT written;
+    return f_write(file, buf, len, &written) == FR_OK && written == len;
+}
+
+static void file_sync(BPTreeFile *file)
+{
+    f_sync(file);
+}
+
+static void file_remove(const char *path)
+{
+    f_unlink(path);
+}
+#else
+#define TREE_FILE_STORAGE NULL
+#define DATA_FILE_STORAGE NULL
+
+static BPTreeFile *file_open(void *storage, const char *path, bool create)
+{
+    (void)storage;
+    return fopen(path, create ? "w+b" : "r+b");
+}
+
+static void file_close(BPTreeFile *file)
+{
+    fclose(file);
+}
+
+static bool file_seek(BPTreeFile *file, uint32_t offset)
+{
+    return fseek(file, offset, SEEK_SET) == 0;
+}
+
+static uint32_t file_tell(BPTreeFile *file)
+{
+    return (uint32_t)ftell(file);
+}
+
+// moves to the end of the file and returns its size
+static uint32_t file_end(BPTreeFile *file)
+{
+    fseek(file, 0, SEEK_END);
+    return (uint32_t)ftell(file);
+}
+
+static bool file_read(BPTreeFile *file, void *buf, uint32_t len)
+{
+    return fread(buf, len, 1, file) == 1;
+}
+
+static bool file_write(BPTreeFile *file, const void *buf, uint32_t len)
+{
+    return fwrite(buf, len, 1, file) == 1;
+}
+
+static void file_sync(BPTreeFile *file)
+{
+    fflush(file);
+}
+
+static void file_remove(const char *path)
+{
+    remove(path);
+}
+#endif
 
 /*
     Load btree file if exists, otherwise create new. Returns BPTree struct.
 */
 BPTree bptree_create(const char *tree_filename, const char *data_filename)
 {
-    BPTree tree;
+    BPTree tree = {0};
 
-    tree.data_file = fopen(data_filename, "r+b");
+    tree.data_file = file_open(DATA_FILE_STORAGE, data_filename, false);
     if (!tree.data_file)
-        tree.data_file = fopen(data_filename, "w+b");
+        tree.data_file = file_open(DATA_FILE_STORAGE, data_filename, true);
 
-    tree.tree_file = fopen(tree_filename, "r+b");
+    tree.tree_file = file_open(TREE_FILE_STORAGE, tree_filename, false);
     if (!tree.tree_file)
     {
-        tree.tree_file = fopen(tree_filename, "w+b");
+        tree.tree_file = file_open(TREE_FILE_STORAGE, tree_filename, true);
+        if (!tree.tree_file)
+        {
+            tree.root_offset = 0;
+            return tree;
+        }
         // reserve space for root offset at beginning of file
         uint32_t initial_root_offset = sizeof(uint32_t);
         // store root offset at start of file.
-        fwrite(&initial_root_offset, sizeof(uint32_t), 1, tree.tree_file);
+        file_write(tree.tree_file, &initial_root_offset, sizeof(uint32_t));
         // create initial root node (as a leaf since no parent)
         BPTreeNode root = {0};
         root.type = LEAF;
         root.key_count = 0;
         root.next = 0;
-        fwrite(&root, sizeof(BPTreeNode), 1, tree.tree_file);
-        fflush(tree.tree_file);
+        file_write(tree.tree_file, &root, sizeof(BPTreeNode));
+        file_sync(tree.tree_file);
 
         tree.root_offset = initial_root_offset;
     }
     else
     {
         // read root offset from existing file
-        fseek(tree.tree_file, 0, SEEK_SET);
-        if (fread(&tree.root_offset, sizeof(uint32_t), 1, tree.tree_file) != 1)
+        file_seek(tree.tree_file, 0);
+        if (!file_read(tree.tree_file, &tree.root_offset, sizeof(uint32_t)))
         {
             tree.root_offset = sizeof(uint32_t); // fallback
         }
@@ -49,12 +169,12 @@ void bptree_close(BPTree *tree)
 {
     if (tree->data_file)
     {
-        fclose(tree->data_file);
+        file_close(tree->data_file);
         tree->data_file = NULL;
     }
     if (tree->tree_file)
     {
-        fclose(tree->tree_file);
+        file_close(tree->tree_file);
         tree->tree_file = NULL;
     }
 }
@@ -62,32 +182,31 @@ void bptree_close(BPTree *tree)
 /*
     Write contact to data file, return offset it was written at.
 */
-uint32_t contacts_append(FILE *data_file, ContactRecord contact)
+uint32_t contacts_append(BPTreeFile *data_file, ContactRecord contact)
 {
     // Try to reuse a tombstoned slot
-    fseek(data_file, 0, SEEK_SET);
+    file_seek(data_file, 0);
     uint32_t offset = 0;
     uint8_t flag;
-    while (fread(&flag, 1, 1, data_file) == 1) {
+    while (file_read(data_file, &flag, 1)) {
         if (flag == 0) {
             // Found a tombstoned slot, reuse it
-            offset = ftell(data_file) - 1;
+            offset = file_tell(data_file) - 1;
             break;
         }
-        fseek(data_file, sizeof(ContactRecord), SEEK_CUR);
+        file_seek(data_file, file_tell(data_file) + sizeof(ContactRecord));
         offset += 1 + sizeof(ContactRecord);
     }
     if (flag != 0) {
         // No tombstoned slot found, append at end
-        fseek(data_file, 0, SEEK_END);
-        offset = ftell(data_file);
+        offset = file_end(data_file);
     }
     contact.offset_id = offset;
     flag = 1;
-    fseek(data_file, offset, SEEK_SET);
-    fwrite(&flag, 1, 1, data_file);
-    fwrite(&contact, sizeof(ContactRecord), 1, data_file);
-    fflush(data_file);
+    file_seek(data_file, offset);
+    file_write(data_file, &flag, 1);
+    file_write(data_file, &contact, sizeof(ContactRecord));
+    file_sync(data_file);
     return offset;
 }
 
@@ -95,21 +214,30 @@ uint32_t contacts_append(FILE *data_file, ContactRecord contact)
     Read contact from data file at given offset.
     Returns true if contact is active, false if tombstoned.
 */
-bool contacts_read(FILE *data_file, uint32_t offset, ContactRecord *out_contact)
+bool contacts_read(BPTreeFile *data_file, uint32_t offset, ContactRecord *out_contact)
 {
-    fseek(data_file, offset, SEEK_SET);
+    file_seek(data_file, offset);
     uint8_t flag;
-    if (fread(&flag, 1, 1, data_file) != 1) return false;
-    if (fread(out_contact, sizeof(ContactRecord), 1, data_file) != 1) return false;
+    if (!file_read(data_file, &flag, 1)) return false;
+    if (!file_read(data_file, out_contact, sizeof(ContactRecord))) return false;
     return flag == 1;
 }
 
-void contacts_delete(FILE *data_file, uint32_t offset)
+void contacts_delete(BPTreeFile *data_file, uint32_t offset)
 {
-    fseek(data_file, offset, SEEK_SET);
+    file_seek(data_file, offset);
     uint8_t flag = 0;
-    fwrite(&flag, 1, 1, data_file);
-    fflush(data_file);
+    file_write(data_file, &flag, 1);
+    file_sync(data_file);
+}
+
+/*
+    Read the tree node at given offset.
+    Returns false if the node could not be read.
+*/
+bool bptree_read_node(BPTree *tree, uint32_t offset, BPTreeNode *out_node)
+{
+    return file_seek(tree->tree_file, offset) && file_read(tree->tree_file, out_node, sizeof(BPTreeNode));
 }
 
 /*
@@ -118,6 +246,7 @@ void contacts_delete(FILE *data_file, uint32_t offset)
 */
 uint32_t bptree_find_leaf(BPTree *tree, const char *name)
 {
+    PROFILE_ZONE_BEGIN(PROFILE_BPTREE_FIND);
     uint32_t current_offset = tree->root_offset;
     BPTreeNode node;
 
@@ -125,10 +254,11 @@ uint32_t bptree_find_leaf(BPTree *tree, const char *name)
     while (1)
     {
         // jump to location of node
-        fseek(tree->tree_file, current_offset, SEEK_SET);
-        fread(&node, sizeof(BPTreeNode), 1, tree->tree_file);
+        file_seek(tree->tree_file, current_offset);
+        file_read(tree->tree_file, &node, sizeof(BPTreeNode));
         if (node.type == LEAF)
         {
+            PROFILE_ZONE_END(PROFILE_BPTREE_FIND);
             return current_offset;
         }
 
@@ -149,9 +279,9 @@ uint32_t bptree_find_leaf(BPTree *tree, const char *name)
 */
 uint32_t bptree_load_page(BPTree *tree, uint32_t offset, ContactsView *state)
 {
-    fseek(tree->tree_file, offset, SEEK_SET);
+    file_seek(tree->tree_file, offset);
     BPTreeNode node;
-    fread(&node, sizeof(BPTreeNode), 1, tree->tree_file);
+    file_read(tree->tree_file, &node, sizeof(BPTreeNode));
     // if not leaf, recurse down leftmost branch
     if (node.type == INTERNAL)
     {
@@ -199,9 +329,9 @@ int bptree_search_prefix_page(BPTree *tree, PrefixSearchState *state, char out_n
     // continue until we run out of leaves or fill the buffer
     while (state->leaf_offset != 0 && found < CONTACTS_VISIBLE_COUNT)
     {
-        fseek(tree->tree_file, state->leaf_offset, SEEK_SET);
+        file_seek(tree->tree_file, state->leaf_offset);
         BPTreeNode leaf;
-        fread(&leaf, sizeof(BPTreeNode), 1, tree->tree_file);
+        file_read(tree->tree_file, &leaf, sizeof(BPTreeNode));
         // scan keys on current lea
         for (; state->key_index < leaf.key_count && found < CONTACTS_VISIBLE_COUNT; state->key_index++)
         {
@@ -233,9 +363,9 @@ static uint32_t bptree_find_parent_recursive(BPTree *tree, uint32_t current_offs
 {
     if (current_offset == 0 || current_offset == child_offset) return 0;
 
-    fseek(tree->tree_file, current_offset, SEEK_SET);
+    file_seek(tree->tree_file, current_offset);
     BPTreeNode node;
-    if (fread(&node, sizeof(BPTreeNode), 1, tree->tree_file) != 1) return 0;
+    if (!file_read(tree->tree_file, &node, sizeof(BPTreeNode))) return 0;
 
     if (node.type == LEAF) return 0;
 
@@ -263,6 +393,30 @@ static uint32_t bptree_find_parent(BPTree *tree, uint32_t child_offset)
 }
 
 
+/*
+    Position for a new key/child pair in an internal node. The new child was
+    split off left_offset, so it belongs directly to its right. Keys alone are
+    ambiguous when duplicate names leave several equal separators.
+*/
+static int bptree_internal_insert_pos(const BPTreeNode *node, uint32_t left_offset, const char *key)
+{
+    for (int i = 0; i <= node->key_count; i++)
+    {
+        if (node->children[i] == left_offset)
+            return i;
+    }
+    // unknown sibling, fall back to key order
+    int pos = node->key_count;
+    while (pos > 0 && strncmp(key, node->keys[pos - 1], MAX_KEY_LEN) < 0)
+    {
+        pos--;
+    }
+    return pos;
+}
+
+static bool bptree_insert_internal_after(BPTree *tree, uint32_t offset, uint32_t left_offset, const char *key, uint32_t child_offset);
+static uint32_t bptree_split_internal_after(BPTree *tree, uint32_t node_offset, uint32_t left_offset, const char *key, uint32_t child_offset);
+
 /*
     Adds a new contact to the data file, handle tree balancing.
 */
@@ -272,9 +426,9 @@ bool bptree_insert(BPTree *tree, ContactRecord contact)
     strncpy(key, contact.name, MAX_KEY_LEN - 1);
     uint32_t data_offset = contacts_append(tree->data_file, contact);
     uint32_t leaf_offset = bptree_find_leaf(tree, key);
-    fseek(tree->tree_file, leaf_offset, SEEK_SET);
+    file_seek(tree->tree_file, leaf_offset);
     BPTreeNode leaf;
-    fread(&leaf, sizeof(BPTreeNode), 1, tree->tree_file);
+    file_read(tree->tree_file, &leaf, sizeof(BPTreeNode));
     // leaf has space without need for split and balancing
     if (leaf.key_count < MAX_KEYS)
     {
@@ -292,19 +446,19 @@ bool bptree_insert(BPTree *tree, ContactRecord contact)
         leaf.children[pos] = data_offset;
         leaf.key_count++;
         // jump back to leaf position
-        fseek(tree->tree_file, leaf_offset, SEEK_SET);
+        file_seek(tree->tree_file, leaf_offset);
         // write updated leaf back to file
-        fwrite(&leaf, sizeof(BPTreeNode), 1, tree->tree_file);
-        fflush(tree->tree_file);
+        file_write(tree->tree_file, &leaf, sizeof(BPTreeNode));
+        file_sync(tree->tree_file);
         return true;
     }
 
     // leaf is full, need to split
     uint32_t new_leaf_offset = bptree_split_leaf(tree, leaf_offset, key, data_offset);
     // get the first key of the new leaf to promote
-    fseek(tree->tree_file, new_leaf_offset, SEEK_SET);
+    file_seek(tree->tree_file, new_leaf_offset);
     BPTreeNode new_leaf;
-    fread(&new_leaf, sizeof(BPTreeNode), 1, tree->tree_file);
+    file_read(tree->tree_file, &new_leaf, sizeof(BPTreeNode));
 
     // if this is the root (no parent), create new root
     if (leaf_offset == tree->root_offset)
@@ -316,16 +470,15 @@ bool bptree_insert(BPTree *tree, ContactRecord contact)
         new_root.children[0] = leaf_offset;
         new_root.children[1] = new_leaf_offset;
 
-        fseek(tree->tree_file, 0, SEEK_END);
-        uint32_t new_root_offset = ftell(tree->tree_file);
-        fwrite(&new_root, sizeof(BPTreeNode), 1, tree->tree_file);
-        fflush(tree->tree_file);
+        uint32_t new_root_offset = file_end(tree->tree_file);
+        file_write(tree->tree_file, &new_root, sizeof(BPTreeNode));
+        file_sync(tree->tree_file);
 
         bptree_update_root(tree, new_root_offset);
     } else { // has parent, insert promoted key into parent
         uint32_t parent_offset = bptree_find_parent(tree, leaf_offset);
         if (parent_offset == 0) parent_offset = tree->root_offset; // fallback, should not happen
-        bptree_insert_internal(tree, parent_offset, new_leaf.keys[0], new_leaf_offset);
+        bptree_insert_internal_after(tree, parent_offset, leaf_offset, new_leaf.keys[0], new_leaf_offset);
     }
 
     return true;
@@ -342,8 +495,8 @@ uint32_t bptree_get_first_leaf(BPTree *tree)
 
     while (1)
     {
-        fseek(tree->tree_file, current_offset, SEEK_SET);
-        fread(&node, sizeof(BPTreeNode), 1, tree->tree_file);
+        file_seek(tree->tree_file, current_offset);
+        file_read(tree->tree_file, &node, sizeof(BPTreeNode));
 
         if (node.type == LEAF)
         {
@@ -359,9 +512,9 @@ uint32_t bptree_get_first_leaf(BPTree *tree)
 */
 uint32_t bptree_get_next_leaf(BPTree *tree, uint32_t current_leaf_offset)
 {
-    fseek(tree->tree_file, current_leaf_offset, SEEK_SET);
+    file_seek(tree->tree_file, current_leaf_offset);
     BPTreeNode leaf;
-    fread(&leaf, sizeof(BPTreeNode), 1, tree->tree_file);
+    file_read(tree->tree_file, &leaf, sizeof(BPTreeNode));
 
     if (leaf.type != LEAF)
     {
@@ -384,9 +537,9 @@ bool bptree_delete(BPTree *tree, ContactRecord contact)
     uint32_t leaf_offset = bptree_find_leaf(tree, key);
     if (leaf_offset == 0) return false;
 
-    fseek(tree->tree_file, leaf_offset, SEEK_SET);
+    file_seek(tree->tree_file, leaf_offset);
     BPTreeNode leaf;
-    if (fread(&leaf, sizeof(BPTreeNode), 1, tree->tree_file) != 1) return false;
+    if (!file_read(tree->tree_file, &leaf, sizeof(BPTreeNode))) return false;
     // find key in leaf
     int found_index = -1;
     for (int i = 0; i < leaf.key_count; i++) {
@@ -415,9 +568,9 @@ bool bptree_delete(BPTree *tree, ContactRecord contact)
     leaf.key_count--;
 
     // write back updated leaf
-    fseek(tree->tree_file, leaf_offset, SEEK_SET);
-    fwrite(&leaf, sizeof(BPTreeNode), 1, tree->tree_file);
-    fflush(tree->tree_file);
+    file_seek(tree->tree_file, leaf_offset);
+    file_write(tree->tree_file, &leaf, sizeof(BPTreeNode));
+    file_sync(tree->tree_file);
 
     contacts_delete(tree->data_file, contact.offset_id);
 
@@ -427,9 +580,9 @@ bool bptree_delete(BPTree *tree, ContactRecord contact)
         if (leaf.key_count > 0) {
             uint32_t parent_offset = bptree_find_parent(tree, leaf_offset);
             if (parent_offset != 0) {
-                fseek(tree->tree_file, parent_offset, SEEK_SET);
+                file_seek(tree->tree_file, parent_offset);
                 BPTreeNode parent;
-                if (fread(&parent, sizeof(BPTreeNode), 1, tree->tree_file) == 1) {
+                if (file_read(tree->tree_file, &parent, sizeof(BPTreeNode))) {
                     // find which key index corresponds to this child pointer and update it.
                     for (int i = 0; i < parent.key_count; i++) {
                         if (parent.children[i] == leaf_offset) {
@@ -446,9 +599,9 @@ bool bptree_delete(BPTree *tree, ContactRecord contact)
                         }
                     }
                     // write parent back
-                    fseek(tree->tree_file, parent_offset, SEEK_SET);
-                    fwrite(&parent, sizeof(BPTreeNode), 1, tree->tree_file);
-                    fflush(tree->tree_file);
+                    file_seek(tree->tree_file, parent_offset);
+                    file_write(tree->tree_file, &parent, sizeof(BPTreeNode));
+                    file_sync(tree->tree_file);
                 }
             }
         }
@@ -465,9 +618,9 @@ bool bptree_delete(BPTree *tree, ContactRecord contact)
 */
 uint32_t bptree_split_leaf(BPTree *tree, uint32_t leaf_offset, const char *new_key, uint32_t new_data_offset)
 {
-    fseek(tree->tree_file, leaf_offset, SEEK_SET);
+    file_seek(tree->tree_file, leaf_offset);
     BPTreeNode leaf;
-    fread(&leaf, sizeof(BPTreeNode), 1, tree->tree_file);
+    file_read(tree->tree_file, &leaf, sizeof(BPTreeNode));
     // create new leaf and have it copy the next pointer of the old leaf.
     BPTreeNode new_leaf = {0};
     new_leaf.type = LEAF;
@@ -516,14 +669,13 @@ uint32_t bptree_split_leaf(BPTree *tree, uint32_t leaf_offset, const char *new_k
         new_leaf.children[i] = temp_children[split_point + i];
     }
     // write new leaf to end of file
-    fseek(tree->tree_file, 0, SEEK_END);
-    uint32_t new_leaf_offset = ftell(tree->tree_file);
-    fwrite(&new_leaf, sizeof(BPTreeNode), 1, tree->tree_file);
+    uint32_t new_leaf_offset = file_end(tree->tree_file);
+    file_write(tree->tree_file, &new_leaf, sizeof(BPTreeNode));
     // update original leaf to point to new leaf
     leaf.next = new_leaf_offset;
-    fseek(tree->tree_file, leaf_offset, SEEK_SET);
-    fwrite(&leaf, sizeof(BPTreeNode), 1, tree->tree_file);
-    fflush(tree->tree_file);
+    file_seek(tree->tree_file, leaf_offset);
+    file_write(tree->tree_file, &leaf, sizeof(BPTreeNode));
+    file_sync(tree->tree_file);
     return new_leaf_offset;
 }
 
@@ -533,34 +685,38 @@ uint32_t bptree_split_leaf(BPTree *tree, uint32_t leaf_offset, const char *new_k
 */
 bool bptree_insert_internal(BPTree *tree, uint32_t offset, const char *key, uint32_t child_offset)
 {
-    fseek(tree->tree_file, offset, SEEK_SET);
+    return bptree_insert_internal_after(tree, offset, 0, key, child_offset);
+}
+
+static bool bptree_insert_internal_after(BPTree *tree, uint32_t offset, uint32_t left_offset, const char *key, uint32_t child_offset)
+{
+    file_seek(tree->tree_file, offset);
     BPTreeNode node;
-    fread(&node, sizeof(BPTreeNode), 1, tree->tree_file);
+    file_read(tree->tree_file, &node, sizeof(BPTreeNode));
 
     if (node.key_count >= MAX_KEYS)
     {
         // need to split internal node
-        bptree_split_internal(tree, offset, key, child_offset);
+        bptree_split_internal_after(tree, offset, left_offset, key, child_offset);
         return true;
     }
 
     // find insertion position
-    int pos = node.key_count;
+    int pos = bptree_internal_insert_pos(&node, left_offset, key);
     // shift keys and children to make room
-    while (pos > 0 && strncmp(key, node.keys[pos - 1], MAX_KEY_LEN) < 0)
+    for (int i = node.key_count; i > pos; i--)
     {
-        strncpy(node.keys[pos], node.keys[pos - 1], MAX_KEY_LEN);
-        node.children[pos + 1] = node.children[pos];
-        pos--;
+        strncpy(node.keys[i], node.keys[i - 1], MAX_KEY_LEN);
+        node.children[i + 1] = node.children[i];
     }
     // insert new key and child
     strncpy(node.keys[pos], key, MAX_KEY_LEN);
     node.children[pos + 1] = child_offset;
     node.key_count++;
     // write back updated node
-    fseek(tree->tree_file, offset, SEEK_SET);
-    fwrite(&node, sizeof(BPTreeNode), 1, tree->tree_file);
-    fflush(tree->tree_file);
+    file_seek(tree->tree_file, offset);
+    file_write(tree->tree_file, &node, sizeof(BPTreeNode));
+    file_sync(tree->tree_file);
 
     return true;
 }
@@ -572,9 +728,9 @@ void bptree_update_root(BPTree *tree, uint32_t new_root_offset)
 {
     tree->root_offset = new_root_offset;
     // persist the root offset to disk (beginning of file)
-    fseek(tree->tree_file, 0, SEEK_SET);
-    fwrite(&new_root_offset, sizeof(uint32_t), 1, tree->tree_file);
-    fflush(tree->tree_file);
+    file_seek(tree->tree_file, 0);
+    file_write(tree->tree_file, &new_root_offset, sizeof(uint32_t));
+    file_sync(tree->tree_file);
 }
 
 /*
@@ -583,11 +739,16 @@ void bptree_update_root(BPTree *tree, uint32_t new_root_offset)
     If the split node was the root, creates a new root as well.
 */
 uint32_t bptree_split_internal(BPTree *tree, uint32_t node_offset, const char *key, uint32_t child_offset)
+{
+    return bptree_split_internal_after(tree, node_offset, 0, key, child_offset);
+}
+
+static uint32_t bptree_split_internal_after(BPTree *tree, uint32_t node_offset, uint32_t left_offset, const char *key, uint32_t child_offset)
 {
     // Read the full internal node
-    fseek(tree->tree_file, node_offset, SEEK_SET);
+    file_seek(tree->tree_file, node_offset);
     BPTreeNode node;
-    fread(&node, sizeof(BPTreeNode), 1, tree->tree_file);
+    file_read(tree->tree_file, &node, sizeof(BPTreeNode));
 
     // Create new internal node
     BPTreeNode new_node = {0};
@@ -609,11 +770,7 @@ uint32_t bptree_split_internal(BPTree *tree, uint32_t node_offset, const char *k
     }
 
     // Find insertion position and insert
-    int insert_pos = node.key_count;
-    while (insert_pos > 0 && strncmp(key, temp_keys[insert_pos - 1], MAX_KEY_LEN) < 0)
-    {
-        insert_pos--;
-    }
+    int insert_pos = bptree_internal_insert_pos(&node, left_offset, key);
 
     // Shift keys and children to make room
     for (int i = node.key_count; i > insert_pos; i--)
@@ -651,14 +808,13 @@ uint32_t bptree_split_internal(BPTree *tree, uint32_t node_offset, const char *k
     new_node.children[new_node.key_count] = temp_children[total_keys];
 
     // Write nodes to disk
-    fseek(tree->tree_file, node_offset, SEEK_SET);
-    fwrite(&node, sizeof(BPTreeNode), 1, tree->tree_file);
+    file_seek(tree->tree_file, node_offset);
+    file_write(tree->tree_file, &node, sizeof(BPTreeNode));
 
-    fseek(tree->tree_file, 0, SEEK_END);
-    uint32_t new_node_offset = ftell(tree->tree_file);
-    fwrite(&new_node, sizeof(BPTreeNode), 1, tree->tree_file);
+    uint32_t new_node_offset = file_end(tree->tree_file);
+    file_write(tree->tree_file, &new_node, sizeof(BPTreeNode));
 
-    fflush(tree->tree_file);
+    file_sync(tree->tree_file);
 
     // The middle key that gets promoted up
     char promoted_key[MAX_KEY_LEN];
@@ -674,13 +830,21 @@ uint32_t bptree_split_internal(BPTree *tree, uint32_t node_offset, const char *k
         new_root.children[0] = node_offset;
         new_root.children[1] = new_node_offset;
 
-        fseek(tree->tree_file, 0, SEEK_END);
-        uint32_t new_root_offset = ftell(tree->tree_file);
-        fwrite(&new_root, sizeof(BPTreeNode), 1, tree->tree_file);
-        fflush(tree->tree_file);
+        uint32_t new_root_offset = file_end(tree->tree_file);
+        file_write(tree->tree_file, &new_root, sizeof(BPTreeNode));
+        file_sync(tree->tree_file);
 
         bptree_update_root(tree, new_root_offset);
     }
+    else
+    {
+        // promote into the parent as well, otherwise the new node is unreachable
+        // and later inserts are routed to the wrong leaf
+        uint32_t parent_offset = bptree_find_parent(tree, node_offset);
+        if (parent_offset == 0)
+            parent_offset = tree->root_offset;
+        bptree_insert_internal_after(tree, parent_offset, node_offset, promoted_key, new_node_offset);
+    }
 
     return new_node_offset;
 }
@@ -692,8 +856,8 @@ int bptree_test()
     printf("Starting B+ Tree test...\n");
 
     // Clean up any existing test files first
-    remove("test_bptree.dat");
-    remove("test_contacts.dat");
+    file_remove("test_bptree.dat");
+    file_remove("test_contacts.dat");
 
     // Create or load B+ tree and contacts files
     BPTree tree = bptree_create("test_bptree.dat", "test_contacts.dat");
@@ -734,9 +898,9 @@ int bptree_test()
     { // Test first few names
         // Find leaf and index for the contact
         uint32_t leaf_offset = bptree_find_leaf(&tree, contacts[i].name);
-        fseek(tree.tree_file, leaf_offset, SEEK_SET);
+        file_seek(tree.tree_file, leaf_offset);
         BPTreeNode leaf;
-        fread(&leaf, sizeof(BPTreeNode), 1, tree.tree_file);
+        file_read(tree.tree_file, &leaf, sizeof(BPTreeNode));
         int found_index = -1;
         for (int j = 0; j < leaf.key_count; j++) {
             if (strncmp(leaf.keys[j], contacts[i].name, MAX_KEY_LEN) == 0) {
@@ -761,9 +925,9 @@ int bptree_test()
 
     // Test search for non-existent contact
     uint32_t leaf_offset = bptree_find_leaf(&tree, "Nonexistent Person");
-    fseek(tree.tree_file, leaf_offset, SEEK_SET);
+    file_seek(tree.tree_file, leaf_offset);
     BPTreeNode leaf;
-    fread(&leaf, sizeof(BPTreeNode), 1, tree.tree_file);
+    file_read(tree.tree_file, &leaf, sizeof(BPTreeNode));
     int found_index = -1;
     for (int j = 0; j < leaf.key_count; j++) {
         if (strncmp(leaf.keys[j], "Nonexistent Person", MAX_KEY_LEN) == 0) {
@@ -810,9 +974,9 @@ int bptree_test()
 
 void bptree_debug_print(BPTree *tree, uint32_t offset, int depth)
 {
-    fseek(tree->tree_file, offset, SEEK_SET);
+    file_seek(tree->tree_file, offset);
     BPTreeNode node;
-    fread(&node, sizeof(BPTreeNode), 1, tree->tree_file);
+    file_read(tree->tree_file, &node, sizeof(BPTreeNode));
 
     for (int i = 0; i < depth; i++)
         printf("  ");
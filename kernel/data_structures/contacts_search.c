@@ -0,0 +1,284 @@
+#include "contacts_search.h"
+
+/*
+    Read a leaf through the one-node cache. Consecutive keys almost always
+    share a leaf, so this turns a row-by-row walk into one read per leaf.
+*/
+static const BPTreeNode *load_leaf(ContactSearch *search, uint32_t offset)
+{
+    if (offset == search->leaf_offset)
+        return &search->leaf;
+
+    search->reads++;
+    if (!bptree_read_node(search->tree, offset, &search->leaf))
+    {
+        search->leaf_offset = 0;
+        return NULL;
+    }
+    search->leaf_offset = offset;
+    return &search->leaf;
+}
+
+/*
+    Move a position forward until it points at a key, skipping empty leaves.
+    Returns false (and leaf 0) when the end of the chain is reached.
+*/
+static bool settle(ContactSearch *search, BPTreePos *pos, int *leaves)
+{
+    while (pos->leaf != 0)
+    {
+        const BPTreeNode *leaf = load_leaf(search, pos->leaf);
+        if (!leaf)
+            break;
+        if (pos->key_index < leaf->key_count)
+            return true;
+        pos->leaf = leaf->next;
+        pos->key_index = 0;
+        if (leaves)
+            (*leaves)++;
+    }
+    pos->leaf = 0;
+    pos->key_index = 0;
+    return false;
+}
+
+static int compare_key(ContactSearch *search, const BPTreePos *pos)
+{
+    const BPTreeNode *leaf = load_leaf(search, pos->leaf);
+    if (!leaf)
+        return 1;
+    return strncmp(leaf->keys[pos->key_index], search->prefix, search->len);
+}
+
+/*
+    Find the first key not ordered before the current prefix, starting at
+    pos. Gives up after CONTACT_SEARCH_SCAN_LEAVES leaves so a prefix that
+    jumps far ahead does not walk half the chain. Returns false if it gave up.
+*/
+static bool scan_lower_bound(ContactSearch *search, BPTreePos *pos, int max_leaves)
+{
+    int leaves = 0;
+    while (settle(search, pos, &leaves))
+    {
+        if (max_leaves >= 0 && leaves > max_leaves)
+            return false;
+        if (compare_key(search, pos) >= 0)
+            return true;
+        pos->key_index++;
+    }
+    return true;
+}
+
+static void start_results(ContactSearch *search)
+{
+    BPTreePos pos = search->stack[search->len];
+    search->found = 0;
+    search->complete = true;
+    search->page_first = 0;
+    search->page_count = 0;
+    search->mark_count = 0;
+    search->mark_stride = CONTACT_SEARCH_MARK_STRIDE;
+    if (pos.leaf != 0 && compare_key(search, &pos) == 0)
+    {
+        search->page[0] = pos;
+        search->page_count = 1;
+        search->marks[0] = pos;
+        search->mark_count = 1;
+        search->found = 1;
+        search->complete = false;
+    }
+}
+
+static bool next_match(ContactSearch *search, BPTreePos *pos)
+{
+    pos->key_index++;
+    if (settle(search, pos, NULL) && compare_key(search, pos) == 0)
+        return true;
+    search->complete = true;
+    return false;
+}
+
+/*
+    Count a result reached by a walk and checkpoint it if it falls on the
+    stride. Walks only ever step one result at a time from an earlier
+    position, so new results arrive in order.
+*/
+static void note_result(ContactSearch *search, uint32_t index, const BPTreePos *pos)
+{
+    if (index < search->found)
+        return;
+    search->found = index + 1;
+    if (index % search->mark_stride != 0)
+        return;
+
+    if (search->mark_count == CONTACT_SEARCH_MARKS)
+    {
+        // out of checkpoints: keep every other one, twice as far apart
+        for (int i = 0; i < CONTACT_SEARCH_MARKS / 2; i++)
+            search->marks[i] = search->marks[2 * i];
+        search->mark_count = CONTACT_SEARCH_MARKS / 2;
+        search->mark_stride *= 2;
+        if (index % search->mark_stride != 0)
+            return;
+    }
+    search->marks[search->mark_count++] = *pos;
+}
+
+static void page_append(ContactSearch *search, const BPTreePos *pos)
+{
+    if (search->page_count == CONTACT_SEARCH_PAGE)
+    {
+        memmove(&search->page[0], &search->page[1], (CONTACT_SEARCH_PAGE - 1) * sizeof(BPTreePos));
+        search->page_first++;
+        search->page_count--;
+    }
+    search->page[search->page_count++] = *pos;
+}
+
+/*
+    Find the position of a result. Rows on the page cost nothing, rows
+    shortly after it slide the page forward, anything else restarts from
+    the checkpoint below. Scrolling back fills the page up to the wanted
+    row so the rows above it are ready; a jump centres the page on it.
+*/
+static bool locate(ContactSearch *search, uint32_t index, BPTreePos *out)
+{
+    if (search->mark_count == 0 || (search->complete && index >= search->found))
+        return false;
+
+    uint32_t page_end = search->page_first + search->page_count;
+    if (index >= search->page_first && index < page_end)
+    {
+        *out = search->page[index - search->page_first];
+        return true;
+    }
+
+    BPTreePos pos;
+    uint32_t at;
+    if (search->page_count > 0 && index >= page_end && index < page_end + CONTACT_SEARCH_PAGE)
+    {
+        pos = search->page[search->page_count - 1];
+        at = page_end - 1;
+    }
+    else
+    {
+        uint32_t first;
+        if (index < search->page_first)
+            first = index >= CONTACT_SEARCH_PAGE - 1 ? index - (CONTACT_SEARCH_PAGE - 1) : 0;
+        else
+            first = index >= CONTACT_SEARCH_PAGE / 2 ? index - CONTACT_SEARCH_PAGE / 2 : 0;
+
+        uint32_t mark = first / search->mark_stride;
+        if (mark >= search->mark_count)
+            mark = search->mark_count - 1;
+        pos = search->marks[mark];
+        at = mark * search->mark_stride;
+        while (at < first)
+        {
+            if (!next_match(search, &pos))
+                return false;
+            note_result(search, ++at, &pos);
+        }
+        search->page_first = at;
+        search->page[0] = pos;
+        search->page_count = 1;
+    }
+
+    while (at < index)
+    {
+        if (!next_match(search, &pos))
+            return false;
+        note_result(search, ++at, &pos);
+        page_append(search, &pos);
+    }
+    *out = pos;
+    return true;
+}
+
+void contact_search_init(ContactSearch *search, BPTree *tree)
+{
+    memset(search, 0, sizeof(*search));
+    search->tree = tree;
+
+    // walk the leftmost branch, noting the depth so descents can be costed
+    BPTreeNode node;
+    uint32_t offset = tree->root_offset;
+    while (1)
+    {
+        search->depth++;
+        search->reads++;
+        if (!bptree_read_node(tree, offset, &node))
+            break;
+        if (node.type == LEAF)
+        {
+            search->leaf = node;
+            search->leaf_offset = offset;
+            break;
+        }
+        offset = node.children[0];
+    }
+
+    BPTreePos first = {offset, 0};
+    settle(search, &first, NULL);
+    search->stack[0] = first;
+    start_results(search);
+}
+
+bool contact_search_push(ContactSearch *search, char c)
+{
+    if (search->len >= MAX_KEY_LEN - 1 || c == '\0')
+        return false;
+
+    BPTreePos pos = search->stack[search->len];
+    search->prefix[search->len++] = c;
+    search->prefix[search->len] = '\0';
+
+    // the new first match cannot be before the old one, so scan forward from it
+    if (!scan_lower_bound(search, &pos, CONTACT_SEARCH_SCAN_LEAVES))
+    {
+        pos.leaf = bptree_find_leaf(search->tree, search->prefix);
+        pos.key_index = 0;
+        search->reads += search->depth;
+        scan_lower_bound(search, &pos, -1);
+    }
+
+    search->stack[search->len] = pos;
+    start_results(search);
+    return search->found > 0;
+}
+
+bool contact_search_pop(ContactSearch *search)
+{
+    if (search->len == 0)
+        return false;
+
+    search->prefix[--search->len] = '\0';
+    // the cursor for the shorter prefix is already on the stack
+    start_results(search);
+    return true;
+}
+
+int contact_search_discover(ContactSearch *search, int n)
+{
+    BPTreePos pos;
+    if (n > 0 && (uint32_t)n > search->found)
+        locate(search, (uint32_t)n - 1, &pos);
+    return (int)search->found;
+}
+
+int contact_search_count(const ContactSearch *search)
+{
+    return (int)search->found + (search->complete ? 0 : 1);
+}
+
+bool contact_search_get(ContactSearch *search, int index, ContactRecord *out)
+{
+    BPTreePos pos;
+    if (index < 0 || !locate(search, (uint32_t)index, &pos))
+        return false;
+
+    const BPTreeNode *leaf = load_leaf(search, pos.leaf);
+    if (!leaf)
+        return false;
+    return contacts_read(search->tree->data_file, leaf->children[pos.key_index], out);
+}
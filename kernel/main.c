@@ -13,8 +13,13 @@
 #include "gpio.h"
 #include "kernel.h"
 #include "stm32_config.h"
+#include "mem_sections.h"
+#include "trace.h"
+#include "profile.h"
+#include "boot_timeline.h"
+#include "task.h"
+#include <string.h>
 #include "sm64_mario_boing.h"
-#include "ws2812.h"
 
 void SystemClock_Config(void);
 static void MPU_Config(void);
@@ -23,10 +28,30 @@ void PeriphCommonClock_Config(void);
 int main(void)
 {
 
+  // the tick starts in HAL_Init(), the phase begins at 0 either way
+  boot_phase_begin(BOOT_PHASE_CLOCKS, HAL_GetTick());
   MPU_Config();
+  // the DMA section is NOLOAD, so startup leaves it as reset left it
+  memset(_sdma_buffers, 0, (size_t)(_edma_buffers - _sdma_buffers));
+  // startup only copies .data, RAMFUNC code is copied here before its first call
+  memcpy(_sitcm, _siitcm, (size_t)(_eitcm - _sitcm));
+  __DSB();
+  __ISB();
+  SCB_EnableICache();
+  SCB_EnableDCache();
   HAL_Init();
   SystemClock_Config();
+#if defined(TRACE_ENABLED)
+  // before any task or queue exists, so every name is recorded
+  trace_init(SystemCoreClock);
+#endif
+#if defined(PROFILE_ENABLED)
+  profile_init(SystemCoreClock);
+#endif
   PeriphCommonClock_Config();
+  boot_phase_end(BOOT_PHASE_CLOCKS, true, HAL_GetTick());
+
+  boot_phase_begin(BOOT_PHASE_PERIPHERALS, HAL_GetTick());
   MX_GPIO_Init();
   MX_SPI4_Init();
   MX_I2C1_Init();
@@ -36,19 +61,18 @@ int main(void)
   MX_TIM3_Init();
   MX_USART1_UART_Init();
 
-  // start LEDS immediately
+  // power the LED rail now, the boot task lights the LEDs once it has settled
   HAL_GPIO_WritePin(LOAD_SW_GPIO_Port, GPIO_PIN_1, GPIO_PIN_SET);
   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_6, GPIO_PIN_SET);
-  HAL_Delay(100);
-  ws2812_init();
-  ws2812_set_brightness(10);
-  ws2812_fill_led(0xFF, 0x00, 0xFF);
-  ws2812_update_leds();
+  boot_phase_end(BOOT_PHASE_PERIPHERALS, true, HAL_GetTick());
 
+  // each task brings up its own hardware, side by side, once the scheduler starts
+  boot_phase_begin(BOOT_PHASE_KERNEL, HAL_GetTick());
   osKernelInitialize();
   // dont want to use generated freertos init
   // MX_FREERTOS_Init();
   kernel_init();
+  boot_phase_end(BOOT_PHASE_KERNEL, true, HAL_GetTick());
 
   osKernelStart();
 
@@ -154,6 +178,40 @@ void MPU_Config(void)
   MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
 
   HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+#if defined(DISPLAY_BUS_FMC)
+  /* LCD on FMC bank 1 (swapped to 0xC0000000): shareable device memory,
+     covering both the command and data addresses */
+  MPU_InitStruct.Number = MPU_REGION_NUMBER1;
+  MPU_InitStruct.BaseAddress = 0xC0000000;
+  MPU_InitStruct.Size = MPU_REGION_SIZE_256KB;
+  MPU_InitStruct.SubRegionDisable = 0x00;
+  MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+  MPU_InitStruct.IsBufferable = MPU_ACCESS_BUFFERABLE;
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+#endif
+
+  /* DMA buffers at the start of AXI SRAM (.dma_buffers): normal memory,
+     non-cacheable, so IDMA and the CPU always see the same bytes */
+  MPU_InitStruct.Number = MPU_REGION_NUMBER2;
+  MPU_InitStruct.BaseAddress = 0x24000000;
+  MPU_InitStruct.Size = MPU_REGION_SIZE_32KB;
+  MPU_InitStruct.SubRegionDisable = 0x00;
+  MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+  MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+  MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+  MPU_InitStruct.IsShareable = MPU_ACCESS_SHAREABLE;
+  MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+  MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+  /* Backup SRAM: non-cacheable, so the health record written before a
+     watchdog reset is in the RAM and not left behind in the D-cache */
+  MPU_InitStruct.Number = MPU_REGION_NUMBER3;
+  MPU_InitStruct.BaseAddress = D3_BKPSRAM_BASE;
+  MPU_InitStruct.Size = MPU_REGION_SIZE_4KB;
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
   /* Enables the MPU */
   HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
 }
@@ -167,6 +225,36 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
   }
 }
 
+/**
+ * @brief Wait for Delay milliseconds
+ * @param Delay Delay in milliseconds
+ *
+ * Replaces the HAL's busy-wait. Once the scheduler runs, a task waiting on a
+ * driver's settle time sleeps instead, so the tasks bringing up their
+ * hardware side by side do not hold each other off the CPU. Interrupts,
+ * critical sections and the start-up code before the scheduler still spin.
+ */
+void HAL_Delay(uint32_t Delay)
+{
+  if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING && !xPortIsInsideInterrupt() &&
+      __get_PRIMASK() == 0 && __get_BASEPRI() == 0)
+  {
+    // one tick more, like the HAL, so the wait is at least Delay
+    vTaskDelay(Delay < HAL_MAX_DELAY ? pdMS_TO_TICKS(Delay) + 1 : portMAX_DELAY);
+    return;
+  }
+
+  uint32_t tickstart = HAL_GetTick();
+  uint32_t wait = Delay;
+  if (wait < HAL_MAX_DELAY)
+  {
+    wait += (uint32_t)(uwTickFreq);
+  }
+  while ((HAL_GetTick() - tickstart) < wait)
+  {
+  }
+}
+
 /**
  * @brief  This function is executed in case of error occurrence.
  * @retval None
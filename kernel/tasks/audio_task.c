@@ -1,4 +1,12 @@
 #include "audio_task.h"
+#include "event_bus.h"
+#include "boot_timeline.h"
+#include "input_pipeline.h"
+#include "mem_sections.h"
+#include "trace.h"
+#include "profile.h"
+
+#define AUDIO_QUEUE_LENGTH 5
 
 int16_t tick[] = {
     // sharp attack
@@ -36,6 +44,17 @@ struct AudioTaskContext
 
 typedef void (*AudioCmdHandler)(AudioTaskContext *ctx, AudioMessage *msg);
 
+// every buffer sent to the codec is one span in a trace and one audio zone sample
+static HAL_StatusTypeDef play_buffer(const int16_t *samples, uint16_t count)
+{
+    TRACE_BEGIN(TRACE_AUDIO_BUFFER, count, 0);
+    PROFILE_ZONE_BEGIN(PROFILE_AUDIO_BUFFER);
+    HAL_StatusTypeDef status = HAL_I2S_Transmit(&AUDIO_I2S_HANDLE, (uint16_t *)samples, count, HAL_MAX_DELAY);
+    PROFILE_ZONE_END(PROFILE_AUDIO_BUFFER);
+    TRACE_END(TRACE_AUDIO_BUFFER, count, status);
+    return status;
+}
+
 /* ===== HANDLERS ===== */
 static void handle_volume_up(AudioTaskContext *ctx, AudioMessage *msg)
 {
@@ -193,7 +212,7 @@ static void handle_select_mic(AudioTaskContext *ctx, AudioMessage *msg)
 
 static void handle_play_tick(AudioTaskContext *ctx, AudioMessage *msg)
 {
-    HAL_I2S_Transmit(&AUDIO_I2S_HANDLE, (uint16_t *)tick, 50, HAL_MAX_DELAY);
+    play_buffer(tick, 50);
 }
 
 static void handle_play_bloop(AudioTaskContext *ctx, AudioMessage *msg)
@@ -201,7 +220,7 @@ static void handle_play_bloop(AudioTaskContext *ctx, AudioMessage *msg)
     // Play the base pattern multiple times to create the full bloop sound
     for (int i = 0; i < BLOOP_REPEAT_COUNT; i++)
     {
-        HAL_I2S_Transmit(&AUDIO_I2S_HANDLE, (uint16_t *)bloop_base, BLOOP_BASE_SIZE, HAL_MAX_DELAY);
+        play_buffer(bloop_base, BLOOP_BASE_SIZE);
     }
 }
 
@@ -260,7 +279,9 @@ static void audio_task_main(void *pvParameters)
     AudioMessage msg;
 
     ctx->codec = nau88c22_get_driver();
+    boot_phase_begin(BOOT_PHASE_CODEC, HAL_GetTick());
     ctx->codec->init();
+    boot_phase_end(BOOT_PHASE_CODEC, true, HAL_GetTick());
     ctx->settings.volume_speaker = 100;
     ctx->settings.volume_headphones = 100;
     ctx->settings.volume_mic_int = 50;
@@ -306,18 +327,53 @@ static void audio_task_main(void *pvParameters)
     }
 }
 
+/* ===== KEY CLICKS ===== */
+
+// Click on key presses only; volume keys step the volume instead
+static bool key_click_filter(const Event *event, void *arg)
+{
+    uint8_t key = EVENT_KEY(event->value);
+    return EVENT_KEY_ACTION(event->value) == KEY_ACTION_PRESS && key != INPUT_VOLUME_UP &&
+           key != INPUT_VOLUME_DOWN;
+}
+
+static bool key_click_sink(const Event *event, void *arg)
+{
+    uint8_t key = EVENT_KEY(event->value);
+    AudioCommand cmd = (key >= INPUT_KEYPAD_0 && key <= INPUT_KEYPAD_9) ? AUDIO_PLAY_TICK : AUDIO_PLAY_BLOOP;
+    return AudioTask_PostCommand((AudioTaskContext *)arg, cmd, NULL);
+}
+
 AudioTaskContext *AudioTask_Init(void)
 {
-    static AudioTaskContext audio_ctx;
+    static AudioTaskContext audio_ctx DTCM_BSS;
+    static StaticTask_t audio_tcb DTCM_BSS;
+    static StackType_t audio_stack[AUDIO_TASK_STACK_SIZE / sizeof(StackType_t)] DTCM_BSS __attribute__((aligned(8)));
+    static StaticQueue_t audio_queue DTCM_BSS;
+    static uint8_t audio_queue_storage[AUDIO_QUEUE_LENGTH * sizeof(AudioMessage)] DTCM_BSS;
+
     memset(&audio_ctx, 0, sizeof(audio_ctx));
-    audio_ctx.queue = xQueueCreate(5, sizeof(AudioMessage));
+    audio_ctx.queue = xQueueCreateStatic(AUDIO_QUEUE_LENGTH, sizeof(AudioMessage), audio_queue_storage, &audio_queue);
+    vQueueAddToRegistry(audio_ctx.queue, "audio");
 
     osThreadAttr_t task_attr = {
         .name = "AudioTask",
-        .stack_size = AUDIO_TASK_STACK_SIZE,
+        .cb_mem = &audio_tcb,
+        .cb_size = sizeof(audio_tcb),
+        .stack_mem = audio_stack,
+        .stack_size = sizeof(audio_stack),
         .priority = AUDIO_TASK_PRIORITY};
     osThreadNew(audio_task_main, &audio_ctx, &task_attr);
 
+    // the task queue is the subscriber queue, posting to it wakes the task
+    EventSubscription clicks = {
+        .name = "audio-clicks",
+        .topics = EVENT_TOPIC_BIT(EVENT_TOPIC_KEY),
+        .filter = key_click_filter,
+        .sink = key_click_sink,
+        .arg = &audio_ctx};
+    event_bus_subscribe(&clicks);
+
     return &audio_ctx;
 }
 
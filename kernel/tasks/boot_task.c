@@ -0,0 +1,77 @@
+#include "boot_task.h"
+#include "boot_timeline.h"
+#include "stm32_config.h"
+#include "stm32h7xx_hal.h"
+#include "task.h"
+#include "fatfs.h"
+#include "sdmmc.h"
+#include "sdcard.h"
+#include "ws2812.h"
+#include "mem_sections.h"
+
+static void boot_leds(void)
+{
+    boot_phase_begin(BOOT_PHASE_LEDS, HAL_GetTick());
+    // main() switched the rail on, the strip needs it settled before the first bit
+    HAL_Delay(BOOT_LED_SETTLE_MS);
+
+    // the bits are timed by polling the PWM period, a task switch would stretch one
+    vTaskSuspendAll();
+    ws2812_init();
+    ws2812_set_brightness(10);
+    ws2812_fill_led(0xFF, 0x00, 0xFF);
+    ws2812_update_leds();
+    xTaskResumeAll();
+    boot_phase_end(BOOT_PHASE_LEDS, true, HAL_GetTick());
+}
+
+static void boot_sd_card(void)
+{
+    boot_phase_begin(BOOT_PHASE_SD_CARD, HAL_GetTick());
+#if defined(__arm__)
+    MX_SDMMC1_SD_Init();
+#endif
+    MX_FATFS_Init();
+    bool mounted = sdcard_init() == 0;
+    boot_phase_end(BOOT_PHASE_SD_CARD, mounted, HAL_GetTick());
+}
+
+static void log_line(const char *line, void *arg)
+{
+    (void)arg;
+    DEBUG_PRINTF("boot: %s\r\n", line);
+}
+
+static void boot_task_main(void *pvParameters)
+{
+    (void)pvParameters;
+
+    boot_leds();
+    boot_sd_card();
+
+    // the modem takes seconds, the report is logged once it and the rest are up
+    uint32_t start = HAL_GetTick();
+    while (!boot_finished() && HAL_GetTick() - start < BOOT_REPORT_TIMEOUT_MS)
+    {
+        osDelay(BOOT_POLL_PERIOD_MS);
+    }
+    boot_timeline_report(log_line, NULL, HAL_GetTick());
+
+    vTaskDelete(NULL);
+}
+
+bool BootTask_Init(void)
+{
+    static StaticTask_t boot_tcb DTCM_BSS;
+    static StackType_t boot_stack[BOOT_TASK_STACK_SIZE / sizeof(StackType_t)] DTCM_BSS __attribute__((aligned(8)));
+
+    osThreadAttr_t task_attr = {
+        .name = "BootTask",
+        .cb_mem = &boot_tcb,
+        .cb_size = sizeof(boot_tcb),
+        .stack_mem = boot_stack,
+        .stack_size = sizeof(boot_stack),
+        .priority = BOOT_TASK_PRIORITY};
+
+    return osThreadNew(boot_task_main, NULL, &task_attr) != NULL;
+}
@@ -1,15 +1,23 @@
 #include "call_state.h"
 #include "tim.h"
+#include "msg_pool.h"
+#include "event_bus.h"
+#include "health_monitor.h"
+#include "boot_timeline.h"
+#include "mem_sections.h"
+#include "trace.h"
 #include <string.h>
 
+#define CALL_QUEUE_LENGTH 5
+
 // Call state context structure
 struct CallStateContext
 {
     CallState current_state;
     EventGroupHandle_t event_group;
     QueueHandle_t queue;
-    DisplayTaskContext *display_ctx;
     char caller_id[32];
+    int health; // heartbeat checked by the watchdog task
 };
 
 // Helper functions
@@ -31,41 +39,20 @@ static void set_gpio_call_mode(uint8_t enabled)
     HAL_GPIO_WritePin(AUDIO_SW_PORT, AUDIO_SW_PIN, enabled ? GPIO_PIN_SET : GPIO_PIN_RESET);
 }
 
-static void update_display(CallStateContext *ctx)
+// Publish the current state; the caller ID travels as a CallData message
+static void publish_state(CallStateContext *ctx)
 {
-    if (!ctx->display_ctx)
-        return;
-
-    // Post display commands with just the caller_id string
-    // Display task will handle the UI rendering
-    switch (ctx->current_state)
+    CallData *call_data = NULL;
+    if (ctx->current_state == CALL_STATE_RINGING || ctx->current_state == CALL_STATE_ACTIVE ||
+        ctx->current_state == CALL_STATE_DIALLING)
     {
-    case CALL_STATE_RINGING:
-        // Incoming call - show incoming call overlay
-        DisplayTask_PostCommand(ctx->display_ctx, DISPLAY_INCOMING_CALL, ctx->caller_id);
-        break;
-
-    case CALL_STATE_ACTIVE:
-        // Call picked up - show active call screen
-        DisplayTask_PostCommand(ctx->display_ctx, DISPLAY_ACTIVE_CALL, ctx->caller_id);
-        break;
-
-    case CALL_STATE_ENDING:
-        // Call hung up - return to previous screen or idle
-        DisplayTask_PostCommand(ctx->display_ctx, DISPLAY_CALL_ENDED, NULL);
-        break;
-
-    case CALL_STATE_DIALLING:
-        // Dialling out - show dialling screen
-        DisplayTask_PostCommand(ctx->display_ctx, DISPLAY_DIALLING, ctx->caller_id);
-        break;
-
-    case CALL_STATE_IDLE:
-    default:
-        // No call - ensure we're back to normal screen
-        // This might not need any special display command
-        break;
+        call_data = msg_alloc(MSG_TYPE_CALL_DATA, sizeof(*call_data));
+        if (call_data)
+        {
+            memcpy(call_data->caller_id, ctx->caller_id, sizeof(call_data->caller_id));
+        }
     }
+    event_bus_publish(EVENT_TOPIC_CALL_STATE, ctx->current_state, call_data);
 }
 
 // Process call commands directly
@@ -78,7 +65,10 @@ static void process_call_command(CallStateContext *ctx, CallMessage *msg)
         if (ctx->current_state == CALL_STATE_IDLE || ctx->current_state == CALL_STATE_RINGING)
         {
             ctx->current_state = CALL_STATE_RINGING;
-            if (msg->data)
+            // keep what led up to the call and a quarter ring of what follows
+            TRACE_EVENT(TRACE_INCOMING_CALL, 0, 0);
+            trace_trigger(TRACE_RING_SIZE / 4);
+            if (msg_type(msg->data) == MSG_TYPE_CALL_DATA)
             {
                 CallData *call_data = (CallData *)msg->data;
                 strncpy(ctx->caller_id, call_data->caller_id, sizeof(ctx->caller_id) - 1);
@@ -100,7 +90,7 @@ static void process_call_command(CallStateContext *ctx, CallMessage *msg)
         if (ctx->current_state == CALL_STATE_IDLE)
         {
             ctx->current_state = CALL_STATE_DIALLING;
-            if (msg->data)
+            if (msg_type(msg->data) == MSG_TYPE_CALL_DATA)
             {
                 CallData *call_data = (CallData *)msg->data;
                 strncpy(ctx->caller_id, call_data->caller_id, sizeof(ctx->caller_id) - 1);
@@ -130,11 +120,15 @@ static void call_state_task_main(void *pvParameters)
     EventBits_t event_bits;
 
     // Initialize hardware
-    drv2603_init();
+    boot_phase_begin(BOOT_PHASE_HAPTICS, HAL_GetTick());
+    bool haptics_ok = drv2603_init() == 0;
+    boot_phase_end(BOOT_PHASE_HAPTICS, haptics_ok, HAL_GetTick());
 
     // Main task loop
     for (;;)
     {
+        health_heartbeat(ctx->health, HAL_GetTick());
+
         // Wait for events with timeout
         event_bits = xEventGroupWaitBits(
             ctx->event_group,
@@ -174,14 +168,19 @@ static void call_state_task_main(void *pvParameters)
 
         if (event_bits & CALL_EVENT_DISPLAY)
         {
-            // Update display
-            update_display(ctx);
+            // Tell subscribers about the new state
+            publish_state(ctx);
         }
 
         // Process any queued commands
         while (xQueueReceive(ctx->queue, &msg, 0))
         {
             process_call_command(ctx, &msg);
+            // caller data arrives as a pool message whose reference ends here
+            if (msg_pool_owns(msg.data))
+            {
+                msg_release(msg.data);
+            }
         }
 
         // Yield to other tasks - critical for system responsiveness
@@ -190,24 +189,31 @@ static void call_state_task_main(void *pvParameters)
 }
 
 // Public API implementation
-CallStateContext *CallState_Init(DisplayTaskContext *display_ctx)
+CallStateContext *CallState_Init(void)
 {
-    static CallStateContext call_ctx;
+    static CallStateContext call_ctx DTCM_BSS;
+    static StaticTask_t call_tcb DTCM_BSS;
+    static StackType_t call_stack[CALL_STATE_TASK_STACK_SIZE / sizeof(StackType_t)] DTCM_BSS __attribute__((aligned(8)));
+    static StaticQueue_t call_queue DTCM_BSS;
+    static uint8_t call_queue_storage[CALL_QUEUE_LENGTH * sizeof(CallMessage)] DTCM_BSS;
+    static StaticEventGroup_t call_events DTCM_BSS;
+
     memset(&call_ctx, 0, sizeof(call_ctx));
+    call_ctx.health = health_register("call", CALL_STATE_TASK_HEARTBEAT_MS, true);
 
     // Initialize context
     call_ctx.current_state = CALL_STATE_IDLE;
-    call_ctx.display_ctx = display_ctx;
 
     // Create event group
-    call_ctx.event_group = xEventGroupCreate();
+    call_ctx.event_group = xEventGroupCreateStatic(&call_events);
     if (!call_ctx.event_group)
     {
         return NULL;
     }
 
     // Create queue
-    call_ctx.queue = xQueueCreate(5, sizeof(CallMessage));
+    call_ctx.queue = xQueueCreateStatic(CALL_QUEUE_LENGTH, sizeof(CallMessage), call_queue_storage, &call_queue);
+    vQueueAddToRegistry(call_ctx.queue, "call");
     if (!call_ctx.queue)
     {
         vEventGroupDelete(call_ctx.event_group);
@@ -217,7 +223,10 @@ CallStateContext *CallState_Init(DisplayTaskContext *display_ctx)
     // Create and start the task
     osThreadAttr_t task_attr = {
         .name = "CallStateTask",
-        .stack_size = CALL_STATE_TASK_STACK_SIZE,
+        .cb_mem = &call_tcb,
+        .cb_size = sizeof(call_tcb),
+        .stack_mem = call_stack,
+        .stack_size = sizeof(call_stack),
         .priority = CALL_STATE_TASK_PRIORITY};
 
     osThreadId_t thread_id = osThreadNew(call_state_task_main, &call_ctx, &task_attr);
@@ -231,26 +240,22 @@ CallStateContext *CallState_Init(DisplayTaskContext *display_ctx)
     return &call_ctx;
 }
 
-void CallState_SetDisplayContext(CallStateContext *ctx, DisplayTaskContext *display_ctx)
-{
-    if (ctx)
-    {
-        ctx->display_ctx = display_ctx;
-    }
-}
-
 bool CallState_PostCommand(CallStateContext *ctx, CallCommand cmd, void *data)
 {
-    if (!ctx || !ctx->queue)
-    {
-        return false;
-    }
-
     CallMessage msg = {
         .cmd = cmd,
         .data = data};
 
-    return xQueueSend(ctx->queue, &msg, pdMS_TO_TICKS(10)) == pdTRUE;
+    if (!ctx || !ctx->queue || xQueueSend(ctx->queue, &msg, pdMS_TO_TICKS(10)) != pdTRUE)
+    {
+        // the caller handed its reference over, so it is dropped here
+        if (msg_pool_owns(data))
+        {
+            msg_release(data);
+        }
+        return false;
+    }
+    return true;
 }
 
 CallState CallState_GetCurrentState(CallStateContext *ctx)
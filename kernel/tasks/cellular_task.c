@@ -1,4 +1,11 @@
 #include "cellular_task.h"
+#include "msg_pool.h"
+#include "event_bus.h"
+#include "health_monitor.h"
+#include "boot_timeline.h"
+#include "mem_sections.h"
+
+#define CELLULAR_QUEUE_LENGTH 5
 
 // Static task handle for ISR access
 static TaskHandle_t g_cellular_task_handle = NULL;
@@ -22,9 +29,11 @@ static uint8_t dbm_to_signal_bars(int16_t dbm_value)
 // Sync onboard RTC with cellular modem clock via display task
 static uint8_t sync_rtc_with_modem(DisplayTaskContext *display_ctx)
 {
-    static RtcSyncData rtc_data; // Static to persist until display task processes it
-    modem_get_clock(&rtc_data.date, &rtc_data.time);
-    DisplayTask_PostCommand(display_ctx, DISPLAY_SYNC_RTC, &rtc_data);
+    RtcSyncData *rtc_data = msg_alloc(MSG_TYPE_RTC_SYNC, sizeof(*rtc_data));
+    if (!rtc_data)
+        return 1;
+    modem_get_clock(&rtc_data->date, &rtc_data->time);
+    DisplayTask_PostCommand(display_ctx, DISPLAY_SYNC_RTC, rtc_data);
 
     return 0;
 }
@@ -72,6 +81,7 @@ struct CellularTaskContext
     DisplayTaskContext *display_ctx;
     CallStateContext *call_ctx;
     uint8_t signal_bars;
+    int health; // heartbeat checked by the watchdog task
 };
 
 typedef void (*CellularCmdHandler)(CellularTaskContext *ctx, CellularMessage *msg);
@@ -130,7 +140,14 @@ static void handle_send_sms(CellularTaskContext *ctx, CellularMessage *msg)
 static void handle_dial(CellularTaskContext *ctx, CellularMessage *msg)
 {
     modem_dial(msg->data);
-    CallState_PostCommand(ctx->call_ctx, CALL_CMD_DIALLING, msg->data);
+
+    CallData *call_data = msg_alloc(MSG_TYPE_CALL_DATA, sizeof(*call_data));
+    if (call_data)
+    {
+        strncpy(call_data->caller_id, msg->data ? (const char *)msg->data : "", sizeof(call_data->caller_id) - 1);
+        call_data->caller_id[sizeof(call_data->caller_id) - 1] = '\0';
+    }
+    CallState_PostCommand(ctx->call_ctx, CALL_CMD_DIALLING, call_data);
 }
 
 static void handle_hang_up(CellularTaskContext *ctx, CellularMessage *msg)
@@ -176,12 +193,17 @@ static void cellular_task_main(void *pvParameters)
     uint32_t last_rtc_sync = 0;
     bool rtc_synced_on_boot = false;
 
-    modem_init();
+    // seconds of power-up and AT set-up, the UI is already running
+    boot_phase_begin(BOOT_PHASE_MODEM, HAL_GetTick());
+    bool modem_ok = modem_init() == 0;
+    boot_phase_end(BOOT_PHASE_MODEM, modem_ok, HAL_GetTick());
     // pull down to prevent sleep
     HAL_GPIO_WritePin(UART_DTR_GPIO_Port, UART_DTR_Pin, GPIO_PIN_RESET);
 
     for (;;)
     {
+        health_heartbeat(ctx->health, HAL_GetTick());
+
         // Wait for RI notification OR timeout (1 second for periodic signal check)
         // ulTaskNotifyTake: clears notification on exit, blocks with timeout
         uint32_t notification_value = ulTaskNotifyTake(
@@ -204,33 +226,35 @@ static void cellular_task_main(void *pvParameters)
             case MODEM_EVENT_INCOMING_CALL:
             {
                 // Incoming call detected - notify call state task
-                CallData call_data;
-                if (caller_id[0] != '\0')
+                CallData *call_data = msg_alloc(MSG_TYPE_CALL_DATA, sizeof(*call_data));
+                if (call_data)
                 {
-                    strncpy(call_data.caller_id, caller_id, sizeof(call_data.caller_id) - 1);
-                    call_data.caller_id[sizeof(call_data.caller_id) - 1] = '\0';
+                    strncpy(call_data->caller_id, caller_id[0] != '\0' ? caller_id : "Unknown",
+                            sizeof(call_data->caller_id) - 1);
+                    call_data->caller_id[sizeof(call_data->caller_id) - 1] = '\0';
                 }
-                else
-                {
-                    strncpy(call_data.caller_id, "Unknown", sizeof(call_data.caller_id) - 1);
-                }
-                CallState_PostCommand(ctx->call_ctx, CALL_CMD_INCOMING_CALL, &call_data);
+                CallState_PostCommand(ctx->call_ctx, CALL_CMD_INCOMING_CALL, call_data);
                 break;
             }
 
             case MODEM_EVENT_INCOMING_SMS:
             {
                 // Incoming SMS detected - retrieve and process
-                // Static so data persists until display task processes it
-                // Note: Will be overwritten if another SMS arrives before user views this one
-                static ReceivedSms received_sms;
-                memset(&received_sms, 0, sizeof(received_sms));
-
-                if (modem_read_sms(sms_index, received_sms.sender, sizeof(received_sms.sender),
-                                   received_sms.body, sizeof(received_sms.body), memtype) == 0)
+                // Each SMS gets its own pool message, so a second one arriving
+                // before the user views the first cannot overwrite it
+                ReceivedSms *received_sms = msg_alloc(MSG_TYPE_SMS, sizeof(*received_sms));
+                if (!received_sms)
+                    break;
+                memset(received_sms, 0, sizeof(*received_sms));
+
+                if (modem_read_sms(sms_index, received_sms->sender, sizeof(received_sms->sender),
+                                   received_sms->body, sizeof(received_sms->body), memtype) == 0)
                 {
-
-                    DisplayTask_PostCommand(ctx->display_ctx, DISPLAY_SHOW_SMS, &received_sms);
+                    event_bus_publish(EVENT_TOPIC_SMS_RECEIVED, 0, received_sms);
+                }
+                else
+                {
+                    msg_release(received_sms);
                 }
                 break;
             }
@@ -268,7 +292,7 @@ static void cellular_task_main(void *pvParameters)
             //     if (current_signal_bars != ctx->signal_bars)
             //     {
             //         ctx->signal_bars = current_signal_bars;
-            //         DisplayTask_PostCommand(ctx->display_ctx, DISPLAY_SET_SIGNAL_STATUS, &ctx->signal_bars);
+            //         event_bus_publish(EVENT_TOPIC_SIGNAL, ctx->signal_bars, NULL);
             //     }
             // }
         }
@@ -300,11 +324,17 @@ static void cellular_task_main(void *pvParameters)
 
 CellularTaskContext *CellularTask_Init(DisplayTaskContext *display_ctx, CallStateContext *call_ctx)
 {
-    static CellularTaskContext cellular_ctx;
+    static CellularTaskContext cellular_ctx DTCM_BSS;
+    static StaticTask_t cellular_tcb DTCM_BSS;
+    static StackType_t cellular_stack[CELLULAR_TASK_STACK_SIZE / sizeof(StackType_t)] DTCM_BSS __attribute__((aligned(8)));
+    static StaticQueue_t cellular_queue DTCM_BSS;
+    static uint8_t cellular_queue_storage[CELLULAR_QUEUE_LENGTH * sizeof(CellularMessage)] DTCM_BSS;
+
     memset(&cellular_ctx, 0, sizeof(cellular_ctx));
 
     // Create queue for commands
-    cellular_ctx.queue = xQueueCreate(5, sizeof(CellularMessage));
+    cellular_ctx.queue = xQueueCreateStatic(CELLULAR_QUEUE_LENGTH, sizeof(CellularMessage), cellular_queue_storage, &cellular_queue);
+    vQueueAddToRegistry(cellular_ctx.queue, "cellular");
     if (!cellular_ctx.queue)
     {
         return NULL;
@@ -312,6 +342,8 @@ CellularTaskContext *CellularTask_Init(DisplayTaskContext *display_ctx, CallStat
 
     cellular_ctx.display_ctx = display_ctx;
     cellular_ctx.call_ctx = call_ctx;
+    // AT commands can block for seconds, so a silent modem is reported without resetting
+    cellular_ctx.health = health_register("cellular", CELLULAR_TASK_HEARTBEAT_MS, false);
     cellular_ctx.signal_bars = 0;
 
     // Configure RI pin interrupt
@@ -319,7 +351,10 @@ CellularTaskContext *CellularTask_Init(DisplayTaskContext *display_ctx, CallStat
 
     osThreadAttr_t task_attr = {
         .name = "CellularTask",
-        .stack_size = CELLULAR_TASK_STACK_SIZE,
+        .cb_mem = &cellular_tcb,
+        .cb_size = sizeof(cellular_tcb),
+        .stack_mem = cellular_stack,
+        .stack_size = sizeof(cellular_stack),
         .priority = CELLULAR_TASK_PRIORITY};
 
     osThreadId_t thread_id = osThreadNew(cellular_task_main, &cellular_ctx, &task_attr);
@@ -0,0 +1,144 @@
+#include "contacts_task.h"
+#include "contacts_search.h"
+#include "display_task.h"
+#include "health_monitor.h"
+#include "mem_sections.h"
+#include <string.h>
+
+typedef struct
+{
+    QueueHandle_t requests;
+    QueueHandle_t replies;
+    DisplayTaskContext *display_ctx; // woken when an answer is queued
+    BPTree tree;
+    bool open;
+    ContactSearch searches[CONTACTS_CLIENT_COUNT]; // one per page, so each keeps its own cursor
+    int health;                                    // heartbeat checked by the watchdog task
+} ContactsTaskContext;
+
+static ContactsTaskContext contacts_ctx DTCM_BSS;
+
+// the card is mounted in the background after boot, so a failed open is tried again next time
+static bool tree_ready(ContactsTaskContext *ctx)
+{
+    if (ctx->open)
+        return true;
+
+    ctx->tree = bptree_create(CONTACTS_TREE_FILE, CONTACTS_DATA_FILE);
+    if (!ctx->tree.tree_file || !ctx->tree.data_file)
+    {
+        bptree_close(&ctx->tree);
+        return false;
+    }
+    for (int i = 0; i < CONTACTS_CLIENT_COUNT; i++)
+        contact_search_init(&ctx->searches[i], &ctx->tree);
+    ctx->open = true;
+    return true;
+}
+
+// backs up to the longest common prefix, so a query that grew by one character costs one push
+static void search_move_to(ContactSearch *search, const char *prefix)
+{
+    uint8_t common = 0;
+    while (common < search->len && prefix[common] == search->prefix[common])
+        common++;
+    while (search->len > common)
+        contact_search_pop(search);
+    for (uint8_t i = common; prefix[i] != '\0' && i < MAX_KEY_LEN - 1; i++)
+        contact_search_push(search, prefix[i]);
+}
+
+static void handle_request(ContactsTaskContext *ctx, const ContactsRequest *req)
+{
+    ContactsReply reply = {
+        .cmd = req->cmd,
+        .client = req->client,
+        .index = req->index};
+    memcpy(reply.prefix, req->prefix, sizeof(reply.prefix));
+
+    reply.available = tree_ready(ctx);
+    if (reply.available)
+    {
+        ContactSearch *search = &ctx->searches[req->client];
+        search_move_to(search, req->prefix);
+        if (req->cmd == CONTACTS_CMD_ROW)
+            contact_search_discover(search, req->index + CONTACTS_DISCOVER_AHEAD);
+        reply.has_contact = contact_search_get(search, req->index, &reply.contact);
+        reply.found = search->found;
+        reply.complete = search->complete;
+    }
+
+    // a dropped answer is asked for again by the list
+    if (xQueueSend(ctx->replies, &reply, pdMS_TO_TICKS(CONTACTS_REPLY_WAIT_MS)) == pdTRUE)
+        DisplayTask_Wake(ctx->display_ctx);
+}
+
+static void contacts_task_main(void *pvParameters)
+{
+    ContactsTaskContext *ctx = (ContactsTaskContext *)pvParameters;
+    ContactsRequest req;
+
+    for (;;)
+    {
+        health_heartbeat(ctx->health, HAL_GetTick());
+
+        // wake up now and then without requests so the heartbeat stays fresh
+        if (xQueueReceive(ctx->requests, &req, pdMS_TO_TICKS(CONTACTS_TASK_HEARTBEAT_MS / 2)))
+        {
+            handle_request(ctx, &req);
+        }
+    }
+}
+
+bool ContactsTask_Init(DisplayTaskContext *display_ctx)
+{
+    static StaticTask_t contacts_tcb DTCM_BSS;
+    static StackType_t contacts_stack[CONTACTS_TASK_STACK_SIZE / sizeof(StackType_t)] DTCM_BSS __attribute__((aligned(8)));
+    static StaticQueue_t request_queue DTCM_BSS;
+    static uint8_t request_storage[CONTACTS_REQUEST_QUEUE_LENGTH * sizeof(ContactsRequest)] DTCM_BSS;
+    static StaticQueue_t reply_queue DTCM_BSS;
+    static uint8_t reply_storage[CONTACTS_REPLY_QUEUE_LENGTH * sizeof(ContactsReply)] DTCM_BSS;
+
+    memset(&contacts_ctx, 0, sizeof(contacts_ctx));
+    contacts_ctx.display_ctx = display_ctx;
+    contacts_ctx.health = health_register("contacts", CONTACTS_TASK_HEARTBEAT_MS, false);
+
+    contacts_ctx.requests = xQueueCreateStatic(CONTACTS_REQUEST_QUEUE_LENGTH, sizeof(ContactsRequest),
+                                               request_storage, &request_queue);
+    contacts_ctx.replies = xQueueCreateStatic(CONTACTS_REPLY_QUEUE_LENGTH, sizeof(ContactsReply),
+                                              reply_storage, &reply_queue);
+    if (!contacts_ctx.requests || !contacts_ctx.replies)
+    {
+        return false;
+    }
+    vQueueAddToRegistry(contacts_ctx.requests, "contacts");
+    vQueueAddToRegistry(contacts_ctx.replies, "contacts-replies");
+
+    osThreadAttr_t task_attr = {
+        .name = "ContactsTask",
+        .cb_mem = &contacts_tcb,
+        .cb_size = sizeof(contacts_tcb),
+        .stack_mem = contacts_stack,
+        .stack_size = sizeof(contacts_stack),
+        .priority = CONTACTS_TASK_PRIORITY};
+
+    return osThreadNew(contacts_task_main, &contacts_ctx, &task_attr) != NULL;
+}
+
+bool ContactsTask_PostRequest(ContactsCommand cmd, ContactsClient client, const char *prefix, int index)
+{
+    if (!contacts_ctx.requests || client >= CONTACTS_CLIENT_COUNT)
+        return false;
+
+    ContactsRequest req = {
+        .cmd = cmd,
+        .client = (uint8_t)client,
+        .index = index};
+    strncpy(req.prefix, prefix, sizeof(req.prefix) - 1);
+    return xQueueSend(contacts_ctx.requests, &req, 0) == pdTRUE;
+}
+
+bool ContactsTask_GetReply(ContactsReply *reply)
+{
+    return contacts_ctx.replies && xQueueReceive(contacts_ctx.replies, reply, 0) == pdTRUE;
+}
@@ -5,14 +5,27 @@
 #include "incoming_text.h"
 #include "messages.h"
 #include "sms_types.h"
+#include "ui_timer.h"
+#include "msg_pool.h"
+#include "event_bus.h"
+#include "health_monitor.h"
+#include "boot_timeline.h"
+#include "contacts_task.h"
+#include "mem_sections.h"
 #include <string.h>
 
+#define DISPLAY_QUEUE_LENGTH 5
+
 struct DisplayTaskContext
 {
     QueueHandle_t queue;
     CallStateContext *call_ctx;        // Reference to call state for callbacks
     CellularTaskContext *cellular_ctx; // Reference to cellular task for callbacks
     PowerTaskContext *power_ctx;
+    TaskHandle_t task;       // notified to end the loop's sleep early
+    EventSubscriber *events; // battery, signal, SMS and call state events
+    CallData *call_data;     // caller ID shown by the incoming call overlay and call page
+    int health;              // heartbeat checked by the watchdog task
 };
 
 typedef void (*DisplayCmdHandler)(DisplayTaskContext *ctx, DisplayMessage *msg);
@@ -64,38 +77,75 @@ static void incoming_text_callback(int action, void *user_data)
     case INCOMING_TEXT_ACTION_CLOSE:
         screen_pop_page();
         break;
+    case INCOMING_TEXT_ACTION_DESTROY:
+        // the overlay's reference, taken in handle_sms_received
+        msg_release(sms_data);
+        break;
     default:
         break;
     }
 }
 
 /* ===== HANDLERS ===== */
+
+// Payload of a pool message of the expected type, NULL for anything else
+static void *message_payload(DisplayMessage *msg, MsgType type)
+{
+    return msg_type(msg->data) == type ? msg->data : NULL;
+}
+
+static void dispatch_input(DisplayTaskContext *ctx, int event)
+{
+    // Handle special cases like the test file
+    if (event == INPUT_RIGHT)
+    {
+        // Only allow popping page if not currently in a call
+        CallState current_state = CALL_STATE_IDLE;
+        if (ctx->call_ctx)
+        {
+            current_state = CallState_GetCurrentState(ctx->call_ctx);
+        }
+
+        // Prohibit popping page if in an active call (ringing, dialing, or active)
+        if (current_state == CALL_STATE_IDLE)
+        {
+            screen_pop_page();
+        }
+        // If in a call, ignore the INPUT_RIGHT button press
+    }
+    else
+    {
+        screen_handle_input(event);
+    }
+}
+
 static void handle_input_event(DisplayTaskContext *ctx, DisplayMessage *msg)
 {
     input_event_t *event = (input_event_t *)msg->data;
     if (event)
     {
-        // Handle special cases like the test file
-        if (*event == INPUT_RIGHT)
-        {
-            // Only allow popping page if not currently in a call
-            CallState current_state = CALL_STATE_IDLE;
-            if (ctx->call_ctx)
-            {
-                current_state = CallState_GetCurrentState(ctx->call_ctx);
-            }
+        dispatch_input(ctx, *event);
+    }
+}
 
-            // Prohibit popping page if in an active call (ringing, dialing, or active)
-            if (current_state == CALL_STATE_IDLE)
-            {
-                screen_pop_page();
-            }
-            // If in a call, ignore the INPUT_RIGHT button press
-        }
-        else
+static void handle_key_event(DisplayTaskContext *ctx, const KeyEvent *key)
+{
+    switch (key->action)
+    {
+    case KEY_ACTION_PRESS:
+    case KEY_ACTION_REPEAT:
+        // coalesced steps are replayed here, the screen is flushed once afterwards
+        for (uint16_t i = 0; i < key->count; i++)
         {
-            screen_handle_input(*event);
+            dispatch_input(ctx, key->key);
         }
+        break;
+    case KEY_ACTION_LONG_PRESS:
+        screen_handle_input(key->key | INPUT_FLAG_LONG_PRESS);
+        break;
+    case KEY_ACTION_RELEASE:
+        screen_handle_input(key->key | INPUT_FLAG_RELEASE);
+        break;
     }
 }
 
@@ -113,115 +163,136 @@ static void handle_clear_screen(DisplayTaskContext *ctx, DisplayMessage *msg)
     display_fill(COLOUR_BLACK);
 }
 
-static void handle_set_signal_status(DisplayTaskContext *ctx, DisplayMessage *msg)
+static void handle_set_volume(DisplayTaskContext *ctx, DisplayMessage *msg)
 {
-    uint8_t *signal = (uint8_t *)msg->data;
-    if (signal)
+    uint8_t *volume = (uint8_t *)message_payload(msg, MSG_TYPE_U8);
+    if (volume)
     {
-        status_bar_update_signal(*signal);
+        status_bar_show_volume(*volume);
     }
 }
 
-static void handle_set_battery_status(DisplayTaskContext *ctx, DisplayMessage *msg)
+static void handle_set_headphone_status(DisplayTaskContext *ctx, DisplayMessage *msg)
 {
-    uint8_t *battery = (uint8_t *)msg->data;
-    if (battery)
-    {
-        status_bar_update_battery(*battery);
-    }
+    // data is a bool cast to a pointer so nothing on the sender's stack is referenced
+    status_bar_update_headphones(msg->data != NULL);
 }
 
-static void handle_set_volume(DisplayTaskContext *ctx, DisplayMessage *msg)
+static void handle_set_battery_page(DisplayTaskContext *ctx, DisplayMessage *msg)
 {
-    uint8_t *volume = (uint8_t *)msg->data;
-    if (volume)
+    void *stats = message_payload(msg, MSG_TYPE_BATTERY_STATS);
+    if (stats)
     {
-        status_bar_show_volume(*volume);
+        screen_handle_response(PAGE_RESPONSE_BATTERY_HC, stats);
     }
 }
 
-static void handle_incoming_call(DisplayTaskContext *ctx, DisplayMessage *msg)
+static void handle_sync_rtc(DisplayTaskContext *ctx, DisplayMessage *msg)
 {
-    char *caller_id = (char *)msg->data;
-    if (caller_id && ctx->call_ctx)
+    RtcSyncData *rtc_data = (RtcSyncData *)message_payload(msg, MSG_TYPE_RTC_SYNC);
+    if (rtc_data)
     {
-        Page *incoming_call_page = incoming_call_overlay_create(caller_id, incoming_call_callback, ctx);
-        screen_push_page(incoming_call_page);
+        HAL_RTC_SetTime(&hrtc, &rtc_data->time, RTC_FORMAT_BIN);
+        HAL_RTC_SetDate(&hrtc, &rtc_data->date, RTC_FORMAT_BIN);
+        status_bar_invalidate(STATUS_FIELD_TIME);
     }
 }
 
-static void handle_active_call(DisplayTaskContext *ctx, DisplayMessage *msg)
+/* ===== EVENT BUS ===== */
+static void handle_sms_received(DisplayTaskContext *ctx, const Event *event)
 {
-    char *caller_id = (char *)msg->data;
-    if (caller_id)
+    ReceivedSms *sms_data = msg_type(event->data) == MSG_TYPE_SMS ? (ReceivedSms *)event->data : NULL;
+    if (sms_data)
     {
-        // TODO: Create active call page/overlay
-        // Page *active_call_page = active_call_overlay_create(caller_id, NULL, NULL);
-        // screen_push_page(active_call_page);
+        // Show SMS notification overlay with sender
+        // The full message is passed as user_data for when user opens it, the
+        // overlay keeps its own reference and drops it when destroyed
+        msg_retain(sms_data);
+        Page *sms_notification = incoming_text_overlay_create(sms_data->sender,
+                                                              incoming_text_callback,
+                                                              sms_data);
+        screen_push_page(sms_notification);
     }
 }
 
-static void handle_call_ended(DisplayTaskContext *ctx, DisplayMessage *msg)
+static void handle_incoming_call(DisplayTaskContext *ctx, const Event *event)
 {
-    // TODO: Handle call ended - return to previous screen or show call ended message
-    // screen_pop_page(); // Return to previous screen
+    CallData *call_data = msg_type(event->data) == MSG_TYPE_CALL_DATA ? (CallData *)event->data : NULL;
+    if (call_data && ctx->call_ctx)
+    {
+        // The overlay and the call page it opens point at the caller ID, so the
+        // message is held until the next call replaces it
+        msg_retain(call_data);
+        msg_release(ctx->call_data);
+        ctx->call_data = call_data;
+
+        Page *incoming_call_page = incoming_call_overlay_create(call_data->caller_id, incoming_call_callback, ctx);
+        screen_push_page(incoming_call_page);
+    }
 }
 
-static void handle_dialling(DisplayTaskContext *ctx, DisplayMessage *msg)
+static void dispatch_event(DisplayTaskContext *ctx, const Event *event)
 {
-    char *caller_id = (char *)msg->data;
-    if (caller_id)
+    switch (event->topic)
     {
-        // TODO: Create dialling page/overlay
-        // Page *dialling_page = dialling_overlay_create(caller_id, NULL, NULL);
-        // screen_push_page(dialling_page);
+    case EVENT_TOPIC_BATTERY:
+        status_bar_update_battery((uint8_t)event->value);
+        break;
+    case EVENT_TOPIC_SIGNAL:
+        status_bar_update_signal((uint8_t)event->value);
+        break;
+    case EVENT_TOPIC_SMS_RECEIVED:
+        handle_sms_received(ctx, event);
+        break;
+    case EVENT_TOPIC_CALL_STATE:
+        handle_incoming_call(ctx, event);
+        break;
+    default:
+        break;
     }
 }
 
-static void handle_show_sms(DisplayTaskContext *ctx, DisplayMessage *msg)
+// Only ringing changes the screen; active, dialling and ended have no pages yet
+static bool display_event_filter(const Event *event, void *arg)
 {
-    ReceivedSms *sms_data = (ReceivedSms *)msg->data;
-    if (sms_data)
+    if (event->topic == EVENT_TOPIC_CALL_STATE)
     {
-        // Show SMS notification overlay with sender
-        // The full message is passed as user_data for when user opens it
-        Page *sms_notification = incoming_text_overlay_create(sms_data->sender,
-                                                              incoming_text_callback,
-                                                              sms_data);
-        screen_push_page(sms_notification);
+        return event->value == CALL_STATE_RINGING;
     }
+    return true;
 }
 
-static void handle_set_battery_page(DisplayTaskContext *ctx, DisplayMessage *msg)
+// Volume keys are handled by the input task, and the input queue discards
+// releases of coalescing keys, so neither is worth waking the display for
+static bool display_key_filter(const Event *event, void *arg)
 {
-
-    screen_handle_response(PAGE_RESPONSE_BATTERY_HC, msg->data);
+    uint8_t key = EVENT_KEY(event->value);
+    if (key == INPUT_VOLUME_UP || key == INPUT_VOLUME_DOWN)
+    {
+        return false;
+    }
+    return !(EVENT_KEY_ACTION(event->value) == KEY_ACTION_RELEASE &&
+             (INPUT_DEFAULT_COALESCE_MASK & INPUT_KEY_BIT(key)));
 }
 
-static void handle_sync_rtc(DisplayTaskContext *ctx, DisplayMessage *msg)
+// Key events go straight into the coalescing input queue
+static bool display_key_sink(const Event *event, void *arg)
 {
-    RtcSyncData *rtc_data = (RtcSyncData *)msg->data;
-    if (rtc_data)
-    {
-        HAL_RTC_SetTime(&hrtc, &rtc_data->time, RTC_FORMAT_BIN);
-        HAL_RTC_SetDate(&hrtc, &rtc_data->date, RTC_FORMAT_BIN);
-    }
+    KeyEvent key = {
+        .key = EVENT_KEY(event->value),
+        .action = EVENT_KEY_ACTION(event->value),
+        .count = EVENT_KEY_COUNT(event->value)};
+    return input_queue_push(&key);
 }
 
 static DisplayCmdHandler display_cmd_table[] = {
     [DISPLAY_HANDLE_INPUT] = handle_input_event,
     [DISPLAY_SET_PAGE] = handle_set_page,
     [DISPLAY_CLEAR_SCREEN] = handle_clear_screen,
-    [DISPLAY_SET_SIGNAL_STATUS] = handle_set_signal_status,
-    [DISPLAY_SET_BATTERY_STATUS] = handle_set_battery_status,
     [DISPLAY_SET_VOLUME] = handle_set_volume,
-    [DISPLAY_INCOMING_CALL] = handle_incoming_call,
-    [DISPLAY_ACTIVE_CALL] = handle_active_call,
-    [DISPLAY_CALL_ENDED] = handle_call_ended,
-    [DISPLAY_DIALLING] = handle_dialling,
-    [DISPLAY_SHOW_SMS] = handle_show_sms,
     [DISPLAY_SET_BATTERY_PAGE] = handle_set_battery_page,
     [DISPLAY_SYNC_RTC] = handle_sync_rtc,
+    [DISPLAY_SET_HEADPHONE_STATUS] = handle_set_headphone_status,
 };
 
 static void dispatch_display_command(DisplayTaskContext *ctx, DisplayMessage *msg)
@@ -234,6 +305,40 @@ static void dispatch_display_command(DisplayTaskContext *ctx, DisplayMessage *ms
             handler(ctx, msg);
         }
     }
+
+    // The queue's reference to a pool message ends here, pages and strings
+    // posted as plain pointers are not ours to free
+    if (msg_pool_owns(msg->data))
+    {
+        msg_release(msg->data);
+    }
+}
+
+static void display_wake(void *arg)
+{
+    DisplayTask_Wake((DisplayTaskContext *)arg);
+}
+
+/*
+    Sleep until the next timer is due, or until a message, key event or RTC
+    alarm notifies the task. Work already waiting keeps the old 1 ms yield.
+*/
+static uint32_t display_sleep_ms(DisplayTaskContext *ctx)
+{
+    if (any_tiles_dirty() || uxQueueMessagesWaiting(ctx->queue) > 0 || event_bus_pending(ctx->events))
+    {
+        return 1;
+    }
+    uint32_t sleep_ms = ui_timer_next_expiry(HAL_GetTick());
+    if (sleep_ms < 1)
+    {
+        sleep_ms = 1;
+    }
+    else if (sleep_ms > DISPLAY_MAX_SLEEP_MS)
+    {
+        sleep_ms = DISPLAY_MAX_SLEEP_MS;
+    }
+    return sleep_ms;
 }
 
 static void display_task_main(void *pvParameters)
@@ -241,12 +346,21 @@ static void display_task_main(void *pvParameters)
     DisplayTaskContext *ctx = (DisplayTaskContext *)pvParameters;
     DisplayMessage msg;
 
+    // Timers are started by pages and the status bar, so the wheel comes first
+    ui_timer_init(HAL_GetTick());
+
     // Initialize display subsystem inside the task context to avoid blocking kernel startup
+    boot_phase_begin(BOOT_PHASE_DISPLAY, HAL_GetTick());
     display_init();
-    osDelay(100);
+    boot_phase_end(BOOT_PHASE_DISPLAY, true, HAL_GetTick());
+
+    // First frame as soon as the panel is up, the modem and SD card finish behind it
+    boot_phase_begin(BOOT_PHASE_FIRST_FRAME, HAL_GetTick());
     display_fill(COLOUR_BLACK);
     theme_set_dark();
     draw_status_bar();
+    status_bar_set_wake_hook(display_wake, ctx);
+    status_bar_start_clock();
     status_bar_update_signal(5);
     status_bar_update_battery(50);
 
@@ -257,10 +371,40 @@ static void display_task_main(void *pvParameters)
     // turn backlight full power
     HAL_GPIO_WritePin(LOAD_SW_GPIO_Port, LOAD_SW_Pin, GPIO_PIN_SET);
     HAL_GPIO_WritePin(GPIOA, GPIO_PIN_6, GPIO_PIN_SET); // backlight
+    boot_phase_end(BOOT_PHASE_FIRST_FRAME, true, HAL_GetTick());
+    DEBUG_PRINTF("boot: first frame at %lu ms\r\n", (unsigned long)HAL_GetTick());
 
     // Task main loop - handles messages and ticks like the test file
     for (;;)
     {
+        health_heartbeat(ctx->health, HAL_GetTick());
+
+        // Run expired page and status bar timers first, so timers started by
+        // the input handlers below are measured from the current time
+        ui_timer_run(HAL_GetTick());
+
+        // Key events arrive through the input queue, already coalesced
+        KeyEvent key;
+        while (input_queue_pop(&key))
+        {
+            handle_key_event(ctx, &key);
+        }
+
+        // Bus events are few and cheap, take them all
+        Event event;
+        while (event_bus_receive(ctx->events, &event))
+        {
+            dispatch_event(ctx, &event);
+            event_bus_release(&event);
+        }
+
+        // Rows the contacts task read off the card, for the contacts pages
+        ContactsReply contacts_reply;
+        while (ContactsTask_GetReply(&contacts_reply))
+        {
+            screen_handle_response(PAGE_RESPONSE_CONTACTS, &contacts_reply);
+        }
+
         // Drain a burst of messages quickly to limit backlog, but cap per cycle
         int processed = 0;
         while (xQueueReceive(ctx->queue, &msg, 0))
@@ -319,25 +463,31 @@ static void display_task_main(void *pvParameters)
             }
         }
 
-        // Update status bar and screen once per cycle
-        status_bar_tick();
+        // Flush dirty tiles, then any status bar fields that changed
         screen_tick();
         // Always yield to other tasks - critical for system responsiveness
-        osDelay(1);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(display_sleep_ms(ctx)));
     }
 }
 
 DisplayTaskContext *DisplayTask_Init(CallStateContext *call_ctx, CellularTaskContext *cellular_ctx)
 {
-    static DisplayTaskContext display_ctx;
+    static DisplayTaskContext display_ctx DTCM_BSS;
+    static StaticTask_t display_tcb DTCM_BSS;
+    static StackType_t display_stack[DISPLAY_TASK_STACK_SIZE / sizeof(StackType_t)] DTCM_BSS __attribute__((aligned(8)));
+    static StaticQueue_t display_queue DTCM_BSS;
+    static uint8_t display_queue_storage[DISPLAY_QUEUE_LENGTH * sizeof(DisplayMessage)] DTCM_BSS;
+
     memset(&display_ctx, 0, sizeof(display_ctx));
 
     // Store call state and cellular contexts for callbacks
     display_ctx.call_ctx = call_ctx;
     display_ctx.cellular_ctx = cellular_ctx;
+    display_ctx.health = health_register("display", DISPLAY_TASK_HEARTBEAT_MS, true);
 
     // Create queue
-    display_ctx.queue = xQueueCreate(5, sizeof(DisplayMessage));
+    display_ctx.queue = xQueueCreateStatic(DISPLAY_QUEUE_LENGTH, sizeof(DisplayMessage), display_queue_storage, &display_queue);
+    vQueueAddToRegistry(display_ctx.queue, "display");
     if (!display_ctx.queue)
     {
         return NULL; // Failed to create queue
@@ -346,7 +496,10 @@ DisplayTaskContext *DisplayTask_Init(CallStateContext *call_ctx, CellularTaskCon
     // Create and start the task
     osThreadAttr_t task_attr = {
         .name = "DisplayTask",
-        .stack_size = DISPLAY_TASK_STACK_SIZE, // Increased stack size for display operations
+        .cb_mem = &display_tcb,
+        .cb_size = sizeof(display_tcb),
+        .stack_mem = display_stack,
+        .stack_size = sizeof(display_stack),
         .priority = DISPLAY_TASK_PRIORITY};
 
     osThreadId_t thread_id = osThreadNew(display_task_main, &display_ctx, &task_attr);
@@ -355,6 +508,25 @@ DisplayTaskContext *DisplayTask_Init(CallStateContext *call_ctx, CellularTaskCon
         vQueueDelete(display_ctx.queue);
         return NULL; // Failed to create task
     }
+    display_ctx.task = (TaskHandle_t)thread_id;
+
+    EventSubscription events = {
+        .name = "display",
+        .topics = EVENT_TOPIC_BIT(EVENT_TOPIC_BATTERY) | EVENT_TOPIC_BIT(EVENT_TOPIC_SIGNAL) |
+                  EVENT_TOPIC_BIT(EVENT_TOPIC_SMS_RECEIVED) | EVENT_TOPIC_BIT(EVENT_TOPIC_CALL_STATE),
+        .filter = display_event_filter,
+        .wake = display_wake,
+        .arg = &display_ctx};
+    display_ctx.events = event_bus_subscribe(&events);
+
+    EventSubscription keys = {
+        .name = "display-keys",
+        .topics = EVENT_TOPIC_BIT(EVENT_TOPIC_KEY),
+        .filter = display_key_filter,
+        .sink = display_key_sink,
+        .wake = display_wake,
+        .arg = &display_ctx};
+    event_bus_subscribe(&keys);
 
     return &display_ctx;
 }
@@ -377,11 +549,33 @@ void DisplayTask_SetPowerContext(DisplayTaskContext *ctx, PowerTaskContext *powe
 
 bool DisplayTask_PostCommand(DisplayTaskContext *ctx, DisplayCommand cmd, void *data)
 {
-    if (!ctx || !ctx->queue)
-        return false;
-
     DisplayMessage msg = {
         .cmd = cmd,
         .data = data};
-    return xQueueSend(ctx->queue, &msg, pdMS_TO_TICKS(10)) == pdTRUE;
+    if (!ctx || !ctx->queue || xQueueSend(ctx->queue, &msg, pdMS_TO_TICKS(10)) != pdTRUE)
+    {
+        // the caller handed its reference over, so it is dropped here
+        if (msg_pool_owns(data))
+            msg_release(data);
+        return false;
+    }
+    DisplayTask_Wake(ctx);
+    return true;
+}
+
+void DisplayTask_Wake(DisplayTaskContext *ctx)
+{
+    if (!ctx || !ctx->task)
+        return;
+
+    if (xPortIsInsideInterrupt())
+    {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(ctx->task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        xTaskNotifyGive(ctx->task);
+    }
 }
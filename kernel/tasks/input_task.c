@@ -1,119 +1,160 @@
 #include "input_task.h"
 #include "call_state.h"
 #include "cellular_task.h"
+#include "msg_pool.h"
+#include "event_bus.h"
+#include "health_monitor.h"
+#include "boot_timeline.h"
+#include "mem_sections.h"
 
 typedef struct
 {
     DisplayTaskContext *display_ctx;
     AudioTaskContext *audio_ctx;
     CallStateContext *call_ctx;
+    int health; // heartbeat checked by the watchdog task
 } InputTaskContext;
 
+static TaskHandle_t input_task_handle;
+
 static uint8_t current_volume = 100; // Initialize to match audio task default (speaker volume)
 
+static void handle_volume(InputTaskContext *input_ctx, input_event_t event)
+{
+    if (event == INPUT_VOLUME_UP)
+    {
+        // Send volume up command to audio task
+        if (input_ctx->audio_ctx)
+        {
+            AudioTask_PostCommand(input_ctx->audio_ctx, AUDIO_VOLUME_UP, NULL);
+        }
+
+        // Update local volume for display (keep in sync)
+        if (current_volume < 100)
+        {
+            current_volume += 5;
+        }
+    }
+    else
+    {
+        // Send volume down command to audio task
+        if (input_ctx->audio_ctx)
+        {
+            AudioTask_PostCommand(input_ctx->audio_ctx, AUDIO_VOLUME_DOWN, NULL);
+        }
+
+        // Update local volume for display (keep in sync)
+        if (current_volume > 0)
+        {
+            current_volume -= 5;
+        }
+    }
+
+    // Send volume update to display task, the message carries a copy of the level
+    if (input_ctx->display_ctx)
+    {
+        uint8_t *volume = msg_alloc(MSG_TYPE_U8, sizeof(*volume));
+        if (volume)
+        {
+            *volume = current_volume;
+            DisplayTask_PostCommand(input_ctx->display_ctx, DISPLAY_SET_VOLUME, volume);
+        }
+    }
+}
+
+static void handle_key_event(InputTaskContext *input_ctx, const KeyEvent *key)
+{
+    input_event_t event = (input_event_t)key->key;
+    bool step = (key->action == KEY_ACTION_PRESS || key->action == KEY_ACTION_REPEAT);
+
+    if ((event == INPUT_VOLUME_UP || event == INPUT_VOLUME_DOWN) && step)
+    {
+        handle_volume(input_ctx, event);
+    }
+
+    // Every key event is published; the display and audio subscriptions pick
+    // what they need, so volume keys and most releases wake nobody
+    event_bus_publish(EVENT_TOPIC_KEY, event_key_pack(key->key, key->action, key->count), NULL);
+}
+
+// called from the keypad EXTI when a wake key is pressed
+static void keypad_wake(void)
+{
+    BaseType_t woken = pdFALSE;
+    if (input_task_handle)
+    {
+        vTaskNotifyGiveFromISR(input_task_handle, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
 void input_task_main(void *pvParameters)
 {
     InputTaskContext *input_ctx = (InputTaskContext *)pvParameters;
-    DisplayTaskContext *display_ctx = input_ctx->display_ctx;
-    AudioTaskContext *audio_ctx = input_ctx->audio_ctx;
-    input_event_t event;
+    static KeyEventGen key_gen;
+    input_event_t keymap[INPUT_MAX_KEYS];
+    KeyEvent events[INPUT_MAX_KEYS * 2];
 
     // Initialize keypad
+    boot_phase_begin(BOOT_PHASE_KEYPAD, HAL_GetTick());
     keypad_init();
+    boot_phase_end(BOOT_PHASE_KEYPAD, true, HAL_GetTick());
 
-    while (1)
+    uint8_t key_count = keypad_get_button_count();
+    for (int i = 0; i < key_count && i < INPUT_MAX_KEYS; i++)
     {
+        keymap[i] = keypad_get_button_event(i);
+    }
+    key_events_init(&key_gen, NULL, keymap, key_count);
+    input_queue_init(INPUT_DEFAULT_COALESCE_MASK);
 
+    input_task_handle = xTaskGetCurrentTaskHandle();
+    keypad_set_wake_callback(keypad_wake);
+
+    while (1)
+    {
+        health_heartbeat(input_ctx->health, HAL_GetTick());
         keypad_update_states();
 
-        // Check all buttons and handle input events
-        for (int button_idx = 0; button_idx < keypad_get_button_count(); button_idx++)
+        int count = key_events_update(&key_gen, keypad_get_state_bitmap(), HAL_GetTick(),
+                                      events, sizeof(events) / sizeof(events[0]));
+        for (int i = 0; i < count; i++)
         {
-            if (keypad_is_button_pressed(button_idx))
-            {
-                event = keypad_get_button_event(button_idx);
-
-                if (event == INPUT_VOLUME_UP)
-                {
-                    // Send volume up command to audio task
-                    if (audio_ctx)
-                    {
-                        AudioTask_PostCommand(audio_ctx, AUDIO_VOLUME_UP, NULL);
-                    }
-
-                    // Update local volume for display (keep in sync)
-                    if (current_volume < 100)
-                    {
-                        current_volume += 5;
-                    }
-
-                    // Send volume update to display task (queue is thread-safe)
-                    if (display_ctx)
-                    {
-                        DisplayTask_PostCommand(display_ctx, DISPLAY_SET_VOLUME, &current_volume);
-                    }
-                }
-                else if (event == INPUT_VOLUME_DOWN)
-                {
-                    // Send volume down command to audio task
-                    if (audio_ctx)
-                    {
-                        AudioTask_PostCommand(audio_ctx, AUDIO_VOLUME_DOWN, NULL);
-                    }
-
-                    // Update local volume for display (keep in sync)
-                    if (current_volume > 0)
-                    {
-                        current_volume -= 5;
-                    }
-
-                    // Send volume update to display task (queue is thread-safe)
-                    if (display_ctx)
-                    {
-                        DisplayTask_PostCommand(display_ctx, DISPLAY_SET_VOLUME, &current_volume);
-                    }
-                }
-                else
-                {
-                    // Dispatch all other input events to display task
-                    if (display_ctx)
-                    {
-                        DisplayTask_PostCommand(display_ctx, DISPLAY_HANDLE_INPUT, &event);
-                    }
-                }
-                if (event >= INPUT_KEYPAD_0 && event <= INPUT_KEYPAD_9)
-                {
-                    if (audio_ctx)
-                    {
-                        AudioTask_PostCommand(audio_ctx, AUDIO_PLAY_TICK, NULL);
-                    }
-                }
-                else
-                {
-                    if (audio_ctx)
-                    {
-                        AudioTask_PostCommand(audio_ctx, AUDIO_PLAY_BLOOP, NULL);
-                    }
-                }
-
-                // Audio feedback removed as requested
-            }
+            handle_key_event(input_ctx, &events[i]);
         }
 
-        vTaskDelay(pdMS_TO_TICKS(5));
+        // scan while a key is held or bouncing, otherwise sleep until a wake
+        // key interrupts or the idle poll comes round for the other keys
+        if (keypad_is_settled())
+        {
+            keypad_wake_arm();
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(INPUT_IDLE_POLL_MS));
+            keypad_wake_disarm();
+        }
+        else
+        {
+            vTaskDelay(pdMS_TO_TICKS(INPUT_SCAN_PERIOD_MS));
+        }
     }
 }
 
 void InputTask_Init(DisplayTaskContext *display_ctx, AudioTaskContext *audio_ctx, CallStateContext *call_ctx)
 {
-    static InputTaskContext input_ctx;
+    static InputTaskContext input_ctx DTCM_BSS;
+    static StaticTask_t input_tcb DTCM_BSS;
+    static StackType_t input_stack[INPUT_TASK_STACK_SIZE / sizeof(StackType_t)] DTCM_BSS __attribute__((aligned(8)));
+
     input_ctx.display_ctx = display_ctx;
     input_ctx.audio_ctx = audio_ctx;
     input_ctx.call_ctx = call_ctx;
+    input_ctx.health = health_register("input", INPUT_TASK_HEARTBEAT_MS, true);
 
     osThreadAttr_t task_attr = {
         .name = "InputTask",
-        .stack_size = INPUT_TASK_STACK_SIZE,
+        .cb_mem = &input_tcb,
+        .cb_size = sizeof(input_tcb),
+        .stack_mem = input_stack,
+        .stack_size = sizeof(input_stack),
         .priority = INPUT_TASK_PRIORITY};
     osThreadNew(input_task_main, &input_ctx, &task_attr);
 }
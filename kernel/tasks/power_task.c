@@ -1,7 +1,14 @@
 #include "power_task.h"
 #include "bq27441.h"
+#include "msg_pool.h"
+#include "event_bus.h"
+#include "health_monitor.h"
+#include "boot_timeline.h"
+#include "mem_sections.h"
 #include <string.h>
 
+#define POWER_QUEUE_LENGTH 5
+
 struct PowerTaskStats {
     uint16_t soc;
     int16_t current;
@@ -15,8 +22,8 @@ struct PowerTaskContext
 {
     QueueHandle_t queue;
     DisplayTaskContext *display_ctx;
-    struct PowerTaskStats stats;
     uint16_t last_soc;
+    int health; // heartbeat checked by the watchdog task
 };
 
 typedef void (*PowerCmdHandler)(PowerTaskContext *ctx, PowerMessage *msg);
@@ -66,15 +73,21 @@ static void handle_shutdown(PowerTaskContext *ctx, PowerMessage *msg)
     bq27441_read_ctrl_reg(subcmd, &subcmd);
 }
 
-static void handle_get_stats(PowerTaskContext *ctx, PowerMessage *msg) { 
-    ctx->stats.soc = bq27441_SOC();
-    ctx->stats.current = bq27441_avg_current();
-    ctx->stats.voltage = bq27441_voltage();
-    ctx->stats.capacity_avail = bq27441_available_capacity();
-    ctx->stats.capacity_full = bq27441_full_capacity();
-    ctx->stats.health = bq27441_health();
-    // VERY UNSAFE MEMORY HANDLING DO NOT COPY PLEASE FIX
-    DisplayTask_PostCommand(ctx->display_ctx, DISPLAY_SET_BATTERY_PAGE, &ctx->stats);
+static void handle_get_stats(PowerTaskContext *ctx, PowerMessage *msg)
+{
+    // Each snapshot is its own pool message, owned by the display task once posted
+    struct PowerTaskStats *stats = msg_alloc(MSG_TYPE_BATTERY_STATS, sizeof(*stats));
+    if (!stats)
+    {
+        return;
+    }
+    stats->soc = bq27441_SOC();
+    stats->current = bq27441_avg_current();
+    stats->voltage = bq27441_voltage();
+    stats->capacity_avail = bq27441_available_capacity();
+    stats->capacity_full = bq27441_full_capacity();
+    stats->health = bq27441_health();
+    DisplayTask_PostCommand(ctx->display_ctx, DISPLAY_SET_BATTERY_PAGE, stats);
 }
 
 /* ===== DISPATCH TABLE ===== */
@@ -106,50 +119,60 @@ static void power_task_main(void *pvParameters)
     uint32_t last_battery_check = 0;
 
     // Initialize the battery fuel gauge
-    bq27441_init();
+    boot_phase_begin(BOOT_PHASE_FUEL_GAUGE, HAL_GetTick());
+    bool gauge_ok = bq27441_init() == 0;
+    boot_phase_end(BOOT_PHASE_FUEL_GAUGE, gauge_ok, HAL_GetTick());
 
     for (;;)
     {
-        // Periodic battery check (every 5 seconds)
-        if (HAL_GetTick() - last_battery_check >= 5000)
+        health_heartbeat(ctx->health, HAL_GetTick());
+
+        // Periodic battery check
+        uint32_t since_check = HAL_GetTick() - last_battery_check;
+        if (since_check >= POWER_BATTERY_CHECK_MS)
         {
+            since_check = 0;
             last_battery_check = HAL_GetTick();
 
             // Read current battery state of charge
             uint16_t current_soc = bq27441_SOC();
 
-            // Only update display if battery level changed
+            // Only publish if battery level changed, a dropped update is retried on the next check
             if (current_soc != ctx->last_soc)
             {
-                ctx->last_soc = current_soc;
-                if (ctx->display_ctx)
+                uint32_t percent = current_soc > 100 ? 100 : current_soc;
+                if (event_bus_publish(EVENT_TOPIC_BATTERY, percent, NULL) > 0)
                 {
-                    DisplayTask_PostCommand(ctx->display_ctx, DISPLAY_SET_BATTERY_STATUS, &ctx->last_soc);
+                    ctx->last_soc = current_soc;
                 }
             }
         }
 
-        // Process any queued commands (non-blocking with short timeout)
-        if (xQueueReceive(ctx->queue, &msg, pdMS_TO_TICKS(100)))
+        // Block on commands until the next battery check so the idle system can sleep
+        if (xQueueReceive(ctx->queue, &msg, pdMS_TO_TICKS(POWER_BATTERY_CHECK_MS - since_check)))
         {
             dispatch_power_command(ctx, &msg);
         }
-
-        osDelay(100);
     }
 }
 
 PowerTaskContext *PowerTask_Init(DisplayTaskContext *display_ctx)
 {
-    static PowerTaskContext power_ctx;
+    static PowerTaskContext power_ctx DTCM_BSS;
+    static StaticTask_t power_tcb DTCM_BSS;
+    static StackType_t power_stack[POWER_TASK_STACK_SIZE / sizeof(StackType_t)] DTCM_BSS __attribute__((aligned(8)));
+    static StaticQueue_t power_queue DTCM_BSS;
+    static uint8_t power_queue_storage[POWER_QUEUE_LENGTH * sizeof(PowerMessage)] DTCM_BSS;
+
     memset(&power_ctx, 0, sizeof(power_ctx));
 
     // Store display context for battery updates
     power_ctx.display_ctx = display_ctx;
-    power_ctx.stats.soc = 0;
+    power_ctx.health = health_register("power", POWER_TASK_HEARTBEAT_MS, false);
 
     // Create queue for commands
-    power_ctx.queue = xQueueCreate(5, sizeof(PowerMessage));
+    power_ctx.queue = xQueueCreateStatic(POWER_QUEUE_LENGTH, sizeof(PowerMessage), power_queue_storage, &power_queue);
+    vQueueAddToRegistry(power_ctx.queue, "power");
     if (!power_ctx.queue)
     {
         return NULL;
@@ -158,7 +181,10 @@ PowerTaskContext *PowerTask_Init(DisplayTaskContext *display_ctx)
     // Create and start the task
     osThreadAttr_t task_attr = {
         .name = "PowerTask",
-        .stack_size = POWER_TASK_STACK_SIZE,
+        .cb_mem = &power_tcb,
+        .cb_size = sizeof(power_tcb),
+        .stack_mem = power_stack,
+        .stack_size = sizeof(power_stack),
         .priority = POWER_TASK_PRIORITY};
 
     osThreadId_t thread_id = osThreadNew(power_task_main, &power_ctx, &task_attr);
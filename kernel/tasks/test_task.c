@@ -1,5 +1,6 @@
 #include "test_task.h"
 #include "stm32_config.h"
+#include "mem_sections.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -23,7 +24,10 @@ static void test_task_main(void *pvParameters)
 // Public API implementation
 TestTaskContext *TestTask_Init(CallStateContext *call_ctx, DisplayTaskContext *display_ctx)
 {
-    TestTaskContext ctx;
+    static TestTaskContext ctx DTCM_BSS;
+    static StaticTask_t test_tcb DTCM_BSS;
+    static StackType_t test_stack[TEST_TASK_STACK_SIZE / sizeof(StackType_t)] DTCM_BSS __attribute__((aligned(8)));
+
     ctx.call_ctx = call_ctx;
     ctx.display_ctx = display_ctx;
     ctx.test_running = true;
@@ -32,7 +36,10 @@ TestTaskContext *TestTask_Init(CallStateContext *call_ctx, DisplayTaskContext *d
     // Create and start the test task
     osThreadAttr_t task_attr = {
         .name = "TestTask",
-        .stack_size = TEST_TASK_STACK_SIZE,
+        .cb_mem = &test_tcb,
+        .cb_size = sizeof(test_tcb),
+        .stack_mem = test_stack,
+        .stack_size = sizeof(test_stack),
         .priority = TEST_TASK_PRIORITY};
 
     osThreadId_t thread_id = osThreadNew(test_task_main, &ctx, &task_attr);
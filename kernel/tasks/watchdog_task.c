@@ -0,0 +1,122 @@
+#include "watchdog_task.h"
+#include "stm32h7xx_hal.h"
+#include "task.h"
+#include "mem_sections.h"
+#include <string.h>
+
+// the backup domain keeps this block across resets, with VBAT also across power loss
+#define HEALTH_BACKUP ((HealthBackup *)D3_BKPSRAM_BASE)
+
+// LSI at 32 kHz divided by 64 gives 2 ms per reload count
+#define IWDG_RELOAD (WATCHDOG_TIMEOUT_MS / 2)
+
+static IWDG_HandleTypeDef hiwdg;
+static TaskStatus_t task_status[HEALTH_MAX_TASKS];
+static HealthTaskSample samples[HEALTH_MAX_TASKS];
+
+static HealthResetCause read_reset_cause(void)
+{
+    HealthResetCause cause = HEALTH_RESET_UNKNOWN;
+    if (__HAL_RCC_GET_FLAG(RCC_FLAG_IWDG1RST) || __HAL_RCC_GET_FLAG(RCC_FLAG_WWDG1RST))
+    {
+        cause = HEALTH_RESET_WATCHDOG;
+    }
+    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_LPWR1RST))
+    {
+        cause = HEALTH_RESET_LOW_POWER;
+    }
+    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_SFTRST))
+    {
+        cause = HEALTH_RESET_SOFTWARE;
+    }
+    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_PORRST) || __HAL_RCC_GET_FLAG(RCC_FLAG_BORRST))
+    {
+        cause = HEALTH_RESET_POWER_ON;
+    }
+    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_PINRST))
+    {
+        cause = HEALTH_RESET_PIN;
+    }
+    __HAL_RCC_CLEAR_RESET_FLAGS();
+    return cause;
+}
+
+static void backup_sram_enable(void)
+{
+    HAL_PWR_EnableBkUpAccess();
+    __HAL_RCC_BKPRAM_CLK_ENABLE();
+    HAL_PWREx_EnableBkUpReg();
+}
+
+static void iwdg_start(void)
+{
+    // stop the counter while the core is halted by the debugger
+    __HAL_DBGMCU_FREEZE_IWDG1();
+
+    hiwdg.Instance = IWDG1;
+    hiwdg.Init.Prescaler = IWDG_PRESCALER_64;
+    hiwdg.Init.Window = IWDG_WINDOW_DISABLE;
+    hiwdg.Init.Reload = IWDG_RELOAD;
+    HAL_IWDG_Init(&hiwdg);
+}
+
+static void sample_tasks(uint32_t now)
+{
+    uint32_t total_runtime = 0;
+    UBaseType_t count = uxTaskGetSystemState(task_status, HEALTH_MAX_TASKS, &total_runtime);
+
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        samples[i].name = task_status[i].pcTaskName;
+        samples[i].runtime = task_status[i].ulRunTimeCounter;
+        samples[i].stack_free = task_status[i].usStackHighWaterMark * sizeof(StackType_t);
+        samples[i].priority = (uint8_t)task_status[i].uxCurrentPriority;
+    }
+    health_update_tasks(samples, (int)count, total_runtime, now);
+}
+
+static void watchdog_task_main(void *pvParameters)
+{
+    (void)pvParameters;
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t last_sample = HAL_GetTick();
+
+    iwdg_start();
+
+    for (;;)
+    {
+        uint32_t now = HAL_GetTick();
+        if (now - last_sample >= WATCHDOG_SAMPLE_PERIOD_MS)
+        {
+            last_sample = now;
+            sample_tasks(now);
+        }
+
+        // a hung critical task lets the watchdog run out, its hang is already in the history
+        if (health_check(now))
+        {
+            HAL_IWDG_Refresh(&hiwdg);
+        }
+
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(WATCHDOG_CHECK_PERIOD_MS));
+    }
+}
+
+bool WatchdogTask_Init(void)
+{
+    static StaticTask_t watchdog_tcb DTCM_BSS;
+    static StackType_t watchdog_stack[WATCHDOG_TASK_STACK_SIZE / sizeof(StackType_t)] DTCM_BSS __attribute__((aligned(8)));
+
+    backup_sram_enable();
+    health_init(HEALTH_BACKUP, read_reset_cause(), HAL_GetTick());
+
+    osThreadAttr_t task_attr = {
+        .name = "WatchdogTask",
+        .cb_mem = &watchdog_tcb,
+        .cb_size = sizeof(watchdog_tcb),
+        .stack_mem = watchdog_stack,
+        .stack_size = sizeof(watchdog_stack),
+        .priority = WATCHDOG_TASK_PRIORITY};
+
+    return osThreadNew(watchdog_task_main, NULL, &task_attr) != NULL;
+}
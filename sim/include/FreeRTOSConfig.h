@@ -0,0 +1,91 @@
+/**
+ * @file FreeRTOSConfig.h
+ * @brief FreeRTOS configuration for the host simulation
+ * @ingroup sim
+ *
+ * Mirrors third_party/stm32/Core/Inc/FreeRTOSConfig.h so the tasks see the
+ * same priorities, tick rate and kernel features as on the board. Left out
+ * are the Cortex-M interrupt priorities and tickless idle, which the POSIX
+ * port has no use for. Run-time stats count host microseconds in place of
+ * DWT cycles.
+ *
+ * Pointers are twice as wide on a 64-bit host, so the heap is scaled by the
+ * pointer size to leave the UI the same room it has on the board. Task
+ * stacks do not come from the heap, see sim/sim_cmsis_os.c.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <stdint.h>
+
+extern uint32_t SystemCoreClock;
+uint32_t sim_run_time_counter(void);
+void sim_assert_failed(const char *file, int line);
+int sim_in_interrupt(void);
+
+#define configUSE_PREEMPTION 1
+#define configSUPPORT_STATIC_ALLOCATION 1
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configUSE_IDLE_HOOK 0
+#define configUSE_TICK_HOOK 0
+#define configCPU_CLOCK_HZ (SystemCoreClock)
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define configMAX_PRIORITIES (56)
+/* each task runs as a pthread on its own stack, which must hold glibc and
+   signal frames besides the firmware */
+#define configMINIMAL_STACK_SIZE ((uint16_t)(32768 / sizeof(StackType_t)))
+#define configTOTAL_HEAP_SIZE ((size_t)(15360 * sizeof(void *) / 4))
+#define configMAX_TASK_NAME_LEN (16)
+#define configUSE_TRACE_FACILITY 1
+#define configUSE_16_BIT_TICKS 0
+#define configUSE_MUTEXES 1
+#define configQUEUE_REGISTRY_SIZE 8
+#define configUSE_RECURSIVE_MUTEXES 1
+#define configUSE_COUNTING_SEMAPHORES 1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configMESSAGE_BUFFER_LENGTH_TYPE size_t
+
+#define configUSE_CO_ROUTINES 0
+#define configMAX_CO_ROUTINE_PRIORITIES (2)
+
+#define configUSE_TIMERS 1
+#define configTIMER_TASK_PRIORITY (2)
+#define configTIMER_QUEUE_LENGTH 10
+#define configTIMER_TASK_STACK_DEPTH configMINIMAL_STACK_SIZE
+
+#define INCLUDE_vTaskPrioritySet 1
+#define INCLUDE_uxTaskPriorityGet 1
+#define INCLUDE_vTaskDelete 1
+#define INCLUDE_vTaskCleanUpResources 0
+#define INCLUDE_vTaskSuspend 1
+#define INCLUDE_vTaskDelayUntil 1
+#define INCLUDE_vTaskDelay 1
+#define INCLUDE_xTaskGetSchedulerState 1
+#define INCLUDE_xTimerPendFunctionCall 1
+#define INCLUDE_xQueueGetMutexHolder 1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+#define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_eTaskGetState 1
+
+/* the board spins in place, here the failing line is worth printing */
+#define configASSERT(x)                           \
+    if ((x) == 0)                                 \
+    {                                             \
+        sim_assert_failed(__FILE__, __LINE__);    \
+    }
+
+#define configGENERATE_RUN_TIME_STATS 1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE() sim_run_time_counter()
+
+#define configUSE_TICKLESS_IDLE 0
+
+/* the Cortex-M ports read IPSR, here the peripheral task is the interrupt */
+#define xPortIsInsideInterrupt() sim_in_interrupt()
+
+#if defined(TRACE_ENABLED)
+#include "trace_freertos.h"
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+/**
+ * @file sim.h
+ * @brief Simulated peripherals of the host simulation
+ * @ingroup sim
+ *
+ * The host-sim build runs the firmware's kernel, tasks and UI on the
+ * FreeRTOS POSIX port. HAL calls land in sim_hal.c, and the peripherals
+ * behind them are modelled here:
+ * - display: the ST7789V on the FMC bus, decoded into a framebuffer that is
+ *   written out as a PPM image after every frame
+ * - keypad: a script of presses that drives the button pins, see
+ *   sim_keypad.c for the format
+ * - modem: the modem UART is a pty, tools/modem_sim.py answers on the other
+ *   end and pending unsolicited lines pulse RI
+ * - audio: I2S transmits are appended to a WAV file at the I2S rate
+ * - SD card: FatFs runs over an image file, formatted and filled from a
+ *   host directory when it does not exist yet
+ *
+ * Interrupt-like work (key edges, RI pulses, display snapshots) is done by
+ * one task at the highest priority, sim_peripheral_task(), which calls the
+ * firmware's interrupt callbacks the way the handlers would.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "stm32h7xx_hal.h"
+
+/** @ingroup sim
+ *  @brief Period of the peripheral task in ticks */
+#define SIM_PERIPHERAL_PERIOD_MS 2
+
+/** @ingroup sim
+ *  @brief Microseconds since the simulation started */
+uint64_t sim_now_us(void);
+
+/** @ingroup sim
+ *  @brief Run-time stats counter for FreeRTOS, microseconds */
+uint32_t sim_run_time_counter(void);
+
+/** @ingroup sim
+ *  @brief Print the failing line of a configASSERT and abort */
+void sim_assert_failed(const char *file, int line);
+
+/** @ingroup sim
+ *  @brief Nonzero while the peripheral task runs, which stands for interrupt context */
+int sim_in_interrupt(void);
+
+/** @ingroup sim
+ *  @brief Flush the outputs and exit, from any task */
+void sim_exit(int status);
+
+/** @ingroup sim
+ *  @brief Raise the RTC alarm callback when the alarm time comes round */
+void sim_rtc_poll(void);
+
+/**
+ * @ingroup sim
+ * @brief Connect the modem UART to a new pty
+ * @param link Symlink to make to the pty, NULL for none
+ * @return true if the pty was opened
+ */
+bool sim_modem_open(const char *link);
+
+/** @ingroup sim
+ *  @brief Pulse RI when the modem has sent something nobody is reading */
+void sim_modem_poll(void);
+
+/**
+ * @ingroup sim
+ * @brief Start writing I2S output to a WAV file
+ * @param path File to create
+ * @return true if the file was created
+ */
+bool sim_audio_open(const char *path);
+
+/** @ingroup sim
+ *  @brief Fill in the WAV header sizes and close the file */
+void sim_audio_close(void);
+
+/**
+ * @ingroup sim
+ * @brief Set up the panel model
+ * @param path PPM file written after each frame, NULL for none
+ */
+void sim_display_init(const char *path);
+
+/** @ingroup sim
+ *  @brief Write the framebuffer if a frame finished since the last call */
+void sim_display_poll(void);
+
+/**
+ * @ingroup sim
+ * @brief Write the framebuffer as a binary PPM
+ * @param path File to write
+ * @return true if the file was written
+ */
+bool sim_display_save(const char *path);
+
+/**
+ * @ingroup sim
+ * @brief Release every button and open the key script
+ * @param path Script file, "-" for stdin, NULL for none
+ * @return true if the script could be opened
+ */
+bool sim_keypad_open(const char *path);
+
+/** @ingroup sim
+ *  @brief Run the key script up to now, pressing and releasing buttons */
+void sim_keypad_poll(void);
+
+/**
+ * @ingroup sim
+ * @brief Open or create the SD card image
+ * @param path Image file
+ * @param seed Directory copied into a newly created image, NULL for none
+ * @param size_mb Size of a new image
+ * @return true if the image is ready to mount
+ */
+bool sim_sdcard_open(const char *path, const char *seed, uint32_t size_mb);
+
+/** @ingroup sim
+ *  @brief Start the peripheral task */
+void sim_peripherals_start(void);
+
+#endif
@@ -0,0 +1,476 @@
+/**
+ * @file stm32h7xx_hal.h
+ * @brief STM32H7 HAL surface for the host simulation
+ * @ingroup sim
+ *
+ * Stands in for the ST HAL header in the host-sim build. It declares the
+ * handle types, register blocks, constants and calls the firmware uses, and
+ * nothing else. The calls are implemented in sim/sim_hal.c and route to the
+ * simulated peripherals: the modem UART is a pty, I2S writes a WAV file, I2C
+ * devices are register files and the RTC follows the host clock.
+ *
+ * GPIO ports are plain structs. Output writes land in ODR, and the scripted
+ * keypad drives the button pins through IDR, active-low like the board.
+ * Register blocks that only target-only code touches (LPTIM, MDMA, DWT,
+ * SCB) are not declared, so a stray use outside an __arm__ guard fails to
+ * compile instead of writing into host memory.
+ */
+
+#ifndef STM32H7XX_HAL_H
+#define STM32H7XX_HAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define __IO volatile
+#define UNUSED(x) ((void)(x))
+
+typedef enum
+{
+    HAL_OK = 0x00,
+    HAL_ERROR = 0x01,
+    HAL_BUSY = 0x02,
+    HAL_TIMEOUT = 0x03,
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+typedef enum
+{
+    RESET = 0,
+    SET = !RESET,
+} FlagStatus,
+    ITStatus;
+
+typedef enum
+{
+    DISABLE = 0,
+    ENABLE = !DISABLE,
+} FunctionalState;
+
+typedef enum
+{
+    SUCCESS = 0,
+    ERROR = !SUCCESS,
+} ErrorStatus;
+
+/* ===== CORE ===== */
+
+typedef int IRQn_Type;
+
+#define EXTI0_IRQn 6
+#define EXTI1_IRQn 7
+#define EXTI2_IRQn 8
+#define EXTI3_IRQn 9
+#define EXTI4_IRQn 10
+#define EXTI9_5_IRQn 23
+#define EXTI15_10_IRQn 40
+#define RTC_Alarm_IRQn 41
+
+#define POSITION_VAL(value) ((uint32_t)__builtin_ctz(value))
+
+#define __disable_irq() ((void)0)
+#define __enable_irq() ((void)0)
+#define __DSB() __sync_synchronize()
+#define __ISB() __sync_synchronize()
+#define __DMB() __sync_synchronize()
+#define __NOP() ((void)0)
+
+extern uint32_t SystemCoreClock;
+
+/* ===== GPIO ===== */
+
+typedef struct
+{
+    __IO uint32_t MODER;
+    __IO uint32_t OTYPER;
+    __IO uint32_t OSPEEDR;
+    __IO uint32_t PUPDR;
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+    __IO uint32_t BSRR;
+    __IO uint32_t LCKR;
+    __IO uint32_t AFR[2];
+} GPIO_TypeDef;
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET,
+} GPIO_PinState;
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_2 ((uint16_t)0x0004)
+#define GPIO_PIN_3 ((uint16_t)0x0008)
+#define GPIO_PIN_4 ((uint16_t)0x0010)
+#define GPIO_PIN_5 ((uint16_t)0x0020)
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+#define GPIO_PIN_7 ((uint16_t)0x0080)
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+#define GPIO_PIN_All ((uint16_t)0xFFFF)
+
+#define GPIO_MODE_INPUT 0x00000000U
+#define GPIO_MODE_OUTPUT_PP 0x00000001U
+#define GPIO_MODE_OUTPUT_OD 0x00000011U
+#define GPIO_MODE_AF_PP 0x00000002U
+#define GPIO_MODE_ANALOG 0x00000003U
+#define GPIO_MODE_IT_RISING 0x10110000U
+#define GPIO_MODE_IT_FALLING 0x10210000U
+#define GPIO_MODE_IT_RISING_FALLING 0x10310000U
+
+#define GPIO_NOPULL 0x00000000U
+#define GPIO_PULLUP 0x00000001U
+#define GPIO_PULLDOWN 0x00000002U
+
+#define GPIO_SPEED_FREQ_LOW 0x00000000U
+#define GPIO_SPEED_FREQ_MEDIUM 0x00000001U
+#define GPIO_SPEED_FREQ_HIGH 0x00000002U
+#define GPIO_SPEED_FREQ_VERY_HIGH 0x00000003U
+
+/** @ingroup sim
+ *  @brief Simulated ports A to K, in that order */
+extern GPIO_TypeDef sim_gpio[11];
+
+#define GPIOA (&sim_gpio[0])
+#define GPIOB (&sim_gpio[1])
+#define GPIOC (&sim_gpio[2])
+#define GPIOD (&sim_gpio[3])
+#define GPIOE (&sim_gpio[4])
+#define GPIOF (&sim_gpio[5])
+#define GPIOG (&sim_gpio[6])
+#define GPIOH (&sim_gpio[7])
+#define GPIOI (&sim_gpio[8])
+#define GPIOJ (&sim_gpio[9])
+#define GPIOK (&sim_gpio[10])
+
+typedef struct
+{
+    __IO uint32_t RTSR1;
+    __IO uint32_t FTSR1;
+    __IO uint32_t SWIER1;
+    __IO uint32_t IMR1;
+    __IO uint32_t EMR1;
+    __IO uint32_t PR1;
+} EXTI_Core_TypeDef;
+
+/** @ingroup sim
+ *  @brief Simulated EXTI for core 1, PR1 bits are cleared by writing 1 */
+extern EXTI_Core_TypeDef sim_exti;
+
+#define EXTI_D1 (&sim_exti)
+
+#define __HAL_GPIO_EXTI_CLEAR_IT(pin) (EXTI_D1->PR1 = (pin))
+#define __HAL_GPIO_EXTI_GET_IT(pin) (EXTI_D1->PR1 & (pin))
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin);
+void HAL_GPIO_EXTI_IRQHandler(uint16_t pin);
+void HAL_GPIO_EXTI_Callback(uint16_t pin);
+
+/* ===== HAL CORE, NVIC, RCC, PWR ===== */
+
+void HAL_Delay(uint32_t delay);
+uint32_t HAL_GetTick(void);
+void HAL_IncTick(void);
+void HAL_SuspendTick(void);
+void HAL_ResumeTick(void);
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt, uint32_t sub);
+void HAL_NVIC_EnableIRQ(IRQn_Type irq);
+void HAL_NVIC_DisableIRQ(IRQn_Type irq);
+
+#define RCC_FLAG_BORRST 1U
+#define RCC_FLAG_PINRST 2U
+#define RCC_FLAG_PORRST 3U
+#define RCC_FLAG_SFTRST 4U
+#define RCC_FLAG_IWDG1RST 5U
+#define RCC_FLAG_WWDG1RST 6U
+#define RCC_FLAG_LPWR1RST 7U
+
+/** @ingroup sim
+ *  @brief Reset cause the simulation reports, a power-on reset */
+#define __HAL_RCC_GET_FLAG(flag) ((flag) == RCC_FLAG_PORRST || (flag) == RCC_FLAG_PINRST || (flag) == RCC_FLAG_BORRST)
+#define __HAL_RCC_CLEAR_RESET_FLAGS() ((void)0)
+#define __HAL_RCC_BKPRAM_CLK_ENABLE() ((void)0)
+
+/** @ingroup sim
+ *  @brief Backup SRAM, which like a power-on reset starts out cleared */
+extern uint8_t sim_bkpsram[4096];
+#define D3_BKPSRAM_BASE ((uintptr_t)sim_bkpsram)
+#define __HAL_DBGMCU_FREEZE_IWDG1() ((void)0)
+
+void HAL_PWR_EnableBkUpAccess(void);
+HAL_StatusTypeDef HAL_PWREx_EnableBkUpReg(void);
+
+/* ===== UART ===== */
+
+typedef enum
+{
+    HAL_UART_STATE_RESET = 0x00U,
+    HAL_UART_STATE_READY = 0x20U,
+    HAL_UART_STATE_BUSY = 0x24U,
+} HAL_UART_StateTypeDef;
+
+typedef struct
+{
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+} UART_InitTypeDef;
+
+typedef struct
+{
+    void *Instance;
+    UART_InitTypeDef Init;
+    __IO HAL_UART_StateTypeDef gState;
+    __IO HAL_UART_StateTypeDef RxState;
+    __IO uint32_t ErrorCode;
+    int fd; /**< Host file descriptor, -1 while unconnected */
+} UART_HandleTypeDef;
+
+#define UART_CLEAR_PEF 0x01U
+#define UART_CLEAR_FEF 0x02U
+#define UART_CLEAR_NEF 0x04U
+#define UART_CLEAR_OREF 0x08U
+#define UART_CLEAR_IDLEF 0x10U
+#define __HAL_UART_CLEAR_FLAG(handle, flags) ((void)(handle), (void)(flags))
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size,
+                                           uint16_t *rx_len, uint32_t timeout);
+
+/* ===== I2C ===== */
+
+typedef struct
+{
+    uint32_t Timing;
+    uint32_t OwnAddress1;
+    uint32_t AddressingMode;
+} I2C_InitTypeDef;
+
+typedef struct
+{
+    void *Instance;
+    I2C_InitTypeDef Init;
+} I2C_HandleTypeDef;
+
+#define I2C_MEMADD_SIZE_8BIT 0x00000001U
+#define I2C_MEMADD_SIZE_16BIT 0x00000002U
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t address, uint8_t *data,
+                                          uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t address, uint8_t *data,
+                                         uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size,
+                                    uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size,
+                                   uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t address, uint32_t trials,
+                                        uint32_t timeout);
+
+/* ===== I2S ===== */
+
+#define I2S_MODE_MASTER_TX 0x00000004U
+#define I2S_STANDARD_PHILIPS 0x00000000U
+#define I2S_DATAFORMAT_16B 0x00000000U
+#define I2S_AUDIOFREQ_8K 8000U
+#define I2S_AUDIOFREQ_16K 16000U
+#define I2S_AUDIOFREQ_44K 44100U
+#define I2S_AUDIOFREQ_48K 48000U
+
+typedef struct
+{
+    uint32_t Mode;
+    uint32_t Standard;
+    uint32_t DataFormat;
+    uint32_t AudioFreq;
+} I2S_InitTypeDef;
+
+typedef struct
+{
+    void *Instance;
+    I2S_InitTypeDef Init;
+} I2S_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_I2S_Transmit(I2S_HandleTypeDef *hi2s, uint16_t *data, uint16_t size, uint32_t timeout);
+
+/* ===== SPI ===== */
+
+typedef struct
+{
+    void *Instance;
+} SPI_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size, uint32_t timeout);
+
+/* ===== TIM ===== */
+
+typedef struct
+{
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t ClockDivision;
+} TIM_Base_InitTypeDef;
+
+typedef struct
+{
+    __IO uint32_t CNT;
+    __IO uint32_t ARR;
+    __IO uint32_t CCR[4];
+    __IO uint32_t SR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+#define TIM_CHANNEL_1 0x00000000U
+#define TIM_CHANNEL_2 0x00000004U
+#define TIM_CHANNEL_3 0x00000008U
+#define TIM_CHANNEL_4 0x0000000CU
+#define TIM_FLAG_UPDATE 0x00000001U
+
+#define __HAL_TIM_SET_COMPARE(handle, channel, value) ((handle)->Instance->CCR[(channel) >> 2] = (value))
+#define __HAL_TIM_SET_COUNTER(handle, value) ((handle)->Instance->CNT = (value))
+#define __HAL_TIM_GET_AUTORELOAD(handle) ((handle)->Instance->ARR)
+/** @ingroup sim
+ *  @brief Update flag, always raised: timer-paced waits run through */
+#define __HAL_TIM_GET_FLAG(handle, flag) (((void)(handle), (flag)) != 0)
+#define __HAL_TIM_CLEAR_FLAG(handle, flag) ((handle)->Instance->SR &= ~(flag))
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef *htim, uint32_t channel, const uint32_t *data,
+                                        uint16_t length);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t channel);
+
+/* ===== RTC ===== */
+
+typedef struct
+{
+    uint8_t Hours;
+    uint8_t Minutes;
+    uint8_t Seconds;
+    uint8_t TimeFormat;
+    uint32_t SubSeconds;
+    uint32_t SecondFraction;
+    uint32_t DayLightSaving;
+    uint32_t StoreOperation;
+} RTC_TimeTypeDef;
+
+typedef struct
+{
+    uint8_t WeekDay;
+    uint8_t Month;
+    uint8_t Date;
+    uint8_t Year;
+} RTC_DateTypeDef;
+
+typedef struct
+{
+    RTC_TimeTypeDef AlarmTime;
+    uint32_t AlarmMask;
+    uint32_t AlarmSubSecondMask;
+    uint32_t AlarmDateWeekDaySel;
+    uint8_t AlarmDateWeekDay;
+    uint32_t Alarm;
+} RTC_AlarmTypeDef;
+
+typedef struct
+{
+    void *Instance;
+} RTC_HandleTypeDef;
+
+#define RTC_FORMAT_BIN 0x00000000U
+#define RTC_FORMAT_BCD 0x00000001U
+#define RTC_HOURFORMAT12_AM 0x00U
+#define RTC_DAYLIGHTSAVING_NONE 0x00000000U
+#define RTC_STOREOPERATION_RESET 0x00000000U
+#define RTC_ALARMMASK_NONE 0x00000000U
+#define RTC_ALARMMASK_DATEWEEKDAY 0x80000000U
+#define RTC_ALARMMASK_HOURS 0x00800000U
+#define RTC_ALARMMASK_MINUTES 0x00008000U
+#define RTC_ALARMMASK_SECONDS 0x00000080U
+#define RTC_ALARMMASK_ALL 0x80808080U
+#define RTC_ALARMSUBSECONDMASK_ALL 0x00000000U
+#define RTC_ALARMDATEWEEKDAYSEL_DATE 0x00000000U
+#define RTC_ALARM_A 0x00000100U
+
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *time, uint32_t format);
+HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *date, uint32_t format);
+HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *time, uint32_t format);
+HAL_StatusTypeDef HAL_RTC_SetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *date, uint32_t format);
+HAL_StatusTypeDef HAL_RTC_SetAlarm_IT(RTC_HandleTypeDef *hrtc, RTC_AlarmTypeDef *alarm, uint32_t format);
+void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc);
+
+/* ===== IWDG ===== */
+
+#define IWDG_PRESCALER_64 0x00000004U
+#define IWDG_WINDOW_DISABLE 0x00000FFFU
+
+typedef struct
+{
+    uint32_t Prescaler;
+    uint32_t Reload;
+    uint32_t Window;
+} IWDG_InitTypeDef;
+
+typedef struct
+{
+    void *Instance;
+    IWDG_InitTypeDef Init;
+} IWDG_HandleTypeDef;
+
+#define IWDG1 ((void *)0)
+
+HAL_StatusTypeDef HAL_IWDG_Init(IWDG_HandleTypeDef *hiwdg);
+HAL_StatusTypeDef HAL_IWDG_Refresh(IWDG_HandleTypeDef *hiwdg);
+
+/* ===== SD ===== */
+
+typedef struct
+{
+    uint32_t CardType;
+    uint32_t CardVersion;
+    uint32_t Class;
+    uint32_t RelCardAdd;
+    uint32_t BlockNbr;
+    uint32_t BlockSize;
+    uint32_t LogBlockNbr;
+    uint32_t LogBlockSize;
+    uint32_t CardSpeed;
+} HAL_SD_CardInfoTypeDef;
+
+typedef struct
+{
+    void *Instance;
+} SD_HandleTypeDef;
+
+#endif
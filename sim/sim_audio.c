@@ -0,0 +1,112 @@
+/**
+ * @file sim_audio.c
+ * @brief I2S output of the host simulation, written to a WAV file
+ * @ingroup sim
+ *
+ * I2S1 sends 16-bit Philips frames, a left and a right word per sample
+ * period, so each transmit is appended to a two-channel WAV at the handle's
+ * AudioFreq. The call returns when the words would have left the wire: the
+ * pace is kept against a running deadline, so many short transmits do not
+ * add up rounding, and a caller that falls behind does not get to catch up
+ * faster than real time.
+ */
+
+#include "main.h"
+#include "sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+I2S_HandleTypeDef hi2s1 = {
+    .Init = {
+        .Mode = I2S_MODE_MASTER_TX,
+        .Standard = I2S_STANDARD_PHILIPS,
+        .DataFormat = I2S_DATAFORMAT_16B,
+        .AudioFreq = I2S_AUDIOFREQ_8K,
+    },
+};
+
+#define WAV_HEADER_SIZE 44
+#define WAV_CHANNELS 2
+
+static FILE *wav;
+static uint32_t wav_bytes;
+static uint64_t wire_free_us; // when the words queued so far have been sent
+
+static void put_le(uint8_t *out, uint32_t value, int size)
+{
+    for (int i = 0; i < size; i++)
+    {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void write_header(uint32_t data_bytes)
+{
+    uint32_t rate = hi2s1.Init.AudioFreq;
+    uint8_t header[WAV_HEADER_SIZE];
+    memcpy(header, "RIFF", 4);
+    put_le(header + 4, 36 + data_bytes, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le(header + 16, 16, 4);
+    put_le(header + 20, 1, 2); // PCM
+    put_le(header + 22, WAV_CHANNELS, 2);
+    put_le(header + 24, rate, 4);
+    put_le(header + 28, rate * WAV_CHANNELS * 2, 4);
+    put_le(header + 32, WAV_CHANNELS * 2, 2);
+    put_le(header + 34, 16, 2);
+    memcpy(header + 36, "data", 4);
+    put_le(header + 40, data_bytes, 4);
+    fseek(wav, 0, SEEK_SET);
+    fwrite(header, 1, sizeof(header), wav);
+    fseek(wav, 0, SEEK_END);
+}
+
+bool sim_audio_open(const char *path)
+{
+    wav = fopen(path, "wb");
+    if (!wav)
+    {
+        perror("sim: audio");
+        return false;
+    }
+    wav_bytes = 0;
+    write_header(0);
+    return true;
+}
+
+void sim_audio_close(void)
+{
+    if (wav)
+    {
+        write_header(wav_bytes);
+        fclose(wav);
+        wav = NULL;
+    }
+}
+
+HAL_StatusTypeDef HAL_I2S_Transmit(I2S_HandleTypeDef *hi2s, uint16_t *data, uint16_t size, uint32_t timeout)
+{
+    (void)timeout;
+    if (size == 0)
+    {
+        return HAL_ERROR;
+    }
+    if (wav)
+    {
+        // the host is little-endian like the WAV samples
+        fwrite(data, sizeof(uint16_t), size, wav);
+        wav_bytes += size * sizeof(uint16_t);
+    }
+
+    uint64_t now = sim_now_us();
+    if (wire_free_us < now)
+    {
+        wire_free_us = now;
+    }
+    wire_free_us += (uint64_t)size * 1000000u / (WAV_CHANNELS * hi2s->Init.AudioFreq);
+    while (sim_now_us() < wire_free_us)
+    {
+    }
+    return HAL_OK;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file sim_cmsis_os.c
+ * @brief The CMSIS-RTOS2 calls the firmware makes, for the host simulation
+ * @ingroup sim
+ *
+ * The board uses ST's cmsis_os2.c, which reads Cortex-M core registers to
+ * tell thread from interrupt context. The firmware and FatFs only need the
+ * kernel start, threads, delays and semaphores, so those are mapped onto
+ * FreeRTOS here.
+ *
+ * Every task is a pthread running on its FreeRTOS stack, and glibc, the
+ * tick signal and host I/O need far more room than the firmware's own
+ * frames. osThreadNew() therefore takes each stack from host memory at
+ * SIM_STACK_SCALE times the size asked for (at least SIM_STACK_MIN) and
+ * leaves the task's static stack array unused. The FreeRTOS heap only holds
+ * what it holds on the board.
+ */
+
+#include "cmsis_os.h"
+#include "semphr.h"
+#include "sim.h"
+
+#include <stdlib.h>
+
+/** @ingroup sim
+ *  @brief Host stack per byte of target stack */
+#define SIM_STACK_SCALE 16
+
+/** @ingroup sim
+ *  @brief Smallest host stack, in bytes */
+#define SIM_STACK_MIN (64 * 1024)
+
+osStatus_t osKernelInitialize(void)
+{
+    return osOK;
+}
+
+osStatus_t osKernelStart(void)
+{
+    vTaskStartScheduler();
+    return osError;
+}
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr)
+{
+    const char *name = attr ? attr->name : NULL;
+    uint32_t stack_size = attr && attr->stack_size ? attr->stack_size : configMINIMAL_STACK_SIZE * sizeof(StackType_t);
+    UBaseType_t priority = attr && attr->priority != osPriorityNone ? (UBaseType_t)attr->priority : osPriorityNormal;
+
+    size_t bytes = (size_t)stack_size * SIM_STACK_SCALE;
+    if (bytes < SIM_STACK_MIN)
+    {
+        bytes = SIM_STACK_MIN;
+    }
+    StackType_t *stack = calloc(1, bytes);
+    StaticTask_t *tcb = attr && attr->cb_mem && attr->cb_size >= sizeof(StaticTask_t) ? attr->cb_mem
+                                                                                         : calloc(1, sizeof(StaticTask_t));
+    if (!stack || !tcb)
+    {
+        return NULL;
+    }
+    return (osThreadId_t)xTaskCreateStatic((TaskFunction_t)func, name ? name : "", bytes / sizeof(StackType_t),
+                                           argument, priority, stack, tcb);
+}
+
+osStatus_t osDelay(uint32_t ticks)
+{
+    if (ticks != 0)
+    {
+        vTaskDelay(ticks);
+    }
+    return osOK;
+}
+
+osSemaphoreId_t osSemaphoreNew(uint32_t max_count, uint32_t initial_count, const osSemaphoreAttr_t *attr)
+{
+    // a control block passed in is used, as cmsis_os2.c does, so the heap holds what it does on the board
+    StaticSemaphore_t *cb = attr && attr->cb_mem && attr->cb_size >= sizeof(StaticSemaphore_t)
+                                ? (StaticSemaphore_t *)attr->cb_mem
+                                : NULL;
+    SemaphoreHandle_t sem;
+    if (max_count == 1)
+    {
+        sem = cb ? xSemaphoreCreateBinaryStatic(cb) : xSemaphoreCreateBinary();
+        if (sem && initial_count != 0)
+        {
+            xSemaphoreGive(sem);
+        }
+    }
+    else
+    {
+        sem = cb ? xSemaphoreCreateCountingStatic(max_count, initial_count, cb)
+                 : xSemaphoreCreateCounting(max_count, initial_count);
+    }
+    return (osSemaphoreId_t)sem;
+}
+
+osStatus_t osSemaphoreAcquire(osSemaphoreId_t semaphore_id, uint32_t timeout)
+{
+    if (!semaphore_id)
+    {
+        return osErrorParameter;
+    }
+    if (xSemaphoreTake((SemaphoreHandle_t)semaphore_id, timeout) != pdPASS)
+    {
+        return timeout != 0 ? osErrorTimeout : osErrorResource;
+    }
+    return osOK;
+}
+
+osStatus_t osSemaphoreRelease(osSemaphoreId_t semaphore_id)
+{
+    if (!semaphore_id)
+    {
+        return osErrorParameter;
+    }
+    return xSemaphoreGive((SemaphoreHandle_t)semaphore_id) == pdPASS ? osOK : osErrorResource;
+}
+
+osStatus_t osSemaphoreDelete(osSemaphoreId_t semaphore_id)
+{
+    if (!semaphore_id)
+    {
+        return osErrorParameter;
+    }
+    vSemaphoreDelete((SemaphoreHandle_t)semaphore_id);
+    return osOK;
+}
+
+/* ===== KERNEL TASKS ===== */
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *stack_size)
+{
+    static StaticTask_t idle_tcb;
+    static StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+    *tcb = &idle_tcb;
+    *stack = idle_stack;
+    *stack_size = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *stack_size)
+{
+    static StaticTask_t timer_tcb;
+    static StackType_t timer_stack[configTIMER_TASK_STACK_DEPTH];
+    *tcb = &timer_tcb;
+    *stack = timer_stack;
+    *stack_size = configTIMER_TASK_STACK_DEPTH;
+}
@@ -0,0 +1,178 @@
+/**
+ * @file sim_display.c
+ * @brief ST7789V panel model of the host simulation
+ * @ingroup sim
+ *
+ * The simulation builds the display with DISPLAY_BUS_FMC, so every bus cycle
+ * of LCD_Controller.c arrives at lcd_fmc_bus_write(). The model decodes
+ * command and data from the D/C address bit, follows CASET, RASET, RAMWR and
+ * the MADCTL row/column exchange, and keeps the panel's RGB565 memory.
+ *
+ * The panel has no notion of a frame, so one is taken to have ended when
+ * pixels were written and the bus then stayed quiet for SIM_FRAME_QUIET_US.
+ * The PPM is then rewritten, at most every SIM_FRAME_MIN_US, through a
+ * temporary file and a rename so a viewer never reads half an image.
+ */
+
+#include "sim.h"
+#include "st7789v.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/** @ingroup sim
+ *  @brief Bus silence that ends a frame */
+#define SIM_FRAME_QUIET_US 4000
+
+/** @ingroup sim
+ *  @brief Shortest time between two PPM writes */
+#define SIM_FRAME_MIN_US 50000
+
+#define PANEL_W ST7789V_LCD_PIXEL_WIDTH
+#define PANEL_H ST7789V_LCD_PIXEL_HEIGHT
+#define MADCTL_MV 0x20
+
+static uint16_t panel[PANEL_W * PANEL_H];
+static uint8_t command;
+static uint8_t params[4];
+static int param_count;
+static uint16_t col0, col1, row0, row1, cur_x, cur_y;
+static bool in_ramwr;
+static bool exchange; // MADCTL MV, rows and columns swapped
+
+static const char *frame_path;
+static volatile uint32_t pixel_writes; // counts RAMWR data cycles
+static uint32_t pixel_writes_seen;
+static uint64_t quiet_since_us;
+static uint64_t last_save_us;
+
+static uint16_t width(void)
+{
+    return exchange ? PANEL_H : PANEL_W;
+}
+
+static uint16_t height(void)
+{
+    return exchange ? PANEL_W : PANEL_H;
+}
+
+void lcd_fmc_bus_write(uintptr_t address, uint16_t value)
+{
+    if (!(address & LCD_FMC_DATA_BIT))
+    {
+        command = (uint8_t)value;
+        param_count = 0;
+        in_ramwr = command == ST7789V_RAMWR;
+        cur_x = col0;
+        cur_y = row0;
+        return;
+    }
+
+    if (in_ramwr)
+    {
+        if (cur_x < width() && cur_y < height())
+        {
+            panel[cur_y * width() + cur_x] = value;
+        }
+        if (++cur_x > col1)
+        {
+            cur_x = col0;
+            if (++cur_y > row1)
+            {
+                cur_y = row0;
+            }
+        }
+        pixel_writes++;
+        return;
+    }
+
+    // parameters arrive on D[7:0]
+    if (param_count < (int)sizeof(params))
+    {
+        params[param_count++] = (uint8_t)value;
+    }
+    if (command == ST7789V_CASET && param_count == 4)
+    {
+        col0 = (uint16_t)(params[0] << 8 | params[1]);
+        col1 = (uint16_t)(params[2] << 8 | params[3]);
+    }
+    else if (command == ST7789V_RASET && param_count == 4)
+    {
+        row0 = (uint16_t)(params[0] << 8 | params[1]);
+        row1 = (uint16_t)(params[2] << 8 | params[3]);
+    }
+    else if (command == ST7789V_MADCTL && param_count == 1)
+    {
+        exchange = (params[0] & MADCTL_MV) != 0;
+    }
+}
+
+uint16_t lcd_fmc_bus_read(uintptr_t address)
+{
+    return (address & LCD_FMC_DATA_BIT) ? ST7789V_ID : 0;
+}
+
+void sim_display_init(const char *path)
+{
+    frame_path = path;
+    col1 = PANEL_W - 1;
+    row1 = PANEL_H - 1;
+}
+
+bool sim_display_save(const char *path)
+{
+    char temp[512];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE *file = fopen(temp, "wb");
+    if (!file)
+    {
+        perror("sim: display");
+        return false;
+    }
+    uint16_t w = width(), h = height();
+    fprintf(file, "P6\n%u %u\n255\n", w, h);
+    static uint8_t row[PANEL_H * 3];
+    for (uint16_t y = 0; y < h; y++)
+    {
+        for (uint16_t x = 0; x < w; x++)
+        {
+            uint16_t pixel = panel[y * w + x];
+            // widen 5/6/5 to 8 bits, repeating the top bits into the bottom
+            uint8_t r = (uint8_t)(pixel >> 11), g = (uint8_t)((pixel >> 5) & 0x3F), b = (uint8_t)(pixel & 0x1F);
+            row[x * 3] = (uint8_t)(r << 3 | r >> 2);
+            row[x * 3 + 1] = (uint8_t)(g << 2 | g >> 4);
+            row[x * 3 + 2] = (uint8_t)(b << 3 | b >> 2);
+        }
+        fwrite(row, 3, w, file);
+    }
+    bool ok = fclose(file) == 0 && rename(temp, path) == 0;
+    if (!ok)
+    {
+        perror("sim: display");
+    }
+    return ok;
+}
+
+void sim_display_poll(void)
+{
+    if (!frame_path)
+    {
+        return;
+    }
+    // the writer is never timed, the poll notes when the count last moved
+    uint64_t now = sim_now_us();
+    uint32_t writes = pixel_writes;
+    if (writes != pixel_writes_seen)
+    {
+        pixel_writes_seen = writes;
+        quiet_since_us = now;
+        return;
+    }
+    if (quiet_since_us == 0 || now - quiet_since_us < SIM_FRAME_QUIET_US || now - last_save_us < SIM_FRAME_MIN_US)
+    {
+        return;
+    }
+    quiet_since_us = 0;
+    last_save_us = now;
+    sim_display_save(frame_path);
+}
@@ -0,0 +1,495 @@
+/**
+ * @file sim_hal.c
+ * @brief HAL calls of the host simulation: time, GPIO, I2C, RTC and the rest
+ * @ingroup sim
+ *
+ * Time comes from the host's monotonic clock. HAL_Delay() behaves like the
+ * board's: a task sleeps once the scheduler runs, anything else spins.
+ * The I2C bus holds a register file per address, with the fuel gauge and
+ * IMU preloaded so their drivers read sensible values. The RTC runs off the
+ * host's local time plus whatever offset HAL_RTC_SetTime() and
+ * HAL_RTC_SetDate() leave. Timers, the watchdog, SPI and the NVIC accept
+ * their calls and do nothing.
+ *
+ * printf() and friends are wrapped at link time (see sim/Makefile): each
+ * call formats into a stack buffer and hands it to write(2) whole, so a
+ * task switch in the middle of a line cannot leave another task waiting on
+ * a stdio lock held by a task that is not running.
+ */
+
+#include "main.h"
+#include "sim.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "bq27441.h"
+#include "lsm6dsv.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+uint32_t SystemCoreClock = 480000000; // PLL1P from SystemClock_Config()
+
+GPIO_TypeDef sim_gpio[11];
+EXTI_Core_TypeDef sim_exti;
+uint8_t sim_bkpsram[4096];
+
+I2C_HandleTypeDef hi2c1;
+SPI_HandleTypeDef hspi4;
+RTC_HandleTypeDef hrtc;
+SD_HandleTypeDef hsd1;
+static TIM_TypeDef tim_regs[3];
+TIM_HandleTypeDef htim3 = {.Instance = &tim_regs[0]};
+TIM_HandleTypeDef htim5 = {.Instance = &tim_regs[1], .Init = {.Period = 299}};
+TIM_HandleTypeDef htim13 = {.Instance = &tim_regs[2]};
+
+static struct timespec start_time;
+
+/* ===== TIME ===== */
+
+uint64_t sim_now_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (start_time.tv_sec == 0 && start_time.tv_nsec == 0)
+    {
+        start_time = now;
+    }
+    return (uint64_t)(now.tv_sec - start_time.tv_sec) * 1000000u +
+           (uint64_t)((now.tv_nsec - start_time.tv_nsec) / 1000);
+}
+
+uint32_t sim_run_time_counter(void)
+{
+    return (uint32_t)sim_now_us();
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(sim_now_us() / 1000u);
+}
+
+void HAL_Delay(uint32_t delay)
+{
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING && !sim_in_interrupt())
+    {
+        vTaskDelay(delay < HAL_MAX_DELAY ? pdMS_TO_TICKS(delay) + 1 : portMAX_DELAY);
+        return;
+    }
+
+    uint32_t start = HAL_GetTick();
+    // the HAL adds a tick so the wait is at least the requested time
+    if (delay < HAL_MAX_DELAY)
+    {
+        delay++;
+    }
+    while (HAL_GetTick() - start < delay)
+    {
+    }
+}
+
+void HAL_IncTick(void)
+{
+}
+
+void HAL_SuspendTick(void)
+{
+}
+
+void HAL_ResumeTick(void)
+{
+}
+
+void sim_assert_failed(const char *file, int line)
+{
+    printf("sim: assertion failed at %s:%d\n", file, line);
+    abort();
+}
+
+/* ===== CONSOLE ===== */
+
+int __wrap_vprintf(const char *format, va_list args)
+{
+    char line[512];
+    int len = vsnprintf(line, sizeof(line), format, args);
+    if (len > (int)sizeof(line) - 1)
+    {
+        len = sizeof(line) - 1;
+    }
+    if (len > 0 && write(STDOUT_FILENO, line, (size_t)len) < 0)
+    {
+        return -1;
+    }
+    return len;
+}
+
+int __wrap_printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int len = __wrap_vprintf(format, args);
+    va_end(args);
+    return len;
+}
+
+int __wrap_puts(const char *text)
+{
+    return __wrap_printf("%s\n", text);
+}
+
+int __wrap_putchar(int c)
+{
+    char ch = (char)c;
+    return write(STDOUT_FILENO, &ch, 1) == 1 ? c : EOF;
+}
+
+/* ===== GPIO ===== */
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init)
+{
+    // inputs idle high through their pull-ups, like the buttons and RI on the board
+    if (init->Pull == GPIO_PULLUP)
+    {
+        port->IDR |= init->Pin;
+    }
+    // HAL_GPIO_Init unmasks the EXTI line of an interrupt pin
+    if ((init->Mode & 0x10000000U) != 0)
+    {
+        EXTI_D1->IMR1 |= init->Pin;
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin)
+{
+    return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    if (state == GPIO_PIN_SET)
+    {
+        port->ODR |= pin;
+    }
+    else
+    {
+        port->ODR &= ~(uint32_t)pin;
+    }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin)
+{
+    port->ODR ^= pin;
+}
+
+void HAL_GPIO_EXTI_IRQHandler(uint16_t pin)
+{
+    if (EXTI_D1->PR1 & pin)
+    {
+        EXTI_D1->PR1 &= ~(uint32_t)pin;
+        HAL_GPIO_EXTI_Callback(pin);
+    }
+}
+
+__attribute__((weak)) void HAL_GPIO_EXTI_Callback(uint16_t pin)
+{
+    (void)pin;
+}
+
+/* ===== NVIC, PWR, IWDG ===== */
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt, uint32_t sub)
+{
+    (void)irq;
+    (void)preempt;
+    (void)sub;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq)
+{
+    (void)irq;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type irq)
+{
+    (void)irq;
+}
+
+void HAL_PWR_EnableBkUpAccess(void)
+{
+}
+
+HAL_StatusTypeDef HAL_PWREx_EnableBkUpReg(void)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_IWDG_Init(IWDG_HandleTypeDef *hiwdg)
+{
+    (void)hiwdg;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_IWDG_Refresh(IWDG_HandleTypeDef *hiwdg)
+{
+    (void)hiwdg;
+    return HAL_OK;
+}
+
+void Error_Handler(void)
+{
+    printf("sim: Error_Handler\n");
+    abort();
+}
+
+/* ===== I2C ===== */
+
+#define I2C_DEVICES 128
+#define I2C_REGS 256
+
+static uint8_t i2c_regs[I2C_DEVICES][I2C_REGS];
+static bool i2c_ready;
+
+static void i2c_put16(uint8_t address, uint8_t reg, uint16_t value)
+{
+    i2c_regs[address][reg] = (uint8_t)value;
+    i2c_regs[address][reg + 1] = (uint8_t)(value >> 8);
+}
+
+// a charged battery at room temperature and an IMU that answers its ID
+static void i2c_preload(void)
+{
+    i2c_put16(BQ27441_I2C_ADDR, BQ27441_CMD_TEMP, 2982); // 0.1 K
+    i2c_put16(BQ27441_I2C_ADDR, BQ27441_CMD_VOLTAGE, 3950);
+    i2c_put16(BQ27441_I2C_ADDR, BQ27441_CMD_REMAINING_CAPACITY, 1600);
+    i2c_put16(BQ27441_I2C_ADDR, BQ27441_CMD_FULL_CHARGE_CAPACITY, 2000);
+    i2c_put16(BQ27441_I2C_ADDR, BQ27441_CMD_AVERAGE_CURRENT, (uint16_t)-120);
+    i2c_put16(BQ27441_I2C_ADDR, BQ27441_CMD_STATE_OF_CHARGE, 80);
+    i2c_put16(BQ27441_I2C_ADDR, BQ27441_CMD_STATE_OF_HEALTH, 100);
+    i2c_regs[LSM6DSV_I2C_ADDR][LSM6DSV_WHO_AM_I] = 0x70;
+    i2c_ready = true;
+}
+
+static void i2c_access(uint16_t address, uint16_t reg, uint8_t *data, uint16_t size, bool write)
+{
+    if (!i2c_ready)
+    {
+        i2c_preload();
+    }
+    uint8_t *regs = i2c_regs[(address >> 1) & (I2C_DEVICES - 1)];
+    for (uint16_t i = 0; i < size; i++)
+    {
+        uint8_t *r = &regs[(reg + i) & (I2C_REGS - 1)];
+        if (write)
+        {
+            *r = data[i];
+        }
+        else
+        {
+            data[i] = *r;
+        }
+    }
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t address, uint8_t *data,
+                                          uint16_t size, uint32_t timeout)
+{
+    (void)hi2c;
+    (void)timeout;
+    // the first byte selects the register, the rest are written from there
+    if (size > 0)
+    {
+        i2c_access(address, data[0], data + 1, size - 1, true);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t address, uint8_t *data,
+                                         uint16_t size, uint32_t timeout)
+{
+    (void)hi2c;
+    (void)timeout;
+    i2c_access(address, 0, data, size, false);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size,
+                                    uint8_t *data, uint16_t size, uint32_t timeout)
+{
+    (void)hi2c;
+    (void)reg_size;
+    (void)timeout;
+    i2c_access(address, reg, data, size, true);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size,
+                                   uint8_t *data, uint16_t size, uint32_t timeout)
+{
+    (void)hi2c;
+    (void)reg_size;
+    (void)timeout;
+    i2c_access(address, reg, data, size, false);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t address, uint32_t trials,
+                                        uint32_t timeout)
+{
+    (void)hi2c;
+    (void)address;
+    (void)trials;
+    (void)timeout;
+    return HAL_OK;
+}
+
+/* ===== SPI, TIM ===== */
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *data, uint16_t size, uint32_t timeout)
+{
+    (void)hspi;
+    (void)data;
+    (void)size;
+    (void)timeout;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size, uint32_t timeout)
+{
+    (void)hspi;
+    (void)timeout;
+    memset(data, 0, size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t channel)
+{
+    (void)htim;
+    (void)channel;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t channel)
+{
+    (void)htim;
+    (void)channel;
+    return HAL_OK;
+}
+
+/* ===== RTC ===== */
+
+static time_t rtc_offset; // seconds between the RTC and host local time
+static RTC_AlarmTypeDef rtc_alarm;
+static bool rtc_alarm_armed;
+static time_t rtc_alarm_last;
+
+static void rtc_now(struct tm *tm)
+{
+    time_t now = time(NULL) + rtc_offset;
+    localtime_r(&now, tm);
+}
+
+static void rtc_set(const struct tm *tm)
+{
+    struct tm copy = *tm;
+    copy.tm_isdst = -1;
+    rtc_offset = mktime(&copy) - time(NULL);
+}
+
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *time, uint32_t format)
+{
+    (void)hrtc;
+    (void)format;
+    struct tm tm;
+    rtc_now(&tm);
+    memset(time, 0, sizeof(*time));
+    time->Hours = (uint8_t)tm.tm_hour;
+    time->Minutes = (uint8_t)tm.tm_min;
+    time->Seconds = (uint8_t)tm.tm_sec;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *date, uint32_t format)
+{
+    (void)hrtc;
+    (void)format;
+    struct tm tm;
+    rtc_now(&tm);
+    date->WeekDay = (uint8_t)(tm.tm_wday == 0 ? 7 : tm.tm_wday); // RTC_WEEKDAY_SUNDAY is 7
+    date->Month = (uint8_t)(tm.tm_mon + 1);
+    date->Date = (uint8_t)tm.tm_mday;
+    date->Year = (uint8_t)(tm.tm_year % 100);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *time, uint32_t format)
+{
+    (void)hrtc;
+    (void)format;
+    struct tm tm;
+    rtc_now(&tm);
+    tm.tm_hour = time->Hours;
+    tm.tm_min = time->Minutes;
+    tm.tm_sec = time->Seconds;
+    rtc_set(&tm);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_SetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *date, uint32_t format)
+{
+    (void)hrtc;
+    (void)format;
+    struct tm tm;
+    rtc_now(&tm);
+    tm.tm_mon = date->Month - 1;
+    tm.tm_mday = date->Date;
+    tm.tm_year = 100 + date->Year;
+    rtc_set(&tm);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_SetAlarm_IT(RTC_HandleTypeDef *hrtc, RTC_AlarmTypeDef *alarm, uint32_t format)
+{
+    (void)hrtc;
+    (void)format;
+    rtc_alarm = *alarm;
+    rtc_alarm_armed = true;
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc)
+{
+    (void)hrtc;
+}
+
+/**
+ * @ingroup sim
+ * @brief Raise the RTC alarm once in the second its unmasked fields match
+ */
+void sim_rtc_poll(void)
+{
+    if (!rtc_alarm_armed)
+    {
+        return;
+    }
+    time_t now = time(NULL) + rtc_offset;
+    if (now == rtc_alarm_last)
+    {
+        return;
+    }
+    struct tm tm;
+    localtime_r(&now, &tm);
+    const RTC_TimeTypeDef *at = &rtc_alarm.AlarmTime;
+    uint32_t mask = rtc_alarm.AlarmMask;
+    if ((!(mask & RTC_ALARMMASK_DATEWEEKDAY) && rtc_alarm.AlarmDateWeekDay != tm.tm_mday) ||
+        (!(mask & RTC_ALARMMASK_HOURS) && at->Hours != tm.tm_hour) ||
+        (!(mask & RTC_ALARMMASK_MINUTES) && at->Minutes != tm.tm_min) ||
+        (!(mask & RTC_ALARMMASK_SECONDS) && at->Seconds != tm.tm_sec))
+    {
+        return;
+    }
+    rtc_alarm_last = now;
+    HAL_RTC_AlarmAEventCallback(&hrtc);
+}
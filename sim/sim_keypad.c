@@ -0,0 +1,249 @@
+/**
+ * @file sim_keypad.c
+ * @brief Scripted keypad of the host simulation
+ * @ingroup sim
+ *
+ * The keypad driver reads the button pins straight from the GPIO input
+ * registers, so a press here pulls the pin's IDR bit low and a release sets
+ * it again. A press on an armed wake key also latches its EXTI line and
+ * runs keypad_exti_irq(), as the EXTI handlers do on the board.
+ *
+ * The script is read a line at a time, from a file or from stdin, without
+ * blocking the simulation. One command per line, '#' starts a comment:
+ *
+ *     wait MS              do nothing for MS milliseconds
+ *     press KEY [MS]       hold KEY for MS (default 80), then wait as long again
+ *     screenshot FILE      write the display to FILE as a PPM
+ *     quit                 stop the simulation
+ *
+ * KEY is one of 0-9, STAR, HASH, UP, DOWN, LEFT, RIGHT, SELECT, MENU_L,
+ * MENU_R, CALL, END, VOL_UP, VOL_DOWN or PWR.
+ */
+
+#include "main.h"
+#include "keypad.h"
+#include "sim.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+/** @ingroup sim
+ *  @brief Hold time of a press that gives none */
+#define SIM_KEY_HOLD_MS 80
+
+typedef struct
+{
+    const char *name;
+    GPIO_TypeDef *port;
+    uint16_t pin;
+} SimKey;
+
+static const SimKey keys[] = {
+    {"0", PB_0_GPIO_Port, PB_0_Pin},
+    {"1", PB_1_GPIO_Port, PB_1_Pin},
+    {"2", PB_2_GPIO_Port, PB_2_Pin},
+    {"3", PB_3_GPIO_Port, PB_3_Pin},
+    {"4", PB_4_GPIO_Port, PB_4_Pin},
+    {"5", PB_5_GPIO_Port, PB_5_Pin},
+    {"6", PB_6_GPIO_Port, PB_6_Pin},
+    {"7", PB_7_GPIO_Port, PB_7_Pin},
+    {"8", PB_8_GPIO_Port, PB_8_Pin},
+    {"9", PB_9_GPIO_Port, PB_9_Pin},
+    {"STAR", PB_STAR_GPIO_Port, PB_STAR_Pin},
+    {"HASH", PB_HASH_GPIO_Port, PB_HASH_Pin},
+    {"UP", PB_DPAD_UP_GPIO_Port, PB_DPAD_UP_Pin},
+    {"DOWN", PB_DPAD_DOWN_GPIO_Port, PB_DPAD_DOWN_Pin},
+    {"LEFT", PB_DPAD_LEFT_GPIO_Port, PB_DPAD_LEFT_Pin},
+    {"RIGHT", PB_DPAD_RIGHT_GPIO_Port, PB_DPAD_RIGHT_Pin},
+    {"SELECT", PB_DPAD_SELECT_GPIO_Port, PB_DPAD_SELECT_Pin},
+    {"MENU_L", PB_MENU_L_GPIO_Port, PB_MENU_L_Pin},
+    {"MENU_R", PB_MENU_R_GPIO_Port, PB_MENU_R_Pin},
+    {"CALL", PB_CALL_GPIO_Port, PB_CALL_Pin},
+    {"END", PB_END_CALL_GPIO_Port, PB_END_CALL_Pin},
+    {"VOL_UP", PB_VOL_UP_GPIO_Port, PB_VOL_UP_Pin},
+    {"VOL_DOWN", PB_VOL_DOWN_GPIO_Port, PB_VOL_DOWN_Pin},
+    {"PWR", PB_PWR_GPIO_Port, PB_PWR_Pin},
+};
+
+#define KEY_COUNT (sizeof(keys) / sizeof(keys[0]))
+
+static int script_fd = -1;
+static char line[256];
+static size_t line_len;
+static uint64_t next_step_us;
+static const SimKey *held;
+static uint64_t release_us;
+
+static void key_press(const SimKey *key)
+{
+    key->port->IDR &= ~(uint32_t)key->pin;
+    // a falling edge on an unmasked line is latched and handled at once
+    if (EXTI_D1->IMR1 & key->pin)
+    {
+        EXTI_D1->PR1 |= key->pin;
+        keypad_exti_irq();
+        EXTI_D1->PR1 &= ~(uint32_t)key->pin;
+    }
+}
+
+static void key_release(const SimKey *key)
+{
+    key->port->IDR |= key->pin;
+}
+
+static const SimKey *key_find(const char *name)
+{
+    for (size_t i = 0; i < KEY_COUNT; i++)
+    {
+        if (strcasecmp(keys[i].name, name) == 0)
+        {
+            return &keys[i];
+        }
+    }
+    return NULL;
+}
+
+bool sim_keypad_open(const char *path)
+{
+    // the board's pull-ups hold every button high until pressed
+    for (size_t i = 0; i < KEY_COUNT; i++)
+    {
+        key_release(&keys[i]);
+    }
+    if (!path)
+    {
+        return true;
+    }
+    script_fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+    if (script_fd < 0)
+    {
+        perror("sim: keys");
+        return false;
+    }
+    fcntl(script_fd, F_SETFL, fcntl(script_fd, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+// next complete line of the script into line, false until one is there
+static bool script_line(void)
+{
+    for (;;)
+    {
+        char *end = memchr(line, '\n', line_len);
+        if (end)
+        {
+            *end = '\0';
+            return true;
+        }
+        if (line_len == sizeof(line) - 1)
+        {
+            // too long to be a command, drop it
+            line_len = 0;
+        }
+        ssize_t got = read(script_fd, line + line_len, sizeof(line) - 1 - line_len);
+        if (got == 0 && line_len > 0)
+        {
+            // last line without a newline
+            line[line_len++] = '\n';
+            continue;
+        }
+        if (got <= 0)
+        {
+            if (got < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        line_len += (size_t)got;
+    }
+}
+
+static void script_consume(size_t used)
+{
+    memmove(line, line + used, line_len - used);
+    line_len -= used;
+}
+
+// runs one command, false when the script has to wait
+static bool script_step(uint64_t now)
+{
+    char *comment = strchr(line, '#');
+    if (comment)
+    {
+        *comment = '\0';
+    }
+    char *save;
+    char *command = strtok_r(line, " \t\r", &save);
+    char *arg = command ? strtok_r(NULL, " \t\r", &save) : NULL;
+    char *arg2 = arg ? strtok_r(NULL, " \t\r", &save) : NULL;
+    if (!command)
+    {
+        return true;
+    }
+
+    if (strcmp(command, "wait") == 0 && arg)
+    {
+        next_step_us = now + strtoul(arg, NULL, 10) * 1000u;
+        return false;
+    }
+    if (strcmp(command, "press") == 0 && arg)
+    {
+        const SimKey *key = key_find(arg);
+        if (!key)
+        {
+            printf("sim: unknown key '%s'\n", arg);
+            return true;
+        }
+        uint64_t hold = (arg2 ? strtoul(arg2, NULL, 10) : SIM_KEY_HOLD_MS) * 1000u;
+        if (held)
+        {
+            key_release(held);
+        }
+        key_press(key);
+        held = key;
+        release_us = now + hold;
+        next_step_us = now + 2 * hold;
+        return false;
+    }
+    if (strcmp(command, "screenshot") == 0 && arg)
+    {
+        sim_display_save(arg);
+        return true;
+    }
+    if (strcmp(command, "quit") == 0)
+    {
+        sim_exit(0);
+    }
+    printf("sim: bad key script line '%s'\n", command);
+    return true;
+}
+
+void sim_keypad_poll(void)
+{
+    uint64_t now = sim_now_us();
+    if (held && now >= release_us)
+    {
+        key_release(held);
+        held = NULL;
+    }
+    if (script_fd < 0 || now < next_step_us)
+    {
+        return;
+    }
+    while (script_line())
+    {
+        size_t used = strlen(line) + 1; // before the parse cuts the line up
+        bool more = script_step(now);
+        script_consume(used);
+        if (!more)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,249 @@
+/**
+ * @file sim_main.c
+ * @brief Entry point of the host simulation
+ * @ingroup sim
+ *
+ * Stands in for kernel/main.c: where the board configures clocks and
+ * peripherals, the simulation opens its models, then starts the kernel the
+ * same way. The tasks bring up their models as they would the hardware, and
+ * the boot task mounts the card, so the boot timeline reads as it does on
+ * the board; the clock phase has nothing to time here and is skipped.
+ *
+ * The peripheral task runs at the highest priority and plays the part of
+ * the interrupt handlers, see sim.h. It also ends the run, on the key
+ * script's quit, after --duration or on Ctrl-C, and writes the outputs
+ * before the process exits.
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "boot_timeline.h"
+#include "kernel.h"
+#include "sim.h"
+#include "trace.h"
+#include "profile.h"
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * @brief Paths and options given on the command line
+ * @ingroup sim
+ */
+typedef struct
+{
+    const char *keys;        /**< Key script, "-" for stdin, NULL for none */
+    const char *framebuffer; /**< PPM written after every frame */
+    const char *wav;         /**< Audio output */
+    const char *sd_image;    /**< FatFs image */
+    const char *sd_seed;     /**< Directory copied into a new image, NULL for none */
+    uint32_t sd_size_mb;     /**< Size of a new image */
+    const char *modem_link;  /**< Symlink made to the modem pty, NULL for none */
+    const char *trace;       /**< Trace dump written on exit, NULL for none */
+    uint32_t duration_ms;    /**< Stop after this long, 0 to run until quit */
+} SimOptions;
+
+static SimOptions options = {
+    .framebuffer = "screen.ppm",
+    .wav = "audio.wav",
+    .sd_image = "sdcard.img",
+    .sd_size_mb = 64,
+};
+
+static volatile sig_atomic_t interrupted;
+static TaskHandle_t peripheral_task;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    interrupted = 1;
+}
+
+#if defined(TRACE_ENABLED)
+static bool file_write(const void *data, size_t len, void *arg)
+{
+    return fwrite(data, 1, len, (FILE *)arg) == len;
+}
+
+static void trace_write(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        perror("sim: trace");
+        return;
+    }
+    size_t bytes = trace_dump(file_write, file);
+    fclose(file);
+    printf("sim: trace of %u bytes written to %s\n", (unsigned)bytes, path);
+}
+#endif
+
+void sim_exit(int status)
+{
+    static volatile bool exiting;
+    if (exiting)
+    {
+        return;
+    }
+    exiting = true;
+    sim_audio_close();
+    if (options.framebuffer)
+    {
+        sim_display_save(options.framebuffer);
+    }
+#if defined(TRACE_ENABLED)
+    if (options.trace)
+    {
+        trace_write(options.trace);
+    }
+#endif
+    printf("sim: stopped after %u ms\n", (unsigned)HAL_GetTick());
+    // the other tasks are parked threads holding no host locks worth waiting for
+    _exit(status);
+}
+
+int sim_in_interrupt(void)
+{
+    return peripheral_task && xTaskGetCurrentTaskHandle() == peripheral_task;
+}
+
+static void sim_peripheral_task(void *argument)
+{
+    (void)argument;
+    TickType_t wake = xTaskGetTickCount();
+    for (;;)
+    {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(SIM_PERIPHERAL_PERIOD_MS));
+        sim_keypad_poll();
+        sim_modem_poll();
+        sim_rtc_poll();
+        sim_display_poll();
+        if (interrupted || (options.duration_ms && HAL_GetTick() >= options.duration_ms))
+        {
+            sim_exit(0);
+        }
+    }
+}
+
+void sim_peripherals_start(void)
+{
+    static StaticTask_t tcb;
+    osThreadAttr_t attr = {
+        .name = "SimPeripherals",
+        .cb_mem = &tcb,
+        .cb_size = sizeof(tcb),
+        .stack_size = 4096,
+        .priority = (osPriority_t)(configMAX_PRIORITIES - 1),
+    };
+    peripheral_task = (TaskHandle_t)osThreadNew(sim_peripheral_task, NULL, &attr);
+}
+
+static void usage(const char *name)
+{
+    printf("usage: %s [options]\n"
+           "  --keys FILE       key script, - for stdin (see sim/sim_keypad.c)\n"
+           "  --fb FILE         display image, rewritten after each frame (screen.ppm)\n"
+           "  --wav FILE        I2S output (audio.wav)\n"
+           "  --sd FILE         SD card image, created if missing (sdcard.img)\n"
+           "  --sd-seed DIR     files copied into a newly created image\n"
+           "  --sd-size MB      size of a new image (64)\n"
+           "  --modem-link PATH symlink to the modem pty, for tools/modem_sim.py\n"
+           "  --trace FILE      trace dump written on exit\n"
+           "  --duration MS     stop after MS milliseconds\n",
+           name);
+}
+
+static bool parse_args(int argc, char **argv)
+{
+    static const struct option longopts[] = {
+        {"keys", required_argument, NULL, 'k'},
+        {"fb", required_argument, NULL, 'f'},
+        {"wav", required_argument, NULL, 'w'},
+        {"sd", required_argument, NULL, 's'},
+        {"sd-seed", required_argument, NULL, 'S'},
+        {"sd-size", required_argument, NULL, 'z'},
+        {"modem-link", required_argument, NULL, 'm'},
+        {"trace", required_argument, NULL, 't'},
+        {"duration", required_argument, NULL, 'd'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longopts, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'k':
+            options.keys = optarg;
+            break;
+        case 'f':
+            options.framebuffer = optarg;
+            break;
+        case 'w':
+            options.wav = optarg;
+            break;
+        case 's':
+            options.sd_image = optarg;
+            break;
+        case 'S':
+            options.sd_seed = optarg;
+            break;
+        case 'z':
+            options.sd_size_mb = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'm':
+            options.modem_link = optarg;
+            break;
+        case 't':
+            options.trace = optarg;
+            break;
+        case 'd':
+            options.duration_ms = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse_args(argc, argv))
+    {
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    sim_now_us(); // time starts here
+
+#if defined(TRACE_ENABLED)
+    // host timestamps are nanoseconds
+    trace_init(1000000000u);
+#endif
+#if defined(PROFILE_ENABLED)
+    profile_init(1000000000u);
+#endif
+    boot_phase_skip(BOOT_PHASE_CLOCKS);
+    boot_phase_begin(BOOT_PHASE_PERIPHERALS, HAL_GetTick());
+    sim_display_init(options.framebuffer);
+    if (!sim_keypad_open(options.keys) || !sim_modem_open(options.modem_link) || !sim_audio_open(options.wav) ||
+        !sim_sdcard_open(options.sd_image, options.sd_seed, options.sd_size_mb))
+    {
+        return 1;
+    }
+    boot_phase_end(BOOT_PHASE_PERIPHERALS, true, HAL_GetTick());
+
+    boot_phase_begin(BOOT_PHASE_KERNEL, HAL_GetTick());
+    osKernelInitialize();
+    kernel_init();
+    boot_phase_end(BOOT_PHASE_KERNEL, true, HAL_GetTick());
+    sim_peripherals_start();
+    osKernelStart();
+    return 0;
+}
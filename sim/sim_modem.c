@@ -0,0 +1,219 @@
+/**
+ * @file sim_modem.c
+ * @brief Modem UART of the host simulation, carried over a pty
+ * @ingroup sim
+ *
+ * The modem UART is the master side of a pty. tools/modem_sim.py, or a
+ * terminal, opens the slave side and plays the modem. The simulation keeps
+ * its own handle on the slave open, so nothing is lost while no modem is
+ * attached: commands then go unanswered, as with a modem that is off.
+ *
+ * Receives behave like the blocking HAL calls. HAL_UART_Receive() waits for
+ * the full count or the timeout, and HAL_UARTEx_ReceiveToIdle() returns
+ * once the line has been quiet for SIM_UART_IDLE_MS after some bytes. The
+ * task waits inside the call and keeps the CPU, as on the board.
+ *
+ * The modem raises RI along with unsolicited result codes. Here that is
+ * inferred: when bytes arrive while no receive is running, the RI EXTI
+ * fires once, and again only after those bytes have been read.
+ */
+
+// posix_openpt() and the rest of the pty calls
+#define _GNU_SOURCE
+
+#include "main.h"
+#include "sim.h"
+#include "stm32_config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/** @ingroup sim
+ *  @brief Quiet time that ends a receive-to-idle, several characters at 115200 baud */
+#define SIM_UART_IDLE_MS 3
+
+UART_HandleTypeDef huart1 = {.fd = -1};
+
+static int slave_fd = -1;
+static bool ri_pending; // RI fired for the bytes waiting now
+
+bool sim_modem_open(const char *link)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+    {
+        perror("sim: modem pty");
+        return false;
+    }
+    const char *name = ptsname(fd);
+    slave_fd = open(name, O_RDWR | O_NOCTTY);
+
+    // raw bytes both ways, no echo and no line editing
+    struct termios tio;
+    if (tcgetattr(slave_fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(slave_fd, TCSANOW, &tio);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    huart1.fd = fd;
+    huart1.gState = HAL_UART_STATE_READY;
+    huart1.RxState = HAL_UART_STATE_READY;
+
+    if (link)
+    {
+        unlink(link);
+        if (symlink(name, link) != 0)
+        {
+            perror("sim: modem link");
+        }
+    }
+    printf("sim: modem on %s%s%s\n", name, link ? ", linked as " : "", link ? link : "");
+
+    // the modem holds its TX line high once powered, which modem_init() waits for
+    UART1_RX_PORT->IDR |= UART1_RX_PIN;
+    return true;
+}
+
+// waits up to timeout_ms for input, false on timeout
+static bool uart_wait(int fd, uint32_t timeout_ms)
+{
+    uint32_t start = HAL_GetTick();
+    for (;;)
+    {
+        uint32_t elapsed = HAL_GetTick() - start;
+        if (timeout_ms != HAL_MAX_DELAY && elapsed >= timeout_ms)
+        {
+            return false;
+        }
+        int wait = timeout_ms == HAL_MAX_DELAY ? 1000 : (int)(timeout_ms - elapsed);
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        int ready = poll(&pfd, 1, wait);
+        if (ready > 0)
+        {
+            return true;
+        }
+        // the tick signal interrupts the wait, carry on with what is left
+        if (ready < 0 && errno != EINTR)
+        {
+            return false;
+        }
+    }
+}
+
+static int uart_read(int fd, uint8_t *data, uint16_t size)
+{
+    ssize_t got = read(fd, data, size);
+    return got > 0 ? (int)got : 0;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size, uint32_t timeout)
+{
+    (void)timeout;
+    if (huart->fd < 0)
+    {
+        return HAL_OK;
+    }
+    while (size > 0)
+    {
+        ssize_t sent = write(huart->fd, data, size);
+        if (sent < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+            {
+                continue;
+            }
+            return HAL_ERROR;
+        }
+        data += sent;
+        size -= (uint16_t)sent;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size, uint32_t timeout)
+{
+    if (huart->fd < 0)
+    {
+        HAL_Delay(timeout);
+        return HAL_TIMEOUT;
+    }
+    huart->RxState = HAL_UART_STATE_BUSY;
+    uint32_t start = HAL_GetTick();
+    uint16_t count = 0;
+    HAL_StatusTypeDef status = HAL_OK;
+    while (count < size)
+    {
+        uint32_t elapsed = HAL_GetTick() - start;
+        uint32_t left = timeout == HAL_MAX_DELAY ? HAL_MAX_DELAY : (elapsed < timeout ? timeout - elapsed : 0);
+        if (!uart_wait(huart->fd, left))
+        {
+            status = HAL_TIMEOUT;
+            break;
+        }
+        count += (uint16_t)uart_read(huart->fd, data + count, size - count);
+    }
+    huart->RxState = HAL_UART_STATE_READY;
+    return status;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size,
+                                           uint16_t *rx_len, uint32_t timeout)
+{
+    *rx_len = 0;
+    if (huart->fd < 0)
+    {
+        HAL_Delay(timeout);
+        return HAL_TIMEOUT;
+    }
+    huart->RxState = HAL_UART_STATE_BUSY;
+    HAL_StatusTypeDef status = HAL_OK;
+    uint16_t count = 0;
+    if (!uart_wait(huart->fd, timeout))
+    {
+        status = HAL_TIMEOUT;
+    }
+    else
+    {
+        while (count < size)
+        {
+            count += (uint16_t)uart_read(huart->fd, data + count, size - count);
+            if (count < size && !uart_wait(huart->fd, SIM_UART_IDLE_MS))
+            {
+                break;
+            }
+        }
+    }
+    *rx_len = count;
+    huart->RxState = HAL_UART_STATE_READY;
+    return status;
+}
+
+void sim_modem_poll(void)
+{
+    if (huart1.fd < 0 || huart1.RxState != HAL_UART_STATE_READY)
+    {
+        return;
+    }
+    struct pollfd pfd = {.fd = huart1.fd, .events = POLLIN};
+    bool waiting = poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN);
+    if (!waiting)
+    {
+        ri_pending = false;
+        return;
+    }
+    if (ri_pending || !(EXTI_D1->IMR1 & MODEM_RI_Pin))
+    {
+        return;
+    }
+    // a short low pulse on RI, seen by the EXTI as a falling edge
+    ri_pending = true;
+    EXTI_D1->PR1 |= MODEM_RI_Pin;
+    HAL_GPIO_EXTI_IRQHandler(MODEM_RI_Pin);
+}
@@ -0,0 +1,208 @@
+/**
+ * @file sim_sdcard.c
+ * @brief SD card of the host simulation, an image file under FatFs
+ * @ingroup sim
+ *
+ * Provides the SD_Driver that FATFS/App/fatfs.c links, so FatFs itself, the
+ * firmware's file code and the mount in sdcard_init() run unchanged. Sectors
+ * are read and written straight through to the image file.
+ *
+ * A missing image is created at the requested size, formatted and
+ * filled with a copy of a host directory, so fonts, the T9 dictionary and
+ * anything else the firmware expects on the card can be staged from the
+ * build tree. An existing image is used as it is, keeping what the last run
+ * wrote.
+ */
+
+#include "sim.h"
+
+// FatFs has a DIR type of its own
+#define DIR HOST_DIR
+#include <dirent.h>
+#undef DIR
+
+#include "fatfs.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SIM_SECTOR_SIZE 512
+
+static int image_fd = -1;
+static DWORD image_sectors;
+
+static DSTATUS sim_sd_initialize(BYTE lun)
+{
+    (void)lun;
+    return image_fd < 0 ? STA_NOINIT : 0;
+}
+
+static DSTATUS sim_sd_status(BYTE lun)
+{
+    (void)lun;
+    return image_fd < 0 ? STA_NOINIT : 0;
+}
+
+static DRESULT sim_sd_read(BYTE lun, BYTE *buff, DWORD sector, UINT count)
+{
+    (void)lun;
+    size_t len = (size_t)count * SIM_SECTOR_SIZE;
+    off_t offset = (off_t)sector * SIM_SECTOR_SIZE;
+    return pread(image_fd, buff, len, offset) == (ssize_t)len ? RES_OK : RES_ERROR;
+}
+
+static DRESULT sim_sd_write(BYTE lun, const BYTE *buff, DWORD sector, UINT count)
+{
+    (void)lun;
+    size_t len = (size_t)count * SIM_SECTOR_SIZE;
+    off_t offset = (off_t)sector * SIM_SECTOR_SIZE;
+    return pwrite(image_fd, buff, len, offset) == (ssize_t)len ? RES_OK : RES_ERROR;
+}
+
+static DRESULT sim_sd_ioctl(BYTE lun, BYTE cmd, void *buff)
+{
+    (void)lun;
+    switch (cmd)
+    {
+    case CTRL_SYNC:
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *(DWORD *)buff = image_sectors;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = SIM_SECTOR_SIZE;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        *(DWORD *)buff = 1;
+        return RES_OK;
+    default:
+        return RES_PARERR;
+    }
+}
+
+const Diskio_drvTypeDef SD_Driver = {
+    sim_sd_initialize,
+    sim_sd_status,
+    sim_sd_read,
+    sim_sd_write,
+    sim_sd_ioctl,
+};
+
+// copies a host file into the image, path is the name on the card
+static bool seed_file(const char *host, const char *path)
+{
+    FILE *in = fopen(host, "rb");
+    if (!in)
+    {
+        return false;
+    }
+    static FIL out;
+    bool ok = f_open(&out, path, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK;
+    static uint8_t buffer[4096];
+    size_t got;
+    while (ok && (got = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    {
+        UINT written;
+        ok = f_write(&out, buffer, (UINT)got, &written) == FR_OK && written == got;
+    }
+    fclose(in);
+    return f_close(&out) == FR_OK && ok;
+}
+
+static bool seed_dir(const char *host, const char *path)
+{
+    HOST_DIR *dir = opendir(host);
+    if (!dir)
+    {
+        perror("sim: sd seed");
+        return false;
+    }
+    bool ok = true;
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        char host_child[512], child[512];
+        snprintf(host_child, sizeof(host_child), "%s/%s", host, entry->d_name);
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        struct stat st;
+        if (stat(host_child, &st) != 0)
+        {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode))
+        {
+            ok = f_mkdir(child) == FR_OK && seed_dir(host_child, child);
+        }
+        else if (S_ISREG(st.st_mode))
+        {
+            ok = seed_file(host_child, child);
+        }
+        if (!ok)
+        {
+            printf("sim: could not copy %s to the SD image\n", host_child);
+        }
+    }
+    closedir(dir);
+    return ok;
+}
+
+// formats the new image and fills it, through a drive of its own
+static bool image_format(const char *seed)
+{
+    char path[4];
+    if (FATFS_LinkDriver(&SD_Driver, path) != 0)
+    {
+        return false;
+    }
+    static uint8_t work[_MAX_SS];
+    static FATFS fs;
+    bool ok = f_mkfs(path, FM_ANY, 0, work, sizeof(work)) == FR_OK;
+    if (ok && seed)
+    {
+        // the only drive, so names from the root need no drive prefix
+        ok = f_mount(&fs, path, 1) == FR_OK && seed_dir(seed, "");
+        f_mount(NULL, path, 0);
+    }
+    FATFS_UnLinkDriver(path);
+    return ok;
+}
+
+bool sim_sdcard_open(const char *path, const char *seed, uint32_t size_mb)
+{
+    bool created = access(path, F_OK) != 0;
+    image_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (image_fd < 0)
+    {
+        perror("sim: sd image");
+        return false;
+    }
+    if (created && ftruncate(image_fd, (off_t)size_mb * 1024 * 1024) != 0)
+    {
+        perror("sim: sd image");
+        return false;
+    }
+    struct stat st;
+    fstat(image_fd, &st);
+    image_sectors = (DWORD)(st.st_size / SIM_SECTOR_SIZE);
+
+    if (created)
+    {
+        printf("sim: formatting %s (%u MB)\n", path, (unsigned)size_mb);
+        if (!image_format(seed))
+        {
+            printf("sim: could not format %s\n", path);
+            close(image_fd);
+            image_fd = -1;
+            unlink(path);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS headers heap_4.c needs
+ * @ingroup tests
+ *
+ * Lets host tests compile the unmodified heap_4.c from the FreeRTOS tree to
+ * compare against it. Only the configuration, types and hooks heap_4 uses
+ * are defined; the heap size is set by the test before the include.
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE ((size_t)15360)
+#endif
+
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configAPPLICATION_ALLOCATED_HEAP 0
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define configASSERT(x) assert(x)
+
+#define portBYTE_ALIGNMENT 8
+#define portBYTE_ALIGNMENT_MASK 0x0007
+#define portMAX_DELAY ((size_t)-1)
+#define PRIVILEGED_FUNCTION
+
+#define mtCOVERAGE_TEST_MARKER()
+#define traceMALLOC(p, size)
+#define traceFREE(p, size)
+
+typedef long BaseType_t;
+
+typedef struct xHeapStats
+{
+    size_t xAvailableHeapSpaceInBytes;
+    size_t xSizeOfLargestFreeBlockInBytes;
+    size_t xSizeOfSmallestFreeBlockInBytes;
+    size_t xNumberOfFreeBlocks;
+    size_t xMinimumEverFreeBytesRemaining;
+    size_t xNumberOfSuccessfulAllocations;
+    size_t xNumberOfSuccessfulFrees;
+} HeapStats_t;
+
+void *pvPortMalloc(size_t xSize);
+void vPortFree(void *pv);
+void vPortInitialiseBlocks(void);
+size_t xPortGetFreeHeapSize(void);
+size_t xPortGetMinimumEverFreeHeapSize(void);
+void vPortGetHeapStats(HeapStats_t *pxHeapStats);
+
+#endif
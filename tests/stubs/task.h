@@ -0,0 +1,20 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for the scheduler calls heap_4.c makes
+ * @ingroup tests
+ *
+ * Host tests drive the heap from a single thread, so suspending the
+ * scheduler and critical sections do nothing.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+static inline void vTaskSuspendAll(void) {}
+static inline BaseType_t xTaskResumeAll(void) { return 0; }
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * @file test_boot_timeline.c
+ * @brief Boot timeline host test
+ * @ingroup tests
+ *
+ * Plays a boot through the timeline the way main() and the tasks do, with
+ * phases overlapping and finishing out of order, one failing and one left
+ * out of the build. Checks the phase states and times, that the boot only
+ * counts as finished once every phase has, and the report: its line count
+ * and width, the bars placed on the time axis, and the first frame held
+ * against the target. Prints the report of the simulated boot.
+ *
+ * Build and run:
+ *   gcc -O2 -I./include/kernel -o test_boot_timeline tests/test_boot_timeline.c kernel/core/boot_timeline.c
+ *   ./test_boot_timeline
+ */
+
+#include "boot_timeline.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_LINES 32
+
+typedef struct
+{
+    char lines[MAX_LINES][BOOT_REPORT_LINE_MAX];
+    int count;
+} Report;
+
+static void collect(const char *line, void *arg)
+{
+    Report *report = (Report *)arg;
+    if (report->count < MAX_LINES)
+    {
+        snprintf(report->lines[report->count], BOOT_REPORT_LINE_MAX, "%s", line);
+    }
+    report->count++;
+}
+
+// the report line of a phase: one header line, then the phases in order
+static const char *phase_line(const Report *report, BootPhase phase)
+{
+    return report->lines[1 + phase];
+}
+
+static const char *bar_of(const char *line)
+{
+    const char *bar = strchr(line, '|');
+    return bar ? bar + 1 : "";
+}
+
+static void test_phases(void)
+{
+    printf("Phases\n");
+    boot_timeline_reset();
+
+    BootPhaseInfo info;
+    CHECK(boot_phase_get(BOOT_PHASE_MODEM, &info) && info.state == BOOT_PENDING);
+    CHECK(!boot_phase_get(BOOT_PHASE_COUNT, &info));
+    CHECK(!boot_finished());
+
+    boot_phase_begin(BOOT_PHASE_CLOCKS, 0);
+    boot_phase_end(BOOT_PHASE_CLOCKS, true, 4);
+    CHECK(boot_phase_get(BOOT_PHASE_CLOCKS, &info));
+    CHECK(info.state == BOOT_DONE && info.start_ms == 0 && info.end_ms == 4);
+
+    // ended without a begin: starts and ends at once
+    boot_phase_end(BOOT_PHASE_LEDS, false, 250);
+    CHECK(boot_phase_get(BOOT_PHASE_LEDS, &info));
+    CHECK(info.state == BOOT_FAILED && info.start_ms == 250 && info.end_ms == 250);
+
+    boot_phase_begin(BOOT_PHASE_MODEM, 30);
+    CHECK(boot_phase_get(BOOT_PHASE_MODEM, &info) && info.state == BOOT_RUNNING && info.start_ms == 30);
+
+    boot_phase_skip(BOOT_PHASE_FUEL_GAUGE);
+    CHECK(boot_phase_get(BOOT_PHASE_FUEL_GAUGE, &info) && info.state == BOOT_SKIPPED);
+
+    // out of range phases are ignored
+    boot_phase_begin(BOOT_PHASE_COUNT, 1);
+    boot_phase_end((BootPhase)-1, true, 1);
+    boot_phase_skip(BOOT_PHASE_COUNT);
+
+    CHECK(strcmp(boot_phase_name(BOOT_PHASE_FIRST_FRAME), "first frame") == 0);
+    CHECK(strcmp(boot_phase_name(BOOT_PHASE_COUNT), "?") == 0);
+}
+
+// the boot main() and the tasks would record, the modem still running
+static void simulated_boot(void)
+{
+    boot_timeline_reset();
+    boot_phase_begin(BOOT_PHASE_CLOCKS, 0);
+    boot_phase_end(BOOT_PHASE_CLOCKS, true, 3);
+    boot_phase_begin(BOOT_PHASE_PERIPHERALS, 3);
+    boot_phase_end(BOOT_PHASE_PERIPHERALS, true, 5);
+    boot_phase_begin(BOOT_PHASE_KERNEL, 5);
+    boot_phase_end(BOOT_PHASE_KERNEL, true, 6);
+
+    boot_phase_begin(BOOT_PHASE_CODEC, 6);
+    boot_phase_begin(BOOT_PHASE_HAPTICS, 6);
+    boot_phase_end(BOOT_PHASE_HAPTICS, true, 6);
+    boot_phase_begin(BOOT_PHASE_DISPLAY, 7);
+    boot_phase_begin(BOOT_PHASE_MODEM, 7);
+    boot_phase_begin(BOOT_PHASE_KEYPAD, 7);
+    boot_phase_end(BOOT_PHASE_KEYPAD, true, 8);
+    boot_phase_begin(BOOT_PHASE_LEDS, 8);
+    boot_phase_begin(BOOT_PHASE_FUEL_GAUGE, 8);
+    boot_phase_end(BOOT_PHASE_FUEL_GAUGE, true, 9);
+    boot_phase_end(BOOT_PHASE_DISPLAY, true, 135);
+    boot_phase_begin(BOOT_PHASE_FIRST_FRAME, 135);
+    boot_phase_end(BOOT_PHASE_FIRST_FRAME, true, 152);
+    boot_phase_end(BOOT_PHASE_LEDS, true, 110);
+    boot_phase_begin(BOOT_PHASE_SD_CARD, 110);
+    boot_phase_end(BOOT_PHASE_SD_CARD, false, 160);
+    boot_phase_end(BOOT_PHASE_CODEC, true, 310);
+}
+
+static void test_report(void)
+{
+    printf("Report\n");
+    simulated_boot();
+    CHECK(!boot_finished());
+
+    Report report = {0};
+    int lines = boot_timeline_report(collect, &report, 1000);
+    CHECK(lines == report.count && lines == BOOT_PHASE_COUNT + 3);
+    for (int i = 0; i < report.count && i < MAX_LINES; i++)
+    {
+        CHECK(strlen(report.lines[i]) <= 40);
+    }
+
+    // the axis runs to now while the modem is running
+    CHECK(strstr(report.lines[0], "0-1000ms") != NULL);
+    CHECK(strstr(phase_line(&report, BOOT_PHASE_MODEM), " run ") != NULL);
+    CHECK(strstr(phase_line(&report, BOOT_PHASE_SD_CARD), "fail") != NULL);
+    CHECK(strstr(phase_line(&report, BOOT_PHASE_DISPLAY), " 128 ") != NULL);
+
+    // the modem bar spans the axis, the clocks get the first cell only
+    const char *modem = bar_of(phase_line(&report, BOOT_PHASE_MODEM));
+    CHECK(strncmp(modem, "==============|", BOOT_REPORT_BAR_WIDTH + 1) == 0);
+    const char *clocks = bar_of(phase_line(&report, BOOT_PHASE_CLOCKS));
+    CHECK(strncmp(clocks, "#             |", BOOT_REPORT_BAR_WIDTH + 1) == 0);
+    const char *sd = bar_of(phase_line(&report, BOOT_PHASE_SD_CARD));
+    CHECK(strchr(sd, '!') != NULL && strchr(sd, '#') == NULL);
+
+    CHECK(strcmp(report.lines[BOOT_PHASE_COUNT + 1], "first frame 152 ms, target 300 met") == 0);
+    CHECK(strcmp(report.lines[BOOT_PHASE_COUNT + 2], "boot running, 1000 ms") == 0);
+
+    // once the modem is up the boot is over and the axis ends with it
+    boot_phase_end(BOOT_PHASE_MODEM, true, 8400);
+    CHECK(boot_finished());
+    memset(&report, 0, sizeof(report));
+    boot_timeline_report(collect, &report, 20000);
+    CHECK(strstr(report.lines[0], "0-8400ms") != NULL);
+    CHECK(strcmp(report.lines[BOOT_PHASE_COUNT + 2], "boot took 8400 ms") == 0);
+    for (int i = 0; i < report.count && i < MAX_LINES; i++)
+    {
+        printf("  %s\n", report.lines[i]);
+    }
+
+    // a late first frame misses the target, a skipped phase does not hold the boot up
+    boot_phase_end(BOOT_PHASE_FIRST_FRAME, true, 420);
+    boot_phase_skip(BOOT_PHASE_LEDS);
+    CHECK(boot_finished());
+    memset(&report, 0, sizeof(report));
+    boot_timeline_report(collect, &report, 20000);
+    CHECK(strcmp(report.lines[BOOT_PHASE_COUNT + 1], "first frame 420 ms, target 300 missed") == 0);
+    CHECK(strstr(phase_line(&report, BOOT_PHASE_LEDS), "skip |              |") != NULL);
+}
+
+int main(void)
+{
+    test_phases();
+    test_report();
+
+    return check_summary();
+}
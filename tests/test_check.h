@@ -0,0 +1,35 @@
+/**
+ * @file test_check.h
+ * @brief Shared checks for the host tests
+ * @ingroup tests
+ *
+ * Each host test is a single file built straight from gcc, so this header
+ * carries its own failure counter. CHECK() reports a failed condition with
+ * its location and carries on, so one run lists every failure, and
+ * check_summary() prints the verdict and gives main() its exit status.
+ */
+
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+
+static int failures;
+
+#define CHECK(cond)                                                   \
+    do                                                                \
+    {                                                                 \
+        if (!(cond))                                                  \
+        {                                                             \
+            printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                               \
+        }                                                             \
+    } while (0)
+
+static inline int check_summary(void)
+{
+    printf(failures ? "FAILED (%d failures)\n" : "PASSED\n", failures);
+    return failures ? 1 : 0;
+}
+
+#endif /* TEST_CHECK_H */
@@ -0,0 +1,248 @@
+/**
+ * @file test_contact_search.c
+ * @brief Incremental contact search host test and benchmark
+ * @ingroup tests
+ *
+ * Builds a 5,000 contact B+ tree, checks the incremental search against a
+ * brute-force prefix match for every keystroke and backspace, and pages
+ * through every contact down and back up again checking each row and the
+ * leaf reads per row. Then types the start of many names and reports time
+ * and node reads per keystroke against restarting the prefix search from
+ * the root on every key.
+ *
+ * Build and run:
+ *   gcc -O2 -I./include/kernel/data_structures -I./include/kernel -o test_contact_search \
+ *       tests/test_contact_search.c kernel/data_structures/contacts_search.c kernel/data_structures/contacts_bptree.c
+ *   ./test_contact_search [contacts]
+ */
+
+#include "contacts_search.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_CONTACTS 5000
+#define TYPED_CHARS 6
+#define ROWS_SHOWN 8
+// reads per row scrolling back up through 5,000 rows, the checkpoints are 128 rows apart by then
+#define MAX_READS_PER_ROW_UP 3
+
+static const char *first_names[] = {
+    "Alice", "Alex", "Alan", "Amelia", "Bob", "Bella", "Ben", "Charlie", "Chloe", "Chris",
+    "Diana", "David", "Dan", "Ethan", "Emma", "Eli", "Fiona", "Finn", "George", "Grace",
+    "Hannah", "Harry", "Ian", "Isla", "Jack", "James", "Jane", "Kara", "Kate", "Liam",
+    "Lily", "Mia", "Max", "Noah", "Nina", "Olivia", "Oscar", "Paul", "Pauline", "Quinn",
+    "Ruby", "Ryan", "Sam", "Sophie", "Ty", "Tom", "Uma", "Victor", "Will", "Zoe"};
+
+static const char *last_names[] = {
+    "Smith", "Jones", "Brown", "Wood", "Jin", "Pounds", "Behnke", "Prince", "Hunt", "Martin",
+    "Baker", "Fleming", "Sparrow", "Thrace", "Neeson", "Taylor", "White", "Harris", "Clark", "Lewis",
+    "Walker", "Hall", "Young", "King", "Wright", "Scott", "Green", "Adams", "Nelson", "Carter"};
+
+static char (*keys)[MAX_KEY_LEN];
+static int key_count;
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int compare_keys(const void *a, const void *b)
+{
+    return strncmp((const char *)a, (const char *)b, MAX_KEY_LEN);
+}
+
+// index of the first key with the prefix, and the number of such keys
+static int brute_force(const char *prefix, int *first)
+{
+    size_t len = strlen(prefix);
+    int count = 0;
+    *first = -1;
+    for (int i = 0; i < key_count; i++)
+    {
+        if (strncmp(keys[i], prefix, len) == 0)
+        {
+            if (*first < 0)
+                *first = i;
+            count++;
+        }
+    }
+    return count;
+}
+
+static void check_query(ContactSearch *search)
+{
+    int first;
+    int expected = brute_force(search->prefix, &first);
+
+    int found = contact_search_discover(search, expected + 1);
+    CHECK(found == expected);
+    CHECK(search->complete);
+    CHECK(contact_search_count(search) == expected);
+    for (int i = 0; i < found && i < expected; i++)
+    {
+        ContactRecord contact;
+        CHECK(contact_search_get(search, i, &contact));
+        CHECK(strncmp(contact.name, keys[first + i], MAX_KEY_LEN - 1) == 0);
+    }
+}
+
+static void test_correctness(BPTree *tree)
+{
+    static ContactSearch search;
+    const char *queries[] = {"Alice Smith", "Al", "Pauline Pounds", "Ty Beh", "Zoe Young", "Zz", "Q", "Mia Xavier"};
+
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++)
+    {
+        contact_search_init(&search, tree);
+        check_query(&search);
+        for (int i = 0; queries[q][i] && i < MAX_KEY_LEN - 1; i++)
+        {
+            contact_search_push(&search, queries[q][i]);
+            check_query(&search);
+        }
+        while (contact_search_pop(&search))
+            check_query(&search);
+        CHECK(search.len == 0);
+    }
+
+    // backspace must not touch the file
+    contact_search_init(&search, tree);
+    contact_search_push(&search, 'J');
+    contact_search_push(&search, 'a');
+    uint32_t reads = search.reads;
+    contact_search_pop(&search);
+    CHECK(search.reads == reads);
+}
+
+// every contact matches the empty prefix, far more than fit in the page or the checkpoints
+static void test_paging(BPTree *tree)
+{
+    static ContactSearch search;
+    ContactRecord contact;
+    int wrong = 0;
+
+    contact_search_init(&search, tree);
+    uint32_t reads = search.reads;
+    for (int i = 0; i < key_count; i++)
+    {
+        CHECK(contact_search_count(&search) > i);
+        if (!contact_search_get(&search, i, &contact) || strncmp(contact.name, keys[i], MAX_KEY_LEN - 1) != 0)
+            wrong++;
+    }
+    uint32_t down = search.reads - reads;
+    CHECK(!contact_search_get(&search, key_count, &contact));
+    CHECK(search.complete && contact_search_count(&search) == key_count);
+
+    reads = search.reads;
+    for (int i = key_count - 1; i >= 0; i--)
+    {
+        if (!contact_search_get(&search, i, &contact) || strncmp(contact.name, keys[i], MAX_KEY_LEN - 1) != 0)
+            wrong++;
+    }
+    uint32_t up = search.reads - reads;
+    CHECK(wrong == 0);
+    CHECK(up <= (uint32_t)key_count * MAX_READS_PER_ROW_UP);
+
+    // a jump lands on the right row and the rows either side of it
+    for (int i = 2500; i < 2503; i++)
+        CHECK(contact_search_get(&search, i, &contact) && strncmp(contact.name, keys[i], MAX_KEY_LEN - 1) == 0);
+    CHECK(contact_search_get(&search, 2499, &contact) && strncmp(contact.name, keys[2499], MAX_KEY_LEN - 1) == 0);
+    CHECK(search.mark_count <= CONTACT_SEARCH_MARKS);
+
+    printf("paging %d rows: %.2f reads/row down, %.2f reads/row up, checkpoints every %lu rows\n", key_count,
+           (double)down / key_count, (double)up / key_count, (unsigned long)search.mark_stride);
+}
+
+static void benchmark(BPTree *tree, int names)
+{
+    static ContactSearch search;
+    unsigned long keystrokes = 0, total_reads = 0;
+    uint32_t worst_reads = 0;
+    double worst_us = 0;
+    double start = now_us();
+
+    for (int n = 0; n < names; n++)
+    {
+        const char *name = keys[(n * 7919) % key_count];
+        contact_search_init(&search, tree);
+        for (int i = 0; name[i] && i < TYPED_CHARS; i++)
+        {
+            uint32_t before = search.reads;
+            double t = now_us();
+            contact_search_push(&search, name[i]);
+            contact_search_discover(&search, ROWS_SHOWN);
+            double dt = now_us() - t;
+            keystrokes++;
+            total_reads += search.reads - before;
+            if (search.reads - before > worst_reads)
+                worst_reads = search.reads - before;
+            if (dt > worst_us)
+                worst_us = dt;
+        }
+    }
+    double incremental = now_us() - start;
+
+    // baseline: descend from the root and rescan on every keystroke
+    start = now_us();
+    for (int n = 0; n < names; n++)
+    {
+        const char *name = keys[(n * 7919) % key_count];
+        for (int i = 0; name[i] && i < TYPED_CHARS; i++)
+        {
+            PrefixSearchState state = {0};
+            char out_names[CONTACTS_VISIBLE_COUNT][MAX_NAME_LEN];
+            uint32_t out_offsets[CONTACTS_VISIBLE_COUNT];
+            strncpy(state.prefix, name, i + 1);
+            state.leaf_offset = bptree_find_leaf(tree, state.prefix);
+            bptree_search_prefix_page(tree, &state, out_names, out_offsets);
+        }
+    }
+    double restart = now_us() - start;
+
+    printf("%d contacts, %lu keystrokes\n", key_count, keystrokes);
+    printf("incremental: %.2f us/key (worst %.2f us), %.2f reads/key (worst %u)\n",
+           incremental / keystrokes, worst_us, (double)total_reads / keystrokes, worst_reads);
+    printf("restart:     %.2f us/key\n", restart / keystrokes);
+}
+
+int main(int argc, char *argv[])
+{
+    int contacts = argc > 1 ? atoi(argv[1]) : DEFAULT_CONTACTS;
+    const char *tree_path = "/tmp/test_contact_search.dat";
+    const char *data_path = "/tmp/test_contact_search_data.dat";
+    remove(tree_path);
+    remove(data_path);
+
+    BPTree tree = bptree_create(tree_path, data_path);
+    keys = calloc(contacts, MAX_KEY_LEN);
+    srand(1);
+    for (int i = 0; i < contacts; i++)
+    {
+        ContactRecord contact = {0};
+        snprintf(contact.name, sizeof(contact.name), "%s %s",
+                 first_names[rand() % (sizeof(first_names) / sizeof(first_names[0]))],
+                 last_names[rand() % (sizeof(last_names) / sizeof(last_names[0]))]);
+        contact.name_len = strlen(contact.name);
+        snprintf(contact.phone, sizeof(contact.phone), "04%08d", i);
+        contact.phone_len = strlen(contact.phone);
+        bptree_insert(&tree, contact);
+        strncpy(keys[key_count++], contact.name, MAX_KEY_LEN - 1);
+    }
+    qsort(keys, key_count, MAX_KEY_LEN, compare_keys);
+
+    test_correctness(&tree);
+    test_paging(&tree);
+    benchmark(&tree, 1000);
+
+    bptree_close(&tree);
+    free(keys);
+    remove(tree_path);
+    remove(data_path);
+
+    return check_summary();
+}
@@ -0,0 +1,401 @@
+/**
+ * @file test_event_bus.c
+ * @brief Event bus host test and wakeup measurement
+ * @ingroup tests
+ *
+ * Checks topic masks, publish-time filters, ring overflow accounting,
+ * wake-on-empty, sinks and msg_pool payload references across several
+ * subscribers.
+ *
+ * Then replays a scripted phone session through the real key event
+ * generator and input queue: menu navigation, a held D-pad, dialling a
+ * number, volume presses, an incoming call, an SMS and periodic battery and
+ * signal updates. Events go through subscriptions that mirror the ones in
+ * display_task.c and audio_task.c, and the wakeups are compared with what
+ * the old point-to-point wiring did for the same events (every non-volume
+ * key event woke the display, every call state but idle was posted to it).
+ *
+ * Build and run:
+ *   gcc -O2 -pthread -I./include/kernel -I./include/ui -o test_event_bus tests/test_event_bus.c \
+ *       kernel/core/event_bus.c kernel/core/msg_pool.c ui/input_pipeline.c
+ *   ./test_event_bus
+ */
+
+#include "event_bus.h"
+#include "input_pipeline.h"
+#include "msg_pool.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <string.h>
+
+// mirrors CallState in call_state.h, which needs FreeRTOS headers
+enum
+{
+    CALL_IDLE,
+    CALL_RINGING,
+    CALL_DIALLING,
+    CALL_ACTIVE,
+    CALL_ENDING
+};
+
+#define SCAN_MS 5        // input task period
+#define SESSION_MS 60000 // one scripted minute
+#define SESSIONS 10
+
+static unsigned wakes[4];
+
+static void count_wake(void *arg)
+{
+    wakes[(int)(intptr_t)arg]++;
+}
+
+static bool odd_only(const Event *event, void *arg)
+{
+    return event->value & 1;
+}
+
+static unsigned sunk;
+static bool counting_sink(const Event *event, void *arg)
+{
+    sunk++;
+    return true;
+}
+
+static void test_basics(void)
+{
+    printf("Topics, filters, rings and sinks\n");
+    msg_pool_init();
+    event_bus_init();
+    memset(wakes, 0, sizeof(wakes));
+
+    EventSubscription a = {.name = "a",
+                           .topics = EVENT_TOPIC_BIT(EVENT_TOPIC_BATTERY) | EVENT_TOPIC_BIT(EVENT_TOPIC_SMS_RECEIVED),
+                           .wake = count_wake,
+                           .arg = (void *)0};
+    EventSubscription b = {.name = "b",
+                           .topics = EVENT_TOPIC_BIT(EVENT_TOPIC_BATTERY) | EVENT_TOPIC_BIT(EVENT_TOPIC_SMS_RECEIVED),
+                           .filter = odd_only,
+                           .wake = count_wake,
+                           .arg = (void *)1};
+    EventSubscription c = {.name = "c", .topics = EVENT_TOPIC_BIT(EVENT_TOPIC_KEY), .sink = counting_sink,
+                           .wake = count_wake, .arg = (void *)2};
+    EventSubscriber *sa = event_bus_subscribe(&a);
+    EventSubscriber *sb = event_bus_subscribe(&b);
+    EventSubscriber *sc = event_bus_subscribe(&c);
+    CHECK(sa && sb && sc);
+
+    // b only sees odd values, c never sees battery
+    CHECK(event_bus_publish(EVENT_TOPIC_BATTERY, 40, NULL) == 1);
+    CHECK(event_bus_publish(EVENT_TOPIC_BATTERY, 41, NULL) == 2);
+    CHECK(event_bus_publish(EVENT_TOPIC_SIGNAL, 3, NULL) == 0);
+
+    EventTopicStats ts;
+    event_bus_get_topic_stats(EVENT_TOPIC_BATTERY, &ts);
+    CHECK(ts.published == 2 && ts.delivered == 3 && ts.filtered == 1 && ts.dropped == 0);
+    // a was woken once for two queued events
+    CHECK(wakes[0] == 1 && wakes[1] == 1);
+    CHECK(ts.wakeups == 2);
+
+    Event ev;
+    CHECK(event_bus_pending(sa));
+    CHECK(event_bus_receive(sa, &ev) && ev.topic == EVENT_TOPIC_BATTERY && ev.value == 40);
+    CHECK(event_bus_receive(sa, &ev) && ev.value == 41);
+    CHECK(!event_bus_receive(sa, &ev));
+    CHECK(event_bus_receive(sb, &ev) && ev.value == 41);
+    CHECK(!event_bus_pending(sb));
+
+    // an empty ring wakes again
+    event_bus_publish(EVENT_TOPIC_BATTERY, 42, NULL);
+    CHECK(wakes[0] == 2);
+    event_bus_receive(sa, &ev);
+
+    printf("Overflow\n");
+    for (int i = 0; i < EVENT_BUS_QUEUE_DEPTH + 3; i++)
+        event_bus_publish(EVENT_TOPIC_BATTERY, 100 + 2 * i, NULL);
+    EventSubscriberStats ss;
+    event_bus_get_subscriber_stats(sa, &ss);
+    CHECK(ss.dropped == 3 && ss.high_water == EVENT_BUS_QUEUE_DEPTH);
+    CHECK(strcmp(ss.name, "a") == 0);
+    event_bus_get_topic_stats(EVENT_TOPIC_BATTERY, &ts);
+    CHECK(ts.dropped == 3);
+    // oldest events are kept
+    CHECK(event_bus_receive(sa, &ev) && ev.value == 100);
+    while (event_bus_receive(sa, &ev))
+        ;
+
+    printf("Sinks\n");
+    event_bus_publish(EVENT_TOPIC_KEY, event_key_pack(INPUT_DPAD_DOWN, KEY_ACTION_PRESS, 3), NULL);
+    event_bus_publish(EVENT_TOPIC_KEY, event_key_pack(INPUT_SELECT, KEY_ACTION_RELEASE, 1), NULL);
+    CHECK(sunk == 2 && wakes[2] == 2); // a sink wakes on every delivery
+    uint32_t packed = event_key_pack(INPUT_DPAD_DOWN, KEY_ACTION_LONG_PRESS, 7);
+    CHECK(EVENT_KEY(packed) == INPUT_DPAD_DOWN && EVENT_KEY_ACTION(packed) == KEY_ACTION_LONG_PRESS &&
+          EVENT_KEY_COUNT(packed) == 7);
+
+    printf("Payload references\n");
+    MsgPoolStats ps;
+    char *sms = msg_alloc(MSG_TYPE_SMS, 16);
+    strcpy(sms, "hello");
+    CHECK(event_bus_publish(EVENT_TOPIC_SMS_RECEIVED, 1, sms) == 2);
+    msg_pool_get_stats(&ps);
+    CHECK(ps.in_use == 1);
+    Event ea, eb;
+    CHECK(event_bus_receive(sa, &ea) && ea.data == sms);
+    CHECK(event_bus_receive(sb, &eb) && eb.data == sms);
+    event_bus_release(&ea);
+    CHECK(ea.data == NULL);
+    CHECK(strcmp(sms, "hello") == 0 && msg_type(sms) == MSG_TYPE_SMS); // b still holds it
+    event_bus_release(&eb);
+    msg_pool_get_stats(&ps);
+    CHECK(ps.in_use == 0);
+
+    // filtered everywhere, or dropped by a full ring: the payload still comes back
+    CHECK(event_bus_publish(EVENT_TOPIC_SMS_RECEIVED, 2, msg_alloc(MSG_TYPE_SMS, 16)) == 1);
+    for (int i = 0; i < EVENT_BUS_QUEUE_DEPTH; i++)
+        event_bus_publish(EVENT_TOPIC_SMS_RECEIVED, 4, msg_alloc(MSG_TYPE_SMS, 16));
+    while (event_bus_receive(sa, &ev))
+        event_bus_release(&ev);
+    msg_pool_get_stats(&ps);
+    CHECK(ps.in_use == 0 && ps.bad_releases == 0);
+    CHECK(event_bus_publish(EVENT_TOPIC_COUNT, 0, msg_alloc(MSG_TYPE_SMS, 16)) == 0);
+    msg_pool_get_stats(&ps);
+    CHECK(ps.in_use == 0);
+
+    printf("Subscriber table\n");
+    event_bus_init();
+    int added = 0;
+    while (event_bus_subscribe(&a))
+        added++;
+    CHECK(added == EVENT_BUS_MAX_SUBSCRIBERS);
+}
+
+/* ===== WAKEUP MEASUREMENT ===== */
+
+enum
+{
+    WAKE_DISPLAY,
+    WAKE_AUDIO,
+};
+
+// same decisions as display_event_filter() in display_task.c
+static bool display_event_filter(const Event *event, void *arg)
+{
+    if (event->topic == EVENT_TOPIC_CALL_STATE)
+        return event->value == CALL_RINGING;
+    return true;
+}
+
+// same decisions as display_key_filter() in display_task.c
+static bool display_key_filter(const Event *event, void *arg)
+{
+    uint8_t key = EVENT_KEY(event->value);
+    if (key == INPUT_VOLUME_UP || key == INPUT_VOLUME_DOWN)
+        return false;
+    return !(EVENT_KEY_ACTION(event->value) == KEY_ACTION_RELEASE &&
+             (INPUT_DEFAULT_COALESCE_MASK & INPUT_KEY_BIT(key)));
+}
+
+static bool display_key_sink(const Event *event, void *arg)
+{
+    KeyEvent key = {.key = EVENT_KEY(event->value),
+                    .action = EVENT_KEY_ACTION(event->value),
+                    .count = EVENT_KEY_COUNT(event->value)};
+    return input_queue_push(&key);
+}
+
+// same decisions as key_click_filter() in audio_task.c
+static bool key_click_filter(const Event *event, void *arg)
+{
+    uint8_t key = EVENT_KEY(event->value);
+    return EVENT_KEY_ACTION(event->value) == KEY_ACTION_PRESS && key != INPUT_VOLUME_UP &&
+           key != INPUT_VOLUME_DOWN;
+}
+
+static bool key_click_sink(const Event *event, void *arg)
+{
+    wakes[WAKE_AUDIO]++; // posting to the audio queue wakes the task
+    return true;
+}
+
+typedef struct
+{
+    uint32_t at_ms;
+    uint32_t hold_ms;
+    uint8_t key;
+} Press;
+
+static Press script[64];
+static int script_len;
+
+static void press(uint32_t at_ms, uint8_t key, uint32_t hold_ms)
+{
+    script[script_len++] = (Press){at_ms, hold_ms, key};
+}
+
+// a minute of use: taps, a held D-pad, dialling, volume, back, a long press
+static void build_script(void)
+{
+    script_len = 0;
+    for (int i = 0; i < 5; i++)
+        press(1000 + i * 300, INPUT_DPAD_DOWN, 100);
+    press(3000, INPUT_DPAD_DOWN, 1500);
+    press(6000, INPUT_SELECT, 100);
+    for (int i = 0; i < 11; i++)
+        press(7000 + i * 370, INPUT_KEYPAD_0 + (i * 7) % 10, 120);
+    for (int i = 0; i < 3; i++)
+        press(12000 + i * 300, INPUT_VOLUME_UP, 100);
+    press(14000, INPUT_RIGHT, 100);
+    press(14400, INPUT_RIGHT, 100);
+    press(16000, INPUT_SELECT, 1000);
+    for (int i = 0; i < 10; i++)
+        press(50000 + i * 300, i % 2 ? INPUT_DPAD_UP : INPUT_DPAD_LEFT, 100);
+}
+
+static uint32_t held_at(uint32_t t)
+{
+    uint32_t held = 0;
+    for (int i = 0; i < script_len; i++)
+        if (t >= script[i].at_ms && t < script[i].at_ms + script[i].hold_ms)
+            held |= 1UL << script[i].key;
+    return held;
+}
+
+static void measure_wakeups(void)
+{
+    printf("Wakeups over %d scripted minutes\n", SESSIONS);
+    msg_pool_init();
+    event_bus_init();
+    input_queue_init(INPUT_DEFAULT_COALESCE_MASK);
+    memset(wakes, 0, sizeof(wakes));
+
+    EventSubscription display = {
+        .name = "display",
+        .topics = EVENT_TOPIC_BIT(EVENT_TOPIC_BATTERY) | EVENT_TOPIC_BIT(EVENT_TOPIC_SIGNAL) |
+                  EVENT_TOPIC_BIT(EVENT_TOPIC_SMS_RECEIVED) | EVENT_TOPIC_BIT(EVENT_TOPIC_CALL_STATE),
+        .filter = display_event_filter,
+        .wake = count_wake,
+        .arg = (void *)WAKE_DISPLAY};
+    EventSubscription keys = {.name = "display-keys",
+                              .topics = EVENT_TOPIC_BIT(EVENT_TOPIC_KEY),
+                              .filter = display_key_filter,
+                              .sink = display_key_sink,
+                              .wake = count_wake,
+                              .arg = (void *)WAKE_DISPLAY};
+    EventSubscription clicks = {.name = "audio-clicks",
+                                .topics = EVENT_TOPIC_BIT(EVENT_TOPIC_KEY),
+                                .filter = key_click_filter,
+                                .sink = key_click_sink};
+    EventSubscriber *display_sub = event_bus_subscribe(&display);
+    event_bus_subscribe(&keys);
+    event_bus_subscribe(&clicks);
+
+    static KeyEventGen gen;
+    input_event_t keymap[INPUT_MAX_KEYS];
+    for (int i = 0; i < INPUT_MAX_KEYS; i++)
+        keymap[i] = (input_event_t)i;
+    key_events_init(&gen, NULL, keymap, INPUT_MAX_KEYS);
+    build_script();
+
+    unsigned old_display = 0, old_audio = 0, volume_posts = 0;
+    unsigned key_events = 0, other_events = 0;
+    KeyEvent out[INPUT_MAX_KEYS * 2];
+
+    for (int session = 0; session < SESSIONS; session++)
+    {
+        uint32_t base = session * SESSION_MS;
+        for (uint32_t t = 0; t < SESSION_MS; t += SCAN_MS)
+        {
+            int n = key_events_update(&gen, held_at(t), base + t, out, sizeof(out) / sizeof(out[0]));
+            for (int i = 0; i < n; i++)
+            {
+                const KeyEvent *k = &out[i];
+                bool step = k->action == KEY_ACTION_PRESS || k->action == KEY_ACTION_REPEAT;
+                key_events++;
+
+                // volume steps post to audio and display directly, before and after
+                if ((k->key == INPUT_VOLUME_UP || k->key == INPUT_VOLUME_DOWN))
+                {
+                    if (step)
+                        volume_posts++;
+                }
+                else
+                {
+                    // old input_task.c: push, wake the display, click on press
+                    old_display++;
+                    if (k->action == KEY_ACTION_PRESS)
+                        old_audio++;
+                }
+                event_bus_publish(EVENT_TOPIC_KEY, event_key_pack(k->key, k->action, k->count), NULL);
+            }
+
+            // background producers, the old wiring posted each of these to the display
+            uint32_t publish[4][2];
+            int np = 0;
+            if (t == 30000)
+                publish[np][0] = EVENT_TOPIC_BATTERY, publish[np++][1] = 80 - session;
+            if (t % 20000 == 10000)
+                publish[np][0] = EVENT_TOPIC_SIGNAL, publish[np++][1] = 3 + (t / 20000) % 2;
+            if (t == 20000 || t == 25000 || t == 40000)
+                publish[np][0] = EVENT_TOPIC_CALL_STATE,
+                publish[np++][1] = t == 20000 ? CALL_RINGING : t == 25000 ? CALL_ACTIVE : CALL_IDLE;
+            for (int i = 0; i < np; i++)
+            {
+                other_events++;
+                if (!(publish[i][0] == EVENT_TOPIC_CALL_STATE && publish[i][1] == CALL_IDLE))
+                    old_display++; // update_display() posted every state but idle
+                event_bus_publish(publish[i][0], publish[i][1], NULL);
+            }
+            if (t == 45000)
+            {
+                other_events++;
+                old_display++;
+                event_bus_publish(EVENT_TOPIC_SMS_RECEIVED, 0, msg_alloc(MSG_TYPE_SMS, 32));
+            }
+
+            // the display task runs and drains everything it was woken for
+            Event ev;
+            while (event_bus_receive(display_sub, &ev))
+                event_bus_release(&ev);
+            KeyEvent k;
+            while (input_queue_pop(&k))
+                ;
+        }
+    }
+
+    double seconds = SESSIONS * SESSION_MS / 1000.0;
+    unsigned new_display = wakes[WAKE_DISPLAY];
+    unsigned new_audio = wakes[WAKE_AUDIO];
+    unsigned old_total = old_display + old_audio + 2 * volume_posts;
+    unsigned new_total = new_display + new_audio + 2 * volume_posts;
+
+    printf("  %u key events, %u other events in %.0f s\n", key_events, other_events, seconds);
+    printf("  %-8s %12s %12s\n", "task", "old wakes/s", "bus wakes/s");
+    printf("  %-8s %12.2f %12.2f\n", "display", (old_display + volume_posts) / seconds,
+           (new_display + volume_posts) / seconds);
+    printf("  %-8s %12.2f %12.2f\n", "audio", (old_audio + volume_posts) / seconds, (new_audio + volume_posts) / seconds);
+    printf("  %-8s %12.2f %12.2f  (%.2f wakeups/s saved, %.0f%%)\n", "total", old_total / seconds,
+           new_total / seconds, (old_total - new_total) / seconds, 100.0 * (old_total - new_total) / old_total);
+
+    for (int topic = 0; topic < EVENT_TOPIC_COUNT; topic++)
+    {
+        static const char *names[] = {"battery", "signal", "sms", "call state", "key"};
+        EventTopicStats ts;
+        event_bus_get_topic_stats((EventTopic)topic, &ts);
+        printf("  %-10s published %5u delivered %5u filtered %5u dropped %u\n", names[topic], ts.published,
+               ts.delivered, ts.filtered, ts.dropped);
+        CHECK(ts.dropped == 0);
+    }
+
+    CHECK(new_display < old_display);
+    CHECK(new_audio == old_audio);
+    MsgPoolStats ps;
+    msg_pool_get_stats(&ps);
+    CHECK(ps.in_use == 0);
+}
+
+int main(void)
+{
+    test_basics();
+    measure_wakeups();
+
+    return check_summary();
+}
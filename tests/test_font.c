@@ -0,0 +1,250 @@
+/**
+ * @file test_font.c
+ * @brief Unicode font loader host test and benchmark
+ * @ingroup tests
+ *
+ * Checks the UTF-8 decoder, glyph decoding against the synthetic font
+ * formula in tools/font_build.py, and UCS-2 SMS bodies decoding to UTF-8.
+ * Then draws a mixed-script SMS corpus the way the messages page does and
+ * reports file reads, page cache hit rate, render time and panel bytes,
+ * first for a cold cache and then for redraws.
+ *
+ * Build and run:
+ *   python3 tools/font_build.py --synthetic /tmp/font.ufn
+ *   gcc -O2 -I./include/ui -I./include/board -I./include/kernel -o test_font tests/test_font.c ui/font.c drivers/modem/pdu.c
+ *   ./test_font /tmp/font.ufn
+ */
+
+#include "font.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define WINDOW_BYTES 11 // CASET, RASET and RAMWR with their parameters
+
+// 5x7 font at size 2: 5x8 cells, each a 2x2 fill_rect window
+#define LEGACY_CHAR_BYTES (5 * 8 * (WINDOW_BYTES + 2 * 2 * 2))
+
+// drivers/modem/pdu.c has no header
+int encodePDU(const char *smscNumber, const char *destNumber, const char *message, int useUCS2, char *outPdu,
+              int outPduSize);
+void decodePDU(const char *pdu, char *sender, int senderSize, char *timestamp, int tsSize, char *message,
+               int msgSize);
+
+static unsigned long long blit_bytes;
+static unsigned long blit_calls;
+static uint16_t last_pixels[FONT_MAX_WIDTH * FONT_MAX_HEIGHT];
+static uint16_t last_width, last_height;
+
+static void count_blit(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t *pixels)
+{
+    (void)x;
+    (void)y;
+    blit_calls++;
+    blit_bytes += WINDOW_BYTES + 2u * width * height;
+    last_width = width;
+    last_height = height;
+    memcpy(last_pixels, pixels, 2u * width * height);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// same formula as synthetic_font() in tools/font_build.py
+static uint16_t synthetic_row(uint32_t cp, int y, uint8_t advance)
+{
+    uint32_t h = cp * 2654435761u + (uint32_t)y * 40503u;
+    h ^= h >> 15;
+    return (uint16_t)(h & 0xFFFF & (0xFFFF << (16 - advance)));
+}
+
+static const char *corpus[] = {
+    "Running 10 min late, see you at the station",
+    "Café at 3? J'ai réservé une table près de la fenêtre 😊",
+    "Grüße aus München! Das Wetter ist schön, bis Sonntag.",
+    "Привет! Ты сегодня будешь дома? Позвони мне вечером.",
+    "Γεια σου! Θα τα πούμε αύριο στις 8.",
+    "明天下午三点在公司门口见，别忘了带合同。",
+    "今日はありがとうございました。また連絡します。",
+    "Happy birthday!! 🎂🎉🎈 Have a great one",
+    "Your code is 483920. Do not share it with anyone.",
+    "Olá! Você já chegou? Estou à espera no café.",
+    "Zażółć gęślą jaźń — test polskich znaków",
+    "Встреча перенесена на 15:30, кабинет 204",
+    "好的👍 我马上到",
+    "¿Dónde estás? Llámame cuando puedas ☎",
+    "OK",
+    "Ça marche, à demain ! €12 pour le billet",
+    "会議は来週の月曜日に変更になりました",
+    "Спасибо за помощь! 🙏",
+    "Meet me at the café near the 駅 (station)",
+    "Balance: 25.40 EUR. Top up at any store.",
+};
+#define CORPUS_SIZE (sizeof(corpus) / sizeof(corpus[0]))
+
+static void test_utf8(void)
+{
+    printf("UTF-8 decoder\n");
+    const char *s = "A\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80";
+    CHECK(font_utf8_next(&s) == 'A');
+    CHECK(font_utf8_next(&s) == 0xE9);
+    CHECK(font_utf8_next(&s) == 0x4E2D);
+    CHECK(font_utf8_next(&s) == 0x1F600);
+    CHECK(font_utf8_next(&s) == 0);
+    CHECK(font_utf8_next(&s) == 0); // stays at the end
+
+    // overlong, surrogate, out of range, stray continuation, truncated
+    const char *bad[] = {"\xC0\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\x80", "\xE4\xB8"};
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        const char *p = bad[i];
+        CHECK(font_utf8_next(&p) == FONT_REPLACEMENT);
+        CHECK(p == bad[i] + 1);
+    }
+}
+
+static void test_glyphs(FontContext *ctx)
+{
+    printf("Glyph decoding\n");
+    const uint32_t cps[] = {'A', 'z', 0xE9, 0x416, 0x3A9, 0x3042, 0x4E2D, 0x9FA5, 0x1F600, 0x1F6FF};
+    for (size_t i = 0; i < sizeof(cps) / sizeof(cps[0]); i++)
+    {
+        const FontGlyph *g = font_glyph(ctx, cps[i]);
+        CHECK(g != NULL);
+        if (!g)
+            continue;
+        uint8_t advance = cps[i] < 0x2000 ? 8 : 16;
+        CHECK(g->advance == advance);
+        for (int y = 0; y < ctx->height; y++)
+            CHECK(g->rows[y] == synthetic_row(cps[i], y, advance));
+    }
+
+    // Thai is not in the font: one miss, then served from the cache as missing
+    CHECK(font_glyph(ctx, 0x0E01) == NULL);
+    uint32_t reads = ctx->reads;
+    CHECK(font_glyph(ctx, 0x0E02) == NULL);
+    CHECK(ctx->reads == reads);
+
+    // drawn pixels match the bitmap
+    ctx->blit = count_blit;
+    font_draw_utf8(ctx, 0, 0, "\xE4\xB8\xAD", 0xFFFF, 0x0000);
+    CHECK(last_width == 16 && last_height == ctx->height);
+    for (int y = 0; y < ctx->height; y++)
+        for (int x = 0; x < 16; x++)
+        {
+            bool on = synthetic_row(0x4E2D, y, 16) & (0x8000 >> x);
+            CHECK(last_pixels[y * 16 + x] == (on ? 0xFFFF : 0x0000));
+        }
+
+    // a missing glyph still advances by a box
+    int end = font_draw_utf8(ctx, 0, 0, "\xE0\xB8\x81", 0xFFFF, 0x0000);
+    CHECK(end == ctx->height / 2 + 1);
+}
+
+static void test_pdu(void)
+{
+    printf("UCS-2 SMS bodies\n");
+    // SMS-DELIVER from +447700900123, UCS-2: "Zé Я 中 😀"
+    const char *pdu = "00"             // no SMSC
+                      "04"             // SMS-DELIVER
+                      "0C91447700091032" "00" "08"
+                      "52011131000040" // timestamp
+                      "12"             // 18 bytes of user data
+                      "005A00E90020042F00204E2D0020D83DDE00";
+    char sender[32], timestamp[32], message[64];
+    decodePDU(pdu, sender, sizeof(sender), timestamp, sizeof(timestamp), message, sizeof(message));
+    CHECK(strcmp(sender, "447700900123") == 0);
+    CHECK(strcmp(message, "Z\xC3\xA9 \xD0\xAF \xE4\xB8\xAD \xF0\x9F\x98\x80") == 0);
+
+    // a truncated buffer never ends in a partial sequence
+    decodePDU(pdu, sender, sizeof(sender), timestamp, sizeof(timestamp), message, 4);
+    CHECK(strcmp(message, "Z\xC3\xA9") == 0);
+
+    char out[256];
+    encodePDU("", "447700900123", "Z\xC3\xA9\xF0\x9F\x98\x80", 1, out, sizeof(out));
+    CHECK(strstr(out, "08" "08" "005A00E9D83DDE00") != NULL); // DCS, UDL, body
+}
+
+// draws every message `redraws` times in a row, as the messages page does on each repaint
+static void run_corpus(FontContext *ctx, const char *label, int redraws)
+{
+    uint32_t hits = ctx->cache_hits, misses = ctx->cache_misses, reads = ctx->reads;
+    uint32_t evictions = ctx->evictions;
+    unsigned long long bytes = blit_bytes;
+    unsigned long long legacy = 0;
+    unsigned long glyphs = 0;
+    int draws = 0;
+
+    double start = now_ns();
+    for (size_t i = 0; i < CORPUS_SIZE; i++)
+        for (int pass = 0; pass < redraws; pass++)
+        {
+            // message body area of the messages page, 13 lines of 16 px
+            font_draw_wrapped(ctx, 15, 70, 210, 13, corpus[i], 0xFFFF, 0x0000);
+            const char *p = corpus[i];
+            while (font_utf8_next(&p))
+                glyphs++;
+            legacy += (unsigned long long)strlen(corpus[i]) * LEGACY_CHAR_BYTES;
+            draws++;
+        }
+    double elapsed = now_ns() - start;
+
+    uint32_t lookups = (ctx->cache_hits - hits) + (ctx->cache_misses - misses);
+    printf("  %-8s %lu glyphs, %u page loads, %u reads, %u evictions, hit rate %.1f%%\n", label, glyphs,
+           ctx->cache_misses - misses, ctx->reads - reads, ctx->evictions - evictions,
+           100.0 * (ctx->cache_hits - hits) / (lookups ? lookups : 1));
+    printf("           %.2f us/message on the host, %llu panel bytes/message (5x7 at size 2: %llu)\n",
+           elapsed / 1e3 / draws, (blit_bytes - bytes) / draws, legacy / draws);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: %s <font.ufn>\n", argv[0]);
+        return 1;
+    }
+
+    test_utf8();
+    test_pdu();
+
+    static FontContext ctx;
+    if (!font_open(&ctx, argv[1]))
+    {
+        printf("not a font file: %s\n", argv[1]);
+        return 1;
+    }
+    printf("Font: height %u, %u pages, %u directory blocks, %zu bytes of context (%d cached pages)\n", ctx.height,
+           ctx.page_count, ctx.block_count, sizeof(ctx), FONT_CACHE_PAGES);
+    test_glyphs(&ctx);
+
+    printf("Mixed-script SMS corpus, %zu messages\n", CORPUS_SIZE);
+    font_close(&ctx);
+    font_open(&ctx, argv[1]);
+    ctx.blit = count_blit;
+    run_corpus(&ctx, "open", 1);
+    run_corpus(&ctx, "again", 1);
+    run_corpus(&ctx, "redraw", 5);
+
+    // reads to show one message, starting from what the previous one left cached
+    font_close(&ctx);
+    font_open(&ctx, argv[1]);
+    ctx.blit = count_blit;
+    uint32_t worst = 0;
+    for (size_t i = 0; i < CORPUS_SIZE; i++)
+    {
+        uint32_t reads = ctx.reads;
+        font_draw_wrapped(&ctx, 15, 70, 210, 13, corpus[i], 0xFFFF, 0x0000);
+        if (ctx.reads - reads > worst)
+            worst = ctx.reads - reads;
+    }
+    printf("  worst single message: %u reads\n", worst);
+    font_close(&ctx);
+
+    return check_summary();
+}
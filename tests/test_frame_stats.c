@@ -0,0 +1,72 @@
+/**
+ * @file test_frame_stats.c
+ * @brief Frame statistics host test
+ * @ingroup tests
+ *
+ * Feeds synthetic frames into the per-page histograms and checks bucketing,
+ * percentiles, budget counting and the text dump. Also usable as a CI budget
+ * check: exits non-zero if any assertion fails.
+ *
+ * Build and run:
+ *   gcc -O2 -I./include -I./include/ui -o test_frame_stats tests/test_frame_stats.c ui/frame_stats.c
+ *   ./test_frame_stats
+ */
+
+#include "ui/frame_stats.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <string.h>
+
+static void draw_a(Page *self, int tx, int ty) {}
+static void draw_b(Page *self, int tx, int ty) {}
+
+int main(void)
+{
+    Page page_a = {.draw_tile = draw_a, .name = "alpha"};
+    Page page_b = {.draw_tile = draw_b, .name = "beta"};
+
+    frame_stats_reset();
+
+    // idle ticks are ignored
+    frame_stats_record(&page_a, 5, 0, 0);
+    CHECK(frame_stats_count() == 0);
+
+    // 90 fast frames and 10 slow ones on page A
+    for (int i = 0; i < 90; i++)
+        frame_stats_record(&page_a, 1000, 2, 3600);
+    for (int i = 0; i < 10; i++)
+        frame_stats_record(&page_a, 20000, 72, 115200);
+
+    frame_stats_record(&page_b, 300, 1, 1800);
+
+    CHECK(frame_stats_count() == 2);
+
+    const FramePageStats *a = frame_stats_find("alpha");
+    CHECK(a != NULL);
+    CHECK(a->frames == 100);
+    CHECK(a->over_budget == 10);
+    CHECK(a->time_us.max == 20000);
+    CHECK(a->time_us.buckets[9] == 90);  // 1000 in [512, 1024)
+    CHECK(a->time_us.buckets[14] == 10); // 20000 in [16384, 32768)
+
+    uint32_t p50 = frame_stats_percentile(&a->time_us, 50);
+    uint32_t p95 = frame_stats_percentile(&a->time_us, 95);
+    CHECK(p50 >= 1000 && p50 < 2048);
+    CHECK(p95 == 20000);
+    CHECK(frame_stats_mean(&a->tiles, a->frames) == (90 * 2 + 10 * 72) / 100);
+
+    const FramePageStats *b = frame_stats_find("beta");
+    CHECK(b != NULL && b->frames == 1 && b->over_budget == 0);
+    CHECK(frame_stats_find("gamma") == NULL);
+
+    frame_stats_dump(printf);
+
+    // timer must be monotonic
+    uint32_t t0 = frame_stats_now();
+    CHECK(frame_stats_elapsed_us(t0) < 1000000);
+
+    frame_stats_reset();
+    CHECK(frame_stats_count() == 0);
+
+    return check_summary();
+}
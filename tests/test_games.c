@@ -0,0 +1,535 @@
+/**
+ * @file test_games.c
+ * @brief Snake and Minesweeper runtime host test and benchmark
+ * @ingroup tests
+ *
+ * Snake: replays random games against a reference that shifts the whole
+ * body each tick, checks that every tick only changes the cells it reports
+ * for redraw, then drives a 64x64 snake around a Hamiltonian cycle until it
+ * fills the board and compares per-tick time at full length with the
+ * shifting reference.
+ *
+ * Minesweeper: replays random reveals, chords and flags against the old
+ * recursive reveal, then floods an empty board from a corner at device size
+ * and at 128x128. Peak stack use of both fills is measured by running them
+ * on a painted pthread stack.
+ *
+ * Build and run:
+ *   gcc -O2 -DSNAKE_COLS=64 -DSNAKE_ROWS=64 -DSWEEPER_MAX_COLS=128 \
+ *       -DSWEEPER_MAX_ROWS=128 -I./include/ui -I./include/ui/pages \
+ *       -o test_games tests/test_games.c ui/pages/games/snake_game.c \
+ *       ui/pages/games/sweeper_board.c -lpthread
+ *   ./test_games
+ */
+
+#include "snake_game.h"
+#include "sweeper_board.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STACK_PAINT 0xA5
+#define DEVICE_COLS 8
+#define DEVICE_ROWS 9
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ---------- stack measurement ---------- */
+
+typedef struct
+{
+    void (*fn)(void *);
+    void *arg;
+    const unsigned char *stack; // lowest address of the painted stack
+    size_t used;                // bytes touched below the trampoline's frame
+} StackJob;
+
+/*
+    Measures before returning, because the thread exit path that runs after
+    the trampoline reaches deeper than a small fn and would hide it.
+*/
+static __attribute__((noinline)) void *stack_trampoline(void *p)
+{
+    StackJob *job = (StackJob *)p;
+    const unsigned char *top = __builtin_frame_address(0);
+    job->fn(job->arg);
+
+    const unsigned char *low = job->stack;
+    while (low < top && *low == STACK_PAINT)
+        low++;
+    job->used = (size_t)(top - low);
+    return NULL;
+}
+
+// bytes of a painted thread stack touched by fn and everything it calls
+static size_t stack_peak(void (*fn)(void *), void *arg, size_t size)
+{
+    unsigned char *stack = aligned_alloc(4096, size);
+    memset(stack, STACK_PAINT, size);
+
+    pthread_attr_t attr;
+    pthread_t thread;
+    StackJob job = {fn, arg, stack, 0};
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, size);
+    pthread_create(&thread, &attr, stack_trampoline, &job);
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+    free(stack);
+    return job.used;
+}
+
+/* ---------- snake ---------- */
+
+// the old runtime: body shifted every tick, linear collision scan
+typedef struct
+{
+    int8_t x[SNAKE_CELLS + 1]; // last index holds the previous tail
+    int8_t y[SNAKE_CELLS + 1];
+    int len;
+    bool over;
+} RefSnake;
+
+static void ref_snake_step(RefSnake *s, SnakeDirection d, SnakeCell apple)
+{
+    s->x[SNAKE_CELLS] = s->x[s->len - 1];
+    s->y[SNAKE_CELLS] = s->y[s->len - 1];
+    for (int i = s->len - 1; i > 0; i--)
+    {
+        s->x[i] = s->x[i - 1];
+        s->y[i] = s->y[i - 1];
+    }
+    if (d == SNAKE_LEFT)
+        s->x[0] = (int8_t)(s->x[0] == 0 ? SNAKE_COLS - 1 : s->x[0] - 1);
+    else if (d == SNAKE_RIGHT)
+        s->x[0] = (int8_t)(s->x[0] == SNAKE_COLS - 1 ? 0 : s->x[0] + 1);
+    else if (d == SNAKE_UP)
+        s->y[0] = (int8_t)(s->y[0] == 0 ? SNAKE_ROWS - 1 : s->y[0] - 1);
+    else
+        s->y[0] = (int8_t)(s->y[0] == SNAKE_ROWS - 1 ? 0 : s->y[0] + 1);
+
+    for (int i = 1; i < s->len; i++)
+    {
+        if (s->x[0] == s->x[i] && s->y[0] == s->y[i])
+        {
+            s->over = true;
+            return;
+        }
+    }
+    if (s->len == 2 && s->x[0] == s->x[SNAKE_CELLS] && s->y[0] == s->y[SNAKE_CELLS])
+    {
+        s->over = true;
+        return;
+    }
+    if (s->x[0] == apple.x && s->y[0] == apple.y)
+    {
+        s->x[s->len] = s->x[SNAKE_CELLS];
+        s->y[s->len] = s->y[SNAKE_CELLS];
+        s->len++;
+    }
+}
+
+// what the page paints for a cell: 0 background, 1 snake, 2 apple
+static int cell_colour(const SnakeGame *g, int x, int y)
+{
+    if (snake_game_occupied(g, x, y))
+        return 1;
+    if (g->apple.x == x && g->apple.y == y)
+        return 2;
+    return 0;
+}
+
+static bool step_reports(const SnakeStep *step, int x, int y)
+{
+    if (step->moved && step->head.x == x && step->head.y == y)
+        return true;
+    if (step->tail_cleared && step->tail.x == x && step->tail.y == y)
+        return true;
+    if (step->apple_moved && step->apple.x == x && step->apple.y == y)
+        return true;
+    return false;
+}
+
+static void test_snake_matches_reference(void)
+{
+    static SnakeGame game;
+    static RefSnake ref;
+    static uint8_t before[SNAKE_ROWS][SNAKE_COLS];
+    int games = 0, ticks = 0, mismatches = 0, unreported = 0;
+
+    srand(7);
+    for (games = 0; games < 200 && ticks < 100000; games++)
+    {
+        snake_game_init(&game, (uint32_t)rand() | 1);
+        memset(&ref, 0, sizeof(ref));
+        ref.len = 1;
+        ref.x[0] = game.body[game.head].x;
+        ref.y[0] = game.body[game.head].y;
+
+        while (game.status == SNAKE_RUN)
+        {
+            SnakeDirection d = game.dir;
+            if (rand() % 4 == 0)
+                d = (SnakeDirection)(rand() % 4);
+            snake_game_turn(&game, d);
+
+            for (int y = 0; y < SNAKE_ROWS; y++)
+                for (int x = 0; x < SNAKE_COLS; x++)
+                    before[y][x] = (uint8_t)cell_colour(&game, x, y);
+
+            SnakeCell apple = game.apple;
+            SnakeStep step;
+            snake_game_step(&game, &step);
+            ref_snake_step(&ref, d, apple);
+            ticks++;
+
+            if ((game.status == SNAKE_OVER) != ref.over)
+            {
+                mismatches++;
+                break;
+            }
+            if (ref.over)
+                break;
+
+            if (ref.len != game.len)
+                mismatches++;
+            for (int i = 0; i < ref.len && i < game.len; i++)
+            {
+                SnakeCell c = snake_game_body(&game, (uint16_t)i);
+                if (c.x != ref.x[i] || c.y != ref.y[i])
+                {
+                    mismatches++;
+                    break;
+                }
+            }
+
+            for (int y = 0; y < SNAKE_ROWS; y++)
+                for (int x = 0; x < SNAKE_COLS; x++)
+                    if (before[y][x] != cell_colour(&game, x, y) && !step_reports(&step, x, y))
+                        unreported++;
+        }
+    }
+
+    printf("snake: %d random games, %d ticks against the shifting reference\n", games, ticks);
+    CHECK(mismatches == 0);
+    CHECK(unreported == 0);
+}
+
+// Hamiltonian cycle: row 0 is the return lane, columns snake through rows 1..H-1
+static SnakeDirection cycle_direction(int x, int y)
+{
+    if (y == 0)
+        return x > 0 ? SNAKE_LEFT : SNAKE_DOWN;
+    if (x % 2 == 0)
+        return y < SNAKE_ROWS - 1 ? SNAKE_DOWN : SNAKE_RIGHT;
+    if (y > 1 || x == SNAKE_COLS - 1)
+        return SNAKE_UP;
+    return SNAKE_RIGHT;
+}
+
+static SnakeGame cycle_game;
+
+static void snake_step_once(void *arg)
+{
+    (void)arg;
+    SnakeCell head = cycle_game.body[cycle_game.head];
+    snake_game_turn(&cycle_game, cycle_direction(head.x, head.y));
+    snake_game_step(&cycle_game, NULL);
+}
+
+static void test_snake_fills_board(void)
+{
+    static RefSnake ref;
+    uint64_t ticks = 0;
+    double worst = 0, total = 0;
+
+    snake_game_init(&cycle_game, 12345);
+    while (cycle_game.status == SNAKE_RUN)
+    {
+        SnakeCell head = cycle_game.body[cycle_game.head];
+        snake_game_turn(&cycle_game, cycle_direction(head.x, head.y));
+        double t0 = now_ns();
+        snake_game_step(&cycle_game, NULL);
+        double dt = now_ns() - t0;
+        total += dt;
+        if (dt > worst)
+            worst = dt;
+        ticks++;
+    }
+
+    CHECK(cycle_game.status == SNAKE_WIN);
+    CHECK(cycle_game.len == SNAKE_CELLS);
+    printf("snake: %dx%d board filled in %llu ticks, mean %.1f ns/tick, worst %.0f ns\n",
+           SNAKE_COLS, SNAKE_ROWS, (unsigned long long)ticks, total / ticks, worst);
+
+    // full length runs, apple parked off the path so neither side grows
+    snake_game_init(&cycle_game, 1);
+    while (cycle_game.len < SNAKE_CELLS - 1)
+    {
+        SnakeCell head = cycle_game.body[cycle_game.head];
+        snake_game_turn(&cycle_game, cycle_direction(head.x, head.y));
+        snake_game_step(&cycle_game, NULL);
+    }
+    memset(&ref, 0, sizeof(ref));
+    ref.len = cycle_game.len;
+    for (int i = 0; i < ref.len; i++)
+    {
+        SnakeCell c = snake_game_body(&cycle_game, (uint16_t)i);
+        ref.x[i] = c.x;
+        ref.y[i] = c.y;
+    }
+
+    // the only free cell holds the apple, keep it there by stepping a copy of the layout
+    const int runs = 20000;
+    SnakeCell nowhere = {-1, -1};
+    double t0 = now_ns();
+    for (int i = 0; i < runs; i++)
+        ref_snake_step(&ref, cycle_direction(ref.x[0], ref.y[0]), nowhere);
+    double ref_ns = (now_ns() - t0) / runs;
+
+    cycle_game.apple = nowhere;
+    t0 = now_ns();
+    for (int i = 0; i < runs; i++)
+        snake_step_once(NULL);
+    double ring_ns = (now_ns() - t0) / runs;
+
+    CHECK(!ref.over);
+    CHECK(cycle_game.status == SNAKE_RUN);
+    printf("snake: length %d, ring buffer %.1f ns/tick, shifting reference %.1f ns/tick\n",
+           cycle_game.len, ring_ns, ref_ns);
+
+    size_t stack = stack_peak(snake_step_once, NULL, 64 * 1024);
+    printf("snake: step stack %zu bytes\n", stack);
+    CHECK(stack < 512);
+}
+
+/* ---------- minesweeper ---------- */
+
+// the old recursive reveal, with its neighbour loops fixed to use signed offsets
+static void ref_reveal(SweeperBoard *b, int x, int y, bool sub_call)
+{
+    SweeperCell *cell = &b->cells[y][x];
+    int flags = 0;
+
+    if (cell->flag)
+        return;
+    if (cell->value == SWEEPER_MINE)
+    {
+        cell->hidden = false;
+        b->status = SWEEPER_OVER;
+        return;
+    }
+    if (!cell->hidden && cell->value == 0)
+        return;
+
+    if (!cell->hidden && !sub_call)
+    {
+        for (int i = -1; i < 2; i++)
+            for (int j = -1; j < 2; j++)
+                if (x + i >= 0 && y + j >= 0 && x + i < b->cols && y + j < b->rows &&
+                    b->cells[y + j][x + i].flag)
+                    flags++;
+        if (flags == cell->value)
+        {
+            for (int i = -1; i < 2; i++)
+                for (int j = -1; j < 2; j++)
+                    if (x + i >= 0 && y + j >= 0 && x + i < b->cols && y + j < b->rows)
+                        ref_reveal(b, x + i, y + j, true);
+        }
+        return;
+    }
+
+    cell->hidden = false;
+    if (cell->value == 0)
+    {
+        for (int i = -1; i < 2; i++)
+            for (int j = -1; j < 2; j++)
+                if (x + i >= 0 && y + j >= 0 && x + i < b->cols && y + j < b->rows)
+                    ref_reveal(b, x + i, y + j, true);
+    }
+}
+
+static bool same_hidden(const SweeperBoard *a, const SweeperBoard *b)
+{
+    for (int y = 0; y < a->rows; y++)
+        for (int x = 0; x < a->cols; x++)
+            if (a->cells[y][x].hidden != b->cells[y][x].hidden || a->cells[y][x].flag != b->cells[y][x].flag)
+                return false;
+    return true;
+}
+
+static void test_sweeper_matches_reference(void)
+{
+    static SweeperBoard board, ref;
+    int games = 0, moves = 0, mismatches = 0, wins = 0, losses = 0, counted = 0;
+
+    srand(11);
+    for (games = 0; games < 2000; games++)
+    {
+        uint8_t cols = (uint8_t)(4 + rand() % 29);
+        uint8_t rows = (uint8_t)(4 + rand() % 29);
+        uint16_t mines = (uint16_t)(rand() % (cols * rows / 5 + 1));
+        sweeper_board_init(&board, cols, rows, mines);
+        sweeper_board_reveal(&board, (uint8_t)(rand() % cols), (uint8_t)(rand() % rows));
+        memcpy(&ref, &board, sizeof(board));
+
+        while (board.status == SWEEPER_ALIVE && moves < 5000000)
+        {
+            uint8_t x = (uint8_t)(rand() % cols);
+            uint8_t y = (uint8_t)(rand() % rows);
+            SweeperCell *c = &board.cells[y][x];
+            moves++;
+
+            // flag real mines most of the time so chords get exercised
+            if (c->hidden && (c->value == SWEEPER_MINE ? rand() % 8 != 0 : rand() % 16 == 0))
+            {
+                sweeper_board_toggle_flag(&board, x, y);
+                ref.cells[y][x].flag = !ref.cells[y][x].flag;
+                continue;
+            }
+            if (c->hidden && c->value == SWEEPER_MINE && !c->flag && rand() % 32 != 0)
+                continue;
+
+            sweeper_board_reveal(&board, x, y);
+            ref_reveal(&ref, x, y, false);
+
+            if ((board.status == SWEEPER_OVER) != (ref.status == SWEEPER_OVER))
+            {
+                mismatches++;
+                break;
+            }
+            if (board.status == SWEEPER_ALIVE && !same_hidden(&board, &ref))
+            {
+                mismatches++;
+                break;
+            }
+        }
+
+        // counters must agree with a board scan
+        int hidden_safe = 0, flagged = 0;
+        for (int y = 0; y < rows; y++)
+            for (int x = 0; x < cols; x++)
+            {
+                hidden_safe += board.cells[y][x].hidden && board.cells[y][x].value != SWEEPER_MINE;
+                flagged += board.cells[y][x].flag && board.cells[y][x].value == SWEEPER_MINE;
+            }
+        if (hidden_safe != board.hidden_safe || flagged != board.flagged_mines)
+            counted++;
+        if (board.status == SWEEPER_WIN)
+            wins++;
+        if (board.status == SWEEPER_OVER)
+            losses++;
+        CHECK(board.work_peak <= cols * rows);
+    }
+
+    printf("sweeper: %d random games (%d won, %d lost), %d moves against the recursive reveal\n",
+           games, wins, losses, moves);
+    CHECK(mismatches == 0);
+    CHECK(counted == 0);
+    CHECK(wins > 0);
+    CHECK(losses > 0);
+}
+
+typedef struct
+{
+    SweeperBoard *board;
+    bool recursive;
+    int opened;
+} FloodJob;
+
+static void flood_corner(void *arg)
+{
+    FloodJob *job = (FloodJob *)arg;
+    if (job->recursive)
+    {
+        job->board->status = SWEEPER_ALIVE;
+        ref_reveal(job->board, 0, 0, false);
+    }
+    else
+    {
+        job->opened = sweeper_board_reveal(job->board, 0, 0);
+    }
+}
+
+static void flood_worst_case(uint8_t cols, uint8_t rows, size_t stack_size)
+{
+    static SweeperBoard board;
+    FloodJob job = {&board, false, 0};
+
+    // no mines: one reveal opens the whole board, the deepest recursion possible
+    sweeper_board_init(&board, cols, rows, 0);
+    double t0 = now_ns();
+    flood_corner(&job);
+    double flood_us = (now_ns() - t0) / 1000.0;
+    CHECK(job.opened == cols * rows);
+    CHECK(board.status == SWEEPER_WIN);
+    CHECK(board.hidden_safe == 0);
+    uint16_t work_peak = board.work_peak;
+
+    sweeper_board_init(&board, cols, rows, 0);
+    size_t iterative = stack_peak(flood_corner, &job, stack_size);
+
+    sweeper_board_init(&board, cols, rows, 0);
+    job.recursive = true;
+    size_t recursive = stack_peak(flood_corner, &job, stack_size);
+
+    printf("sweeper: %dx%d empty board, flood %.1f us, work list peak %u/%d, "
+           "stack iterative %zu bytes, recursive %zu bytes\n",
+           cols, rows, flood_us, work_peak, cols * rows, iterative, recursive);
+    CHECK(iterative < 512);
+    CHECK(work_peak <= cols * rows);
+}
+
+static void test_sweeper_worst_case(void)
+{
+    flood_worst_case(DEVICE_COLS, DEVICE_ROWS, 64 * 1024);
+    flood_worst_case(SWEEPER_MAX_COLS, SWEEPER_MAX_ROWS, 16 * 1024 * 1024);
+}
+
+static void test_sweeper_edges(void)
+{
+    static SweeperBoard board;
+
+    // more mines than room outside the safe block: placement is clamped, never loops
+    sweeper_board_init(&board, DEVICE_COLS, DEVICE_ROWS, 1000);
+    sweeper_board_reveal(&board, 3, 3);
+    CHECK(board.mines == DEVICE_COLS * DEVICE_ROWS - 9);
+    CHECK(board.cells[3][3].value == 0 || board.status == SWEEPER_WIN);
+    CHECK(board.status == SWEEPER_ALIVE);
+
+    // flagging every mine after the region is open wins without another reveal
+    for (int y = 0; y < DEVICE_ROWS; y++)
+        for (int x = 0; x < DEVICE_COLS; x++)
+            if (board.cells[y][x].value == SWEEPER_MINE)
+                sweeper_board_toggle_flag(&board, (uint8_t)x, (uint8_t)y);
+    CHECK(board.status == SWEEPER_WIN);
+
+    // flags on revealed cells and reveals on flags are ignored
+    sweeper_board_init(&board, DEVICE_COLS, DEVICE_ROWS, 0);
+    CHECK(sweeper_board_toggle_flag(&board, 0, 0));
+    CHECK(sweeper_board_reveal(&board, 0, 0) == 0);
+    CHECK(board.cells[0][0].hidden);
+    CHECK(sweeper_board_toggle_flag(&board, 0, 0));
+    CHECK(sweeper_board_reveal(&board, 0, 0) == DEVICE_COLS * DEVICE_ROWS);
+    CHECK(!sweeper_board_toggle_flag(&board, 0, 0));
+    CHECK(sweeper_board_reveal(&board, DEVICE_COLS, 0) == 0);
+}
+
+int main(void)
+{
+    test_snake_matches_reference();
+    test_snake_fills_board();
+    test_sweeper_matches_reference();
+    test_sweeper_edges();
+    test_sweeper_worst_case();
+
+    return check_summary();
+}
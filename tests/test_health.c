@@ -0,0 +1,263 @@
+/**
+ * @file test_health.c
+ * @brief Health monitor host test
+ * @ingroup tests
+ *
+ * Drives the health monitor with a simulated clock the way the watchdog
+ * task does: heartbeats that go silent past their timeout, CPU usage from
+ * run-time counters that wrap, stack marks that run low, and resets that
+ * keep the backup block. Checks that only critical hangs block the
+ * watchdog refresh, that every hang and low stack is recorded once, that
+ * the history and stack minimums survive a reset and that a corrupted
+ * block is cleared. Ends with the cost of a check and a task sample.
+ *
+ * Build and run:
+ *   gcc -O2 -pthread -I./include/kernel -o test_health tests/test_health.c kernel/core/health_monitor.c
+ *   ./test_health
+ */
+
+#include "health_monitor.h"
+#include "test_check.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static HealthBackup backup; // stands in for backup SRAM
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int history_count(HealthEvent event, const char *name)
+{
+    HealthRecord records[HEALTH_HISTORY_LEN];
+    int n = health_get_history(records, HEALTH_HISTORY_LEN);
+    int found = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (records[i].event == event && (!name || strcmp(records[i].name, name) == 0))
+            found++;
+    }
+    return found;
+}
+
+static void test_heartbeats(void)
+{
+    printf("Heartbeats\n");
+    memset(&backup, 0xA5, sizeof(backup)); // power-on garbage
+    health_init(&backup, HEALTH_RESET_POWER_ON, 0);
+
+    uint16_t boots;
+    HealthResetCause cause;
+    health_get_boot(&boots, &cause);
+    CHECK(boots == 1 && cause == HEALTH_RESET_POWER_ON);
+    CHECK(history_count(HEALTH_EVENT_BOOT, NULL) == 1);
+
+    int input = health_register("input", 500, true);
+    int cellular = health_register("cellular", 30000, false);
+    CHECK(input == 0 && cellular == 1);
+
+    // fresh from registration, then beaten on time
+    uint32_t now = 0;
+    for (; now < 5000; now += 100)
+    {
+        health_heartbeat(input, now);
+        health_heartbeat(cellular, now);
+        CHECK(health_check(now));
+    }
+
+    // input stops: refresh is withheld once it is past its timeout, recorded once
+    uint32_t last = now - 100;
+    for (; now < last + 2000; now += 100)
+    {
+        health_heartbeat(cellular, now);
+        bool alive = health_check(now);
+        CHECK(alive == (now - last <= 500));
+    }
+    CHECK(history_count(HEALTH_EVENT_HANG, "input") == 1);
+
+    HealthHeartbeatInfo info[HEALTH_MAX_HEARTBEATS];
+    CHECK(health_get_heartbeats(info, HEALTH_MAX_HEARTBEATS, now) == 2);
+    CHECK(info[0].hung && info[0].critical && !info[1].hung);
+    CHECK(info[0].max_age_ms >= 1900);
+
+    // recovery clears the hang without a second record
+    health_heartbeat(input, now);
+    CHECK(health_check(now));
+
+    // a non-critical hang is recorded but does not stop the refresh
+    last = now;
+    for (; now < last + 31000; now += 500)
+    {
+        health_heartbeat(input, now);
+        CHECK(health_check(now));
+    }
+    CHECK(history_count(HEALTH_EVENT_HANG, "cellular") == 1);
+    CHECK(history_count(HEALTH_EVENT_HANG, "input") == 1);
+
+    // out-of-range ids are ignored
+    health_heartbeat(-1, now);
+    health_heartbeat(HEALTH_MAX_HEARTBEATS, now);
+}
+
+static void test_tasks(void)
+{
+    printf("CPU and stack usage\n");
+    memset(&backup, 0, sizeof(backup));
+    health_init(&backup, HEALTH_RESET_PIN, 0);
+
+    // counters start near the top so the second interval wraps
+    uint32_t base = 0xFFFFFF00u - 1000000;
+    HealthTaskSample s[3] = {
+        {"DisplayTask", base, 900, 24},
+        {"InputTask", base, 300, 24},
+        {"IDLE", base, 400, 0},
+    };
+    health_update_tasks(s, 3, base, 1000);
+
+    // 1,000,000 counts: display 25%, input 2.5%, idle the rest
+    for (int i = 0; i < 2; i++)
+    {
+        s[0].runtime += 250000;
+        s[1].runtime += 25000;
+        s[2].runtime += 725000;
+        base += 1000000;
+        health_update_tasks(s, 3, base, 2000 + i * 1000);
+
+        HealthTaskInfo t[HEALTH_MAX_TASKS];
+        CHECK(health_get_tasks(t, HEALTH_MAX_TASKS) == 3);
+        CHECK(t[0].cpu_permille == 250);
+        CHECK(t[1].cpu_permille == 25);
+        CHECK(t[2].cpu_permille == 725);
+    }
+
+    // input runs low once, recorded once even as it stays low
+    s[1].stack_free = 96;
+    health_update_tasks(s, 3, base, 4000);
+    s[1].stack_free = 80;
+    health_update_tasks(s, 3, base, 5000);
+    CHECK(history_count(HEALTH_EVENT_STACK_LOW, "InputTask") == 1);
+
+    HealthTaskInfo t[HEALTH_MAX_TASKS];
+    health_get_tasks(t, HEALTH_MAX_TASKS);
+    CHECK(t[1].stack_free == 80 && t[1].stack_min == 80);
+    CHECK(t[0].stack_min == 900);
+
+    // a deleted task drops to zero CPU
+    health_update_tasks(s, 2, base + 1000, 6000);
+    health_get_tasks(t, HEALTH_MAX_TASKS);
+    CHECK(t[2].cpu_permille == 0);
+}
+
+static void test_reset(void)
+{
+    printf("History across resets\n");
+    // continues from test_tasks: one boot, one stack record, 6 s uptime
+    health_check(6000);
+    health_init(&backup, HEALTH_RESET_WATCHDOG, 0);
+
+    uint16_t boots;
+    HealthResetCause cause;
+    health_get_boot(&boots, &cause);
+    CHECK(boots == 2 && cause == HEALTH_RESET_WATCHDOG);
+
+    HealthRecord r[HEALTH_HISTORY_LEN];
+    int n = health_get_history(r, HEALTH_HISTORY_LEN);
+    CHECK(n == 3);
+    CHECK(r[0].event == HEALTH_EVENT_BOOT && r[0].value == 6 && r[0].boot == 2);
+    CHECK(r[1].event == HEALTH_EVENT_STACK_LOW && r[1].boot == 1 && r[1].value == 96);
+
+    // the lowest stack seen survives even though this boot has more headroom
+    HealthTaskSample s = {"InputTask", 0, 400, 24};
+    health_update_tasks(&s, 1, 0, 100);
+    HealthTaskInfo t;
+    health_get_tasks(&t, 1);
+    CHECK(t.stack_free == 400 && t.stack_min == 80);
+
+    // the ring keeps the newest records
+    int hb = health_register("display", 100, true);
+    uint32_t now = 0;
+    for (int i = 0; i < HEALTH_HISTORY_LEN + 4; i++)
+    {
+        now += 200;
+        health_check(now); // hangs
+        health_heartbeat(hb, now);
+        health_check(now); // recovers
+    }
+    n = health_get_history(r, HEALTH_HISTORY_LEN);
+    CHECK(n == HEALTH_HISTORY_LEN);
+    CHECK(r[0].event == HEALTH_EVENT_HANG && r[0].uptime_s == now / 1000);
+    CHECK(history_count(HEALTH_EVENT_BOOT, NULL) == 0);
+
+    // one flipped bit clears the block
+    ((uint8_t *)&backup)[offsetof(HealthBackup, history) + 5] ^= 0x10;
+    health_init(&backup, HEALTH_RESET_SOFTWARE, 0);
+    health_get_boot(&boots, NULL);
+    CHECK(boots == 1);
+    CHECK(health_get_history(r, HEALTH_HISTORY_LEN) == 1);
+
+    health_clear_history();
+    CHECK(health_get_history(r, HEALTH_HISTORY_LEN) == 0);
+    health_get_boot(&boots, NULL);
+    CHECK(boots == 1);
+
+    // no backup block: monitoring still works
+    health_init(NULL, HEALTH_RESET_UNKNOWN, 0);
+    hb = health_register("display", 100, true);
+    CHECK(health_check(50));
+    CHECK(!health_check(500));
+    CHECK(health_get_history(r, HEALTH_HISTORY_LEN) == 0);
+}
+
+static void test_cost(void)
+{
+    enum
+    {
+        ROUNDS = 200000,
+        TASKS = 10
+    };
+    health_init(&backup, HEALTH_RESET_PIN, 0);
+    for (int i = 0; i < 6; i++)
+        health_register("task", 1000, i < 3);
+
+    static char names[TASKS][16];
+    HealthTaskSample s[TASKS];
+    for (int i = 0; i < TASKS; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "Task%d", i);
+        s[i] = (HealthTaskSample){names[i], 0, 512, 24};
+    }
+
+    double start = now_ns();
+    for (uint32_t i = 0; i < ROUNDS; i++)
+        health_check(i);
+    double check_ns = (now_ns() - start) / ROUNDS;
+
+    start = now_ns();
+    for (uint32_t i = 0; i < ROUNDS; i++)
+    {
+        for (int t = 0; t < TASKS; t++)
+            s[t].runtime += t * 100;
+        health_update_tasks(s, TASKS, i * 4500, i);
+    }
+    double sample_ns = (now_ns() - start) / ROUNDS;
+
+    printf("  check of 6 heartbeats %.0f ns, sample of %d tasks %.0f ns on the host\n", check_ns, TASKS,
+           sample_ns);
+    printf("  backup block %zu bytes of 4096 backup SRAM\n", sizeof(HealthBackup));
+    CHECK(sizeof(HealthBackup) <= 4096);
+}
+
+int main(void)
+{
+    test_heartbeats();
+    test_tasks();
+    test_reset();
+    test_cost();
+
+    return check_summary();
+}
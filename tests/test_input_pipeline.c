@@ -0,0 +1,126 @@
+/**
+ * @file test_input_pipeline.c
+ * @brief Key event generator and input queue host test
+ * @ingroup tests
+ *
+ * Drives the key event generator with synthetic held-state timelines and
+ * checks press/release/repeat/long-press timing, then floods the input queue
+ * to check coalescing and drop accounting.
+ *
+ * Build and run:
+ *   gcc -O2 -I./include/ui -o test_input_pipeline tests/test_input_pipeline.c ui/input_pipeline.c
+ *   ./test_input_pipeline
+ */
+
+#include "input_pipeline.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <string.h>
+
+// same ordering as the keypad driver button table
+static const input_event_t keymap[] = {
+    INPUT_KEYPAD_0, INPUT_KEYPAD_1, INPUT_KEYPAD_2, INPUT_KEYPAD_3,
+    INPUT_KEYPAD_4, INPUT_KEYPAD_5, INPUT_KEYPAD_6, INPUT_KEYPAD_7,
+    INPUT_KEYPAD_8, INPUT_KEYPAD_9, INPUT_KEYPAD_STAR, INPUT_KEYPAD_HASH,
+    INPUT_DPAD_UP, INPUT_DPAD_DOWN, INPUT_DPAD_LEFT, INPUT_DPAD_RIGHT,
+    INPUT_SELECT, INPUT_LEFT, INPUT_RIGHT, INPUT_PICKUP, INPUT_HANGUP,
+    INPUT_VOLUME_UP, INPUT_VOLUME_DOWN, INPUT_POWER};
+
+#define KEY_COUNT (sizeof(keymap) / sizeof(keymap[0]))
+
+typedef struct
+{
+    int press, release, repeat, longp;
+} Counts;
+
+// hold one key for hold_ms at a 5 ms poll interval, then release it
+static Counts hold_key(KeyEventGen *gen, int bit, uint32_t *now, uint32_t hold_ms)
+{
+    Counts c = {0};
+    KeyEvent ev[8];
+    uint32_t end = *now + hold_ms;
+    for (; *now <= end + 5; *now += 5)
+    {
+        uint32_t held = (*now < end) ? (1UL << bit) : 0;
+        int n = key_events_update(gen, held, *now, ev, 8);
+        for (int i = 0; i < n; i++)
+        {
+            switch (ev[i].action)
+            {
+            case KEY_ACTION_PRESS: c.press++; break;
+            case KEY_ACTION_RELEASE: c.release++; break;
+            case KEY_ACTION_REPEAT: c.repeat++; break;
+            case KEY_ACTION_LONG_PRESS: c.longp++; break;
+            }
+        }
+    }
+    return c;
+}
+
+int main(void)
+{
+    KeyEventGen gen;
+    uint32_t now = 1000;
+
+    key_events_init(&gen, NULL, keymap, KEY_COUNT);
+
+    // short tap: press and release only
+    Counts tap = hold_key(&gen, 13, &now, 100);
+    CHECK(tap.press == 1 && tap.release == 1 && tap.repeat == 0 && tap.longp == 0);
+
+    // hold DOWN for 1 s: repeats start after 400 ms at 80 ms intervals
+    Counts hold = hold_key(&gen, 13, &now, 1000);
+    CHECK(hold.press == 1 && hold.release == 1);
+    CHECK(hold.repeat == 8); // 400, 480, ..., 960
+    CHECK(hold.longp == 1);
+
+    // digits do not repeat but do report a long press
+    Counts digit = hold_key(&gen, 0, &now, 1000);
+    CHECK(digit.repeat == 0 && digit.longp == 1);
+
+    // custom timings
+    KeyEventConfig cfg;
+    key_events_default_config(&cfg);
+    cfg.repeat_delay_ms = 200;
+    cfg.repeat_rate_ms = 50;
+    cfg.long_press_ms = 0;
+    key_events_init(&gen, &cfg, keymap, KEY_COUNT);
+    Counts fast = hold_key(&gen, 12, &now, 500);
+    CHECK(fast.repeat == 6 && fast.longp == 0); // 200, 250, ..., 450
+
+    // queue: ten DOWN presses with no consumer collapse into one entry
+    input_queue_init(INPUT_DEFAULT_COALESCE_MASK);
+    for (int i = 0; i < 10; i++)
+    {
+        KeyEvent press = {INPUT_DPAD_DOWN, KEY_ACTION_PRESS, 1};
+        KeyEvent release = {INPUT_DPAD_DOWN, KEY_ACTION_RELEASE, 1};
+        CHECK(input_queue_push(&press));
+        CHECK(input_queue_push(&release));
+    }
+    KeyEvent out;
+    CHECK(input_queue_pop(&out));
+    CHECK(out.key == INPUT_DPAD_DOWN && out.count == 10);
+    CHECK(!input_queue_pop(&out));
+
+    // digits keep their order and are never merged
+    KeyEvent two = {INPUT_KEYPAD_2, KEY_ACTION_PRESS, 1};
+    input_queue_push(&two);
+    input_queue_push(&two);
+    CHECK(input_queue_pop(&out) && out.count == 1);
+    CHECK(input_queue_pop(&out) && out.count == 1);
+
+    // flood with non-mergeable events: overflow is counted, not silent
+    for (int i = 0; i < INPUT_QUEUE_SIZE + 4; i++)
+        input_queue_push(&two);
+
+    InputQueueStats stats;
+    input_queue_get_stats(&stats);
+    printf("pushed %lu coalesced %lu dropped %lu high water %u\n",
+           (unsigned long)stats.pushed, (unsigned long)stats.coalesced,
+           (unsigned long)stats.dropped, stats.high_water);
+    CHECK(stats.coalesced == 9);
+    CHECK(stats.dropped == 4);
+    CHECK(stats.high_water == INPUT_QUEUE_SIZE);
+
+    return check_summary();
+}
@@ -0,0 +1,222 @@
+/**
+ * @file test_keypad_debounce.c
+ * @brief Vertical-counter keypad debounce host test
+ * @ingroup tests
+ *
+ * Feeds recorded bounce traces, one character per 5 ms scan, through the
+ * parallel debounce and checks the debounced level against the expected
+ * trace: clean presses, chatter on make and on break, glitches that never
+ * become a press and dropouts during a hold. All traces run at once on
+ * separate bits to show the keys do not disturb each other. Random traces
+ * on all 32 bits are then checked against a per-key counter model, and
+ * the changed-key bitmap against the XOR of the states.
+ *
+ * Build and run:
+ *   gcc -O2 -I./include/drivers/peripherals -o test_keypad_debounce tests/test_keypad_debounce.c drivers/peripherals/keypad_debounce.c
+ *   ./test_keypad_debounce
+ */
+
+#include "keypad_debounce.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef struct
+{
+    const char *name;
+    const char *raw;      // level read on each scan, 1 = down
+    const char *expected; // debounced level after each scan
+} Trace;
+
+// expected output for KEYPAD_DEBOUNCE_SAMPLES 7, a level is taken on its 7th scan
+static const Trace traces[] = {
+    {"clean press",
+     "0001111111111111111000000000000000",
+     "0000000001111111111111111000000000"},
+    {"bounce on make",
+     "0010110111011111111111111110000000000",
+     "0000000000000000011111111111111110000"},
+    {"bounce on break",
+     "0111111111111111010010110000000000000",
+     "0000000111111111111111111111110000000"},
+    {"glitches",
+     "0000100000110000011101000111111000000",
+     "0000000000000000000000000000000000000"},
+    {"dropout while held",
+     "0111111111111110001111111111110000000000",
+     "0000000111111111111111111111111111110000"},
+    {"release and press again",
+     "0111111111111100000001111111111000000000",
+     "0000000111111111111100000001111111111000"},
+};
+
+#define TRACE_COUNT ((int)(sizeof(traces) / sizeof(traces[0])))
+
+static void test_traces(void)
+{
+    printf("Recorded bounce traces\n");
+    for (int t = 0; t < TRACE_COUNT; t++)
+    {
+        KeypadDebounce db;
+        keypad_debounce_init(&db);
+        int len = (int)strlen(traces[t].raw);
+        int wrong = 0;
+        for (int i = 0; i < len; i++)
+        {
+            keypad_debounce_update(&db, traces[t].raw[i] == '1' ? 1u : 0u);
+            if ((db.state & 1u) != (uint32_t)(traces[t].expected[i] - '0'))
+                wrong++;
+        }
+        if (wrong)
+            printf("  %s: %d scans differ\n", traces[t].name, wrong);
+        CHECK(wrong == 0);
+        CHECK(keypad_debounce_idle(&db));
+    }
+}
+
+// every trace on its own bit, with a spread of starting offsets
+static void test_parallel(void)
+{
+    printf("Traces in parallel\n");
+    KeypadDebounce db;
+    keypad_debounce_init(&db);
+
+    int len = 0;
+    for (int t = 0; t < TRACE_COUNT; t++)
+    {
+        int l = (int)strlen(traces[t].raw) + t * 3;
+        len = l > len ? l : len;
+    }
+
+    int wrong = 0;
+    uint32_t presses = 0;
+    for (int i = 0; i < len; i++)
+    {
+        uint32_t raw = 0;
+        uint32_t expected = 0;
+        for (int t = 0; t < TRACE_COUNT; t++)
+        {
+            int j = i - t * 3;
+            if (j >= 0 && j < (int)strlen(traces[t].raw))
+            {
+                raw |= (uint32_t)(traces[t].raw[j] - '0') << (t * 5);
+                expected |= (uint32_t)(traces[t].expected[j] - '0') << (t * 5);
+            }
+        }
+        uint32_t before = db.state;
+        uint32_t changed = keypad_debounce_update(&db, raw);
+        CHECK(changed == (before ^ db.state));
+        presses += (uint32_t)__builtin_popcount(changed & db.state);
+        if (db.state != expected)
+            wrong++;
+    }
+    CHECK(wrong == 0);
+    CHECK(presses == 6); // one per trace with a press, two for the last
+    CHECK(keypad_debounce_idle(&db));
+}
+
+// per-key counter the vertical counter must agree with
+typedef struct
+{
+    uint8_t level[32];
+    uint8_t count[32];
+} Model;
+
+static void model_update(Model *m, uint32_t raw)
+{
+    for (int k = 0; k < 32; k++)
+    {
+        uint8_t r = (raw >> k) & 1u;
+        if (r == m->level[k])
+        {
+            m->count[k] = 0;
+        }
+        else if (++m->count[k] == KEYPAD_DEBOUNCE_SAMPLES)
+        {
+            m->level[k] = r;
+            m->count[k] = 0;
+        }
+    }
+}
+
+static void test_random(void)
+{
+    printf("Random traces against the per-key model\n");
+    KeypadDebounce db;
+    Model m;
+    keypad_debounce_init(&db);
+    memset(&m, 0, sizeof(m));
+    srand(41);
+
+    // each key holds a level for a random run, with bounces at the edges
+    uint32_t level = 0;
+    int run[32] = {0};
+    int mismatches = 0;
+    for (int i = 0; i < 200000; i++)
+    {
+        uint32_t raw = 0;
+        for (int k = 0; k < 32; k++)
+        {
+            if (--run[k] <= 0)
+            {
+                level ^= 1u << k;
+                run[k] = 1 + rand() % 20;
+            }
+            uint32_t bit = (level >> k) & 1u;
+            if (rand() % 8 == 0)
+                bit ^= 1u;
+            raw |= bit << k;
+        }
+
+        uint32_t before = db.state;
+        uint32_t changed = keypad_debounce_update(&db, raw);
+        model_update(&m, raw);
+
+        uint32_t expected = 0;
+        for (int k = 0; k < 32; k++)
+            expected |= (uint32_t)m.level[k] << k;
+        if (db.state != expected || changed != (before ^ db.state))
+            mismatches++;
+    }
+    CHECK(mismatches == 0);
+}
+
+static void test_cost(void)
+{
+    enum
+    {
+        ROUNDS = 1000000
+    };
+    KeypadDebounce db;
+    keypad_debounce_init(&db);
+    uint32_t raw = 0x00A5A5A5u;
+    uint32_t sink = 0;
+
+    double start = now_ns();
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        raw = raw * 1664525u + 1013904223u;
+        sink ^= keypad_debounce_update(&db, raw & 0x00FFFFFFu);
+    }
+    double ns = (now_ns() - start) / ROUNDS;
+    printf("  24 keys debounced in %.1f ns per scan on the host (%u)\n", ns, sink & 1u);
+}
+
+int main(void)
+{
+    test_traces();
+    test_parallel();
+    test_random();
+    test_cost();
+
+    return check_summary();
+}
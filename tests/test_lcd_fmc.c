@@ -0,0 +1,217 @@
+/**
+ * @file test_lcd_fmc.c
+ * @brief FMC display transport host test and fill benchmark
+ * @ingroup tests
+ *
+ * Runs the ST7789V driver over the FMC transport with a test double for the
+ * bus: every write cycle is decoded into command or data from the A16
+ * address bit and fed to a small panel model (CASET, RASET, RAMWR and
+ * COLMOD parameters) with a 240x320 framebuffer. Checks that 8-bit
+ * parameters reach the panel intact, that fills and RGB565 blocks land in
+ * the right window, and that reads go to the data address.
+ *
+ * The benchmark counts bus cycles for a full-screen fill and converts them
+ * to time with the board's clock setup: FMC at 240 MHz with the CubeMX
+ * timing (ADDSET 1 + DATAST 15 + 1 = 17 cycles per write), SPI4 at 96 MHz
+ * (PLL3Q 192 MHz / 2). SPI per-call overhead cannot be measured on the host
+ * and is taken as SPI_CALL_NS.
+ *
+ * Build and run:
+ *   gcc -O2 -DDISPLAY_BUS_FMC -I./include/drivers/display -I./include/board -o test_lcd_fmc \
+ *       tests/test_lcd_fmc.c drivers/display/LCD_Controller.c drivers/display/st7789v.c
+ *   ./test_lcd_fmc
+ */
+
+#include "st7789v.h"
+#include "test_check.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PANEL_W 240
+#define PANEL_H 320
+#define PIXELS (PANEL_W * PANEL_H)
+
+#define FMC_CYCLE_NS (17.0 * 1000.0 / 240.0) // 17 fmc_ker_ck cycles at 240 MHz
+#define SPI_BIT_NS (1000.0 / 96.0)           // SPI4 SCK at 96 MHz
+#define SPI_CALL_NS 1000.0                   // chip select, D/C and HAL_SPI_Transmit setup, estimated
+
+// panel model
+static uint16_t framebuffer[PIXELS];
+static uint8_t command;
+static uint8_t params[16];
+static int param_count;
+static uint16_t col0, col1, row0, row1, cur_x, cur_y;
+static bool in_ramwr;
+static uint8_t colmod;
+
+// bus statistics
+static unsigned long commands, data_writes, reads, stray_writes;
+
+void lcd_fmc_bus_write(uintptr_t address, uint16_t value)
+{
+    uintptr_t base = (uintptr_t)FMC_BANK1_REG;
+    if ((address & ~LCD_FMC_DATA_BIT) != base)
+    {
+        stray_writes++;
+        return;
+    }
+
+    if (!(address & LCD_FMC_DATA_BIT))
+    {
+        commands++;
+        command = (uint8_t)value;
+        param_count = 0;
+        in_ramwr = command == ST7789V_RAMWR;
+        if (in_ramwr)
+        {
+            cur_x = col0;
+            cur_y = row0;
+        }
+        return;
+    }
+
+    data_writes++;
+    if (in_ramwr)
+    {
+        if (cur_x < PANEL_W && cur_y < PANEL_H)
+            framebuffer[cur_y * PANEL_W + cur_x] = value;
+        if (++cur_x > col1)
+        {
+            cur_x = col0;
+            if (++cur_y > row1)
+                cur_y = row0;
+        }
+        return;
+    }
+
+    // parameters arrive on D[7:0]
+    if (param_count < (int)sizeof(params))
+        params[param_count++] = (uint8_t)value;
+    if (value > 0xFF)
+        stray_writes++;
+    if (command == ST7789V_CASET && param_count == 4)
+    {
+        col0 = (uint16_t)(params[0] << 8 | params[1]);
+        col1 = (uint16_t)(params[2] << 8 | params[3]);
+    }
+    else if (command == ST7789V_RASET && param_count == 4)
+    {
+        row0 = (uint16_t)(params[0] << 8 | params[1]);
+        row1 = (uint16_t)(params[2] << 8 | params[3]);
+    }
+    else if (command == ST7789V_COLMOD && param_count == 1)
+    {
+        colmod = params[0];
+    }
+}
+
+uint16_t lcd_fmc_bus_read(uintptr_t address)
+{
+    reads++;
+    return (address & LCD_FMC_DATA_BIT) ? 0x0085 : 0xDEAD;
+}
+
+static void reset_stats(void)
+{
+    commands = data_writes = reads = stray_writes = 0;
+}
+
+static bool rect_is(int x, int y, int w, int h, uint16_t colour)
+{
+    for (int row = y; row < y + h; row++)
+        for (int col = x; col < x + w; col++)
+            if (framebuffer[row * PANEL_W + col] != colour)
+                return false;
+    return true;
+}
+
+static void test_transport(const IDisplayDriver_t *drv)
+{
+    printf("Transport\n");
+    const ILCD_t *lcd = lcd_create_default();
+    CHECK(lcd == lcd_create_fmc());
+
+    // 8-bit parameters used to collapse to 0 or 1 with '&&'
+    drv->init();
+    CHECK(colmod == 0x05);
+    CHECK(stray_writes == 0);
+
+    reset_stats();
+    lcd->write_reg(ST7789V_CASET);
+    lcd->write_data8(0xAB);
+    CHECK(commands == 1 && data_writes == 1);
+    CHECK(params[0] == 0xAB);
+
+    reset_stats();
+    CHECK(lcd->read_data() == 0x0085);
+    CHECK(reads == 1);
+}
+
+static void test_drawing(const IDisplayDriver_t *drv)
+{
+    printf("Drawing through the panel model\n");
+    uint32_t bytes = lcd_get_tx_bytes();
+    reset_stats();
+    drv->fill(0x1234);
+    CHECK(rect_is(0, 0, PANEL_W, PANEL_H, 0x1234));
+    CHECK(commands == 3 && data_writes == 8 + PIXELS);
+    CHECK(lcd_get_tx_bytes() - bytes == 11 + 2 * PIXELS);
+
+    drv->fill_rect(10, 20, 30, 40, 0xF800);
+    CHECK(rect_is(10, 20, 30, 40, 0xF800));
+    CHECK(rect_is(0, 0, PANEL_W, 20, 0x1234));
+    CHECK(framebuffer[20 * PANEL_W + 9] == 0x1234 && framebuffer[20 * PANEL_W + 40] == 0x1234);
+
+    drv->draw_hline(0x07E0, 0, 100, PANEL_W);
+    CHECK(rect_is(0, 100, PANEL_W, 1, 0x07E0));
+    drv->draw_vline(0x001F, 200, 0, PANEL_H);
+    CHECK(rect_is(200, 0, 1, PANEL_H, 0x001F));
+
+    uint16_t block[8 * 4];
+    for (int i = 0; i < 8 * 4; i++)
+        block[i] = (uint16_t)(0xA000 + i);
+    drv->draw_rgb565(50, 60, 8, 4, block);
+    bool same = true;
+    for (int row = 0; row < 4; row++)
+        for (int col = 0; col < 8; col++)
+            same &= framebuffer[(60 + row) * PANEL_W + 50 + col] == block[row * 8 + col];
+    CHECK(same);
+
+    drv->draw_pixel(239, 319, 0xFFFF);
+    CHECK(framebuffer[PIXELS - 1] == 0xFFFF);
+    CHECK(stray_writes == 0);
+}
+
+static void benchmark(const IDisplayDriver_t *drv)
+{
+    printf("Full-screen fill, %d pixels\n", PIXELS);
+    reset_stats();
+    drv->fill(0x0000);
+    unsigned long cycles = commands + data_writes;
+
+    double fmc_ms = cycles * FMC_CYCLE_NS / 1e6;
+    // window setup is 6 SPI transactions of 1 or 4 bytes either way
+    double setup_ns = 6 * SPI_CALL_NS + 11 * 8 * SPI_BIT_NS;
+    double spi_wire_ns = 2.0 * PIXELS * 8 * SPI_BIT_NS;
+    double spi_pixel_ms = (setup_ns + spi_wire_ns + PIXELS * SPI_CALL_NS) / 1e6;
+    double spi_stream_ms = (setup_ns + spi_wire_ns + ((PIXELS + 255) / 256) * SPI_CALL_NS) / 1e6;
+
+    printf("  %-34s %8s %10s\n", "transport", "fill ms", "CPU busy");
+    printf("  %-34s %8.2f %10s\n", "SPI4, one transaction per pixel", spi_pixel_ms, "all");
+    printf("  %-34s %8.2f %10s\n", "SPI4, streamed (write_repeat)", spi_stream_ms, "all");
+    printf("  %-34s %8.2f %10s\n", "FMC, CPU stores", fmc_ms, "all");
+    printf("  %-34s %8.2f %10s\n", "FMC, MDMA", fmc_ms, "setup only");
+    printf("  %lu bus cycles, %.1f ns each; FMC fills %.1fx faster than streamed SPI\n", cycles, FMC_CYCLE_NS,
+           spi_stream_ms / fmc_ms);
+}
+
+int main(void)
+{
+    const IDisplayDriver_t *drv = st7789v_get_driver();
+    test_transport(drv);
+    test_drawing(drv);
+    benchmark(drv);
+
+    return check_summary();
+}
@@ -0,0 +1,371 @@
+/**
+ * @file test_memwrap.c
+ * @brief Allocation tracking host test
+ * @ingroup tests
+ *
+ * Builds memwrap with MEM_TRACKING on libc and drives it the way the UI
+ * does: pages that allocate their Page, state and buffers, pushed and
+ * popped many times with the screen's leak check after each pop. Checks
+ * that clean pages report zero leaks over the soak, that a page which
+ * forgets a buffer is reported with the right file, line and size, that
+ * per-file peaks follow the largest page, that mem_realloc() keeps the
+ * data, that random churn leaves the table consistent, that a full table
+ * degrades to untracked blocks, and that threads can allocate at once.
+ * Ends with the cost of a tracked allocation pair.
+ *
+ * Build and run:
+ *   gcc -O2 -pthread -DMEM_TRACKING -I./include/kernel -o test_memwrap tests/test_memwrap.c kernel/core/memwrap.c
+ *   ./test_memwrap
+ */
+
+#include "memwrap.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ===== PAGES ===== */
+
+// the shape of a UI page: a Page, its state, and buffers the state owns
+typedef struct
+{
+    char *lines[4];
+    size_t count;
+} FakeState;
+
+typedef struct
+{
+    const char *name;
+    FakeState *state;
+} FakePage;
+
+static int leak_line; // line of the allocation the leaky page forgets
+
+static FakePage *page_create(const char *name, size_t lines, size_t line_size)
+{
+    FakePage *page = mem_malloc(sizeof(FakePage));
+    FakeState *state = mem_calloc(1, sizeof(FakeState));
+    page->name = name;
+    page->state = state;
+    for (size_t i = 0; i < lines; i++)
+    {
+        state->lines[i] = mem_malloc(line_size);
+        memset(state->lines[i], 'a', line_size);
+    }
+    state->count = lines;
+    return page;
+}
+
+static void page_destroy(FakePage *page, bool leak)
+{
+    for (size_t i = 0; i < page->state->count; i++)
+    {
+        if (!(leak && i == 0))
+            mem_free(page->state->lines[i]);
+    }
+    mem_free(page->state);
+    mem_free(page);
+}
+
+static FakePage *leaky_create(void)
+{
+    FakePage *page = page_create("leaky", 2, 48);
+    // a buffer the destroy path never frees
+    mem_free(page->state->lines[0]);
+    leak_line = __LINE__ + 1;
+    page->state->lines[0] = mem_malloc(100);
+    return page;
+}
+
+// screen_push_page() and screen_pop_page() as far as tracking is concerned
+static int push_and_pop(FakePage *page, bool leak)
+{
+    uint32_t mark = mem_track_seq_of(page);
+    const char *name = page->name;
+    page_destroy(page, leak);
+    return mem_track_check_page(mark, name);
+}
+
+static void test_soak(void)
+{
+    printf("Page open/close soak\n");
+    MemTrackStats before, after;
+    mem_track_get_stats(&before);
+
+    int leaks = 0;
+    for (int i = 0; i < 5000; i++)
+    {
+        FakePage *outer = page_create("sms", 3, 64 + i % 32);
+        uint32_t outer_mark = mem_track_seq_of(outer);
+
+        // a child page opened and closed while the parent is on the stack
+        leaks += push_and_pop(page_create("details", 2, 200), false);
+
+        page_destroy(outer, false);
+        leaks += mem_track_check_page(outer_mark, "sms");
+    }
+    mem_track_get_stats(&after);
+    CHECK(leaks == 0);
+    CHECK(after.live_bytes == before.live_bytes);
+    CHECK(after.live_count == before.live_count);
+    CHECK(after.leak_checks == before.leak_checks + 10000);
+    CHECK(after.untracked == 0);
+
+    MemLeakReport report;
+    mem_track_get_leak_report(&report);
+    CHECK(report.count == 0);
+}
+
+static void test_leak_report(void)
+{
+    printf("Leak report\n");
+    // a block the parent keeps across the child's life is not the child's leak
+    char *kept = mem_malloc(32);
+
+    FakePage *page = leaky_create();
+    uint32_t mark = mem_track_seq_of(page);
+    char *during = mem_malloc(16); // freed by someone else before the pop
+    mem_free(during);
+    const char *name = page->name;
+    page_destroy(page, true);
+    CHECK(mem_track_check_page(mark, name) == 1);
+
+    MemLeakReport report;
+    mem_track_get_leak_report(&report);
+    CHECK(report.count == 1 && report.bytes == 100);
+    CHECK(strcmp(report.page, "leaky") == 0);
+    CHECK(strcmp(report.blocks[0].tag, "test_memwrap.c") == 0);
+    CHECK(report.blocks[0].line == leak_line);
+    CHECK(report.blocks[0].size == 100);
+
+    MemTrackStats stats;
+    mem_track_get_stats(&stats);
+    CHECK(stats.leaks == 1);
+
+    // the leaked block is still owned and can be found from the report mark
+    MemBlockInfo blocks[4];
+    uint32_t bytes;
+    CHECK(mem_track_leaks(report.blocks[0].seq, blocks, 4, &bytes) == 1 && bytes == 100);
+    mem_free(kept);
+}
+
+static void test_tags(void)
+{
+    printf("Per-file peaks\n");
+    mem_track_reset_peaks();
+    MemTagStats tags[MEM_TRACK_MAX_TAGS];
+    int n = mem_track_get_tags(tags, MEM_TRACK_MAX_TAGS);
+    CHECK(n == 1);
+    uint32_t base = tags[0].live_bytes; // the leaked 100 bytes
+    CHECK(tags[0].peak_bytes == base);
+
+    FakePage *big = page_create("big", 4, 1000);
+    page_destroy(big, false);
+    FakePage *small = page_create("small", 1, 10);
+
+    n = mem_track_get_tags(tags, MEM_TRACK_MAX_TAGS);
+    CHECK(n == 1);
+    CHECK(tags[0].peak_bytes == base + sizeof(FakePage) + sizeof(FakeState) + 4000);
+    CHECK(tags[0].live_bytes == base + sizeof(FakePage) + sizeof(FakeState) + 10);
+    page_destroy(small, false);
+
+    MemTrackStats stats;
+    mem_track_get_stats(&stats);
+    CHECK(stats.peak_bytes == tags[0].peak_bytes);
+}
+
+static void test_realloc(void)
+{
+    printf("Realloc keeps the data\n");
+    MemTrackStats before, after;
+    mem_track_get_stats(&before);
+
+    char *p = mem_realloc(NULL, 16);
+    CHECK(p != NULL);
+    for (int i = 0; i < 16; i++)
+        p[i] = (char)i;
+
+    // grow across many sizes so the block moves
+    for (size_t size = 32; size <= 64 * 1024; size *= 2)
+    {
+        p = mem_realloc(p, size);
+        CHECK(p != NULL);
+        int same = 1;
+        for (int i = 0; i < 16; i++)
+            same &= p[i] == (char)i;
+        CHECK(same);
+
+        MemTrackStats now;
+        mem_track_get_stats(&now);
+        CHECK(now.live_bytes == before.live_bytes + size);
+        CHECK(now.live_count == before.live_count + 1);
+    }
+
+    p = mem_realloc(p, 8);
+    CHECK(p && p[7] == 7);
+    CHECK(mem_realloc(p, 0) == NULL);
+    mem_track_get_stats(&after);
+    CHECK(after.live_bytes == before.live_bytes);
+    CHECK(after.live_count == before.live_count);
+}
+
+static void test_churn(void)
+{
+    printf("Random churn\n");
+    enum
+    {
+        LIVE = 150
+    };
+    void *blocks[LIVE] = {0};
+    size_t sizes[LIVE] = {0};
+    size_t expected = 0;
+    MemTrackStats base;
+    mem_track_get_stats(&base);
+    srand(42);
+
+    for (int i = 0; i < 200000; i++)
+    {
+        int k = rand() % LIVE;
+        if (blocks[k])
+        {
+            mem_free(blocks[k]);
+            expected -= sizes[k];
+            blocks[k] = NULL;
+        }
+        else
+        {
+            sizes[k] = 1 + (size_t)(rand() % 300);
+            blocks[k] = mem_malloc(sizes[k]);
+            expected += sizes[k];
+        }
+    }
+
+    MemTrackStats stats;
+    mem_track_get_stats(&stats);
+    CHECK(stats.live_bytes == base.live_bytes + expected);
+    CHECK(stats.untracked == 0);
+
+    // every live block is still findable, so the table chains are intact
+    int found = 0, live = 0;
+    for (int k = 0; k < LIVE; k++)
+    {
+        if (!blocks[k])
+            continue;
+        live++;
+        found += mem_track_seq_of(blocks[k]) != mem_track_mark();
+        mem_free(blocks[k]);
+    }
+    CHECK(found == live);
+    mem_track_get_stats(&stats);
+    CHECK(stats.live_bytes == base.live_bytes);
+}
+
+static void test_full_table(void)
+{
+    printf("Full table\n");
+    enum
+    {
+        COUNT = MEM_TRACK_MAX_ALLOCS + 40
+    };
+    static void *blocks[COUNT];
+    MemTrackStats base, stats;
+    mem_track_get_stats(&base);
+
+    for (int i = 0; i < COUNT; i++)
+        blocks[i] = mem_malloc(24);
+    mem_track_get_stats(&stats);
+    CHECK(stats.untracked > 0);
+    CHECK(stats.live_count + (stats.untracked - base.untracked) == base.live_count + COUNT);
+
+    // untracked blocks free like any other and leave the totals alone
+    for (int i = 0; i < COUNT; i++)
+        mem_free(blocks[i]);
+    mem_track_get_stats(&stats);
+    CHECK(stats.live_count == base.live_count);
+    CHECK(stats.live_bytes == base.live_bytes);
+}
+
+static void *thread_main(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < 20000; i++)
+    {
+        void *a = mem_malloc(32);
+        void *b = mem_calloc(4, 8);
+        a = mem_realloc(a, 96);
+        mem_free(b);
+        mem_free(a);
+    }
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    printf("Threads\n");
+    MemTrackStats before, after;
+    mem_track_get_stats(&before);
+
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++)
+        pthread_create(&threads[i], NULL, thread_main, NULL);
+    for (int i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+
+    mem_track_get_stats(&after);
+    CHECK(after.live_bytes == before.live_bytes);
+    CHECK(after.live_count == before.live_count);
+}
+
+static void test_cost(void)
+{
+    enum
+    {
+        ROUNDS = 1000000
+    };
+    void *held[64];
+    for (int i = 0; i < 64; i++)
+        held[i] = mem_malloc(40);
+
+    double start = now_ns();
+    for (int i = 0; i < ROUNDS; i++)
+        mem_free(mem_malloc(64));
+    double tracked_ns = (now_ns() - start) / ROUNDS;
+
+    // through a volatile so the compiler keeps the libc pair
+    void *volatile sink;
+    start = now_ns();
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        sink = mem_heap_malloc(64);
+        mem_heap_free(sink);
+    }
+    double raw_ns = (now_ns() - start) / ROUNDS;
+
+    for (int i = 0; i < 64; i++)
+        mem_free(held[i]);
+    printf("  malloc/free pair %.0f ns tracked, %.0f ns untracked, with 64 blocks live\n", tracked_ns, raw_ns);
+}
+
+int main(void)
+{
+    CHECK(mem_track_enabled());
+    test_soak();
+    test_leak_report();
+    test_tags();
+    test_realloc();
+    test_churn();
+    test_full_table();
+    test_threads();
+    test_cost();
+
+    return check_summary();
+}
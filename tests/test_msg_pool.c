@@ -0,0 +1,297 @@
+/**
+ * @file test_msg_pool.c
+ * @brief Message pool host test with threaded producers and consumers
+ * @ingroup tests
+ *
+ * Checks allocation, typed headers, reference counting, exhaustion and
+ * misuse counters on a single thread. Then runs producer threads that
+ * allocate, fill and post messages through bounded queues to consumer
+ * threads that verify the payload and release it, the same ownership
+ * handover the tasks use. Every fourth message is fanned out to both
+ * consumers with one extra reference, and consumers hold on to their last
+ * few messages so the pool runs dry and producers have to retry. At the end
+ * every block must be back in the pool with nothing released twice.
+ *
+ * Build and run:
+ *   gcc -O2 -pthread -I./include/kernel -o test_msg_pool tests/test_msg_pool.c kernel/core/msg_pool.c
+ *   ./test_msg_pool
+ */
+
+#include "msg_pool.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define PRODUCERS 4
+#define CONSUMERS 2
+#define MESSAGES_PER_PRODUCER 100000
+#define QUEUE_DEPTH 5 // same depth as the display task queue
+#define HELD 3        // messages each consumer keeps, like an overlay holding its SMS
+
+typedef struct
+{
+    uint8_t producer;
+    uint8_t fill;
+    uint16_t length;
+    uint32_t seq;
+    uint8_t bytes[MSG_POOL_PAYLOAD_SIZE - 8];
+} TestPayload;
+
+/* ===== BOUNDED POINTER QUEUE, STANDS IN FOR A FREERTOS QUEUE ===== */
+typedef struct
+{
+    void *items[QUEUE_DEPTH];
+    int head, count;
+    bool closed;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full;
+} TestQueue;
+
+static TestQueue queues[CONSUMERS];
+
+static void queue_init(TestQueue *q)
+{
+    memset(q, 0, sizeof(*q));
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+}
+
+static void queue_send(TestQueue *q, void *item)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->count == QUEUE_DEPTH)
+        pthread_cond_wait(&q->not_full, &q->lock);
+    q->items[(q->head + q->count++) % QUEUE_DEPTH] = item;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// NULL once the queue is closed and drained
+static void *queue_receive(TestQueue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !q->closed)
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    void *item = NULL;
+    if (q->count > 0)
+    {
+        item = q->items[q->head];
+        q->head = (q->head + 1) % QUEUE_DEPTH;
+        q->count--;
+        pthread_cond_signal(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return item;
+}
+
+static void queue_close(TestQueue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    q->closed = true;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ===== SINGLE-THREADED ===== */
+static void test_basics(void)
+{
+    printf("Allocation and reference counting\n");
+    msg_pool_init();
+    MsgPoolStats s;
+
+    uint8_t *value = msg_alloc(MSG_TYPE_U8, sizeof(uint8_t));
+    CHECK(value != NULL);
+    *value = 42;
+    CHECK(msg_pool_owns(value));
+    CHECK(msg_type(value) == MSG_TYPE_U8);
+    CHECK(msg_size(value) == 1);
+
+    // plain pointers and interior pointers are not messages
+    uint8_t local = 0;
+    CHECK(!msg_pool_owns(&local));
+    CHECK(!msg_pool_owns(NULL));
+    CHECK(!msg_pool_owns(value + 1));
+    CHECK(msg_type(&local) == MSG_TYPE_NONE);
+
+    msg_retain(value);
+    msg_release(value);
+    CHECK(msg_type(value) == MSG_TYPE_U8); // one reference left
+    msg_release(value);
+    CHECK(msg_type(value) == MSG_TYPE_NONE);
+
+    msg_release(value); // double release is counted, not corrupting
+    msg_release(&local);
+    msg_retain(value);
+    msg_pool_get_stats(&s);
+    CHECK(s.bad_releases == 3);
+    CHECK(s.in_use == 0 && s.allocs == 1 && s.releases == 1);
+
+    CHECK(msg_alloc(MSG_TYPE_U8, MSG_POOL_PAYLOAD_SIZE + 1) == NULL);
+    CHECK(msg_alloc(MSG_TYPE_NONE, 1) == NULL);
+    msg_pool_get_stats(&s);
+    CHECK(s.oversize == 2);
+
+    printf("Exhaustion\n");
+    void *held[MSG_POOL_BLOCKS];
+    for (int i = 0; i < MSG_POOL_BLOCKS; i++)
+    {
+        held[i] = msg_alloc(MSG_TYPE_USER, MSG_POOL_PAYLOAD_SIZE);
+        CHECK(held[i] != NULL);
+    }
+    CHECK(msg_alloc(MSG_TYPE_USER, 1) == NULL);
+    msg_pool_get_stats(&s);
+    CHECK(s.exhausted == 1);
+    CHECK(s.in_use == MSG_POOL_BLOCKS && s.high_water == MSG_POOL_BLOCKS);
+
+    // blocks do not overlap
+    for (int i = 0; i < MSG_POOL_BLOCKS; i++)
+        memset(held[i], i, MSG_POOL_PAYLOAD_SIZE);
+    bool intact = true;
+    for (int i = 0; i < MSG_POOL_BLOCKS; i++)
+        for (int b = 0; b < MSG_POOL_PAYLOAD_SIZE; b++)
+            intact &= ((uint8_t *)held[i])[b] == i;
+    CHECK(intact);
+
+    for (int i = 0; i < MSG_POOL_BLOCKS; i++)
+        msg_release(held[i]);
+    msg_pool_get_stats(&s);
+    CHECK(s.in_use == 0);
+    CHECK(msg_alloc(MSG_TYPE_USER, 1) != NULL);
+}
+
+/* ===== THREADED ===== */
+static unsigned long retries[PRODUCERS];
+static unsigned long received[CONSUMERS];
+static unsigned long corrupt[CONSUMERS];
+
+static void *producer(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    uint32_t rng = 0x9E3779B9u * (id + 1);
+
+    for (uint32_t seq = 0; seq < MESSAGES_PER_PRODUCER; seq++)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        uint16_t length = (uint16_t)(rng >> 16) % sizeof(((TestPayload *)0)->bytes);
+
+        TestPayload *msg;
+        while (!(msg = msg_alloc(MSG_TYPE_USER, MSG_POOL_PAYLOAD_SIZE)))
+        {
+            // pool exhausted: a task would drop the update or retry later
+            retries[id]++;
+            sched_yield();
+        }
+        msg->producer = (uint8_t)id;
+        msg->seq = seq;
+        msg->length = length;
+        msg->fill = (uint8_t)(seq ^ id);
+        memset(msg->bytes, msg->fill, length);
+
+        if (seq % 4 == 0)
+        {
+            // fan out: one reference per receiving queue
+            msg_retain(msg);
+            queue_send(&queues[0], msg);
+            queue_send(&queues[1], msg);
+        }
+        else
+        {
+            queue_send(&queues[seq % CONSUMERS], msg);
+        }
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    TestPayload *msg;
+    void *held[HELD] = {NULL};
+    unsigned long n = 0;
+    while ((msg = queue_receive(&queues[id])))
+    {
+        bool ok = msg_type(msg) == MSG_TYPE_USER && msg->producer < PRODUCERS &&
+                  msg->fill == (uint8_t)(msg->seq ^ msg->producer);
+        for (int i = 0; ok && i < msg->length; i++)
+            ok = msg->bytes[i] == msg->fill;
+        if (!ok)
+            corrupt[id]++;
+        received[id]++;
+
+        // keep this one, drop the oldest
+        msg_release(held[n % HELD]);
+        held[n++ % HELD] = msg;
+    }
+    for (int i = 0; i < HELD; i++)
+        msg_release(held[i]);
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    printf("%d producers, %d consumers, %d messages each, %d blocks\n", PRODUCERS, CONSUMERS,
+           MESSAGES_PER_PRODUCER, MSG_POOL_BLOCKS);
+    msg_pool_init();
+    for (int i = 0; i < CONSUMERS; i++)
+        queue_init(&queues[i]);
+
+    pthread_t producers[PRODUCERS], consumers[CONSUMERS];
+    double start = now_ns();
+    for (int i = 0; i < CONSUMERS; i++)
+        pthread_create(&consumers[i], NULL, consumer, (void *)(intptr_t)i);
+    for (int i = 0; i < PRODUCERS; i++)
+        pthread_create(&producers[i], NULL, producer, (void *)(intptr_t)i);
+    for (int i = 0; i < PRODUCERS; i++)
+        pthread_join(producers[i], NULL);
+    for (int i = 0; i < CONSUMERS; i++)
+        queue_close(&queues[i]);
+    for (int i = 0; i < CONSUMERS; i++)
+        pthread_join(consumers[i], NULL);
+    double elapsed = now_ns() - start;
+
+    unsigned long sent = (unsigned long)PRODUCERS * MESSAGES_PER_PRODUCER;
+    unsigned long fanned = (unsigned long)PRODUCERS * ((MESSAGES_PER_PRODUCER + 3) / 4);
+    unsigned long total_received = 0, total_corrupt = 0, total_retries = 0;
+    for (int i = 0; i < CONSUMERS; i++)
+    {
+        total_received += received[i];
+        total_corrupt += corrupt[i];
+    }
+    for (int i = 0; i < PRODUCERS; i++)
+        total_retries += retries[i];
+
+    MsgPoolStats s;
+    msg_pool_get_stats(&s);
+    CHECK(total_received == sent + fanned);
+    CHECK(total_corrupt == 0);
+    CHECK(s.allocs == sent && s.releases == sent);
+    CHECK(s.in_use == 0);
+    CHECK(s.bad_releases == 0);
+    CHECK(s.high_water == MSG_POOL_BLOCKS);
+    CHECK(s.exhausted > 0);
+
+    printf("  %lu deliveries in %.1f ms, %.0f ns each\n", total_received, elapsed / 1e6,
+           elapsed / total_received);
+    printf("  high water %u of %d blocks, %u exhausted allocations, %lu producer retries\n", s.high_water,
+           MSG_POOL_BLOCKS, s.exhausted, total_retries);
+    printf("  %zu bytes of payload handed over per message without a copy\n", sizeof(TestPayload));
+}
+
+int main(void)
+{
+    test_basics();
+    test_threads();
+
+    return check_summary();
+}
@@ -0,0 +1,202 @@
+/**
+ * @file test_profile.c
+ * @brief Profiling zone host test
+ * @ingroup tests
+ *
+ * Records known times into the zones and checks what the table makes of
+ * them: count, minimum, maximum and total, the histogram buckets and the
+ * percentiles read from them, and that out of range zones are ignored.
+ * Times a real zone with the macros. Several threads then record into one
+ * zone at once, and nothing may be lost without a lock. Checks the report's
+ * line count and width and its units, and prints it.
+ *
+ * Build and run:
+ *   gcc -O2 -pthread -DPROFILE_ENABLED -I./include/kernel -o test_profile tests/test_profile.c kernel/core/profile.c
+ *   ./test_profile
+ */
+
+#include "profile.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_LINES 16
+#define THREADS 4
+#define SAMPLES_PER_THREAD 100000
+
+typedef struct
+{
+    char lines[MAX_LINES][PROFILE_REPORT_LINE_MAX];
+    int count;
+} Report;
+
+static void collect(const char *line, void *arg)
+{
+    Report *report = (Report *)arg;
+    if (report->count < MAX_LINES)
+    {
+        snprintf(report->lines[report->count], PROFILE_REPORT_LINE_MAX, "%s", line);
+    }
+    report->count++;
+}
+
+static void test_record(void)
+{
+    printf("Record\n");
+    profile_init(1000000000u);
+
+    ProfileStats stats;
+    CHECK(profile_get(PROFILE_GLYPH, &stats));
+    CHECK(stats.count == 0 && stats.min == 0 && stats.max == 0 && stats.total == 0);
+    CHECK(profile_percentile(&stats, 50) == 0);
+
+    profile_record(PROFILE_GLYPH, 1000);
+    profile_record(PROFILE_GLYPH, 3000);
+    profile_record(PROFILE_GLYPH, 1);
+    profile_record(PROFILE_GLYPH, 0);
+    CHECK(profile_get(PROFILE_GLYPH, &stats));
+    CHECK(stats.count == 4 && stats.min == 0 && stats.max == 3000 && stats.total == 4001);
+    // 0 and 1 share the first bucket, 1000 is in [512, 1024), 3000 in [2048, 4096)
+    CHECK(stats.buckets[0] == 2 && stats.buckets[9] == 1 && stats.buckets[11] == 1);
+
+    // the median is the second sample, the top is held to the maximum
+    CHECK(profile_percentile(&stats, 50) == 1);
+    CHECK(profile_percentile(&stats, 75) == 1023);
+    CHECK(profile_percentile(&stats, 99) == 3000);
+    CHECK(profile_percentile(&stats, 100) == 3000);
+
+    // the total carries into its upper half
+    profile_record(PROFILE_PDU_DECODE, 0xF0000000u);
+    profile_record(PROFILE_PDU_DECODE, 0xF0000000u);
+    profile_record(PROFILE_PDU_DECODE, UINT32_MAX);
+    CHECK(profile_get(PROFILE_PDU_DECODE, &stats));
+    CHECK(stats.total == 2ull * 0xF0000000u + UINT32_MAX);
+    CHECK(stats.buckets[PROFILE_BUCKETS - 1] == 3 && stats.max == UINT32_MAX);
+    CHECK(profile_percentile(&stats, 50) == UINT32_MAX);
+
+    // out of range zones are ignored
+    profile_record(PROFILE_ZONE_COUNT, 5);
+    profile_record((ProfileZone)-1, 5);
+    CHECK(!profile_get(PROFILE_ZONE_COUNT, &stats));
+    CHECK(!profile_get(PROFILE_GLYPH, NULL));
+
+    CHECK(strcmp(profile_zone_name(PROFILE_DISPLAY_FLUSH), "flush") == 0);
+    CHECK(strcmp(profile_zone_name(PROFILE_ZONE_COUNT), "?") == 0);
+    CHECK(profile_clock_hz() == 1000000000u);
+
+    profile_reset();
+    CHECK(profile_get(PROFILE_GLYPH, &stats));
+    CHECK(stats.count == 0 && stats.min == 0 && stats.total == 0 && stats.buckets[0] == 0);
+    profile_record(PROFILE_GLYPH, 70);
+    CHECK(profile_get(PROFILE_GLYPH, &stats) && stats.min == 70 && stats.max == 70);
+}
+
+static volatile uint32_t sink;
+
+static void test_macros(void)
+{
+    printf("Macros\n");
+    profile_reset();
+    for (int pass = 0; pass < 10; pass++)
+    {
+        PROFILE_ZONE_BEGIN(PROFILE_BPTREE_FIND);
+        for (uint32_t i = 0; i < 10000; i++)
+        {
+            sink += i;
+        }
+        PROFILE_ZONE_END(PROFILE_BPTREE_FIND);
+    }
+
+    ProfileStats stats;
+    CHECK(profile_get(PROFILE_BPTREE_FIND, &stats));
+    CHECK(stats.count == 10 && stats.min > 0 && stats.min <= stats.max);
+    CHECK(stats.total >= (uint64_t)stats.min * 10 && stats.total <= (uint64_t)stats.max * 10);
+}
+
+static void *record_many(void *arg)
+{
+    uint32_t ticks = (uint32_t)(uintptr_t)arg;
+    for (int i = 0; i < SAMPLES_PER_THREAD; i++)
+    {
+        profile_record(PROFILE_AT_COMMAND, ticks);
+    }
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    printf("Concurrent\n");
+    profile_reset();
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++)
+    {
+        pthread_create(&threads[t], NULL, record_many, (void *)(uintptr_t)(100u << t));
+    }
+    for (int t = 0; t < THREADS; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+
+    ProfileStats stats;
+    CHECK(profile_get(PROFILE_AT_COMMAND, &stats));
+    CHECK(stats.count == THREADS * SAMPLES_PER_THREAD);
+    CHECK(stats.total == (uint64_t)SAMPLES_PER_THREAD * (100 + 200 + 400 + 800));
+    CHECK(stats.min == 100 && stats.max == 800);
+    uint32_t bucketed = 0;
+    for (int b = 0; b < PROFILE_BUCKETS; b++)
+    {
+        bucketed += stats.buckets[b];
+    }
+    CHECK(bucketed == stats.count);
+    CHECK(stats.buckets[6] == SAMPLES_PER_THREAD && stats.buckets[9] == SAMPLES_PER_THREAD);
+}
+
+static void test_report(void)
+{
+    printf("Report\n");
+    profile_init(1000000000u);
+    profile_record(PROFILE_DISPLAY_FLUSH, 2500000); // 2.5 ms
+    profile_record(PROFILE_DISPLAY_FLUSH, 3500000);
+    profile_record(PROFILE_GLYPH, 12300);           // 12.3 us
+    profile_record(PROFILE_AT_COMMAND, 450000000);  // 450 ms
+    for (int i = 0; i < 123456; i++)
+    {
+        profile_record(PROFILE_AUDIO_BUFFER, 900);
+    }
+
+    Report report = {0};
+    int lines = profile_report(collect, &report);
+    CHECK(lines == report.count && lines == PROFILE_ZONE_COUNT + 1);
+    for (int i = 0; i < report.count && i < MAX_LINES; i++)
+    {
+        CHECK(strlen(report.lines[i]) <= 40);
+        printf("  %s\n", report.lines[i]);
+    }
+
+    const char *flush = report.lines[1 + PROFILE_DISPLAY_FLUSH];
+    CHECK(strncmp(flush, "flush", 5) == 0);
+    CHECK(strstr(flush, " 2 ") != NULL && strstr(flush, " 2500 ") != NULL && strstr(flush, " 3000 ") != NULL);
+    CHECK(strstr(report.lines[1 + PROFILE_GLYPH], " 12.3 ") != NULL);
+    CHECK(strstr(report.lines[1 + PROFILE_AT_COMMAND], " 450m") != NULL);
+    CHECK(strstr(report.lines[1 + PROFILE_AUDIO_BUFFER], " 123k ") != NULL);
+    CHECK(strstr(report.lines[1 + PROFILE_AUDIO_BUFFER], " 0.9 ") != NULL);
+    CHECK(strstr(report.lines[1 + PROFILE_PDU_DECODE], "    0     -") != NULL);
+
+    // on the target the ticks are cycles
+    profile_init(550000000u);
+    profile_record(PROFILE_GLYPH, 5500);
+    memset(&report, 0, sizeof(report));
+    profile_report(collect, &report);
+    CHECK(strstr(report.lines[1 + PROFILE_GLYPH], " 10.0 ") != NULL);
+}
+
+int main(void)
+{
+    test_record();
+    test_macros();
+    test_concurrent();
+    test_report();
+
+    return check_summary();
+}
@@ -0,0 +1,250 @@
+/**
+ * @file test_sampler.c
+ * @brief PC sampler host test
+ * @ingroup tests
+ *
+ * Checks the sample ring in kernel/core/sampler.c through its dump: the
+ * header, samples oldest first across the ring's wrap, the count of
+ * samples lost to it, the trailer's checksum and a failing sink. There is
+ * no timer on the host, so sampler_start() must refuse and the samples
+ * are fed in with sampler_record() as the timer interrupt would.
+ *
+ * Given a file name, also writes a dump of made-up samples whose PCs lie
+ * in this program's own functions, for tools/sample_profile.py. Built
+ * without PIE, those addresses fit the dump's 32 bits and addr2line can
+ * name them.
+ *
+ * Build and run:
+ *   gcc -O2 -g -no-pie -fno-pie -I./include/kernel -o test_sampler tests/test_sampler.c kernel/core/sampler.c
+ *   ./test_sampler [samples.bin]
+ *   python3 tools/sample_profile.py samples.bin --elf test_sampler --addr2line addr2line
+ */
+
+#include "sampler.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DUMP_MAX (sizeof(SamplerDumpHeader) + SAMPLER_MAX_TASKS * sizeof(SamplerName) + \
+                  SAMPLER_RING_SIZE * sizeof(SamplerRecord) + 8)
+
+typedef struct
+{
+    uint8_t data[DUMP_MAX];
+    size_t len;
+    size_t fail_after; // bytes the sink takes before refusing, 0 for no limit
+} Buffer;
+
+typedef struct
+{
+    SamplerDumpHeader header;
+    const SamplerRecord *records;
+} Dump;
+
+static Buffer buffer;
+
+static bool buffer_write(const void *data, size_t len, void *arg)
+{
+    Buffer *b = (Buffer *)arg;
+    if (b->len + len > sizeof(b->data) || (b->fail_after && b->len + len > b->fail_after))
+    {
+        return false;
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+    return true;
+}
+
+// dump into the buffer and check the framing, false if it is malformed
+static bool take_dump(Dump *dump)
+{
+    memset(&buffer, 0, sizeof(buffer));
+    size_t bytes = sampler_dump(buffer_write, &buffer);
+    if (bytes != buffer.len || bytes < sizeof(SamplerDumpHeader) + 8)
+    {
+        return false;
+    }
+    memcpy(&dump->header, buffer.data, sizeof(dump->header));
+    const SamplerDumpHeader *h = &dump->header;
+    size_t body = sizeof(*h) + h->name_count * sizeof(SamplerName) + h->count * sizeof(SamplerRecord);
+    if (memcmp(h->magic, SAMPLER_DUMP_MAGIC, 4) != 0 || body + 8 != bytes ||
+        memcmp(buffer.data + body, SAMPLER_DUMP_END, 4) != 0)
+    {
+        return false;
+    }
+    uint32_t sum = 0, stored;
+    for (size_t i = 0; i < body; i++)
+    {
+        sum += buffer.data[i];
+    }
+    memcpy(&stored, buffer.data + body + 4, sizeof(stored));
+    if (sum != stored)
+    {
+        return false;
+    }
+    dump->records = (const SamplerRecord *)(buffer.data + sizeof(*h) + h->name_count * sizeof(SamplerName));
+    return true;
+}
+
+static void test_empty(void)
+{
+    printf("Empty\n");
+    sampler_init();
+
+    SamplerStats stats;
+    sampler_get_stats(&stats);
+    CHECK(stats.taken == 0 && stats.overwritten == 0 && stats.capacity == SAMPLER_RING_SIZE);
+    CHECK(!stats.running && stats.rate_hz == 0);
+
+    // no timer here
+    CHECK(!sampler_start(SAMPLER_DEFAULT_HZ));
+    sampler_get_stats(&stats);
+    CHECK(!stats.running);
+    sampler_stop();
+
+    Dump dump;
+    CHECK(take_dump(&dump));
+    CHECK(dump.header.version == SAMPLER_DUMP_VERSION);
+    CHECK(dump.header.record_size == sizeof(SamplerRecord) && sizeof(SamplerRecord) == 16);
+    CHECK(dump.header.name_size == sizeof(SamplerName) && sizeof(SamplerName) == 16);
+    CHECK(sizeof(SamplerDumpHeader) == 32);
+    CHECK(dump.header.capacity == SAMPLER_RING_SIZE);
+    CHECK(dump.header.taken == 0 && dump.header.count == 0 && dump.header.name_count == 0);
+}
+
+static void test_records(void)
+{
+    printf("Records\n");
+    sampler_init();
+    sampler_record(0x08001234, 0x08000101, 0x20001000, 0);
+    sampler_record(0x000000A0, 0x08000203, 0x20001000, 16 + 55);
+    sampler_record(0x08004000, 0xFFFFFFFD, 0, 0);
+
+    Dump dump;
+    CHECK(take_dump(&dump));
+    CHECK(dump.header.taken == 3 && dump.header.count == 3);
+    const SamplerRecord *r = dump.records;
+    CHECK(r[0].pc == 0x08001234 && r[0].lr == 0x08000101 && r[0].task == 0x20001000 && r[0].exception == 0);
+    CHECK(r[1].pc == 0x000000A0 && r[1].exception == 71);
+    CHECK(r[2].task == 0 && r[2].lr == 0xFFFFFFFD && r[2].reserved == 0);
+
+    // a sink that gives up fails the dump
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.fail_after = sizeof(SamplerDumpHeader) + 8;
+    CHECK(sampler_dump(buffer_write, &buffer) == 0);
+}
+
+static void test_wrap(void)
+{
+    printf("Wrap\n");
+    sampler_init();
+    const uint32_t extra = 37;
+    for (uint32_t i = 0; i < SAMPLER_RING_SIZE + extra; i++)
+    {
+        sampler_record(i, i + 1, 1, 0);
+    }
+
+    SamplerStats stats;
+    sampler_get_stats(&stats);
+    CHECK(stats.taken == SAMPLER_RING_SIZE + extra && stats.overwritten == extra);
+
+    Dump dump;
+    CHECK(take_dump(&dump));
+    CHECK(dump.header.taken == SAMPLER_RING_SIZE + extra && dump.header.count == SAMPLER_RING_SIZE);
+    // the oldest kept is the first not overwritten, and the rest follow in order
+    bool ordered = true;
+    for (uint32_t i = 0; i < SAMPLER_RING_SIZE; i++)
+    {
+        if (dump.records[i].pc != extra + i || dump.records[i].lr != extra + i + 1)
+        {
+            ordered = false;
+        }
+    }
+    CHECK(ordered);
+}
+
+/* ===== EXAMPLE DUMP ===== */
+
+static volatile uint32_t spin;
+
+__attribute__((noinline)) static void hal_busy_wait(void)
+{
+    for (int i = 0; i < 10; i++)
+    {
+        spin++;
+    }
+}
+
+__attribute__((noinline)) static void render_frame(void)
+{
+    spin += 3;
+    hal_busy_wait();
+}
+
+__attribute__((noinline)) static void decode_message(void)
+{
+    spin ^= 5;
+}
+
+// the address of a function, a few bytes into its body
+static uint32_t inside(void (*fn)(void))
+{
+    return (uint32_t)(uintptr_t)fn + 4;
+}
+
+static bool file_write(const void *data, size_t len, void *arg)
+{
+    return fwrite(data, 1, len, (FILE *)arg) == len;
+}
+
+static bool write_example(const char *path)
+{
+    if ((uintptr_t)&render_frame > UINT32_MAX)
+    {
+        printf("  functions above 4 GB, build with -no-pie for names\n");
+    }
+    sampler_init();
+    // a display task spending most of its time in a busy-wait, a modem task
+    // decoding, and an interrupt handler that was itself interrupted
+    for (int i = 0; i < 600; i++)
+    {
+        sampler_record(inside(hal_busy_wait), inside(render_frame) | 1, 0x20001000, 0);
+    }
+    for (int i = 0; i < 250; i++)
+    {
+        sampler_record(inside(render_frame), inside(render_frame) | 1, 0x20001000, 0);
+    }
+    for (int i = 0; i < 120; i++)
+    {
+        sampler_record(inside(decode_message), inside(decode_message) | 1, 0x20002000, 0);
+    }
+    for (int i = 0; i < 30; i++)
+    {
+        sampler_record(inside(hal_busy_wait), 0xFFFFFFF1, 0x20002000, 16 + 55);
+    }
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        return false;
+    }
+    size_t bytes = sampler_dump(file_write, f);
+    fclose(f);
+    printf("  wrote %zu bytes to %s\n", bytes, path);
+    render_frame();
+    decode_message();
+    return bytes > 0;
+}
+
+int main(int argc, char **argv)
+{
+    test_empty();
+    test_records();
+    test_wrap();
+    if (argc > 1)
+    {
+        CHECK(write_example(argv[1]));
+    }
+
+    return check_summary();
+}
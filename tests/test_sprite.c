@@ -0,0 +1,413 @@
+/**
+ * @file test_sprite.c
+ * @brief Sprite blitter host test and bytes-per-frame benchmark
+ * @ingroup tests
+ *
+ * Renders into a host framebuffer through a fake panel that charges bytes
+ * the way the ST7789V driver does: 11 bytes to open a window (CASET, RASET,
+ * RAMWR) plus 2 bytes per pixel, so a single pixel costs 13 bytes.
+ *
+ * Checks clipping and colour keying, that composing a sweeper cell with
+ * sprites gives the same pixels as the old rect and per-pixel bitmap
+ * drawing, and that dirty tiles from sprite_place() erase every old
+ * position of a sprite sliding across tile boundaries. Then reports panel
+ * bytes per frame for each moving sprite, old approach against sprites.
+ *
+ * Build and run:
+ *   gcc -O2 -I./include/ui -o test_sprite tests/test_sprite.c ui/sprite.c \
+ *       ui/game_sprites.c ui/tile.c
+ *   ./test_sprite
+ */
+
+#include "sprite.h"
+#include "game_sprites.h"
+#include "tile.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FB_W 240
+#define FB_H 320
+#define WINDOW_BYTES 11
+
+#define BG 0x0000
+#define BORDER 0x7BEF
+#define INK 0xFFFF
+#define CURSOR 0x07E0
+#define BODY 0x001F
+
+static uint16_t fb[FB_H][FB_W];
+static uint16_t ideal[FB_H][FB_W];
+static unsigned long panel_bytes;
+
+/* ---------- fake panel, same cost model as st7789v.c ---------- */
+
+static void panel_fill_rect(int x, int y, int w, int h, uint16_t colour)
+{
+    panel_bytes += WINDOW_BYTES + 2UL * w * h;
+    for (int r = y; r < y + h; r++)
+        for (int c = x; c < x + w; c++)
+            fb[r][c] = colour;
+}
+
+static void panel_pixel(int x, int y, uint16_t colour)
+{
+    panel_bytes += WINDOW_BYTES + 2;
+    fb[y][x] = colour;
+}
+
+static void panel_draw_rect(int x, int y, int w, int h, uint16_t colour)
+{
+    panel_fill_rect(x, y, w, 1, colour);
+    panel_fill_rect(x, y + h - 1, w, 1, colour);
+    panel_fill_rect(x, y, 1, h, colour);
+    panel_fill_rect(x + w - 1, y, 1, h, colour);
+}
+
+// old display_draw_bits: every pixel written on its own, key pixels in the background colour
+static void panel_draw_bits(int x, int y, const Sprite *mask, uint16_t colour, uint16_t bg)
+{
+    for (int r = 0; r < mask->height; r++)
+        for (int c = 0; c < mask->width; c++)
+            panel_pixel(x + c, y + r, mask->pixels[r * mask->width + c] != SPRITE_KEY ? colour : bg);
+}
+
+static void panel_flush(const SpriteCanvas *canvas)
+{
+    panel_bytes += WINDOW_BYTES + 2UL * canvas->width * canvas->height;
+    for (int r = 0; r < canvas->height; r++)
+        memcpy(&fb[canvas->y + r][canvas->x], &canvas->pixels[r * canvas->width], canvas->width * 2);
+}
+
+/* ---------- blitter basics ---------- */
+
+static void test_blit_clip_and_key(void)
+{
+    static SpriteCanvas canvas;
+    uint16_t px[4 * 3] = {
+        1, SPRITE_KEY, 3, 4,
+        5, 6, SPRITE_KEY, 8,
+        9, 10, 11, 12,
+    };
+    Sprite s = {4, 3, px};
+
+    sprite_canvas_begin(&canvas, 100, 100, 3, 2, 0xAAAA);
+    sprite_blit(&canvas, &s, 98, 99);
+    // only sprite columns 2-3, rows 1-2 land on canvas columns 0-1, rows 0-1
+    CHECK(canvas.pixels[0] == 0xAAAA); // key pixel at sprite (2, 1)
+    CHECK(canvas.pixels[1] == 8);
+    CHECK(canvas.pixels[2] == 0xAAAA);
+    CHECK(canvas.pixels[3] == 11);
+    CHECK(canvas.pixels[4] == 12);
+    CHECK(canvas.pixels[5] == 0xAAAA);
+
+    sprite_canvas_begin(&canvas, 0, 0, 3, 2, 0);
+    sprite_blit_tinted(&canvas, &s, 0, 0, 0x1234);
+    CHECK(canvas.pixels[0] == 0x1234 && canvas.pixels[1] == 0 && canvas.pixels[2] == 0x1234);
+
+    // fully outside: untouched
+    sprite_canvas_begin(&canvas, 0, 0, 3, 2, 7);
+    sprite_blit(&canvas, &s, 3, 0);
+    sprite_blit(&canvas, &s, -4, 0);
+    sprite_blit(&canvas, &s, 0, 2);
+    int untouched = 1;
+    for (int i = 0; i < 6; i++)
+        untouched &= canvas.pixels[i] == 7;
+    CHECK(untouched);
+
+    // oversized regions are clamped to the buffer
+    sprite_canvas_begin(&canvas, 0, 0, 1000, 1000, 0);
+    CHECK(canvas.width * canvas.height <= SPRITE_CANVAS_PIXELS);
+
+    SpriteInstance inst = {&s, 10, 10};
+    sprite_canvas_begin(&canvas, 13, 12, 5, 5, 0);
+    CHECK(sprite_overlaps(&canvas, &inst));
+    inst.x = 18;
+    CHECK(!sprite_overlaps(&canvas, &inst));
+}
+
+static void clear_dirty(void)
+{
+    for (int y = 0; y < TILE_ROWS; y++)
+        for (int x = 0; x < TILE_COLS; x++)
+            mark_tile_clean(x, y);
+}
+
+static int draws;
+static void count_tile(Page *self, int tx, int ty)
+{
+    (void)self;
+    (void)tx;
+    (void)ty;
+    draws++;
+}
+
+static void test_mark_rect(void)
+{
+    Page counter = {0};
+    counter.draw_tile = count_tile;
+    clear_dirty();
+
+    // straddles four tiles
+    sprite_mark_rect(25, NAVBAR_HEIGHT + 25, 10, 10);
+    draws = 0;
+    flush_dirty_tiles(&counter);
+    CHECK(draws == 4);
+
+    // exactly one tile
+    sprite_mark_rect(30, NAVBAR_HEIGHT + 30, TILE_WIDTH, TILE_HEIGHT);
+    draws = 0;
+    flush_dirty_tiles(&counter);
+    CHECK(draws == 1);
+
+    // partly off screen and in the navbar: clipped, not wrapped
+    sprite_mark_rect(-20, 0, 30, 30);
+    draws = 0;
+    flush_dirty_tiles(&counter);
+    CHECK(draws == 1);
+
+    SpriteInstance inst = {0};
+    sprite_place(&inst, &game_sprites[GAME_SPRITES_FLAG], 5, NAVBAR_HEIGHT + 5);
+    draws = 0;
+    flush_dirty_tiles(&counter);
+    CHECK(draws == 1);
+    sprite_place(&inst, &game_sprites[GAME_SPRITES_FLAG], 5, NAVBAR_HEIGHT + 5);
+    draws = 0;
+    flush_dirty_tiles(&counter);
+    CHECK(draws == 0);
+    sprite_place(&inst, &game_sprites[GAME_SPRITES_FLAG], 35, NAVBAR_HEIGHT + 5);
+    draws = 0;
+    flush_dirty_tiles(&counter);
+    CHECK(draws == 2);
+}
+
+/* ---------- sweeper cursor over flagged cells ---------- */
+
+static int cursor_x;
+
+/*
+ * The pre-sprite sweeper tile: border rect, inner fill, per-pixel flag and
+ * two cursor rects. The old flag branch skipped the inner fill and left the
+ * inner cursor ring behind, the fill is counted here so both paths produce
+ * the same pixels.
+ */
+static void legacy_sweeper_tile(Page *self, int tx, int ty)
+{
+    (void)self;
+    int px, py;
+    tile_to_pixels(tx, ty, &px, &py);
+    panel_draw_rect(px, py, TILE_WIDTH, TILE_HEIGHT, BORDER);
+    panel_fill_rect(px + 1, py + 1, TILE_WIDTH - 2, TILE_HEIGHT - 2, BG);
+    panel_draw_bits(px + 5, py + 5, &game_sprites[GAME_SPRITES_FLAG], INK, BG);
+    if (tx == cursor_x && ty == 0)
+    {
+        panel_draw_rect(px, py, TILE_WIDTH, TILE_HEIGHT, CURSOR);
+        panel_draw_rect(px + 1, py + 1, TILE_WIDTH - 2, TILE_HEIGHT - 2, CURSOR);
+    }
+}
+
+static SpriteInstance cursor_sprite;
+
+static void sprite_sweeper_tile(Page *self, int tx, int ty)
+{
+    (void)self;
+    static SpriteCanvas canvas;
+    int px, py;
+    tile_to_pixels(tx, ty, &px, &py);
+    sprite_canvas_begin_tile(&canvas, tx, ty, BG);
+    sprite_canvas_draw_rect(&canvas, px, py, TILE_WIDTH, TILE_HEIGHT, BORDER);
+    sprite_blit_tinted(&canvas, &game_sprites[GAME_SPRITES_FLAG], px + 5, py + 5, INK);
+    if (sprite_overlaps(&canvas, &cursor_sprite))
+        sprite_blit_tinted(&canvas, cursor_sprite.sprite, cursor_sprite.x, cursor_sprite.y, CURSOR);
+    panel_flush(&canvas);
+}
+
+static void test_sweeper_cursor(unsigned long *legacy_bytes, unsigned long *sprite_bytes)
+{
+    static uint16_t legacy_fb[FB_H][FB_W];
+    Page legacy = {0}, sprites = {0};
+    legacy.draw_tile = legacy_sweeper_tile;
+    sprites.draw_tile = sprite_sweeper_tile;
+    int moves = 0;
+    int px, py;
+
+    // first row of flagged cells, cursor walks left to right
+    memset(fb, 0, sizeof(fb));
+    cursor_x = 0;
+    for (int tx = 0; tx < TILE_COLS; tx++)
+        mark_tile_dirty(tx, 0);
+    flush_dirty_tiles(&legacy);
+    panel_bytes = 0;
+    for (cursor_x = 1; cursor_x < TILE_COLS; cursor_x++, moves++)
+    {
+        mark_tile_dirty(cursor_x - 1, 0);
+        mark_tile_dirty(cursor_x, 0);
+        flush_dirty_tiles(&legacy);
+    }
+    *legacy_bytes = panel_bytes / moves;
+    memcpy(legacy_fb, fb, sizeof(fb));
+
+    memset(fb, 0, sizeof(fb));
+    memset(&cursor_sprite, 0, sizeof(cursor_sprite));
+    tile_to_pixels(0, 0, &px, &py);
+    sprite_place(&cursor_sprite, &game_sprites[GAME_SPRITES_CURSOR], px, py);
+    for (int tx = 0; tx < TILE_COLS; tx++)
+        mark_tile_dirty(tx, 0);
+    flush_dirty_tiles(&sprites);
+    panel_bytes = 0;
+    for (int tx = 1; tx < TILE_COLS; tx++)
+    {
+        tile_to_pixels(tx, 0, &px, &py);
+        sprite_place(&cursor_sprite, &game_sprites[GAME_SPRITES_CURSOR], px, py);
+        flush_dirty_tiles(&sprites);
+    }
+    *sprite_bytes = panel_bytes / moves;
+
+    CHECK(memcmp(legacy_fb, fb, sizeof(fb)) == 0);
+}
+
+/* ---------- snake head ---------- */
+
+static int head_x;
+
+// what a head with eyes costs with today's primitives: erase the old cell, per-pixel mask for the new one
+static void legacy_snake_frame(int old_x, int new_x)
+{
+    int px, py;
+    tile_to_pixels(old_x, 4, &px, &py);
+    panel_fill_rect(px, py, TILE_WIDTH, TILE_HEIGHT, BODY);
+    tile_to_pixels(new_x, 4, &px, &py);
+    panel_draw_bits(px, py, &game_sprites[GAME_SPRITES_SNAKE_HEAD_RIGHT], BODY, BG);
+}
+
+static SpriteInstance head;
+
+static void sprite_snake_tile(Page *self, int tx, int ty)
+{
+    (void)self;
+    static SpriteCanvas canvas;
+    bool is_head = (tx == head_x && ty == 4);
+    bool body = (ty == 4 && tx < head_x);
+    sprite_canvas_begin_tile(&canvas, tx, ty, body ? BODY : BG);
+    if (is_head && sprite_overlaps(&canvas, &head))
+        sprite_blit_tinted(&canvas, head.sprite, head.x, head.y, BODY);
+    panel_flush(&canvas);
+}
+
+static void test_snake_head(unsigned long *legacy_bytes, unsigned long *sprite_bytes)
+{
+    Page page = {0};
+    page.draw_tile = sprite_snake_tile;
+    int moves = 0;
+    int px, py;
+
+    panel_bytes = 0;
+    for (int x = 1; x < TILE_COLS; x++, moves++)
+        legacy_snake_frame(x - 1, x);
+    *legacy_bytes = panel_bytes / moves;
+
+    memset(&head, 0, sizeof(head));
+    head_x = 0;
+    tile_to_pixels(0, 4, &px, &py);
+    sprite_place(&head, &game_sprites[GAME_SPRITES_SNAKE_HEAD_RIGHT], px, py);
+    flush_dirty_tiles(&page);
+    panel_bytes = 0;
+    for (head_x = 1; head_x < TILE_COLS; head_x++)
+    {
+        tile_to_pixels(head_x, 4, &px, &py);
+        sprite_place(&head, &game_sprites[GAME_SPRITES_SNAKE_HEAD_RIGHT], px, py);
+        flush_dirty_tiles(&page);
+    }
+    *sprite_bytes = panel_bytes / moves;
+
+    // eyes are background, the rest of the head body colour
+    const Sprite *s = &game_sprites[GAME_SPRITES_SNAKE_HEAD_RIGHT];
+    tile_to_pixels(TILE_COLS - 1, 4, &px, &py);
+    int wrong = 0;
+    for (int r = 0; r < s->height; r++)
+        for (int c = 0; c < s->width; c++)
+            wrong += fb[py + r][px + c] != (s->pixels[r * s->width + c] != SPRITE_KEY ? BODY : BG);
+    CHECK(wrong == 0);
+}
+
+/* ---------- free-moving sprite crossing tile boundaries ---------- */
+
+static SpriteInstance slider;
+
+static void slider_tile(Page *self, int tx, int ty)
+{
+    (void)self;
+    static SpriteCanvas canvas;
+    sprite_canvas_begin_tile(&canvas, tx, ty, BG);
+    if (sprite_overlaps(&canvas, &slider))
+        sprite_blit_tinted(&canvas, slider.sprite, slider.x, slider.y, INK);
+    panel_flush(&canvas);
+}
+
+static void test_sliding_sprite(unsigned long *legacy_bytes, unsigned long *sprite_bytes)
+{
+    const Sprite *s = &game_sprites[GAME_SPRITES_MINE];
+    Page page = {0};
+    page.draw_tile = slider_tile;
+    int frames = 0, stale = 0;
+    int x = 0, y = NAVBAR_HEIGHT;
+
+    // old way: erase the previous rect, then per-pixel bitmap at the new spot
+    panel_bytes = 0;
+    for (int i = 1; i < 60; i++)
+    {
+        panel_fill_rect(x, y, s->width, s->height, BG);
+        x = i * 3;
+        y = NAVBAR_HEIGHT + i * 4;
+        panel_draw_bits(x, y, s, INK, BG);
+        frames++;
+    }
+    *legacy_bytes = panel_bytes / frames;
+
+    memset(fb, 0, sizeof(fb));
+    memset(&slider, 0, sizeof(slider));
+    mark_all_tiles_dirty();
+    flush_dirty_tiles(&page);
+    panel_bytes = 0;
+    for (int i = 0; i < 60; i++)
+    {
+        x = i * 3;
+        y = NAVBAR_HEIGHT + i * 4;
+        sprite_place(&slider, s, x, y);
+        flush_dirty_tiles(&page);
+
+        // nothing left behind: the screen matches a fresh render of the sprite alone
+        memset(ideal, 0, sizeof(ideal));
+        for (int r = 0; r < s->height; r++)
+            for (int c = 0; c < s->width; c++)
+                if (s->pixels[r * s->width + c] != SPRITE_KEY)
+                    ideal[y + r][x + c] = INK;
+        if (memcmp(ideal, fb, sizeof(fb)) != 0)
+            stale++;
+    }
+    *sprite_bytes = panel_bytes / 60;
+    CHECK(stale == 0);
+}
+
+int main(void)
+{
+    unsigned long legacy, sprite;
+
+    test_blit_clip_and_key();
+    test_mark_rect();
+
+    test_sweeper_cursor(&legacy, &sprite);
+    printf("sweeper cursor over flags: %lu bytes/frame before, %lu with sprites\n", legacy, sprite);
+    CHECK(sprite < legacy);
+
+    test_snake_head(&legacy, &sprite);
+    printf("snake head with eyes:      %lu bytes/frame before, %lu with sprites\n", legacy, sprite);
+    CHECK(sprite < legacy);
+
+    test_sliding_sprite(&legacy, &sprite);
+    printf("20x20 sprite sliding 3,4 px: %lu bytes/frame before, %lu with sprites\n", legacy, sprite);
+    CHECK(sprite < legacy);
+
+    return check_summary();
+}
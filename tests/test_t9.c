@@ -0,0 +1,284 @@
+/**
+ * @file test_t9.c
+ * @brief T9 dictionary host test and benchmark
+ * @ingroup tests
+ *
+ * Types every word of the list a dictionary was compiled from, digit by
+ * digit, and checks the candidates after each keypress against the list:
+ * the most frequent words for a complete sequence in order, otherwise the
+ * start of the most frequent word it leads to. Also checks that dead ends
+ * are refused, that deleting digits restores the earlier candidates, the
+ * reads per keypress and the packed size. Reports reads and time per
+ * keypress, node cache hit rate, and how often the intended word is the
+ * first candidate or reachable by cycling.
+ *
+ * Build and run:
+ *   python3 tools/t9_dict.py --synthetic 50000 /tmp/t9.dict --list /tmp/t9.words
+ *   gcc -O2 -I./include/ui -o test_t9 tests/test_t9.c ui/t9.c
+ *   ./test_t9 /tmp/t9.dict /tmp/t9.words
+ */
+
+#include "t9.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// the 50k synthetic list packs to about 12.4 bytes per word
+#define MAX_BYTES_PER_WORD 16
+#define MAX_REPORTED 5
+
+typedef struct
+{
+    char word[T9_MAX_DEPTH + 1];
+    char digits[T9_MAX_DEPTH + 1];
+    unsigned long freq;
+} Entry;
+
+static const char *letter_digits = "22233344455566677778889999";
+static int mismatches;
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// by digit sequence, then the order the dictionary ranks words in
+static int compare_entries(const void *a, const void *b)
+{
+    const Entry *x = a, *y = b;
+    int c = strcmp(x->digits, y->digits);
+    if (c)
+        return c;
+    if (x->freq != y->freq)
+        return x->freq > y->freq ? -1 : 1;
+    return strcmp(x->word, y->word);
+}
+
+static bool ranks_before(const Entry *x, const Entry *y)
+{
+    return x->freq != y->freq ? x->freq > y->freq : strcmp(x->word, y->word) < 0;
+}
+
+static Entry *load_list(const char *path, size_t *count)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return NULL;
+    size_t capacity = 1024, n = 0;
+    Entry *entries = malloc(capacity * sizeof(Entry));
+    char word[64];
+    unsigned long freq;
+    while (fscanf(f, "%63s %lu", word, &freq) == 2)
+    {
+        if (strlen(word) > T9_MAX_DEPTH)
+            continue;
+        if (n == capacity)
+        {
+            capacity *= 2;
+            entries = realloc(entries, capacity * sizeof(Entry));
+        }
+        strcpy(entries[n].word, word);
+        for (int i = 0; word[i]; i++)
+            entries[n].digits[i] = letter_digits[word[i] - 'a'];
+        entries[n].digits[strlen(word)] = '\0';
+        entries[n].freq = freq;
+        n++;
+    }
+    fclose(f);
+    qsort(entries, n, sizeof(Entry), compare_entries);
+    *count = n;
+    return entries;
+}
+
+static void mismatch(const Entry *e, int depth, const char *what)
+{
+    if (mismatches++ < MAX_REPORTED)
+        printf("  FAIL typing %s, after %.*s: %s\n", e->word, depth, e->digits, what);
+}
+
+// candidates for the first depth digits of entries[w], whose prefix range is [lo, hi)
+static void check_candidates(const T9Context *ctx, const Entry *entries, size_t w, size_t lo, size_t hi, int depth)
+{
+    size_t exact = lo;
+    while (exact < hi && entries[exact].digits[depth] == '\0')
+        exact++;
+
+    if (exact > lo)
+    {
+        size_t expected = exact - lo < T9_MAX_CANDIDATES ? exact - lo : T9_MAX_CANDIDATES;
+        if (ctx->completion || ctx->candidate_count != expected)
+        {
+            mismatch(&entries[w], depth, "wrong candidate count");
+            return;
+        }
+        for (size_t i = 0; i < expected; i++)
+        {
+            if (strcmp(ctx->candidates[i], entries[lo + i].word) != 0)
+            {
+                mismatch(&entries[w], depth, "candidates out of frequency order");
+                return;
+            }
+        }
+        return;
+    }
+
+    const Entry *best = &entries[lo];
+    for (size_t i = lo + 1; i < hi; i++)
+    {
+        if (ranks_before(&entries[i], best))
+            best = &entries[i];
+    }
+    if (!ctx->completion || ctx->candidate_count != 1 || strncmp(ctx->candidates[0], best->word, depth) != 0 ||
+        ctx->candidates[0][depth] != '\0')
+        mismatch(&entries[w], depth, "completion is not the start of the most frequent word");
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <t9.dict> <word list>\n", argv[0]);
+        return 1;
+    }
+
+    size_t count = 0;
+    Entry *entries = load_list(argv[2], &count);
+    if (!entries || count == 0)
+    {
+        printf("cannot read word list %s\n", argv[2]);
+        return 1;
+    }
+
+    static T9Context ctx;
+    CHECK(!t9_open(&ctx, "/nonexistent/t9.dict"));
+    if (!t9_open(&ctx, argv[1]))
+    {
+        printf("not a T9 dictionary: %s\n", argv[1]);
+        return 1;
+    }
+
+    // nothing typed yet, and keys without letters never match
+    CHECK(t9_current(&ctx) == NULL);
+    CHECK(t9_next_candidate(&ctx) == NULL);
+    CHECK(!t9_pop_digit(&ctx));
+    CHECK(!t9_push_digit(&ctx, '1'));
+    CHECK(!t9_push_digit(&ctx, '0'));
+    CHECK(ctx.depth == 0);
+
+    FILE *f = fopen(argv[1], "rb");
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    printf("dictionary: %zu words, %ld bytes, %.1f bytes per word\n", count, size, (double)size / count);
+    CHECK(size < (long)count * MAX_BYTES_PER_WORD);
+
+    // words are visited in digit order, so the prefix ranges only move forward
+    size_t range_lo[T9_MAX_DEPTH + 1] = {0}, range_hi[T9_MAX_DEPTH + 1] = {0};
+    char shown[T9_MAX_DEPTH + 1][T9_MAX_DEPTH + 1];
+    unsigned long keypresses = 0, first = 0, cycled = 0, beyond = 0, crowded = 0, missing = 0, dead_ends = 0;
+    uint32_t worst_reads = 0;
+    double elapsed = 0;
+
+    for (size_t w = 0; w < count; w++)
+    {
+        const Entry *e = &entries[w];
+        int len = (int)strlen(e->digits);
+
+        t9_reset(&ctx);
+        bool ok = true;
+        for (int d = 1; d <= len; d++)
+        {
+            uint32_t before = ctx.reads;
+            double start = now_us();
+            ok = t9_push_digit(&ctx, e->digits[d - 1]);
+            elapsed += now_us() - start;
+            keypresses++;
+            if (ctx.reads - before > worst_reads)
+                worst_reads = ctx.reads - before;
+            if (!ok)
+                break;
+
+            if (w >= range_hi[d] || strncmp(entries[range_lo[d]].digits, e->digits, d) != 0)
+            {
+                range_lo[d] = w;
+                range_hi[d] = w + 1;
+                while (range_hi[d] < count && strncmp(entries[range_hi[d]].digits, e->digits, d) == 0)
+                    range_hi[d]++;
+            }
+            check_candidates(&ctx, entries, w, range_lo[d], range_hi[d], d);
+            strcpy(shown[d], t9_current(&ctx) ? t9_current(&ctx) : "");
+        }
+        if (!ok)
+        {
+            missing++;
+            continue;
+        }
+
+        // the range for the whole sequence starts with the words that end there
+        if (w - range_lo[len] >= T9_MAX_CANDIDATES)
+            crowded++;
+        if (strcmp(t9_current(&ctx), e->word) == 0)
+        {
+            first++;
+        }
+        else
+        {
+            int i = 1;
+            while (i < ctx.candidate_count && strcmp(t9_next_candidate(&ctx), e->word) != 0)
+                i++;
+            if (i < ctx.candidate_count)
+                cycled++;
+            else
+                beyond++;
+        }
+
+        // a digit no listed word continues with is refused and leaves the word as it was
+        for (char digit = '2'; len < T9_MAX_DEPTH && digit <= '9'; digit++)
+        {
+            bool continues = false;
+            for (size_t i = range_lo[len]; i < range_hi[len] && !continues; i++)
+                continues = entries[i].digits[len] == digit;
+            if (continues)
+                continue;
+            const char *before = t9_current(&ctx);
+            if (t9_push_digit(&ctx, digit) || ctx.depth != len || t9_current(&ctx) != before)
+                mismatch(e, len, "dead end accepted");
+            dead_ends++;
+            break;
+        }
+
+        // deleting digits shows what was shown on the way in
+        for (int d = len - 1; d >= 1; d--)
+        {
+            if (!t9_pop_digit(&ctx) || ctx.depth != d || strcmp(t9_current(&ctx), shown[d]) != 0)
+            {
+                mismatch(e, d, "delete did not restore the earlier candidate");
+                break;
+            }
+        }
+    }
+
+    printf("typed %zu words, %lu keypresses, %lu dead ends tried\n", count, keypresses, dead_ends);
+    printf("reads per keypress: %.2f avg, %lu worst\n", (double)ctx.reads / keypresses, (unsigned long)worst_reads);
+    printf("node cache hit rate: %.1f%%\n", 100.0 * ctx.cache_hits / (ctx.cache_hits + ctx.cache_misses));
+    printf("time per keypress: %.2f us (host)\n", elapsed / keypresses);
+    printf("first candidate: %.1f%%, found by cycling: %.1f%%, beyond %d candidates: %lu, missing: %lu\n",
+           100.0 * first / count, 100.0 * cycled / count, T9_MAX_CANDIDATES, beyond, missing);
+
+    CHECK(missing == 0);
+    CHECK(mismatches == 0);
+    // the node record carries its candidates, and its parent may have been evicted
+    CHECK(worst_reads <= 2);
+    // out of reach only when more frequent words fill the candidates
+    CHECK(beyond == crowded);
+
+    t9_close(&ctx);
+    CHECK(!t9_push_digit(&ctx, '2'));
+    free(entries);
+
+    return check_summary();
+}
@@ -0,0 +1,139 @@
+/**
+ * @file test_tickless.c
+ * @brief Tickless idle tick conversion host test
+ * @ingroup tests
+ *
+ * Runs the LPTIM1 to RTOS tick conversion used by vPortSuppressTicksAndSleep()
+ * against a simulated 4 kHz low-power timer and a 1 kHz tick, plus rates that
+ * do not divide evenly. Checks that sleeps end on the requested tick, that a
+ * long run of sleeps and early wakes does not drift from the timer, that the
+ * part of a tick already counted shortens the sleep, and that sleeps are
+ * capped to what the 16-bit compare register can hold.
+ *
+ * Build and run:
+ *   gcc -O2 -I./include/kernel -o test_tickless tests/test_tickless.c kernel/core/tickless_idle.c
+ *   ./test_tickless
+ */
+
+#include "tickless_idle.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static void test_exact(void)
+{
+    printf("Sleeps on the tick boundary\n");
+    TicklessClock clock;
+    tickless_clock_init(&clock, 4000, 1000, 0xFFFE);
+
+    CHECK(tickless_counts_for(&clock, 1, 0) == 4);
+    CHECK(tickless_counts_for(&clock, 10, 0) == 40);
+    CHECK(tickless_ticks_elapsed(&clock, 40, 0, 10) == 10);
+    CHECK(clock.carry == 0);
+
+    // woken after 2.5 ticks: two are counted, the half carries into the next sleep
+    CHECK(tickless_ticks_elapsed(&clock, 10, 0, 10) == 2);
+    CHECK(clock.carry == 2000);
+    CHECK(tickless_counts_for(&clock, 1, 0) == 2);
+    CHECK(tickless_ticks_elapsed(&clock, 2, 0, 1) == 1);
+    CHECK(clock.carry == 0);
+
+    // half a tick already on the SysTick shortens the sleep by two counts
+    CHECK(tickless_counts_for(&clock, 5, 0x8000) == 18);
+    CHECK(tickless_ticks_elapsed(&clock, 18, 0x8000, 5) == 5);
+    CHECK(clock.carry == 0);
+
+    // never zero counts, even when the carry already covers the sleep
+    clock.carry = 3999;
+    CHECK(tickless_counts_for(&clock, 1, 0xFFFF) == 1);
+}
+
+static void test_caps(void)
+{
+    printf("Caps\n");
+    TicklessClock clock;
+    tickless_clock_init(&clock, 4000, 1000, 0xFFFE);
+
+    uint32_t max = tickless_max_ticks(&clock);
+    CHECK(max == 16382);
+    CHECK(tickless_counts_for(&clock, max, 0) <= 0xFFFE);
+    CHECK(tickless_counts_for(&clock, 100000, 0) == tickless_counts_for(&clock, max, 0));
+
+    // late wakes are clamped to the RTOS limit with under a tick carried
+    CHECK(tickless_ticks_elapsed(&clock, 400, 0, 20) == 20);
+    CHECK(clock.carry == 3999);
+    CHECK(tickless_ticks_elapsed(&clock, 0, 0, 5) == 0);
+    CHECK(clock.carry == 3999);
+}
+
+// sleeps of random length, a third of them ended early by an interrupt
+static void run_drift(uint32_t counter_hz, uint32_t tick_hz)
+{
+    TicklessClock clock;
+    tickless_clock_init(&clock, counter_hz, tick_hz, 0xFFFE);
+    srand(counter_hz ^ tick_hz);
+
+    uint64_t timer_counts = 0;
+    uint64_t rtos_ticks = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        uint32_t expected = 2 + (uint32_t)(rand() % 2000);
+        uint32_t counts = tickless_counts_for(&clock, expected, 0);
+        if (rand() % 3 == 0)
+        {
+            counts = (uint32_t)(rand() % counts);
+        }
+
+        uint32_t ticks = tickless_ticks_elapsed(&clock, counts, 0, expected);
+        timer_counts += counts;
+        rtos_ticks += ticks;
+        CHECK(ticks <= expected);
+    }
+
+    // the RTOS is behind the timer by exactly the carried fraction
+    uint64_t timer_units = timer_counts * tick_hz;
+    uint64_t rtos_units = rtos_ticks * counter_hz;
+    CHECK(timer_units == rtos_units + clock.carry);
+    CHECK(clock.carry < counter_hz);
+    printf("  %u Hz timer, %u Hz tick: %llu ticks over 100000 sleeps, %u units carried\n", counter_hz, tick_hz,
+           (unsigned long long)rtos_ticks, clock.carry);
+}
+
+static void test_drift(void)
+{
+    printf("No drift\n");
+    run_drift(4000, 1000);
+    run_drift(32000, 1000);
+    run_drift(4000, 300);
+    run_drift(3125, 1000);
+}
+
+// full sleeps land on the requested tick even when the rates do not divide
+static void test_uneven(void)
+{
+    printf("Uneven rates\n");
+    TicklessClock clock;
+    tickless_clock_init(&clock, 3125, 1000, 0xFFFE);
+
+    int late = 0;
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        uint32_t expected = 1 + i % 97;
+        uint32_t counts = tickless_counts_for(&clock, expected, 0);
+        if (tickless_ticks_elapsed(&clock, counts, 0, expected) != expected)
+        {
+            late++;
+        }
+    }
+    CHECK(late == 0);
+}
+
+int main(void)
+{
+    test_exact();
+    test_caps();
+    test_drift();
+    test_uneven();
+
+    return check_summary();
+}
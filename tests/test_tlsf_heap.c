@@ -0,0 +1,662 @@
+/**
+ * @file test_tlsf_heap.c
+ * @brief TLSF heap host test and benchmark against heap_4
+ * @ingroup tests
+ *
+ * Checks the TLSF heap directly: arena limits, alignment and usable sizes
+ * for every request size, in-place realloc growing into and shrinking back
+ * to a free neighbour, exhaustion and full recovery, and random churn with
+ * the whole-heap invariant check run along the way.
+ *
+ * Then replays the same allocation trace through TLSF and through the
+ * unmodified FreeRTOS heap_4.c, compiled against tests/stubs, both over a
+ * 15360-byte array as configured on the device. TLSF's control structure
+ * is taken out of that array as the port does. The trace follows the
+ * firmware's allocation sites: task stacks, TCBs and queues at boot, then
+ * hours of page pushes and pops with their state and list buffers, SMS
+ * overlays holding decoded PDUs, AT response buffers and a growing
+ * string buffer. Every block is filled and checked before it is freed.
+ *
+ * The cost of a call is counted, not timed: the free-list blocks it visits.
+ * For heap_4 that is every block its first-fit search and its address-
+ * ordered insert step over, found by walking its list the way its loops
+ * do. For TLSF it is the block the bitmaps pick plus the neighbours split
+ * off or merged, read from the change in the free block count. The counts
+ * are the same on every run and every machine. Reported per heap: mean and
+ * worst blocks visited per call, failed allocations, and the smallest
+ * largest-free-block and most free blocks seen.
+ *
+ * Build and run:
+ *   gcc -O2 -I./include/kernel -I./tests/stubs -I./third_party/stm32/Middlewares/Third_Party/FreeRTOS/Source/portable/MemMang -o test_tlsf_heap tests/test_tlsf_heap.c kernel/core/tlsf_heap.c
+ *   ./test_tlsf_heap
+ */
+
+#include "tlsf_heap.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the FreeRTOS heap under comparison, built in this translation unit
+#include "heap_4.c"
+
+static uint64_t arena_words[64 * 1024 / 8];
+static uint8_t *const arena = (uint8_t *)arena_words;
+
+/* ===== TLSF ===== */
+
+static void test_init(void)
+{
+    printf("Arena limits\n");
+    TlsfHeap heap;
+    CHECK(!tlsf_heap_init(&heap, arena + 4, 4096));
+    CHECK(!tlsf_heap_init(&heap, arena, 16));
+    CHECK(!tlsf_heap_init(&heap, arena, (size_t)1 << TLSF_FL_MAX_LOG2 << 1));
+    CHECK(tlsf_heap_init(&heap, arena, 15360));
+    CHECK(tlsf_heap_check(&heap));
+
+    TlsfStats stats;
+    tlsf_heap_get_stats(&heap, &stats);
+    CHECK(stats.free_blocks == 1);
+    CHECK(stats.largest_free == stats.total_bytes && stats.free_bytes == stats.total_bytes);
+    CHECK(tlsf_heap_malloc(&heap, 0) == NULL);
+    CHECK(tlsf_heap_malloc(&heap, stats.total_bytes + 1) == NULL);
+    tlsf_heap_get_stats(&heap, &stats);
+    CHECK(stats.failed == 1);
+}
+
+static void test_sizes(void)
+{
+    printf("Every request size\n");
+    TlsfHeap heap;
+    tlsf_heap_init(&heap, arena, 15360);
+    TlsfStats stats;
+    tlsf_heap_get_stats(&heap, &stats);
+
+    int bad = 0;
+    for (size_t size = 1; size <= stats.total_bytes; size++)
+    {
+        uint8_t *p = tlsf_heap_malloc(&heap, size);
+        if (!p || ((uintptr_t)p & (TLSF_ALIGN - 1)) || tlsf_heap_usable_size(p) < size)
+        {
+            bad++;
+            continue;
+        }
+        memset(p, 0xA5, size);
+        tlsf_heap_free(&heap, p);
+    }
+    CHECK(bad == 0);
+    CHECK(tlsf_heap_check(&heap));
+    tlsf_heap_get_stats(&heap, &stats);
+    CHECK(stats.free_blocks == 1 && stats.used_blocks == 0);
+}
+
+static void test_realloc(void)
+{
+    printf("Realloc in place\n");
+    TlsfHeap heap;
+    tlsf_heap_init(&heap, arena, 15360);
+
+    uint8_t *a = tlsf_heap_malloc(&heap, 100);
+    uint8_t *b = tlsf_heap_malloc(&heap, 300);
+    uint8_t *c = tlsf_heap_malloc(&heap, 40);
+    uint8_t *guard = tlsf_heap_malloc(&heap, 40);
+    for (int i = 0; i < 100; i++)
+        a[i] = (uint8_t)i;
+
+    // grows into b's space once b is gone
+    tlsf_heap_free(&heap, b);
+    CHECK(tlsf_heap_realloc(&heap, a, 380) == a);
+    CHECK(tlsf_heap_usable_size(a) >= 380);
+    int same = 1;
+    for (int i = 0; i < 100; i++)
+        same &= a[i] == (uint8_t)i;
+    CHECK(same);
+    CHECK(tlsf_heap_check(&heap));
+
+    // shrinking hands the tail back to the free lists
+    TlsfStats before, after;
+    tlsf_heap_get_stats(&heap, &before);
+    CHECK(tlsf_heap_realloc(&heap, a, 64) == a);
+    tlsf_heap_get_stats(&heap, &after);
+    CHECK(after.free_bytes > before.free_bytes);
+    CHECK(after.realloc_kept == 2);
+    CHECK(tlsf_heap_check(&heap));
+
+    // no room next to it: moves, keeps the data, frees the old block
+    memset(c, 0x5A, 40);
+    uint8_t *moved = tlsf_heap_realloc(&heap, c, 2000);
+    CHECK(moved != NULL && moved != c);
+    CHECK(moved[0] == 0x5A && moved[39] == 0x5A);
+    CHECK(tlsf_heap_check(&heap));
+    tlsf_heap_free(&heap, guard);
+
+    CHECK(tlsf_heap_realloc(&heap, NULL, 0) == NULL);
+    CHECK(tlsf_heap_realloc(&heap, moved, 0) == NULL);
+    tlsf_heap_free(&heap, a);
+    tlsf_heap_get_stats(&heap, &after);
+    CHECK(after.free_blocks == 1 && after.used_blocks == 0);
+    CHECK(tlsf_heap_check(&heap));
+}
+
+static void test_exhaustion(void)
+{
+    printf("Exhaustion and recovery\n");
+    TlsfHeap heap;
+    tlsf_heap_init(&heap, arena, 15360);
+    static void *blocks[2048];
+    int n = 0;
+    while (n < 2048 && (blocks[n] = tlsf_heap_malloc(&heap, 24)) != NULL)
+        n++;
+    CHECK(n > 100 && n < 2048);
+    CHECK(tlsf_heap_check(&heap));
+
+    TlsfStats stats;
+    tlsf_heap_get_stats(&heap, &stats);
+    CHECK(stats.failed == 1);
+    CHECK(stats.min_ever_free == stats.free_bytes);
+
+    // free every other block, then the rest: all must merge back
+    for (int i = 0; i < n; i += 2)
+        tlsf_heap_free(&heap, blocks[i]);
+    tlsf_heap_get_stats(&heap, &stats);
+    CHECK(stats.largest_free < 64);
+    for (int i = 1; i < n; i += 2)
+        tlsf_heap_free(&heap, blocks[i]);
+    tlsf_heap_get_stats(&heap, &stats);
+    CHECK(stats.free_blocks == 1 && stats.largest_free == stats.total_bytes);
+    CHECK(tlsf_heap_check(&heap));
+}
+
+static void test_churn(void)
+{
+    printf("Random churn with invariant checks\n");
+    enum
+    {
+        LIVE = 96
+    };
+    TlsfHeap heap;
+    tlsf_heap_init(&heap, arena, 15360);
+    uint8_t *blocks[LIVE] = {0};
+    size_t sizes[LIVE] = {0};
+    int corrupt = 0, inconsistent = 0;
+    srand(43);
+
+    for (int i = 0; i < 300000; i++)
+    {
+        int k = rand() % LIVE;
+        if (blocks[k])
+        {
+            for (size_t j = 0; j < sizes[k]; j++)
+                corrupt += blocks[k][j] != (uint8_t)k;
+            if (rand() % 4 == 0)
+            {
+                size_t size = 1 + (size_t)(rand() % 600);
+                uint8_t *p = tlsf_heap_realloc(&heap, blocks[k], size);
+                if (p)
+                {
+                    memset(p, k, size);
+                    blocks[k] = p;
+                    sizes[k] = size;
+                }
+            }
+            else
+            {
+                tlsf_heap_free(&heap, blocks[k]);
+                blocks[k] = NULL;
+            }
+        }
+        else
+        {
+            sizes[k] = 1 + (size_t)(rand() % (rand() % 8 ? 200 : 1500));
+            blocks[k] = tlsf_heap_malloc(&heap, sizes[k]);
+            if (blocks[k])
+                memset(blocks[k], k, sizes[k]);
+        }
+        if (i % 1000 == 0 && !tlsf_heap_check(&heap))
+            inconsistent++;
+    }
+    CHECK(corrupt == 0);
+    CHECK(inconsistent == 0);
+
+    for (int k = 0; k < LIVE; k++)
+        tlsf_heap_free(&heap, blocks[k]);
+    TlsfStats stats;
+    tlsf_heap_get_stats(&heap, &stats);
+    CHECK(stats.free_blocks == 1 && stats.used_blocks == 0);
+}
+
+/* ===== TRACE ===== */
+
+enum
+{
+    OP_ALLOC,
+    OP_FREE,
+    OP_REALLOC,
+};
+
+typedef struct
+{
+    uint8_t op;
+    uint16_t id;
+    uint16_t size;
+} Event;
+
+#define MAX_EVENTS 400000
+#define MAX_IDS 4096
+
+static Event trace[MAX_EVENTS];
+static int trace_len;
+static int next_id;
+
+static bool id_live[MAX_IDS];
+
+static int emit(uint8_t op, int id, int size)
+{
+    if (trace_len < MAX_EVENTS)
+        trace[trace_len++] = (Event){op, (uint16_t)id, (uint16_t)size};
+    id_live[id] = op != OP_FREE;
+    return id;
+}
+
+static int alloc_id(int size)
+{
+    while (id_live[next_id])
+        next_id = (next_id + 1) % MAX_IDS;
+    return emit(OP_ALLOC, next_id, size);
+}
+
+// what a page allocates on create: Page, state, and its own buffers
+typedef struct
+{
+    int ids[8];
+    int count;
+} PageAllocs;
+
+static void page_open(PageAllocs *p, int state_size, int buffers, int buffer_size)
+{
+    p->count = 0;
+    p->ids[p->count++] = alloc_id(40);
+    p->ids[p->count++] = alloc_id(state_size);
+    for (int i = 0; i < buffers && p->count < 8; i++)
+        p->ids[p->count++] = alloc_id(buffer_size);
+}
+
+static void page_close(PageAllocs *p)
+{
+    // destroy frees the buffers, then the state, then the page
+    for (int i = p->count - 1; i >= 0; i--)
+        emit(OP_FREE, p->ids[i], 0);
+}
+
+static void build_trace(void)
+{
+    srand(2024);
+    trace_len = 0;
+    next_id = 0;
+    memset(id_live, 0, sizeof(id_live));
+
+    // boot: seven task stacks with their TCBs, task queues, an event group
+    static const int stacks[] = {1024, 512, 2048, 2048, 512, 1024, 1024};
+    for (int i = 0; i < 7; i++)
+    {
+        alloc_id(stacks[i]);
+        alloc_id(92);
+    }
+    static const int queues[] = {80 + 5 * 8, 80 + 5 * 12, 80 + 5 * 16, 80 + 5 * 8, 80 + 5 * 8};
+    for (int i = 0; i < 5; i++)
+        alloc_id(queues[i]);
+    alloc_id(32);
+
+    PageAllocs home;
+    page_open(&home, 64, 0, 0);
+
+    PageAllocs stack[4];
+    int depth = 0;
+    int overlay[2] = {-1, -1};
+    int overlay_left = 0;
+    int at_buffer = -1;
+    int text = -1, text_size = 0;
+
+    while (trace_len < MAX_EVENTS - 64)
+    {
+        int r = rand() % 100;
+        if (r < 30 && depth < 4)
+        {
+            // open a page: menu, contacts, messages, a game, a debug page
+            switch (rand() % 5)
+            {
+            case 0:
+                page_open(&stack[depth], 96, 1, 64);
+                break;
+            case 1:
+                page_open(&stack[depth], 200, 4, 32 + rand() % 32);
+                break;
+            case 2:
+                page_open(&stack[depth], 160, 1 + rand() % 3, 176);
+                break;
+            case 3:
+                page_open(&stack[depth], rand() % 2 ? 420 : 530, 0, 0);
+                break;
+            default:
+                page_open(&stack[depth], 48, 0, 0);
+                break;
+            }
+            depth++;
+        }
+        else if (r < 58 && depth > 0)
+        {
+            page_close(&stack[--depth]);
+        }
+        else if (r < 66 && overlay[0] < 0)
+        {
+            // an SMS arrives: decoded PDU, then the overlay that shows it
+            overlay[0] = alloc_id(176);
+            overlay[1] = alloc_id(120);
+            overlay_left = 5 + rand() % 40;
+        }
+        else if (r < 86)
+        {
+            // AT round trip: a response buffer that lives for a few events
+            if (at_buffer >= 0)
+                emit(OP_FREE, at_buffer, 0);
+            at_buffer = alloc_id(64 + rand() % 192);
+        }
+        else
+        {
+            // a text entry buffer growing as characters are typed
+            if (text < 0)
+            {
+                text_size = 16;
+                text = alloc_id(text_size);
+            }
+            else if (text_size < 320 && rand() % 4)
+            {
+                text_size += 16;
+                emit(OP_REALLOC, text, text_size);
+            }
+            else
+            {
+                emit(OP_FREE, text, 0);
+                text = -1;
+            }
+        }
+
+        if (overlay[0] >= 0 && --overlay_left == 0)
+        {
+            emit(OP_FREE, overlay[1], 0);
+            emit(OP_FREE, overlay[0], 0);
+            overlay[0] = overlay[1] = -1;
+        }
+    }
+}
+
+/* ===== REPLAY ===== */
+
+typedef struct
+{
+    const char *name;
+    void (*reset)(void);
+    void *(*malloc_fn)(size_t);
+    void (*free_fn)(void *);
+    void *(*realloc_fn)(void *, size_t);
+    void (*stats)(size_t *free_bytes, size_t *largest, size_t *blocks);
+} HeapOps;
+
+// free-list blocks visited by the call being replayed
+static uint32_t call_steps;
+
+static TlsfHeap *tlsf;
+
+static size_t tlsf_free_blocks(void)
+{
+    TlsfStats s;
+    tlsf_heap_get_stats(tlsf, &s);
+    return s.free_blocks;
+}
+
+static void tlsf_reset(void)
+{
+    // control structure from the front of the same 15360 bytes, as the port does
+    size_t control = (sizeof(TlsfHeap) + TLSF_ALIGN - 1) & ~((size_t)TLSF_ALIGN - 1);
+    tlsf = (TlsfHeap *)arena;
+    tlsf_heap_init(tlsf, arena + control, 15360 - control);
+}
+static void *tlsf_malloc(size_t n)
+{
+    // the list head the bitmaps pick, and the remainder if it was split off
+    size_t before = tlsf_free_blocks();
+    void *p = tlsf_heap_malloc(tlsf, n);
+    call_steps += 1 + (p && tlsf_free_blocks() == before);
+    return p;
+}
+static void tlsf_free(void *p)
+{
+    if (!p)
+        return;
+    // the freed block, and each neighbour merged into it
+    size_t before = tlsf_free_blocks();
+    tlsf_heap_free(tlsf, p);
+    call_steps += 1 + (uint32_t)(before + 1 - tlsf_free_blocks());
+}
+static void *tlsf_realloc(void *p, size_t n)
+{
+    size_t before = tlsf_free_blocks();
+    void *q = tlsf_heap_realloc(tlsf, p, n);
+    size_t after = tlsf_free_blocks();
+    // in place it absorbs or splits off a neighbour, moving is a malloc and a free
+    call_steps += (q == p ? 1 : 3) + (uint32_t)(after > before ? after - before : before - after);
+    return q;
+}
+static void tlsf_stats(size_t *free_bytes, size_t *largest, size_t *blocks)
+{
+    TlsfStats s;
+    tlsf_heap_get_stats(tlsf, &s);
+    *free_bytes = s.free_bytes;
+    *largest = s.largest_free;
+    *blocks = s.free_blocks;
+}
+
+// blocks prvInsertBlockIntoFreeList steps over to reach addr's place
+static uint32_t heap4_insert_steps(const void *addr)
+{
+    uint32_t steps = 1;
+    for (BlockLink_t *it = &xStart; it->pxNextFreeBlock && (void *)it->pxNextFreeBlock < addr; it = it->pxNextFreeBlock)
+        steps++;
+    return steps;
+}
+
+// blocks pvPortMalloc's first-fit search looks at for n bytes
+static uint32_t heap4_search_steps(size_t n)
+{
+    if (!pxEnd)
+        return 1;
+    size_t wanted = (n + xHeapStructSize + portBYTE_ALIGNMENT_MASK) & ~(size_t)portBYTE_ALIGNMENT_MASK;
+    uint32_t steps = 1;
+    for (BlockLink_t *b = xStart.pxNextFreeBlock; b->xBlockSize < wanted && b->pxNextFreeBlock; b = b->pxNextFreeBlock)
+        steps++;
+    return steps;
+}
+
+// heap_4 sets itself up once; a replay frees everything so it starts whole again
+static void heap4_reset(void) {}
+static void *heap4_malloc(size_t n)
+{
+    call_steps += heap4_search_steps(n);
+    uint8_t *p = pvPortMalloc(n);
+    if (p)
+    {
+        // heap_4 merges free neighbours, so a free block right after this one is the split-off tail
+        BlockLink_t *block = (BlockLink_t *)(p - xHeapStructSize);
+        uint8_t *tail = (uint8_t *)block + (block->xBlockSize & ~xBlockAllocatedBit);
+        for (BlockLink_t *it = xStart.pxNextFreeBlock; it && it != pxEnd; it = it->pxNextFreeBlock)
+        {
+            if ((uint8_t *)it == tail)
+            {
+                call_steps += heap4_insert_steps(tail);
+                break;
+            }
+        }
+    }
+    return p;
+}
+static void heap4_free(void *p)
+{
+    if (!p)
+        return;
+    call_steps += heap4_insert_steps((uint8_t *)p - xHeapStructSize);
+    vPortFree(p);
+}
+static void *heap4_realloc(void *p, size_t n)
+{
+    // what memwrap does on heap_4: keep the block if it fits, else move
+    size_t have = (((BlockLink_t *)((uint8_t *)p - xHeapStructSize))->xBlockSize & ~xBlockAllocatedBit) - xHeapStructSize;
+    if (n <= have)
+    {
+        call_steps += 1;
+        return p;
+    }
+    void *q = heap4_malloc(n);
+    if (q)
+    {
+        memcpy(q, p, have);
+        heap4_free(p);
+    }
+    return q;
+}
+static void heap4_stats(size_t *free_bytes, size_t *largest, size_t *blocks)
+{
+    HeapStats_t s;
+    vPortGetHeapStats(&s);
+    *free_bytes = s.xAvailableHeapSpaceInBytes;
+    *largest = s.xSizeOfLargestFreeBlockInBytes;
+    *blocks = s.xNumberOfFreeBlocks;
+}
+
+static const HeapOps heaps[] = {
+    {"heap_4", heap4_reset, heap4_malloc, heap4_free, heap4_realloc, heap4_stats},
+    {"tlsf", tlsf_reset, tlsf_malloc, tlsf_free, tlsf_realloc, tlsf_stats},
+};
+
+typedef struct
+{
+    uint64_t steps;
+    uint32_t calls, max_steps;
+    int failed, corrupt;
+    size_t min_largest, max_blocks;
+} ReplayResult;
+
+static void replay(const HeapOps *h, ReplayResult *out)
+{
+    static uint8_t *ptrs[MAX_IDS];
+    static uint16_t sizes[MAX_IDS];
+    memset(out, 0, sizeof(*out));
+    out->min_largest = (size_t)-1;
+
+    h->reset();
+    memset(ptrs, 0, sizeof(ptrs));
+    for (int i = 0; i < trace_len; i++)
+    {
+        const Event *e = &trace[i];
+        uint8_t *p = ptrs[e->id];
+        call_steps = 0;
+        switch (e->op)
+        {
+        case OP_ALLOC:
+            p = h->malloc_fn(e->size);
+            if (p)
+                memset(p, (uint8_t)e->id, e->size);
+            else
+                out->failed++;
+            ptrs[e->id] = p;
+            sizes[e->id] = e->size;
+            break;
+        case OP_REALLOC:
+            if (!p)
+                continue;
+            p = h->realloc_fn(p, e->size);
+            if (p)
+            {
+                memset(p, (uint8_t)e->id, e->size);
+                ptrs[e->id] = p;
+                sizes[e->id] = e->size;
+            }
+            else
+            {
+                out->failed++;
+            }
+            break;
+        default:
+            if (!p)
+                continue;
+            for (int j = 0; j < sizes[e->id]; j++)
+                out->corrupt += p[j] != (uint8_t)e->id;
+            h->free_fn(p);
+            ptrs[e->id] = NULL;
+            break;
+        }
+
+        out->steps += call_steps;
+        out->calls++;
+        if (call_steps > out->max_steps)
+            out->max_steps = call_steps;
+
+        if (i % 64 == 0)
+        {
+            size_t free_bytes, largest, blocks;
+            h->stats(&free_bytes, &largest, &blocks);
+            if (largest < out->min_largest)
+                out->min_largest = largest;
+            if (blocks > out->max_blocks)
+                out->max_blocks = blocks;
+        }
+    }
+
+    for (int id = 0; id < MAX_IDS; id++)
+    {
+        h->free_fn(ptrs[id]);
+        ptrs[id] = NULL;
+    }
+}
+
+static void test_replay(void)
+{
+    printf("Replayed firmware trace, 15360-byte heap\n");
+    build_trace();
+    printf("  tlsf control %zu B of the array here, pointers are %zu B on the host\n", sizeof(TlsfHeap),
+           sizeof(void *));
+
+    ReplayResult results[2];
+    for (int i = 0; i < 2; i++)
+    {
+        replay(&heaps[i], &results[i]);
+        const ReplayResult *r = &results[i];
+        printf("  %-6s %6lu calls: %.2f blocks visited per call, worst %lu\n", heaps[i].name,
+               (unsigned long)r->calls, (double)r->steps / r->calls, (unsigned long)r->max_steps);
+        printf("         failed %d, smallest largest-free %zu B, most free blocks %zu\n", r->failed,
+               r->min_largest, r->max_blocks);
+        CHECK(r->corrupt == 0);
+    }
+    // TLSF never walks a list: the block it takes, a split or two merges, or a move
+    CHECK(results[1].max_steps <= 5);
+
+    // the heaps must end whole after the replay frees everything
+    size_t free_bytes, largest, blocks;
+    heap4_stats(&free_bytes, &largest, &blocks);
+    CHECK(blocks == 1);
+    CHECK(tlsf_heap_check(tlsf));
+    tlsf_stats(&free_bytes, &largest, &blocks);
+    CHECK(blocks == 1);
+}
+
+int main(void)
+{
+    test_init();
+    test_sizes();
+    test_realloc();
+    test_exhaustion();
+    test_churn();
+    test_replay();
+
+    return check_summary();
+}
@@ -0,0 +1,483 @@
+/**
+ * @file test_trace.c
+ * @brief Trace ring host test
+ * @ingroup tests
+ *
+ * Checks the trace ring in kernel/core/trace.c through its dump: the
+ * header, the name table with renames, truncation and overflow, records
+ * oldest first across the ring's wrap, the sequence tags, skipped repeat
+ * task switches, the trigger freezing the ring a set number of records
+ * later, and a failing sink. Four threads then write at once, and every
+ * record must come back whole with each thread's records in order, also
+ * when the dump is taken while they are still writing.
+ *
+ * Reports the cost of a record. Given a file name, also writes a dump of
+ * a made-up few milliseconds of firmware activity for
+ * tools/trace_decode.py.
+ *
+ * Build and run:
+ *   gcc -O2 -pthread -DTRACE_ENABLED -I./include/kernel -o test_trace tests/test_trace.c kernel/core/trace.c
+ *   ./test_trace [trace.bin]
+ *   python3 tools/trace_decode.py trace.bin --summary
+ */
+
+#include "trace.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WRITERS 4
+#define WRITER_RECORDS 200000
+#define TEST_EVENT (TRACE_USER + 0x40)
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ===== DUMP PARSING ===== */
+
+typedef struct
+{
+    uint8_t data[sizeof(TraceDumpHeader) + TRACE_MAX_NAMES * sizeof(TraceName) +
+                 TRACE_RING_SIZE * sizeof(TraceRecord) + 8];
+    size_t len;
+    int fail_after; // sink calls to accept, -1 for all
+} Buffer;
+
+static bool buffer_write(const void *data, size_t len, void *arg)
+{
+    Buffer *b = (Buffer *)arg;
+    if (b->fail_after == 0 || b->len + len > sizeof(b->data))
+    {
+        return false;
+    }
+    if (b->fail_after > 0)
+    {
+        b->fail_after--;
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+    return true;
+}
+
+typedef struct
+{
+    TraceDumpHeader header;
+    const TraceName *names;
+    const TraceRecord *records;
+    uint32_t torn; // records whose tag does not match their position
+} Dump;
+
+static Buffer buffer;
+
+// dump into the buffer and check the framing, false if it is malformed
+static bool take_dump(Dump *dump)
+{
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.fail_after = -1;
+    size_t bytes = trace_dump(buffer_write, &buffer);
+    if (bytes != buffer.len || bytes < sizeof(TraceDumpHeader) + 8)
+    {
+        return false;
+    }
+
+    memcpy(&dump->header, buffer.data, sizeof(dump->header));
+    const TraceDumpHeader *h = &dump->header;
+    size_t body = sizeof(*h) + h->name_count * sizeof(TraceName) + h->count * sizeof(TraceRecord);
+    if (memcmp(h->magic, TRACE_DUMP_MAGIC, 4) != 0 || body + 8 != bytes ||
+        memcmp(buffer.data + body, TRACE_DUMP_END, 4) != 0)
+    {
+        return false;
+    }
+    uint32_t sum = 0, stored;
+    for (size_t i = 0; i < body; i++)
+    {
+        sum += buffer.data[i];
+    }
+    memcpy(&stored, buffer.data + body + 4, sizeof(stored));
+    if (sum != stored)
+    {
+        return false;
+    }
+
+    dump->names = (const TraceName *)(buffer.data + sizeof(*h));
+    dump->records = (const TraceRecord *)(buffer.data + sizeof(*h) + h->name_count * sizeof(TraceName));
+    dump->torn = 0;
+    for (uint32_t i = 0; i < h->count; i++)
+    {
+        uint32_t index = h->head - h->count + i;
+        if (dump->records[i].tag != (uint16_t)((index >> TRACE_RING_LOG2) + 1))
+        {
+            dump->torn++;
+        }
+    }
+    return true;
+}
+
+/* ===== TESTS ===== */
+
+static void test_empty(void)
+{
+    printf("Empty ring\n");
+    trace_init(1000000000u);
+    Dump dump;
+    CHECK(take_dump(&dump));
+    CHECK(dump.header.version == TRACE_DUMP_VERSION);
+    CHECK(dump.header.record_size == sizeof(TraceRecord) && sizeof(TraceRecord) == 16);
+    CHECK(dump.header.name_size == sizeof(TraceName) && sizeof(TraceName) == 16);
+    CHECK(sizeof(TraceDumpHeader) == 32);
+    CHECK(dump.header.clock_hz == 1000000000u);
+    CHECK(dump.header.capacity == TRACE_RING_SIZE);
+    CHECK(dump.header.head == 0 && dump.header.count == 0 && dump.header.name_count == 0);
+}
+
+static void test_names(void)
+{
+    printf("Names\n");
+    trace_init(1000000000u);
+    trace_name(TRACE_NAME_TASK, 1, "IDLE");
+    trace_name(TRACE_NAME_QUEUE, 1, "display");
+    trace_name(TRACE_NAME_TASK, 2, "CellularTaskLong");
+    trace_name(TRACE_NAME_TASK, 1, "Idle");
+
+    Dump dump;
+    CHECK(take_dump(&dump));
+    CHECK(dump.header.name_count == 3);
+    CHECK(dump.names[0].kind == TRACE_NAME_TASK && dump.names[0].key == 1);
+    CHECK(strncmp(dump.names[0].name, "Idle", sizeof(dump.names[0].name)) == 0);
+    CHECK(dump.names[1].kind == TRACE_NAME_QUEUE && dump.names[1].key == 1);
+    CHECK(memcmp(dump.names[2].name, "CellularTas", TRACE_NAME_LEN - 1) == 0);
+
+    for (uint32_t i = 0; i < TRACE_MAX_NAMES + 5; i++)
+    {
+        trace_name(TRACE_NAME_QUEUE, 100 + i, "q");
+    }
+    TraceStats stats;
+    trace_get_stats(&stats);
+    CHECK(stats.names == TRACE_MAX_NAMES);
+}
+
+static void test_wrap(void)
+{
+    printf("Order across the wrap\n");
+    trace_init(1000000000u);
+    uint32_t total = 2 * TRACE_RING_SIZE + 7;
+    for (uint32_t i = 0; i < total; i++)
+    {
+        trace_record(TEST_EVENT, i, ~i);
+    }
+
+    Dump dump;
+    CHECK(take_dump(&dump));
+    CHECK(dump.header.head == total && dump.header.count == TRACE_RING_SIZE);
+    CHECK(dump.torn == 0);
+    uint32_t first = total - TRACE_RING_SIZE;
+    bool in_order = true;
+    for (uint32_t i = 0; i < dump.header.count; i++)
+    {
+        const TraceRecord *r = &dump.records[i];
+        in_order &= r->id == TEST_EVENT && r->arg0 == first + i && r->arg1 == ~(first + i);
+        in_order &= i == 0 || (int32_t)(r->timestamp - dump.records[i - 1].timestamp) >= 0;
+    }
+    CHECK(in_order);
+
+    TraceStats stats;
+    trace_get_stats(&stats);
+    CHECK(stats.written == total && stats.overwritten == total - TRACE_RING_SIZE);
+    CHECK(stats.enabled && !stats.triggered);
+
+    // the dump resumes recording
+    trace_record(TEST_EVENT, 0, 0);
+    trace_get_stats(&stats);
+    CHECK(stats.written == total + 1);
+}
+
+static void test_spans_and_switches(void)
+{
+    printf("Spans and task switches\n");
+    trace_init(1000000000u);
+    trace_task_switch(3, 2);
+    trace_task_switch(3, 2);
+    TRACE_BEGIN(TRACE_AT_COMMAND, 0x5153432B, 0);
+    TRACE_END(TRACE_AT_COMMAND, 0, 12);
+    trace_task_switch(1, 0);
+
+    Dump dump;
+    CHECK(take_dump(&dump));
+    CHECK(dump.header.count == 4);
+    CHECK(dump.records[0].id == TRACE_TASK_SWITCH && dump.records[0].arg0 == 3 && dump.records[0].arg1 == 2);
+    CHECK(dump.records[1].id == (TRACE_AT_COMMAND | TRACE_FLAG_BEGIN));
+    CHECK(dump.records[2].id == (TRACE_AT_COMMAND | TRACE_FLAG_END) && dump.records[2].arg1 == 12);
+    CHECK(dump.records[3].id == TRACE_TASK_SWITCH && dump.records[3].arg0 == 1);
+}
+
+static void test_trigger(void)
+{
+    printf("Trigger\n");
+    trace_init(1000000000u);
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        trace_record(TEST_EVENT, i, 0);
+    }
+    trace_trigger(10);
+    trace_trigger(500); // ignored, one is pending
+    for (uint32_t i = 100; i < 150; i++)
+    {
+        trace_record(TEST_EVENT, i, 0);
+    }
+
+    TraceStats stats;
+    trace_get_stats(&stats);
+    CHECK(!stats.enabled && stats.triggered && stats.written == 110);
+
+    Dump dump;
+    CHECK(take_dump(&dump));
+    CHECK(dump.header.count == 110 && dump.torn == 0);
+    CHECK(dump.records[109].arg0 == 109);
+
+    // a frozen ring stays frozen across a dump until it is re-armed
+    trace_record(TEST_EVENT, 999, 0);
+    CHECK(take_dump(&dump));
+    CHECK(dump.header.count == 110);
+    trace_set_enabled(true);
+    trace_record(TEST_EVENT, 999, 0);
+    trace_get_stats(&stats);
+    CHECK(stats.enabled && !stats.triggered);
+    CHECK(take_dump(&dump));
+    CHECK(dump.records[dump.header.count - 1].arg0 == 999);
+
+    // stopped, a trigger is ignored and nothing is recorded
+    trace_set_enabled(false);
+    trace_trigger(1);
+    trace_record(TEST_EVENT, 1, 0);
+    trace_get_stats(&stats);
+    CHECK(!stats.enabled && !stats.triggered);
+}
+
+static void test_sink_failure(void)
+{
+    printf("Failing sink\n");
+    trace_init(1000000000u);
+    trace_record(TEST_EVENT, 1, 2);
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.fail_after = 1;
+    CHECK(trace_dump(buffer_write, &buffer) == 0);
+    TraceStats stats;
+    trace_get_stats(&stats);
+    CHECK(stats.enabled);
+}
+
+/* ===== CONCURRENT WRITERS ===== */
+
+static volatile bool writers_go;
+
+static void *writer_main(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    while (!writers_go)
+    {
+    }
+    for (uint32_t seq = 0; seq < WRITER_RECORDS; seq++)
+    {
+        trace_record(TEST_EVENT, id, seq);
+    }
+    return NULL;
+}
+
+static void run_writers(bool dump_midway, Dump *dump)
+{
+    pthread_t threads[WRITERS];
+    writers_go = false;
+    for (uintptr_t i = 0; i < WRITERS; i++)
+    {
+        pthread_create(&threads[i], NULL, writer_main, (void *)i);
+    }
+    writers_go = true;
+    if (dump_midway)
+    {
+        TraceStats stats;
+        do
+        {
+            trace_get_stats(&stats);
+        } while (stats.written < WRITER_RECORDS);
+        CHECK(take_dump(dump));
+    }
+    for (int i = 0; i < WRITERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    if (!dump_midway)
+    {
+        CHECK(take_dump(dump));
+    }
+}
+
+// each writer's records must come out whole and in the order it wrote them
+static bool writers_in_order(const Dump *dump)
+{
+    int64_t last[WRITERS];
+    for (int i = 0; i < WRITERS; i++)
+    {
+        last[i] = -1;
+    }
+    uint32_t index = dump->header.head - dump->header.count;
+    for (uint32_t i = 0; i < dump->header.count; i++, index++)
+    {
+        const TraceRecord *r = &dump->records[i];
+        if (r->tag != (uint16_t)((index >> TRACE_RING_LOG2) + 1))
+        {
+            continue;
+        }
+        if (r->id != TEST_EVENT || r->arg0 >= WRITERS || (int64_t)r->arg1 <= last[r->arg0])
+        {
+            return false;
+        }
+        last[r->arg0] = r->arg1;
+    }
+    return true;
+}
+
+static void test_concurrent(void)
+{
+    printf("Concurrent writers\n");
+    Dump dump;
+
+    trace_init(1000000000u);
+    run_writers(false, &dump);
+    CHECK(dump.header.head == WRITERS * WRITER_RECORDS);
+    CHECK(dump.header.count == TRACE_RING_SIZE);
+    CHECK(dump.torn == 0);
+    CHECK(writers_in_order(&dump));
+
+    // a writer past the enabled check when the dump starts can still land
+    // one record, which at worst tears the oldest slot being read
+    trace_init(1000000000u);
+    run_writers(true, &dump);
+    printf("  dump while writing: %u records, %u torn\n", dump.header.count, dump.torn);
+    CHECK(dump.torn <= WRITERS);
+    CHECK(writers_in_order(&dump));
+}
+
+/* ===== COST ===== */
+
+static void report_cost(void)
+{
+    printf("Cost\n");
+    trace_init(1000000000u);
+    const int rounds = 4000000;
+    double start = now_ns();
+    for (int i = 0; i < rounds; i++)
+    {
+        trace_record(TEST_EVENT, (uint32_t)i, 0);
+    }
+    double record_ns = (now_ns() - start) / rounds;
+
+    trace_set_enabled(false);
+    start = now_ns();
+    for (int i = 0; i < rounds; i++)
+    {
+        trace_record(TEST_EVENT, (uint32_t)i, 0);
+    }
+    double off_ns = (now_ns() - start) / rounds;
+
+    printf("  trace_record %.1f ns, %.1f ns while stopped (host clock_gettime timestamps)\n", record_ns, off_ns);
+}
+
+/* ===== SAMPLE DUMP ===== */
+
+static void spin_us(double us)
+{
+    double end = now_ns() + us * 1000;
+    while (now_ns() < end)
+    {
+    }
+}
+
+// tasks as numbered by the kernel at boot
+enum
+{
+    IDLE = 1,
+    DISPLAY = 3,
+    CELLULAR = 5,
+    AUDIO = 6,
+};
+
+static void write_sample(const char *path)
+{
+    trace_init(1000000000u);
+    trace_name(TRACE_NAME_TASK, IDLE, "IDLE");
+    trace_name(TRACE_NAME_TASK, DISPLAY, "DisplayTask");
+    trace_name(TRACE_NAME_TASK, CELLULAR, "CellularTask");
+    trace_name(TRACE_NAME_TASK, AUDIO, "AudioTask");
+    trace_name(TRACE_NAME_QUEUE, 0x20001000, "display");
+    trace_name(TRACE_NAME_QUEUE, 0x20002000, "audio");
+
+    for (int frame = 0; frame < 5; frame++)
+    {
+        trace_task_switch(DISPLAY, 3);
+        trace_record(TRACE_QUEUE_RECEIVE, 0x20001000, 1);
+        trace_record(TRACE_DISPLAY_FLUSH | TRACE_FLAG_BEGIN, 0, 0);
+        spin_us(300);
+        trace_record(TRACE_ISR | TRACE_FLAG_BEGIN, 16 + 122, 0);
+        spin_us(5);
+        trace_record(TRACE_ISR | TRACE_FLAG_END, 16 + 122, 0);
+        spin_us(200);
+        trace_record(TRACE_DISPLAY_FLUSH | TRACE_FLAG_END, 6, 6 * 2 * 240 * 30);
+        trace_record(TRACE_QUEUE_SEND, 0x20002000, 0);
+
+        trace_task_switch(AUDIO, 4);
+        trace_record(TRACE_QUEUE_RECEIVE, 0x20002000, 1);
+        trace_record(TRACE_AUDIO_BUFFER | TRACE_FLAG_BEGIN, 50, 0);
+        spin_us(100);
+        trace_record(TRACE_AUDIO_BUFFER | TRACE_FLAG_END, 50, 0);
+        trace_record(TRACE_QUEUE_RECEIVE_FAILED, 0x20002000, 0);
+
+        trace_task_switch(CELLULAR, 2);
+        trace_record(TRACE_AT_COMMAND | TRACE_FLAG_BEGIN, 0x5153432B, 0); // "+CSQ"
+        spin_us(150);
+        trace_record(TRACE_AT_COMMAND | TRACE_FLAG_END, 0, 24);
+
+        trace_task_switch(IDLE, 0);
+        trace_record(TRACE_IDLE_SLEEP | TRACE_FLAG_BEGIN, 16, 1);
+        spin_us(50); // Stop mode: the ticks slept are added back by the decoder
+        trace_record(TRACE_IDLE_SLEEP | TRACE_FLAG_END, 16, 1);
+    }
+    trace_record(TRACE_INCOMING_CALL, 0, 0);
+
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        printf("  cannot write %s\n", path);
+        failures++;
+        return;
+    }
+    Dump dump;
+    CHECK(take_dump(&dump));
+    CHECK(fwrite(buffer.data, 1, buffer.len, f) == buffer.len);
+    fclose(f);
+    printf("Sample dump of %u records written to %s\n", dump.header.count, path);
+}
+
+int main(int argc, char **argv)
+{
+    test_empty();
+    test_names();
+    test_wrap();
+    test_spans_and_switches();
+    test_trigger();
+    test_sink_failure();
+    test_concurrent();
+    report_cost();
+    if (argc > 1)
+    {
+        write_sample(argv[1]);
+    }
+
+    return check_summary();
+}
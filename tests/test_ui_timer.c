@@ -0,0 +1,363 @@
+/**
+ * @file test_ui_timer.c
+ * @brief Timer wheel host test and benchmark
+ * @ingroup tests
+ *
+ * Arms 10,000 timers with delays spread over every wheel level, cancels a
+ * third of them, then advances time in irregular steps and checks that each
+ * surviving timer fires exactly once, on its own tick, and that cancelled
+ * timers never fire. Also covers periodic reload, owner cancellation, pool
+ * exhaustion, stale handles, clock wraparound and the next-expiry deadline,
+ * and reports start/cancel cost and how many wakeups a sleeping display
+ * loop needs compared with polling every millisecond.
+ *
+ * Build and run:
+ *   gcc -O2 -DUI_TIMER_POOL_SIZE=10000 -I./include/ui -o test_ui_timer \
+ *       tests/test_ui_timer.c ui/ui_timer.c
+ *   ./test_ui_timer
+ */
+
+#include "ui_timer.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TIMER_COUNT UI_TIMER_POOL_SIZE
+#define OWNERS 10
+
+typedef struct
+{
+    UiTimerId id;
+    uint32_t expires; // next expected tick
+    uint32_t period;
+    uint32_t fired;
+    uint32_t late;    // fired on the wrong tick
+    bool cancelled;
+} Expect;
+
+static Expect expect[TIMER_COUNT];
+static int owners[OWNERS];
+static uint32_t last_fire_tick;
+static uint32_t out_of_order;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void on_fire(void *arg)
+{
+    Expect *e = (Expect *)arg;
+    uint32_t tick = ui_timer_now();
+    if (tick != e->expires)
+        e->late++;
+    if ((int32_t)(tick - last_fire_tick) < 0)
+        out_of_order++;
+    last_fire_tick = tick;
+    e->fired++;
+    if (e->period)
+        e->expires = tick + e->period;
+}
+
+static uint32_t random_delay(void)
+{
+    // spread over the four levels: < 64 ms, < 4 s, < 4.4 min, < 4.6 h
+    switch (rand() % 4)
+    {
+    case 0:
+        return 1 + rand() % 63;
+    case 1:
+        return 64 + rand() % (4096 - 64);
+    case 2:
+        return 4096 + rand() % (262144 - 4096);
+    default:
+        return 262144 + rand() % (UI_TIMER_MAX_DELAY_MS - 262144);
+    }
+}
+
+static void test_one_shots(uint32_t start)
+{
+    memset(expect, 0, sizeof(expect));
+    ui_timer_init(start);
+    last_fire_tick = start;
+    out_of_order = 0;
+
+    for (int i = 0; i < TIMER_COUNT; i++)
+    {
+        uint32_t delay = random_delay();
+        expect[i].expires = start + delay;
+        expect[i].id = ui_timer_start(&owners[i % OWNERS], delay, 0, on_fire, &expect[i]);
+        CHECK(expect[i].id != UI_TIMER_NONE);
+    }
+    for (int i = 0; i < TIMER_COUNT; i += 3)
+    {
+        CHECK(ui_timer_cancel(expect[i].id));
+        CHECK(!ui_timer_cancel(expect[i].id)); // second cancel is a no-op
+        expect[i].cancelled = true;
+    }
+
+    UiTimerStats stats;
+    ui_timer_get_stats(&stats);
+    CHECK(stats.active == TIMER_COUNT - (TIMER_COUNT + 2) / 3);
+
+    // irregular steps, sometimes far beyond the next expiry
+    uint32_t now = start;
+    int steps = 0;
+    while (now - start <= UI_TIMER_MAX_DELAY_MS + 1)
+    {
+        uint32_t step = (rand() % 8 == 0) ? 1 + rand() % 200000 : 1 + rand() % 5000;
+        now += step;
+        uint32_t deadline = ui_timer_next_expiry(now - step);
+        // the deadline is a lower bound on every pending expiry
+        for (int i = steps % 97; i < TIMER_COUNT; i += 97)
+        {
+            if (!expect[i].cancelled && !expect[i].fired)
+                CHECK(deadline == UI_TIMER_NEVER || expect[i].expires - (now - step) >= deadline);
+        }
+        ui_timer_run(now);
+        steps++;
+    }
+
+    uint32_t missed = 0, extra = 0, late = 0;
+    for (int i = 0; i < TIMER_COUNT; i++)
+    {
+        if (expect[i].cancelled)
+            extra += expect[i].fired;
+        else if (expect[i].fired != 1)
+            missed++;
+        late += expect[i].late;
+    }
+    CHECK(missed == 0);
+    CHECK(extra == 0);
+    CHECK(late == 0);
+    CHECK(out_of_order == 0);
+    CHECK(ui_timer_next_expiry(now) == UI_TIMER_NEVER);
+    ui_timer_get_stats(&stats);
+    CHECK(stats.active == 0);
+    printf("start %08lx: %d timers over %d steps, missed %lu, cancelled fired %lu, late %lu, cascaded %lu\n",
+           (unsigned long)start, TIMER_COUNT, steps, (unsigned long)missed,
+           (unsigned long)extra, (unsigned long)late, (unsigned long)stats.cascaded);
+}
+
+static void test_periodic_and_owners(void)
+{
+    memset(expect, 0, sizeof(expect));
+    ui_timer_init(0);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        expect[i].period = 1 + rand() % 3000;
+        expect[i].expires = expect[i].period;
+        expect[i].id = ui_timer_start(&owners[i % OWNERS], expect[i].period, expect[i].period, on_fire, &expect[i]);
+    }
+
+    uint32_t now = 0;
+    while (now < 60000)
+    {
+        now += 1 + rand() % 700;
+        ui_timer_run(now);
+    }
+
+    uint32_t wrong = 0, late = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        if (expect[i].fired != now / expect[i].period)
+            wrong++;
+        late += expect[i].late;
+        CHECK(ui_timer_pending(expect[i].id));
+    }
+    CHECK(wrong == 0);
+    CHECK(late == 0);
+
+    // a popped page takes its timers with it
+    CHECK(ui_timer_cancel_owner(&owners[3]) == 100);
+    CHECK(ui_timer_cancel_owner(&owners[3]) == 0);
+    CHECK(ui_timer_cancel_owner(NULL) == 0);
+    for (int i = 3; i < 1000; i += OWNERS)
+    {
+        CHECK(!ui_timer_pending(expect[i].id));
+        expect[i].fired = 0;
+    }
+    now += 5000;
+    ui_timer_run(now);
+    for (int i = 3; i < 1000; i += OWNERS)
+        CHECK(expect[i].fired == 0);
+
+    UiTimerStats stats;
+    ui_timer_get_stats(&stats);
+    CHECK(stats.active == 900);
+}
+
+static UiTimerId self_id;
+static int self_runs;
+
+static void cancel_self(void *arg)
+{
+    (void)arg;
+    self_runs++;
+    CHECK(ui_timer_cancel(self_id));
+}
+
+static Expect *victim;
+
+static void cancel_other(void *arg)
+{
+    (void)arg;
+    ui_timer_cancel(victim->id);
+}
+
+static void test_edge_cases(void)
+{
+    memset(expect, 0, sizeof(expect));
+    ui_timer_init(100);
+
+    // pool exhaustion
+    for (int i = 0; i < TIMER_COUNT; i++)
+        expect[i].id = ui_timer_start(NULL, 1000, 0, on_fire, &expect[i]);
+    CHECK(ui_timer_start(NULL, 1000, 0, on_fire, NULL) == UI_TIMER_NONE);
+    UiTimerStats stats;
+    ui_timer_get_stats(&stats);
+    CHECK(stats.exhausted == 1);
+    CHECK(stats.high_water == TIMER_COUNT);
+
+    // a stale handle must not cancel the timer that reused its slot
+    UiTimerId stale = expect[0].id;
+    CHECK(ui_timer_cancel(stale));
+    UiTimerId reused = ui_timer_start(NULL, 10, 0, on_fire, &expect[0]);
+    CHECK(reused != stale);
+    CHECK(!ui_timer_cancel(stale));
+    CHECK(ui_timer_pending(reused));
+    CHECK(!ui_timer_pending(UI_TIMER_NONE));
+
+    // a periodic timer can stop itself from its own callback
+    ui_timer_init(0);
+    self_runs = 0;
+    self_id = ui_timer_start(NULL, 5, 5, cancel_self, NULL);
+    ui_timer_run(100);
+    CHECK(self_runs == 1);
+    CHECK(ui_timer_next_expiry(100) == UI_TIMER_NEVER);
+
+    // a callback can cancel another timer due on the same tick
+    memset(expect, 0, sizeof(expect));
+    ui_timer_init(0);
+    victim = &expect[1];
+    expect[1].id = ui_timer_start(NULL, 20, 0, on_fire, &expect[1]);
+    ui_timer_start(NULL, 20, 0, cancel_other, NULL); // started last, so it runs first in the slot
+    ui_timer_run(50);
+    CHECK(expect[1].fired == 0);
+    CHECK(ui_timer_next_expiry(50) == UI_TIMER_NEVER);
+
+    // deadline is exact inside the first level
+    ui_timer_init(1000);
+    CHECK(ui_timer_next_expiry(1000) == UI_TIMER_NEVER);
+    ui_timer_start(NULL, 37, 0, on_fire, &expect[2]);
+    expect[2].expires = 1037;
+    CHECK(ui_timer_next_expiry(1000) == 37);
+    CHECK(ui_timer_next_expiry(1030) == 7);
+    CHECK(ui_timer_next_expiry(1040) == 0);
+    ui_timer_start(NULL, 0, 0, on_fire, &expect[3]); // 0 is one tick
+    expect[3].expires = 1001;
+    CHECK(ui_timer_next_expiry(1000) == 1);
+    ui_timer_run(1040);
+    CHECK(expect[2].fired == 1 && expect[2].late == 0);
+    CHECK(expect[3].fired == 1 && expect[3].late == 0);
+}
+
+/*
+    A display loop that sleeps until ui_timer_next_expiry() must hit every
+    expiry on time. Count its wakeups against a loop that polls each ms.
+*/
+static void test_sleep_loop(void)
+{
+    memset(expect, 0, sizeof(expect));
+    ui_timer_init(0);
+
+    // the UI's steady state: a game tick, a cursor blink, a debug refresh and some timeouts
+    uint32_t periods[] = {150, 500, 1000};
+    for (int i = 0; i < 3; i++)
+    {
+        expect[i].period = periods[i];
+        expect[i].expires = periods[i];
+        ui_timer_start(&owners[0], periods[i], periods[i], on_fire, &expect[i]);
+    }
+    for (int i = 3; i < 20; i++)
+    {
+        uint32_t delay = 1000 + rand() % 50000;
+        expect[i].expires = delay;
+        ui_timer_start(&owners[1], delay, 0, on_fire, &expect[i]);
+    }
+
+    uint32_t now = 0, wakeups = 0;
+    const uint32_t duration = 60000;
+    while (now < duration)
+    {
+        uint32_t sleep = ui_timer_next_expiry(now);
+        if (sleep == 0)
+            sleep = 1;
+        if (sleep > duration - now)
+            sleep = duration - now;
+        now += sleep;
+        ui_timer_run(now);
+        wakeups++;
+    }
+
+    uint32_t late = 0, missed = 0;
+    for (int i = 0; i < 20; i++)
+    {
+        late += expect[i].late;
+        if (expect[i].period ? expect[i].fired != duration / expect[i].period : expect[i].fired != 1)
+            missed++;
+    }
+    CHECK(late == 0);
+    CHECK(missed == 0);
+    printf("sleeping loop: %lu wakeups in %lu ms (polling: %lu), late %lu\n",
+           (unsigned long)wakeups, (unsigned long)duration, (unsigned long)duration, (unsigned long)late);
+}
+
+static void benchmark(void)
+{
+    static UiTimerId ids[TIMER_COUNT];
+    static uint32_t delays[TIMER_COUNT];
+    int sizes[] = {100, TIMER_COUNT};
+
+    for (int s = 0; s < 2; s++)
+    {
+        int n = sizes[s];
+        double start_ns = 0, cancel_ns = 0;
+        const int rounds = 20;
+        for (int i = 0; i < n; i++)
+            delays[i] = random_delay();
+        for (int r = 0; r < rounds; r++)
+        {
+            ui_timer_init(r * 7919);
+            double t = now_ns();
+            for (int i = 0; i < n; i++)
+                ids[i] = ui_timer_start(NULL, delays[i], 0, on_fire, &expect[0]);
+            start_ns += now_ns() - t;
+
+            t = now_ns();
+            for (int i = n - 1; i >= 0; i--)
+                ui_timer_cancel(ids[(i * 7) % n]);
+            cancel_ns += now_ns() - t;
+        }
+        printf("%5d pending: start %.1f ns, cancel %.1f ns\n",
+               n, start_ns / (rounds * n), cancel_ns / (rounds * n));
+    }
+}
+
+int main(void)
+{
+    srand(1);
+    test_one_shots(0);
+    test_one_shots(0xFFFFF000u); // clock wraps during the run
+    test_periodic_and_owners();
+    test_edge_cases();
+    test_sleep_loop();
+    benchmark();
+
+    return check_summary();
+}
@@ -0,0 +1,198 @@
+/**
+ * @file test_virtual_list.c
+ * @brief Virtual list host test and benchmark
+ * @ingroup tests
+ *
+ * Scrolls a 1,000 row list top to bottom and back, checking that each step
+ * issues at most one fetch and that scrolling up moves the window by one row
+ * instead of jumping back to the top. Also exercises the asynchronous path
+ * with a source that defers every row: late deliveries for rows that left
+ * the window are dropped, and a delivery the source never makes is asked
+ * for again once VLIST_RETRY_MS has passed on the UI timer clock.
+ *
+ * Build and run:
+ *   gcc -O2 -I./include/ui -I./include/ui/components -o test_virtual_list tests/test_virtual_list.c \
+ *       ui/components/virtual_list.c ui/tile.c ui/ui_timer.c
+ *   ./test_virtual_list
+ */
+
+#include "virtual_list.h"
+#include "ui_timer.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define ROWS 1000
+#define VISIBLE 9
+#define PREFETCH 3
+
+static int draws = 0;
+static char last_text[VLIST_ROW_LEN];
+static char text_buffer[VLIST_ROW_LEN];
+
+static void draw_row(int tile_y, int selected, const char *text)
+{
+    draws++;
+    strncpy(last_text, text, sizeof(last_text) - 1);
+}
+
+static int sync_count(void *ctx)
+{
+    return ROWS;
+}
+
+static bool sync_fetch(void *ctx, int index, char *out, int out_len)
+{
+    snprintf(out, out_len, "Contact %04d", index);
+    return true;
+}
+
+// slow source: remembers requests and answers them later
+static int pending[VLIST_MAX_SLOTS * 4];
+static int pending_count = 0;
+
+static bool async_fetch(void *ctx, int index, char *out, int out_len)
+{
+    pending[pending_count++] = index;
+    return false;
+}
+
+static bool was_requested(int index)
+{
+    for (int i = 0; i < pending_count; i++)
+    {
+        if (pending[i] == index)
+            return true;
+    }
+    return false;
+}
+
+// answer every request except one the source has lost
+static void deliver_pending(VirtualList *list, int lost)
+{
+    for (int i = 0; i < pending_count; i++)
+    {
+        char text[VLIST_ROW_LEN];
+        if (pending[i] == lost)
+            continue;
+        snprintf(text, sizeof(text), "Slow %d", pending[i]);
+        vlist_deliver(list, pending[i], text);
+    }
+    pending_count = 0;
+}
+
+static void flush_list(VirtualList *list)
+{
+    for (int ty = 0; ty < TILE_ROWS; ty++)
+        vlist_draw_tile(list, ty);
+}
+
+int main(void)
+{
+    VirtualList list;
+    VListSource source = {.count = sync_count, .fetch = sync_fetch, .ctx = NULL};
+
+    CHECK(vlist_init(&list, &source, draw_row, 0, 1, VISIBLE, PREFETCH));
+    CHECK(list.count == ROWS);
+    CHECK(list.fetches == VISIBLE + PREFETCH);
+
+    // scroll down one row at a time: at most one fetch per step
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint32_t worst = 0;
+    for (int i = 1; i < ROWS; i++)
+    {
+        uint32_t before = list.fetches;
+        CHECK(vlist_move(&list, +1));
+        if (list.fetches - before > worst)
+            worst = list.fetches - before;
+    }
+    CHECK(worst <= 1);
+    CHECK(list.selected == ROWS - 1);
+    CHECK(list.offset == ROWS - VISIBLE);
+    CHECK(!vlist_move(&list, +1));
+
+    // scroll back up: window follows one row at a time
+    int prev_offset = list.offset;
+    for (int i = ROWS - 2; i >= 0; i--)
+    {
+        uint32_t before = list.fetches;
+        vlist_move(&list, -1);
+        CHECK(list.fetches - before <= 1);
+        CHECK(list.offset == prev_offset || list.offset == prev_offset - 1);
+        prev_offset = list.offset;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    CHECK(list.selected == 0 && list.offset == 0);
+
+    double us = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / 1000.0;
+    printf("scroll %d rows down and up: %lu fetches, %.3f us/step\n",
+           ROWS, (unsigned long)list.fetches, us / (2 * (ROWS - 1)));
+
+    // the row at the selection is cached and drawn from cache
+    CHECK(vlist_selected_text(&list) != NULL);
+    CHECK(strcmp(vlist_selected_text(&list), "Contact 0000") == 0);
+    vlist_select(&list, 500);
+    CHECK(strcmp(vlist_selected_text(&list), "Contact 0500") == 0);
+    draws = 0;
+    flush_list(&list);
+    CHECK(draws == VISIBLE);
+
+    // asynchronous source: rows are placeholders until delivered
+    ui_timer_init(0);
+    VListSource slow = {.count = sync_count, .fetch = async_fetch, .ctx = NULL};
+    CHECK(vlist_init(&list, &slow, draw_row, 0, 1, VISIBLE, PREFETCH));
+    CHECK(pending_count == VISIBLE + PREFETCH);
+    CHECK(vlist_selected_text(&list) == NULL);
+    vlist_draw_tile(&list, 0);
+    CHECK(strcmp(last_text, "...") == 0);
+
+    deliver_pending(&list, -1);
+    vlist_draw_tile(&list, 0);
+    CHECK(strcmp(last_text, "Slow 0") == 0);
+
+    // a late delivery for a row that left the window is dropped, the row now in its slot keeps its own text
+    vlist_select(&list, 100);
+    deliver_pending(&list, -1);
+    int shares_slot = VLIST_MAX_SLOTS * (100 / VLIST_MAX_SLOTS);
+    CHECK(list.slots[shares_slot % VLIST_MAX_SLOTS].index == shares_slot);
+    vlist_deliver(&list, 0, "stale");
+    CHECK(strcmp(list.slots[0].text, "stale") != 0);
+    CHECK(vlist_selected_text(&list) != NULL);
+    CHECK(strcmp(vlist_selected_text(&list), "Slow 100") == 0);
+    vlist_draw_tile(&list, shares_slot - list.offset);
+    snprintf(text_buffer, sizeof(text_buffer), "Slow %d", shares_slot);
+    CHECK(strcmp(last_text, text_buffer) == 0);
+
+    // a delivery that never comes is not asked for again until it is overdue
+    vlist_select(&list, 200);
+    deliver_pending(&list, 200);
+    CHECK(vlist_selected_text(&list) == NULL);
+    ui_timer_run(VLIST_RETRY_MS - 1);
+    vlist_draw_tile(&list, 200 - list.offset);
+    CHECK(strcmp(last_text, "...") == 0);
+    CHECK(vlist_retry_pending(&list) == 0);
+    CHECK(pending_count == 0);
+
+    // then the timer retries it, and a synchronous answer would be drawn straight away
+    ui_timer_run(VLIST_RETRY_MS);
+    CHECK(vlist_retry_pending(&list) == 1);
+    CHECK(pending_count == 1 && was_requested(200));
+    deliver_pending(&list, -1);
+    CHECK(strcmp(vlist_selected_text(&list), "Slow 200") == 0);
+
+    // or drawing the placeholder retries it
+    vlist_select(&list, 300);
+    deliver_pending(&list, 300);
+    ui_timer_run(3 * VLIST_RETRY_MS);
+    vlist_draw_tile(&list, 300 - list.offset);
+    CHECK(was_requested(300));
+    deliver_pending(&list, -1);
+    CHECK(strcmp(vlist_selected_text(&list), "Slow 300") == 0);
+
+    // bad geometry is rejected
+    CHECK(!vlist_init(&list, &source, draw_row, 0, 1, VLIST_MAX_SLOTS, 1));
+
+    return check_summary();
+}
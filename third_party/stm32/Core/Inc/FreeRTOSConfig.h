@@ -165,6 +165,27 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* Run-time stats feed the watchdog task's CPU usage. The counter is the DWT cycle
+counter, enabled here through its register addresses because this header is also
+seen by files that do not include the CMSIS core header. */
+#define configGENERATE_RUN_TIME_STATS            1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() \
+  do { \
+    (*(volatile uint32_t *)0xE000EDFCUL) |= (1UL << 24); /* CoreDebug->DEMCR TRCENA */ \
+    (*(volatile uint32_t *)0xE0001000UL) |= 1UL;         /* DWT->CTRL CYCCNTENA */ \
+  } while (0)
+#define portGET_RUN_TIME_COUNTER_VALUE()         (*(volatile uint32_t *)0xE0001004UL) /* DWT->CYCCNT */
+/* Tickless idle, the sleep itself is kernel/core/tickless_idle.c. Driver test builds
+link without it and keep the plain tick. */
+#if defined(USE_FREERTOS)
+#define configUSE_TICKLESS_IDLE                  2
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP    2
+#endif
+/* Event trace into the RAM ring of kernel/core/trace.c, hooks shared with the
+host simulation. */
+#if defined(TRACE_ENABLED)
+#include "trace_freertos.h"
+#endif
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
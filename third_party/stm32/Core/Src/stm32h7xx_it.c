@@ -22,6 +22,8 @@
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "keypad.h"
+#include "trace.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -59,6 +61,7 @@ extern SD_HandleTypeDef hsd1;
 extern TIM_HandleTypeDef htim1;
 
 /* USER CODE BEGIN EV */
+extern RTC_HandleTypeDef hrtc;
 
 /* USER CODE END EV */
 
@@ -180,28 +183,99 @@ void TIM1_UP_IRQHandler(void)
 void SDMMC1_IRQHandler(void)
 {
   /* USER CODE BEGIN SDMMC1_IRQn 0 */
-
+  TRACE_ISR_ENTER();
   /* USER CODE END SDMMC1_IRQn 0 */
   HAL_SD_IRQHandler(&hsd1);
   /* USER CODE BEGIN SDMMC1_IRQn 1 */
-
+  TRACE_ISR_EXIT();
   /* USER CODE END SDMMC1_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
 
+/**
+ * @brief This function handles EXTI line0 interrupt.
+ */
+void EXTI0_IRQHandler(void)
+{
+  TRACE_ISR_ENTER();
+  keypad_exti_irq();
+  TRACE_ISR_EXIT();
+}
+
+/**
+ * @brief This function handles EXTI line1 interrupt.
+ */
+void EXTI1_IRQHandler(void)
+{
+  TRACE_ISR_ENTER();
+  keypad_exti_irq();
+  TRACE_ISR_EXIT();
+}
+
+/**
+ * @brief This function handles EXTI line2 interrupt.
+ */
+void EXTI2_IRQHandler(void)
+{
+  TRACE_ISR_ENTER();
+  keypad_exti_irq();
+  TRACE_ISR_EXIT();
+}
+
+/**
+ * @brief This function handles EXTI line3 interrupt.
+ */
+void EXTI3_IRQHandler(void)
+{
+  TRACE_ISR_ENTER();
+  keypad_exti_irq();
+  TRACE_ISR_EXIT();
+}
+
+/**
+ * @brief This function handles EXTI line4 interrupt.
+ */
+void EXTI4_IRQHandler(void)
+{
+  TRACE_ISR_ENTER();
+  keypad_exti_irq();
+  TRACE_ISR_EXIT();
+}
+
 /**
  * @brief This function handles EXTI line[9:5] interrupts.
  */
 void EXTI9_5_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI9_5_IRQn 0 */
-
+  TRACE_ISR_ENTER();
+  keypad_exti_irq();
   /* USER CODE END EXTI9_5_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(UART_RI_Pin);
   /* USER CODE BEGIN EXTI9_5_IRQn 1 */
-
+  TRACE_ISR_EXIT();
   /* USER CODE END EXTI9_5_IRQn 1 */
 }
 
+/**
+ * @brief This function handles RTC alarms (A and B) interrupt through EXTI line 17.
+ */
+void RTC_Alarm_IRQHandler(void)
+{
+  TRACE_ISR_ENTER();
+  HAL_RTC_AlarmIRQHandler(&hrtc);
+  TRACE_ISR_EXIT();
+}
+
+/**
+ * @brief This function handles EXTI line[15:10] interrupts.
+ */
+void EXTI15_10_IRQHandler(void)
+{
+  TRACE_ISR_ENTER();
+  keypad_exti_irq();
+  TRACE_ISR_EXIT();
+}
+
 /* USER CODE END 1 */
@@ -228,7 +228,10 @@
 /  _NORTC_MDAY and _NORTC_YEAR have no effect.
 /  These options have no effect at read-only configuration (_FS_READONLY = 1). */
 
-#define _FS_LOCK    2     /* 0:Disable or >=1:Enable */
+/* The font and the T9 dictionary stay open while the UI runs, on top of
+   a trace or sampler dump, a directory and file in the SD card driver, and the
+   source and temporary file minIni holds while it rewrites the config */
+#define _FS_LOCK    8     /* 0:Disable or >=1:Enable */
 /* The option _FS_LOCK switches file lock function to control duplicated file open
 /  and illegal operation to open objects. This option must be 0 when _FS_READONLY
 /  is 1.
@@ -84,7 +84,17 @@ See BSP_SD_ErrorCallback() and BSP_SD_AbortCallback() below
 * transfer data
 */
 /* USER CODE BEGIN enableScratchBuffer */
-/* #define ENABLE_SCRATCH_BUFFER */
+/* IDMA cannot reach DTCM, where .bss and the task stacks live, so buffers
+   there go through the scratch block in the non-cacheable DMA section. So do
+   cached buffers that share a cache line with other data; the rest get the
+   maintenance in dcache.h around their transfers */
+#include "mem_sections.h"
+#include "dcache.h"
+/* SDMMC runs from a PLL that Stop mode turns off, so a transfer holds the
+   idle sleep in WFI until it completes */
+#include "tickless_idle.h"
+#define ENABLE_SCRATCH_BUFFER
+#define SD_DMA_REACHABLE(p) ((((uint32_t)(p) & 0x3) == 0) && !MEM_IN_DTCM(p) && dcache_dma_aligned((p), BLOCKSIZE))
 /* USER CODE END enableScratchBuffer */
 
 /* Private variables ---------------------------------------------------------*/
@@ -92,7 +102,7 @@ See BSP_SD_ErrorCallback() and BSP_SD_AbortCallback() below
 #if defined (ENABLE_SD_DMA_CACHE_MAINTENANCE)
 ALIGN_32BYTES(static uint8_t scratch[BLOCKSIZE]); // 32-Byte aligned for cache maintenance
 #else
-__ALIGN_BEGIN static uint8_t scratch[BLOCKSIZE] __ALIGN_END;
+static uint8_t scratch[BLOCKSIZE] DMA_BUFFER;
 #endif
 #endif
 /* Disk status */
@@ -102,6 +112,9 @@ static volatile DSTATUS Stat = STA_NOINIT;
 static osMessageQId SDQueueID = NULL;
 #else
 static osMessageQueueId_t SDQueueID = NULL;
+/* the completion queue comes from static storage, like the task queues */
+static StaticQueue_t SDQueueCb DTCM_BSS;
+static uint8_t SDQueueStorage[QUEUE_SIZE * sizeof(uint16_t)] DTCM_BSS;
 #endif
 /* Private function prototypes -----------------------------------------------*/
 static DSTATUS SD_CheckStatus(BYTE lun);
@@ -211,7 +224,13 @@ Stat = STA_NOINIT;
       osMessageQDef(SD_Queue, QUEUE_SIZE, uint16_t);
       SDQueueID = osMessageCreate (osMessageQ(SD_Queue), NULL);
 #else
-      SDQueueID = osMessageQueueNew(QUEUE_SIZE, 2, NULL);
+      const osMessageQueueAttr_t SDQueueAttr = {
+        .name = "SD_Queue",
+        .cb_mem = &SDQueueCb,
+        .cb_size = sizeof(SDQueueCb),
+        .mq_mem = SDQueueStorage,
+        .mq_size = sizeof(SDQueueStorage)};
+      SDQueueID = osMessageQueueNew(QUEUE_SIZE, sizeof(uint16_t), &SDQueueAttr);
 #endif
       }
 
@@ -269,12 +288,14 @@ DRESULT SD_read(BYTE lun, BYTE *buff, DWORD sector, UINT count)
   {
     return res;
   }
+  tickless_stop_hold();
 
 #if defined(ENABLE_SCRATCH_BUFFER)
-  if (!((uint32_t)buff & 0x3))
+  if (SD_DMA_REACHABLE(buff))
   {
 #endif
     /* Fast path cause destination buffer is correctly aligned */
+    dcache_invalidate(buff, count * BLOCKSIZE);
     ret = BSP_SD_ReadBlocks_DMA((uint32_t*)buff, (uint32_t)(sector), count);
 
     if (ret == MSD_OK) {
@@ -301,6 +322,7 @@ DRESULT SD_read(BYTE lun, BYTE *buff, DWORD sector, UINT count)
               if (BSP_SD_GetCardState() == SD_TRANSFER_OK)
               {
                 res = RES_OK;
+                dcache_invalidate(buff, count * BLOCKSIZE);
 #if (ENABLE_SD_DMA_CACHE_MAINTENANCE == 1)
                 /*
                 the SCB_InvalidateDCache_by_Addr() requires a 32-Byte aligned address,
@@ -392,6 +414,7 @@ DRESULT SD_read(BYTE lun, BYTE *buff, DWORD sector, UINT count)
         res = RES_OK;
     }
 #endif
+  tickless_stop_release();
   return res;
 }
 
@@ -432,9 +455,10 @@ DRESULT SD_write(BYTE lun, const BYTE *buff, DWORD sector, UINT count)
   {
     return res;
   }
+  tickless_stop_hold();
 
 #if defined(ENABLE_SCRATCH_BUFFER)
-  if (!((uint32_t)buff & 0x3))
+  if (SD_DMA_REACHABLE(buff))
   {
 #endif
 #if (ENABLE_SD_DMA_CACHE_MAINTENANCE == 1)
@@ -447,6 +471,7 @@ DRESULT SD_write(BYTE lun, const BYTE *buff, DWORD sector, UINT count)
   SCB_CleanDCache_by_Addr((uint32_t*)alignedAddr, count*BLOCKSIZE + ((uint32_t)buff - alignedAddr));
 #endif
 
+  dcache_clean(buff, count * BLOCKSIZE);
   if(BSP_SD_WriteBlocks_DMA((uint32_t*)buff,
                            (uint32_t) (sector),
                            count) == MSD_OK)
@@ -560,6 +585,7 @@ DRESULT SD_write(BYTE lun, const BYTE *buff, DWORD sector, UINT count)
   }
 #endif
 
+  tickless_stop_release();
   return res;
 }
  #endif /* _USE_WRITE == 1 */
@@ -25,6 +25,12 @@
 
 
 #if _FS_REENTRANT
+#include "mem_sections.h"
+
+/* Control blocks for the sync objects, one per volume, so they do not come
+   out of the RTOS heap */
+static StaticSemaphore_t sync_cb[_VOLUMES] DTCM_BSS;
+
 /*------------------------------------------------------------------------*/
 /* Create a Synchronization Object                                        */
 /*------------------------------------------------------------------------*/
@@ -46,7 +52,10 @@ int ff_cre_syncobj (	/* 1:Function succeeded, 0:Could not create the sync object
     osMutexDef(MTX);
     *sobj = osMutexCreate(osMutex(MTX));
 #else
-    *sobj = osMutexNew(NULL);
+    const osMutexAttr_t attr = {
+        .cb_mem = &sync_cb[vol],
+        .cb_size = sizeof(sync_cb[vol])};
+    *sobj = osMutexNew(&attr);
 #endif
 
 #else
@@ -55,7 +64,10 @@ int ff_cre_syncobj (	/* 1:Function succeeded, 0:Could not create the sync object
     osSemaphoreDef(SEM);
     *sobj = osSemaphoreCreate(osSemaphore(SEM), 1);
 #else
-    *sobj = osSemaphoreNew(1, 1, NULL);
+    const osSemaphoreAttr_t attr = {
+        .cb_mem = &sync_cb[vol],
+        .cb_size = sizeof(sync_cb[vol])};
+    *sobj = osSemaphoreNew(1, 1, &attr);
 #endif
 
 #endif
@@ -0,0 +1,216 @@
+"""Build a Unicode bitmap font file for ui/font.c.
+
+Input is a BDF bitmap font, the usual format for hand-tuned small fonts
+(GNU Unifont, the X11 misc-fixed fonts, ...). TrueType fonts are rasterised
+with Pillow when it is installed; otherwise convert them to BDF first with
+otf2bdf. Glyphs taller or wider than 16 pixels are cropped.
+
+    python3 tools/font_build.py unifont.bdf font.ufn
+    python3 tools/font_build.py --ttf NotoSansCJK.ttf --size 16 font.ufn
+    python3 tools/font_build.py --synthetic font.ufn     # benchmark font
+
+--ranges limits the output to the listed code point ranges, e.g.
+"20-7E,A0-17F,370-3FF,400-4FF,3000-30FF,4E00-9FFF,1F300-1F6FF".
+
+Copy the output to the root of the SD card as font.ufn.
+"""
+
+import argparse
+import struct
+import sys
+
+MAX_SIZE = 16
+PAGE = 16
+TABLE_BLOCK = 32
+MAX_BLOCKS = 256
+
+DEFAULT_RANGES = "20-7E,A0-24F,370-3FF,400-4FF,2000-206F,20A0-20CF,2190-21FF,3000-30FF,4E00-9FFF,FF00-FFEF,1F300-1F6FF"
+
+
+def parse_ranges(text):
+    ranges = []
+    for part in text.split(","):
+        lo, _, hi = part.partition("-")
+        ranges.append((int(lo, 16), int(hi or lo, 16)))
+    return ranges
+
+
+def in_ranges(cp, ranges):
+    return any(lo <= cp <= hi for lo, hi in ranges)
+
+
+def read_bdf(path, ranges):
+    """Return (height, ascent, {code point: (advance, rows)})."""
+    glyphs = {}
+    ascent = descent = None
+    bbox = None
+    with open(path, encoding="latin-1") as f:
+        lines = iter(f.read().splitlines())
+    for line in lines:
+        key, _, value = line.partition(" ")
+        if key == "FONTBOUNDINGBOX":
+            bbox = [int(v) for v in value.split()]
+        elif key == "FONT_ASCENT":
+            ascent = int(value)
+        elif key == "FONT_DESCENT":
+            descent = int(value)
+        elif key == "STARTCHAR":
+            cp = advance = None
+            box = None
+            bitmap = []
+            for line in lines:
+                key, _, value = line.partition(" ")
+                if key == "ENCODING":
+                    cp = int(value.split()[0])
+                elif key == "DWIDTH":
+                    advance = int(value.split()[0])
+                elif key == "BBX":
+                    box = [int(v) for v in value.split()]
+                elif key == "BITMAP":
+                    bitmap = []
+                    for line in lines:
+                        if line.startswith("ENDCHAR"):
+                            break
+                        bitmap.append(int(line, 16) << (32 - 4 * len(line)))
+                    break
+            if cp is None or cp < 0 or box is None or not in_ranges(cp, ranges):
+                continue
+            glyphs[cp] = (advance, box, bitmap)
+
+    if ascent is None or descent is None:
+        if bbox is None:
+            raise ValueError(f"{path}: no FONT_ASCENT/FONT_DESCENT or FONTBOUNDINGBOX")
+        ascent, descent = bbox[1] + bbox[3], -bbox[3]
+    height = min(ascent + descent, MAX_SIZE)
+
+    out = {}
+    for cp, (advance, box, bitmap) in glyphs.items():
+        width, rows_high, xoff, yoff = box
+        advance = min(max(advance or width, 1), MAX_SIZE)
+        rows = [0] * height
+        top = ascent - (yoff + rows_high)  # first bitmap row in cell coordinates
+        for i, bits in enumerate(bitmap):
+            y = top + i
+            if 0 <= y < height:
+                # bits hold the bitmap row left-aligned in 32 bits
+                row = bits >> 16
+                row = row >> xoff if xoff >= 0 else row << -xoff
+                rows[y] = row & 0xFFFF & (0xFFFF << (MAX_SIZE - advance))
+        out[cp] = (advance, rows)
+    return height, min(ascent, height), out
+
+
+def read_ttf(path, size, ranges):
+    try:
+        from PIL import Image, ImageDraw, ImageFont
+    except ImportError:
+        sys.exit("TTF input needs Pillow (pip install pillow), or convert to BDF with otf2bdf")
+
+    font = ImageFont.truetype(path, size)
+    ascent, descent = font.getmetrics()
+    height = min(ascent + descent, MAX_SIZE)
+    out = {}
+    for lo, hi in ranges:
+        for cp in range(lo, hi + 1):
+            ch = chr(cp)
+            if font.getmask(ch).getbbox() is None and cp != 0x20:
+                continue  # not in the font
+            advance = min(max(int(round(font.getlength(ch))), 1), MAX_SIZE)
+            image = Image.new("1", (MAX_SIZE, height), 0)
+            ImageDraw.Draw(image).text((0, 0), ch, font=font, fill=1)
+            rows = []
+            for y in range(height):
+                row = 0
+                for x in range(advance):
+                    if image.getpixel((x, y)):
+                        row |= 0x8000 >> x
+                rows.append(row)
+            out[cp] = (advance, rows)
+    return height, min(ascent, height), out
+
+
+def synthetic_font(ranges, height=16):
+    """Deterministic pseudo-glyphs, see tests/test_font.c for the same formula."""
+    out = {}
+    for lo, hi in ranges:
+        for cp in range(lo, hi + 1):
+            # Latin, Greek and Cyrillic are half width, the rest full width
+            advance = 8 if cp < 0x2000 else 16
+            rows = []
+            for y in range(height):
+                h = (cp * 2654435761 + y * 40503) & 0xFFFFFFFF
+                h ^= h >> 15
+                rows.append(h & 0xFFFF & (0xFFFF << (MAX_SIZE - advance)))
+            out[cp] = (advance, rows)
+    return height, height - 3, out
+
+
+def encode(height, ascent, glyphs):
+    pages = {}
+    for cp in sorted(glyphs):
+        pages.setdefault(cp // PAGE, []).append(cp)
+
+    page_numbers = sorted(pages)
+    blocks = (len(page_numbers) + TABLE_BLOCK - 1) // TABLE_BLOCK
+    if blocks > MAX_BLOCKS:
+        raise ValueError(f"{len(page_numbers)} pages, at most {MAX_BLOCKS * TABLE_BLOCK} are supported")
+
+    header_size = 20
+    keys_size = 4 * blocks
+    table_offset = header_size + keys_size
+    data_offset = table_offset + 12 * len(page_numbers)
+
+    table = bytearray()
+    data = bytearray()
+    for page in page_numbers:
+        mask = 0
+        body = bytearray()
+        for cp in pages[page]:
+            advance, rows = glyphs[cp]
+            mask |= 1 << (cp % PAGE)
+            body.append(advance)
+            for row in rows:
+                if advance > 8:
+                    body += struct.pack(">H", row)
+                else:
+                    body.append(row >> 8)
+        table += struct.pack("<IIHH", page, data_offset + len(data), len(body), mask)
+        data += body
+
+    keys = b"".join(struct.pack("<I", page_numbers[i]) for i in range(0, len(page_numbers), TABLE_BLOCK))
+    max_advance = max(advance for advance, _ in glyphs.values())
+    header = b"UFN1" + struct.pack("<BBBBIII", height, ascent, max_advance, 0,
+                                   len(page_numbers), table_offset, len(glyphs))
+    return header + keys + bytes(table) + bytes(data), len(page_numbers)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", help="BDF font")
+    parser.add_argument("output", help="font file to write")
+    parser.add_argument("--ttf", help="TrueType font to rasterise instead of a BDF")
+    parser.add_argument("--size", type=int, default=MAX_SIZE, help="pixel size for --ttf")
+    parser.add_argument("--synthetic", action="store_true", help="generate a benchmark font")
+    parser.add_argument("--ranges", default=DEFAULT_RANGES, help="hex code point ranges to keep")
+    args = parser.parse_args()
+
+    ranges = parse_ranges(args.ranges)
+    if args.synthetic:
+        height, ascent, glyphs = synthetic_font(ranges)
+    elif args.ttf:
+        height, ascent, glyphs = read_ttf(args.ttf, args.size, ranges)
+    elif args.input:
+        height, ascent, glyphs = read_bdf(args.input, ranges)
+    else:
+        parser.error("give a BDF font, --ttf or --synthetic")
+
+    if not glyphs:
+        sys.exit("no glyphs in the selected ranges")
+    blob, page_count = encode(height, ascent, glyphs)
+    with open(args.output, "wb") as f:
+        f.write(blob)
+    print(f"{len(glyphs)} glyphs in {page_count} pages, height {height}, {len(blob)} bytes")
+
+
+if __name__ == "__main__":
+    main()
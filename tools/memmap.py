@@ -0,0 +1,173 @@
+"""Print where the firmware's memory went, from the GNU ld map file.
+
+The firmware build runs this after linking. It shows the usage of each
+memory region, the output sections placed in each, the objects pinned
+with DTCM_BSS, DMA_BUFFER, FASTDATA and RAMFUNC
+(include/board/mem_sections.h), and the
+largest objects in each region.
+
+    python3 tools/memmap.py build/Firmware.map
+    python3 tools/memmap.py build/Firmware.map --elf build/Firmware.elf --top 15
+
+The map lists input sections by object file but names only global
+symbols. With --elf, the symbol table is read with arm-none-eabi-nm so
+function-local statics such as task stacks and control blocks are listed
+by name too. Only the standard library is used.
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+
+# output sections that take no target memory
+IGNORED = (".debug", ".comment", ".ARM.attributes", ".stab", ".gnu.attributes", "/DISCARD/")
+# input sections listed object by object
+PLACED = (".dtcm_bss", ".dma_buffers", ".dtcm_data", ".itcm_text")
+
+HEX = r"0x[0-9a-fA-F]+"
+SECTION_RE = re.compile(r"^( ?)([^\s*]\S*)\s+(" + HEX + r")\s+(" + HEX + r")(?:\s+load address\s+(" + HEX + r"))?\s*(.*)$")
+
+
+class Region:
+    def __init__(self, name, origin, length):
+        self.name = name
+        self.origin = origin
+        self.length = length
+        self.sections = []
+
+    def contains(self, addr):
+        return self.origin <= addr < self.origin + self.length
+
+    def used(self):
+        return sum(size for _, _, size in self.sections)
+
+
+def parse_map(lines):
+    """Return the regions, the output sections and the pinned input sections."""
+    regions = []
+    outputs = []
+    placed = []
+    section = None
+    i = 0
+    for i, line in enumerate(lines):
+        if line.startswith(("Memory Configuration", "Linker script and memory map")):
+            section = line[0]
+            if section == "L":
+                break
+            continue
+        fields = line.split()
+        if section == "M" and len(fields) >= 3 and fields[1].startswith("0x") and fields[0] != "*default*":
+            regions.append(Region(fields[0], int(fields[1], 16), int(fields[2], 16)))
+
+    pending = None  # a name too long for its column wraps onto its own line
+    for line in lines[i:]:
+        line = line.rstrip("\r\n")
+        if not line.strip():
+            pending = None
+            continue
+        if pending is None and re.match(r"^ ?\.?\S+$", line) and not line.strip().startswith(("*", "0x")):
+            pending = line
+            continue
+        if pending is not None:
+            line = pending + line
+            pending = None
+        m = SECTION_RE.match(line)
+        if not m:
+            continue
+        name = m.group(2)
+        addr, size = int(m.group(3), 16), int(m.group(4), 16)
+        load = int(m.group(5), 16) if m.group(5) else None
+        if not m.group(1):
+            if size and not name.startswith(IGNORED):
+                outputs.append((name, addr, size, load))
+        elif name.startswith(PLACED) and size:
+            placed.append((name, addr, size, m.group(6).strip()))
+    return regions, outputs, placed
+
+
+def read_symbols(elf, nm):
+    """Return (address, size, name) for every sized data and code symbol."""
+    try:
+        out = subprocess.run([nm, "-S", "-C", elf], check=True, capture_output=True, text=True).stdout
+    except (OSError, subprocess.CalledProcessError) as err:
+        print("memmap: cannot read symbols from %s: %s" % (elf, err), file=sys.stderr)
+        return []
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in "bBdDrRtT":
+            symbols.append((int(fields[0], 16), int(fields[1], 16), fields[3]))
+    return symbols
+
+
+def region_of(regions, addr):
+    for region in regions:
+        if region.contains(addr):
+            return region
+    return None
+
+
+def short(path):
+    return path.replace("\\", "/").rsplit("/", 1)[-1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map", help="map file written by the linker (-Wl,-Map)")
+    parser.add_argument("--elf", help="linked image, for symbol names")
+    parser.add_argument("--nm", default="arm-none-eabi-nm", help="nm for the target (default %(default)s)")
+    parser.add_argument("--top", type=int, default=10, help="largest objects listed per region (default %(default)s)")
+    args = parser.parse_args()
+
+    with open(args.map, encoding="utf-8", errors="replace") as f:
+        regions, outputs, placed = parse_map(f.readlines())
+    if not regions:
+        sys.exit("memmap: no Memory Configuration in %s" % args.map)
+
+    for name, addr, size, load in outputs:
+        region = region_of(regions, addr)
+        if region:
+            region.sections.append((name, addr, size))
+        # initialised data also takes its copy in flash
+        if load is not None and load != addr:
+            image = region_of(regions, load)
+            if image:
+                image.sections.append((name + " (load)", load, size))
+
+    print("%-10s %10s %10s %10s %6s" % ("Region", "Origin", "Size", "Used", "Use%"))
+    for region in regions:
+        used = region.used()
+        print("%-10s 0x%08x %10d %10d %5.1f%%" % (region.name, region.origin, region.length, used,
+                                                  100.0 * used / region.length if region.length else 0))
+
+    for region in regions:
+        if not region.sections:
+            continue
+        print("\n%s" % region.name)
+        for name, addr, size in sorted(region.sections, key=lambda s: s[1]):
+            print("  %-24s 0x%08x %8d" % (name, addr, size))
+
+    symbols = read_symbols(args.elf, args.nm) if args.elf else []
+
+    if placed:
+        print("\nPinned objects")
+        for name, addr, size, obj in sorted(placed, key=lambda p: p[1]):
+            region = region_of(regions, addr)
+            print("  %-12s %-8s 0x%08x %8d  %s" % (name, region.name if region else "?", addr, size, short(obj)))
+            for sym_addr, sym_size, sym in sorted(symbols):
+                if addr <= sym_addr < addr + size:
+                    print("    %-40s %8d" % (sym, sym_size))
+
+    if symbols:
+        for region in regions:
+            inside = [s for s in symbols if region.contains(s[0])]
+            if not inside:
+                continue
+            print("\nLargest in %s" % region.name)
+            for sym_addr, sym_size, sym in sorted(inside, key=lambda s: -s[1])[:args.top]:
+                print("  %-40s 0x%08x %8d" % (sym, sym_addr, sym_size))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,273 @@
+"""Stand in for the RC7620 modem of the host simulation.
+
+The simulation (sim/) connects the modem UART to a pseudo-terminal and
+prints its name, or links it with --modem-link. This script opens that
+terminal and answers the AT commands the firmware sends, so the cellular
+task gets through its start-up and the phone and SMS pages have a network
+to talk to.
+
+    build/sim/UniQOS-sim --modem-link /tmp/uniqos-modem &
+    python3 tools/modem_sim.py /tmp/uniqos-modem
+
+Lines typed on stdin play the network side:
+
+    ring NUMBER          incoming call, RING and +CLIP
+    answer               the far end picks up the call we dialled
+    hangup               the far end hangs up, NO CARRIER
+    sms NUMBER TEXT      incoming SMS, stored and announced with +CMTI
+    signal RSSI          +CSQ reading, 0-31 or 99 for unknown
+
+Commands the script does not know are answered with OK, as most of what
+the firmware sends during start-up is configuration. Only the standard
+library is used.
+"""
+
+import argparse
+import os
+import select
+import sys
+import termios
+import time
+import tty
+
+CTRL_Z = b"\x1a"
+ESC = b"\x1b"
+
+# +CLCC <dir> and <stat>
+DIR_MO, DIR_MT = 0, 1
+STAT_ACTIVE, STAT_DIALING, STAT_INCOMING = 0, 2, 4
+
+
+class Modem:
+    def __init__(self, fd, verbose):
+        self.fd = fd
+        self.verbose = verbose
+        self.echo = True
+        self.rssi = 20
+        self.calls = []
+        self.messages = {}
+        self.next_sms = 1
+        self.next_mr = 1
+        self.line = b""
+        self.sms_to = None
+        self.sms_text = b""
+
+    def send(self, text):
+        data = text.encode("latin-1") if isinstance(text, str) else text
+        os.write(self.fd, data)
+
+    def reply(self, *lines, status="OK"):
+        out = "".join("\r\n" + line + "\r\n" for line in lines)
+        self.send(out + "\r\n" + status + "\r\n")
+
+    def log(self, text):
+        if self.verbose:
+            print(text, flush=True)
+
+    # ----- from the firmware -----
+
+    def feed(self, data):
+        for byte in data:
+            ch = bytes([byte])
+            if self.sms_to is not None:
+                self.sms_byte(ch)
+                continue
+            if self.echo:
+                self.send(ch)
+            if ch == b"\r":
+                line = self.line.strip()
+                self.line = b""
+                if line:
+                    self.command(line.decode("latin-1"))
+            elif ch != b"\n":
+                self.line += ch
+
+    def sms_byte(self, ch):
+        if ch == CTRL_Z:
+            text = self.sms_text.decode("latin-1")
+            print("sms to %s: %s" % (self.sms_to, text), flush=True)
+            self.reply("+CMGS: %d" % self.next_mr)
+            self.next_mr = self.next_mr % 255 + 1
+            self.sms_to = None
+        elif ch == ESC:
+            self.sms_to = None
+            self.reply()
+        else:
+            if self.echo:
+                self.send(ch)
+            self.sms_text += ch
+
+    def command(self, line):
+        self.log("<< " + line)
+        upper = line.upper()
+        if not upper.startswith("AT"):
+            self.reply(status="ERROR")
+            return
+        # AT+CPMS="SM";+CMGR=5 chains commands, one final result for all
+        lines = []
+        for part in split_chain(line[2:]):
+            result = self.one(part)
+            if result is None:
+                return
+            if result is False:
+                self.reply(*lines, status="ERROR")
+                return
+            lines.extend(result)
+        self.reply(*lines)
+
+    def one(self, cmd):
+        """Lines of one command's answer, False for ERROR, None when answered already."""
+        upper = cmd.upper()
+        if upper in ("", "Z", "&F"):
+            return []
+        if upper.startswith("E") and upper[1:] in ("0", "1"):
+            self.echo = upper == "E1"
+            return []
+        if upper == "+CSQ":
+            return ["+CSQ: %d,99" % self.rssi]
+        if upper == "+CCLK?":
+            return ['+CCLK: "%s"' % clock_now()]
+        if upper == "+CPIN?":
+            return ["+CPIN: READY"]
+        if upper == "+CREG?":
+            return ["+CREG: 0,1"]
+        if upper == "+CEREG?":
+            return ["+CEREG: 0,1"]
+        if upper.startswith("+CPMS="):
+            used = len(self.messages)
+            return ["+CPMS: %d,255,%d,255,%d,255" % (used, used, used)]
+        if upper.startswith("+CMGR="):
+            return self.read_sms(cmd[6:])
+        if upper.startswith("+CMGD="):
+            self.messages.pop(to_int(cmd[6:].split(",")[0]), None)
+            return []
+        if upper.startswith("+CMGS="):
+            self.sms_to = cmd[6:].strip('"')
+            self.sms_text = b""
+            self.send("\r\n> ")
+            return None
+        if upper == "+CLCC":
+            return [
+                '+CLCC: %d,%d,%d,0,0,"%s",145' % (i + 1, call["dir"], call["stat"], call["number"])
+                for i, call in enumerate(self.calls)
+            ]
+        if upper.startswith("D"):
+            number = cmd[1:].rstrip(";")
+            self.calls = [{"dir": DIR_MO, "stat": STAT_DIALING, "number": number}]
+            print("dialling %s, 'answer' or 'hangup'" % number, flush=True)
+            return []
+        if upper == "A":
+            if not self.calls:
+                return False
+            self.calls[0]["stat"] = STAT_ACTIVE
+            print("call answered", flush=True)
+            return []
+        if upper in ("H", "H0", "+CHUP"):
+            if self.calls:
+                print("call ended by the phone", flush=True)
+            self.calls = []
+            return []
+        return []
+
+    def read_sms(self, arg):
+        index = to_int(arg)
+        message = self.messages.get(index)
+        if message is None:
+            return False
+        state = "REC READ" if message["read"] else "REC UNREAD"
+        message["read"] = True
+        return ['+CMGR: "%s","%s",,"%s"\r\n%s' % (state, message["number"], message["time"], message["text"])]
+
+    # ----- from the network, typed on stdin -----
+
+    def network(self, line):
+        word, _, rest = line.strip().partition(" ")
+        word = word.lower()
+        if word == "ring" and rest:
+            self.calls = [{"dir": DIR_MT, "stat": STAT_INCOMING, "number": rest.strip()}]
+            # one burst, the firmware reads RING and +CLIP in a single receive
+            self.send('\r\nRING\r\n\r\n+CLIP: "%s",145,,,,0\r\n' % rest.strip())
+        elif word == "answer" and self.calls:
+            self.calls[0]["stat"] = STAT_ACTIVE
+        elif word == "hangup":
+            self.calls = []
+            self.send("\r\nNO CARRIER\r\n")
+        elif word == "sms" and rest:
+            number, _, text = rest.strip().partition(" ")
+            index = self.next_sms
+            self.next_sms += 1
+            self.messages[index] = {"number": number, "text": text, "time": clock_now(), "read": False}
+            self.send('\r\n+CMTI: "SM",%d\r\n' % index)
+        elif word == "signal" and rest:
+            self.rssi = to_int(rest)
+        elif word:
+            print("commands: ring NUMBER, answer, hangup, sms NUMBER TEXT, signal RSSI", flush=True)
+
+
+def split_chain(text):
+    parts = []
+    current = ""
+    quoted = False
+    for ch in text:
+        if ch == '"':
+            quoted = not quoted
+        if ch == ";" and not quoted:
+            parts.append(current)
+            current = ""
+        else:
+            current += ch
+    # ATD<number>; ends in a semicolon that is part of the command
+    if current or not parts:
+        parts.append(current)
+    elif parts[-1].upper().startswith("D"):
+        parts[-1] += ";"
+    return parts
+
+
+def to_int(text):
+    try:
+        return int(text.strip())
+    except ValueError:
+        return 0
+
+
+def clock_now():
+    now = time.localtime()
+    quarters = (now.tm_gmtoff or 0) // 900
+    return time.strftime("%y/%m/%d,%H:%M:%S", now) + "%+03d" % quarters
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("tty", help="modem terminal printed by the simulation, or its --modem-link")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print every AT command")
+    args = parser.parse_args()
+
+    fd = os.open(args.tty, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd, termios.TCSANOW)
+    modem = Modem(fd, args.verbose)
+    print("modem on %s, type commands for the network side" % args.tty, flush=True)
+
+    inputs = [fd, sys.stdin]
+    while True:
+        ready, _, _ = select.select(inputs, [], [])
+        if fd in ready:
+            try:
+                data = os.read(fd, 512)
+            except OSError:
+                # the simulation closed its end
+                break
+            if not data:
+                break
+            modem.feed(data)
+        if sys.stdin in ready:
+            line = sys.stdin.readline()
+            if not line:
+                inputs.remove(sys.stdin)
+                continue
+            modem.network(line)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,219 @@
+"""Turn a PC sampler dump into a profile.
+
+The firmware writes the dump from Debug > Sampler (include/kernel/sampler.h),
+to samples.bin on the SD card and, when the board has a debug UART, over
+the UART. Either capture can be given here. Bytes before the dump, such
+as log lines in a UART capture, are skipped.
+
+    python3 tools/sample_profile.py samples.bin --elf build/Firmware.elf
+    python3 tools/sample_profile.py uart.log --elf build/Firmware.elf --lines --callers
+
+Every sample is the PC the sampling interrupt stacked, with the LR and the
+task that was running. The PCs and LRs are symbolised against the ELF with
+addr2line (arm-none-eabi-addr2line by default) into functions, or with
+--lines into source lines. The flat profile ranks them over the whole
+capture. The task profile splits the samples by task first, with
+interrupt handlers that were interrupted in a group of their own, and
+ranks within each task. --callers adds the function the LR points into,
+usually the caller, which tells apart the users of a shared busy-wait.
+
+Without --elf the raw addresses are ranked. Only the standard library is
+used besides addr2line.
+"""
+
+import argparse
+import shutil
+import struct
+import subprocess
+import sys
+
+MAGIC = b"UQPS"
+END = b"UQPE"
+VERSION = 1
+HEADER = struct.Struct("<4sHHIIIIHHI")
+NAME = struct.Struct("<I12s")
+RECORD = struct.Struct("<IIIHH")
+
+# an LR at or above this is an EXC_RETURN value, the sample was taken in a handler's first instructions
+EXC_RETURN = 0xFFFFFF00
+
+
+class Dump:
+    def __init__(self, header, names, records):
+        (_, self.version, _, self.rate_hz, self.capacity, self.taken, self.count, _, _, _) = header
+        self.tasks = dict(names)
+        self.records = records  # (pc, lr, task, exception)
+
+
+def parse(data):
+    """Find the dump in data, check it and return a Dump."""
+    error = "no sampler dump found"
+    start = data.find(MAGIC)
+    while start >= 0:
+        try:
+            return parse_at(data, start)
+        except ValueError as err:
+            error = str(err)
+        start = data.find(MAGIC, start + 1)
+    raise ValueError(error)
+
+
+def parse_at(data, start):
+    if len(data) - start < HEADER.size:
+        raise ValueError("dump header cut short")
+    header = HEADER.unpack_from(data, start)
+    version, record_size, capacity, count, name_count, name_size = (
+        header[1], header[2], header[4], header[6], header[7], header[8])
+    if version != VERSION or record_size != RECORD.size or name_size != NAME.size:
+        raise ValueError("unsupported dump version %d" % version)
+    if capacity == 0 or capacity & (capacity - 1) or count > capacity:
+        raise ValueError("bad ring size %d" % capacity)
+
+    pos = start + HEADER.size
+    body_end = pos + name_count * NAME.size + count * RECORD.size
+    if len(data) < body_end + 8:
+        raise ValueError("dump cut short, %d of %d bytes" % (len(data) - start, body_end + 8 - start))
+    if data[body_end:body_end + 4] != END:
+        raise ValueError("dump trailer missing")
+    (checksum,) = struct.unpack_from("<I", data, body_end + 4)
+    if sum(data[start:body_end]) & 0xFFFFFFFF != checksum:
+        raise ValueError("dump checksum mismatch")
+
+    names = []
+    for _ in range(name_count):
+        task, raw = NAME.unpack_from(data, pos)
+        names.append((task, raw.split(b"\0", 1)[0].decode("ascii", "replace")))
+        pos += NAME.size
+
+    records = []
+    for _ in range(count):
+        pc, lr, task, exception, _ = RECORD.unpack_from(data, pos)
+        pos += RECORD.size
+        records.append((pc, lr, task, exception))
+    return Dump(header, names, records)
+
+
+def find_addr2line(wanted):
+    if wanted:
+        return wanted
+    for tool in ("arm-none-eabi-addr2line", "addr2line"):
+        if shutil.which(tool):
+            return tool
+    sys.exit("sample_profile: no addr2line found, give one with --addr2line")
+
+
+class Symbols:
+    """Function and source line of addresses, looked up in one addr2line run."""
+
+    def __init__(self, elf, addr2line, addresses):
+        self.table = {}
+        if not elf:
+            return
+        addresses = sorted(addresses)
+        if not addresses:
+            return
+        cmd = [addr2line, "-f", "-C", "-a", "-e", elf] + ["0x%08x" % a for a in addresses]
+        try:
+            out = subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+        except (OSError, subprocess.CalledProcessError) as err:
+            sys.exit("sample_profile: %s failed: %s" % (addr2line, err))
+        # three lines per address: the address, the function, file:line
+        lines = out.splitlines()
+        for i in range(0, len(lines) - 2, 3):
+            address = int(lines[i], 16)
+            function = lines[i + 1]
+            where = lines[i + 2]
+            self.table[address] = (function, where)
+
+    def function(self, address):
+        function, _ = self.table.get(address, ("??", "??:0"))
+        return function if function != "??" else "0x%08x" % address
+
+    def line(self, address):
+        function, where = self.table.get(address, ("??", "??:0"))
+        if where.startswith("??"):
+            return self.function(address)
+        # addr2line may add a discriminator, and the directories are noise here
+        where = where.split(" ", 1)[0].rsplit("/", 1)[-1]
+        return "%s %s" % (function, where) if function != "??" else where
+
+
+def call_site(lr):
+    """Address inside the call instruction an LR returns from, None for an exception return."""
+    if lr >= EXC_RETURN or lr < 2:
+        return None
+    # Thumb return addresses have bit 0 set and follow the call
+    return (lr & ~1) - 2
+
+
+def context_name(dump, task, exception):
+    if exception:
+        return "IRQ %d" % (exception - 16) if exception >= 16 else "exception %d" % exception
+    if task == 0:
+        return "before scheduler"
+    return dump.tasks.get(task, "task 0x%08x" % task)
+
+
+def rank(counts, total, top, indent=""):
+    for key, n in sorted(counts.items(), key=lambda item: (-item[1], item[0]))[:top]:
+        print("%s%7d %6.1f%%  %s" % (indent, n, 100.0 * n / total, key))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", help="samples.bin from the SD card, or a UART capture holding a dump")
+    parser.add_argument("--elf", help="firmware ELF the samples were taken from")
+    parser.add_argument("--addr2line", help="addr2line to use (default arm-none-eabi-addr2line, then addr2line)")
+    parser.add_argument("--lines", action="store_true", help="rank source lines instead of functions")
+    parser.add_argument("--callers", action="store_true", help="pair each function with the one its LR is in")
+    parser.add_argument("--top", type=int, default=20, help="entries per list (default %(default)s)")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        data = f.read()
+    try:
+        dump = parse(data)
+    except ValueError as err:
+        sys.exit("sample_profile: %s: %s" % (args.dump, err))
+
+    total = len(dump.records)
+    span = " over %.2f s" % (total / dump.rate_hz) if dump.rate_hz else ""
+    rate = "%d Hz" % dump.rate_hz if dump.rate_hz else "an unknown rate"
+    print("%d samples at %s%s, %d lost to the ring wrapping"
+          % (total, rate, span, max(dump.taken - dump.capacity, 0)))
+    if not total:
+        return
+
+    addresses = {pc for pc, _, _, _ in dump.records}
+    if args.callers:
+        addresses |= {call_site(lr) for _, lr, _, _ in dump.records} - {None}
+    symbols = Symbols(args.elf, find_addr2line(args.addr2line) if args.elf else None, addresses)
+    where = symbols.line if args.lines else symbols.function
+
+    def key(pc, lr):
+        if args.callers:
+            site = call_site(lr)
+            caller = symbols.function(site) if site is not None else "(interrupt entry)"
+            return "%s  <-  %s" % (where(pc), caller)
+        return where(pc)
+
+    flat = {}
+    by_context = {}
+    for pc, lr, task, exception in dump.records:
+        k = key(pc, lr)
+        flat[k] = flat.get(k, 0) + 1
+        context = by_context.setdefault(context_name(dump, task, exception), {})
+        context[k] = context.get(k, 0) + 1
+
+    print("\nFlat profile\n%7s %7s  %s" % ("Samples", "Share", "Line" if args.lines else "Function"))
+    rank(flat, total, args.top)
+
+    print("\nBy task")
+    for name, counts in sorted(by_context.items(), key=lambda item: -sum(item[1].values())):
+        n = sum(counts.values())
+        print("\n%7d %6.1f%%  %s" % (n, 100.0 * n / total, name))
+        rank(counts, n, args.top, "    ")
+
+
+if __name__ == "__main__":
+    main()
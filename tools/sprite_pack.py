@@ -0,0 +1,210 @@
+"""Pack PNG sprites into an RGB565 sprite sheet for ui/sprite.c.
+
+Each input PNG becomes one sprite named after its file. Pixels with alpha
+below the threshold become SPRITE_KEY (magenta, 0xF81F) and are skipped by
+the blitter. Opaque pixels that happen to convert to the key are nudged one
+step of blue so they stay visible.
+
+    python3 tools/sprite_pack.py --name game_sprites \\
+        --header include/ui/game_sprites.h --source ui/game_sprites.c \\
+        icons/sprites/*.png
+
+Only the standard library is used. 8-bit greyscale, RGB, palette and RGBA
+PNGs without interlacing are supported, which covers what image editors
+export for small sprites.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+SPRITE_KEY = 0xF81F
+PNG_MAGIC = b"\x89PNG\r\n\x1a\n"
+CHANNELS = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def read_png(path):
+    """Return (width, height, rows of (r, g, b, a) tuples)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(PNG_MAGIC):
+        raise ValueError(f"{path}: not a PNG file")
+
+    pos = len(PNG_MAGIC)
+    idat = b""
+    palette = []
+    trns = b""
+    width = height = depth = colour = interlace = None
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, colour, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"PLTE":
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            trns = body
+        elif kind == b"IDAT":
+            idat += body
+        elif kind == b"IEND":
+            break
+
+    if depth != 8 or interlace != 0 or colour not in CHANNELS:
+        raise ValueError(f"{path}: only 8-bit, non-interlaced PNGs are supported")
+
+    bpp = CHANNELS[colour]
+    stride = width * bpp
+    raw = zlib.decompress(idat)
+    rows = []
+    prev = bytearray(stride)
+    for y in range(height):
+        start = y * (stride + 1)
+        kind = raw[start]
+        line = bytearray(raw[start + 1:start + 1 + stride])
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if kind == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif kind == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif kind == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xFF
+            elif kind == 4:
+                line[i] = (line[i] + paeth(a, b, c)) & 0xFF
+        prev = line
+
+        row = []
+        for x in range(width):
+            px = line[x * bpp:(x + 1) * bpp]
+            if colour == 0:
+                row.append((px[0], px[0], px[0], 255))
+            elif colour == 2:
+                row.append((px[0], px[1], px[2], 255))
+            elif colour == 3:
+                r, g, b = palette[px[0]]
+                alpha = trns[px[0]] if px[0] < len(trns) else 255
+                row.append((r, g, b, alpha))
+            elif colour == 4:
+                row.append((px[0], px[0], px[0], px[1]))
+            else:
+                row.append(tuple(px))
+        rows.append(row)
+    return width, height, rows
+
+
+def rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def convert(path, alpha_threshold):
+    width, height, rows = read_png(path)
+    if width > 255 or height > 255:
+        raise ValueError(f"{path}: sprites are limited to 255x255")
+    pixels = []
+    nudged = 0
+    for row in rows:
+        for r, g, b, a in row:
+            if a < alpha_threshold:
+                pixels.append(SPRITE_KEY)
+                continue
+            value = rgb565(r, g, b)
+            if value == SPRITE_KEY:
+                value -= 1
+                nudged += 1
+            pixels.append(value)
+    if nudged:
+        print(f"{path}: {nudged} opaque pixels matched the key and were nudged", file=sys.stderr)
+    return width, height, pixels
+
+
+def identifier(text):
+    return re.sub(r"[^0-9a-zA-Z]", "_", text).strip("_").lower()
+
+
+def write_header(path, name, sprites):
+    guard = name.upper() + "_H"
+    enum = [f"    {name.upper()}_{identifier(s).upper()}," for s, _, _, _ in sprites]
+    with open(path, "w") as f:
+        f.write(f"""/**
+ * @file {os.path.basename(path)}
+ * @brief Packed sprite sheet
+ * @ingroup ui_screen
+ *
+ * Generated by tools/sprite_pack.py, do not edit. Regenerate from the PNGs
+ * after changing them.
+ */
+
+#ifndef {guard}
+#define {guard}
+
+#include "sprite.h"
+
+typedef enum
+{{
+{chr(10).join(enum)}
+    {name.upper()}_COUNT,
+}} {''.join(part.title() for part in name.split('_'))}Id;
+
+extern const Sprite {name}[{name.upper()}_COUNT];
+
+#endif
+""")
+
+
+def write_source(path, header, name, sprites):
+    total = sum(len(p) for _, _, _, p in sprites)
+    with open(path, "w") as f:
+        f.write(f'#include "{os.path.basename(header)}"\n\n')
+        f.write("// Generated by tools/sprite_pack.py, do not edit\n\n")
+        f.write(f"static const uint16_t {name}_pixels[{total}] = {{\n")
+        for sprite, width, height, pixels in sprites:
+            f.write(f"    // {sprite}, {width}x{height}\n")
+            for i in range(0, len(pixels), 12):
+                f.write("    " + ", ".join(f"0x{p:04X}" for p in pixels[i:i + 12]) + ",\n")
+        f.write("};\n\n")
+
+        f.write(f"const Sprite {name}[{name.upper()}_COUNT] = {{\n")
+        offset = 0
+        for sprite, width, height, pixels in sprites:
+            f.write(f"    [{name.upper()}_{identifier(sprite).upper()}] = "
+                    f"{{{width}, {height}, &{name}_pixels[{offset}]}},\n")
+            offset += len(pixels)
+        f.write("};\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("pngs", nargs="+", help="sprite images, one sprite per file")
+    parser.add_argument("--name", required=True, help="C name of the sheet, e.g. game_sprites")
+    parser.add_argument("--header", required=True, help="header to write")
+    parser.add_argument("--source", required=True, help="C source to write")
+    parser.add_argument("--alpha", type=int, default=128, help="alpha below which a pixel is transparent")
+    args = parser.parse_args()
+
+    sprites = []
+    for png in sorted(args.pngs):
+        width, height, pixels = convert(png, args.alpha)
+        sprites.append((os.path.splitext(os.path.basename(png))[0], width, height, pixels))
+
+    write_header(args.header, identifier(args.name), sprites)
+    write_source(args.source, args.header, identifier(args.name), sprites)
+    total = sum(len(p) for _, _, _, p in sprites) * 2
+    print(f"{len(sprites)} sprites, {total} bytes of pixels")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,210 @@
+"""Compile a word list into a T9 dictionary file for ui/t9.c.
+
+Input is a text file with one word per line, optionally followed by a
+frequency ("hello 1234"). Words without a frequency are ranked by their
+position in the file. Only a-z words up to 24 letters are kept.
+
+    python3 tools/t9_dict.py words.txt t9.dict
+    python3 tools/t9_dict.py --synthetic 50000 t9.dict   # benchmark dictionary
+
+The trie is written depth first with single-child chains folded into digit
+labels, and words are stored as the 2-bit position of each letter on its key,
+since the typed digits already say which key it was. See include/ui/t9.h for
+the layout.
+
+Copy the output to the root of the SD card as t9.dict.
+"""
+
+import argparse
+import random
+import struct
+import sys
+
+MAX_LEN = 24
+MAX_WORDS = 127          # words kept per digit sequence, the count has 7 bits
+HAS_HINT = 0x80          # word count flag: a completion hint follows the child offsets
+HEADER_SIZE = 20
+MAX_OFFSET = 0xFFFFFF    # child offsets are 24 bits
+
+KEYS = {
+    "2": "abc", "3": "def", "4": "ghi", "5": "jkl",
+    "6": "mno", "7": "pqrs", "8": "tuv", "9": "wxyz",
+}
+LETTER_TO_DIGIT = {c: d for d, letters in KEYS.items() for c in letters}
+
+
+class Node:
+    __slots__ = ("children", "words", "best")
+
+    def __init__(self):
+        self.children = {}
+        self.words = []
+        self.best = None
+
+
+def rank(entry):
+    """Most frequent first, ties alphabetical, so the output is reproducible."""
+    freq, word = entry
+    return -freq, word
+
+
+def read_words(path):
+    words = {}
+    with open(path, encoding="utf-8", errors="ignore") as f:
+        lines = [line.split() for line in f if line.strip()]
+    for rank, parts in enumerate(lines):
+        word = parts[0].lower()
+        if not word.isalpha() or not word.isascii() or len(word) > MAX_LEN:
+            continue
+        freq = int(parts[1]) if len(parts) > 1 else max(1, len(lines) - rank)
+        words[word] = max(freq, words.get(word, 0))
+    return words
+
+
+def synthetic_words(count, seed=1):
+    """Pronounceable pseudo-words with a Zipf frequency distribution."""
+    rng = random.Random(seed)
+    onsets = ["", "b", "c", "d", "f", "g", "h", "j", "k", "l", "m", "n", "p",
+              "r", "s", "t", "v", "w", "y", "z", "br", "ch", "cl", "dr", "fl",
+              "gr", "pl", "pr", "sh", "st", "th", "tr", "wh"]
+    vowels = ["a", "e", "i", "o", "u", "ai", "ea", "ee", "oo", "ou"]
+    codas = ["", "", "n", "r", "s", "t", "l", "m", "nd", "ng", "st", "ck"]
+    words = {}
+    while len(words) < count:
+        word = "".join(rng.choice(onsets) + rng.choice(vowels) + rng.choice(codas)
+                       for _ in range(rng.choice((1, 1, 2, 2, 2, 3, 3, 4))))
+        if 0 < len(word) <= MAX_LEN and word not in words:
+            words[word] = 0
+    for rank, word in enumerate(words):
+        words[word] = max(1, int(65535 / (rank + 1)))
+    return words
+
+
+def build_trie(words):
+    root = Node()
+    for word, freq in words.items():
+        node = root
+        for c in word:
+            node = node.children.setdefault(LETTER_TO_DIGIT[c], Node())
+        node.words.append((freq, word))
+    return root
+
+
+def finish(node):
+    """Sort word lists and compute the best completion per subtree."""
+    node.words.sort(key=rank)
+    best = node.words[0] if node.words else None
+    for child in node.children.values():
+        cb = finish(child)
+        if cb and (best is None or rank(cb) < rank(best)):
+            best = cb
+    node.best = best
+    return best
+
+
+def pack_letters(word, length):
+    """2-bit position of each letter on its key, four letters per byte."""
+    out = bytearray((length + 3) // 4)
+    for i, c in enumerate(word[:length]):
+        out[i // 4] |= KEYS[LETTER_TO_DIGIT[c]].index(c) << (2 * (i % 4))
+    return bytes(out)
+
+
+def compress(node, depth):
+    """List [node, label, depth, child indices] records in depth-first order.
+
+    Chains of single-child nodes without words are folded into the digit label
+    of the node they lead to, so a record is only written where the trie
+    branches or a word ends.
+    """
+    records = []
+
+    def visit(node, label, depth):
+        record = [node, label, depth, []]
+        records.append(record)
+        for d in sorted(node.children):
+            child, child_label, child_depth = node.children[d], "", depth + 1
+            while not child.words and len(child.children) == 1:
+                (next_digit, next_child), = child.children.items()
+                child_label += next_digit
+                child, child_depth = next_child, child_depth + 1
+            record[3].append(len(records))
+            visit(child, child_label, child_depth)
+
+    visit(node, "", depth)
+    return records
+
+
+def encode(record, offsets):
+    node, label, depth, children = record
+    mask = 0
+    for d in node.children:
+        mask |= 1 << (int(d) - 2)
+    words = node.words[:MAX_WORDS]
+    # the hint is only read where no word ends: inside the label or at a node without words
+    hint = node.best if (not words or (label and node.best != words[0])) else None
+    out = bytearray([mask, len(words) | (HAS_HINT if hint else 0), len(label)])
+    nibbles = [int(d) for d in label] + [0] * (len(label) % 2)
+    out += bytes(nibbles[i] | (nibbles[i + 1] << 4) for i in range(0, len(nibbles), 2))
+    for child in children[1:]:
+        out += struct.pack("<I", offsets[child])[:3]
+    if hint:
+        out += pack_letters(hint[1], depth)
+    for _, word in words:
+        out += pack_letters(word, depth)
+    return bytes(out)
+
+
+def serialise(root, out_path):
+    records = compress(root, 0)
+    # record sizes do not depend on the offsets they hold, so lay them out first
+    offsets = [0] * len(records)
+    sizes = [len(encode(r, offsets)) for r in records]
+    offset = HEADER_SIZE
+    for i, size in enumerate(sizes):
+        offsets[i] = offset
+        offset += size
+    if offset > MAX_OFFSET:
+        sys.exit(f"dictionary too large: {offset} bytes, offsets are 24 bits")
+
+    word_count = sum(min(len(r[0].words), MAX_WORDS) for r in records)
+    blob = bytearray(struct.pack("<4sIIII", b"T9D2", len(records), word_count, HEADER_SIZE, 0))
+    for r in records:
+        blob += encode(r, offsets)
+        # the first child follows its parent, so it needs no offset
+        assert not r[3] or offsets[r[3][0]] == len(blob)
+    with open(out_path, "wb") as f:
+        f.write(blob)
+    return len(records), word_count, len(blob)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("words", nargs="?", help="word list (word [frequency] per line)")
+    parser.add_argument("output", help="dictionary file to write")
+    parser.add_argument("--synthetic", type=int, metavar="N",
+                        help="generate N pseudo-words instead of reading a list")
+    parser.add_argument("--list", metavar="FILE",
+                        help="also write the words and frequencies used (for tests/test_t9.c)")
+    args = parser.parse_args()
+
+    if args.synthetic:
+        words = synthetic_words(args.synthetic)
+    elif args.words:
+        words = read_words(args.words)
+    else:
+        parser.error("a word list or --synthetic is required")
+
+    if args.list:
+        with open(args.list, "w") as f:
+            for word, freq in sorted(words.items()):
+                f.write(f"{word} {freq}\n")
+
+    root = build_trie(words)
+    finish(root)
+    nodes, count, size = serialise(root, args.output)
+    print(f"{count} words, {nodes} nodes, {size} bytes -> {args.output}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,331 @@
+"""Turn a trace ring dump into Chrome trace JSON.
+
+The firmware writes the dump from Debug > Trace (include/kernel/trace.h),
+to trace.bin on the SD card and, when the board has a debug UART, over
+the UART. Either capture can be given here. Bytes before the dump, such
+as log lines in a UART capture, are skipped.
+
+    python3 tools/trace_decode.py trace.bin -o trace.json
+    python3 tools/trace_decode.py uart.log --summary
+
+Open the JSON in chrome://tracing or https://ui.perfetto.dev. Each task
+gets a track showing when it ran, with its queue sends and receives as
+instant events. Interrupts, idle sleeps and the driver spans (display
+flush, AT commands, audio buffers) get a track each.
+
+The cycle counter is 32 bits and stops in Stop mode. Timestamps are
+unwrapped on the assumption that consecutive records are less than one
+wrap apart, and every idle sleep is stretched to the ticks the kernel
+says it slept. Only the standard library is used.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b"UQTR"
+END = b"UQTE"
+VERSION = 1
+HEADER = struct.Struct("<4sHHIIIIHHI")
+NAME = struct.Struct("<IB11s")
+RECORD = struct.Struct("<IHHII")
+
+FLAG_BEGIN = 0x8000
+FLAG_END = 0x4000
+ID_MASK = 0x3FFF
+
+# TraceEventId in include/kernel/trace.h
+TASK_SWITCH = 1
+QUEUE_SEND = 2
+QUEUE_SEND_FAILED = 3
+QUEUE_RECEIVE = 4
+QUEUE_RECEIVE_FAILED = 5
+ISR = 6
+IDLE_SLEEP = 7
+USER = 0x100
+DISPLAY_FLUSH = USER
+AT_COMMAND = USER + 1
+AUDIO_BUFFER = USER + 2
+INCOMING_CALL = USER + 3
+
+NAME_TASK = 1
+NAME_QUEUE = 2
+
+QUEUE_EVENTS = {
+    QUEUE_SEND: "send",
+    QUEUE_SEND_FAILED: "send failed",
+    QUEUE_RECEIVE: "receive",
+    QUEUE_RECEIVE_FAILED: "receive failed",
+}
+SPAN_TRACKS = {
+    IDLE_SLEEP: "Idle sleep",
+    DISPLAY_FLUSH: "Display flush",
+    AT_COMMAND: "AT commands",
+    AUDIO_BUFFER: "Audio buffers",
+}
+
+PID = 1
+TID_ISR = 1000
+TID_EVENTS = 1001
+TID_SPANS = 1100  # plus the event id
+
+
+class Dump:
+    def __init__(self, header, names, records, dropped):
+        (_, self.version, _, self.clock_hz, self.capacity, self.head, self.count, _, _, _) = header
+        self.tasks = {key: name for kind, key, name in names if kind == NAME_TASK}
+        self.queues = {key: name for kind, key, name in names if kind == NAME_QUEUE}
+        self.records = records  # (cycles, id, arg0, arg1), timestamps still raw
+        self.dropped = dropped
+
+
+def parse(data):
+    """Find the dump in data, check it and return a Dump."""
+    error = "no trace dump found"
+    start = data.find(MAGIC)
+    while start >= 0:
+        try:
+            return parse_at(data, start)
+        except ValueError as err:
+            error = str(err)
+        start = data.find(MAGIC, start + 1)
+    raise ValueError(error)
+
+
+def parse_at(data, start):
+    if len(data) - start < HEADER.size:
+        raise ValueError("dump header cut short")
+    header = HEADER.unpack_from(data, start)
+    version, record_size, capacity, head, count, name_count, name_size = (
+        header[1], header[2], header[4], header[5], header[6], header[7], header[8])
+    if version != VERSION or record_size != RECORD.size or name_size != NAME.size:
+        raise ValueError("unsupported dump version %d" % version)
+    if capacity == 0 or capacity & (capacity - 1) or count > capacity:
+        raise ValueError("bad ring size %d" % capacity)
+
+    pos = start + HEADER.size
+    body_end = pos + name_count * NAME.size + count * RECORD.size
+    if len(data) < body_end + 8:
+        raise ValueError("dump cut short, %d of %d bytes" % (len(data) - start, body_end + 8 - start))
+    if data[body_end:body_end + 4] != END:
+        raise ValueError("dump trailer missing")
+    (checksum,) = struct.unpack_from("<I", data, body_end + 4)
+    if sum(data[start:body_end]) & 0xFFFFFFFF != checksum:
+        raise ValueError("dump checksum mismatch")
+
+    names = []
+    for _ in range(name_count):
+        key, kind, raw = NAME.unpack_from(data, pos)
+        names.append((kind, key, raw.split(b"\0", 1)[0].decode("ascii", "replace")))
+        pos += NAME.size
+
+    # a record's tag is its lap plus one, anything else was torn or never written
+    log2 = capacity.bit_length() - 1
+    records = []
+    dropped = 0
+    for i in range(count):
+        stamp, event, tag, arg0, arg1 = RECORD.unpack_from(data, pos)
+        pos += RECORD.size
+        index = (head - count + i) & 0xFFFFFFFF
+        if tag != ((index >> log2) + 1) & 0xFFFF:
+            dropped += 1
+            continue
+        records.append((stamp, event, arg0, arg1))
+    return Dump(header, names, records, dropped)
+
+
+def unwrap(dump, tick_hz):
+    """Return the records with 64-bit timestamps in microseconds."""
+    out = []
+    if not dump.records:
+        return out
+    last = dump.records[0][0]
+    total = 0  # cycles since the first record
+    sleep_start = None
+    for stamp, event, arg0, arg1 in dump.records:
+        delta = (stamp - last) & 0xFFFFFFFF
+        # an interrupt can stamp its record before the one it preempted
+        if delta >= 0x80000000:
+            delta -= 1 << 32
+        total += delta
+        last = stamp
+
+        kind = event & ID_MASK
+        if kind == IDLE_SLEEP and event & FLAG_BEGIN:
+            sleep_start = total
+        elif kind == IDLE_SLEEP and event & FLAG_END and sleep_start is not None:
+            # the counter stopped or wrapped during the sleep, trust the kernel's ticks
+            slept = arg0 * dump.clock_hz // tick_hz
+            missing = slept - (total - sleep_start)
+            if missing > 0:
+                total += missing
+            sleep_start = None
+        out.append((total * 1e6 / dump.clock_hz, event, arg0, arg1))
+    return out
+
+
+def at_name(tag):
+    text = struct.pack("<I", tag).split(b"\0", 1)[0].decode("ascii", "replace")
+    return "AT" + text if text else "AT"
+
+
+class Builder:
+    def __init__(self, dump):
+        self.dump = dump
+        self.events = []
+        self.tids = {}
+
+    def thread(self, tid, name, order):
+        if tid not in self.tids:
+            self.tids[tid] = name
+            self.events.append({"ph": "M", "pid": PID, "tid": tid, "name": "thread_name", "args": {"name": name}})
+            self.events.append({"ph": "M", "pid": PID, "tid": tid, "name": "thread_sort_index",
+                                "args": {"sort_index": order}})
+        return tid
+
+    def task_tid(self, task):
+        name = self.dump.tasks.get(task, "task %d" % task)
+        return self.thread(task, name, task)
+
+    def slice(self, tid, name, start, end, args=None):
+        event = {"ph": "X", "pid": PID, "tid": tid, "name": name, "ts": start, "dur": max(end - start, 0)}
+        if args:
+            event["args"] = args
+        self.events.append(event)
+
+    def instant(self, tid, name, ts, args=None):
+        event = {"ph": "i", "s": "t", "pid": PID, "tid": tid, "name": name, "ts": ts}
+        if args:
+            event["args"] = args
+        self.events.append(event)
+
+
+def span_name(kind, begin, end):
+    if kind == AT_COMMAND:
+        return at_name(begin[0])
+    if kind == DISPLAY_FLUSH:
+        return "flush %d tiles" % end[0]
+    if kind == AUDIO_BUFFER:
+        return "%d samples" % begin[0]
+    if kind == IDLE_SLEEP:
+        return "stop" if begin[1] else "sleep"
+    return "event %#x" % kind
+
+
+def span_args(kind, begin, end):
+    if kind == AT_COMMAND:
+        return {"result": end[0], "response bytes": end[1]}
+    if kind == DISPLAY_FLUSH:
+        return {"tiles": end[0], "bytes": end[1]}
+    if kind == AUDIO_BUFFER:
+        return {"samples": begin[0], "hal status": end[1]}
+    if kind == IDLE_SLEEP:
+        return {"ticks expected": begin[0], "ticks slept": end[0], "woken by timer": bool(end[1])}
+    return {"begin": list(begin), "end": list(end)}
+
+
+def build(dump, records):
+    """Return the Chrome trace events and per-track busy time for the summary."""
+    b = Builder(dump)
+    b.events.append({"ph": "M", "pid": PID, "name": "process_name", "args": {"name": "UniQOS"}})
+    busy = {}
+    spans = {}
+
+    running = None  # (task, since)
+    open_spans = {}  # (track kind, key) -> (ts, args)
+    isr_stack = []
+
+    def close_task(ts):
+        if running:
+            task, since = running
+            b.slice(b.task_tid(task), "running", since, ts)
+            name = b.tids[task]
+            busy[name] = busy.get(name, 0) + ts - since
+
+    for ts, event, arg0, arg1 in records:
+        kind = event & ID_MASK
+        if kind == TASK_SWITCH:
+            close_task(ts)
+            running = (arg0, ts)
+            b.task_tid(arg0)
+        elif kind in QUEUE_EVENTS:
+            tid = b.task_tid(running[0]) if running else b.thread(TID_EVENTS, "Events", TID_EVENTS)
+            queue = dump.queues.get(arg0, "%#010x" % arg0)
+            b.instant(tid, "%s %s" % (queue, QUEUE_EVENTS[kind]), ts, {"queue": queue, "waiting": arg1})
+        elif kind == ISR:
+            tid = b.thread(TID_ISR, "Interrupts", TID_ISR)
+            if event & FLAG_BEGIN:
+                isr_stack.append((arg0, ts))
+            elif event & FLAG_END and isr_stack:
+                number, since = isr_stack.pop()
+                name = "IRQ %d" % (number - 16) if number >= 16 else "exception %d" % number
+                b.slice(tid, name, since, ts)
+                busy["Interrupts"] = busy.get("Interrupts", 0) + ts - since
+        elif kind == INCOMING_CALL:
+            b.instant(b.thread(TID_EVENTS, "Events", TID_EVENTS), "incoming call", ts)
+        elif event & (FLAG_BEGIN | FLAG_END):
+            track = SPAN_TRACKS.get(kind, "Event %#x" % kind)
+            tid = b.thread(TID_SPANS + kind, track, TID_SPANS + kind)
+            if event & FLAG_BEGIN:
+                open_spans[kind] = (ts, (arg0, arg1))
+            elif kind in open_spans:
+                since, begin = open_spans.pop(kind)
+                name = span_name(kind, begin, (arg0, arg1))
+                b.slice(tid, name, since, ts, span_args(kind, begin, (arg0, arg1)))
+                stats = spans.setdefault(track, [])
+                stats.append(ts - since)
+        else:
+            b.instant(b.thread(TID_EVENTS, "Events", TID_EVENTS), "event %#x" % kind, ts,
+                      {"arg0": arg0, "arg1": arg1})
+
+    if records:
+        close_task(records[-1][0])
+    return b.events, busy, spans
+
+
+def print_summary(dump, records, busy, spans):
+    span = records[-1][0] - records[0][0] if records else 0
+    print("%d records over %.3f ms, %d dropped as torn, %d lost to the ring wrapping"
+          % (len(records), span / 1000, dump.dropped, max(dump.head - dump.capacity, 0)))
+    if busy:
+        print("\n%-16s %12s %7s" % ("Track", "Time (ms)", "Share"))
+        for name, total in sorted(busy.items(), key=lambda item: -item[1]):
+            print("%-16s %12.3f %6.1f%%" % (name, total / 1000, 100.0 * total / span if span else 0))
+    if spans:
+        print("\n%-16s %7s %11s %11s" % ("Span", "Count", "Mean (us)", "Max (us)"))
+        for name, times in sorted(spans.items()):
+            print("%-16s %7d %11.1f %11.1f" % (name, len(times), sum(times) / len(times), max(times)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", help="trace.bin from the SD card, or a UART capture holding a dump")
+    parser.add_argument("-o", "--output", help="Chrome trace JSON to write (default stdout)")
+    parser.add_argument("--tick-hz", type=int, default=1000, help="kernel tick rate (default %(default)s)")
+    parser.add_argument("--summary", action="store_true", help="print time per track and span instead of JSON")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        data = f.read()
+    try:
+        dump = parse(data)
+    except ValueError as err:
+        sys.exit("trace_decode: %s: %s" % (args.dump, err))
+
+    records = unwrap(dump, args.tick_hz)
+    events, busy, spans = build(dump, records)
+
+    if args.summary:
+        print_summary(dump, records, busy, spans)
+        return
+    text = json.dumps({"traceEvents": events, "displayTimeUnit": "ns"}, separators=(",", ":"))
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text)
+    else:
+        print(text)
+
+
+if __name__ == "__main__":
+    main()
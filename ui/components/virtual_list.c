@@ -0,0 +1,286 @@
+#include "virtual_list.h"
+#include "ui_timer.h"
+#include <string.h>
+
+static void mark_list_row_dirty(VirtualList *list, int row)
+{
+    int tile_y = list->first_tile_row + row * list->row_tiles;
+    for (int y = 0; y < list->row_tiles; y++)
+    {
+        for (int x = 0; x < TILE_COLS; x++)
+        {
+            mark_tile_dirty(x, tile_y + y);
+        }
+    }
+}
+
+static void mark_list_row_clean(VirtualList *list, int row)
+{
+    int tile_y = list->first_tile_row + row * list->row_tiles;
+    for (int y = 0; y < list->row_tiles; y++)
+    {
+        for (int x = 0; x < TILE_COLS; x++)
+        {
+            mark_tile_clean(x, tile_y + y);
+        }
+    }
+}
+
+static void mark_index_dirty(VirtualList *list, int index)
+{
+    int row = index - list->offset;
+    if (row >= 0 && row < list->visible)
+        mark_list_row_dirty(list, row);
+}
+
+static void mark_all_rows_dirty(VirtualList *list)
+{
+    for (int row = 0; row < list->visible; row++)
+        mark_list_row_dirty(list, row);
+}
+
+static VListSlot *slot_for(VirtualList *list, int index)
+{
+    return &list->slots[index % VLIST_MAX_SLOTS];
+}
+
+static void ensure_row(VirtualList *list, int index)
+{
+    if (index < 0 || index >= list->count)
+        return;
+
+    VListSlot *slot = slot_for(list, index);
+    if (slot->index == index && slot->state == VLIST_SLOT_READY)
+        return;
+    // the source may still deliver, so only ask again once it is overdue
+    if (slot->index == index && slot->state == VLIST_SLOT_PENDING &&
+        ui_timer_now() - slot->requested < VLIST_RETRY_MS)
+        return;
+
+    slot->index = index;
+    slot->text[0] = '\0';
+    slot->requested = ui_timer_now();
+    list->fetches++;
+    if (list->source.fetch && list->source.fetch(list->source.ctx, index, slot->text, VLIST_ROW_LEN))
+    {
+        slot->text[VLIST_ROW_LEN - 1] = '\0';
+        slot->state = VLIST_SLOT_READY;
+    }
+    else
+    {
+        slot->state = VLIST_SLOT_PENDING;
+    }
+}
+
+// window is bounded by VLIST_MAX_SLOTS and only rows not already cached are fetched
+static void fill_window(VirtualList *list)
+{
+    int first = list->offset - list->prefetch;
+    int last = list->offset + list->visible + list->prefetch;
+    for (int i = first; i < last; i++)
+        ensure_row(list, i);
+}
+
+bool vlist_init(VirtualList *list, const VListSource *source, VListDrawRow draw_row,
+                int first_tile_row, int row_tiles, int visible, int prefetch)
+{
+    if (!list || !source || visible <= 0 || row_tiles <= 0 || prefetch < 0)
+        return false;
+    if (visible + 2 * prefetch > VLIST_MAX_SLOTS)
+        return false;
+
+    memset(list, 0, sizeof(*list));
+    list->source = *source;
+    list->draw_row = draw_row;
+    list->first_tile_row = first_tile_row;
+    list->row_tiles = row_tiles;
+    list->visible = visible;
+    list->prefetch = prefetch;
+    for (int i = 0; i < VLIST_MAX_SLOTS; i++)
+        list->slots[i].index = -1;
+
+    vlist_refresh(list);
+    return true;
+}
+
+bool vlist_select(VirtualList *list, int index)
+{
+    if (list->count <= 0)
+        return false;
+    if (index < 0)
+        index = 0;
+    if (index > list->count - 1)
+        index = list->count - 1;
+    if (index == list->selected)
+        return false;
+
+    int old = list->selected;
+    int new_offset = list->offset;
+    list->selected = index;
+
+    // scroll just enough to keep the selection on screen, in either direction
+    if (index < new_offset)
+        new_offset = index;
+    else if (index >= new_offset + list->visible)
+        new_offset = index - list->visible + 1;
+
+    if (new_offset != list->offset)
+    {
+        list->offset = new_offset;
+        fill_window(list);
+        mark_all_rows_dirty(list);
+    }
+    else
+    {
+        mark_index_dirty(list, old);
+        mark_index_dirty(list, index);
+    }
+    return true;
+}
+
+bool vlist_move(VirtualList *list, int delta)
+{
+    return vlist_select(list, list->selected + delta);
+}
+
+bool vlist_draw_tile(VirtualList *list, int ty)
+{
+    int rel = ty - list->first_tile_row;
+    if (rel < 0 || rel >= list->visible * list->row_tiles)
+        return false;
+
+    int row = rel / list->row_tiles;
+    int index = list->offset + row;
+    const char *text = "";
+
+    if (index < list->count)
+    {
+        ensure_row(list, index);
+        VListSlot *slot = slot_for(list, index);
+        text = (slot->state == VLIST_SLOT_READY) ? slot->text : "...";
+    }
+
+    if (list->draw_row)
+        list->draw_row(list->first_tile_row + row * list->row_tiles,
+                       index < list->count && index == list->selected, text);
+    mark_list_row_clean(list, row);
+    return true;
+}
+
+void vlist_deliver(VirtualList *list, int index, const char *text)
+{
+    if (index < 0 || index >= list->count)
+        return;
+
+    VListSlot *slot = slot_for(list, index);
+    if (slot->index != index || slot->state != VLIST_SLOT_PENDING)
+        return;
+
+    strncpy(slot->text, text, VLIST_ROW_LEN - 1);
+    slot->text[VLIST_ROW_LEN - 1] = '\0';
+    slot->state = VLIST_SLOT_READY;
+    mark_index_dirty(list, index);
+}
+
+int vlist_retry_pending(VirtualList *list)
+{
+    int first = list->offset - list->prefetch;
+    int last = list->offset + list->visible + list->prefetch;
+    int retried = 0;
+    for (int i = 0; i < VLIST_MAX_SLOTS; i++)
+    {
+        VListSlot *slot = &list->slots[i];
+        if (slot->state != VLIST_SLOT_PENDING || slot->index < first || slot->index >= last ||
+            ui_timer_now() - slot->requested < VLIST_RETRY_MS)
+            continue;
+        ensure_row(list, slot->index);
+        // a synchronous answer this time replaces the placeholder straight away
+        mark_index_dirty(list, slot->index);
+        retried++;
+    }
+    return retried;
+}
+
+void vlist_refresh(VirtualList *list)
+{
+    list->count = list->source.count ? list->source.count(list->source.ctx) : 0;
+    for (int i = 0; i < VLIST_MAX_SLOTS; i++)
+    {
+        list->slots[i].index = -1;
+        list->slots[i].state = VLIST_SLOT_EMPTY;
+    }
+
+    if (list->selected > list->count - 1)
+        list->selected = list->count > 0 ? list->count - 1 : 0;
+    if (list->offset > list->selected)
+        list->offset = list->selected;
+    if (list->selected >= list->offset + list->visible)
+        list->offset = list->selected - list->visible + 1;
+
+    fill_window(list);
+    mark_all_rows_dirty(list);
+}
+
+bool vlist_update_count(VirtualList *list)
+{
+    int count = list->source.count ? list->source.count(list->source.ctx) : 0;
+    if (count == list->count)
+        return false;
+
+    int lo = count < list->count ? count : list->count;
+    int hi = count < list->count ? list->count : count;
+    for (int i = 0; i < VLIST_MAX_SLOTS; i++)
+    {
+        if (list->slots[i].index >= count)
+        {
+            list->slots[i].index = -1;
+            list->slots[i].state = VLIST_SLOT_EMPTY;
+        }
+    }
+    list->count = count;
+
+    int old_offset = list->offset;
+    if (list->selected > count - 1)
+        list->selected = count > 0 ? count - 1 : 0;
+    if (list->offset > list->selected)
+        list->offset = list->selected;
+
+    fill_window(list);
+    if (list->offset != old_offset)
+    {
+        mark_all_rows_dirty(list);
+    }
+    else
+    {
+        // only rows that appeared or disappeared need drawing
+        for (int i = lo; i < hi; i++)
+            mark_index_dirty(list, i);
+        mark_index_dirty(list, list->selected);
+    }
+    return true;
+}
+
+const char *vlist_selected_text(const VirtualList *list)
+{
+    if (list->count <= 0)
+        return NULL;
+    const VListSlot *slot = &list->slots[list->selected % VLIST_MAX_SLOTS];
+    if (slot->index != list->selected || slot->state != VLIST_SLOT_READY)
+        return NULL;
+    return slot->text;
+}
+
+int vlist_array_count(void *ctx)
+{
+    return ((VListArray *)ctx)->count;
+}
+
+bool vlist_array_fetch(void *ctx, int index, char *out, int out_len)
+{
+    VListArray *array = (VListArray *)ctx;
+    if (index < 0 || index >= array->count)
+        return false;
+    strncpy(out, array->items[index], out_len - 1);
+    out[out_len - 1] = '\0';
+    return true;
+}
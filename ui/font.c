@@ -0,0 +1,400 @@
+#include "font.h"
+#include "profile.h"
+#include <string.h>
+
+#if defined(__arm__) || defined(HOST_SIM)
+#include "fatfs.h"
+#include "display.h"
+#include "mem_sections.h"
+static FIL font_file DMA_BUFFER;
+#else
+#include <stdio.h>
+#endif
+
+#define HEADER_SIZE 20
+#define ENTRY_SIZE 12
+
+// reads up to len bytes, returns the number read (short only at end of file)
+static uint32_t file_read_upto(FontContext *ctx, uint32_t offset, void *buf, uint32_t len)
+{
+    ctx->reads++;
+#if defined(__arm__) || defined(HOST_SIM)
+    UINT got = 0;
+    if (f_lseek((FIL *)ctx->file, offset) != FR_OK)
+        return 0;
+    if (f_read((FIL *)ctx->file, buf, len, &got) != FR_OK)
+        return 0;
+    return got;
+#else
+    FILE *f = (FILE *)ctx->file;
+    if (fseek(f, (long)offset, SEEK_SET) != 0)
+        return 0;
+    return (uint32_t)fread(buf, 1, len, f);
+#endif
+}
+
+static bool file_read(FontContext *ctx, uint32_t offset, void *buf, uint32_t len)
+{
+    return file_read_upto(ctx, offset, buf, len) == len;
+}
+
+static uint32_t read_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool font_open(FontContext *ctx, const char *path)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    for (int i = 0; i < FONT_CACHE_PAGES; i++)
+        ctx->cache[i].page = FONT_NO_PAGE;
+    ctx->table_block = -1;
+#if defined(__arm__) || defined(HOST_SIM)
+    ctx->blit = display_draw_rgb565;
+    if (f_open(&font_file, path, FA_READ) != FR_OK)
+        return false;
+    ctx->file = &font_file;
+#else
+    ctx->file = fopen(path, "rb");
+    if (!ctx->file)
+        return false;
+#endif
+
+    uint8_t header[HEADER_SIZE];
+    if (!file_read(ctx, 0, header, sizeof(header)) || memcmp(header, "UFN1", 4) != 0)
+    {
+        font_close(ctx);
+        return false;
+    }
+    ctx->height = header[4];
+    ctx->ascent = header[5];
+    ctx->max_advance = header[6];
+    ctx->page_count = read_u32(&header[8]);
+    ctx->table_offset = read_u32(&header[12]);
+
+    uint32_t blocks = (ctx->page_count + FONT_TABLE_BLOCK - 1) / FONT_TABLE_BLOCK;
+    if (ctx->height == 0 || ctx->height > FONT_MAX_HEIGHT || ctx->max_advance > FONT_MAX_WIDTH ||
+        blocks > FONT_TABLE_BLOCKS)
+    {
+        font_close(ctx);
+        return false;
+    }
+
+    // read in place, each key is converted from the bytes it occupies
+    uint8_t *keys = (uint8_t *)ctx->block_keys;
+    if (!file_read(ctx, HEADER_SIZE, keys, blocks * 4))
+    {
+        font_close(ctx);
+        return false;
+    }
+    for (uint32_t i = 0; i < blocks; i++)
+        ctx->block_keys[i] = read_u32(&keys[i * 4]);
+    ctx->block_count = (uint16_t)blocks;
+    return true;
+}
+
+void font_close(FontContext *ctx)
+{
+    if (!ctx->file)
+        return;
+#if defined(__arm__) || defined(HOST_SIM)
+    f_close((FIL *)ctx->file);
+#else
+    fclose((FILE *)ctx->file);
+#endif
+    ctx->file = NULL;
+}
+
+uint32_t font_utf8_next(const char **s)
+{
+    const uint8_t *p = (const uint8_t *)*s;
+    uint32_t cp;
+    int extra;
+
+    if (p[0] == 0)
+        return 0;
+    if (p[0] < 0x80)
+    {
+        *s += 1;
+        return p[0];
+    }
+    if ((p[0] & 0xE0) == 0xC0)
+    {
+        cp = p[0] & 0x1F;
+        extra = 1;
+    }
+    else if ((p[0] & 0xF0) == 0xE0)
+    {
+        cp = p[0] & 0x0F;
+        extra = 2;
+    }
+    else if ((p[0] & 0xF8) == 0xF0)
+    {
+        cp = p[0] & 0x07;
+        extra = 3;
+    }
+    else
+    {
+        *s += 1;
+        return FONT_REPLACEMENT;
+    }
+
+    for (int i = 1; i <= extra; i++)
+    {
+        // also stops at the terminator, which is not a continuation byte
+        if ((p[i] & 0xC0) != 0x80)
+        {
+            *s += 1;
+            return FONT_REPLACEMENT;
+        }
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+
+    // overlong forms, UTF-16 surrogates and values past U+10FFFF
+    static const uint32_t min_cp[4] = {0, 0x80, 0x800, 0x10000};
+    if (cp < min_cp[extra] || (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+    {
+        *s += 1;
+        return FONT_REPLACEMENT;
+    }
+    *s += extra + 1;
+    return cp;
+}
+
+// find a page in the table, false if the font does not have it
+static bool find_page(FontContext *ctx, uint32_t page, uint32_t *offset, uint16_t *size, uint16_t *mask)
+{
+    if (ctx->block_count == 0 || page < ctx->block_keys[0])
+        return false;
+
+    // last block whose first page is <= page
+    int lo = 0, hi = ctx->block_count - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (ctx->block_keys[mid] <= page)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    uint32_t first = (uint32_t)lo * FONT_TABLE_BLOCK;
+    uint32_t count = ctx->page_count - first < FONT_TABLE_BLOCK ? ctx->page_count - first : FONT_TABLE_BLOCK;
+    if (ctx->table_block != lo)
+    {
+        if (!file_read(ctx, ctx->table_offset + first * ENTRY_SIZE, ctx->table, count * ENTRY_SIZE))
+        {
+            ctx->table_block = -1;
+            return false;
+        }
+        ctx->table_block = lo;
+    }
+
+    int a = 0, b = (int)count - 1;
+    while (a <= b)
+    {
+        int mid = (a + b) / 2;
+        const uint8_t *entry = &ctx->table[mid * ENTRY_SIZE];
+        uint32_t key = read_u32(entry);
+        if (key == page)
+        {
+            *offset = read_u32(&entry[4]);
+            *size = read_u16(&entry[8]);
+            *mask = read_u16(&entry[10]);
+            return true;
+        }
+        if (key < page)
+            a = mid + 1;
+        else
+            b = mid - 1;
+    }
+    return false;
+}
+
+static void load_page(FontContext *ctx, FontPage *slot, uint32_t page)
+{
+    memset(slot->glyphs, 0, sizeof(slot->glyphs));
+    slot->page = page;
+
+    uint32_t offset;
+    uint16_t size, mask;
+    // a page the font lacks stays cached with no glyphs
+    if (!find_page(ctx, page, &offset, &size, &mask) || size > FONT_PAGE_DATA_MAX)
+        return;
+
+    if (!file_read(ctx, offset, ctx->page_data, size))
+        return;
+
+    const uint8_t *p = ctx->page_data;
+    const uint8_t *end = ctx->page_data + size;
+    for (int i = 0; i < FONT_PAGE_GLYPHS; i++)
+    {
+        if (!(mask & (1U << i)))
+            continue;
+        if (p >= end)
+            break;
+        uint8_t advance = *p++;
+        int bytes = advance > 8 ? 2 : 1;
+        if (advance == 0 || advance > FONT_MAX_WIDTH || p + bytes * ctx->height > end)
+            break;
+
+        FontGlyph *g = &slot->glyphs[i];
+        g->advance = advance;
+        for (int row = 0; row < ctx->height; row++)
+        {
+            g->rows[row] = (uint16_t)(p[0] << 8);
+            if (bytes == 2)
+                g->rows[row] |= p[1];
+            p += bytes;
+        }
+    }
+}
+
+const FontGlyph *font_glyph(FontContext *ctx, uint32_t cp)
+{
+    if (!ctx->file)
+        return NULL;
+
+    uint32_t page = cp / FONT_PAGE_GLYPHS;
+    FontPage *slot = NULL;
+    FontPage *oldest = &ctx->cache[0];
+    ctx->clock++;
+
+    for (int i = 0; i < FONT_CACHE_PAGES; i++)
+    {
+        FontPage *line = &ctx->cache[i];
+        if (line->page == page)
+        {
+            slot = line;
+            break;
+        }
+        // unused lines have a zero stamp, so they are taken first
+        if (line->last_used < oldest->last_used)
+            oldest = line;
+    }
+
+    if (slot)
+    {
+        ctx->cache_hits++;
+    }
+    else
+    {
+        ctx->cache_misses++;
+        if (oldest->page != FONT_NO_PAGE)
+            ctx->evictions++;
+        slot = oldest;
+        load_page(ctx, slot, page);
+    }
+    slot->last_used = ctx->clock;
+
+    const FontGlyph *g = &slot->glyphs[cp % FONT_PAGE_GLYPHS];
+    return g->advance ? g : NULL;
+}
+
+// width a code point takes on screen, including the box drawn for missing glyphs
+static uint8_t glyph_advance(FontContext *ctx, const FontGlyph *g)
+{
+    return g ? g->advance : (uint8_t)(ctx->height / 2 + 1);
+}
+
+uint16_t font_text_width(FontContext *ctx, const char *text)
+{
+    uint16_t width = 0;
+    uint32_t cp;
+    while ((cp = font_utf8_next(&text)) != 0)
+        width += glyph_advance(ctx, font_glyph(ctx, cp));
+    return width;
+}
+
+static void draw_glyph(FontContext *ctx, int x, int y, const FontGlyph *g, uint16_t colour, uint16_t bg_colour)
+{
+    PROFILE_ZONE_BEGIN(PROFILE_GLYPH);
+    uint8_t width = glyph_advance(ctx, g);
+    uint16_t *px = ctx->pixels;
+
+    if (g)
+    {
+        for (int row = 0; row < ctx->height; row++)
+        {
+            uint16_t bits = g->rows[row];
+            for (int col = 0; col < width; col++, bits <<= 1)
+                *px++ = (bits & 0x8000) ? colour : bg_colour;
+        }
+    }
+    else
+    {
+        // hollow box for code points the font does not cover
+        for (int row = 0; row < ctx->height; row++)
+        {
+            for (int col = 0; col < width; col++)
+            {
+                bool edge = col == 0 || col == width - 2 || row == 1 || row == ctx->height - 2;
+                bool inside = col < width - 1 && row > 0 && row < ctx->height - 1;
+                *px++ = (edge && inside) ? colour : bg_colour;
+            }
+        }
+    }
+
+    if (ctx->blit)
+        ctx->blit((uint16_t)x, (uint16_t)y, width, ctx->height, ctx->pixels);
+    PROFILE_ZONE_END(PROFILE_GLYPH);
+}
+
+int font_draw_utf8(FontContext *ctx, int x, int y, const char *text, uint16_t colour, uint16_t bg_colour)
+{
+    uint32_t cp;
+    while ((cp = font_utf8_next(&text)) != 0)
+    {
+        const FontGlyph *g = font_glyph(ctx, cp);
+        draw_glyph(ctx, x, y, g, colour, bg_colour);
+        x += glyph_advance(ctx, g);
+    }
+    return x;
+}
+
+int font_draw_wrapped(FontContext *ctx, int x, int y, int width, int max_lines, const char *text,
+                      uint16_t colour, uint16_t bg_colour)
+{
+    int cx = x;
+    int lines = 1;
+    uint32_t cp;
+
+    if (max_lines <= 0)
+        return 0;
+
+    while ((cp = font_utf8_next(&text)) != 0)
+    {
+        if (cp == '\n')
+        {
+            if (lines == max_lines)
+                break;
+            cx = x;
+            y += ctx->height;
+            lines++;
+            continue;
+        }
+        if (cp == ' ' && cx == x && lines > 1)
+            continue;
+
+        const FontGlyph *g = font_glyph(ctx, cp);
+        uint8_t advance = glyph_advance(ctx, g);
+        if (cx + advance > x + width && cx > x)
+        {
+            if (lines == max_lines)
+                break;
+            cx = x;
+            y += ctx->height;
+            lines++;
+            if (cp == ' ')
+                continue;
+        }
+        draw_glyph(ctx, cx, y, g, colour, bg_colour);
+        cx += advance;
+    }
+    return lines;
+}
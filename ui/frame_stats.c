@@ -0,0 +1,174 @@
+#include "frame_stats.h"
+#include <string.h>
+
+#if defined(__arm__)
+#include "main.h"
+#else
+#include <time.h>
+#endif
+
+static FramePageStats page_stats[FRAME_STATS_MAX_PAGES];
+static int page_count = 0;
+
+uint32_t frame_stats_now(void)
+{
+#if defined(__arm__)
+    // enable the cycle counter on first use
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+    return DWT->CYCCNT;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000U + ts.tv_nsec / 1000U);
+#endif
+}
+
+uint32_t frame_stats_elapsed_us(uint32_t start)
+{
+    // subtract before scaling, so a counter wrap between the two reads cancels out
+    uint32_t ticks = frame_stats_now() - start;
+#if defined(__arm__)
+    return ticks / (SystemCoreClock / 1000000U);
+#else
+    return ticks;
+#endif
+}
+
+static uint8_t log2_bucket(uint32_t value)
+{
+    uint8_t bucket = 0;
+    while (value > 1 && bucket < FRAME_STATS_BUCKETS - 1)
+    {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void hist_add(FrameHistogram *hist, uint32_t value)
+{
+    hist->buckets[log2_bucket(value)]++;
+    hist->sum += value;
+    if (value > hist->max)
+        hist->max = value;
+}
+
+static FramePageStats *lookup(const Page *page)
+{
+    const void *key = (const void *)page->draw_tile;
+    for (int i = 0; i < page_count; i++)
+    {
+        if (page_stats[i].key == key)
+            return &page_stats[i];
+    }
+    if (page_count >= FRAME_STATS_MAX_PAGES)
+        return NULL;
+
+    FramePageStats *entry = &page_stats[page_count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->key = key;
+    entry->name = page->name ? page->name : "?";
+    return entry;
+}
+
+void frame_stats_reset(void)
+{
+    memset(page_stats, 0, sizeof(page_stats));
+    page_count = 0;
+}
+
+void frame_stats_record(const Page *page, uint32_t time_us, uint32_t tiles, uint32_t bytes)
+{
+    if (!page || (tiles == 0 && bytes == 0))
+        return;
+
+    FramePageStats *entry = lookup(page);
+    if (!entry)
+        return;
+
+    entry->frames++;
+    if (time_us > FRAME_STATS_BUDGET_US)
+        entry->over_budget++;
+    hist_add(&entry->time_us, time_us);
+    hist_add(&entry->tiles, tiles);
+    hist_add(&entry->bytes, bytes);
+}
+
+int frame_stats_count(void)
+{
+    return page_count;
+}
+
+const FramePageStats *frame_stats_get(int index)
+{
+    if (index < 0 || index >= page_count)
+        return NULL;
+    return &page_stats[index];
+}
+
+const FramePageStats *frame_stats_find(const char *name)
+{
+    for (int i = 0; i < page_count; i++)
+    {
+        if (page_stats[i].name && strcmp(page_stats[i].name, name) == 0)
+            return &page_stats[i];
+    }
+    return NULL;
+}
+
+uint32_t frame_stats_percentile(const FrameHistogram *hist, uint8_t percent)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < FRAME_STATS_BUCKETS; i++)
+        total += hist->buckets[i];
+    if (total == 0)
+        return 0;
+
+    uint64_t target = (total * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < FRAME_STATS_BUCKETS; i++)
+    {
+        seen += hist->buckets[i];
+        if (seen >= target && hist->buckets[i])
+        {
+            // upper bound of the bucket, clamped to the observed max
+            uint32_t upper = (i == FRAME_STATS_BUCKETS - 1) ? hist->max : (2U << i) - 1;
+            return upper < hist->max ? upper : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+uint32_t frame_stats_mean(const FrameHistogram *hist, uint32_t samples)
+{
+    if (samples == 0)
+        return 0;
+    return (uint32_t)(hist->sum / samples);
+}
+
+void frame_stats_dump(int (*print)(const char *fmt, ...))
+{
+    if (!print)
+        return;
+
+    print("%-12s %7s %5s %8s %8s %8s %6s %8s\r\n",
+          "page", "frames", "over", "p50us", "p95us", "maxus", "tiles", "bytes");
+    for (int i = 0; i < page_count; i++)
+    {
+        const FramePageStats *s = &page_stats[i];
+        print("%-12s %7lu %5lu %8lu %8lu %8lu %6lu %8lu\r\n",
+              s->name,
+              (unsigned long)s->frames,
+              (unsigned long)s->over_budget,
+              (unsigned long)frame_stats_percentile(&s->time_us, 50),
+              (unsigned long)frame_stats_percentile(&s->time_us, 95),
+              (unsigned long)s->time_us.max,
+              (unsigned long)frame_stats_mean(&s->tiles, s->frames),
+              (unsigned long)frame_stats_mean(&s->bytes, s->frames));
+    }
+}
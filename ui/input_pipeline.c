@@ -0,0 +1,193 @@
+#include "input_pipeline.h"
+#include <string.h>
+
+#if defined(USE_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#define INPUT_LOCK() taskENTER_CRITICAL()
+#define INPUT_UNLOCK() taskEXIT_CRITICAL()
+#else
+#define INPUT_LOCK()
+#define INPUT_UNLOCK()
+#endif
+
+/* ===== EVENT GENERATOR ===== */
+
+void key_events_default_config(KeyEventConfig *config)
+{
+    config->repeat_delay_ms = INPUT_REPEAT_DELAY_MS;
+    config->repeat_rate_ms = INPUT_REPEAT_RATE_MS;
+    config->long_press_ms = INPUT_LONG_PRESS_MS;
+    config->repeat_mask = INPUT_DEFAULT_REPEAT_MASK;
+}
+
+void key_events_init(KeyEventGen *gen, const KeyEventConfig *config,
+                     const input_event_t *keymap, uint8_t key_count)
+{
+    memset(gen, 0, sizeof(*gen));
+    if (config)
+        gen->config = *config;
+    else
+        key_events_default_config(&gen->config);
+
+    if (key_count > INPUT_MAX_KEYS)
+        key_count = INPUT_MAX_KEYS;
+    for (int i = 0; i < key_count; i++)
+        gen->keymap[i] = keymap[i];
+    gen->key_count = key_count;
+}
+
+static int emit(KeyEvent *out, int n, int max_out, input_event_t key, KeyAction action)
+{
+    if (n >= max_out)
+        return n;
+    out[n].key = (uint8_t)key;
+    out[n].action = (uint8_t)action;
+    out[n].count = 1;
+    return n + 1;
+}
+
+int key_events_update(KeyEventGen *gen, uint32_t held, uint32_t now_ms,
+                      KeyEvent *out, int max_out)
+{
+    const KeyEventConfig *cfg = &gen->config;
+    uint32_t changed = held ^ gen->held;
+    uint32_t active = held | changed;
+    int n = 0;
+
+    for (int i = 0; i < gen->key_count && active; i++)
+    {
+        uint32_t bit = 1UL << i;
+        if (!(active & bit))
+            continue;
+        active &= ~bit;
+
+        input_event_t key = gen->keymap[i];
+
+        if (changed & bit)
+        {
+            if (held & bit)
+            {
+                gen->down_since[i] = now_ms;
+                gen->next_repeat[i] = now_ms + cfg->repeat_delay_ms;
+                gen->long_sent &= ~bit;
+                n = emit(out, n, max_out, key, KEY_ACTION_PRESS);
+            }
+            else
+            {
+                gen->long_sent &= ~bit;
+                n = emit(out, n, max_out, key, KEY_ACTION_RELEASE);
+            }
+            continue;
+        }
+
+        // key still held
+        if (cfg->long_press_ms && !(gen->long_sent & bit) &&
+            (now_ms - gen->down_since[i]) >= cfg->long_press_ms)
+        {
+            gen->long_sent |= bit;
+            n = emit(out, n, max_out, key, KEY_ACTION_LONG_PRESS);
+        }
+
+        if ((cfg->repeat_mask & INPUT_KEY_BIT(key)) &&
+            (int32_t)(now_ms - gen->next_repeat[i]) >= 0)
+        {
+            // if polling fell behind, resync instead of emitting a burst
+            gen->next_repeat[i] += cfg->repeat_rate_ms;
+            if ((int32_t)(now_ms - gen->next_repeat[i]) >= 0)
+                gen->next_repeat[i] = now_ms + cfg->repeat_rate_ms;
+            n = emit(out, n, max_out, key, KEY_ACTION_REPEAT);
+        }
+    }
+
+    gen->held = held;
+    return n;
+}
+
+/* ===== COALESCING QUEUE ===== */
+
+static KeyEvent queue[INPUT_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+static uint32_t queue_coalesce_mask = INPUT_DEFAULT_COALESCE_MASK;
+static InputQueueStats queue_stats;
+
+static bool is_step(const KeyEvent *event)
+{
+    return event->action == KEY_ACTION_PRESS || event->action == KEY_ACTION_REPEAT;
+}
+
+void input_queue_init(uint32_t coalesce_mask)
+{
+    INPUT_LOCK();
+    queue_head = 0;
+    queue_count = 0;
+    queue_coalesce_mask = coalesce_mask;
+    memset(&queue_stats, 0, sizeof(queue_stats));
+    INPUT_UNLOCK();
+}
+
+bool input_queue_push(const KeyEvent *event)
+{
+    bool coalescing = (queue_coalesce_mask & INPUT_KEY_BIT(event->key)) != 0;
+    uint16_t count = event->count ? event->count : 1;
+
+    INPUT_LOCK();
+    queue_stats.pushed++;
+
+    if (coalescing && event->action == KEY_ACTION_RELEASE)
+    {
+        INPUT_UNLOCK();
+        return true;
+    }
+
+    if (coalescing && is_step(event) && queue_count > 0)
+    {
+        KeyEvent *last = &queue[(queue_head + queue_count - 1) % INPUT_QUEUE_SIZE];
+        if (last->key == event->key && is_step(last) && last->count <= UINT16_MAX - count)
+        {
+            last->count += count;
+            queue_stats.coalesced += count;
+            INPUT_UNLOCK();
+            return true;
+        }
+    }
+
+    if (queue_count >= INPUT_QUEUE_SIZE)
+    {
+        queue_stats.dropped++;
+        INPUT_UNLOCK();
+        return false;
+    }
+
+    KeyEvent *slot = &queue[(queue_head + queue_count) % INPUT_QUEUE_SIZE];
+    *slot = *event;
+    slot->count = count;
+    queue_count++;
+    if (queue_count > queue_stats.high_water)
+        queue_stats.high_water = queue_count;
+    INPUT_UNLOCK();
+    return true;
+}
+
+bool input_queue_pop(KeyEvent *event)
+{
+    INPUT_LOCK();
+    if (queue_count == 0)
+    {
+        INPUT_UNLOCK();
+        return false;
+    }
+    *event = queue[queue_head];
+    queue_head = (queue_head + 1) % INPUT_QUEUE_SIZE;
+    queue_count--;
+    INPUT_UNLOCK();
+    return true;
+}
+
+void input_queue_get_stats(InputQueueStats *stats)
+{
+    INPUT_LOCK();
+    *stats = queue_stats;
+    INPUT_UNLOCK();
+}
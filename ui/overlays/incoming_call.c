@@ -114,6 +114,7 @@ Page *incoming_call_overlay_create(const char *phone_number, IncomingCallCallbac
 
     page->draw = incoming_call_draw;
     page->draw_tile = NULL;
+    page->name = "incoming_call";
     page->handle_input = incoming_call_handle_input;
     page->reset = incoming_call_reset;
     page->destroy = incoming_call_destroy;
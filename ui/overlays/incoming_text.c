@@ -92,6 +92,10 @@ static void incoming_text_destroy(Page *self)
     if (!self)
         return;
     IncomingTextState *state = (IncomingTextState *)self->state;
+    if (state->callback)
+    {
+        state->callback(INCOMING_TEXT_ACTION_DESTROY, state->user_data);
+    }
     mem_free(state);
     mem_free(self);
 }
@@ -110,6 +114,7 @@ Page *incoming_text_overlay_create(const char *sender_number, IncomingTextCallba
 
     page->draw = incoming_text_draw;
     page->draw_tile = NULL;
+    page->name = "incoming_text";
     page->handle_input = incoming_text_handle_input;
     page->reset = incoming_text_reset;
     page->destroy = incoming_text_destroy;
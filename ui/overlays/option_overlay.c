@@ -130,6 +130,7 @@ Page *option_overlay_page_create(const char *header, const char **options, int n
     state->mounted = false;
     page->draw = NULL;
     page->draw_tile = option_overlay_draw_tile;
+    page->name = "option";
     page->handle_input = option_overlay_handle_input;
     page->reset = option_overlay_reset;
     page->destroy = option_overlay_destroy;
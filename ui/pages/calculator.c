@@ -578,6 +578,7 @@ Page *calculator_page_create()
 
     page->draw = calculator_draw;
     page->draw_tile = calculator_draw_tile;
+    page->name = "calculator";
     page->handle_input = calculator_handle_input;
     page->reset = NULL;
     page->destroy = calculator_destroy;
@@ -251,6 +251,7 @@ Page *calendar_page_create()
 
     page->draw = NULL;
     page->draw_tile = calendar_draw_tile;
+    page->name = "calendar";
     page->handle_input = calendar_handle_input;
     page->reset = NULL;
     page->destroy = calendar_destroy;
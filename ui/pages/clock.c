@@ -4,6 +4,7 @@
 #include "tile.h"
 #include "input.h"
 #include "theme.h"
+#include "ui_timer.h"
 
 #include "rtc.h"
 #include <stdlib.h>
@@ -18,6 +19,7 @@
 #define MINUTES_LENGTH (CIRCLE_R - 30)
 #define HOURS_LENGTH (CIRCLE_R - 50)
 #define angle(x) ((x) * 6.0f - 90.0f) * 3.14159f / 180.0f
+#define TICK_TIME 1000 // ms
 
 typedef enum
 {
@@ -27,7 +29,7 @@ typedef enum
 
 typedef struct
 {
-    uint32_t elapsed_time;
+    bool tick_due; // set by the second timer, the RTC is only read when due
     ClockMode mode;
     uint8_t prev_minute;
     uint8_t prev_hour;
@@ -156,19 +158,29 @@ static void draw_digital_hours(RTC_TimeTypeDef sTime)
 
 // ========================= VTABLE FUNCTIONS ========================= //
 
+static void clock_timer(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+    {
+        ((ClockState *)self->state)->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
 static void clock_draw_tile(Page *self, int tx, int ty)
 {
     ClockState *state = (ClockState *)self->state;
-    uint32_t current_time = HAL_GetTick();
 
-    char time_buffer[15] = {0};
-    RTC_TimeTypeDef sTime;
-    RTC_DateTypeDef sDate;
-    HAL_RTC_GetTime(&hrtc, &sTime, RTC_FORMAT_BIN);
-    HAL_RTC_GetDate(&hrtc, &sDate, RTC_FORMAT_BIN); // need to read date to refresh shadow registers
-
-    if ((current_time - state->elapsed_time) >= 1000)
+    if (state->tick_due || !state->mounted)
     {
+        state->tick_due = false;
+
+        RTC_TimeTypeDef sTime;
+        RTC_DateTypeDef sDate;
+        HAL_RTC_GetTime(&hrtc, &sTime, RTC_FORMAT_BIN);
+        HAL_RTC_GetDate(&hrtc, &sDate, RTC_FORMAT_BIN); // need to read date to refresh shadow registers
+
         // Time has changed, update display
 
         if (state->mode == DIGITAL)
@@ -215,11 +227,9 @@ static void clock_draw_tile(Page *self, int tx, int ty)
             draw_minute_hand(sTime.Minutes);
         }
 
-        state->elapsed_time = current_time;
         state->prev_minute = sTime.Minutes;
         state->prev_hour = sTime.Hours;
     }
-    mark_all_tiles_dirty();
 }
 
 static void clock_handle_input(Page *self, int event_type)
@@ -231,16 +241,16 @@ static void clock_handle_input(Page *self, int event_type)
         if (state->mode != DIGITAL)
         {
             state->mode = DIGITAL;
-            state->elapsed_time = 0;
             state->mounted = false;
+            mark_tile_dirty(0, 0);
         }
         break;
     case INPUT_DPAD_LEFT:
         if (state->mode != ANALOG)
         {
             state->mode = ANALOG;
-            state->elapsed_time = 0;
             state->mounted = false;
+            mark_tile_dirty(0, 0);
         }
         break;
     default:
@@ -263,7 +273,7 @@ Page *clock_page_create()
     Page *page = mem_malloc(sizeof(Page));
     ClockState *state = mem_malloc(sizeof(ClockState));
     memset(state, 0, sizeof(ClockState));
-    state->elapsed_time = 0;
+    state->tick_due = false;
     state->mode = ANALOG;
     state->prev_minute = 255;
     state->prev_hour = 255;
@@ -272,10 +282,13 @@ Page *clock_page_create()
 
     page->draw = NULL;
     page->draw_tile = clock_draw_tile;
+    page->name = "clock";
     page->handle_input = clock_handle_input;
     page->reset = NULL;
     page->destroy = clock_destroy;
     page->state = state;
 
+    ui_timer_start(page, TICK_TIME, TICK_TIME, clock_timer, page);
+
     return page;
 }
\ No newline at end of file
@@ -176,6 +176,7 @@ Page *contact_details_page_create(ContactRecord contact)
 
     page->draw = NULL; // Full redraw not needed, using tile redraw
     page->draw_tile = contact_details_draw_tile;
+    page->name = "contact";
     page->handle_input = contact_details_handle_input;
     page->reset = contact_details_reset;
     page->destroy = contact_details_destroy;
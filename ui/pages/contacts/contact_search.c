@@ -0,0 +1,289 @@
+#include "contact_search.h"
+#include "memwrap.h"
+#include "ui_timer.h"
+#include <ctype.h>
+#include <stdio.h>
+
+#define SEARCH_VISIBLE_ROWS (TILE_ROWS - 1)
+#define SEARCH_PREFETCH 3
+
+typedef struct
+{
+    VirtualList list;
+    char prefix[MAX_KEY_LEN];
+    uint8_t len;
+    uint32_t found;        // matches the contacts task has found so far
+    bool complete;         // found counts every match
+    bool available;        // cleared when the contacts task has no tree to read
+    input_event_t tap_key; // key of the character still being cycled, INPUT_NONE if committed
+    uint8_t tap_index;
+    bool mounted;
+} ContactSearchState;
+
+static void contact_search_draw_tile(Page *self, int tx, int ty);
+static void contact_search_handle_input(Page *self, int event_type);
+static void contact_search_reset(Page *self);
+static void contact_search_destroy(Page *self);
+
+// matches are counted as the contacts task finds them, the row after the last one asks for more
+static int search_count(void *ctx)
+{
+    ContactSearchState *state = (ContactSearchState *)ctx;
+    if (!state->available)
+        return 0;
+    return (int)state->found + (state->complete ? 0 : 1);
+}
+
+// the row is read off the card by the contacts task and arrives in contact_search_data_response()
+static bool search_fetch(void *ctx, int index, char *out, int out_len)
+{
+    ContactSearchState *state = (ContactSearchState *)ctx;
+    ContactsTask_PostRequest(CONTACTS_CMD_ROW, CONTACTS_CLIENT_SEARCH, state->prefix, index);
+    return false;
+}
+
+static void draw_query_row(ContactSearchState *state)
+{
+    int px, py;
+    tile_to_pixels(0, 0, &px, &py);
+    display_fill_rect(px, py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT, current_theme.bg_colour);
+
+    char text[MAX_KEY_LEN + 2];
+    snprintf(text, sizeof(text), "%s_", state->prefix);
+    display_draw_string(px + 10, py + 8, text, current_theme.text_colour, current_theme.bg_colour, 2);
+
+    char count[16];
+    if (!state->available)
+        snprintf(count, sizeof(count), "-");
+    else
+        snprintf(count, sizeof(count), "%lu%s", (unsigned long)state->found, state->complete ? "" : "+");
+    int width = strlen(count) * 6;
+    display_draw_string(TILE_WIDTH * TILE_COLS - width - 8, py + 12, count, current_theme.text_colour, current_theme.bg_colour, 1);
+    display_draw_horizontal_line(px, py + TILE_HEIGHT - 1, px + TILE_WIDTH * TILE_COLS, current_theme.highlight_colour);
+
+    for (int x = 0; x < TILE_COLS; x++)
+        mark_tile_clean(x, 0);
+}
+
+static void mark_query_dirty(void)
+{
+    for (int x = 0; x < TILE_COLS; x++)
+        mark_tile_dirty(x, 0);
+}
+
+static void contact_search_draw_tile(Page *self, int tx, int ty)
+{
+    ContactSearchState *state = (ContactSearchState *)self->state;
+    if (!state->mounted)
+    {
+        draw_bottom_bar("", "Select", "Back", 0);
+        state->mounted = true;
+    }
+
+    if (ty == 0)
+    {
+        draw_query_row(state);
+        return;
+    }
+    if (ty == 1 && state->list.count == 0)
+    {
+        draw_contact_row(1, 0, state->available ? "No matches" : "No contacts");
+        for (int x = 0; x < TILE_COLS; x++)
+            mark_tile_clean(x, 1);
+        return;
+    }
+    vlist_draw_tile(&state->list, ty);
+}
+
+static void contact_search_data_response(Page *self, int type, void *resp)
+{
+    ContactSearchState *state = (ContactSearchState *)self->state;
+    const ContactsReply *reply = (const ContactsReply *)resp;
+    // answers for an earlier query are dropped, rows for this one are asked for again
+    if (type != PAGE_RESPONSE_CONTACTS || reply->client != CONTACTS_CLIENT_SEARCH ||
+        strcmp(reply->prefix, state->prefix) != 0)
+        return;
+
+    if (reply->cmd == CONTACTS_CMD_OPEN)
+    {
+        if (reply->has_contact)
+            screen_push_page(contact_details_page_create(reply->contact));
+        return;
+    }
+
+    // a row past the last match comes back empty so the "more" row clears
+    vlist_deliver(&state->list, reply->index, reply->has_contact ? reply->contact.name : "");
+    if (reply->available != state->available || reply->found != state->found || reply->complete != state->complete)
+        mark_query_dirty();
+    state->available = reply->available;
+    state->found = reply->found;
+    state->complete = reply->complete;
+    vlist_update_count(&state->list);
+}
+
+// asks again for rows whose answer was dropped
+static void contact_search_retry(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+        vlist_retry_pending(&((ContactSearchState *)self->state)->list);
+}
+
+static void query_push(ContactSearchState *state, char c)
+{
+    if (state->len >= MAX_KEY_LEN - 1)
+        return;
+    state->prefix[state->len++] = c;
+    state->prefix[state->len] = '\0';
+}
+
+static bool query_pop(ContactSearchState *state)
+{
+    if (state->len == 0)
+        return false;
+    state->prefix[--state->len] = '\0';
+    return true;
+}
+
+static void query_changed(ContactSearchState *state)
+{
+    state->found = 0;
+    state->complete = false;
+    state->list.selected = 0;
+    state->list.offset = 0;
+    vlist_refresh(&state->list);
+    mark_query_dirty();
+}
+
+static void commit_tap(ContactSearchState *state)
+{
+    state->tap_key = INPUT_NONE;
+    state->tap_index = 0;
+}
+
+/*
+    Names are stored capitalised and keys compare case-sensitively, so the
+    first letter of each word is entered in upper case.
+*/
+static char adjust_case(ContactSearchState *state, char c)
+{
+    uint8_t len = state->len;
+    if (len == 0 || state->prefix[len - 1] == ' ')
+        return (char)toupper((unsigned char)c);
+    return c;
+}
+
+static void type_key(ContactSearchState *state, input_event_t key)
+{
+    const multitap_key_t *mapping = multitap_get_key_mapping(key);
+    if (!mapping || mapping->count == 0)
+        return;
+
+    if (key == state->tap_key)
+    {
+        // same key again: replace the pending character with the next one
+        query_pop(state);
+        state->tap_index = (state->tap_index + 1) % mapping->count;
+    }
+    else
+    {
+        if (state->len >= MAX_KEY_LEN - 1)
+            return; // query is full
+        state->tap_key = key;
+        state->tap_index = 0;
+    }
+
+    query_push(state, adjust_case(state, mapping->characters[state->tap_index]));
+    query_changed(state);
+}
+
+static void contact_search_handle_input(Page *self, int event_type)
+{
+    ContactSearchState *state = (ContactSearchState *)self->state;
+
+    switch (event_type)
+    {
+    case INPUT_KEYPAD_0:
+        commit_tap(state);
+        query_push(state, ' ');
+        query_changed(state);
+        break;
+    case INPUT_KEYPAD_1:
+    case INPUT_KEYPAD_2:
+    case INPUT_KEYPAD_3:
+    case INPUT_KEYPAD_4:
+    case INPUT_KEYPAD_5:
+    case INPUT_KEYPAD_6:
+    case INPUT_KEYPAD_7:
+    case INPUT_KEYPAD_8:
+    case INPUT_KEYPAD_9:
+        type_key(state, (input_event_t)event_type);
+        break;
+    case INPUT_KEYPAD_HASH:
+        commit_tap(state);
+        break;
+    case INPUT_DPAD_LEFT:
+        commit_tap(state);
+        if (query_pop(state))
+            query_changed(state);
+        break;
+    case INPUT_DPAD_UP:
+        commit_tap(state);
+        vlist_move(&state->list, -1);
+        break;
+    case INPUT_DPAD_DOWN:
+        commit_tap(state);
+        vlist_move(&state->list, +1);
+        break;
+    case INPUT_SELECT:
+        // the details page opens when the contacts task has read the contact
+        ContactsTask_PostRequest(CONTACTS_CMD_OPEN, CONTACTS_CLIENT_SEARCH, state->prefix, state->list.selected);
+        break;
+    }
+}
+
+static void contact_search_reset(Page *self)
+{
+    ContactSearchState *state = (ContactSearchState *)self->state;
+    state->mounted = false;
+}
+
+static void contact_search_destroy(Page *self)
+{
+    if (self == NULL)
+        return;
+    ContactSearchState *state = (ContactSearchState *)self->state;
+    mem_free(state);
+    mem_free(self);
+}
+
+Page *contact_search_page_create(void)
+{
+    Page *page = mem_malloc(sizeof(Page));
+    ContactSearchState *state = mem_malloc(sizeof(ContactSearchState));
+    memset(state, 0, sizeof(*state));
+
+    state->available = true;
+    state->tap_key = INPUT_NONE;
+
+    VListSource source = {
+        .count = search_count,
+        .fetch = search_fetch,
+        .ctx = state};
+    // a list that does not fit the row cache stays zeroed and draws nothing, so show the page empty
+    if (!vlist_init(&state->list, &source, draw_contact_row, 1, 1, SEARCH_VISIBLE_ROWS, SEARCH_PREFETCH))
+        state->available = false;
+
+    page->draw = NULL;
+    page->draw_tile = contact_search_draw_tile;
+    page->name = "contact_search";
+    page->handle_input = contact_search_handle_input;
+    page->reset = contact_search_reset;
+    page->destroy = contact_search_destroy;
+    page->data_response = contact_search_data_response;
+    page->state = state;
+
+    ui_timer_start(page, VLIST_RETRY_MS, VLIST_RETRY_MS, contact_search_retry, page);
+
+    return page;
+}
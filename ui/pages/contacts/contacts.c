@@ -1,11 +1,15 @@
 #include "contacts.h"
 #include "memwrap.h"
+#include "ui_timer.h"
+
+#define CONTACTS_PREFETCH 3
 
 typedef struct
 {
-    Cursor cursor;
-    ContactsView view;
-    int page_offset;
+    VirtualList list;
+    uint32_t found; // contacts the contacts task has read so far
+    bool complete;  // found counts every contact
+    bool available; // cleared when the contacts task has no tree to read
     bool mounted;
 } ContactsState;
 
@@ -14,74 +18,50 @@ static void contacts_handle_input(Page *self, int event_type);
 static void contacts_reset(Page *self);
 static void contacts_destroy(Page *self);
 
-static char *names[] = {
-    "Ty Behnke",
-    "James Wood",
-    "Caiyan Jin",
-    "Pauline Pounds",
-    "Alice Smith",
-    "Bob Johnson",
-    "Charlie Brown",
-    "Diana Prince",
-    "Ethan Hunt",
-    "Fiona Gallagher",
-    "George Martin",
-    "Hannah Baker",
-    "Ian Fleming",
-    "Jack Sparrow",
-    "Kara Thrace",
-    "Liam Neeson",
-};
-
-static char *phones[] = {
-    "+61413279693",
-    "+61234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-    "1234567890",
-};
-
-static void mark_row_clean(Page *self, int row)
+// contacts are counted as the contacts task reads them, the row after the last one asks for more
+static int contacts_count(void *ctx)
 {
-    int tile_y = row;
-    for (int i = 0; i < TILE_COLS; i++)
-    {
-        mark_tile_clean(i, tile_y);
-    }
+    ContactsState *state = (ContactsState *)ctx;
+    if (!state->available)
+        return 0;
+    return (int)state->found + (state->complete ? 0 : 1);
 }
 
-static void mark_row_dirty(Page *self, int row)
+// the row is read off the card by the contacts task and arrives in contacts_data_response()
+static bool contacts_fetch(void *ctx, int index, char *out, int out_len)
 {
-    int tile_y = row;
-    for (int i = 0; i < TILE_COLS; i++)
-    {
-        mark_tile_dirty(i, tile_y);
-    }
+    ContactsTask_PostRequest(CONTACTS_CMD_ROW, CONTACTS_CLIENT_LIST, "", index);
+    return false;
 }
 
-static void update_page_offset(ContactsState *state)
+static void contacts_data_response(Page *self, int type, void *resp)
 {
-    if (state->cursor.y < state->page_offset)
-    {
-        state->page_offset = 0;
-        mark_all_tiles_dirty();
-    }
-    else if (state->cursor.y >= state->page_offset + CONTACTS_VISIBLE_COUNT)
+    ContactsState *state = (ContactsState *)self->state;
+    const ContactsReply *reply = (const ContactsReply *)resp;
+    if (type != PAGE_RESPONSE_CONTACTS || reply->client != CONTACTS_CLIENT_LIST)
+        return;
+
+    if (reply->cmd == CONTACTS_CMD_OPEN)
     {
-        state->page_offset = state->cursor.y;
-        mark_all_tiles_dirty();
+        if (reply->has_contact)
+            screen_push_page(contact_details_page_create(reply->contact));
+        return;
     }
+
+    // a row past the last contact comes back empty so the "more" row clears
+    vlist_deliver(&state->list, reply->index, reply->has_contact ? reply->contact.name : "");
+    state->available = reply->available;
+    state->found = reply->found;
+    state->complete = reply->complete;
+    vlist_update_count(&state->list);
+}
+
+// asks again for rows whose answer was dropped
+static void contacts_retry(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+        vlist_retry_pending(&((ContactsState *)self->state)->list);
 }
 
 static void contacts_draw_tile(Page *self, int tx, int ty)
@@ -89,69 +69,49 @@ static void contacts_draw_tile(Page *self, int tx, int ty)
     ContactsState *state = (ContactsState *)self->state;
     if (!state->mounted)
     {
-        display_fill_rect(0, 25 + TILE_HEIGHT * TILE_ROWS, TILE_WIDTH * TILE_COLS, TILE_HEIGHT, current_theme.fg_colour);
+        draw_bottom_bar("Search", "Select", "Back", 0);
         state->mounted = true;
     }
-    int item_index = state->page_offset + ty;
-    if (item_index >= sizeof(names) / sizeof(names[0]))
+    if (ty == 0 && state->list.count == 0)
     {
-        draw_contact_row(ty, false, ""); // empty row
-        mark_row_clean(self, ty);
+        draw_contact_row(0, 0, "No contacts");
+        for (int x = 0; x < TILE_COLS; x++)
+            mark_tile_clean(x, 0);
         return;
     }
-    bool highlight = (state->cursor.y == item_index);
-    draw_contact_row(ty, highlight, names[item_index]);
-    mark_row_clean(self, ty);
+    vlist_draw_tile(&state->list, ty);
 }
 
 static void contacts_handle_input(Page *self, int event_type)
 {
-    int old_x, old_y;
-    bool moved = false;
     ContactsState *state = (ContactsState *)self->state;
 
     switch (event_type)
     {
     case INPUT_DPAD_UP:
-        moved = cursor_move(&state->cursor, 0, -1, &old_x, &old_y);
+        vlist_move(&state->list, -1);
         break;
     case INPUT_DPAD_DOWN:
-        moved = cursor_move(&state->cursor, 0, +1, &old_x, &old_y);
+        vlist_move(&state->list, +1);
         break;
     case INPUT_DPAD_RIGHT:
-        if (state->cursor.y < 9)
-            moved = cursor_move(&state->cursor, 0, 9 - state->cursor.y, &old_x, &old_y);
+        vlist_move(&state->list, +CONTACTS_VISIBLE_COUNT);
         break;
     case INPUT_DPAD_LEFT:
-        if (state->cursor.y >= 9)
-            moved = cursor_move(&state->cursor, 0, -state->cursor.y, &old_x, &old_y);
+        vlist_move(&state->list, -CONTACTS_VISIBLE_COUNT);
         break;
     }
 
-    if (moved)
+    if (event_type == INPUT_LEFT)
     {
-        update_page_offset(state);
-        int old_row = old_y - state->page_offset;
-        int new_row = state->cursor.y - state->page_offset;
-
-        if (old_row >= 0 && old_row < CONTACTS_VISIBLE_COUNT)
-            mark_row_dirty(self, old_row);
-        if (new_row >= 0 && new_row < CONTACTS_VISIBLE_COUNT)
-            mark_row_dirty(self, new_row);
+        screen_push_page(contact_search_page_create());
+        return;
     }
 
     if (event_type == INPUT_SELECT)
     {
-        ContactRecord contact = {
-            .name_len = strlen(names[state->cursor.y]),
-            .phone_len = SMS_MAX_PHONE_LENGTH - 2,
-            .offset_id = 0};
-        strncpy(contact.name, names[state->cursor.y], sizeof(contact.name) - 1);
-        contact.name[sizeof(contact.name) - 1] = '\0';
-        strncpy(contact.phone, phones[state->cursor.y], sizeof(contact.phone) - 1);
-        contact.phone[sizeof(contact.phone) - 1] = '\0';
-        Page *details_page = contact_details_page_create(contact);
-        screen_push_page(details_page);
+        // the details page opens when the contacts task has read the contact
+        ContactsTask_PostRequest(CONTACTS_CMD_OPEN, CONTACTS_CLIENT_LIST, "", state->list.selected);
     }
     // handle input, update cursor, mark tiles dirty, etc.
 }
@@ -182,16 +142,29 @@ Page *contacts_page_create()
 {
     Page *page = mem_malloc(sizeof(Page));
     ContactsState *state = mem_malloc(sizeof(ContactsState));
-    state->cursor = (Cursor){0, 0, 0, 15, false};
-    state->page_offset = 0;
+    memset(state, 0, sizeof(*state));
+
+    state->available = true;
+
+    VListSource source = {
+        .count = contacts_count,
+        .fetch = contacts_fetch,
+        .ctx = state};
+    // a list that does not fit the row cache stays zeroed and draws nothing, so show the page empty
+    if (!vlist_init(&state->list, &source, draw_contact_row, 0, 1, CONTACTS_VISIBLE_COUNT, CONTACTS_PREFETCH))
+        state->available = false;
     state->mounted = false;
 
     page->draw = NULL;
     page->draw_tile = contacts_draw_tile;
+    page->name = "contacts";
     page->handle_input = contacts_handle_input;
     page->reset = contacts_reset;
     page->destroy = contacts_destroy;
+    page->data_response = contacts_data_response;
     page->state = state;
 
+    ui_timer_start(page, VLIST_RETRY_MS, VLIST_RETRY_MS, contacts_retry, page);
+
     return page;
 }
\ No newline at end of file
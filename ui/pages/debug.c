@@ -8,12 +8,21 @@
 #include "theme.h"
 #include "power_page.h"
 #include "imu_page.h"
+#include "frame_stats_page.h"
+#include "health_page.h"
+#include "memory_page.h"
+#include "trace_page.h"
+#include "boot_page.h"
+#include "bench_page.h"
+#include "profile_page.h"
+#include "sampler_page.h"
 #include "memwrap.h"
 #include <stddef.h>
 #include <string.h>
 
-#define DEBUG_ITEMS_COUNT 2
-#define DEBUG_VISIBLE_COUNT 5
+#define DEBUG_ITEMS_COUNT 10
+// item rows below the two-tile header
+#define DEBUG_VISIBLE_COUNT 4
 
 typedef struct
 {
@@ -65,16 +74,16 @@ static void debug_draw_tile(Page *self, int tx, int ty)
 {
     DebugState *state = (DebugState *)self->state;
     int visible_row = ty / 2; // 0-4 on screen
+    int item_index = state->page_offset + visible_row - 1;
 
     if (visible_row == 0)
     {
         // Header row
         draw_debug_header(0);
     }
-    else if (visible_row <= DEBUG_ITEMS_COUNT)
+    else if (visible_row <= DEBUG_VISIBLE_COUNT && item_index < DEBUG_ITEMS_COUNT)
     {
         // Debug option rows
-        int item_index = visible_row - 1;
         bool highlight = (state->cursor.y == item_index);
         draw_menu_row(visible_row * 2, highlight, state->items[item_index]);
     }
@@ -115,9 +124,25 @@ static void debug_handle_input(Page *self, int event_type)
     // --- Update display if cursor moved ---
     if (moved)
     {
-        // Mark old and new positions dirty (rows start from 1, not 0 because of header)
-        mark_row_dirty(old_y + 1);
-        mark_row_dirty(state->cursor.y + 1);
+        // scroll just enough to keep the cursor on screen
+        int offset = state->page_offset;
+        if (state->cursor.y < offset)
+            offset = state->cursor.y;
+        else if (state->cursor.y >= offset + DEBUG_VISIBLE_COUNT)
+            offset = state->cursor.y - DEBUG_VISIBLE_COUNT + 1;
+
+        if (offset != state->page_offset)
+        {
+            state->page_offset = offset;
+            for (int row = 1; row <= DEBUG_VISIBLE_COUNT; row++)
+                mark_row_dirty(row);
+        }
+        else
+        {
+            // Mark old and new positions dirty (rows start from 1, not 0 because of header)
+            mark_row_dirty(old_y - offset + 1);
+            mark_row_dirty(state->cursor.y - offset + 1);
+        }
     }
 
     // --- Selection action ---
@@ -138,6 +163,54 @@ static void debug_handle_input(Page *self, int event_type)
             screen_push_page(imu_page);
             break;
         }
+        case 2:
+        {
+            Page *frames_page = frame_stats_page_create();
+            screen_push_page(frames_page);
+            break;
+        }
+        case 3:
+        {
+            Page *health_page = health_page_create();
+            screen_push_page(health_page);
+            break;
+        }
+        case 4:
+        {
+            Page *memory_page = memory_page_create();
+            screen_push_page(memory_page);
+            break;
+        }
+        case 5:
+        {
+            Page *trace_page = trace_page_create();
+            screen_push_page(trace_page);
+            break;
+        }
+        case 6:
+        {
+            Page *boot_page = boot_page_create();
+            screen_push_page(boot_page);
+            break;
+        }
+        case 7:
+        {
+            Page *bench_page = bench_page_create();
+            screen_push_page(bench_page);
+            break;
+        }
+        case 8:
+        {
+            Page *profile_page = profile_page_create();
+            screen_push_page(profile_page);
+            break;
+        }
+        case 9:
+        {
+            Page *sampler_page = sampler_page_create();
+            screen_push_page(sampler_page);
+            break;
+        }
         }
     }
 }
@@ -170,10 +243,19 @@ Page *debug_page_create()
     // Initialize debug options
     state->items[0] = "Power";
     state->items[1] = "IMU";
+    state->items[2] = "Frames";
+    state->items[3] = "Health";
+    state->items[4] = "Memory";
+    state->items[5] = "Trace";
+    state->items[6] = "Boot";
+    state->items[7] = "Bench";
+    state->items[8] = "Profile";
+    state->items[9] = "Sampler";
     state->page_offset = 0;
 
     page->draw = debug_draw;
     page->draw_tile = debug_draw_tile;
+    page->name = "debug";
     page->handle_input = debug_handle_input;
     page->reset = debug_reset;
     page->destroy = debug_destroy;
@@ -0,0 +1,242 @@
+#include "bench_page.h"
+#include "screen.h"
+#include "display.h"
+#include "tile.h"
+#include "input.h"
+#include "theme.h"
+#include "frame_stats.h"
+#include "mixer.h"
+#include "mem_sections.h"
+#include "dcache.h"
+#include "stm32_config.h"
+#include "memwrap.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define LINE_HEIGHT 10
+#define BENCH_RUNS 3                 // best of, the first run also warms the caches
+#define SPAN_WIDTH TILE_WIDTH        // below LCD_FMC_DMA_MIN, so the CPU writes every pixel
+#define MIXER_SAMPLES SAMPLE_RATE    // one second of a full chord
+
+typedef enum
+{
+    BENCH_FILL,  // page area in one fill, the panel's fill path
+    BENCH_SPANS, // page area in tile-wide spans, the span writers
+    BENCH_TEXT,  // page area in 5x7 text, the pixel writers
+    BENCH_MIXER, // mixer_next() over MAX_OSCS oscillators
+    BENCH_COUNT
+} BenchCase;
+
+typedef struct
+{
+    uint32_t uncached_us;
+    uint32_t cached_us;
+} BenchResult;
+
+typedef struct
+{
+    BenchResult results[BENCH_COUNT];
+    bool run_due; // set by select, the run happens in the next draw
+    bool has_results;
+    bool mounted;
+} BenchPageState;
+
+typedef struct
+{
+    int px, py;
+    int line;
+} LineWriter;
+
+static const char *const bench_names[BENCH_COUNT] = {"fill", "spans", "text", "mixer"};
+
+// mixed samples land here so the loop is not optimised away
+static volatile int16_t mixer_sink;
+
+static void bench_case(BenchCase which, int px, int py)
+{
+    const int width = TILE_WIDTH * TILE_COLS;
+    const int height = TILE_HEIGHT * TILE_ROWS;
+    switch (which)
+    {
+    case BENCH_FILL:
+        display_fill_rect(px, py, width, height, current_theme.bg_colour);
+        break;
+    case BENCH_SPANS:
+        for (int y = py; y < py + height; y++)
+        {
+            for (int x = px; x < px + width; x += SPAN_WIDTH)
+            {
+                display_fill_rect(x, y, SPAN_WIDTH, 1, current_theme.bg_colour);
+            }
+        }
+        break;
+    case BENCH_TEXT:
+        for (int y = py; y + LINE_HEIGHT <= py + height; y += LINE_HEIGHT)
+        {
+            display_draw_string(px, y, "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcd", current_theme.text_colour,
+                                current_theme.bg_colour, 1);
+        }
+        break;
+    case BENCH_MIXER:
+    {
+        Mixer chord;
+        mixer_init(&chord);
+        mixer_add(&chord, NOTE_C);
+        mixer_add(&chord, NOTE_E);
+        mixer_add(&chord, NOTE_G);
+        mixer_add(&chord, NOTE_C2);
+        for (int i = 0; i < MIXER_SAMPLES; i++)
+        {
+            mixer_sink = mixer_next(&chord);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static uint32_t bench_time(BenchCase which, int px, int py)
+{
+    uint32_t best = UINT32_MAX;
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        uint32_t start = frame_stats_now();
+        bench_case(which, px, py);
+        uint32_t took = frame_stats_elapsed_us(start);
+        if (took < best)
+        {
+            best = took;
+        }
+    }
+    return best;
+}
+
+// every case with the caches off, as before they were enabled, then on
+static void bench_run(BenchPageState *state, int px, int py)
+{
+    static bool table_ready = false;
+    if (!table_ready)
+    {
+        osc_generate_sine_table();
+        table_ready = true;
+    }
+
+    // no task switches inside a measurement, audio and the modem wait for the run
+    vTaskSuspendAll();
+    bool was_on = cache_enabled();
+    for (int pass = 0; pass < 2; pass++)
+    {
+        cache_set_enabled(pass == 1);
+        for (int i = 0; i < BENCH_COUNT; i++)
+        {
+            uint32_t took = bench_time((BenchCase)i, px, py);
+            if (pass == 0)
+            {
+                state->results[i].uncached_us = took;
+            }
+            else
+            {
+                state->results[i].cached_us = took;
+            }
+        }
+    }
+    cache_set_enabled(was_on);
+    xTaskResumeAll();
+    state->has_results = true;
+}
+
+static void put_line(LineWriter *w, const char *text, uint16_t colour)
+{
+    DEBUG_PRINTF("bench: %s\r\n", text);
+    int y = w->py + w->line * LINE_HEIGHT;
+    display_draw_string(w->px, y, text, colour, current_theme.bg_colour, 1);
+    w->line++;
+}
+
+static void bench_draw_tile(Page *self, int tx, int ty)
+{
+    BenchPageState *state = (BenchPageState *)self->state;
+    LineWriter w = {0};
+    tile_to_pixels(0, 0, &w.px, &w.py);
+
+    if (state->run_due)
+    {
+        state->run_due = false;
+        bench_run(state, w.px, w.py);
+        state->mounted = false;
+    }
+    if (state->mounted)
+    {
+        return;
+    }
+    state->mounted = true;
+    display_fill_rect(w.px, w.py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
+
+    char line[64];
+    // every RAMFUNC lands together, so one of them tells where all are
+    snprintf(line, sizeof(line), "hot code in %s", MEM_IN_ITCM(&mixer_next) ? "itcm" : "flash");
+    put_line(&w, line, current_theme.text_colour);
+#if !defined(__arm__)
+    put_line(&w, "no caches here, both passes alike", current_theme.text_colour);
+#endif
+    if (!state->has_results)
+    {
+        put_line(&w, "select runs the benchmark", current_theme.text_colour);
+        return;
+    }
+
+    snprintf(line, sizeof(line), "%-6s%11s%11s%7s", "case", "no cache", "cache", "gain");
+    put_line(&w, line, current_theme.highlight_colour);
+    for (int i = 0; i < BENCH_COUNT; i++)
+    {
+        const BenchResult *r = &state->results[i];
+        uint32_t gain = r->cached_us ? r->uncached_us * 10 / r->cached_us : 0;
+        snprintf(line, sizeof(line), "%-6s%9luus%9luus%4lu.%lux", bench_names[i], (unsigned long)r->uncached_us,
+                 (unsigned long)r->cached_us, (unsigned long)(gain / 10), (unsigned long)(gain % 10));
+        put_line(&w, line, current_theme.text_colour);
+    }
+}
+
+static void bench_handle_input(Page *self, int event_type)
+{
+    BenchPageState *state = (BenchPageState *)self->state;
+    if (event_type == INPUT_SELECT)
+    {
+        state->run_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void bench_destroy(Page *self)
+{
+    if (self)
+    {
+        BenchPageState *state = (BenchPageState *)self->state;
+        mem_free(state);
+        mem_free(self);
+    }
+}
+
+Page *bench_page_create()
+{
+    Page *page = mem_malloc(sizeof(Page));
+    BenchPageState *state = mem_malloc(sizeof(BenchPageState));
+    memset(state, 0, sizeof(BenchPageState));
+
+    page->draw = NULL;
+    page->draw_tile = bench_draw_tile;
+    page->name = "bench";
+    page->handle_input = bench_handle_input;
+    page->reset = NULL;
+    page->destroy = bench_destroy;
+    page->state = state;
+    page->data_response = NULL;
+
+    return page;
+}
@@ -0,0 +1,133 @@
+#include "boot_page.h"
+#include "boot_timeline.h"
+#include "screen.h"
+#include "display.h"
+#include "tile.h"
+#include "input.h"
+#include "theme.h"
+#include "ui_timer.h"
+#include "stm32h7xx_hal.h"
+#include "stm32_config.h"
+#include "memwrap.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define TICK_TIME 1000 // ms
+#define LINE_HEIGHT 10
+#define MAX_LINES ((TILE_HEIGHT * TILE_ROWS) / LINE_HEIGHT)
+
+typedef struct
+{
+    bool tick_due; // set by the refresh timer
+    bool mounted;
+} BootPageState;
+
+typedef struct
+{
+    int px, py;
+    int line;
+} LineWriter;
+
+static void boot_timer(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+    {
+        ((BootPageState *)self->state)->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void put_line(LineWriter *w, const char *text, uint16_t colour)
+{
+    if (w->line >= MAX_LINES)
+    {
+        return;
+    }
+    int y = w->py + w->line * LINE_HEIGHT;
+    display_fill_rect(w->px, y, TILE_WIDTH * TILE_COLS, LINE_HEIGHT, current_theme.bg_colour);
+    display_draw_string(w->px, y, text, colour, current_theme.bg_colour, 1);
+    w->line++;
+}
+
+// header, failed phases and the first frame line stand out
+static void report_line(const char *line, void *arg)
+{
+    LineWriter *w = (LineWriter *)arg;
+    bool marked = w->line == 0 || strchr(line, '!') != NULL || strstr(line, "missed") != NULL;
+    put_line(w, line, marked ? current_theme.highlight_colour : current_theme.text_colour);
+}
+
+static void boot_draw_tile(Page *self, int tx, int ty)
+{
+    BootPageState *state = (BootPageState *)self->state;
+    LineWriter w = {0};
+    tile_to_pixels(0, 0, &w.px, &w.py);
+
+    if (!state->mounted)
+    {
+        display_fill_rect(w.px, w.py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
+        state->mounted = true;
+        state->tick_due = true;
+    }
+
+    if (!state->tick_due)
+    {
+        return;
+    }
+    state->tick_due = false;
+
+    boot_timeline_report(report_line, &w, HAL_GetTick());
+}
+
+static void log_line(const char *line, void *arg)
+{
+    (void)arg;
+    DEBUG_PRINTF("boot: %s\r\n", line);
+}
+
+static void boot_handle_input(Page *self, int event_type)
+{
+    BootPageState *state = (BootPageState *)self->state;
+    if (event_type == INPUT_SELECT)
+    {
+        // the same report again on the UART, as the boot task logged it
+        boot_timeline_report(log_line, NULL, HAL_GetTick());
+        state->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void boot_destroy(Page *self)
+{
+    if (self)
+    {
+        BootPageState *state = (BootPageState *)self->state;
+        mem_free(state);
+        mem_free(self);
+    }
+}
+
+Page *boot_page_create()
+{
+    Page *page = mem_malloc(sizeof(Page));
+    BootPageState *state = mem_malloc(sizeof(BootPageState));
+    memset(state, 0, sizeof(BootPageState));
+    state->mounted = false;
+
+    page->draw = NULL;
+    page->draw_tile = boot_draw_tile;
+    page->name = "boot";
+    page->handle_input = boot_handle_input;
+    page->reset = NULL;
+    page->destroy = boot_destroy;
+    page->state = state;
+    page->data_response = NULL;
+
+    ui_timer_start(page, TICK_TIME, TICK_TIME, boot_timer, page);
+
+    return page;
+}
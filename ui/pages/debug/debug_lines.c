@@ -0,0 +1,50 @@
+#include "debug_lines.h"
+#include "display.h"
+#include "theme.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+void debug_lines_begin(DebugLines *w)
+{
+    tile_to_pixels(0, 0, &w->px, &w->py);
+    w->line = 0;
+}
+
+void debug_lines_blank(DebugLines *w)
+{
+    if (w->line >= DEBUG_MAX_LINES)
+    {
+        return;
+    }
+    display_fill_rect(w->px, w->py + w->line * DEBUG_LINE_HEIGHT, TILE_WIDTH * TILE_COLS, DEBUG_LINE_HEIGHT,
+                      current_theme.bg_colour);
+    w->line++;
+}
+
+void debug_lines_put(DebugLines *w, uint16_t colour, const char *fmt, ...)
+{
+    if (w->line >= DEBUG_MAX_LINES)
+    {
+        return;
+    }
+    char buff[DEBUG_LINE_CHARS];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buff, sizeof(buff), fmt, args);
+    va_end(args);
+
+    int y = w->py + w->line * DEBUG_LINE_HEIGHT;
+    debug_lines_blank(w);
+    display_draw_string(w->px, y, buff, colour, current_theme.bg_colour, 1);
+}
+
+void debug_lines_clear_rest(DebugLines *w)
+{
+    if (w->line < DEBUG_MAX_LINES)
+    {
+        display_fill_rect(w->px, w->py + w->line * DEBUG_LINE_HEIGHT, TILE_WIDTH * TILE_COLS,
+                          (DEBUG_MAX_LINES - w->line) * DEBUG_LINE_HEIGHT, current_theme.bg_colour);
+        w->line = DEBUG_MAX_LINES;
+    }
+}
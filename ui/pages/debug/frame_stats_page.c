@@ -0,0 +1,140 @@
+#include "frame_stats_page.h"
+#include "frame_stats.h"
+#include "input_pipeline.h"
+#include "status_bar.h"
+#include "screen.h"
+#include "display.h"
+#include "tile.h"
+#include "input.h"
+#include "theme.h"
+#include "ui_timer.h"
+#include "memwrap.h"
+#include "debug_lines.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define TICK_TIME 1000 // ms
+// page rows, below the two header lines and above the three counter lines
+#define PAGE_LINES (DEBUG_MAX_LINES - 5)
+
+typedef struct
+{
+    bool tick_due; // set by the refresh timer
+    bool mounted;
+} FrameStatsState;
+
+// refresh only while visible, marking a single tile keeps this page cheap in the frame stats
+static void frame_stats_timer(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+    {
+        ((FrameStatsState *)self->state)->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void frame_stats_draw_tile(Page *self, int tx, int ty)
+{
+    FrameStatsState *state = (FrameStatsState *)self->state;
+    DebugLines w;
+    debug_lines_begin(&w);
+
+    if (!state->mounted)
+    {
+        display_fill_rect(w.px, w.py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
+        state->mounted = true;
+        state->tick_due = true;
+    }
+
+    if (state->tick_due)
+    {
+        state->tick_due = false;
+        debug_lines_put(&w, current_theme.highlight_colour, "%-8s %4s %3s %4s %4s %3s %5s",
+                        "page", "n", "over", "p95", "max", "til", "bytes");
+        debug_lines_put(&w, current_theme.text_colour, "budget %lu us, times in 0.1 ms",
+                        (unsigned long)FRAME_STATS_BUDGET_US);
+
+        for (int i = 0; i < PAGE_LINES; i++)
+        {
+            const FramePageStats *s = frame_stats_get(i);
+            if (!s)
+            {
+                debug_lines_blank(&w);
+                continue;
+            }
+            uint16_t colour = s->over_budget ? current_theme.highlight_colour : current_theme.text_colour;
+            debug_lines_put(&w, colour, "%-8.8s %4lu %3lu %4lu %4lu %3lu %5lu",
+                            s->name,
+                            (unsigned long)(s->frames % 10000),
+                            (unsigned long)(s->over_budget % 1000),
+                            (unsigned long)(frame_stats_percentile(&s->time_us, 95) / 100),
+                            (unsigned long)(s->time_us.max / 100),
+                            (unsigned long)frame_stats_mean(&s->tiles, s->frames),
+                            (unsigned long)frame_stats_mean(&s->bytes, s->frames));
+        }
+
+        InputQueueStats input;
+        input_queue_get_stats(&input);
+        debug_lines_put(&w, current_theme.text_colour, "keys %lu merged %lu dropped %lu hw %u",
+                        (unsigned long)input.pushed, (unsigned long)input.coalesced,
+                        (unsigned long)input.dropped, input.high_water);
+
+        StatusBarStats bar;
+        status_bar_get_stats(&bar);
+        debug_lines_put(&w, current_theme.text_colour, "bar rtc %lu min %lu draws %lu bytes %lu",
+                        (unsigned long)bar.rtc_reads, (unsigned long)bar.minute_ticks,
+                        (unsigned long)bar.redraws, (unsigned long)bar.redraw_bytes);
+
+        UiTimerStats timers;
+        ui_timer_get_stats(&timers);
+        debug_lines_put(&w, current_theme.text_colour, "timers %u hw %u fired %lu full %lu",
+                        timers.active, timers.high_water,
+                        (unsigned long)timers.fired, (unsigned long)timers.exhausted);
+    }
+}
+
+static void frame_stats_handle_input(Page *self, int event_type)
+{
+    FrameStatsState *state = (FrameStatsState *)self->state;
+    if (event_type == INPUT_SELECT)
+    {
+        frame_stats_reset();
+        state->mounted = false;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void frame_stats_destroy(Page *self)
+{
+    if (self)
+    {
+        FrameStatsState *state = (FrameStatsState *)self->state;
+        mem_free(state);
+        mem_free(self);
+    }
+}
+
+Page *frame_stats_page_create()
+{
+    Page *page = mem_malloc(sizeof(Page));
+    FrameStatsState *state = mem_malloc(sizeof(FrameStatsState));
+    memset(state, 0, sizeof(FrameStatsState));
+    state->mounted = false;
+
+    page->draw = NULL;
+    page->draw_tile = frame_stats_draw_tile;
+    page->name = "frames";
+    page->handle_input = frame_stats_handle_input;
+    page->reset = NULL;
+    page->destroy = frame_stats_destroy;
+    page->state = state;
+    page->data_response = NULL;
+
+    ui_timer_start(page, TICK_TIME, TICK_TIME, frame_stats_timer, page);
+
+    return page;
+}
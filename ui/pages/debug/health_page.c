@@ -0,0 +1,193 @@
+#include "health_page.h"
+#include "health_monitor.h"
+#include "tickless_idle.h"
+#include "keypad.h"
+#include "screen.h"
+#include "display.h"
+#include "tile.h"
+#include "input.h"
+#include "theme.h"
+#include "ui_timer.h"
+#include "stm32h7xx_hal.h"
+#include "memwrap.h"
+#include "debug_lines.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define TICK_TIME 1000 // ms
+
+typedef struct
+{
+    bool tick_due; // set by the refresh timer
+    bool mounted;
+} HealthState;
+
+static void health_timer(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+    {
+        ((HealthState *)self->state)->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void draw_tasks(DebugLines *w)
+{
+    HealthTaskInfo tasks[HEALTH_MAX_TASKS];
+    int count = health_get_tasks(tasks, HEALTH_MAX_TASKS);
+
+    debug_lines_put(w, current_theme.highlight_colour, "%-11s %5s %5s %5s %3s", "task", "cpu%", "stack", "min", "pri");
+    for (int i = 0; i < count; i++)
+    {
+        const HealthTaskInfo *t = &tasks[i];
+        bool low = t->stack_min < HEALTH_STACK_LOW_BYTES;
+        debug_lines_put(w, low ? current_theme.highlight_colour : current_theme.text_colour,
+                        "%-11.11s %3u.%u %5lu %5lu %3u", t->name,
+                        t->cpu_permille / 10, t->cpu_permille % 10,
+                        (unsigned long)t->stack_free, (unsigned long)t->stack_min, t->priority);
+    }
+}
+
+static void draw_heartbeats(DebugLines *w, uint32_t now)
+{
+    HealthHeartbeatInfo beats[HEALTH_MAX_HEARTBEATS];
+    int count = health_get_heartbeats(beats, HEALTH_MAX_HEARTBEATS, now);
+
+    debug_lines_put(w, current_theme.highlight_colour, "%-9s %6s %6s %6s", "beat", "age", "max", "limit");
+    for (int i = 0; i < count; i++)
+    {
+        const HealthHeartbeatInfo *b = &beats[i];
+        debug_lines_put(w, b->hung ? current_theme.highlight_colour : current_theme.text_colour,
+                        "%-9.9s %6lu %6lu %6lu %s", b->name,
+                        (unsigned long)b->age_ms, (unsigned long)b->max_age_ms,
+                        (unsigned long)b->timeout_ms, b->hung ? "HANG" : (b->critical ? "crit" : ""));
+    }
+}
+
+static void draw_sleep(DebugLines *w, uint32_t now)
+{
+    TicklessStats sleep;
+    KeypadWakeStats wake;
+    tickless_get_stats(&sleep);
+    keypad_get_wake_stats(&wake);
+
+    // ticks are milliseconds, shares are of the uptime
+    uint32_t up = now ? now : 1;
+    uint32_t idle = (uint32_t)((uint64_t)sleep.sleep_ticks * 1000 / up);
+    uint32_t stop = (uint32_t)((uint64_t)sleep.stop_ticks * 1000 / up);
+    debug_lines_put(w, current_theme.text_colour, "idle %lu.%lu%% stop %lu.%lu%% veto %lu",
+                    (unsigned long)(idle / 10), (unsigned long)(idle % 10),
+                    (unsigned long)(stop / 10), (unsigned long)(stop % 10),
+                    (unsigned long)sleep.vetoed);
+
+    debug_lines_put(w, current_theme.text_colour, "key wake irq %lu poll %lu %lu/%lums",
+                    (unsigned long)wake.exti_wakes, (unsigned long)wake.polled_wakes,
+                    (unsigned long)wake.last_latency_ms, (unsigned long)wake.max_latency_ms);
+}
+
+static void draw_history(DebugLines *w)
+{
+    HealthRecord records[HEALTH_HISTORY_LEN];
+    int count = health_get_history(records, HEALTH_HISTORY_LEN);
+
+    for (int i = 0; i < count && w->line < DEBUG_MAX_LINES; i++)
+    {
+        const HealthRecord *r = &records[i];
+        switch (r->event)
+        {
+        case HEALTH_EVENT_BOOT:
+            debug_lines_put(w, current_theme.text_colour, "#%u boot %s, before ran %lus", r->boot,
+                            health_reset_name((HealthResetCause)r->reset_cause), (unsigned long)r->value);
+            break;
+        case HEALTH_EVENT_HANG:
+            debug_lines_put(w, current_theme.highlight_colour, "#%u %lus hang %s %lums", r->boot,
+                            (unsigned long)r->uptime_s, r->name, (unsigned long)r->value);
+            break;
+        default:
+            debug_lines_put(w, current_theme.highlight_colour, "#%u %lus stack %s %luB", r->boot,
+                            (unsigned long)r->uptime_s, r->name, (unsigned long)r->value);
+            break;
+        }
+    }
+}
+
+static void health_draw_tile(Page *self, int tx, int ty)
+{
+    HealthState *state = (HealthState *)self->state;
+    DebugLines w;
+    debug_lines_begin(&w);
+
+    if (!state->mounted)
+    {
+        display_fill_rect(w.px, w.py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
+        state->mounted = true;
+        state->tick_due = true;
+    }
+
+    if (!state->tick_due)
+    {
+        return;
+    }
+    state->tick_due = false;
+
+    uint32_t now = HAL_GetTick();
+    uint16_t boots;
+    HealthResetCause cause;
+    health_get_boot(&boots, &cause);
+    debug_lines_put(&w, current_theme.text_colour, "boot %u reset %s up %lus", boots,
+                    health_reset_name(cause), (unsigned long)(now / 1000));
+    draw_sleep(&w, now);
+
+    draw_tasks(&w);
+    draw_heartbeats(&w, now);
+    draw_history(&w);
+
+    // clear what the previous refresh drew below the last line
+    debug_lines_clear_rest(&w);
+}
+
+static void health_handle_input(Page *self, int event_type)
+{
+    HealthState *state = (HealthState *)self->state;
+    if (event_type == INPUT_SELECT)
+    {
+        health_clear_history();
+        state->mounted = false;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void health_destroy(Page *self)
+{
+    if (self)
+    {
+        HealthState *state = (HealthState *)self->state;
+        mem_free(state);
+        mem_free(self);
+    }
+}
+
+Page *health_page_create()
+{
+    Page *page = mem_malloc(sizeof(Page));
+    HealthState *state = mem_malloc(sizeof(HealthState));
+    memset(state, 0, sizeof(HealthState));
+    state->mounted = false;
+
+    page->draw = NULL;
+    page->draw_tile = health_draw_tile;
+    page->name = "health";
+    page->handle_input = health_handle_input;
+    page->reset = NULL;
+    page->destroy = health_destroy;
+    page->state = state;
+    page->data_response = NULL;
+
+    ui_timer_start(page, TICK_TIME, TICK_TIME, health_timer, page);
+
+    return page;
+}
@@ -4,7 +4,9 @@
 #include "tile.h"
 #include "input.h"
 #include "theme.h"
+#include "ui_timer.h"
 #include "lsm6dsv.h"
+#include "memwrap.h"
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -14,16 +16,26 @@
 
 typedef struct
 {
-    uint32_t last_tick;
+    bool tick_due; // set by the refresh timer
     lsm6dsv_data_t data;
     bool mounted;
 
 } IMUState;
 
+// sample the IMU only while this page is on screen
+static void imu_timer(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+    {
+        ((IMUState *)self->state)->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
 static void imu_draw_tile(Page *self, int tx, int ty)
 {
     IMUState *state = (IMUState *)self->state;
-    uint32_t curr_time = HAL_GetTick();
     int px, py;
     char buff[32];
     if (!state->mounted)
@@ -31,14 +43,15 @@ static void imu_draw_tile(Page *self, int tx, int ty)
         tile_to_pixels(0, 0, &px, &py);
         display_fill_rect(px, py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
         state->mounted = true;
-        state->last_tick = 0;
+        state->tick_due = true;
         // init first time just in case 
         // TODO: Remove later 
         lsm6dsv_init();
     }
 
-    if ((curr_time - state->last_tick) > TICK_TIME)
+    if (state->tick_due)
     {
+        state->tick_due = false;
         lsm6dsv_get_all(&state->data);
 
         tile_to_pixels(0, 1, &px, &py);
@@ -75,10 +88,7 @@ static void imu_draw_tile(Page *self, int tx, int ty)
         snprintf(buff, sizeof(buff), "TEMP: %12.4fc", state->data.temp);
         display_draw_string(px, py, buff, current_theme.text_colour, current_theme.bg_colour, 2);
         memset(buff, 0, sizeof(buff));
-
-        state->last_tick = curr_time;
     }
-    mark_all_tiles_dirty();
 }
 
 static void imu_handle_input(Page *self, int event_type)
@@ -112,25 +122,28 @@ static void imu_destroy(Page *self)
     if (self)
     {
         IMUState *state = (IMUState *)self->state;
-        free(state);
-        free(self);
+        mem_free(state);
+        mem_free(self);
     }
 }
 
 Page *imu_page_create()
 {
-    Page *page = malloc(sizeof(Page));
-    IMUState *state = malloc(sizeof(IMUState));
+    Page *page = mem_malloc(sizeof(Page));
+    IMUState *state = mem_malloc(sizeof(IMUState));
     memset(state, 0, sizeof(IMUState));
     state->mounted = false;
 
     page->draw = NULL;
     page->draw_tile = imu_draw_tile;
+    page->name = "imu";
     page->handle_input = imu_handle_input;
     page->reset = NULL;
     page->destroy = imu_destroy;
     page->state = state;
     page->data_response = NULL;
 
+    ui_timer_start(page, TICK_TIME, TICK_TIME, imu_timer, page);
+
     return page;
 }
@@ -0,0 +1,169 @@
+#include "memory_page.h"
+#include "screen.h"
+#include "display.h"
+#include "tile.h"
+#include "input.h"
+#include "theme.h"
+#include "ui_timer.h"
+#include "memwrap.h"
+#include "debug_lines.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define TICK_TIME 1000 // ms
+#define TAG_LINES 8
+
+typedef struct
+{
+    bool tick_due; // set by the refresh timer
+    bool mounted;
+} MemoryState;
+
+static void memory_timer(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+    {
+        ((MemoryState *)self->state)->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void draw_heap(DebugLines *w)
+{
+    MemHeapStats heap;
+    mem_get_heap_stats(&heap);
+
+    debug_lines_put(w, current_theme.text_colour, "heap free %lu largest %lu",
+                    (unsigned long)heap.free_bytes, (unsigned long)heap.largest_free);
+    debug_lines_put(w, current_theme.text_colour, "frag %u.%u%% in %lu blocks, low %lu",
+                    heap.fragmentation_permille / 10, heap.fragmentation_permille % 10,
+                    (unsigned long)heap.free_blocks, (unsigned long)heap.min_ever_free);
+}
+
+static void draw_tags(DebugLines *w)
+{
+    MemTrackStats totals;
+    mem_track_get_stats(&totals);
+    debug_lines_put(w, current_theme.text_colour, "live %luB in %lu, peak %luB", (unsigned long)totals.live_bytes,
+                    (unsigned long)totals.live_count, (unsigned long)totals.peak_bytes);
+    if (totals.untracked || totals.failed)
+    {
+        debug_lines_put(w, current_theme.highlight_colour, "untracked %lu failed %lu",
+                        (unsigned long)totals.untracked, (unsigned long)totals.failed);
+    }
+
+    MemTagStats tags[TAG_LINES];
+    int count = mem_track_get_tags(tags, TAG_LINES);
+    debug_lines_put(w, current_theme.highlight_colour, "%-18s %6s %6s %4s", "file", "live", "peak", "n");
+    for (int i = 0; i < count; i++)
+    {
+        debug_lines_put(w, current_theme.text_colour, "%-18.18s %6lu %6lu %4lu", tags[i].tag,
+                        (unsigned long)tags[i].live_bytes, (unsigned long)tags[i].peak_bytes,
+                        (unsigned long)tags[i].live_count);
+    }
+}
+
+static void draw_leaks(DebugLines *w)
+{
+    MemTrackStats totals;
+    MemLeakReport report;
+    mem_track_get_stats(&totals);
+    mem_track_get_leak_report(&report);
+
+    debug_lines_put(w, totals.leaks ? current_theme.highlight_colour : current_theme.text_colour,
+                    "page pops %lu, leaked blocks %lu", (unsigned long)totals.leak_checks,
+                    (unsigned long)totals.leaks);
+    if (report.count == 0)
+    {
+        return;
+    }
+
+    debug_lines_put(w, current_theme.highlight_colour, "last: %s %lu blocks %luB", report.page,
+                    (unsigned long)report.count, (unsigned long)report.bytes);
+    int shown = report.count < MEM_LEAK_REPORT_LEN ? (int)report.count : MEM_LEAK_REPORT_LEN;
+    for (int i = 0; i < shown; i++)
+    {
+        const MemBlockInfo *b = &report.blocks[i];
+        debug_lines_put(w, current_theme.text_colour, "  %s:%u %luB", b->tag, b->line, (unsigned long)b->size);
+    }
+}
+
+static void memory_draw_tile(Page *self, int tx, int ty)
+{
+    MemoryState *state = (MemoryState *)self->state;
+    DebugLines w;
+    debug_lines_begin(&w);
+
+    if (!state->mounted)
+    {
+        display_fill_rect(w.px, w.py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
+        state->mounted = true;
+        state->tick_due = true;
+    }
+
+    if (!state->tick_due)
+    {
+        return;
+    }
+    state->tick_due = false;
+
+    draw_heap(&w);
+    if (mem_track_enabled())
+    {
+        draw_tags(&w);
+        draw_leaks(&w);
+    }
+    else
+    {
+        debug_lines_put(&w, current_theme.text_colour, "build with MEM_TRACKING for owners");
+    }
+
+    // clear what the previous refresh drew below the last line
+    debug_lines_clear_rest(&w);
+}
+
+static void memory_handle_input(Page *self, int event_type)
+{
+    MemoryState *state = (MemoryState *)self->state;
+    if (event_type == INPUT_SELECT)
+    {
+        mem_track_reset_peaks();
+        state->mounted = false;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void memory_destroy(Page *self)
+{
+    if (self)
+    {
+        MemoryState *state = (MemoryState *)self->state;
+        mem_free(state);
+        mem_free(self);
+    }
+}
+
+Page *memory_page_create()
+{
+    Page *page = mem_malloc(sizeof(Page));
+    MemoryState *state = mem_malloc(sizeof(MemoryState));
+    memset(state, 0, sizeof(MemoryState));
+    state->mounted = false;
+
+    page->draw = NULL;
+    page->draw_tile = memory_draw_tile;
+    page->name = "memory";
+    page->handle_input = memory_handle_input;
+    page->reset = NULL;
+    page->destroy = memory_destroy;
+    page->state = state;
+    page->data_response = NULL;
+
+    ui_timer_start(page, TICK_TIME, TICK_TIME, memory_timer, page);
+
+    return page;
+}
@@ -4,7 +4,9 @@
 #include "tile.h"
 #include "input.h"
 #include "theme.h"
+#include "ui_timer.h"
 #include "mcp73871.h"
+#include "memwrap.h"
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -14,7 +16,7 @@
 
 typedef struct
 {
-    uint32_t last_tick;
+    bool tick_due; // set by the refresh timer
     uint16_t soc;
     int16_t current;
     uint16_t voltage;
@@ -27,21 +29,32 @@ typedef struct
 
 
 
+// poll the gauge only while this page is on screen
+static void power_timer(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+    {
+        ((PowerState *)self->state)->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
 static void power_draw_tile(Page *self, int tx, int ty)
 {
     PowerState *state = (PowerState *)self->state;
-    uint32_t curr_time = HAL_GetTick();
     int px, py;
     char buff[32];
     if (!state->mounted) {
         tile_to_pixels(0, 0, &px, &py);
         display_fill_rect(px, py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
         state->mounted = true;
-        state->last_tick = 0;
+        state->tick_due = true;
     }
 
-    if ((curr_time - state->last_tick) > TICK_TIME)
+    if (state->tick_due)
     {
+        state->tick_due = false;
         screen_request(PAGE_REQUEST_BATTERY_HC, NULL);
 
         tile_to_pixels(0, 1, &px, &py);
@@ -122,10 +135,7 @@ static void power_draw_tile(Page *self, int tx, int ty)
             display_draw_string(px, py, "Status:     UNKNOWN", current_theme.text_colour, current_theme.bg_colour, 2);
             break;
         }
-
-        state->last_tick = curr_time;
     }
-    mark_all_tiles_dirty();
 }
 
 static void power_handle_input(Page *self, int event_type)
@@ -155,7 +165,7 @@ static void power_handle_input(Page *self, int event_type)
 }
 
 static void power_handle_response(Page *self, int type, void *resp) {
-    // VERY UNSAFE MEMORY HANDLING DO NOT COPY PLEASE FIX
+    // resp is a pool message the display task holds until this returns
     PowerState* state = (PowerState *)self->state;
     uint16_t* stats = (uint16_t*)resp;
     if (type == PAGE_RESPONSE_BATTERY_HC) {
@@ -173,25 +183,28 @@ static void power_destroy(Page *self)
     if (self)
     {
         PowerState *state = (PowerState *)self->state;
-        free(state);
-        free(self);
+        mem_free(state);
+        mem_free(self);
     }
 }
 
 Page *power_page_create()
 {
-    Page *page = malloc(sizeof(Page));
-    PowerState *state = malloc(sizeof(PowerState));
+    Page *page = mem_malloc(sizeof(Page));
+    PowerState *state = mem_malloc(sizeof(PowerState));
     memset(state, 0, sizeof(PowerState));
     state->mounted = false;
 
     page->draw = NULL;
     page->draw_tile = power_draw_tile;
+    page->name = "power";
     page->handle_input = power_handle_input;
     page->reset = NULL;
     page->destroy = power_destroy;
     page->state = state;
     page->data_response = power_handle_response;
 
+    ui_timer_start(page, TICK_TIME, TICK_TIME, power_timer, page);
+
     return page;
 }
@@ -0,0 +1,142 @@
+#include "profile_page.h"
+#include "profile.h"
+#include "screen.h"
+#include "display.h"
+#include "tile.h"
+#include "input.h"
+#include "theme.h"
+#include "ui_timer.h"
+#include "stm32_config.h"
+#include "memwrap.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define TICK_TIME 1000 // ms
+#define LINE_HEIGHT 10
+#define MAX_LINES ((TILE_HEIGHT * TILE_ROWS) / LINE_HEIGHT)
+
+typedef struct
+{
+    bool tick_due; // set by the refresh timer
+    bool mounted;
+} ProfilePageState;
+
+typedef struct
+{
+    int px, py;
+    int line;
+} LineWriter;
+
+static void profile_timer(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+    {
+        ((ProfilePageState *)self->state)->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void put_line(LineWriter *w, const char *text, uint16_t colour)
+{
+    if (w->line >= MAX_LINES)
+    {
+        return;
+    }
+    int y = w->py + w->line * LINE_HEIGHT;
+    display_fill_rect(w->px, y, TILE_WIDTH * TILE_COLS, LINE_HEIGHT, current_theme.bg_colour);
+    display_draw_string(w->px, y, text, colour, current_theme.bg_colour, 1);
+    w->line++;
+}
+
+#if defined(PROFILE_ENABLED)
+static void report_line(const char *line, void *arg)
+{
+    LineWriter *w = (LineWriter *)arg;
+    put_line(w, line, w->line == 0 ? current_theme.highlight_colour : current_theme.text_colour);
+}
+#endif
+
+static void profile_draw_tile(Page *self, int tx, int ty)
+{
+    ProfilePageState *state = (ProfilePageState *)self->state;
+    LineWriter w = {0};
+    tile_to_pixels(0, 0, &w.px, &w.py);
+
+    if (!state->mounted)
+    {
+        display_fill_rect(w.px, w.py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
+        state->mounted = true;
+        state->tick_due = true;
+    }
+
+    if (!state->tick_due)
+    {
+        return;
+    }
+    state->tick_due = false;
+
+#if defined(PROFILE_ENABLED)
+    profile_report(report_line, &w);
+    put_line(&w, "select logs and clears the table", current_theme.text_colour);
+#else
+    put_line(&w, "build with PROFILE=1 to record", current_theme.text_colour);
+#endif
+}
+
+#if defined(PROFILE_ENABLED)
+static void log_line(const char *line, void *arg)
+{
+    (void)arg;
+    DEBUG_PRINTF("profile: %s\r\n", line);
+}
+#endif
+
+static void profile_handle_input(Page *self, int event_type)
+{
+    ProfilePageState *state = (ProfilePageState *)self->state;
+    if (event_type == INPUT_SELECT)
+    {
+#if defined(PROFILE_ENABLED)
+        // what has been gathered so far goes to the UART, the page starts again from empty
+        profile_report(log_line, NULL);
+        profile_reset();
+#endif
+        state->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void profile_destroy(Page *self)
+{
+    if (self)
+    {
+        ProfilePageState *state = (ProfilePageState *)self->state;
+        mem_free(state);
+        mem_free(self);
+    }
+}
+
+Page *profile_page_create()
+{
+    Page *page = mem_malloc(sizeof(Page));
+    ProfilePageState *state = mem_malloc(sizeof(ProfilePageState));
+    memset(state, 0, sizeof(ProfilePageState));
+    state->mounted = false;
+
+    page->draw = NULL;
+    page->draw_tile = profile_draw_tile;
+    page->name = "profile";
+    page->handle_input = profile_handle_input;
+    page->reset = NULL;
+    page->destroy = profile_destroy;
+    page->state = state;
+    page->data_response = NULL;
+
+    ui_timer_start(page, TICK_TIME, TICK_TIME, profile_timer, page);
+
+    return page;
+}
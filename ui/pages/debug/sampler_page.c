@@ -0,0 +1,202 @@
+#include "sampler_page.h"
+#include "screen.h"
+#include "display.h"
+#include "tile.h"
+#include "input.h"
+#include "theme.h"
+#include "ui_timer.h"
+#include "memwrap.h"
+#include "sampler.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define TICK_TIME 1000 // ms
+#define LINE_HEIGHT 10
+#define MAX_LINES ((TILE_HEIGHT * TILE_ROWS) / LINE_HEIGHT)
+#define SAMPLER_FILE "samples.bin"
+
+typedef enum
+{
+    DUMP_NONE,
+    DUMP_OK,
+    DUMP_FAILED,
+} DumpResult;
+
+typedef struct
+{
+    bool tick_due; // set by the refresh timer
+    bool mounted;
+    DumpResult sd;
+    DumpResult uart;
+} SamplerState;
+
+typedef struct
+{
+    int px, py;
+    int line;
+} LineWriter;
+
+static void sampler_timer(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+    {
+        ((SamplerState *)self->state)->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void put_line(LineWriter *w, const char *text, uint16_t colour)
+{
+    if (w->line >= MAX_LINES)
+    {
+        return;
+    }
+    int y = w->py + w->line * LINE_HEIGHT;
+    display_fill_rect(w->px, y, TILE_WIDTH * TILE_COLS, LINE_HEIGHT, current_theme.bg_colour);
+    display_draw_string(w->px, y, text, colour, current_theme.bg_colour, 1);
+    w->line++;
+}
+
+#if defined(SAMPLER_ENABLED)
+static const char *result_text(DumpResult result)
+{
+    switch (result)
+    {
+    case DUMP_OK:
+        return "ok";
+    case DUMP_FAILED:
+        return "failed";
+    default:
+        return "-";
+    }
+}
+
+static void draw_stats(LineWriter *w, SamplerState *state, char *buff, size_t size)
+{
+    SamplerStats stats;
+    sampler_get_stats(&stats);
+
+    if (stats.running)
+    {
+        snprintf(buff, size, "sampling at %lu Hz", (unsigned long)stats.rate_hz);
+        put_line(w, buff, current_theme.highlight_colour);
+    }
+    else
+    {
+        put_line(w, "stopped", current_theme.text_colour);
+    }
+    uint32_t kept = stats.taken < stats.capacity ? stats.taken : stats.capacity;
+    snprintf(buff, size, "samples %lu kept %lu", (unsigned long)stats.taken, (unsigned long)kept);
+    put_line(w, buff, current_theme.text_colour);
+    if (stats.rate_hz)
+    {
+        snprintf(buff, size, "ring holds %lu s", (unsigned long)(stats.capacity / stats.rate_hz));
+        put_line(w, buff, current_theme.text_colour);
+    }
+
+    snprintf(buff, size, "sd %s uart %s", result_text(state->sd), result_text(state->uart));
+    put_line(w, buff, current_theme.text_colour);
+#if defined(__arm__) && defined(USE_FREERTOS)
+    put_line(w, stats.running ? "select: stop and dump to " SAMPLER_FILE : "select: clear and start",
+             current_theme.text_colour);
+#else
+    put_line(w, "no timer, samples on the target only", current_theme.text_colour);
+#endif
+}
+#endif
+
+static void sampler_draw_tile(Page *self, int tx, int ty)
+{
+    SamplerState *state = (SamplerState *)self->state;
+    LineWriter w = {0};
+    tile_to_pixels(0, 0, &w.px, &w.py);
+
+    if (!state->mounted)
+    {
+        display_fill_rect(w.px, w.py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
+        state->mounted = true;
+        state->tick_due = true;
+    }
+
+    if (!state->tick_due)
+    {
+        return;
+    }
+    state->tick_due = false;
+
+#if defined(SAMPLER_ENABLED)
+    char buff[48];
+    draw_stats(&w, state, buff, sizeof(buff));
+#else
+    put_line(&w, "build with SAMPLER=1 to sample", current_theme.text_colour);
+#endif
+
+    // clear what the previous refresh drew below the last line
+    if (w.line < MAX_LINES)
+    {
+        display_fill_rect(w.px, w.py + w.line * LINE_HEIGHT, TILE_WIDTH * TILE_COLS,
+                          (MAX_LINES - w.line) * LINE_HEIGHT, current_theme.bg_colour);
+    }
+}
+
+static void sampler_handle_input(Page *self, int event_type)
+{
+    SamplerState *state = (SamplerState *)self->state;
+    if (event_type == INPUT_SELECT)
+    {
+#if defined(__arm__) && defined(USE_FREERTOS) && defined(SAMPLER_ENABLED)
+        SamplerStats stats;
+        sampler_get_stats(&stats);
+        if (stats.running)
+        {
+            sampler_stop();
+            state->sd = sampler_save(SAMPLER_FILE) ? DUMP_OK : DUMP_FAILED;
+            state->uart = sampler_send_uart() ? DUMP_OK : DUMP_FAILED;
+        }
+        else
+        {
+            sampler_init();
+            sampler_start(SAMPLER_DEFAULT_HZ);
+            state->sd = DUMP_NONE;
+            state->uart = DUMP_NONE;
+        }
+#endif
+        state->mounted = false;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void sampler_destroy(Page *self)
+{
+    if (self)
+    {
+        SamplerState *state = (SamplerState *)self->state;
+        mem_free(state);
+        mem_free(self);
+    }
+}
+
+Page *sampler_page_create()
+{
+    Page *page = mem_malloc(sizeof(Page));
+    SamplerState *state = mem_malloc(sizeof(SamplerState));
+    memset(state, 0, sizeof(SamplerState));
+    state->mounted = false;
+
+    page->draw = NULL;
+    page->draw_tile = sampler_draw_tile;
+    page->name = "sampler";
+    page->handle_input = sampler_handle_input;
+    page->reset = NULL;
+    page->destroy = sampler_destroy;
+    page->state = state;
+    page->data_response = NULL;
+
+    ui_timer_start(page, TICK_TIME, TICK_TIME, sampler_timer, page);
+
+    return page;
+}
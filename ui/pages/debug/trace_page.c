@@ -0,0 +1,184 @@
+#include "trace_page.h"
+#include "screen.h"
+#include "display.h"
+#include "tile.h"
+#include "input.h"
+#include "theme.h"
+#include "ui_timer.h"
+#include "memwrap.h"
+#include "trace.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define TICK_TIME 1000 // ms
+#define LINE_HEIGHT 10
+#define MAX_LINES ((TILE_HEIGHT * TILE_ROWS) / LINE_HEIGHT)
+#define TRACE_FILE "trace.bin"
+
+typedef enum
+{
+    DUMP_NONE,
+    DUMP_OK,
+    DUMP_FAILED,
+} DumpResult;
+
+typedef struct
+{
+    bool tick_due; // set by the refresh timer
+    bool mounted;
+    DumpResult sd;
+    DumpResult uart;
+} TraceState;
+
+typedef struct
+{
+    int px, py;
+    int line;
+} LineWriter;
+
+static void trace_timer(void *arg)
+{
+    Page *self = (Page *)arg;
+    if (screen_get_current_page() == self)
+    {
+        ((TraceState *)self->state)->tick_due = true;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void put_line(LineWriter *w, const char *text, uint16_t colour)
+{
+    if (w->line >= MAX_LINES)
+    {
+        return;
+    }
+    int y = w->py + w->line * LINE_HEIGHT;
+    display_fill_rect(w->px, y, TILE_WIDTH * TILE_COLS, LINE_HEIGHT, current_theme.bg_colour);
+    display_draw_string(w->px, y, text, colour, current_theme.bg_colour, 1);
+    w->line++;
+}
+
+#if defined(TRACE_ENABLED)
+static const char *result_text(DumpResult result)
+{
+    switch (result)
+    {
+    case DUMP_OK:
+        return "ok";
+    case DUMP_FAILED:
+        return "failed";
+    default:
+        return "-";
+    }
+}
+
+static void draw_stats(LineWriter *w, TraceState *state, char *buff, size_t size)
+{
+    TraceStats stats;
+    trace_get_stats(&stats);
+
+    const char *mode = stats.enabled ? "recording" : "stopped";
+    if (stats.triggered)
+    {
+        mode = stats.enabled ? "triggered" : "frozen";
+    }
+    snprintf(buff, size, "ring %s", mode);
+    put_line(w, buff, stats.triggered ? current_theme.highlight_colour : current_theme.text_colour);
+    uint32_t held = stats.written < stats.capacity ? stats.written : stats.capacity;
+    snprintf(buff, size, "records %lu of %lu", (unsigned long)held, (unsigned long)stats.capacity);
+    put_line(w, buff, current_theme.text_colour);
+    snprintf(buff, size, "written %lu overwritten %lu", (unsigned long)stats.written,
+             (unsigned long)stats.overwritten);
+    put_line(w, buff, current_theme.text_colour);
+    snprintf(buff, size, "names %u", stats.names);
+    put_line(w, buff, current_theme.text_colour);
+
+    snprintf(buff, size, "sd %s uart %s", result_text(state->sd), result_text(state->uart));
+    put_line(w, buff, current_theme.text_colour);
+    put_line(w, "select: dump to " TRACE_FILE " and re-arm", current_theme.text_colour);
+}
+#endif
+
+static void trace_draw_tile(Page *self, int tx, int ty)
+{
+    TraceState *state = (TraceState *)self->state;
+    LineWriter w = {0};
+    tile_to_pixels(0, 0, &w.px, &w.py);
+
+    if (!state->mounted)
+    {
+        display_fill_rect(w.px, w.py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
+        state->mounted = true;
+        state->tick_due = true;
+    }
+
+    if (!state->tick_due)
+    {
+        return;
+    }
+    state->tick_due = false;
+
+#if defined(TRACE_ENABLED)
+    char buff[48];
+    draw_stats(&w, state, buff, sizeof(buff));
+#else
+    put_line(&w, "build with TRACE=1 to record", current_theme.text_colour);
+#endif
+
+    // clear what the previous refresh drew below the last line
+    if (w.line < MAX_LINES)
+    {
+        display_fill_rect(w.px, w.py + w.line * LINE_HEIGHT, TILE_WIDTH * TILE_COLS,
+                          (MAX_LINES - w.line) * LINE_HEIGHT, current_theme.bg_colour);
+    }
+}
+
+static void trace_handle_input(Page *self, int event_type)
+{
+    TraceState *state = (TraceState *)self->state;
+    if (event_type == INPUT_SELECT)
+    {
+#if defined(__arm__) && defined(USE_FREERTOS) && defined(TRACE_ENABLED)
+        state->sd = trace_save(TRACE_FILE) ? DUMP_OK : DUMP_FAILED;
+        state->uart = trace_send_uart() ? DUMP_OK : DUMP_FAILED;
+        // the dump leaves a triggered ring frozen, start a fresh capture
+        trace_set_enabled(true);
+#endif
+        state->mounted = false;
+        mark_tile_dirty(0, 0);
+    }
+}
+
+static void trace_destroy(Page *self)
+{
+    if (self)
+    {
+        TraceState *state = (TraceState *)self->state;
+        mem_free(state);
+        mem_free(self);
+    }
+}
+
+Page *trace_page_create()
+{
+    Page *page = mem_malloc(sizeof(Page));
+    TraceState *state = mem_malloc(sizeof(TraceState));
+    memset(state, 0, sizeof(TraceState));
+    state->mounted = false;
+
+    page->draw = NULL;
+    page->draw_tile = trace_draw_tile;
+    page->name = "trace";
+    page->handle_input = trace_handle_input;
+    page->reset = NULL;
+    page->destroy = trace_destroy;
+    page->state = state;
+    page->data_response = NULL;
+
+    ui_timer_start(page, TICK_TIME, TICK_TIME, trace_timer, page);
+
+    return page;
+}
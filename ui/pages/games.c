@@ -174,6 +174,7 @@ Page *games_page_create()
 
     page->draw = games_draw;
     page->draw_tile = games_draw_tile;
+    page->name = "games";
     page->handle_input = games_handle_input;
     page->reset = games_reset;
     page->destroy = games_destroy;
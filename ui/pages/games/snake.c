@@ -1,294 +1,190 @@
 #include "snake.h"
+#include "snake_game.h"
 #include "screen.h"
 #include "display.h"
 #include "tile.h"
 #include "input.h"
 #include "theme.h"
+#include "ui_timer.h"
+#include "sprite.h"
+#include "game_sprites.h"
+#include "memwrap.h"
 
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
 
-#define GRID_SIZE_X TILE_COLS
-#define GRID_SIZE_Y TILE_ROWS
-#define MAX_SNAKE GRID_SIZE_X *GRID_SIZE_Y
-
 #define TICK_TIME 500 // ms
 
 #define APPLE_COLOUR current_theme.accent_colour
 #define SNAKE_COLOUR current_theme.fg_colour
 
-typedef enum
-{
-    GAME_WIN,
-    GAME_OVER,
-    GAME_RUN,
-    GAME_NEW,
-} GameState;
-
-typedef enum
-{
-    UP,
-    DOWN,
-    LEFT,
-    RIGHT,
-} Direction;
+#define BANNER_SIZE 3
+#define BANNER_Y ((TILE_HEIGHT * TILE_ROWS) / 2)
+#define BANNER_FIRST_ROW ((BANNER_Y - NAVBAR_HEIGHT) / TILE_HEIGHT)
+#define BANNER_LAST_ROW ((BANNER_Y + 8 * BANNER_SIZE - 1 - NAVBAR_HEIGHT) / TILE_HEIGHT)
 
 typedef struct
 {
-    uint32_t last_tick;
-    GameState game_state;
-    int8_t snake_x[MAX_SNAKE]; // using last index as prev tail
-    int8_t snake_y[MAX_SNAKE];
-    uint8_t snake_len;
-    uint8_t apple_x;
-    uint8_t apple_y;
-    bool new_apple;
-    Direction d;
+    SnakeGame game;
+    SpriteInstance head;
 } SnakeState;
 
-/*
- * Runs a single game tick to do the following:
- *      - Move the snake in direction `currMove`
- *      - End game on self collision
- *      - Extend snake on collision with apple
- */
-void game_tick(SnakeState *state)
-{
-    if (state->game_state != GAME_RUN)
-    {
-        return;
-    }
-
-    // copy out old tail
-    state->snake_x[MAX_SNAKE - 1] = state->snake_x[state->snake_len - 1];
-    state->snake_y[MAX_SNAKE - 1] = state->snake_y[state->snake_len - 1];
+static SpriteCanvas canvas; // only touched from the display task
 
-    // advance snake body
-    for (int i = state->snake_len - 1; i > 0; i--)
+static const Sprite *head_sprite(SnakeDirection dir)
+{
+    switch (dir)
     {
-        state->snake_x[i] = state->snake_x[i - 1];
-        state->snake_y[i] = state->snake_y[i - 1];
+    case SNAKE_DOWN:
+        return &game_sprites[GAME_SPRITES_SNAKE_HEAD_DOWN];
+    case SNAKE_LEFT:
+        return &game_sprites[GAME_SPRITES_SNAKE_HEAD_LEFT];
+    case SNAKE_RIGHT:
+        return &game_sprites[GAME_SPRITES_SNAKE_HEAD_RIGHT];
+    case SNAKE_UP:
+    default:
+        return &game_sprites[GAME_SPRITES_SNAKE_HEAD_UP];
     }
+}
 
-    // advance head
-    switch (state->d)
-    {
-    case LEFT:
-        state->snake_x[0]--;
-        break;
-
-    case RIGHT:
-        state->snake_x[0]++;
-        break;
-
-    case UP:
-        state->snake_y[0]--;
-        break;
-
-    case DOWN:
-        state->snake_y[0]++;
-        break;
+// moving the head sprite marks its old tile, now plain body, and its new one
+static void place_head(SnakeState *state)
+{
+    int px, py;
+    SnakeCell head = snake_game_body(&state->game, 0);
+    tile_to_pixels(head.x, head.y, &px, &py);
+    sprite_place(&state->head, head_sprite(state->game.dir), px, py);
+}
 
-    default:
-        break;
-    }
+/*
+ * Every tile draws its own cell from the game state, so a step only has to
+ * mark the head, the vacated tail and a respawned apple dirty. The cell is
+ * composed off-screen and sent as one window.
+ */
+static void draw_board_cell(SnakeState *state, int tx, int ty)
+{
+    uint16_t colour = current_theme.bg_colour;
+    SnakeCell head = snake_game_body(&state->game, 0);
 
-    // check OOB
-    if (state->snake_x[0] < 0)
-    {
-        state->snake_x[0] = GRID_SIZE_X - 1;
-    }
-    else if (state->snake_x[0] >= GRID_SIZE_X)
-    {
-        state->snake_x[0] = 0;
-    }
-    else if (state->snake_y[0] < 0)
+    if (snake_game_occupied(&state->game, tx, ty) && !(head.x == tx && head.y == ty))
     {
-        state->snake_y[0] = GRID_SIZE_Y - 1;
+        colour = SNAKE_COLOUR;
     }
-    else if (state->snake_y[0] >= GRID_SIZE_Y)
+    else if (state->game.apple.x == tx && state->game.apple.y == ty)
     {
-        state->snake_y[0] = 0;
+        colour = APPLE_COLOUR;
     }
 
-    // check collision on snake
-    for (int i = 1; i < state->snake_len; i++)
+    sprite_canvas_begin_tile(&canvas, tx, ty, colour);
+    if (sprite_overlaps(&canvas, &state->head))
     {
-        if (state->snake_x[0] == state->snake_x[i] && state->snake_y[0] == state->snake_y[i])
-        {
-            state->game_state = GAME_OVER;
-            return;
-        }
+        sprite_blit_tinted(&canvas, state->head.sprite, state->head.x, state->head.y, SNAKE_COLOUR);
     }
+    display_draw_rgb565(canvas.x, canvas.y, canvas.width, canvas.height, canvas.pixels);
+}
 
-    // collision edge case for size 2
-    if (state->snake_len == 2 && state->snake_x[0] == state->snake_x[MAX_SNAKE - 1] && state->snake_y[0] == state->snake_y[MAX_SNAKE - 1])
-    {
-        state->game_state = GAME_OVER;
-        return;
-    }
+static void draw_banner(SnakeState *state)
+{
+    const char *title = state->game.status == SNAKE_WIN ? "GAME WIN" : "GAME OVER";
+    int text_width = strlen(title) * 6 * BANNER_SIZE;
+    uint16_t center_x = (TILE_WIDTH * TILE_COLS - text_width) / 2;
+    display_draw_string(center_x, BANNER_Y, title, current_theme.text_colour, current_theme.bg_colour, BANNER_SIZE);
+}
 
-    // check collision on apple and extend
-    if (state->snake_x[0] == state->apple_x && state->snake_y[0] == state->apple_y)
+static void mark_banner_dirty(void)
+{
+    for (int ty = BANNER_FIRST_ROW; ty <= BANNER_LAST_ROW; ty++)
     {
-        // extend
-        state->snake_x[state->snake_len] = state->snake_x[MAX_SNAKE - 1];
-        state->snake_y[state->snake_len] = state->snake_y[MAX_SNAKE - 1];
-        state->snake_len++;
-
-        // Check win
-        if (state->snake_len == MAX_SNAKE)
+        for (int tx = 0; tx < TILE_COLS; tx++)
         {
-            state->game_state = GAME_WIN;
+            mark_tile_dirty(tx, ty);
         }
-        else
-        {
-            state->new_apple = true;
-        }
-    }
-
-    // new apple
-    if (state->new_apple)
-    {
-        // new apple
-        bool safe_spawn;
-        do
-        {
-            safe_spawn = true; // Reset for each attempt
-            state->apple_x = (uint8_t)(rand() % GRID_SIZE_X);
-            state->apple_y = (uint8_t)(rand() % GRID_SIZE_Y);
-
-            for (uint8_t i = 0; i < state->snake_len; i++)
-            {
-                if (state->apple_x == state->snake_x[i] && state->apple_y == state->snake_y[i])
-                {
-                    safe_spawn = false;
-                    break;
-                }
-            }
-
-        } while (!safe_spawn);
     }
-
-    return;
 }
 
-/*
- * Init the game with a new grid
- */
-void init_game_snake(SnakeState *state)
+static void new_game(SnakeState *state)
 {
-    state->last_tick = HAL_GetTick();
-    state->game_state = GAME_RUN;
-    state->snake_len = 1;
-    state->snake_x[0] = GRID_SIZE_X / 2;
-    state->snake_y[0] = GRID_SIZE_Y / 2;
-    state->new_apple = true;
-    srand(state->last_tick);
-    int px, py;
-    tile_to_pixels(0, 0, &px, &py);
-    display_fill_rect(px, py, TILE_WIDTH * TILE_COLS, TILE_HEIGHT * TILE_ROWS, current_theme.bg_colour);
+    snake_game_init(&state->game, HAL_GetTick());
+    place_head(state);
+    mark_all_tiles_dirty();
 }
 
-static void snake_draw_tile(Page *self, int tx, int ty)
+/*
+ * Game timer, runs every TICK_TIME in the display task and only advances
+ * the game while the page is visible.
+ */
+static void snake_timer(void *arg)
 {
+    Page *self = (Page *)arg;
     SnakeState *state = (SnakeState *)self->state;
-    uint32_t curr_time = HAL_GetTick();
-    uint16_t x_draw, y_draw;
-    int px, py;
+    SnakeStep step;
 
-    // Init a new game and reset display
-    if (state->game_state == GAME_NEW)
+    if (state->game.status != SNAKE_RUN || screen_get_current_page() != self)
     {
-        init_game_snake(state);
+        return;
     }
 
-    // TODO: should probably confirm that this logic holds at tick reset
-    if ((curr_time - state->last_tick) > TICK_TIME)
+    if (snake_game_step(&state->game, &step) != SNAKE_RUN)
     {
-        game_tick(state);
-
-        // Clear tail
-        x_draw = (uint16_t)state->snake_x[MAX_SNAKE - 1];
-        y_draw = (uint16_t)state->snake_y[MAX_SNAKE - 1];
-        tile_to_pixels(x_draw, y_draw, &px, &py);
-        display_fill_rect(px, py, TILE_WIDTH, TILE_HEIGHT, current_theme.bg_colour);
+        mark_banner_dirty();
+    }
 
-        // Draw head
-        x_draw = (uint16_t)state->snake_x[0];
-        y_draw = (uint16_t)state->snake_y[0];
-        tile_to_pixels(x_draw, y_draw, &px, &py);
-        display_fill_rect(px, py, TILE_WIDTH, TILE_HEIGHT, SNAKE_COLOUR);
+    if (step.moved)
+    {
+        place_head(state);
+    }
+    if (step.tail_cleared)
+    {
+        mark_tile_dirty(step.tail.x, step.tail.y);
+    }
+    if (step.apple_moved)
+    {
+        mark_tile_dirty(step.apple.x, step.apple.y);
+    }
+}
 
-        // Draw Apple if req
-        if (state->new_apple)
-        {
-            x_draw = (uint16_t)state->apple_x;
-            y_draw = (uint16_t)state->apple_y;
-            tile_to_pixels(x_draw, y_draw, &px, &py);
-            display_fill_rect(px, py, TILE_WIDTH, TILE_HEIGHT, APPLE_COLOUR);
-            state->new_apple = false;
-        }
+static void snake_draw_tile(Page *self, int tx, int ty)
+{
+    SnakeState *state = (SnakeState *)self->state;
 
-        state->last_tick = curr_time;
+    draw_board_cell(state, tx, ty);
 
-        if (state->game_state == GAME_WIN)
-        {
-            char *title = "GAME WIN";
-            int text_width = strlen(title) * 6 * 3;
-            uint16_t center_x = (TILE_WIDTH * TILE_COLS - text_width) / 2;
-            uint16_t center_y = (TILE_HEIGHT * TILE_ROWS) / 2;
-            display_draw_string(center_x, center_y, title, current_theme.text_colour, current_theme.bg_colour, 3);
-        }
-        else if (state->game_state == GAME_OVER)
-        {
-            char *title = "GAME OVER";
-            int text_width = strlen(title) * 6 * 3;
-            uint16_t center_x = (TILE_WIDTH * TILE_COLS - text_width) / 2;
-            uint16_t center_y = (TILE_HEIGHT * TILE_ROWS) / 2;
-            display_draw_string(center_x, center_y, title, current_theme.text_colour, current_theme.bg_colour, 3);
-        }
+    // the banner spans these rows, drawing it after each of their cells keeps it on top
+    if (state->game.status != SNAKE_RUN && ty >= BANNER_FIRST_ROW && ty <= BANNER_LAST_ROW)
+    {
+        draw_banner(state);
     }
-
-    mark_all_tiles_dirty();
 }
 
 static void snake_handle_input(Page *self, int event_type)
 {
     SnakeState *state = (SnakeState *)self->state;
-    switch (state->game_state)
+    switch (state->game.status)
     {
-    case GAME_OVER:
+    case SNAKE_OVER:
+    case SNAKE_WIN:
         if (event_type == INPUT_DPAD_UP || event_type == INPUT_DPAD_DOWN ||
             event_type == INPUT_DPAD_LEFT || event_type == INPUT_DPAD_RIGHT ||
             event_type == INPUT_SELECT)
         {
-            state->game_state = GAME_NEW;
+            new_game(state);
         }
         break;
-    case GAME_WIN:
-        if (event_type == INPUT_DPAD_UP || event_type == INPUT_DPAD_DOWN ||
-            event_type == INPUT_DPAD_LEFT || event_type == INPUT_DPAD_RIGHT ||
-            event_type == INPUT_SELECT)
-        {
-            state->game_state = GAME_NEW;
-        }
-        break;
-    case GAME_RUN:
+    case SNAKE_RUN:
         switch (event_type)
         {
         case INPUT_DPAD_UP:
-            state->d = UP;
+            snake_game_turn(&state->game, SNAKE_UP);
             break;
         case INPUT_DPAD_DOWN:
-            state->d = DOWN;
+            snake_game_turn(&state->game, SNAKE_DOWN);
             break;
         case INPUT_DPAD_LEFT:
-            state->d = LEFT;
+            snake_game_turn(&state->game, SNAKE_LEFT);
             break;
         case INPUT_DPAD_RIGHT:
-            state->d = RIGHT;
+            snake_game_turn(&state->game, SNAKE_RIGHT);
             break;
         default:
             break;
@@ -304,25 +200,30 @@ static void snake_destroy(Page *self)
     if (self)
     {
         SnakeState *state = (SnakeState *)self->state;
-        free(state);
-        free(self);
+        mem_free(state);
+        mem_free(self);
     }
 }
 
 Page *snake_page_create()
 {
-    Page *page = malloc(sizeof(Page));
-    SnakeState *state = malloc(sizeof(SnakeState));
+    Page *page = mem_malloc(sizeof(Page));
+    SnakeState *state = mem_malloc(sizeof(SnakeState));
     memset(state, 0, sizeof(SnakeState));
 
-    init_game_snake(state);
+    snake_game_init(&state->game, HAL_GetTick());
+    place_head(state);
 
     page->draw = NULL;
     page->draw_tile = snake_draw_tile;
+    page->name = "snake";
     page->handle_input = snake_handle_input;
     page->reset = NULL;
     page->destroy = snake_destroy;
     page->state = state;
 
+    // cancelled by the screen when the page is popped
+    ui_timer_start(page, TICK_TIME, TICK_TIME, snake_timer, page);
+
     return page;
 }
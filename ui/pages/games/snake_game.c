@@ -0,0 +1,145 @@
+#include "snake_game.h"
+#include <stddef.h>
+#include <string.h>
+
+static uint32_t next_random(SnakeGame *game)
+{
+    // xorshift32, deterministic per seed so host tests can replay games
+    uint32_t x = game->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    game->rng = x;
+    return x;
+}
+
+static bool same_cell(SnakeCell a, SnakeCell b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+/*
+ * Pick the n-th free cell for a uniformly random n, so placement takes at
+ * most one pass over the board however full it is.
+ */
+static void spawn_apple(SnakeGame *game)
+{
+    uint16_t target = (uint16_t)(next_random(game) % (SNAKE_CELLS - game->len));
+    for (int y = 0; y < SNAKE_ROWS; y++)
+    {
+        for (int x = 0; x < SNAKE_COLS; x++)
+        {
+            if (game->occupied[y][x])
+                continue;
+            if (target-- == 0)
+            {
+                game->apple.x = (int8_t)x;
+                game->apple.y = (int8_t)y;
+                return;
+            }
+        }
+    }
+}
+
+void snake_game_init(SnakeGame *game, uint32_t seed)
+{
+    memset(game, 0, sizeof(SnakeGame));
+    game->rng = seed ? seed : 0x2545F491;
+    game->status = SNAKE_RUN;
+    game->dir = SNAKE_UP;
+    game->len = 1;
+    game->head = 0;
+    game->body[0].x = SNAKE_COLS / 2;
+    game->body[0].y = SNAKE_ROWS / 2;
+    game->occupied[game->body[0].y][game->body[0].x] = 1;
+    spawn_apple(game);
+}
+
+void snake_game_turn(SnakeGame *game, SnakeDirection dir)
+{
+    game->dir = dir;
+}
+
+SnakeStatus snake_game_step(SnakeGame *game, SnakeStep *step)
+{
+    SnakeStep local;
+    if (!step)
+        step = &local;
+    memset(step, 0, sizeof(SnakeStep));
+
+    if (game->status != SNAKE_RUN)
+        return game->status;
+
+    SnakeCell head = game->body[game->head];
+    SnakeCell tail = game->body[(game->head + game->len - 1) % SNAKE_CELLS];
+    SnakeCell next = head;
+
+    switch (game->dir)
+    {
+    case SNAKE_LEFT:
+        next.x = (int8_t)(head.x == 0 ? SNAKE_COLS - 1 : head.x - 1);
+        break;
+    case SNAKE_RIGHT:
+        next.x = (int8_t)(head.x == SNAKE_COLS - 1 ? 0 : head.x + 1);
+        break;
+    case SNAKE_UP:
+        next.y = (int8_t)(head.y == 0 ? SNAKE_ROWS - 1 : head.y - 1);
+        break;
+    case SNAKE_DOWN:
+        next.y = (int8_t)(head.y == SNAKE_ROWS - 1 ? 0 : head.y + 1);
+        break;
+    default:
+        break;
+    }
+
+    bool grow = same_cell(next, game->apple);
+
+    // the tail moves out of the way this step, except on a two cell reversal
+    if (game->occupied[next.y][next.x] && !(same_cell(next, tail) && game->len > 2))
+    {
+        game->status = SNAKE_OVER;
+        return game->status;
+    }
+
+    if (!grow)
+    {
+        game->occupied[tail.y][tail.x] = 0;
+        step->tail = tail;
+        step->tail_cleared = true;
+    }
+
+    game->head = (uint16_t)((game->head + SNAKE_CELLS - 1) % SNAKE_CELLS);
+    game->body[game->head] = next;
+    game->occupied[next.y][next.x] = 1;
+    step->head = next;
+    step->moved = true;
+
+    if (grow)
+    {
+        game->len++;
+        if (game->len == SNAKE_CELLS)
+        {
+            game->status = SNAKE_WIN;
+        }
+        else
+        {
+            spawn_apple(game);
+            step->apple = game->apple;
+            step->apple_moved = true;
+        }
+    }
+
+    return game->status;
+}
+
+bool snake_game_occupied(const SnakeGame *game, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= SNAKE_COLS || y >= SNAKE_ROWS)
+        return false;
+    return game->occupied[y][x] != 0;
+}
+
+SnakeCell snake_game_body(const SnakeGame *game, uint16_t index)
+{
+    return game->body[(game->head + index) % SNAKE_CELLS];
+}
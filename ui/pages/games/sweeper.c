@@ -1,10 +1,14 @@
-#include "snake.h"
+#include "sweeper.h"
+#include "sweeper_board.h"
 #include "screen.h"
 #include "display.h"
 #include "tile.h"
 #include "input.h"
 #include "cursor.h"
 #include "theme.h"
+#include "sprite.h"
+#include "game_sprites.h"
+#include "memwrap.h"
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -15,426 +19,179 @@
 
 #define MAX_MINES 12
 
-#define TICK_TIME 100 // ms - can be super low redrawing is handled manually
-
-// Values 0-8 used for mine proximity counts
-#define CELL_MINE 0x0A
-
 #define CURSOR_COLOUR current_theme.fg_colour
 #define CELL_BORDER_COLOR current_theme.accent_colour
 
-uint8_t mine_symbol[] = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x04,
-	0x00,0x10,0x41,0x00,0x9F,0x20,0x07,0xFC,0x00,0x7F,0xC0,0x0F,
-	0xFE,0x00,0xFF,0xE0,0x3F,0xFF,0x80,0xFF,0xE0,0x0F,0xFE,0x00,
-	0x7F,0xC0,0x07,0xFC,0x00,0x9F,0x20,0x10,0x41,0x00,0x04,0x00,
-	0x00,0x00,0x00,0x00,0x00};
-
-
-uint8_t flag_symbol[] = {0x00,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x3C,
-	0x00,0x03,0xF8,0x00,0x3F,0xE0,0x03,0xFF,0x00,0x3F,0xC0,0x03,
-	0xF0,0x00,0x38,0x00,0x02,0x00,0x00,0x20,0x00,0x02,0x00,0x00,
-	0x20,0x00,0x02,0x00,0x00,0x20,0x00,0x02,0x00,0x00,0x20,0x00,
-	0x00,0x00,0x00,0x00,0x00};
-
-typedef enum
-{
-    GAME_START,
-    GAME_ALIVE,
-    GAME_OVER,
-    GAME_WIN,
-} GameState;
-
-typedef struct
-{
-    uint8_t cell_val;
-    bool is_hidden;
-    bool has_flag;
-    bool redraw;
-} Cell;
+#define BANNER_SIZE 3
+#define BANNER_Y ((TILE_HEIGHT * TILE_ROWS) / 2)
+#define BANNER_FIRST_ROW ((BANNER_Y - NAVBAR_HEIGHT) / TILE_HEIGHT)
+#define BANNER_LAST_ROW ((BANNER_Y + 8 * BANNER_SIZE - 1 - NAVBAR_HEIGHT) / TILE_HEIGHT)
 
 typedef struct
 {
-    uint32_t last_tick;
     Cursor cursor;
-    int old_cursor_x;
-    int old_cursor_y;
-    Cell grid[GRID_SIZE_Y][GRID_SIZE_X];
-    uint8_t mine_count;
-    GameState game_state;
+    SpriteInstance cursor_sprite;
+    SweeperBoard board;
 } SweeperState;
 
+static SpriteCanvas canvas; // only touched from the display task
+
+// the cursor sprite marks the tiles it leaves and enters
+static void place_cursor(SweeperState *state)
+{
+    int px, py;
+    tile_to_pixels(state->cursor.x, state->cursor.y, &px, &py);
+    sprite_place(&state->cursor_sprite, &game_sprites[GAME_SPRITES_CURSOR], px, py);
+}
+
 /*
- * Initialise the board
+ * Initialise a new game, mines are placed by the first reveal
  */
-void board_reveal(SweeperState *state, uint8_t reveal_x, uint8_t reveal_y, bool sub_call)
+void init_game_sweeper(SweeperState *state)
 {
-    uint8_t nearbyFlags = 0;
-
-    // Reveal on flag is nothing
-    if (state->grid[reveal_y][reveal_x].has_flag == true)
-    {
-        return;
-    }
-
-    // Reveal mine game over
-    if (state->grid[reveal_y][reveal_x].cell_val == CELL_MINE)
-    {
-        state->grid[reveal_y][reveal_x].is_hidden = false;
-        state->game_state = GAME_OVER;
-        state->grid[reveal_y][reveal_x].redraw = true;
-        return;
-    }
-
-    // Reveal on empty revealed is nothing
-    if (state->grid[reveal_y][reveal_x].is_hidden == false &&
-        state->grid[reveal_y][reveal_x].cell_val == 0)
-    {
-        return;
-    }
-
-    // reveal on revealed square with val
-    if (state->grid[reveal_y][reveal_x].is_hidden == false && !sub_call)
-    {
-        // check flag count
-        for (uint8_t i = -1; i < 2; i++)
-        {
-            for (uint8_t j = -1; j < 2; j++)
-            {
-                // Skip OOB
-                if (reveal_y + j >= GRID_SIZE_Y || reveal_x + i >= GRID_SIZE_X ||
-                    reveal_y + j < 0 || reveal_x + i < 0)
-                {
-                    continue;
-                }
-                if (state->grid[reveal_y + j][reveal_x + i].has_flag)
-                {
-                    nearbyFlags++;
-                }
-            }
-        }
-
-        // call reveal on surrounds
-        // I think this logic may be dogy might need to check
-        if (nearbyFlags == state->grid[reveal_y][reveal_x].cell_val)
-        {
-            for (uint8_t i = -1; i < 2; i++)
-            {
-                for (uint8_t j = -1; j < 2; j++)
-                {
-                    // Skip OOB
-                    if (reveal_y + j >= GRID_SIZE_Y ||
-                        reveal_x + i >= GRID_SIZE_X || reveal_y + j < 0 ||
-                        reveal_x + i < 0)
-                    {
-                        continue;
-                    }
-                    board_reveal(state, i + reveal_x, j + reveal_y, true);
-                }
-            }
-        }
-
-        return;
-    }
+    sweeper_board_init(&state->board, GRID_SIZE_X, GRID_SIZE_Y, MAX_MINES);
 
-    // revealing 0 reveals all surrounding
-    if (state->grid[reveal_y][reveal_x].cell_val == 0)
-    {
-        state->grid[reveal_y][reveal_x].is_hidden = false;
-        state->grid[reveal_y][reveal_x].redraw = true;
-        for (uint8_t i = -1; i < 2; i++)
-        {
-            for (uint8_t j = -1; j < 2; j++)
-            {
-                // Skip OOB
-                if (reveal_y + j >= GRID_SIZE_Y || reveal_x + i >= GRID_SIZE_X ||
-                    reveal_y + j < 0 || reveal_x + i < 0)
-                {
-                    continue;
-                }
-                board_reveal(state, i + reveal_x, j + reveal_y, true);
-            }
-        }
-    }
-    else
-    { // Otherwise reveal plain num
-        state->grid[reveal_y][reveal_x].is_hidden = false;
-        state->grid[reveal_y][reveal_x].redraw = true;
-    }
-
-    // Check for win state
-    bool has_won = true;
-    for (uint8_t row = 0; row < GRID_SIZE_Y; row++)
-    {
-        for (uint8_t col = 0; col < GRID_SIZE_X; col++)
-        {
-            // mines should be flagged
-            if (state->grid[row][col].cell_val == CELL_MINE && !state->grid[row][col].has_flag)
-            {
-                has_won = false;
-                break;
-            }
-            // all other cells should be revealed
-            if (state->grid[row][col].cell_val != CELL_MINE && state->grid[row][col].is_hidden)
-            {
-                has_won = false;
-                break;
-            }
-        }
-        if (!has_won)
-            break;
-    }
+    // manual cursor init
+    state->cursor.max_x = GRID_SIZE_X - 1;
+    state->cursor.max_y = GRID_SIZE_Y - 1;
+    state->cursor.x = GRID_SIZE_X / 2;
+    state->cursor.y = GRID_SIZE_Y / 2;
+    state->cursor.selected = false;
+    place_cursor(state);
 
-    if (has_won)
-    {
-        state->game_state = GAME_WIN;
-    }
+    srand(HAL_GetTick());
 }
 
 /*
- * Initialise the board
+ * Hand cells changed by the board over to the tile flush, each tile then
+ * redraws only its own cell.
  */
-void board_init(SweeperState *state, uint8_t reveal_x, uint8_t reveal_y)
+static void mark_changed_cells(SweeperState *state)
 {
-    uint8_t mine_count = 0;
-    int attempts = 0;
-
-    // Add mines
-    while (mine_count < MAX_MINES && attempts < 1000)
-    {
-        uint8_t mine_x = rand() % GRID_SIZE_X;
-        uint8_t mine_y = rand() % GRID_SIZE_Y;
-        attempts++;
-        
-
-        // skip mines in 3x3 near first
-        if (mine_x >= reveal_x - 1 && mine_x <= reveal_x + 1 &&
-            mine_y >= reveal_y - 1 && mine_y <= reveal_y + 1)
-        {
-            continue;
-        }
-
-        if (state->grid[mine_y][mine_x].cell_val != CELL_MINE)
-        {
-            state->grid[mine_y][mine_x].cell_val = CELL_MINE;
-            mine_count++;
-        }
-    }
-
-    // Set non-mine values and hide
     for (uint8_t row = 0; row < GRID_SIZE_Y; row++)
     {
         for (uint8_t col = 0; col < GRID_SIZE_X; col++)
         {
-            if (state->grid[row][col].cell_val == CELL_MINE)
+            if (state->board.cells[row][col].redraw)
             {
-                continue;
-            }
-
-            // Calc Mines nearby
-            for (uint8_t i = -1; i < 2; i++)
-            {
-                for (uint8_t j = -1; j < 2; j++)
-                {
-                    // Skip OOB
-                    if (row + j >= GRID_SIZE_Y || col + i >= GRID_SIZE_X ||
-                        row + j < 0 || col + i < 0)
-                    {
-                        continue;
-                    }
-                    if (state->grid[row + j][col + i].cell_val == CELL_MINE)
-                    {
-                        state->grid[row][col].cell_val++;
-                    }
-                }
+                state->board.cells[row][col].redraw = false;
+                mark_tile_dirty(col, row);
             }
         }
     }
 }
 
-/*
- * Initialise snake in game
- */
-void init_game_sweeper(SweeperState *state)
+static void mark_banner_dirty(void)
 {
-
-    state->last_tick = HAL_GetTick();
-
-    state->game_state = GAME_START;
-
-    // manual cursor init
-    state->cursor.max_x = GRID_SIZE_X - 1;
-    state->cursor.max_y = GRID_SIZE_Y - 1;
-    state->cursor.x = GRID_SIZE_X / 2;
-    state->cursor.y = GRID_SIZE_Y / 2;
-    state->cursor.selected = false;
-
-    // hide board & reset
-    for (uint8_t row = 0; row < GRID_SIZE_Y; row++)
+    for (int ty = BANNER_FIRST_ROW; ty <= BANNER_LAST_ROW; ty++)
     {
-        for (uint8_t col = 0; col < GRID_SIZE_X; col++)
+        for (int tx = 0; tx < TILE_COLS; tx++)
         {
-            state->grid[row][col].is_hidden = true;
-            state->grid[row][col].has_flag = false;
-            state->grid[row][col].cell_val = 0;
-            state->grid[row][col].redraw = true;
+            mark_tile_dirty(tx, ty);
         }
     }
-
-    srand(state->last_tick);
 }
 
 void sweeper_handle_input(Page *self, int event_type)
 {
     SweeperState *state = self->state;
-    if (state->game_state == GAME_START && event_type == INPUT_SELECT)
-    {
-        // first reveal
-        board_init(state, state->cursor.x, state->cursor.y);
-        state->game_state = GAME_ALIVE;
-        board_reveal(state, state->cursor.x, state->cursor.y, false);
-    }
-    else if (state->game_state == GAME_OVER && event_type == INPUT_SELECT)
-    {
-        // new game
-        init_game_sweeper(state);
-    }
-    else if (state->game_state == GAME_WIN && event_type == INPUT_SELECT)
+    SweeperStatus before = state->board.status;
+    int old_x, old_y;
+
+    if ((before == SWEEPER_OVER || before == SWEEPER_WIN) && event_type == INPUT_SELECT)
     {
         // new game
         init_game_sweeper(state);
+        mark_all_tiles_dirty();
     }
     else if (event_type == INPUT_SELECT)
     {
-        board_reveal(state, state->cursor.x, state->cursor.y, false);
+        // the first reveal also places the mines
+        sweeper_board_reveal(&state->board, state->cursor.x, state->cursor.y);
     }
-    else if (event_type == INPUT_KEYPAD_2 && state->grid[state->cursor.y][state->cursor.x].is_hidden == true)
+    else if (event_type == INPUT_KEYPAD_2)
     {
         // TODO confirm keypad 2 is suitable
-        state->grid[state->cursor.y][state->cursor.x].has_flag = !state->grid[state->cursor.y][state->cursor.x].has_flag;
-    }
-    else if (event_type == INPUT_DPAD_LEFT)
-    {
-        cursor_move(&state->cursor, -1, 0, &state->old_cursor_x, &state->old_cursor_y);
-    }
-    else if (event_type == INPUT_DPAD_RIGHT)
-    {
-        cursor_move(&state->cursor, 1, 0, &state->old_cursor_x, &state->old_cursor_y);
+        sweeper_board_toggle_flag(&state->board, state->cursor.x, state->cursor.y);
     }
-    else if (event_type == INPUT_DPAD_UP)
+    else if (event_type == INPUT_DPAD_LEFT || event_type == INPUT_DPAD_RIGHT ||
+             event_type == INPUT_DPAD_UP || event_type == INPUT_DPAD_DOWN)
     {
-        cursor_move(&state->cursor, 0, 1, &state->old_cursor_x, &state->old_cursor_y);
+        int dx = (event_type == INPUT_DPAD_LEFT) ? -1 : (event_type == INPUT_DPAD_RIGHT) ? 1 : 0;
+        int dy = (event_type == INPUT_DPAD_UP) ? -1 : (event_type == INPUT_DPAD_DOWN) ? 1 : 0;
+        if (cursor_move(&state->cursor, dx, dy, &old_x, &old_y))
+        {
+            place_cursor(state);
+        }
     }
-    else if (event_type == INPUT_DPAD_DOWN)
+
+    mark_changed_cells(state);
+
+    if (before != state->board.status &&
+        (state->board.status == SWEEPER_OVER || state->board.status == SWEEPER_WIN))
     {
-        cursor_move(&state->cursor, 0, -1, &state->old_cursor_x, &state->old_cursor_y);
+        mark_banner_dirty();
     }
 }
 
-void draw_cell(Cell *cell, uint16_t x, uint16_t y)
+/*
+ * Compose a cell off-screen, flag, mine and cursor sprites included, and
+ * send it as one window. Digits are drawn on top afterwards.
+ */
+static void draw_cell(SweeperState *state, int tx, int ty)
 {
-    // Default cell border
-
+    SweeperCell *cell = &state->board.cells[ty][tx];
+    uint16_t fill = cell->hidden ? current_theme.bg_colour : current_theme.highlight_colour;
     int px, py;
-    tile_to_pixels(x, y, &px, &py);
-    display_draw_rect(px, py, TILE_WIDTH, 
-        TILE_HEIGHT, CELL_BORDER_COLOR);
 
-    // Draw flag
-    if (cell->has_flag)
+    tile_to_pixels(tx, ty, &px, &py);
+    sprite_canvas_begin_tile(&canvas, tx, ty, fill);
+    sprite_canvas_draw_rect(&canvas, px, py, TILE_WIDTH, TILE_HEIGHT, CELL_BORDER_COLOR);
+
+    if (cell->flag)
     {
-        display_draw_bits(px + 5, px + 5, flag_symbol, current_theme.text_colour, 
-            current_theme.bg_colour, 20, 20);
+        sprite_blit_tinted(&canvas, &game_sprites[GAME_SPRITES_FLAG], px + 5, py + 5, current_theme.text_colour);
     }
-    else if (!cell->is_hidden)
+    else if (!cell->hidden && cell->value == SWEEPER_MINE)
     {
-        // default reveal background
-        display_fill_rect(px + 1, py + 1,
-                          TILE_WIDTH - 2, TILE_HEIGHT - 2, current_theme.highlight_colour);
-        if (cell->cell_val == CELL_MINE)
-        {
-            display_draw_bits(x + 5, y + 5, mine_symbol, current_theme.text_colour, 
-                current_theme.highlight_colour,20, 20);
-        }
-        else if (cell->cell_val != 0)
-        {
-            // Val type reveal
-            display_draw_char(px + 10, py + 8,
-                              '0' + cell->cell_val, current_theme.text_colour,
-                              current_theme.highlight_colour, 2);
-        }
+        sprite_blit_tinted(&canvas, &game_sprites[GAME_SPRITES_MINE], px + 5, py + 5, current_theme.text_colour);
     }
-    else
+
+    if (sprite_overlaps(&canvas, &state->cursor_sprite))
     {
-        display_fill_rect(px + 1, py + 1,
-                          TILE_WIDTH - 2, TILE_HEIGHT - 2, current_theme.bg_colour);
+        sprite_blit_tinted(&canvas, state->cursor_sprite.sprite,
+                           state->cursor_sprite.x, state->cursor_sprite.y, CURSOR_COLOUR);
     }
-}
 
-void draw_cursor(uint16_t x, uint16_t y)
-{
-    int px, py;
-    tile_to_pixels(x, y, &px, &py);
-    display_draw_rect(px, py, TILE_WIDTH,
-                      TILE_HEIGHT, CURSOR_COLOUR);
-    display_draw_rect(px + 1, py + 1,
-                      TILE_WIDTH - 2, TILE_HEIGHT - 2, CURSOR_COLOUR);
+    display_draw_rgb565(canvas.x, canvas.y, canvas.width, canvas.height, canvas.pixels);
+
+    if (!cell->hidden && !cell->flag && cell->value != 0 && cell->value != SWEEPER_MINE)
+    {
+        // Val type reveal
+        display_draw_char(px + 10, py + 8,
+                          '0' + cell->value, current_theme.text_colour,
+                          current_theme.highlight_colour, 2);
+    }
 }
 
 static void sweeper_draw_tile(Page *self, int tx, int ty)
 {
     SweeperState *state = self->state;
-    uint32_t curr_time = HAL_GetTick();
 
-    if ((curr_time - state->last_tick) > TICK_TIME)
-    {
-        // Redraw all required grids
-        for (uint8_t row = 0; row < GRID_SIZE_Y; row++)
-        {
-            for (uint8_t col = 0; col < GRID_SIZE_X; col++)
-            {
-                if (state->grid[row][col].redraw)
-                {
-                    state->grid[row][col].redraw = false;
-                    draw_cell(&state->grid[row][col], col, row);
-                }
-            }
-        }
+    // tiles map one to one onto cells, only changed cells are marked dirty
+    state->board.cells[ty][tx].redraw = false;
+    draw_cell(state, tx, ty);
 
-        // redraw cursor and reset old location
-        if (state->old_cursor_x != state->cursor.x && 
-            state->old_cursor_y != state->cursor.y)
-        {
-            draw_cell(&state->grid[state->old_cursor_y][state->old_cursor_x], 
-                state->old_cursor_x, state->old_cursor_y);
-            state->old_cursor_x = state->cursor.x;
-            state->old_cursor_y = state->cursor.y;
-            draw_cursor(state->cursor.x, state->cursor.y);
-
-        }
-        state->last_tick = curr_time;
-    }
-
-    // check game state
-    if (state->game_state == GAME_WIN)
+    // the banner spans these rows, drawing it after each of their cells keeps it on top
+    if ((state->board.status == SWEEPER_WIN || state->board.status == SWEEPER_OVER) &&
+        ty >= BANNER_FIRST_ROW && ty <= BANNER_LAST_ROW)
     {
-        char *title = "GAME WIN";
-        int text_width = strlen(title) * 6 * 3;
+        char *title = state->board.status == SWEEPER_WIN ? "GAME WIN" : "GAME OVER";
+        int text_width = strlen(title) * 6 * BANNER_SIZE;
         uint16_t center_x = (TILE_WIDTH * TILE_COLS - text_width) / 2;
-        uint16_t center_y = (TILE_HEIGHT * TILE_ROWS) / 2;
-        display_draw_string(center_x, center_y, title, 
-            current_theme.text_colour, current_theme.bg_colour, 3);
+        display_draw_string(center_x, BANNER_Y, title, 
+            current_theme.text_colour, current_theme.bg_colour, BANNER_SIZE);
     }
-    else if (state->game_state == GAME_OVER)
-    {
-        char *title = "GAME OVER";
-        int text_width = strlen(title) * 6 * 3;
-        uint16_t center_x = (TILE_WIDTH * TILE_COLS - text_width) / 2;
-        uint16_t center_y = (TILE_HEIGHT * TILE_ROWS) / 2;
-        display_draw_string(center_x, center_y, title, 
-            current_theme.text_colour, current_theme.bg_colour, 3);
-    }
-
-    mark_all_tiles_dirty();
 }
 
 static void sweeper_destroy(Page *self)
@@ -442,21 +199,22 @@ static void sweeper_destroy(Page *self)
     if (self)
     {
         SweeperState *state = (SweeperState *)self->state;
-        free(state);
-        free(self);
+        mem_free(state);
+        mem_free(self);
     }
 }
 
 Page *sweeper_page_create()
 {
-    Page *page = malloc(sizeof(Page));
-    SweeperState *state = malloc(sizeof(SweeperState));
+    Page *page = mem_malloc(sizeof(Page));
+    SweeperState *state = mem_malloc(sizeof(SweeperState));
     memset(state, 0, sizeof(SweeperState));
 
     init_game_sweeper(state);
 
     page->draw = NULL;
     page->draw_tile = sweeper_draw_tile;
+    page->name = "sweeper";
     page->handle_input = sweeper_handle_input;
     page->reset = NULL;
     page->destroy = sweeper_destroy;
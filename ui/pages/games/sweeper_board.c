@@ -0,0 +1,246 @@
+#include "sweeper_board.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    uint16_t head;
+    uint16_t tail;
+} WorkList;
+
+static inline SweeperCell *cell_at(SweeperBoard *board, int x, int y)
+{
+    return &board->cells[y][x];
+}
+
+static inline bool in_bounds(const SweeperBoard *board, int x, int y)
+{
+    return x >= 0 && y >= 0 && x < board->cols && y < board->rows;
+}
+
+static void check_win(SweeperBoard *board)
+{
+    // mines flagged and every other cell revealed, tracked by counters instead of a board scan
+    if (board->status == SWEEPER_ALIVE && board->hidden_safe == 0 && board->flagged_mines == board->mines)
+        board->status = SWEEPER_WIN;
+}
+
+// uncover a safe cell, queueing it if it borders no mines
+static int uncover(SweeperBoard *board, WorkList *list, int x, int y)
+{
+    SweeperCell *cell = cell_at(board, x, y);
+    cell->hidden = false;
+    cell->redraw = true;
+    board->hidden_safe--;
+    if (cell->value == 0)
+    {
+        board->work[list->tail++] = (uint16_t)(y * board->cols + x);
+        uint16_t depth = (uint16_t)(list->tail - list->head);
+        if (depth > board->work_peak)
+            board->work_peak = depth;
+    }
+    return 1;
+}
+
+/*
+    Breadth-first flood fill from a safe hidden cell. A cell is uncovered as
+    it is queued, so it can never be queued twice and the list holds at most
+    one entry per cell. Flags stop the fill, as they do for a player.
+*/
+static int open_region(SweeperBoard *board, int x, int y)
+{
+    WorkList list = {0, 0};
+    int opened = uncover(board, &list, x, y);
+
+    while (list.head != list.tail)
+    {
+        uint16_t index = board->work[list.head++];
+        int cx = index % board->cols;
+        int cy = index / board->cols;
+
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                int nx = cx + dx;
+                int ny = cy + dy;
+                if (!in_bounds(board, nx, ny))
+                    continue;
+                SweeperCell *n = cell_at(board, nx, ny);
+                if (n->hidden && !n->flag)
+                    opened += uncover(board, &list, nx, ny);
+            }
+        }
+    }
+    return opened;
+}
+
+static void explode(SweeperBoard *board, int x, int y)
+{
+    SweeperCell *cell = cell_at(board, x, y);
+    cell->hidden = false;
+    cell->redraw = true;
+    board->status = SWEEPER_OVER;
+}
+
+// reveal the unflagged neighbours of a number once its flags account for every mine
+static int chord(SweeperBoard *board, int x, int y)
+{
+    int flags = 0;
+    int opened = 0;
+
+    for (int dy = -1; dy <= 1; dy++)
+        for (int dx = -1; dx <= 1; dx++)
+            if (in_bounds(board, x + dx, y + dy) && cell_at(board, x + dx, y + dy)->flag)
+                flags++;
+
+    if (flags != cell_at(board, x, y)->value)
+        return 0;
+
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            int nx = x + dx;
+            int ny = y + dy;
+            if (!in_bounds(board, nx, ny))
+                continue;
+            SweeperCell *n = cell_at(board, nx, ny);
+            if (!n->hidden || n->flag)
+                continue;
+            if (n->value == SWEEPER_MINE)
+            {
+                explode(board, nx, ny);
+                return opened;
+            }
+            opened += open_region(board, nx, ny);
+        }
+    }
+    return opened;
+}
+
+void sweeper_board_init(SweeperBoard *board, uint8_t cols, uint8_t rows, uint16_t mines)
+{
+    memset(board, 0, sizeof(SweeperBoard));
+    board->cols = cols > SWEEPER_MAX_COLS ? SWEEPER_MAX_COLS : cols;
+    board->rows = rows > SWEEPER_MAX_ROWS ? SWEEPER_MAX_ROWS : rows;
+    board->mines = mines;
+    board->hidden_safe = (uint16_t)(board->cols * board->rows);
+    board->status = SWEEPER_START;
+
+    for (int y = 0; y < board->rows; y++)
+    {
+        for (int x = 0; x < board->cols; x++)
+        {
+            board->cells[y][x].hidden = true;
+            board->cells[y][x].redraw = true;
+        }
+    }
+}
+
+void sweeper_board_place_mines(SweeperBoard *board, uint8_t safe_x, uint8_t safe_y)
+{
+    uint16_t candidates = 0;
+    board->flagged_mines = 0;
+
+    // every cell outside the 3x3 block around the first reveal may hold a mine
+    for (int y = 0; y < board->rows; y++)
+    {
+        for (int x = 0; x < board->cols; x++)
+        {
+            if (abs(x - safe_x) <= 1 && abs(y - safe_y) <= 1)
+                continue;
+            board->work[candidates++] = (uint16_t)(y * board->cols + x);
+        }
+    }
+
+    if (board->mines > candidates)
+        board->mines = candidates;
+
+    // partial Fisher-Yates shuffle, the first `mines` candidates become mines
+    for (uint16_t i = 0; i < board->mines; i++)
+    {
+        uint16_t j = (uint16_t)(i + (uint32_t)rand() % (candidates - i));
+        uint16_t index = board->work[j];
+        board->work[j] = board->work[i];
+        board->work[i] = index;
+        board->cells[index / board->cols][index % board->cols].value = SWEEPER_MINE;
+    }
+
+    for (int y = 0; y < board->rows; y++)
+    {
+        for (int x = 0; x < board->cols; x++)
+        {
+            if (board->cells[y][x].value == SWEEPER_MINE)
+            {
+                // flags can be placed before the first reveal
+                if (board->cells[y][x].flag)
+                    board->flagged_mines++;
+                continue;
+            }
+            uint8_t count = 0;
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    if (in_bounds(board, x + dx, y + dy) && board->cells[y + dy][x + dx].value == SWEEPER_MINE)
+                        count++;
+            board->cells[y][x].value = count;
+        }
+    }
+
+    board->hidden_safe = (uint16_t)(board->cols * board->rows - board->mines);
+    board->status = SWEEPER_ALIVE;
+}
+
+int sweeper_board_reveal(SweeperBoard *board, uint8_t x, uint8_t y)
+{
+    if (!in_bounds(board, x, y))
+        return 0;
+    if (board->status == SWEEPER_START)
+        sweeper_board_place_mines(board, x, y);
+    if (board->status != SWEEPER_ALIVE)
+        return 0;
+
+    SweeperCell *cell = cell_at(board, x, y);
+    int opened = 0;
+
+    if (cell->flag)
+        return 0;
+
+    if (cell->hidden)
+    {
+        if (cell->value == SWEEPER_MINE)
+        {
+            explode(board, x, y);
+            return 0;
+        }
+        opened = open_region(board, x, y);
+    }
+    else if (cell->value != 0)
+    {
+        opened = chord(board, x, y);
+    }
+
+    check_win(board);
+    return opened;
+}
+
+bool sweeper_board_toggle_flag(SweeperBoard *board, uint8_t x, uint8_t y)
+{
+    if (!in_bounds(board, x, y))
+        return false;
+    if (board->status != SWEEPER_START && board->status != SWEEPER_ALIVE)
+        return false;
+
+    SweeperCell *cell = cell_at(board, x, y);
+    if (!cell->hidden)
+        return false;
+
+    cell->flag = !cell->flag;
+    cell->redraw = true;
+    if (cell->value == SWEEPER_MINE)
+        board->flagged_mines = (uint16_t)(cell->flag ? board->flagged_mines + 1 : board->flagged_mines - 1);
+
+    check_win(board);
+    return true;
+}
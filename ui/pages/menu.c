@@ -3,6 +3,7 @@
 #include "display.h"
 #include "tile.h"
 #include "menu_row.h"
+#include "virtual_list.h"
 #include "cursor.h"
 #include "input.h"
 #include "phone.h"
@@ -19,12 +20,12 @@
 
 #define MENU_ITEMS_COUNT 9
 #define MENU_VISIBLE_COUNT 5
+#define MENU_PREFETCH 1
 
 typedef struct
 {
-    Cursor cursor;
-    const char *items[MENU_ITEMS_COUNT];
-    int page_offset;
+    VirtualList list;
+    bool ready;
 } MenuState;
 
 // forward declarations
@@ -34,108 +35,69 @@ static void menu_handle_input(Page *self, int event_type);
 static void menu_reset(Page *self);
 
 static bool theme_toggle = false;
+static const char *const menu_items[MENU_ITEMS_COUNT] = {
+    "Phone", "SMS", "Contacts", "Clock", "Calculator", "Calendar", "Games", "Debug", "Settings"};
+static VListArray menu_source = {.items = menu_items, .count = MENU_ITEMS_COUNT};
 // state is static since only one menu page exists
-static MenuState menu_state = {
-    .cursor = {0, 0, 0, MENU_ITEMS_COUNT - 1, false},
-    .items = {"Phone", "SMS", "Contacts", "Clock", "Calculator", "Calendar", "Games", "Debug", "Settings"},
-    .page_offset = 0};
+static MenuState menu_state = {.ready = false};
 // --- Draw functions ---
 static void menu_draw(Page *self) {}
 
-static void menu_draw_tile(Page *self, int tx, int ty)
+static void draw_menu_list_row(int tile_y, int selected, const char *text)
 {
-    int visible_row = ty / 2; // 0–4 on screen
-    int item_index = menu_state.page_offset + visible_row;
-
-    if (item_index < MENU_ITEMS_COUNT)
-    {
-        bool highlight = (menu_state.cursor.y == item_index);
-        draw_menu_row(visible_row * 2, highlight, menu_state.items[item_index]);
-    }
+    if (text[0] == '\0')
+        draw_empty_row(tile_y);
     else
-    {
-        draw_empty_row(visible_row * 2);
-    }
-
-    for (int i = 0; i < TILE_COLS; i++)
-    {
-        mark_tile_clean(i, visible_row * 2);
-        mark_tile_clean(i, visible_row * 2 + 1);
-    }
+        draw_menu_row(tile_y, selected, text);
 }
 
-static void mark_row_dirty(Page *self, int row)
+// false if the list geometry does not fit the row cache, the menu then stays blank
+static bool menu_ensure_list(void)
 {
-    int tile_y = row * 2;
-    for (int i = 0; i < TILE_COLS; i++)
-    {
-        mark_tile_dirty(i, tile_y);
-        mark_tile_dirty(i, tile_y + 1);
-    }
+    if (menu_state.ready)
+        return true;
+    VListSource source = {
+        .count = vlist_array_count,
+        .fetch = vlist_array_fetch,
+        .ctx = &menu_source};
+    menu_state.ready = vlist_init(&menu_state.list, &source, draw_menu_list_row, 0, 2, MENU_VISIBLE_COUNT, MENU_PREFETCH);
+    return menu_state.ready;
 }
 
-static void update_page_offset()
+static void menu_draw_tile(Page *self, int tx, int ty)
 {
-    // scroll down
-    if (menu_state.cursor.y >= menu_state.page_offset + MENU_VISIBLE_COUNT)
-    {
-        menu_state.page_offset = menu_state.cursor.y; // new page start
-        mark_all_tiles_dirty();
-    }
-    // scroll up
-    else if (menu_state.cursor.y < menu_state.page_offset)
-    {
-        menu_state.page_offset = 0; // back to first page
-        mark_all_tiles_dirty();
-    }
+    if (menu_ensure_list())
+        vlist_draw_tile(&menu_state.list, ty);
 }
 
 static void menu_handle_input(Page *self, int event_type)
 {
-    int old_x, old_y;
-    bool moved = false;
+    if (!menu_ensure_list())
+        return;
 
     // --- Movement ---
     switch (event_type)
     {
     case INPUT_DPAD_UP:
-        moved = cursor_move(&menu_state.cursor, 0, -1, &old_x, &old_y);
+        vlist_move(&menu_state.list, -1);
         break;
     case INPUT_DPAD_DOWN:
-        moved = cursor_move(&menu_state.cursor, 0, +1, &old_x, &old_y);
+        vlist_move(&menu_state.list, +1);
         break;
     case INPUT_DPAD_RIGHT: // jump to page 2 (items 5+)
-        if (menu_state.cursor.y < 5)
-            moved = cursor_move(&menu_state.cursor, 0, 5 - menu_state.cursor.y, &old_x, &old_y);
+        if (menu_state.list.selected < MENU_VISIBLE_COUNT)
+            vlist_select(&menu_state.list, MENU_VISIBLE_COUNT);
         break;
     case INPUT_DPAD_LEFT: // jump back to top
-        if (menu_state.cursor.y >= 5)
-            moved = cursor_move(&menu_state.cursor, 0, -menu_state.cursor.y, &old_x, &old_y);
-        break;
-    case INPUT_SELECT:
-        menu_state.cursor.selected = true;
+        if (menu_state.list.selected >= MENU_VISIBLE_COUNT)
+            vlist_select(&menu_state.list, 0);
         break;
     }
 
-    // --- Page / redraw updates ---
-    if (moved)
-    {
-        update_page_offset();
-
-        int old_row = old_y - menu_state.page_offset;
-        int new_row = menu_state.cursor.y - menu_state.page_offset;
-
-        if (old_row >= 0 && old_row < MENU_VISIBLE_COUNT)
-            mark_row_dirty(self, old_row);
-        if (new_row >= 0 && new_row < MENU_VISIBLE_COUNT)
-            mark_row_dirty(self, new_row);
-    }
-
     // --- Selection action ---
     if (event_type == INPUT_SELECT)
     {
-        menu_state.cursor.selected = false;
-        switch (menu_state.cursor.y)
+        switch (menu_state.list.selected)
         {
         case 0:
         {
@@ -200,6 +162,7 @@ static void menu_reset(Page *self)
 Page menu_page = {
     .draw = menu_draw,
     .draw_tile = menu_draw_tile,
+    .name = "menu",
     .handle_input = menu_handle_input,
     .reset = menu_reset,
     .destroy = NULL, // static singleton page
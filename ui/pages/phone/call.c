@@ -397,6 +397,7 @@ Page *call_page_create(const char *phone_number)
 
     page->draw = call_draw;
     page->draw_tile = call_draw_tile;
+    page->name = "call";
     page->handle_input = call_handle_input;
     page->reset = call_reset;
     page->destroy = call_destroy;
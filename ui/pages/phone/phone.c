@@ -180,6 +180,7 @@ Page *phone_page_create()
 
     page->draw = phone_draw;
     page->draw_tile = phone_draw_tile;
+    page->name = "phone";
     page->handle_input = phone_handle_input;
     page->reset = phone_reset;
     page->destroy = phone_destroy;
@@ -1,16 +1,28 @@
 #include "messages.h"
 #include "option_overlay.h"
 #include "memwrap.h"
+#include "font.h"
 
-// Helper function to draw wrapped text
+#define FONT_PATH "font.ufn"
+
+static FontContext font_ctx;
+
+// the card is mounted in the background after boot, so a failed open is tried again on the next draw
+static bool font_ensure_open(void)
+{
+    return font_ctx.file || font_open(&font_ctx, FONT_PATH);
+}
+
+// Helper function to draw wrapped text with the built-in font when no font file is present
 static void draw_wrapped_text(int start_x, int start_y, int max_width, const char *text, uint16_t colour, uint16_t bg_colour, uint8_t size)
 {
     int x = start_x;
     int y = start_y;
     int line_height = size * 8; // Approximate line height based on font size
     int char_width = size * 5;  // Reduced character width for tighter spacing
+    uint32_t cp;
 
-    while (*text)
+    while ((cp = font_utf8_next(&text)) != 0)
     {
         // Check if current character fits on current line
         if (x + char_width > start_x + max_width && x > start_x)
@@ -21,16 +33,12 @@ static void draw_wrapped_text(int start_x, int start_y, int max_width, const cha
         }
 
         // Skip spaces at the beginning of a line
-        if (*text == ' ' && x == start_x)
-        {
-            text++;
+        if (cp == ' ' && x == start_x)
             continue;
-        }
 
-        // Draw the character
-        display_draw_char(x, y, *text, colour, bg_colour, size);
+        // Draw the character, the 5x7 font only has ASCII
+        display_draw_char(x, y, cp < 128 ? (char)cp : '?', colour, bg_colour, size);
         x += char_width;
-        text++;
     }
 }
 
@@ -46,7 +54,10 @@ static void messages_page_draw(Page *self)
     // Draw sender info
     tile_to_pixels(0, 0, &px, &py);
     display_draw_string(px + 5, py + 10, "From:", current_theme.fg_colour, current_theme.bg_colour, 2);
-    display_draw_string(px + 65, py + 10, state->sender, current_theme.text_colour, current_theme.bg_colour, 2);
+    if (font_ensure_open())
+        font_draw_utf8(&font_ctx, px + 65, py + 8, state->sender, current_theme.text_colour, current_theme.bg_colour);
+    else
+        display_draw_string(px + 65, py + 10, state->sender, current_theme.text_colour, current_theme.bg_colour, 2);
 
     // Draw first horizontal separator
     tile_to_pixels(0, 1, &px, &py);
@@ -56,7 +67,17 @@ static void messages_page_draw(Page *self)
     int message_start_x = px + 15;
     int message_start_y = py + 15;
     int message_width = TILE_COLS * TILE_WIDTH - 30; // Leave margins
-    draw_wrapped_text(message_start_x, message_start_y, message_width, state->message, current_theme.text_colour, current_theme.bg_colour, 2);
+    if (font_ensure_open())
+    {
+        // down to the second separator
+        int lines = (7 * TILE_HEIGHT - 10) / font_ctx.height;
+        font_draw_wrapped(&font_ctx, message_start_x, message_start_y, message_width, lines, state->message,
+                          current_theme.text_colour, current_theme.bg_colour);
+    }
+    else
+    {
+        draw_wrapped_text(message_start_x, message_start_y, message_width, state->message, current_theme.text_colour, current_theme.bg_colour, 2);
+    }
 
     // Draw second horizontal separator
     tile_to_pixels(0, 8, &px, &py);
@@ -97,6 +118,7 @@ Page *messages_page_create(MessagePageState state)
 
     page->draw = messages_page_draw;
     page->draw_tile = NULL;
+    page->name = "messages";
     page->handle_input = messages_handle_input;
     page->reset = NULL;
     page->destroy = messages_destroy;
@@ -1,9 +1,11 @@
 #include "new_sms.h"
 #include "multitap.h"
+#include "t9.h"
 #include "bottom_bar.h"
 #include "option_overlay.h"
 #include "memwrap.h"
 #include "sms_types.h"
+#include "ui_timer.h"
 
 #define MAX_PHONE_NUMBER_LENGTH SMS_MAX_PHONE_LENGTH
 #define MAX_SMS_LENGTH SMS_MAX_MESSAGE_LENGTH
@@ -16,6 +18,9 @@
 #define TEXT_XPAD 5
 #define TEXT_YPAD 7
 #define PHONE_NUMBER_XPAD 10
+#define T9_DICT_PATH "t9.dict"
+#define CURSOR_BLINK_MS 500
+#define MULTITAP_TIMEOUT_MS 1000 // pending multi-tap character is accepted after this pause
 
 typedef enum
 {
@@ -30,8 +35,12 @@ typedef struct
     char sms_content[MAX_SMS_LENGTH + 1];
     InputMode mode;
     bool multitap_enabled; // Whether multi-tap is enabled for SMS input
+    bool t9_enabled;       // Whether T9 predictive input is enabled for SMS input
+    uint8_t t9_len;        // Length of the uncommitted T9 word at the end of the message
     bool mounted;
     bool overlay_open; // Track if overlay is currently open
+    bool cursor_on;           // blink phase, forced on by every key press
+    UiTimerId multitap_timer; // accepts the pending multi-tap character on timeout
 } NewSmsState;
 
 // Option overlay callback
@@ -79,9 +88,15 @@ static void remove_digit(Page *self);
 static void add_char(Page *self, char c);
 static void remove_char(Page *self);
 static void handle_keypad_input(Page *self, int event_type, char digit, char sms_char);
+static void handle_t9_input(Page *self, char digit);
 static void calculate_cursor_position(int content_len, int *cursor_x, int *cursor_y);
 static void handle_multitap_confirmation(Page *self);
 static void update_bottom_bar(NewSmsState *state);
+static void mark_cursor_dirty(NewSmsState *state);
+static void multitap_timeout(void *arg);
+
+// dictionary is opened once on first use and shared by all new SMS pages
+static T9Context t9_ctx;
 
 // ==================== Helper Functions ====================
 
@@ -108,14 +123,26 @@ static void handle_keypad_input(Page *self, int event_type, char digit, char sms
     }
     else
     {
-        // For SMS input, use multi-tap if enabled
-        if (state->multitap_enabled)
+        // For SMS input, use T9 or multi-tap if enabled
+        if (state->t9_enabled)
+        {
+            handle_t9_input(self, digit);
+        }
+        else if (state->multitap_enabled)
         {
             char output_char;
             if (multitap_handle_keypress(event_type, &output_char))
             {
                 add_char(self, output_char);
             }
+            // restart the timeout on every tap and show the new preview
+            ui_timer_cancel(state->multitap_timer);
+            state->multitap_timer = UI_TIMER_NONE;
+            if (multitap_is_active())
+            {
+                state->multitap_timer = ui_timer_start(self, MULTITAP_TIMEOUT_MS, 0, multitap_timeout, self);
+            }
+            mark_cursor_dirty(state);
         }
         else
         {
@@ -124,9 +151,56 @@ static void handle_keypad_input(Page *self, int event_type, char digit, char sms
     }
 }
 
+// the card is mounted in the background after boot, so a failed open is tried again next time
+static bool t9_ensure_open(void)
+{
+    return t9_ctx.file || t9_open(&t9_ctx, T9_DICT_PATH);
+}
+
+static void t9_show_word(Page *self, const char *word)
+{
+    NewSmsState *state = (NewSmsState *)self->state;
+    // replace the uncommitted word in place
+    for (; state->t9_len > 0; state->t9_len--)
+    {
+        remove_char(self);
+    }
+    for (const char *p = word ? word : ""; *p && strlen(state->sms_content) < MAX_SMS_LENGTH; p++)
+    {
+        add_char(self, *p);
+        state->t9_len++;
+    }
+}
+
+static void t9_commit(NewSmsState *state)
+{
+    t9_reset(&t9_ctx);
+    state->t9_len = 0;
+}
+
+static void handle_t9_input(Page *self, char digit)
+{
+    NewSmsState *state = (NewSmsState *)self->state;
+    if (digit >= '2' && digit <= '9')
+    {
+        // digits with no dictionary continuation are ignored
+        if (t9_push_digit(&t9_ctx, digit))
+        {
+            t9_show_word(self, t9_current(&t9_ctx));
+        }
+    }
+    else
+    {
+        t9_commit(state);
+        add_char(self, digit == '0' ? ' ' : '.');
+    }
+}
+
 static void handle_multitap_confirmation(Page *self)
 {
     NewSmsState *state = (NewSmsState *)self->state;
+    ui_timer_cancel(state->multitap_timer);
+    state->multitap_timer = UI_TIMER_NONE;
     if (state->mode == SMS_INPUT && state->multitap_enabled)
     {
         char output_char;
@@ -137,6 +211,34 @@ static void handle_multitap_confirmation(Page *self)
     }
 }
 
+static void mark_cursor_dirty(NewSmsState *state)
+{
+    if (state->mode == NUMBER_INPUT)
+        mark_tile_dirty(1, 1);
+    else
+        mark_tile_dirty(1, state->cursor.y + 3);
+}
+
+static void cursor_blink(void *arg)
+{
+    Page *self = (Page *)arg;
+    NewSmsState *state = (NewSmsState *)self->state;
+    if (screen_get_current_page() != self)
+        return;
+    state->cursor_on = !state->cursor_on;
+    mark_cursor_dirty(state);
+}
+
+static void multitap_timeout(void *arg)
+{
+    Page *self = (Page *)arg;
+    NewSmsState *state = (NewSmsState *)self->state;
+    state->multitap_timer = UI_TIMER_NONE;
+    // leave the character pending while an overlay covers the page
+    if (screen_get_current_page() == self)
+        handle_multitap_confirmation(self);
+}
+
 static void update_bottom_bar(NewSmsState *state)
 {
     int accent_index = state->overlay_open ? 1 : 0;
@@ -201,7 +303,8 @@ static void draw_number(NewSmsState *state, int tx, int ty)
     tile_to_pixels(1, 1, &px, &py);
     display_draw_string(px + PHONE_NUMBER_XPAD, py + TEXT_YPAD, state->phone_number, current_theme.text_colour, current_theme.fg_colour, PHONE_CHAR_SCALE);
     int cursor_x = px + PHONE_NUMBER_XPAD + (strlen(state->phone_number) * PHONE_CHAR_DISPLAY_WIDTH);
-    display_fill_rect(cursor_x, py + TEXT_YPAD, 5, TILE_HEIGHT - 8 - TEXT_YPAD, current_theme.text_colour);
+    uint16_t cursor_colour = (state->mode == NUMBER_INPUT && state->cursor_on) ? current_theme.text_colour : current_theme.fg_colour;
+    display_fill_rect(cursor_x, py + TEXT_YPAD, 5, TILE_HEIGHT - 8 - TEXT_YPAD, cursor_colour);
 }
 
 static void draw_phone_number_area(Page *self, int tx, int ty)
@@ -334,8 +437,9 @@ static void draw_sms_content_area(Page *self, int tx, int ty)
             int cursor_x = px + TEXT_XPAD + (state->cursor.x * CHAR_DISPLAY_WIDTH);
             int cursor_y = py + TEXT_YPAD;
 
-            // Draw cursor
-            display_fill_rect(cursor_x, cursor_y, 5, TILE_HEIGHT - 8 - TEXT_YPAD, current_theme.text_colour);
+            // Draw cursor, or clear it in the off phase of the blink
+            display_fill_rect(cursor_x, cursor_y, 5, TILE_HEIGHT - 8 - TEXT_YPAD,
+                              state->cursor_on ? current_theme.text_colour : current_theme.bg_colour);
 
             // Draw multi-tap preview if active
             if (state->multitap_enabled && multitap_is_active())
@@ -383,6 +487,13 @@ static void new_sms_handle_input(Page *self, int event_type)
 {
     NewSmsState *state = (NewSmsState *)self->state;
 
+    // keep the cursor solid while typing
+    if (!state->cursor_on)
+    {
+        state->cursor_on = true;
+        mark_cursor_dirty(state);
+    }
+
     // Check if overlay was closed (any input other than overlay opening means overlay is closed)
     if (state->overlay_open && event_type != INPUT_LEFT)
     {
@@ -422,16 +533,35 @@ static void new_sms_handle_input(Page *self, int event_type)
         handle_keypad_input(self, event_type, '9', 'w');
         break;
     case INPUT_KEYPAD_STAR:
-        // Toggle multi-tap mode
+        // Cycle input mode: multi-tap -> T9 (if a dictionary is present) -> direct
         if (state->mode == SMS_INPUT)
         {
-            state->multitap_enabled = !state->multitap_enabled;
+            if (state->multitap_enabled)
+            {
+                state->multitap_enabled = false;
+                state->t9_enabled = t9_ensure_open();
+            }
+            else if (state->t9_enabled)
+            {
+                state->t9_enabled = false;
+            }
+            else
+            {
+                state->multitap_enabled = true;
+            }
+            t9_commit(state);
             multitap_reset(); // Reset any pending multi-tap
+            ui_timer_cancel(state->multitap_timer);
+            state->multitap_timer = UI_TIMER_NONE;
         }
         break;
     case INPUT_KEYPAD_HASH:
-        // Confirm current multi-tap character if active
-        if (state->mode == SMS_INPUT && state->multitap_enabled)
+        // Cycle T9 candidates, or confirm current multi-tap character if active
+        if (state->mode == SMS_INPUT && state->t9_enabled && state->t9_len > 0)
+        {
+            t9_show_word(self, t9_next_candidate(&t9_ctx));
+        }
+        else if (state->mode == SMS_INPUT && state->multitap_enabled)
         {
             handle_multitap_confirmation(self);
         }
@@ -439,6 +569,8 @@ static void new_sms_handle_input(Page *self, int event_type)
     case INPUT_DPAD_LEFT:
         if (state->mode == NUMBER_INPUT)
             remove_digit(self);
+        else if (state->t9_enabled && state->t9_len > 0 && t9_pop_digit(&t9_ctx))
+            t9_show_word(self, t9_current(&t9_ctx));
         else
             remove_char(self);
         break;
@@ -447,6 +579,7 @@ static void new_sms_handle_input(Page *self, int event_type)
     case INPUT_DPAD_UP:
         if (state->mode == SMS_INPUT)
         {
+            t9_commit(state);
             clear_old_cursor(state);
             state->mode = NUMBER_INPUT;
             state->cursor.x = strlen(state->phone_number);
@@ -496,7 +629,11 @@ static void new_sms_reset(Page *self)
         memset(state->sms_content, 0, sizeof(state->sms_content));
         state->mode = NUMBER_INPUT;
         state->multitap_enabled = true; // Enable multi-tap by default
+        state->t9_enabled = false;
+        state->t9_len = 0;
         multitap_reset();
+        ui_timer_cancel(state->multitap_timer);
+        state->multitap_timer = UI_TIMER_NONE;
         state->mounted = false;
         state->overlay_open = false;
     }
@@ -531,11 +668,16 @@ Page *new_sms_page_create(const char *phone_number)
     state->cursor = (Cursor){cursor_x, 0, 0, MAX_PHONE_NUMBER_LENGTH - 1, false};
     state->mode = NUMBER_INPUT;
     state->multitap_enabled = true; // Enable multi-tap by default
+    state->t9_enabled = false;
+    state->t9_len = 0;
     state->mounted = false;
     state->overlay_open = false;
+    state->cursor_on = true;
+    state->multitap_timer = UI_TIMER_NONE;
 
     page->draw = new_sms_draw;
     page->draw_tile = new_sms_draw_tile;
+    page->name = "new_sms";
     page->handle_input = new_sms_handle_input;
     page->reset = new_sms_reset;
     page->destroy = new_sms_destroy;
@@ -544,5 +686,8 @@ Page *new_sms_page_create(const char *phone_number)
     // Initialize multi-tap system
     multitap_init();
 
+    // cancelled with the page's other timers when it is popped
+    ui_timer_start(page, CURSOR_BLINK_MS, CURSOR_BLINK_MS, cursor_blink, page);
+
     return page;
 }
\ No newline at end of file
@@ -173,6 +173,7 @@ Page *sms_page_create()
 
     page->draw = sms_draw;
     page->draw_tile = sms_draw_tile;
+    page->name = "sms";
     page->handle_input = sms_handle_input;
     page->reset = sms_reset;
     page->destroy = sms_destroy;
@@ -1,12 +1,19 @@
 #include "screen.h"
 #include "tile.h"
 #include "status_bar.h"
+#include "frame_stats.h"
+#include "ui_timer.h"
+#include "LCD_Controller.h"
+#include "memwrap.h"
+#include "trace.h"
+#include "profile.h"
 #include <stdlib.h>
 #include <stdbool.h>
 
 #define MAX_PAGE_STACK 10
 
 static Page *page_stack[MAX_PAGE_STACK];
+static uint32_t page_marks[MAX_PAGE_STACK]; // allocation mark of each pushed page
 static int page_top = -1;
 static Page *current_page = NULL;
 
@@ -31,6 +38,11 @@ void screen_init(Page *initial_page)
     }
 }
 
+Page *screen_get_current_page(void)
+{
+    return current_page;
+}
+
 /**
  * Push a new page onto the stack.
  */
@@ -40,6 +52,8 @@ void screen_push_page(Page *new_page)
     {
 
         page_stack[++page_top] = current_page;
+        // the page was allocated just before the push, its own blocks count
+        page_marks[page_top] = mem_track_seq_of(new_page);
 
         current_page = new_page;
 
@@ -58,10 +72,15 @@ void screen_pop_page(void)
 {
     if (page_top >= 0)
     {
-        // Free current page if dynamic
+        // Timers must not outlive the page state they point at
+        ui_timer_cancel_owner(current_page);
+
+        // Free current page if dynamic, then look for blocks it left behind
+        const char *name = current_page ? current_page->name : NULL;
         if (current_page && current_page->destroy)
         {
             current_page->destroy(current_page);
+            mem_track_check_page(page_marks[page_top], name);
         }
 
         // Restore the previous page from the stack
@@ -80,6 +99,8 @@ void screen_pop_page(void)
  */
 void screen_set_page(Page *new_page)
 {
+    ui_timer_cancel_owner(current_page);
+
     // Free current page if dynamic
     if (current_page && current_page->destroy)
     {
@@ -161,7 +182,18 @@ void screen_tick(void)
     // check response buffer and call screen handle data response
     if (current_page->draw_tile)
     {
-        flush_dirty_tiles(current_page);
+        uint32_t start = frame_stats_now();
+        uint32_t start_bytes = lcd_get_tx_bytes();
+        TRACE_BEGIN(TRACE_DISPLAY_FLUSH, 0, 0);
+        PROFILE_ZONE_BEGIN(PROFILE_DISPLAY_FLUSH);
+        int tiles = flush_dirty_tiles(current_page);
+        PROFILE_ZONE_END(PROFILE_DISPLAY_FLUSH);
+        uint32_t bytes = lcd_get_tx_bytes() - start_bytes;
+        TRACE_END(TRACE_DISPLAY_FLUSH, tiles, bytes);
+        frame_stats_record(current_page,
+                           frame_stats_elapsed_us(start),
+                           (uint32_t)tiles,
+                           bytes);
     }
     status_bar_tick();
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "sprite.h"
+#include <stddef.h>
+
+typedef struct
+{
+    int x0, y0, x1, y1; // half-open
+} Clip;
+
+// intersect a screen rectangle with the canvas, false if nothing is left
+static bool clip_to_canvas(const SpriteCanvas *canvas, int x, int y, int width, int height, Clip *out)
+{
+    out->x0 = x > canvas->x ? x : canvas->x;
+    out->y0 = y > canvas->y ? y : canvas->y;
+    out->x1 = (x + width) < (canvas->x + canvas->width) ? (x + width) : (canvas->x + canvas->width);
+    out->y1 = (y + height) < (canvas->y + canvas->height) ? (y + height) : (canvas->y + canvas->height);
+    return out->x0 < out->x1 && out->y0 < out->y1;
+}
+
+void sprite_canvas_begin(SpriteCanvas *canvas, int x, int y, int width, int height, uint16_t bg_colour)
+{
+    if (width < 0)
+        width = 0;
+    if (width > SPRITE_CANVAS_PIXELS)
+        width = SPRITE_CANVAS_PIXELS;
+    if (height < 0)
+        height = 0;
+    if (width && height > SPRITE_CANVAS_PIXELS / width)
+        height = SPRITE_CANVAS_PIXELS / width;
+
+    canvas->x = (int16_t)x;
+    canvas->y = (int16_t)y;
+    canvas->width = (uint16_t)width;
+    canvas->height = (uint16_t)height;
+
+    uint16_t *p = canvas->pixels;
+    for (int i = width * height; i > 0; i--)
+        *p++ = bg_colour;
+}
+
+void sprite_canvas_begin_tile(SpriteCanvas *canvas, int tx, int ty, uint16_t bg_colour)
+{
+    int px, py;
+    tile_to_pixels(tx, ty, &px, &py);
+    sprite_canvas_begin(canvas, px, py, TILE_WIDTH, TILE_HEIGHT, bg_colour);
+}
+
+void sprite_canvas_fill_rect(SpriteCanvas *canvas, int x, int y, int width, int height, uint16_t colour)
+{
+    Clip c;
+    if (!clip_to_canvas(canvas, x, y, width, height, &c))
+        return;
+
+    for (int row = c.y0; row < c.y1; row++)
+    {
+        uint16_t *dst = &canvas->pixels[(row - canvas->y) * canvas->width + (c.x0 - canvas->x)];
+        for (int col = c.x0; col < c.x1; col++)
+            *dst++ = colour;
+    }
+}
+
+void sprite_canvas_draw_rect(SpriteCanvas *canvas, int x, int y, int width, int height, uint16_t colour)
+{
+    sprite_canvas_fill_rect(canvas, x, y, width, 1, colour);
+    sprite_canvas_fill_rect(canvas, x, y + height - 1, width, 1, colour);
+    sprite_canvas_fill_rect(canvas, x, y, 1, height, colour);
+    sprite_canvas_fill_rect(canvas, x + width - 1, y, 1, height, colour);
+}
+
+/*
+    Shared row walker for both blit modes. Only the clipped part of the
+    sprite is visited, so a sprite spread over four tiles costs one sprite's
+    worth of work in total.
+*/
+static void blit(SpriteCanvas *canvas, const Sprite *sprite, int x, int y, bool tint, uint16_t colour)
+{
+    Clip c;
+    if (!sprite || !clip_to_canvas(canvas, x, y, sprite->width, sprite->height, &c))
+        return;
+
+    for (int row = c.y0; row < c.y1; row++)
+    {
+        const uint16_t *src = &sprite->pixels[(row - y) * sprite->width + (c.x0 - x)];
+        uint16_t *dst = &canvas->pixels[(row - canvas->y) * canvas->width + (c.x0 - canvas->x)];
+        for (int col = c.x0; col < c.x1; col++, src++, dst++)
+        {
+            if (*src != SPRITE_KEY)
+                *dst = tint ? colour : *src;
+        }
+    }
+}
+
+void sprite_blit(SpriteCanvas *canvas, const Sprite *sprite, int x, int y)
+{
+    blit(canvas, sprite, x, y, false, 0);
+}
+
+void sprite_blit_tinted(SpriteCanvas *canvas, const Sprite *sprite, int x, int y, uint16_t colour)
+{
+    blit(canvas, sprite, x, y, true, colour);
+}
+
+bool sprite_overlaps(const SpriteCanvas *canvas, const SpriteInstance *instance)
+{
+    Clip c;
+    if (!instance->sprite)
+        return false;
+    return clip_to_canvas(canvas, instance->x, instance->y, instance->sprite->width, instance->sprite->height, &c);
+}
+
+void sprite_mark_rect(int x, int y, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    // floor division so rectangles partly above the tile area still map correctly
+    int tx0 = x >= 0 ? x / TILE_WIDTH : -((-x + TILE_WIDTH - 1) / TILE_WIDTH);
+    int ty0 = (y - NAVBAR_HEIGHT) >= 0 ? (y - NAVBAR_HEIGHT) / TILE_HEIGHT
+                                       : -((NAVBAR_HEIGHT - y + TILE_HEIGHT - 1) / TILE_HEIGHT);
+    int tx1 = (x + width - 1) >= 0 ? (x + width - 1) / TILE_WIDTH : -1;
+    int ty1 = (y + height - 1 - NAVBAR_HEIGHT) >= 0 ? (y + height - 1 - NAVBAR_HEIGHT) / TILE_HEIGHT : -1;
+
+    if (tx0 < 0)
+        tx0 = 0;
+    if (ty0 < 0)
+        ty0 = 0;
+    if (tx1 >= TILE_COLS)
+        tx1 = TILE_COLS - 1;
+    if (ty1 >= TILE_ROWS)
+        ty1 = TILE_ROWS - 1;
+
+    for (int ty = ty0; ty <= ty1; ty++)
+        for (int tx = tx0; tx <= tx1; tx++)
+            mark_tile_dirty(tx, ty);
+}
+
+void sprite_place(SpriteInstance *instance, const Sprite *sprite, int x, int y)
+{
+    if (instance->sprite == sprite && instance->x == x && instance->y == y)
+        return;
+
+    // old rectangle first so the tiles it leaves are repainted without it
+    if (instance->sprite)
+        sprite_mark_rect(instance->x, instance->y, instance->sprite->width, instance->sprite->height);
+
+    instance->sprite = sprite;
+    instance->x = (int16_t)x;
+    instance->y = (int16_t)y;
+
+    if (sprite)
+        sprite_mark_rect(x, y, sprite->width, sprite->height);
+}
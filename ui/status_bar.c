@@ -1,131 +1,235 @@
 #include "status_bar.h"
+#include "LCD_Controller.h"
+#include "ui_timer.h"
+#include <stdio.h>
+
+#define VOLUME_SHOW_MS 2000
+
+typedef struct
+{
+    uint16_t x, y, w, h;
+} FieldRegion;
+
+// field regions, indexed by STATUS_FIELD_* bit number
+static const FieldRegion field_regions[] = {
+    {10, 5, 60, 16},  // time
+    {90, 5, 60, 16},  // volume
+    {156, 9, 14, 8},  // headphones
+    {180, 5, 30, 16}, // signal
+    {210, 6, 30, 16}, // battery
+};
 
 typedef struct
 {
     bool mounted;
     RTC_TimeTypeDef last_time;
-    uint8_t last_signal_strength;
-    uint8_t last_battery_level;
+    bool time_valid;
+    uint8_t signal_strength;
+    uint8_t battery_level;
+    bool headphones;
 
     bool volume_indicator_visible;
     uint8_t current_volume;
-    uint32_t volume_show_start_time;
-    uint32_t volume_show_duration_ms;
+    UiTimerId volume_timer;
+
+    StatusBarStats stats;
 } StatusBarState;
 
 static StatusBarState status_state = {0};
 
+// written from the RTC alarm interrupt, so kept outside status_state
+static volatile uint32_t pending_fields = STATUS_FIELD_ALL;
+
+static void (*wake_hook)(void *arg) = NULL;
+static void *wake_arg = NULL;
+
+void status_bar_invalidate(uint32_t fields)
+{
+    __atomic_fetch_or(&pending_fields, fields, __ATOMIC_RELAXED);
+}
+
+void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc)
+{
+    status_state.stats.minute_ticks++;
+    status_bar_invalidate(STATUS_FIELD_TIME);
+    if (wake_hook)
+        wake_hook(wake_arg);
+}
+
+void status_bar_set_wake_hook(void (*hook)(void *arg), void *arg)
+{
+    wake_arg = arg;
+    wake_hook = hook;
+}
+
+void status_bar_start_clock(void)
+{
+    // fire at second 0 of every minute
+    RTC_AlarmTypeDef alarm = {0};
+    alarm.AlarmTime.Seconds = 0;
+    alarm.AlarmMask = RTC_ALARMMASK_DATEWEEKDAY | RTC_ALARMMASK_HOURS | RTC_ALARMMASK_MINUTES;
+    alarm.AlarmSubSecondMask = RTC_ALARMSUBSECONDMASK_ALL;
+    alarm.AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_DATE;
+    alarm.AlarmDateWeekDay = 1;
+    alarm.Alarm = RTC_ALARM_A;
+    HAL_RTC_SetAlarm_IT(&hrtc, &alarm, RTC_FORMAT_BIN);
+
+    // FreeRTOS-safe priority, same as the other EXTI sources
+    HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
+}
+
 void draw_status_bar(void)
 {
     if (!status_state.mounted)
     {
         display_fill_rect(0, 0, 240, 25, current_theme.fg_colour);
         status_state.mounted = true;
-        status_state.volume_show_duration_ms = 2000;
+        status_bar_invalidate(STATUS_FIELD_ALL);
     }
 }
 
-static void update_time_display(void)
+static void clear_field(int field)
 {
-    if (!status_state.mounted)
-        return;
-
-    // read both registers to avoid locking out the date register
-    RTC_DateTypeDef sDate;
-    RTC_TimeTypeDef sTime;
-    HAL_RTC_GetDate(&hrtc, &sDate, RTC_FORMAT_BIN);
-    HAL_RTC_GetTime(&hrtc, &sTime, RTC_FORMAT_BIN);
-
-    if (sTime.Hours != status_state.last_time.Hours ||
-        sTime.Minutes != status_state.last_time.Minutes)
-    {
-
-        char time_buffer[16];
-        sprintf(time_buffer, "%02d:%02d", sTime.Hours, sTime.Minutes);
-        display_draw_string(10, 5, time_buffer, current_theme.bg_colour, current_theme.fg_colour, 2);
-
-        status_state.last_time = sTime;
-    }
+    const FieldRegion *r = &field_regions[field];
+    display_fill_rect(r->x, r->y, r->w, r->h, current_theme.fg_colour);
 }
 
-static void update_volume_indicator(void)
+static void draw_time(void)
 {
-    if (!status_state.mounted || !status_state.volume_indicator_visible)
-        return;
+    // the time register must be read before the date register to unlock the shadow registers
+    RTC_TimeTypeDef sTime;
+    RTC_DateTypeDef sDate;
+    HAL_RTC_GetTime(&hrtc, &sTime, RTC_FORMAT_BIN);
+    HAL_RTC_GetDate(&hrtc, &sDate, RTC_FORMAT_BIN);
+    status_state.stats.rtc_reads++;
 
-    uint32_t current_time = HAL_GetTick();
-    if (current_time - status_state.volume_show_start_time >= status_state.volume_show_duration_ms)
-    {
-        display_fill_rect(90, 5, 60, 16, current_theme.fg_colour);
-        status_state.volume_indicator_visible = false;
+    if (status_state.time_valid &&
+        sTime.Hours == status_state.last_time.Hours &&
+        sTime.Minutes == status_state.last_time.Minutes)
         return;
-    }
 
-    // Only redraw if volume changed (this function is called every tick)
-    static uint8_t last_drawn_volume = 0;
-    if (status_state.current_volume != last_drawn_volume)
-    {
-        char volume_buffer[16];
-        sprintf(volume_buffer, "%d%%", status_state.current_volume);
-        int text_width = strlen(volume_buffer) * 6;
-        int center_x = (240 - text_width) / 2;
-        int center_y = (25 - 8) / 2;
-        display_fill_rect(90, 5, 60, 16, current_theme.fg_colour);
-        display_draw_string(center_x, center_y, volume_buffer, current_theme.bg_colour, current_theme.fg_colour, 1);
-        last_drawn_volume = status_state.current_volume;
-    }
+    char time_buffer[16];
+    snprintf(time_buffer, sizeof(time_buffer), "%02d:%02d", sTime.Hours, sTime.Minutes);
+    display_draw_string(field_regions[0].x, field_regions[0].y, time_buffer, current_theme.bg_colour, current_theme.fg_colour, 2);
+    status_state.last_time = sTime;
+    status_state.time_valid = true;
 }
 
-void status_bar_show_volume(uint8_t volume)
+static void draw_volume(void)
 {
-    if (!status_state.mounted)
+    clear_field(1);
+    if (!status_state.volume_indicator_visible)
         return;
 
-    status_state.current_volume = volume;
-    status_state.volume_indicator_visible = true;
-    status_state.volume_show_start_time = HAL_GetTick();
-
     char volume_buffer[16];
-    sprintf(volume_buffer, "%d%%", volume);
+    snprintf(volume_buffer, sizeof(volume_buffer), "%d%%", status_state.current_volume);
     int text_width = strlen(volume_buffer) * 6;
     int center_x = (240 - text_width) / 2;
     int center_y = (25 - 8) / 2;
     display_draw_string(center_x, center_y, volume_buffer, current_theme.bg_colour, current_theme.fg_colour, 1);
 }
 
-void status_bar_tick(void)
+static void draw_headphones(void)
 {
-    update_time_display();
-    update_volume_indicator();
+    clear_field(2);
+    if (status_state.headphones)
+        display_draw_string(field_regions[2].x + 1, field_regions[2].y, "HP", current_theme.bg_colour, current_theme.fg_colour, 1);
 }
 
-void status_bar_update_signal(uint8_t strength)
+static void draw_signal(void)
 {
+    clear_field(3);
+    display_draw_signal_bars(field_regions[3].x, field_regions[3].y, status_state.signal_strength, current_theme.bg_colour, current_theme.fg_colour);
+}
 
-    if (strength != status_state.last_signal_strength)
-    {
-        display_fill_rect(180, 5, 30, 16, current_theme.fg_colour);
+static void draw_battery(void)
+{
+    clear_field(4);
+    display_draw_battery_icon(field_regions[4].x, field_regions[4].y, status_state.battery_level, current_theme.bg_colour, current_theme.fg_colour);
+}
 
-        display_draw_signal_bars(180, 5, strength, current_theme.bg_colour, current_theme.fg_colour);
+static void (*const field_drawers[])(void) = {
+    draw_time,
+    draw_volume,
+    draw_headphones,
+    draw_signal,
+    draw_battery,
+};
 
-        status_state.last_signal_strength = strength;
+void status_bar_tick(void)
+{
+    if (!status_state.mounted)
+        return;
+
+    uint32_t fields = __atomic_exchange_n(&pending_fields, 0, __ATOMIC_RELAXED);
+    if (!fields)
+        return;
+
+    uint32_t start_bytes = lcd_get_tx_bytes();
+    for (int i = 0; i < (int)(sizeof(field_drawers) / sizeof(field_drawers[0])); i++)
+    {
+        if (fields & (1U << i))
+        {
+            field_drawers[i]();
+            status_state.stats.redraws++;
+        }
     }
+    status_state.stats.redraw_bytes += lcd_get_tx_bytes() - start_bytes;
 }
 
-void status_bar_update_battery(uint8_t level)
+static void hide_volume(void *arg)
 {
+    status_state.volume_indicator_visible = false;
+    status_state.volume_timer = UI_TIMER_NONE;
+    status_bar_invalidate(STATUS_FIELD_VOLUME);
+}
 
-    if (level != status_state.last_battery_level)
+void status_bar_show_volume(uint8_t volume)
+{
+    status_state.current_volume = volume;
+    status_state.volume_indicator_visible = true;
+    // each press restarts the timeout; owned by no page so it survives navigation
+    ui_timer_cancel(status_state.volume_timer);
+    status_state.volume_timer = ui_timer_start(NULL, VOLUME_SHOW_MS, 0, hide_volume, NULL);
+    status_bar_invalidate(STATUS_FIELD_VOLUME);
+}
+
+void status_bar_update_signal(uint8_t strength)
+{
+    if (strength != status_state.signal_strength)
     {
-        display_fill_rect(210, 6, 30, 16, current_theme.fg_colour);
+        status_state.signal_strength = strength;
+        status_bar_invalidate(STATUS_FIELD_SIGNAL);
+    }
+}
 
-        display_draw_battery_icon(210, 6, level, current_theme.bg_colour, current_theme.fg_colour);
+void status_bar_update_battery(uint8_t level)
+{
+    if (level != status_state.battery_level)
+    {
+        status_state.battery_level = level;
+        status_bar_invalidate(STATUS_FIELD_BATTERY);
+    }
+}
 
-        status_state.last_battery_level = level;
+void status_bar_update_headphones(bool connected)
+{
+    if (connected != status_state.headphones)
+    {
+        status_state.headphones = connected;
+        status_bar_invalidate(STATUS_FIELD_HEADPHONES);
     }
 }
 
+void status_bar_get_stats(StatusBarStats *stats)
+{
+    *stats = status_state.stats;
+}
+
 void status_bar_reset(void)
 {
+    ui_timer_cancel(status_state.volume_timer);
     memset(&status_state, 0, sizeof(status_state));
-}
\ No newline at end of file
+    status_bar_invalidate(STATUS_FIELD_ALL);
+}
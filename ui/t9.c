@@ -0,0 +1,274 @@
+#include "t9.h"
+#include <string.h>
+
+#if defined(__arm__) || defined(HOST_SIM)
+#include "fatfs.h"
+#include "mem_sections.h"
+static FIL t9_file DMA_BUFFER;
+#else
+#include <stdio.h>
+#endif
+
+#define HEADER_SIZE 20
+#define NODE_FIXED_SIZE 3
+#define CHILD_OFFSET_SIZE 3
+#define HAS_HINT 0x80
+// largest node record up to the end of its first T9_MAX_CANDIDATES words
+#define NODE_READ_MAX \
+    (NODE_FIXED_SIZE + (T9_MAX_DEPTH + 1) / 2 + 7 * CHILD_OFFSET_SIZE + (1 + T9_MAX_CANDIDATES) * T9_LETTER_BYTES)
+
+static const char key_letters[8][5] = {"abc", "def", "ghi", "jkl", "mno", "pqrs", "tuv", "wxyz"};
+
+// reads up to len bytes, returns the number read (short only at end of file)
+static uint32_t file_read_upto(T9Context *ctx, uint32_t offset, void *buf, uint32_t len)
+{
+    ctx->reads++;
+#if defined(__arm__) || defined(HOST_SIM)
+    UINT got = 0;
+    if (f_lseek((FIL *)ctx->file, offset) != FR_OK)
+        return 0;
+    if (f_read((FIL *)ctx->file, buf, len, &got) != FR_OK)
+        return 0;
+    return got;
+#else
+    FILE *f = (FILE *)ctx->file;
+    if (fseek(f, (long)offset, SEEK_SET) != 0)
+        return 0;
+    return (uint32_t)fread(buf, 1, len, f);
+#endif
+}
+
+static bool file_read(T9Context *ctx, uint32_t offset, void *buf, uint32_t len)
+{
+    return file_read_upto(ctx, offset, buf, len) == len;
+}
+
+static uint32_t read_u24(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static uint32_t read_u32(const uint8_t *p)
+{
+    return read_u24(p) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t popcount8(uint8_t v)
+{
+    uint8_t n = 0;
+    while (v)
+    {
+        v &= v - 1;
+        n++;
+    }
+    return n;
+}
+
+// entry is the depth reached by the digit that selected this node, the folded label adds the rest
+static const T9Node *load_node(T9Context *ctx, uint32_t offset, uint8_t entry)
+{
+    T9Node *slot = &ctx->cache[offset % T9_CACHE_NODES];
+    if (slot->offset == offset)
+    {
+        ctx->cache_hits++;
+        return slot;
+    }
+    ctx->cache_misses++;
+    slot->offset = T9_NONE;
+
+    // the record and the words shown as candidates in one read
+    uint8_t buf[NODE_READ_MAX];
+    uint32_t got = file_read_upto(ctx, offset, buf, sizeof(buf));
+    if (got < NODE_FIXED_SIZE)
+        return NULL;
+
+    uint8_t children = popcount8(buf[0]);
+    uint8_t word_count = buf[1] & ~HAS_HINT;
+    bool has_hint = buf[1] & HAS_HINT;
+    uint8_t label_len = buf[2];
+    if (entry + label_len > T9_MAX_DEPTH)
+        return NULL;
+    uint8_t letter_bytes = (uint8_t)((entry + label_len + 3) / 4);
+    uint8_t shown = word_count < T9_MAX_CANDIDATES ? word_count : T9_MAX_CANDIDATES;
+    uint32_t label_bytes = (label_len + 1) / 2;
+    uint32_t offsets_at = NODE_FIXED_SIZE + label_bytes;
+    uint32_t hint_at = offsets_at + (children ? children - 1 : 0) * CHILD_OFFSET_SIZE;
+    uint32_t words_at = hint_at + (has_hint ? letter_bytes : 0);
+    uint32_t end = words_at + word_count * letter_bytes;
+    if (got < words_at + shown * letter_bytes)
+        return NULL;
+
+    slot->child_mask = buf[0];
+    slot->word_count = word_count;
+    slot->depth = entry + label_len;
+    slot->label_len = label_len;
+    memcpy(slot->label, &buf[NODE_FIXED_SIZE], label_bytes);
+    // the first child is written straight after this record
+    for (int i = 0; i < children; i++)
+        slot->children[i] = i == 0 ? offset + end : read_u24(&buf[offsets_at + (i - 1) * CHILD_OFFSET_SIZE]);
+    slot->has_hint = has_hint;
+    if (has_hint)
+        memcpy(slot->hint, &buf[hint_at], letter_bytes);
+    for (int i = 0; i < shown; i++)
+        memcpy(slot->words[i], &buf[words_at + i * letter_bytes], letter_bytes);
+    slot->offset = offset;
+    return slot;
+}
+
+static char label_digit(const T9Node *node, uint8_t index)
+{
+    uint8_t packed = node->label[index / 2];
+    return (char)('0' + (index & 1 ? packed >> 4 : packed & 0x0F));
+}
+
+// each letter is its position on the key typed for it
+static void decode_word(const T9Context *ctx, const uint8_t *letters, uint8_t len, char *out)
+{
+    for (int i = 0; i < len; i++)
+    {
+        uint8_t position = (letters[i / 4] >> (2 * (i % 4))) & 0x03;
+        out[i] = key_letters[ctx->digits[i] - '2'][position];
+    }
+    out[len] = '\0';
+}
+
+static void load_candidates(T9Context *ctx)
+{
+    ctx->candidate_count = 0;
+    ctx->candidate_index = 0;
+    ctx->completion = false;
+    if (ctx->depth == 0)
+        return;
+
+    const T9Node *node = load_node(ctx, ctx->path[ctx->depth], ctx->entry[ctx->depth]);
+    if (!node)
+        return;
+
+    if (ctx->depth == node->depth && node->word_count > 0)
+    {
+        uint8_t count = node->word_count < T9_MAX_CANDIDATES ? node->word_count : T9_MAX_CANDIDATES;
+        for (int i = 0; i < count; i++)
+            decode_word(ctx, node->words[i], ctx->depth, ctx->candidates[i]);
+        ctx->candidate_count = count;
+    }
+    else if (node->has_hint || node->word_count > 0)
+    {
+        // no complete word yet: show the start of the most likely completion
+        decode_word(ctx, node->has_hint ? node->hint : node->words[0], ctx->depth, ctx->candidates[0]);
+        ctx->candidate_count = 1;
+        ctx->completion = true;
+    }
+}
+
+bool t9_open(T9Context *ctx, const char *path)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    for (int i = 0; i < T9_CACHE_NODES; i++)
+        ctx->cache[i].offset = T9_NONE;
+
+#if defined(__arm__) || defined(HOST_SIM)
+    if (f_open(&t9_file, path, FA_READ) != FR_OK)
+        return false;
+    ctx->file = &t9_file;
+#else
+    ctx->file = fopen(path, "rb");
+    if (!ctx->file)
+        return false;
+#endif
+
+    uint8_t header[HEADER_SIZE];
+    if (!file_read(ctx, 0, header, sizeof(header)) || memcmp(header, "T9D2", 4) != 0)
+    {
+        t9_close(ctx);
+        return false;
+    }
+    ctx->root = read_u32(&header[12]);
+    t9_reset(ctx);
+    return true;
+}
+
+void t9_close(T9Context *ctx)
+{
+    if (!ctx->file)
+        return;
+#if defined(__arm__) || defined(HOST_SIM)
+    f_close((FIL *)ctx->file);
+#else
+    fclose((FILE *)ctx->file);
+#endif
+    ctx->file = NULL;
+}
+
+void t9_reset(T9Context *ctx)
+{
+    ctx->depth = 0;
+    ctx->digits[0] = '\0';
+    ctx->path[0] = ctx->root;
+    ctx->entry[0] = 0;
+    ctx->candidate_count = 0;
+    ctx->candidate_index = 0;
+    ctx->completion = false;
+}
+
+bool t9_push_digit(T9Context *ctx, char digit)
+{
+    if (!ctx->file || digit < '2' || digit > '9' || ctx->depth >= T9_MAX_DEPTH)
+        return false;
+
+    uint8_t depth = ctx->depth;
+    const T9Node *node = load_node(ctx, ctx->path[depth], ctx->entry[depth]);
+    if (!node)
+        return false;
+
+    if (depth < node->depth)
+    {
+        // inside a folded chain, only its next digit continues a word
+        if (label_digit(node, depth - ctx->entry[depth]) != digit)
+            return false;
+        ctx->path[depth + 1] = ctx->path[depth];
+        ctx->entry[depth + 1] = ctx->entry[depth];
+    }
+    else
+    {
+        uint8_t bit = 1U << (digit - '2');
+        if (!(node->child_mask & bit))
+            return false;
+        uint32_t child = node->children[popcount8(node->child_mask & (bit - 1))];
+        if (!load_node(ctx, child, depth + 1))
+            return false;
+        ctx->path[depth + 1] = child;
+        ctx->entry[depth + 1] = depth + 1;
+    }
+
+    ctx->depth++;
+    ctx->digits[ctx->depth - 1] = digit;
+    ctx->digits[ctx->depth] = '\0';
+    load_candidates(ctx);
+    return true;
+}
+
+bool t9_pop_digit(T9Context *ctx)
+{
+    if (ctx->depth == 0)
+        return false;
+    ctx->depth--;
+    ctx->digits[ctx->depth] = '\0';
+    // path nodes are usually still cached, so this is cheap
+    load_candidates(ctx);
+    return true;
+}
+
+const char *t9_current(const T9Context *ctx)
+{
+    if (ctx->candidate_count == 0)
+        return NULL;
+    return ctx->candidates[ctx->candidate_index];
+}
+
+const char *t9_next_candidate(T9Context *ctx)
+{
+    if (ctx->candidate_count == 0)
+        return NULL;
+    ctx->candidate_index = (ctx->candidate_index + 1) % ctx->candidate_count;
+    return ctx->candidates[ctx->candidate_index];
+}
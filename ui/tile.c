@@ -24,15 +24,29 @@ void mark_all_tiles_dirty(void) {
     }
 }
 
-void flush_dirty_tiles(Page* page) {
+bool any_tiles_dirty(void) {
+    for (int y = 0; y < TILE_ROWS; y++) {
+        for (int x = 0; x < TILE_COLS; x++) {
+            if (dirty[y][x]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int flush_dirty_tiles(Page* page) {
+    int drawn = 0;
     for (int y = 0; y < TILE_ROWS; y++) {
         for (int x = 0; x < TILE_COLS; x++) {
             if (dirty[y][x]) {
                 if (page && page->draw_tile) {
                     page->draw_tile(page, x, y);
+                    drawn++;
                 }
                 dirty[y][x] = false;
             }
         }
     }
+    return drawn;
 }
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include "ui_timer.h"
+#include <stddef.h>
+#include <string.h>
+
+#if UI_TIMER_POOL_SIZE > 0xFFFE
+#error "UI_TIMER_POOL_SIZE must fit a 16-bit pool index"
+#endif
+
+#define SLOT_MASK (UI_TIMER_SLOTS - 1)
+#define NIL 0xFFFF
+#define BUCKET_COUNT (UI_TIMER_LEVELS * UI_TIMER_SLOTS)
+
+typedef struct
+{
+    uint32_t expires;
+    uint32_t period;
+    UiTimerCallback callback;
+    void *arg;
+    const void *owner;
+    uint16_t prev;   // bucket list links, next doubles as the free list link
+    uint16_t next;
+    uint16_t bucket; // level * UI_TIMER_SLOTS + slot while armed
+    uint16_t generation;
+    bool armed;
+} UiTimer;
+
+static UiTimer timers[UI_TIMER_POOL_SIZE];
+static uint16_t buckets[BUCKET_COUNT];      // head of each slot list
+static uint64_t occupied[UI_TIMER_LEVELS];  // bit n set while slot n of the level is non-empty
+static uint16_t free_head;
+static uint32_t clk;  // next tick to process
+static uint32_t base; // tick new timers are measured from
+static UiTimerStats stats;
+
+static inline uint32_t ctz64(uint64_t x)
+{
+    return (uint32_t)__builtin_ctzll(x);
+}
+
+static inline uint64_t rotr64(uint64_t x, uint32_t r)
+{
+    r &= 63;
+    return r ? (x >> r) | (x << (64 - r)) : x;
+}
+
+// pick the level whose span covers the remaining time, relative to clk
+static uint16_t bucket_for(uint32_t expires)
+{
+    uint32_t delta = expires - clk;
+    if ((int32_t)delta < 0)
+        return (uint16_t)(clk & SLOT_MASK); // overdue: next tick processed
+
+    int level = 0;
+    while (level < UI_TIMER_LEVELS - 1 && delta >= (1UL << ((level + 1) * UI_TIMER_SLOT_BITS)))
+        level++;
+    uint32_t slot = (expires >> (level * UI_TIMER_SLOT_BITS)) & SLOT_MASK;
+    return (uint16_t)(level * UI_TIMER_SLOTS + slot);
+}
+
+static void link_timer(uint16_t index)
+{
+    UiTimer *t = &timers[index];
+    uint16_t bucket = bucket_for(t->expires);
+    t->bucket = bucket;
+    t->prev = NIL;
+    t->next = buckets[bucket];
+    if (t->next != NIL)
+        timers[t->next].prev = index;
+    buckets[bucket] = index;
+    occupied[bucket / UI_TIMER_SLOTS] |= 1ULL << (bucket & SLOT_MASK);
+}
+
+static void unlink_timer(uint16_t index)
+{
+    UiTimer *t = &timers[index];
+    if (t->prev != NIL)
+        timers[t->prev].next = t->next;
+    else
+        buckets[t->bucket] = t->next;
+    if (t->next != NIL)
+        timers[t->next].prev = t->prev;
+    if (buckets[t->bucket] == NIL)
+        occupied[t->bucket / UI_TIMER_SLOTS] &= ~(1ULL << (t->bucket & SLOT_MASK));
+}
+
+static void release_timer(uint16_t index)
+{
+    UiTimer *t = &timers[index];
+    t->armed = false;
+    t->generation++;
+    t->next = free_head;
+    free_head = index;
+    stats.active--;
+}
+
+static UiTimer *lookup(UiTimerId id)
+{
+    uint32_t index = (id & 0xFFFF) - 1;
+    if (id == UI_TIMER_NONE || index >= UI_TIMER_POOL_SIZE)
+        return NULL;
+    UiTimer *t = &timers[index];
+    if (!t->armed || t->generation != (uint16_t)(id >> 16))
+        return NULL;
+    return t;
+}
+
+void ui_timer_init(uint32_t now_ms)
+{
+    memset(timers, 0, sizeof(timers));
+    memset(occupied, 0, sizeof(occupied));
+    memset(&stats, 0, sizeof(stats));
+    for (int i = 0; i < (int)BUCKET_COUNT; i++)
+        buckets[i] = NIL;
+    for (int i = 0; i < UI_TIMER_POOL_SIZE; i++)
+        timers[i].next = (i + 1 < UI_TIMER_POOL_SIZE) ? (uint16_t)(i + 1) : NIL;
+    free_head = 0;
+    base = now_ms;
+    clk = now_ms + 1;
+}
+
+UiTimerId ui_timer_start(const void *owner, uint32_t delay_ms, uint32_t period_ms,
+                         UiTimerCallback callback, void *arg)
+{
+    if (!callback)
+        return UI_TIMER_NONE;
+    if (free_head == NIL)
+    {
+        stats.exhausted++;
+        return UI_TIMER_NONE;
+    }
+
+    uint16_t index = free_head;
+    UiTimer *t = &timers[index];
+    free_head = t->next;
+
+    if (delay_ms == 0)
+        delay_ms = 1;
+    if (delay_ms > UI_TIMER_MAX_DELAY_MS)
+        delay_ms = UI_TIMER_MAX_DELAY_MS;
+    if (period_ms > UI_TIMER_MAX_DELAY_MS)
+        period_ms = UI_TIMER_MAX_DELAY_MS;
+
+    t->expires = base + delay_ms;
+    t->period = period_ms;
+    t->callback = callback;
+    t->arg = arg;
+    t->owner = owner;
+    t->armed = true;
+    link_timer(index);
+
+    stats.started++;
+    if (++stats.active > stats.high_water)
+        stats.high_water = stats.active;
+    return ((uint32_t)t->generation << 16) | (uint32_t)(index + 1);
+}
+
+bool ui_timer_cancel(UiTimerId id)
+{
+    UiTimer *t = lookup(id);
+    if (!t)
+        return false;
+    uint16_t index = (uint16_t)(t - timers);
+    unlink_timer(index);
+    release_timer(index);
+    return true;
+}
+
+bool ui_timer_pending(UiTimerId id)
+{
+    return lookup(id) != NULL;
+}
+
+int ui_timer_cancel_owner(const void *owner)
+{
+    if (!owner)
+        return 0;
+    int cancelled = 0;
+    for (uint16_t i = 0; i < UI_TIMER_POOL_SIZE; i++)
+    {
+        if (timers[i].armed && timers[i].owner == owner)
+        {
+            unlink_timer(i);
+            release_timer(i);
+            cancelled++;
+        }
+    }
+    return cancelled;
+}
+
+// move every timer in a coarse slot down to the level that now covers it
+static void cascade(int level, uint32_t slot)
+{
+    uint16_t bucket = (uint16_t)(level * UI_TIMER_SLOTS + slot);
+    while (buckets[bucket] != NIL)
+    {
+        uint16_t index = buckets[bucket];
+        unlink_timer(index);
+        link_timer(index);
+        stats.cascaded++;
+    }
+}
+
+/*
+    Slots are emptied from the head one timer at a time rather than detached
+    as a list, so a callback may cancel any timer, including ones due in the
+    same tick. Nothing started during the pass can land in this slot again:
+    new and reloaded timers expire at least one tick later.
+*/
+static int expire_slot(uint32_t slot)
+{
+    int fired = 0;
+    while (buckets[slot] != NIL)
+    {
+        uint16_t index = buckets[slot];
+        UiTimer *t = &timers[index];
+        UiTimerCallback callback = t->callback;
+        void *arg = t->arg;
+
+        unlink_timer(index);
+        if (t->period)
+        {
+            // reload from the tick being processed so a late wheel cannot fire twice
+            t->expires = clk + t->period;
+            link_timer(index);
+        }
+        else
+        {
+            release_timer(index);
+        }
+
+        stats.fired++;
+        fired++;
+        callback(arg);
+    }
+    return fired;
+}
+
+// next tick that has work after clk, never past now_ms + 1
+static uint32_t next_tick(uint32_t now_ms)
+{
+    uint32_t t = clk + 1;
+    uint32_t next;
+    bool coarse = (occupied[1] | occupied[2] | occupied[3]) != 0;
+    uint64_t ahead = occupied[0] >> (t & SLOT_MASK);
+
+    if ((t & SLOT_MASK) == 0 && coarse)
+        next = t; // cascade due
+    else if (ahead)
+        next = t + ctz64(ahead);
+    else if (coarse)
+        next = (t | SLOT_MASK) + 1;
+    else if (occupied[0])
+        next = (t | SLOT_MASK) + 1 + ctz64(occupied[0]);
+    else
+        next = now_ms + 1;
+
+    if ((int32_t)(next - (now_ms + 1)) > 0)
+        next = now_ms + 1;
+    return next;
+}
+
+int ui_timer_run(uint32_t now_ms)
+{
+    int fired = 0;
+    while ((int32_t)(now_ms - clk) >= 0)
+    {
+        uint32_t slot = clk & SLOT_MASK;
+        if (slot == 0)
+        {
+            for (int level = 1; level < UI_TIMER_LEVELS; level++)
+            {
+                uint32_t index = (clk >> (level * UI_TIMER_SLOT_BITS)) & SLOT_MASK;
+                cascade(level, index);
+                if (index != 0)
+                    break;
+            }
+        }
+
+        base = clk;
+        fired += expire_slot(slot);
+        clk = next_tick(now_ms);
+    }
+    base = now_ms;
+    return fired;
+}
+
+uint32_t ui_timer_next_expiry(uint32_t now_ms)
+{
+    bool found = false;
+    uint32_t next = 0;
+
+    if (occupied[0])
+    {
+        uint64_t ahead = occupied[0] >> (clk & SLOT_MASK);
+        next = ahead ? clk + ctz64(ahead) : (clk | SLOT_MASK) + 1 + ctz64(occupied[0]);
+        found = true;
+    }
+
+    // coarse levels: the tick their next occupied slot cascades, a lower bound on its expiry
+    for (int level = 1; level < UI_TIMER_LEVELS; level++)
+    {
+        if (!occupied[level])
+            continue;
+        uint32_t shift = level * UI_TIMER_SLOT_BITS;
+        uint32_t first = (clk >> shift) + ((clk & ((1UL << shift) - 1)) != 0);
+        uint32_t cascade_at = (first + ctz64(rotr64(occupied[level], first))) << shift;
+        if (!found || (int32_t)(cascade_at - next) < 0)
+            next = cascade_at;
+        found = true;
+    }
+
+    if (!found)
+        return UI_TIMER_NEVER;
+    return (int32_t)(next - now_ms) > 0 ? next - now_ms : 0;
+}
+
+uint32_t ui_timer_now(void)
+{
+    return base;
+}
+
+void ui_timer_get_stats(UiTimerStats *out)
+{
+    *out = stats;
+}